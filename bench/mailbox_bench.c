@@ -1,7 +1,8 @@
 /*
  * Agim - Mailbox Benchmark
  *
- * Measures mailbox throughput for message passing.
+ * Measures mailbox throughput for message passing, and the cost of
+ * allocating message values from malloc versus worker pools.
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -16,6 +17,7 @@
 #include <stdatomic.h>
 
 #include "runtime/mailbox.h"
+#include "util/worker_alloc.h"
 #include "vm/value.h"
 
 /* Timing Utilities */
@@ -106,17 +108,138 @@ static void bench_value_creation(int iterations) {
     BENCH_END("array (10 elem) create/free", iterations / 10);
 }
 
+/* Benchmark: Value allocation from worker pools */
+
+static void bench_value_alloc(const char *label, int iterations) {
+    char name[64];
+
+    snprintf(name, sizeof(name), "%s value_int create/free", label);
+    BENCH_START();
+    for (int i = 0; i < iterations; i++) {
+        value_free(value_int(i));
+    }
+    BENCH_END(name, iterations);
+
+    snprintf(name, sizeof(name), "%s value_string create/free", label);
+    BENCH_START();
+    for (int i = 0; i < iterations; i++) {
+        value_free(value_string("hello"));
+    }
+    BENCH_END(name, iterations);
+
+    snprintf(name, sizeof(name), "%s map (4 keys) create/free", label);
+    static const char *keys[] = {"a", "b", "c", "d"};
+    BENCH_START();
+    for (int i = 0; i < iterations / 10; i++) {
+        Value *map = value_map();
+        for (int j = 0; j < 4; j++) {
+            map = map_set(map, keys[j], value_int(j));
+        }
+        value_free(map);
+    }
+    BENCH_END(name, iterations / 10);
+}
+
+static void bench_worker_pools(int iterations) {
+    printf("\nValue Allocation (malloc vs worker pools):\n");
+
+    bench_value_alloc("malloc", iterations);
+
+    WorkerAllocator alloc;
+    worker_alloc_init(&alloc, 0);
+    worker_alloc_set_current(&alloc);
+    bench_value_alloc("pooled", iterations);
+    worker_alloc_set_current(NULL);
+    worker_alloc_free(&alloc);
+}
+
+/* Benchmark: Values allocated by one thread and freed by another */
+
+typedef struct {
+    Mailbox *mbox;
+    int messages;
+    bool pooled;
+} PipeArgs;
+
+static void *pipe_producer(void *arg) {
+    PipeArgs *args = (PipeArgs *)arg;
+    WorkerAllocator alloc;
+
+    if (args->pooled) {
+        worker_alloc_init(&alloc, 1);
+        worker_alloc_set_current(&alloc);
+    }
+
+    for (int i = 0; i < args->messages; i++) {
+        Message *m = malloc(sizeof(Message));
+        m->value = value_string("payload");
+        m->sender = 1;
+        m->next = NULL;
+        mailbox_push(args->mbox, m, 0);
+    }
+
+    if (args->pooled) {
+        worker_alloc_set_current(NULL);
+        /* Blocks still in flight keep the chunks alive */
+        worker_alloc_free(&alloc);
+    }
+    return NULL;
+}
+
+static void bench_cross_thread(const char *label, int messages, bool pooled) {
+    Mailbox mbox;
+    mailbox_init(&mbox);
+
+    WorkerAllocator alloc;
+    if (pooled) {
+        worker_alloc_init(&alloc, 0);
+        worker_alloc_set_current(&alloc);
+    }
+
+    PipeArgs args = {.mbox = &mbox, .messages = messages, .pooled = pooled};
+    pthread_t producer;
+
+    BENCH_START();
+    pthread_create(&producer, NULL, pipe_producer, &args);
+
+    int consumed = 0;
+    while (consumed < messages) {
+        Message *msg = mailbox_pop(&mbox);
+        if (!msg) continue;
+        value_free(msg->value);  /* Remote free when pooled */
+        free(msg);
+        consumed++;
+    }
+    pthread_join(producer, NULL);
+    BENCH_END(label, messages);
+
+    if (pooled) {
+        worker_alloc_set_current(NULL);
+        worker_alloc_free(&alloc);
+    }
+    mailbox_free(&mbox);
+}
+
 /* Multi-producer benchmark data */
 
 typedef struct {
     Mailbox *mbox;
     int messages_per_thread;
     int thread_id;
+    bool pooled;
     _Atomic(int) *start_flag;
 } ProducerArgs;
 
 static void *producer_thread(void *arg) {
     ProducerArgs *args = (ProducerArgs *)arg;
+    WorkerAllocator alloc;
+
+    /* Pooled producers stand in for workers: message nodes and values
+     * come from their own pools instead of the shared malloc */
+    if (args->pooled) {
+        worker_alloc_init(&alloc, args->thread_id + 1);
+        worker_alloc_set_current(&alloc);
+    }
 
     /* Wait for start signal */
     while (!atomic_load(args->start_flag)) {
@@ -125,28 +248,29 @@ static void *producer_thread(void *arg) {
 
     for (int i = 0; i < args->messages_per_thread; i++) {
         Value *msg = value_int(args->thread_id * args->messages_per_thread + i);
-        Message *m = malloc(sizeof(Message));
-        if (!m || !msg) {
+        Message *m = msg ? message_new(args->thread_id, msg) : NULL;
+        if (!m) {
             if (msg) value_free(msg);
-            if (m) free(m);
             break;
         }
-        m->value = msg;
-        m->sender = args->thread_id;
-        m->next = NULL;
         mailbox_push(args->mbox, m, 0);
     }
 
+    if (args->pooled) {
+        worker_alloc_set_current(NULL);
+        worker_alloc_free(&alloc);  /* Queued messages keep their chunks */
+    }
     return NULL;
 }
 
-static void bench_mailbox_mpsc(int num_producers, int messages_per_producer) {
+static void bench_mailbox_mpsc(int num_producers, int messages_per_producer, bool pooled) {
     Mailbox mbox;
     mailbox_init(&mbox);
 
     int total_messages = num_producers * messages_per_producer;
-    printf("\nMulti-Producer Single-Consumer (%d producers x %d msgs = %d total):\n",
-           num_producers, messages_per_producer, total_messages);
+    printf("\nMulti-Producer Single-Consumer, %s (%d producers x %d msgs = %d total):\n",
+           pooled ? "pooled" : "malloc", num_producers, messages_per_producer,
+           total_messages);
 
     pthread_t *threads = malloc(sizeof(pthread_t) * num_producers);
     ProducerArgs *args = malloc(sizeof(ProducerArgs) * num_producers);
@@ -157,6 +281,7 @@ static void bench_mailbox_mpsc(int num_producers, int messages_per_producer) {
         args[i].mbox = &mbox;
         args[i].messages_per_thread = messages_per_producer;
         args[i].thread_id = i;
+        args[i].pooled = pooled;
         args[i].start_flag = &start_flag;
         pthread_create(&threads[i], NULL, producer_thread, &args[i]);
     }
@@ -176,8 +301,7 @@ static void bench_mailbox_mpsc(int num_producers, int messages_per_producer) {
     int consumed = 0;
     Message *msg;
     while ((msg = mailbox_pop(&mbox)) != NULL) {
-        value_free(msg->value);
-        free(msg);
+        message_free(msg);
         consumed++;
     }
     BENCH_END("single-consumer pop", consumed);
@@ -298,11 +422,18 @@ int main(void) {
 
     bench_mailbox_direct(100000);
     bench_value_creation(100000);
+    bench_worker_pools(1000000);
+
+    printf("\nCross-Thread Send and Free (1 producer, 1 consumer):\n");
+    bench_cross_thread("malloc string send/free", 1000000, false);
+    bench_cross_thread("pooled string send/free", 1000000, true);
 
     /* Multi-producer benchmarks */
-    bench_mailbox_mpsc(2, 50000);   /* 2 producers, 100k total */
-    bench_mailbox_mpsc(4, 25000);   /* 4 producers, 100k total */
-    bench_mailbox_mpsc(8, 12500);   /* 8 producers, 100k total */
+    for (int pooled = 0; pooled <= 1; pooled++) {
+        bench_mailbox_mpsc(2, 50000, pooled);   /* 2 producers, 100k total */
+        bench_mailbox_mpsc(4, 25000, pooled);   /* 4 producers, 100k total */
+        bench_mailbox_mpsc(8, 12500, pooled);   /* 8 producers, 100k total */
+    }
 
     /* Latency percentiles */
     bench_latency_percentiles(100000);
@@ -139,6 +139,7 @@ static RegChunk *make_reg_countup_loop(int iterations) {
 static double bench_reg_vm(int iterations) {
     RegChunk *chunk = make_reg_countup_loop(iterations);
     RegVM *vm = regvm_new();
+    vm->reduction_limit = (size_t)iterations * 20;
 
     double start = get_time_ms();
     regvm_run(vm, chunk);
@@ -17,7 +17,11 @@
 #include <sys/resource.h>
 
 #include "vm/value.h"
+#include "vm/bytecode.h"
+#include "types/string.h"
 #include "runtime/mailbox.h"
+#include "runtime/scheduler.h"
+#include "runtime/worker.h"
 
 /* Timing Utilities */
 
@@ -212,6 +216,115 @@ cleanup:
     mailbox_free(&mbox);
 }
 
+/*
+ * Scheduler ping-pong: two blocks bounce a message through the real
+ * send/receive path on worker threads. Every hop parks the receiver and
+ * wakes it from the sender, so this measures the scheduler's wakeup
+ * latency rather than raw mailbox cost.
+ */
+
+static void emit_const(Chunk *chunk, size_t idx) {
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, (idx >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, idx & 0xFF, 1);
+}
+
+/* Wraps body_fn in "for i = count; i > 0; i--" */
+static Bytecode *make_counted_loop(int count, void (*body_fn)(Chunk *, void *), void *ctx) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    size_t c_count = chunk_add_constant(chunk, value_int(count));
+    size_t c_one = chunk_add_constant(chunk, value_int(1));
+    size_t c_zero = chunk_add_constant(chunk, value_int(0));
+
+    emit_const(chunk, c_count);
+    size_t loop_start = chunk->code_size;
+
+    chunk_write_opcode(chunk, OP_DUP, 1);
+    emit_const(chunk, c_zero);
+    chunk_write_opcode(chunk, OP_LE, 1);
+    size_t exit_jump = chunk_write_jump(chunk, OP_JUMP_IF, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+
+    body_fn(chunk, ctx);
+
+    emit_const(chunk, c_one);
+    chunk_write_opcode(chunk, OP_SUB, 1);
+    chunk_write_opcode(chunk, OP_LOOP, 1);
+    size_t offset = chunk->code_size - loop_start + 2;
+    chunk_write_byte(chunk, (offset >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, offset & 0xFF, 1);
+
+    chunk_patch_jump(chunk, exit_jump);
+    chunk_write_opcode(chunk, OP_POP, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+/* send(pong, 1); receive() */
+static void ping_body(Chunk *chunk, void *ctx) {
+    Pid pong = *(Pid *)ctx;
+    emit_const(chunk, chunk_add_constant(chunk, value_pid(pong)));
+    emit_const(chunk, chunk_add_constant(chunk, value_int(1)));
+    chunk_write_opcode(chunk, OP_SEND, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+    chunk_write_opcode(chunk, OP_RECEIVE, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+}
+
+/* msg = receive(); send(msg.sender, 1) */
+static void pong_body(Chunk *chunk, void *ctx) {
+    (void)ctx;
+    chunk_write_opcode(chunk, OP_RECEIVE, 1);
+    emit_const(chunk, chunk_add_constant(chunk, value_string("sender")));
+    chunk_write_opcode(chunk, OP_MAP_GET, 1);
+    emit_const(chunk, chunk_add_constant(chunk, value_int(1)));
+    chunk_write_opcode(chunk, OP_SEND, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+}
+
+static void bench_scheduler_ping_pong(int rounds, size_t workers) {
+    printf("\nScheduler Ping-Pong (rounds=%d, workers=%zu):\n", rounds, workers);
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = workers;
+
+    Scheduler *sched = scheduler_new(&config);
+    if (!sched) {
+        printf("  ERROR: Failed to create scheduler\n");
+        return;
+    }
+
+    Bytecode *pong_code = make_counted_loop(rounds, pong_body, NULL);
+    Pid pong = scheduler_spawn_ex(sched, pong_code, "pong",
+                                  CAP_SEND | CAP_RECEIVE, NULL);
+    Bytecode *ping_code = make_counted_loop(rounds, ping_body, &pong);
+    scheduler_spawn_ex(sched, ping_code, "ping", CAP_SEND | CAP_RECEIVE, NULL);
+
+    double start = get_time_ns();
+    scheduler_run(sched);
+    double elapsed_ns = get_time_ns() - start;
+
+    size_t parks = 0;
+    for (size_t i = 0; i < scheduler_worker_count(sched); i++) {
+        parks += atomic_load(&scheduler_get_worker(sched, i)->parks);
+    }
+
+    SchedulerStats stats = scheduler_stats(sched);
+    printf("  Time: %.2f ms\n", elapsed_ns / 1e6);
+    printf("  Round-trip: %.1f ns\n", elapsed_ns / rounds);
+    printf("  Context switches: %zu, worker parks: %zu\n",
+           stats.context_switches, parks);
+    printf("  Completed: %zu/2 blocks\n", stats.blocks_dead);
+
+    scheduler_free(sched);
+    bytecode_free(ping_code);
+    bytecode_free(pong_code);
+}
+
 int main(void) {
     printf("=== Agim Ring Benchmark ===\n");
 
@@ -228,6 +341,11 @@ int main(void) {
     bench_burst_pattern(1000, 100);     /* 100,000 messages */
     bench_burst_pattern(10000, 10);     /* 100,000 messages */
 
+    /* Cross-block wakeups through the scheduler */
+    bench_scheduler_ping_pong(100000, 1);
+    bench_scheduler_ping_pong(100000, 2);
+    bench_scheduler_ping_pong(100000, 4);
+
     printf("\n=== Ring Benchmark Complete ===\n");
     return 0;
 }
@@ -0,0 +1,299 @@
+/*
+ * Agim Spawn/Wake Scaling Benchmark
+ *
+ * Drives the multi-threaded scheduler from 1-64 external producer threads
+ * while the workers are running, to measure how cross-thread scheduling
+ * scales. Two patterns are measured:
+ *
+ *   spawn - producers call scheduler_spawn for short-lived blocks
+ *   wake  - producers send to parked receivers, waking each one
+ *
+ * Both paths hand blocks to workers they do not own, so the cost is
+ * dominated by the injection path into worker run queues.
+ *
+ * Usage: agim_scaling_bench [ops] [workers]
+ *
+ * Copyright (c) 2025 Agim Language Contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "vm/value.h"
+#include "vm/bytecode.h"
+#include "runtime/scheduler.h"
+#include "runtime/worker.h"
+
+#define RECEIVERS 64
+
+/* Timing */
+
+static double get_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/* Bytecode */
+
+static Bytecode *make_halt_code(void) {
+    Bytecode *code = bytecode_new();
+    chunk_write_opcode(code->main, OP_HALT, 1);
+    return code;
+}
+
+/* for i = count; i > 0; i-- { receive() } */
+static Bytecode *make_receive_loop(int count) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    size_t c_count = chunk_add_constant(chunk, value_int(count));
+    size_t c_one = chunk_add_constant(chunk, value_int(1));
+    size_t c_zero = chunk_add_constant(chunk, value_int(0));
+
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, (c_count >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, c_count & 0xFF, 1);
+
+    size_t loop_start = chunk->code_size;
+
+    chunk_write_opcode(chunk, OP_DUP, 2);
+    chunk_write_opcode(chunk, OP_CONST, 2);
+    chunk_write_byte(chunk, (c_zero >> 8) & 0xFF, 2);
+    chunk_write_byte(chunk, c_zero & 0xFF, 2);
+    chunk_write_opcode(chunk, OP_LE, 2);
+    size_t exit_jump = chunk_write_jump(chunk, OP_JUMP_IF, 2);
+    chunk_write_opcode(chunk, OP_POP, 2);
+
+    chunk_write_opcode(chunk, OP_RECEIVE, 3);
+    chunk_write_opcode(chunk, OP_POP, 3);
+
+    chunk_write_opcode(chunk, OP_CONST, 4);
+    chunk_write_byte(chunk, (c_one >> 8) & 0xFF, 4);
+    chunk_write_byte(chunk, c_one & 0xFF, 4);
+    chunk_write_opcode(chunk, OP_SUB, 4);
+
+    chunk_write_opcode(chunk, OP_LOOP, 5);
+    size_t offset = chunk->code_size - loop_start + 2;
+    chunk_write_byte(chunk, (offset >> 8) & 0xFF, 5);
+    chunk_write_byte(chunk, offset & 0xFF, 5);
+
+    chunk_patch_jump(chunk, exit_jump);
+    chunk_write_opcode(chunk, OP_POP, 6);
+    chunk_write_opcode(chunk, OP_POP, 6);
+    chunk_write_opcode(chunk, OP_HALT, 6);
+
+    return code;
+}
+
+/* receive_timeout(60000): the armed timer keeps the workers from treating
+ * the run as blocked while only foreign threads can wake anything */
+static Bytecode *make_sentinel_code(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    size_t c_timeout = chunk_add_constant(chunk, value_int(60000));
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, (c_timeout >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, c_timeout & 0xFF, 1);
+    chunk_write_opcode(chunk, OP_RECEIVE_TIMEOUT, 1);
+    chunk_write_opcode(chunk, OP_POP, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+/* Harness */
+
+typedef struct Producer {
+    pthread_t thread;
+    Scheduler *sched;
+    Bytecode *code;
+    const Pid *targets;
+    size_t target_count;
+    size_t ops;
+} Producer;
+
+static void *run_scheduler(void *arg) {
+    scheduler_run((Scheduler *)arg);
+    return NULL;
+}
+
+static void *spawn_producer(void *arg) {
+    Producer *p = (Producer *)arg;
+    for (size_t i = 0; i < p->ops; i++) {
+        scheduler_spawn(p->sched, p->code, "spawned");
+    }
+    return NULL;
+}
+
+static void *wake_producer(void *arg) {
+    Producer *p = (Producer *)arg;
+    Value *msg = value_int(1);
+
+    /* Round-robin over our receivers so each send lands on a parked block */
+    for (size_t i = 0; i < p->ops; i++) {
+        scheduler_send(p->sched, p->targets[i % p->target_count], PID_INVALID, msg);
+    }
+
+    value_free(msg);
+    return NULL;
+}
+
+static Scheduler *start_scheduler(size_t workers, size_t max_blocks,
+                                  Bytecode *sentinel_code, Pid *sentinel,
+                                  pthread_t *thread) {
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = workers;
+    config.max_blocks = max_blocks;
+
+    Scheduler *sched = scheduler_new(&config);
+    if (!sched) return NULL;
+
+    /* The sentinel keeps the workers alive until the producers are done */
+    *sentinel = scheduler_spawn_ex(sched, sentinel_code, "sentinel",
+                                   CAP_RECEIVE, NULL);
+    pthread_create(thread, NULL, run_scheduler, sched);
+    return sched;
+}
+
+static void stop_scheduler(Scheduler *sched, Pid sentinel, pthread_t thread) {
+    Value *msg = value_nil();
+    scheduler_send(sched, sentinel, PID_INVALID, msg);
+    value_free(msg);
+    pthread_join(thread, NULL);
+}
+
+static void bench_spawn(size_t threads, size_t total_ops, size_t workers) {
+    Bytecode *sentinel_code = make_sentinel_code();
+    Bytecode *code = make_halt_code();
+    Pid sentinel;
+    pthread_t sched_thread;
+
+    Scheduler *sched = start_scheduler(workers, total_ops + 16,
+                                       sentinel_code, &sentinel, &sched_thread);
+    if (!sched) {
+        printf("  ERROR: Failed to create scheduler\n");
+        return;
+    }
+
+    Producer *producers = calloc(threads, sizeof(Producer));
+    double start = get_time_ms();
+
+    for (size_t i = 0; i < threads; i++) {
+        producers[i].sched = sched;
+        producers[i].code = code;
+        producers[i].ops = total_ops / threads;
+        pthread_create(&producers[i].thread, NULL, spawn_producer, &producers[i]);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(producers[i].thread, NULL);
+    }
+
+    double produced = get_time_ms() - start;
+    stop_scheduler(sched, sentinel, sched_thread);
+    double drained = get_time_ms() - start;
+
+    size_t ops = (total_ops / threads) * threads;
+    printf("  spawn %2zu threads: %8.2f ms produce | %8.2f ms drain | %9.0f spawns/sec\n",
+           threads, produced, drained, ops / (drained / 1000.0));
+
+    free(producers);
+    scheduler_free(sched);
+    bytecode_free(code);
+    bytecode_free(sentinel_code);
+}
+
+static void bench_wake(size_t threads, size_t total_ops, size_t workers) {
+    size_t per_receiver = total_ops / RECEIVERS;
+    Bytecode *sentinel_code = make_sentinel_code();
+    Bytecode *code = make_receive_loop((int)per_receiver);
+    Pid sentinel;
+    pthread_t sched_thread;
+
+    Scheduler *sched = start_scheduler(workers, RECEIVERS + 16,
+                                       sentinel_code, &sentinel, &sched_thread);
+    if (!sched) {
+        printf("  ERROR: Failed to create scheduler\n");
+        return;
+    }
+
+    BlockLimits limits = block_limits_default();
+    limits.max_mailbox_size = per_receiver + 16;
+
+    Pid receivers[RECEIVERS];
+    for (size_t i = 0; i < RECEIVERS; i++) {
+        receivers[i] = scheduler_spawn_ex(sched, code, "receiver",
+                                          CAP_RECEIVE, &limits);
+    }
+
+    /* Give the receivers a chance to park before the first send */
+    nanosleep(&(struct timespec){.tv_sec = 0, .tv_nsec = 10000000}, NULL);
+
+    Producer *producers = calloc(threads, sizeof(Producer));
+    size_t share = RECEIVERS / threads;
+    double start = get_time_ms();
+
+    for (size_t i = 0; i < threads; i++) {
+        producers[i].sched = sched;
+        producers[i].targets = &receivers[i * share];
+        producers[i].target_count = share;
+        producers[i].ops = share * per_receiver;
+        pthread_create(&producers[i].thread, NULL, wake_producer, &producers[i]);
+    }
+    for (size_t i = 0; i < threads; i++) {
+        pthread_join(producers[i].thread, NULL);
+    }
+
+    double produced = get_time_ms() - start;
+    stop_scheduler(sched, sentinel, sched_thread);
+    double drained = get_time_ms() - start;
+
+    size_t ops = share * threads * per_receiver;
+    printf("  wake  %2zu threads: %8.2f ms produce | %8.2f ms drain | %9.0f msgs/sec\n",
+           threads, produced, drained, ops / (drained / 1000.0));
+
+    free(producers);
+    scheduler_free(sched);
+    bytecode_free(code);
+    bytecode_free(sentinel_code);
+}
+
+/* Main */
+
+int main(int argc, char **argv) {
+    size_t total_ops = 64000;
+    long num_workers = sysconf(_SC_NPROCESSORS_ONLN);
+    if (num_workers < 1) num_workers = 1;
+
+    if (argc > 1) {
+        long ops = atol(argv[1]);
+        if (ops > 0) total_ops = (size_t)ops;
+    }
+    if (argc > 2) {
+        long w = atol(argv[2]);
+        if (w > 0) num_workers = w;
+    }
+
+    printf("================================================================\n");
+    printf("    AGIM SPAWN/WAKE SCALING BENCHMARK\n");
+    printf("    %zu ops per run, %ld workers\n", total_ops, num_workers);
+    printf("================================================================\n\n");
+
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        bench_spawn(threads, total_ops, (size_t)num_workers);
+    }
+    printf("\n");
+    for (size_t threads = 1; threads <= 64; threads *= 2) {
+        bench_wake(threads, total_ops, (size_t)num_workers);
+    }
+
+    printf("\n");
+    return 0;
+}
@@ -7,11 +7,15 @@
 
 #include "lang/agim.h"
 #include "vm/vm.h"
+#include "vm/regvm.h"
 #include "vm/value.h"
 #include "vm/primitives.h"
+#include "vm/nanbox_convert.h"
 #include "runtime/scheduler.h"
 #include "runtime/block.h"
+#include "runtime/worker.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -52,6 +56,142 @@ static void print_usage(const char *program) {
     fprintf(stderr, "  -v, --version  Show version information\n");
     fprintf(stderr, "  -d, --disasm   Disassemble bytecode instead of running\n");
     fprintf(stderr, "  -t, --tools    List registered tools\n");
+    fprintf(stderr, "  --backend=B    Execution backend: stack (default) or reg\n\n");
+    fprintf(stderr, "Scheduler:\n");
+    fprintf(stderr, "  -w, --workers N     Worker threads, 0 = single-threaded (default: CPUs)\n");
+    fprintf(stderr, "  --reductions N      Reductions per time slice (default: 10000)\n");
+    fprintf(stderr, "  --max-blocks N      Maximum live blocks (default: 10000)\n\n");
+    fprintf(stderr, "Environment:\n");
+    fprintf(stderr, "  AGIM_WORKERS        Default for --workers\n");
+}
+
+/* Parse a non-negative count; returns false on junk or overflow */
+static bool parse_count(const char *text, size_t *out) {
+    if (!text || *text == '\0' || *text == '-') return false;
+
+    char *end;
+    errno = 0;
+    unsigned long long value = strtoull(text, &end, 10);
+    if (errno != 0 || *end != '\0') return false;
+
+    *out = (size_t)value;
+    return true;
+}
+
+/* Value of an option that takes an argument, advancing *i past it */
+static const char *option_value(int argc, char **argv, int *i) {
+    if (*i + 1 >= argc) {
+        fprintf(stderr, "agim: option '%s' requires a value\n", argv[*i]);
+        return NULL;
+    }
+    return argv[++*i];
+}
+
+static void print_tools(const ToolInfo *tools, size_t tool_count) {
+    if (tool_count == 0) {
+        printf("No tools defined.\n");
+        return;
+    }
+
+    printf("Tools (%zu):\n", tool_count);
+    for (size_t i = 0; i < tool_count; i++) {
+        printf("\n  tool %s(", tools[i].name);
+        for (size_t j = 0; j < tools[i].param_count; j++) {
+            if (j > 0) printf(", ");
+            printf("%s", tools[i].params[j].name ? tools[i].params[j].name : "?");
+            if (tools[i].params[j].type) {
+                printf(": %s", tools[i].params[j].type);
+            }
+        }
+        printf(")");
+        if (tools[i].return_type) {
+            printf(" -> %s", tools[i].return_type);
+        }
+        if (tools[i].description) {
+            printf("\n    \"%s\"", tools[i].description);
+        }
+        /* Show parameter descriptions if present */
+        for (size_t j = 0; j < tools[i].param_count; j++) {
+            if (tools[i].params[j].description) {
+                printf("\n    @param %s: %s",
+                       tools[i].params[j].name ? tools[i].params[j].name : "?",
+                       tools[i].params[j].description);
+            }
+        }
+        printf("\n");
+    }
+}
+
+/* Compile and run source on the register VM */
+static int run_reg(const char *source, const SchedulerConfig *config,
+                   bool disassemble, bool list_tools) {
+    const char *error = NULL;
+    RegChunk *program = agim_compile_reg(source, &error);
+
+    if (!program) {
+        fprintf(stderr, "agim: compile error: %s\n", error ? error : "unknown error");
+        fprintf(stderr, "agim: (register backend; try --backend=stack)\n");
+        if (error) agim_error_free(error);
+        return 1;
+    }
+
+    if (list_tools) {
+        size_t tool_count;
+        const ToolInfo *tools = bytecode_get_tools(program->stubs, &tool_count);
+        print_tools(tools, tool_count);
+        regchunk_free(program);
+        return 0;
+    }
+
+    if (disassemble) {
+        regchunk_disassemble(program, "main");
+        for (size_t i = 0; i < program->functions_count; i++) {
+            RegChunk *fn = program->functions[i];
+            regchunk_disassemble(fn, fn->name ? fn->name : "fn");
+        }
+        regchunk_free(program);
+        return 0;
+    }
+
+    Scheduler *scheduler = scheduler_new(config);
+    if (!scheduler) {
+        fprintf(stderr, "agim: failed to create scheduler\n");
+        regchunk_free(program);
+        return 1;
+    }
+
+    Pid main_pid = scheduler_spawn_reg(scheduler, program, program, "main", CAP_NONE, NULL);
+    if (main_pid == PID_INVALID) {
+        fprintf(stderr, "agim: failed to spawn main block\n");
+        scheduler_free(scheduler);
+        regchunk_free(program);
+        return 1;
+    }
+
+    Block *main_block = scheduler_get_block(scheduler, main_pid);
+    main_block->retain_on_exit = true;
+
+    scheduler_run(scheduler);
+
+    int exit_code = 0;
+    if (main_block->regvm) {
+        if (main_block->regvm->error) {
+            fprintf(stderr, "agim: runtime error: %s\n", main_block->regvm->error);
+            exit_code = 1;
+        } else {
+            Value scratch;
+            Value *result = nanbox_borrow_value(main_block->regvm->result, &scratch);
+            if (result && !value_is_nil(result)) {
+                value_print(result);
+                printf("\n");
+            }
+        }
+    }
+
+    /* Blocks borrow the program; free it once they are gone */
+    scheduler_free(scheduler);
+    regchunk_free(program);
+    return exit_code;
 }
 
 static void print_version(void) {
@@ -67,6 +207,18 @@ int main(int argc, char **argv) {
     const char *filename = NULL;
     bool disassemble = false;
     bool list_tools = false;
+    bool use_reg = false;
+
+    /* Run on the work-stealing pool by default, one worker per CPU */
+    MTSchedulerConfig mt_defaults = mt_scheduler_config_default();
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = mt_defaults.num_workers;
+
+    const char *env_workers = getenv("AGIM_WORKERS");
+    if (env_workers && *env_workers && !parse_count(env_workers, &config.num_workers)) {
+        fprintf(stderr, "agim: invalid AGIM_WORKERS '%s'\n", env_workers);
+        return 1;
+    }
 
     for (int i = 1; i < argc; i++) {
         if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
@@ -79,6 +231,40 @@ int main(int argc, char **argv) {
             disassemble = true;
         } else if (strcmp(argv[i], "-t") == 0 || strcmp(argv[i], "--tools") == 0) {
             list_tools = true;
+        } else if (strncmp(argv[i], "--backend", 9) == 0 &&
+                   (argv[i][9] == '\0' || argv[i][9] == '=')) {
+            const char *value = argv[i][9] == '=' ? argv[i] + 10 : option_value(argc, argv, &i);
+            if (!value) return 1;
+            if (strcmp(value, "stack") == 0) {
+                use_reg = false;
+            } else if (strcmp(value, "reg") == 0) {
+                use_reg = true;
+            } else {
+                fprintf(stderr, "agim: unknown backend '%s' (expected stack or reg)\n", value);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-w") == 0 || strcmp(argv[i], "--workers") == 0) {
+            const char *value = option_value(argc, argv, &i);
+            if (!value) return 1;
+            if (!parse_count(value, &config.num_workers)) {
+                fprintf(stderr, "agim: invalid worker count '%s'\n", value);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--reductions") == 0) {
+            const char *value = option_value(argc, argv, &i);
+            if (!value) return 1;
+            if (!parse_count(value, &config.default_reductions) ||
+                config.default_reductions == 0) {
+                fprintf(stderr, "agim: invalid reduction count '%s'\n", value);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--max-blocks") == 0) {
+            const char *value = option_value(argc, argv, &i);
+            if (!value) return 1;
+            if (!parse_count(value, &config.max_blocks) || config.max_blocks == 0) {
+                fprintf(stderr, "agim: invalid block limit '%s'\n", value);
+                return 1;
+            }
         } else if (argv[i][0] == '-') {
             fprintf(stderr, "agim: unknown option '%s'\n", argv[i]);
             return 1;
@@ -98,6 +284,12 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    if (use_reg) {
+        int exit_code = run_reg(source, &config, disassemble, list_tools);
+        free(source);
+        return exit_code;
+    }
+
     /* Compile */
     const char *error = NULL;
     Bytecode *code = agim_compile(source, &error);
@@ -113,38 +305,7 @@ int main(int argc, char **argv) {
     if (list_tools) {
         size_t tool_count;
         const ToolInfo *tools = bytecode_get_tools(code, &tool_count);
-
-        if (tool_count == 0) {
-            printf("No tools defined.\n");
-        } else {
-            printf("Tools (%zu):\n", tool_count);
-            for (size_t i = 0; i < tool_count; i++) {
-                printf("\n  tool %s(", tools[i].name);
-                for (size_t j = 0; j < tools[i].param_count; j++) {
-                    if (j > 0) printf(", ");
-                    printf("%s", tools[i].params[j].name ? tools[i].params[j].name : "?");
-                    if (tools[i].params[j].type) {
-                        printf(": %s", tools[i].params[j].type);
-                    }
-                }
-                printf(")");
-                if (tools[i].return_type) {
-                    printf(" -> %s", tools[i].return_type);
-                }
-                if (tools[i].description) {
-                    printf("\n    \"%s\"", tools[i].description);
-                }
-                /* Show parameter descriptions if present */
-                for (size_t j = 0; j < tools[i].param_count; j++) {
-                    if (tools[i].params[j].description) {
-                        printf("\n    @param %s: %s",
-                               tools[i].params[j].name ? tools[i].params[j].name : "?",
-                               tools[i].params[j].description);
-                    }
-                }
-                printf("\n");
-            }
-        }
+        print_tools(tools, tool_count);
         bytecode_free(code);
         return 0;
     }
@@ -161,8 +322,7 @@ int main(int argc, char **argv) {
         return 0;
     }
 
-    /* Create scheduler (single-threaded by default) */
-    SchedulerConfig config = scheduler_config_default();
+    /* Create scheduler */
     Scheduler *scheduler = scheduler_new(&config);
     if (!scheduler) {
         fprintf(stderr, "agim: failed to create scheduler\n");
@@ -185,13 +345,16 @@ int main(int argc, char **argv) {
         return 1;
     }
 
+    /* Workers free blocks as they exit; keep main around for its result */
+    Block *main_block = scheduler_get_block(scheduler, main_pid);
+    main_block->retain_on_exit = true;
+
     /* Run until all blocks complete */
     scheduler_run(scheduler);
 
     /* Check result */
     int exit_code = 0;
-    Block *main_block = scheduler_get_block(scheduler, main_pid);
-    if (main_block && main_block->vm) {
+    if (main_block->vm) {
         if (main_block->vm->error) {
             fprintf(stderr, "agim: runtime error: %s\n", main_block->vm->error);
             exit_code = 1;
@@ -511,7 +511,7 @@ static Value *bytecode_tool_call(Block *block, Value **args, size_t arg_count,
     fn->locals_count = 0;
     fn->parent = NULL;
 
-    Value *func_val = agim_alloc(sizeof(Value));
+    Value *func_val = value_mem_alloc(sizeof(Value));
     if (!func_val) {
         LOG_ERROR("tools: failed to allocate Value for bytecode tool function");
         agim_free(fn);
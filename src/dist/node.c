@@ -8,6 +8,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "dist/node.h"
+#include "runtime/scheduler.h"
 #include "runtime/serialize.h"
 #include "runtime/timer.h"
 #include "debug/log.h"
@@ -24,8 +25,17 @@
 #include <sys/select.h>
 #include <sys/socket.h>
 #include <sys/time.h>
+#include <sys/uio.h>
+#include <time.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#define DIST_USE_EPOLL 1
+#else
+#include <poll.h>
+#endif
+
 /*
  * Configuration
  */
@@ -33,6 +43,19 @@
 /* Maximum message size to prevent memory exhaustion attacks (16 MB) */
 #define DIST_MAX_MESSAGE_SIZE (16 * 1024 * 1024)
 
+/* Fixed handshake part: [type:1][version:1][cookie:8][node_number:2][name_len:1] */
+#define DIST_HANDSHAKE_HEADER_SIZE 13
+
+/* Frame header for DIST_MSG_SEND and the link/monitor frames:
+ * [type:1][length:4][target_pid:8][sender_pid:8] */
+#define DIST_SEND_HEADER_SIZE 21
+
+/* Longest exit reason carried by DIST_MSG_EXIT and DIST_MSG_DOWN */
+#define DIST_REASON_MAX 256
+
+/* Send queue capacity kept between batches; larger buffers are released */
+#define DIST_SEND_QUEUE_RETAIN (64 * 1024)
+
 NodeConfig node_config_default(void) {
     return (NodeConfig){
         .name = "node",
@@ -41,79 +64,58 @@ NodeConfig node_config_default(void) {
         .cookie = 0,
         .heartbeat_ms = 5000,
         .timeout_ms = 10000,
+        .flush_delay_us = 0,
+        .node_number = 0,
     };
 }
 
-/* Node Lifecycle */
-
-DistributedNode *node_new(const NodeConfig *config) {
-    DistributedNode *node = calloc(1, sizeof(DistributedNode));
-    if (!node) {
-        LOG_ERROR("node: failed to allocate DistributedNode");
-        return NULL;
+/* Fold the name into a non-zero node number (FNV-1a) */
+static uint16_t node_number_from_name(const char *name) {
+    uint32_t hash = 2166136261u;
+    for (const char *p = name; *p; p++) {
+        hash ^= (uint8_t)*p;
+        hash *= 16777619u;
     }
+    uint16_t number = (uint16_t)(hash ^ (hash >> 16));
+    return number != 0 ? number : 1;
+}
 
-    NodeConfig cfg = config ? *config : node_config_default();
-
-    /* Set up local identity */
-    strncpy(node->local.name, cfg.name, NODE_NAME_MAX - 1);
-    strncpy(node->local.host, cfg.host, NODE_HOST_MAX - 1);
-    node->local.port = cfg.port;
-    node->local.cookie = cfg.cookie;
-    node->local.node_id = (uint64_t)timer_current_time_ms();  /* Simple unique ID */
-
-    node->config = cfg;
-    node->peers = NULL;
-    node->peer_count = 0;
-    node->listen_fd = -1;
-    node->accept_running = false;
-    node->monitors = NULL;
-    node->monitor_count = 0;
-    node->running = false;
-
-    node->callback_ctx = NULL;
-    node->on_node_up = NULL;
-    node->on_node_down = NULL;
-    node->on_message = NULL;
+/* Connections */
 
-    pthread_mutex_init(&node->lock, NULL);
+static NodeConnection *connection_new(DistributedNode *node) {
+    NodeConnection *conn = calloc(1, sizeof(NodeConnection));
+    if (!conn) return NULL;
 
-    return node;
+    conn->socket_fd = -1;
+    conn->node = node;
+    atomic_init(&conn->refcount, 1);
+    pthread_mutex_init(&conn->send_lock, NULL);
+    return conn;
 }
 
-void node_free(DistributedNode *node) {
-    if (!node) return;
-
-    node_stop(node);
+static void connection_free(NodeConnection *conn) {
+    pthread_mutex_destroy(&conn->send_lock);
+    free(conn->send_queue);
+    shared_buffer_release(conn->recv_buf);
+    free(conn);
+}
 
-    pthread_mutex_lock(&node->lock);
+static void connection_retain(NodeConnection *conn) {
+    atomic_fetch_add_explicit(&conn->refcount, 1, memory_order_relaxed);
+}
 
-    /* Free peer connections */
-    NodeConnection *peer = node->peers;
-    while (peer) {
-        NodeConnection *next = peer->next;
-        if (peer->socket_fd >= 0) {
-            close(peer->socket_fd);
-        }
-        free(peer);
-        peer = next;
-    }
+/* Drop a reference; the last one closes the socket and frees the connection */
+static void connection_release(NodeConnection *conn) {
+    if (!conn) return;
+    if (atomic_fetch_sub_explicit(&conn->refcount, 1, memory_order_acq_rel) != 1) return;
 
-    /* Free monitors */
-    NodeMonitor *mon = node->monitors;
-    while (mon) {
-        NodeMonitor *next = mon->next;
-        free(mon);
-        mon = next;
+    if (conn->socket_fd >= 0) {
+        close(conn->socket_fd);
     }
-
-    pthread_mutex_unlock(&node->lock);
-    pthread_mutex_destroy(&node->lock);
-
-    free(node);
+    connection_free(conn);
 }
 
-/* Accept Thread */
+/* Socket I/O */
 
 /* Read exactly n bytes from socket */
 static bool socket_read_exact(int fd, void *buf, size_t n) {
@@ -141,230 +143,1002 @@ static bool socket_write_exact(int fd, const void *buf, size_t n) {
     return true;
 }
 
-/* Receiver thread for a peer connection */
-static void *receiver_thread_fn(void *arg) {
-    NodeConnection *conn = (NodeConnection *)arg;
+/* Write a full iovec array to socket, resuming after partial writes */
+static bool socket_writev_exact(int fd, struct iovec *iov, int iovcnt) {
+    while (iovcnt > 0) {
+        struct msghdr msg = {0};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)iovcnt;
 
-    while (conn->recv_running) {
-        /* Read message header: [type:1][length:4] */
-        uint8_t header[5];
-        if (!socket_read_exact(conn->socket_fd, header, 5)) {
-            break;  /* Connection closed or error */
+        ssize_t w = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+
+        size_t written = (size_t)w;
+        while (iovcnt > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (iovcnt > 0) {
+            iov->iov_base = (uint8_t *)iov->iov_base + written;
+            iov->iov_len -= written;
         }
+    }
+    return true;
+}
 
-        uint8_t msg_type = header[0];
-        uint32_t msg_len = ((uint32_t)header[1] << 24) | ((uint32_t)header[2] << 16) |
-                          ((uint32_t)header[3] << 8) | header[4];
+/* Encode a PID-addressed frame header (big-endian fields) */
+static void frame_send_header(uint8_t *header, uint8_t type, Pid target_pid,
+                              Pid sender_pid, size_t payload_len) {
+    /* Length covers the PIDs (16 bytes) and the payload */
+    uint32_t msg_len = 16 + (uint32_t)payload_len;
+    header[0] = type;
+    header[1] = (msg_len >> 24) & 0xFF;
+    header[2] = (msg_len >> 16) & 0xFF;
+    header[3] = (msg_len >> 8) & 0xFF;
+    header[4] = msg_len & 0xFF;
 
-        /* Reject messages that are too large (security: prevent memory exhaustion) */
-        if (msg_len > DIST_MAX_MESSAGE_SIZE) {
-            break;  /* Disconnect - message too large */
+    for (int i = 7; i >= 0; i--) {
+        header[5 + 7 - i] = (target_pid >> (i * 8)) & 0xFF;
+        header[5 + 15 - i] = (sender_pid >> (i * 8)) & 0xFF;
+    }
+}
+
+/* Append a frame to the connection's send queue. Caller holds send_lock. */
+static bool send_queue_append(NodeConnection *conn, const uint8_t *header,
+                              const void *data, size_t len) {
+    size_t needed = conn->send_queue_len + DIST_SEND_HEADER_SIZE + len;
+    if (needed > conn->send_queue_cap) {
+        size_t cap = conn->send_queue_cap ? conn->send_queue_cap : 4096;
+        while (cap < needed) cap *= 2;
+        uint8_t *queue = realloc(conn->send_queue, cap);
+        if (!queue) {
+            LOG_ERROR("node: failed to grow send queue to %zu bytes", cap);
+            return false;
         }
+        conn->send_queue = queue;
+        conn->send_queue_cap = cap;
+    }
 
-        /* Handle message by type */
-        switch (msg_type) {
-        case DIST_MSG_HEARTBEAT:
-            conn->last_heartbeat = timer_current_time_ms();
+    memcpy(conn->send_queue + conn->send_queue_len, header, DIST_SEND_HEADER_SIZE);
+    conn->send_queue_len += DIST_SEND_HEADER_SIZE;
+    if (len > 0) {
+        memcpy(conn->send_queue + conn->send_queue_len, data, len);
+        conn->send_queue_len += len;
+    }
+    return true;
+}
+
+/* Send handshake to a peer */
+static bool send_handshake(int fd, const NodeId *local) {
+    /* Handshake format: [type:1][version:1][cookie:8][node_number:2][name_len:1][name:var] */
+    size_t name_len = strlen(local->name);
+    if (name_len > 255) name_len = 255;
+
+    size_t total = DIST_HANDSHAKE_HEADER_SIZE + name_len;
+    uint8_t *buf = malloc(total);
+    if (!buf) return false;
+
+    size_t pos = 0;
+    buf[pos++] = DIST_MSG_HANDSHAKE;
+    buf[pos++] = DIST_PROTOCOL_VERSION;
+
+    /* Cookie (8 bytes big-endian) */
+    for (int i = 7; i >= 0; i--) {
+        buf[pos++] = (local->cookie >> (i * 8)) & 0xFF;
+    }
+
+    buf[pos++] = (local->node_id >> 8) & 0xFF;
+    buf[pos++] = local->node_id & 0xFF;
+
+    buf[pos++] = (uint8_t)name_len;
+    memcpy(buf + pos, local->name, name_len);
+
+    bool ok = socket_write_exact(fd, buf, total);
+    free(buf);
+    return ok;
+}
+
+
+/* Validate the fixed handshake part and take the peer's node number */
+static bool check_handshake_header(const uint8_t *header, uint64_t expected_cookie,
+                                   NodeId *peer_out) {
+    if (header[0] != DIST_MSG_HANDSHAKE) return false;
+    if (header[1] != DIST_PROTOCOL_VERSION) return false;
+
+    /* Verify cookie */
+    uint64_t cookie = 0;
+    for (int i = 0; i < 8; i++) {
+        cookie = (cookie << 8) | header[2 + i];
+    }
+    if (cookie != expected_cookie) return false;
+
+    peer_out->node_id = ((uint64_t)header[10] << 8) | header[11];
+    return peer_out->node_id != 0;
+}
+
+static void copy_handshake_name(const uint8_t *name, size_t name_len, NodeId *peer_out) {
+    if (name_len >= NODE_NAME_MAX) name_len = NODE_NAME_MAX - 1;
+    memcpy(peer_out->name, name, name_len);
+    peer_out->name[name_len] = '\0';
+}
+
+/* Read handshake from a peer */
+static bool read_handshake(int fd, uint64_t expected_cookie, NodeId *peer_out) {
+    uint8_t header[DIST_HANDSHAKE_HEADER_SIZE];
+    if (!socket_read_exact(fd, header, sizeof(header))) return false;
+    if (!check_handshake_header(header, expected_cookie, peer_out)) return false;
+
+    /* Read the whole name so the stream stays in sync, even if truncated */
+    uint8_t name[255];
+    uint8_t name_len = header[DIST_HANDSHAKE_HEADER_SIZE - 1];
+    if (name_len > 0 && !socket_read_exact(fd, name, name_len)) return false;
+    copy_handshake_name(name, name_len, peer_out);
+
+    peer_out->cookie = expected_cookie;
+    return true;
+}
+
+/* Decode a handshake from buffered bytes.
+ * Returns 1 and sets *used once complete, 0 if more bytes are needed,
+ * -1 if the handshake is rejected. */
+static int parse_handshake(const uint8_t *buf, size_t avail, uint64_t expected_cookie,
+                           NodeId *peer_out, size_t *used) {
+    if (avail < DIST_HANDSHAKE_HEADER_SIZE) return 0;
+    if (!check_handshake_header(buf, expected_cookie, peer_out)) return -1;
+
+    size_t name_len = buf[DIST_HANDSHAKE_HEADER_SIZE - 1];
+    if (avail < DIST_HANDSHAKE_HEADER_SIZE + name_len) return 0;
+    copy_handshake_name(buf + DIST_HANDSHAKE_HEADER_SIZE, name_len, peer_out);
+
+    peer_out->cookie = expected_cookie;
+    *used = DIST_HANDSHAKE_HEADER_SIZE + name_len;
+    return 1;
+}
+
+/* Event Loop
+ *
+ * One thread per node waits on the listening socket and every peer socket
+ * (epoll on Linux, poll elsewhere). Reads use MSG_DONTWAIT, so sockets stay
+ * in blocking mode for the senders in node_send. Connections dropped by
+ * other threads are retired to the loop, which frees them between event
+ * batches so an event already returned for them never sees freed memory.
+ */
+
+#define IO_MAX_EVENTS 64
+
+/* Receive buffer sizing */
+#define DIST_RECV_BUFFER_INITIAL (16 * 1024)
+#define DIST_RECV_READ_MIN 4096
+#define DIST_RECV_BUFFER_RETAIN (64 * 1024)
+
+typedef struct NodeIoLoop {
+    pthread_t thread;
+    bool running;
+    pthread_mutex_t lock;           /* Guards running, retired and the poll set */
+    int wake_fds[2];                /* Self-pipe to interrupt the wait */
+    NodeConnection *handshaking;    /* Inbound connections awaiting a handshake */
+    NodeConnection *retired;        /* Freed by the loop after its current batch */
+#ifdef DIST_USE_EPOLL
+    int epoll_fd;
+#else
+    struct pollfd *fds;             /* Watched descriptors and their tags */
+    void **tags;
+    size_t count;
+    size_t capacity;
+    struct pollfd *snap_fds;        /* Loop-thread copy polled without the lock */
+    void **snap_tags;
+    size_t snap_capacity;
+#endif
+} NodeIoLoop;
+
+/* Event tags for the loop's own descriptors; any other tag is a connection */
+static char io_tag_wake;
+static char io_tag_listen;
+
+static void io_loop_destroy(NodeIoLoop *io) {
+    if (!io) return;
+#ifdef DIST_USE_EPOLL
+    close(io->epoll_fd);
+#else
+    free(io->fds);
+    free(io->tags);
+    free(io->snap_fds);
+    free(io->snap_tags);
+#endif
+    close(io->wake_fds[0]);
+    close(io->wake_fds[1]);
+    pthread_mutex_destroy(&io->lock);
+    free(io);
+}
+
+static bool io_watch(NodeIoLoop *io, int fd, void *tag) {
+#ifdef DIST_USE_EPOLL
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = tag };
+    return epoll_ctl(io->epoll_fd, EPOLL_CTL_ADD, fd, &ev) == 0;
+#else
+    pthread_mutex_lock(&io->lock);
+    if (io->count == io->capacity) {
+        size_t cap = io->capacity ? io->capacity * 2 : 16;
+        struct pollfd *fds = realloc(io->fds, cap * sizeof(struct pollfd));
+        if (fds) io->fds = fds;
+        void **tags = fds ? realloc(io->tags, cap * sizeof(void *)) : NULL;
+        if (!tags) {
+            pthread_mutex_unlock(&io->lock);
+            return false;
+        }
+        io->tags = tags;
+        io->capacity = cap;
+    }
+    io->fds[io->count] = (struct pollfd){ .fd = fd, .events = POLLIN };
+    io->tags[io->count] = tag;
+    io->count++;
+    pthread_mutex_unlock(&io->lock);
+    return true;
+#endif
+}
+
+static NodeIoLoop *io_loop_new(void) {
+    NodeIoLoop *io = calloc(1, sizeof(NodeIoLoop));
+    if (!io) return NULL;
+
+    if (pipe(io->wake_fds) < 0) {
+        free(io);
+        return NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        fcntl(io->wake_fds[i], F_SETFL, fcntl(io->wake_fds[i], F_GETFL, 0) | O_NONBLOCK);
+    }
+
+#ifdef DIST_USE_EPOLL
+    io->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (io->epoll_fd < 0) {
+        close(io->wake_fds[0]);
+        close(io->wake_fds[1]);
+        free(io);
+        return NULL;
+    }
+#endif
+
+    pthread_mutex_init(&io->lock, NULL);
+
+    if (!io_watch(io, io->wake_fds[0], &io_tag_wake)) {
+        io_loop_destroy(io);
+        return NULL;
+    }
+    return io;
+}
+
+static void io_unwatch(NodeIoLoop *io, int fd, void *tag) {
+#ifdef DIST_USE_EPOLL
+    (void)tag;
+    epoll_ctl(io->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+#else
+    (void)fd;
+    pthread_mutex_lock(&io->lock);
+    for (size_t i = 0; i < io->count; i++) {
+        if (io->tags[i] == tag) {
+            io->count--;
+            io->fds[i] = io->fds[io->count];
+            io->tags[i] = io->tags[io->count];
             break;
+        }
+    }
+    pthread_mutex_unlock(&io->lock);
+#endif
+}
+
+/* Wait for readable descriptors and return up to max of their tags;
+ * timeout_ms < 0 waits indefinitely */
+static int io_wait(NodeIoLoop *io, void **tags, int max, int timeout_ms) {
+#ifdef DIST_USE_EPOLL
+    struct epoll_event events[IO_MAX_EVENTS];
+    if (max > IO_MAX_EVENTS) max = IO_MAX_EVENTS;
+
+    int n = epoll_wait(io->epoll_fd, events, max, timeout_ms);
+    if (n < 0) return 0;
+    for (int i = 0; i < n; i++) {
+        tags[i] = events[i].data.ptr;
+    }
+    return n;
+#else
+    pthread_mutex_lock(&io->lock);
+    size_t count = io->count;
+    if (count > io->snap_capacity) {
+        struct pollfd *fds = realloc(io->snap_fds, count * sizeof(struct pollfd));
+        if (fds) io->snap_fds = fds;
+        void **snap_tags = fds ? realloc(io->snap_tags, count * sizeof(void *)) : NULL;
+        if (!snap_tags) {
+            pthread_mutex_unlock(&io->lock);
+            return 0;
+        }
+        io->snap_tags = snap_tags;
+        io->snap_capacity = count;
+    }
+    memcpy(io->snap_fds, io->fds, count * sizeof(struct pollfd));
+    memcpy(io->snap_tags, io->tags, count * sizeof(void *));
+    pthread_mutex_unlock(&io->lock);
+
+    if (poll(io->snap_fds, (nfds_t)count, timeout_ms) <= 0) return 0;
+
+    int n = 0;
+    for (size_t i = 0; i < count && n < max; i++) {
+        if (io->snap_fds[i].revents) {
+            tags[n++] = io->snap_tags[i];
+        }
+    }
+    return n;
+#endif
+}
+
+static void io_wake(NodeIoLoop *io) {
+    uint8_t byte = 1;
+    ssize_t w = write(io->wake_fds[1], &byte, 1);
+    (void)w;  /* A full pipe already guarantees a wakeup */
+}
+
+static void io_drain_wake(NodeIoLoop *io) {
+    uint8_t buf[64];
+    while (read(io->wake_fds[0], buf, sizeof(buf)) > 0) {}
+}
+
+/* Register a connection's socket with the loop */
+static bool conn_watch(NodeIoLoop *io, NodeConnection *conn) {
+    conn->watched = true;
+    if (!io_watch(io, conn->socket_fd, conn)) {
+        conn->watched = false;
+        return false;
+    }
+    return true;
+}
+
+/* Deregister a connection; returns false if another thread already did */
+static bool conn_unwatch(NodeIoLoop *io, NodeConnection *conn) {
+    pthread_mutex_lock(&io->lock);
+    bool was_watched = conn->watched;
+    conn->watched = false;
+    pthread_mutex_unlock(&io->lock);
+
+    if (was_watched) {
+        io_unwatch(io, conn->socket_fd, conn);
+    }
+    return was_watched;
+}
+
+/* Hand a connection to the loop to release once no event can refer to it */
+static void io_retire(NodeIoLoop *io, NodeConnection *conn) {
+    pthread_mutex_lock(&io->lock);
+    if (io->running) {
+        conn->next = io->retired;
+        io->retired = conn;
+        pthread_mutex_unlock(&io->lock);
+        io_wake(io);
+        return;
+    }
+    pthread_mutex_unlock(&io->lock);
+    connection_release(conn);
+}
+
+static void io_free_retired(NodeIoLoop *io) {
+    pthread_mutex_lock(&io->lock);
+    NodeConnection *conn = io->retired;
+    io->retired = NULL;
+    pthread_mutex_unlock(&io->lock);
+
+    while (conn) {
+        NodeConnection *next = conn->next;
+        connection_release(conn);
+        conn = next;
+    }
+}
 
-        case DIST_MSG_SEND: {
-            /* Format: [target_pid:8][sender_pid:8][payload:...] */
-            if (msg_len < 16) break;
+static void handshaking_remove(NodeIoLoop *io, NodeConnection *conn) {
+    NodeConnection **pp = &io->handshaking;
+    while (*pp) {
+        if (*pp == conn) {
+            *pp = conn->next;
+            conn->next = NULL;
+            return;
+        }
+        pp = &(*pp)->next;
+    }
+}
+
+/* Ensure at least extra bytes of free space after the buffered data */
+static bool conn_recv_reserve(NodeConnection *conn, size_t extra) {
+    size_t cap = conn->recv_buf ? conn->recv_buf->capacity : 0;
+    if (cap - conn->recv_len >= extra) return true;
 
-            uint8_t pid_buf[16];
-            if (!socket_read_exact(conn->socket_fd, pid_buf, 16)) break;
+    size_t new_cap = cap ? cap : DIST_RECV_BUFFER_INITIAL;
+    while (new_cap - conn->recv_len < extra) new_cap *= 2;
+
+    SharedBuffer *buf = shared_buffer_new(new_cap);
+    if (!buf) {
+        LOG_ERROR("node: failed to grow receive buffer to %zu bytes", new_cap);
+        return false;
+    }
+    if (conn->recv_len > 0) {
+        memcpy(buf->data, conn->recv_buf->data, conn->recv_len);
+    }
+    shared_buffer_release(conn->recv_buf);
+    conn->recv_buf = buf;
+    return true;
+}
 
-            /* Parse PIDs (big-endian) */
-            Pid target_pid = 0, sender_pid = 0;
-            for (int i = 0; i < 8; i++) {
-                target_pid = (target_pid << 8) | pid_buf[i];
-                sender_pid = (sender_pid << 8) | pid_buf[8 + i];
+/* Drop the first consumed bytes of the receive buffer */
+static bool conn_recv_consume(NodeConnection *conn, size_t consumed) {
+    SharedBuffer *buf = conn->recv_buf;
+    size_t tail = conn->recv_len - consumed;
+    bool pinned = atomic_load_explicit(&buf->refcount, memory_order_acquire) > 1;
+
+    if (pinned || (tail == 0 && buf->capacity > DIST_RECV_BUFFER_RETAIN)) {
+        /* Decoded values still borrow from it, or it grew for one large frame */
+        conn->recv_buf = NULL;
+        conn->recv_len = 0;
+        if (tail > 0) {
+            if (!conn_recv_reserve(conn, tail)) {
+                shared_buffer_release(buf);
+                return false;
             }
+            memcpy(conn->recv_buf->data, buf->data + consumed, tail);
+            conn->recv_len = tail;
+        }
+        shared_buffer_release(buf);
+        return true;
+    }
 
-            /* Read payload */
-            size_t payload_len = msg_len - 16;
-            void *payload = NULL;
-            if (payload_len > 0) {
-                payload = malloc(payload_len);
-                if (!payload) {
-                    /* Malloc failed - skip the payload bytes to stay in sync */
-                    uint8_t skip_buf[256];
-                    size_t remaining = payload_len;
-                    while (remaining > 0) {
-                        size_t chunk = remaining > sizeof(skip_buf) ? sizeof(skip_buf) : remaining;
-                        if (!socket_read_exact(conn->socket_fd, skip_buf, chunk)) break;
-                        remaining -= chunk;
-                    }
-                    break;
-                }
-                if (!socket_read_exact(conn->socket_fd, payload, payload_len)) {
-                    free(payload);
-                    break;
-                }
+    memmove(buf->data, buf->data + consumed, tail);
+    conn->recv_len = tail;
+    return true;
+}
+
+/* Fan a lost peer out to everything watching it: links and monitors of
+ * its blocks, node monitors, then the callback */
+static void peer_down(DistributedNode *node, const NodeId *peer) {
+    if (node->scheduler) {
+        scheduler_node_down(node->scheduler, (uint16_t)peer->node_id);
+
+        pthread_mutex_lock(&node->lock);
+        size_t count = 0;
+        Pid *watchers = node->monitor_count
+            ? malloc(node->monitor_count * sizeof(Pid)) : NULL;
+        for (NodeMonitor *mon = node->monitors; mon && watchers; mon = mon->next) {
+            if (mon->node_name[0] == '\0' || strcmp(mon->node_name, peer->name) == 0) {
+                watchers[count++] = mon->watcher_pid;
             }
+        }
+        pthread_mutex_unlock(&node->lock);
 
-            /* Deliver message via callback */
-            DistributedNode *node = conn->node;
-            if (node && node->on_message) {
-                node->on_message(node->callback_ctx, &conn->peer, target_pid,
-                                 payload, payload_len);
+        if (count > 0) {
+            Value *msg = value_map();
+            msg = map_set(msg, "type", value_string("nodedown"));
+            msg = map_set(msg, "node", value_string(peer->name));
+            for (size_t i = 0; i < count; i++) {
+                scheduler_send(node->scheduler, watchers[i], PID_INVALID, msg);
             }
-            free(payload);
-            conn->messages_received++;
-            break;
+            value_free(msg);
+        }
+        free(watchers);
+    }
+
+    if (node->on_node_down) {
+        node->on_node_down(node->callback_ctx, peer);
+    }
+}
+
+/* Stop reading from a connection after EOF, a protocol error or a timeout */
+static void conn_close_io(DistributedNode *node, NodeConnection *conn) {
+    if (!conn_unwatch(node->io, conn)) return;
+
+    if (conn->state == NODE_CONNECTING) {
+        /* Inbound peer that never completed its handshake */
+        handshaking_remove(node->io, conn);
+        io_retire(node->io, conn);
+        return;
+    }
+
+    /* node_disconnect may race us here; whoever swaps out CONNECTED reports */
+    if (atomic_exchange(&conn->state, NODE_DISCONNECTED) == NODE_CONNECTED) {
+        peer_down(node, &conn->peer);
+    }
+}
+
+/* PIDs name their node by number, so a peer must share it with neither
+ * this node nor another peer. Names hash to numbers, so two names can
+ * collide; NodeConfig.node_number on one side resolves it. Call with
+ * node->lock held. */
+static bool peer_number_free(DistributedNode *node, const NodeConnection *conn,
+                             const NodeId *peer) {
+    if (peer->node_id == node->local.node_id) {
+        LOG_ERROR("node: peer %s has node number %llu, as this node %s does; "
+                  "set node_number on one of them", peer->name,
+                  (unsigned long long)peer->node_id, node->local.name);
+        return false;
+    }
+    for (NodeConnection *other = node->peers; other; other = other->next) {
+        /* A dropped connection keeps its number, and the same node coming
+         * back under its own name is not a collision */
+        NodeState state = other->state;
+        if (other == conn || other->peer.node_id != peer->node_id) continue;
+        if (state != NODE_CONNECTING && state != NODE_CONNECTED) continue;
+        if (strcmp(other->peer.name, peer->name) == 0) continue;
+
+        LOG_ERROR("node: peer %s has node number %llu, as peer %s does; "
+                  "set node_number on one of them", peer->name,
+                  (unsigned long long)peer->node_id, other->peer.name);
+        return false;
+    }
+    return true;
+}
+
+/* Reply to an inbound handshake and publish the connection as a peer */
+static bool accept_handshake(DistributedNode *node, NodeConnection *conn) {
+    /* Refused before replying, so the dialing node's connect fails */
+    pthread_mutex_lock(&node->lock);
+    bool number_free = peer_number_free(node, conn, &conn->peer);
+    pthread_mutex_unlock(&node->lock);
+    if (!number_free) return false;
+
+    if (!send_handshake(conn->socket_fd, &node->local)) return false;
+
+    /* Checked again where the peer is published, so of two colliding
+     * peers handshaking at once only one gets in */
+    pthread_mutex_lock(&node->lock);
+    if (!peer_number_free(node, conn, &conn->peer)) {
+        pthread_mutex_unlock(&node->lock);
+        return false;
+    }
+    conn->state = NODE_CONNECTED;
+    conn->connected_at = timer_current_time_ms();
+    conn->last_heartbeat = conn->connected_at;
+    conn->last_sent = conn->connected_at;
+    conn->next = node->peers;
+    node->peers = conn;
+    node->peer_count++;
+    pthread_mutex_unlock(&node->lock);
+
+    handshaking_remove(node->io, conn);
+
+    if (node->on_node_up) {
+        node->on_node_up(node->callback_ctx, &conn->peer);
+    }
+    return true;
+}
+
+static RemoteSignal remote_signal_of(uint8_t msg_type) {
+    switch (msg_type) {
+    case DIST_MSG_LINK:      return REMOTE_LINK;
+    case DIST_MSG_UNLINK:    return REMOTE_UNLINK;
+    case DIST_MSG_MONITOR:   return REMOTE_MONITOR;
+    case DIST_MSG_DEMONITOR: return REMOTE_DEMONITOR;
+    case DIST_MSG_EXIT:      return REMOTE_EXIT;
+    default:                 return REMOTE_DOWN;
+    }
+}
+
+static uint8_t remote_signal_type(RemoteSignal signal) {
+    switch (signal) {
+    case REMOTE_LINK:      return DIST_MSG_LINK;
+    case REMOTE_UNLINK:    return DIST_MSG_UNLINK;
+    case REMOTE_MONITOR:   return DIST_MSG_MONITOR;
+    case REMOTE_DEMONITOR: return DIST_MSG_DEMONITOR;
+    case REMOTE_EXIT:      return DIST_MSG_EXIT;
+    case REMOTE_DOWN:      return DIST_MSG_DOWN;
+    }
+    return DIST_MSG_DOWN;
+}
+
+/* Act on one complete frame at offset in the receive buffer */
+static void dispatch_frame(DistributedNode *node, NodeConnection *conn,
+                           uint8_t msg_type, size_t offset, uint32_t msg_len) {
+    uint8_t *data = conn->recv_buf->data + offset;
+
+    switch (msg_type) {
+    case DIST_MSG_HEARTBEAT:
+        /* Only proves liveness, which every received frame already did */
+        break;
+
+    case DIST_MSG_LINK:
+    case DIST_MSG_UNLINK:
+    case DIST_MSG_MONITOR:
+    case DIST_MSG_DEMONITOR:
+    case DIST_MSG_EXIT:
+    case DIST_MSG_DOWN: {
+        /* Format: [target_pid:8][from_pid:8], then [code:4][reason:...]
+         * for EXIT and DOWN */
+        if (msg_len < 16 || !node->scheduler) break;
+
+        Pid target_pid = 0;
+        Pid from_pid = 0;
+        for (int i = 0; i < 8; i++) {
+            target_pid = (target_pid << 8) | data[i];
+            from_pid = (from_pid << 8) | data[8 + i];
+        }
+
+        int code = 0;
+        char reason[DIST_REASON_MAX] = "error";
+        if (msg_type == DIST_MSG_EXIT || msg_type == DIST_MSG_DOWN) {
+            if (msg_len < 20) break;
+            code = (int)(((uint32_t)data[16] << 24) | ((uint32_t)data[17] << 16) |
+                         ((uint32_t)data[18] << 8) | data[19]);
+            size_t reason_len = msg_len - 20;
+            if (reason_len >= sizeof(reason)) reason_len = sizeof(reason) - 1;
+            memcpy(reason, data + 20, reason_len);
+            reason[reason_len] = '\0';
         }
 
-        default:
-            /* Skip unknown message types */
-            if (msg_len > 0) {
-                uint8_t *skip = malloc(msg_len);
-                if (skip) {
-                    socket_read_exact(conn->socket_fd, skip, msg_len);
-                    free(skip);
+        scheduler_handle_remote(node->scheduler, remote_signal_of(msg_type),
+                                target_pid, from_pid, reason, code);
+        conn->messages_received++;
+        break;
+    }
+
+    case DIST_MSG_SEND: {
+        /* Format: [target_pid:8][sender_pid:8][payload:...] */
+        if (msg_len < 16) break;
+
+        Pid target_pid = 0;
+        Pid sender_pid = 0;
+        for (int i = 0; i < 8; i++) {
+            target_pid = (target_pid << 8) | data[i];
+            sender_pid = (sender_pid << 8) | data[8 + i];
+        }
+
+        size_t payload_len = msg_len - 16;
+        if (node->on_message) {
+            node->on_message(node->callback_ctx, &conn->peer, target_pid,
+                             payload_len > 0 ? data + 16 : NULL, payload_len);
+        }
+        if (node->scheduler || node->on_value) {
+            /* Decode in place; large byte strings borrow the buffer */
+            SerialBuffer buf;
+            serial_buffer_init_shared(&buf, conn->recv_buf, offset + 16, payload_len);
+            SerializeResult res;
+            Value *value = deserialize_value(&buf, &res);
+            serial_buffer_free(&buf);
+
+            if (res == SERIALIZE_OK && node->scheduler) {
+                /* The mailbox takes its own copy */
+                if (!scheduler_send(node->scheduler, target_pid, sender_pid, value)) {
+                    LOG_WARN("node: no block %llu for message from %s",
+                             (unsigned long long)target_pid, conn->peer.name);
                 }
+                value_free(value);
+            } else if (res == SERIALIZE_OK) {
+                node->on_value(node->callback_ctx, &conn->peer, target_pid, value);
+            } else {
+                LOG_WARN("node: dropping undecodable message from %s", conn->peer.name);
+                if (value) value_free(value);
             }
+        }
+        conn->messages_received++;
+        break;
+    }
+
+    default:
+        /* Unknown message types are skipped whole */
+        break;
+    }
+}
+
+/* Decode every complete frame in the receive buffer */
+static bool conn_parse_frames(DistributedNode *node, NodeConnection *conn) {
+    size_t pos = 0;
+    size_t need = 0;
+    bool ok = true;
+
+    while (ok && conn->watched) {
+        uint8_t *frame = conn->recv_buf->data + pos;
+        size_t avail = conn->recv_len - pos;
+
+        if (conn->state == NODE_CONNECTING) {
+            size_t used = 0;
+            int res = parse_handshake(frame, avail, node->config.cookie,
+                                      &conn->peer, &used);
+            if (res == 0) break;
+            pos += used;
+            ok = res > 0 && accept_handshake(node, conn);
+            continue;
+        }
+
+        /* Message header: [type:1][length:4] */
+        if (avail < 5) break;
+        uint32_t msg_len = ((uint32_t)frame[1] << 24) | ((uint32_t)frame[2] << 16) |
+                           ((uint32_t)frame[3] << 8) | frame[4];
+
+        /* Reject messages that are too large (security: prevent memory exhaustion) */
+        if (msg_len > DIST_MAX_MESSAGE_SIZE) {
+            ok = false;
+            break;
+        }
+        if (avail < 5 + (size_t)msg_len) {
+            need = 5 + (size_t)msg_len;
             break;
         }
 
+        dispatch_frame(node, conn, frame[0], pos + 5, msg_len);
         conn->bytes_received += 5 + msg_len;
+        pos += 5 + msg_len;
     }
 
-    return NULL;
+    /* Keep the partial frame, if any, at the front of the buffer */
+    if (pos > 0 && !conn_recv_consume(conn, pos)) {
+        ok = false;
+    }
+    if (ok && need > 0) {
+        ok = conn_recv_reserve(conn, need - conn->recv_len);
+    }
+    return ok;
 }
 
-/* Send handshake to a peer */
-static bool send_handshake(int fd, const NodeId *local) {
-    /* Handshake format: [type:1][version:1][cookie:8][name_len:1][name:var] */
-    size_t name_len = strlen(local->name);
-    if (name_len > 255) name_len = 255;
+static void conn_on_readable(DistributedNode *node, NodeConnection *conn) {
+    if (!conn->watched) return;
 
-    size_t total = 1 + 1 + 8 + 1 + name_len;
-    uint8_t *buf = malloc(total);
-    if (!buf) return false;
+    if (!conn_recv_reserve(conn, DIST_RECV_READ_MIN)) {
+        conn_close_io(node, conn);
+        return;
+    }
 
-    size_t pos = 0;
-    buf[pos++] = DIST_MSG_HANDSHAKE;
-    buf[pos++] = DIST_PROTOCOL_VERSION;
+    ssize_t r = recv(conn->socket_fd, conn->recv_buf->data + conn->recv_len,
+                     conn->recv_buf->capacity - conn->recv_len, MSG_DONTWAIT);
+    if (r < 0 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+    if (r <= 0) {
+        conn_close_io(node, conn);  /* Connection closed or error */
+        return;
+    }
 
-    /* Cookie (8 bytes big-endian) */
-    for (int i = 7; i >= 0; i--) {
-        buf[pos++] = (local->cookie >> (i * 8)) & 0xFF;
+    /* Any traffic proves the peer alive; heartbeats only cover idle links */
+    conn->last_heartbeat = timer_current_time_ms();
+    conn->recv_len += (size_t)r;
+    if (!conn_parse_frames(node, conn)) {
+        conn_close_io(node, conn);
+    }
+}
+
+/* Accept every pending inbound connection; handshakes complete in the loop */
+static void accept_pending(DistributedNode *node) {
+    for (;;) {
+        struct sockaddr_in client_addr;
+        socklen_t addr_len = sizeof(client_addr);
+
+        int client_fd = accept(node->listen_fd, (struct sockaddr *)&client_addr, &addr_len);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            return;  /* EAGAIN: backlog drained */
+        }
+
+        /* Peer sockets block for senders; only the loop's reads are non-blocking */
+        fcntl(client_fd, F_SETFL, fcntl(client_fd, F_GETFL, 0) & ~O_NONBLOCK);
+
+        /* Set TCP_NODELAY */
+        int flag = 1;
+        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+
+        NodeConnection *conn = connection_new(node);
+        if (!conn) {
+            close(client_fd);
+            continue;
+        }
+
+        conn->state = NODE_CONNECTING;
+        conn->socket_fd = client_fd;
+        inet_ntop(AF_INET, &client_addr.sin_addr, conn->peer.host, NODE_HOST_MAX);
+        conn->peer.port = ntohs(client_addr.sin_port);
+
+        conn->next = node->io->handshaking;
+        node->io->handshaking = conn;
+
+        if (!conn_watch(node->io, conn)) {
+            handshaking_remove(node->io, conn);
+            connection_release(conn);
+        }
+    }
+}
+
+static bool conn_send(DistributedNode *node, NodeConnection *conn, uint8_t type,
+                      Pid target_pid, Pid sender_pid, const void *data, size_t len);
+
+/* Heartbeat idle peers and drop silent ones. Peers that sent or received
+ * anything within the interval need no extra traffic. */
+static void io_sweep_peers(DistributedNode *node, uint64_t now) {
+    /* Snapshot under the lock; a heartbeat may block on a full socket.
+     * The references keep a peer disconnected meanwhile alive until we finish. */
+    pthread_mutex_lock(&node->lock);
+    size_t count = 0;
+    NodeConnection **conns = node->peer_count
+        ? malloc(node->peer_count * sizeof(NodeConnection *)) : NULL;
+    for (NodeConnection *conn = node->peers; conn && conns; conn = conn->next) {
+        if (conn->state == NODE_CONNECTED && count < node->peer_count) {
+            connection_retain(conn);
+            conns[count++] = conn;
+        }
+    }
+    pthread_mutex_unlock(&node->lock);
+
+    for (size_t i = 0; i < count; i++) {
+        NodeConnection *conn = conns[i];
+
+        if (node->config.timeout_ms > 0 &&
+            now - conn->last_heartbeat > node->config.timeout_ms) {
+            LOG_WARN("node: peer %s silent for %llu ms, disconnecting", conn->peer.name,
+                     (unsigned long long)(now - conn->last_heartbeat));
+            shutdown(conn->socket_fd, SHUT_RDWR);
+            conn_close_io(node, conn);
+            connection_release(conn);
+            continue;
+        }
+
+        pthread_mutex_lock(&conn->send_lock);
+        bool idle = !conn->send_flushing &&
+                    now - conn->last_sent >= node->config.heartbeat_ms;
+        pthread_mutex_unlock(&conn->send_lock);
+
+        if (idle) {
+            conn_send(node, conn, DIST_MSG_HEARTBEAT, PID_INVALID, PID_INVALID, NULL, 0);
+        }
+        connection_release(conn);
+    }
+    free(conns);
+}
+
+static void *io_loop_fn(void *arg) {
+    DistributedNode *node = (DistributedNode *)arg;
+    NodeIoLoop *io = node->io;
+    void *tags[IO_MAX_EVENTS];
+    uint32_t interval = node->config.heartbeat_ms;
+    uint64_t next_sweep = timer_current_time_ms() + interval;
+
+    for (;;) {
+        pthread_mutex_lock(&io->lock);
+        bool running = io->running;
+        pthread_mutex_unlock(&io->lock);
+        if (!running) break;
+
+        int timeout = -1;
+        if (interval > 0) {
+            uint64_t now = timer_current_time_ms();
+            if (now >= next_sweep) {
+                io_sweep_peers(node, now);
+                next_sweep = now + interval;
+            }
+            timeout = (int)(next_sweep - now);
+        }
+
+        int n = io_wait(io, tags, IO_MAX_EVENTS, timeout);
+        for (int i = 0; i < n; i++) {
+            if (tags[i] == &io_tag_wake) {
+                io_drain_wake(io);
+            } else if (tags[i] == &io_tag_listen) {
+                accept_pending(node);
+            } else {
+                conn_on_readable(node, (NodeConnection *)tags[i]);
+            }
+        }
+
+        io_free_retired(io);
     }
 
-    buf[pos++] = (uint8_t)name_len;
-    memcpy(buf + pos, local->name, name_len);
+    return NULL;
+}
+
+static bool io_loop_start(DistributedNode *node) {
+    NodeIoLoop *io = node->io;
+    bool ok = true;
+
+    pthread_mutex_lock(&io->lock);
+    if (!io->running) {
+        io->running = true;
+        if (pthread_create(&io->thread, NULL, io_loop_fn, node) != 0) {
+            LOG_ERROR("node: failed to start event loop thread");
+            io->running = false;
+            ok = false;
+        }
+    }
+    pthread_mutex_unlock(&io->lock);
 
-    bool ok = socket_write_exact(fd, buf, total);
-    free(buf);
     return ok;
 }
 
-/* Read handshake from a peer */
-static bool read_handshake(int fd, uint64_t expected_cookie, NodeId *peer_out) {
-    /* Read fixed part: [type:1][version:1][cookie:8][name_len:1] */
-    uint8_t header[11];
-    if (!socket_read_exact(fd, header, 11)) return false;
+static void io_loop_stop(DistributedNode *node) {
+    NodeIoLoop *io = node->io;
 
-    if (header[0] != DIST_MSG_HANDSHAKE) return false;
-    if (header[1] != DIST_PROTOCOL_VERSION) return false;
+    pthread_mutex_lock(&io->lock);
+    bool was_running = io->running;
+    io->running = false;
+    pthread_mutex_unlock(&io->lock);
 
-    /* Verify cookie */
-    uint64_t cookie = 0;
-    for (int i = 0; i < 8; i++) {
-        cookie = (cookie << 8) | header[2 + i];
+    if (was_running) {
+        io_wake(io);
+        pthread_join(io->thread, NULL);
     }
-    if (cookie != expected_cookie) return false;
+    io_free_retired(io);
 
-    /* Read name */
-    uint8_t name_len = header[10];
-    if (name_len > 0) {
-        if (name_len >= NODE_NAME_MAX) name_len = NODE_NAME_MAX - 1;
-        if (!socket_read_exact(fd, peer_out->name, name_len)) return false;
-        peer_out->name[name_len] = '\0';
-    } else {
-        peer_out->name[0] = '\0';
+    /* Inbound connections that never finished their handshake */
+    NodeConnection *conn = io->handshaking;
+    io->handshaking = NULL;
+    while (conn) {
+        NodeConnection *next = conn->next;
+        conn_unwatch(io, conn);
+        connection_release(conn);
+        conn = next;
     }
-
-    peer_out->cookie = cookie;
-    return true;
 }
 
-static void *accept_thread_fn(void *arg) {
-    DistributedNode *node = (DistributedNode *)arg;
+/* Node Lifecycle */
 
-    while (node->accept_running) {
-        struct sockaddr_in client_addr;
-        socklen_t addr_len = sizeof(client_addr);
+DistributedNode *node_new(const NodeConfig *config) {
+    DistributedNode *node = calloc(1, sizeof(DistributedNode));
+    if (!node) {
+        LOG_ERROR("node: failed to allocate DistributedNode");
+        return NULL;
+    }
 
-        int client_fd = accept(node->listen_fd, (struct sockaddr *)&client_addr, &addr_len);
-        if (client_fd < 0) {
-            if (errno == EINTR || errno == EAGAIN) continue;
-            break;
-        }
+    node->io = io_loop_new();
+    if (!node->io) {
+        LOG_ERROR("node: failed to create event loop");
+        free(node);
+        return NULL;
+    }
 
-        /* Set TCP_NODELAY */
-        int flag = 1;
-        setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    NodeConfig cfg = config ? *config : node_config_default();
 
-        /* Read handshake from client */
-        NodeId peer_id = {0};
-        if (!read_handshake(client_fd, node->config.cookie, &peer_id)) {
-            close(client_fd);
-            continue;
-        }
+    /* Set up local identity */
+    strncpy(node->local.name, cfg.name, NODE_NAME_MAX - 1);
+    strncpy(node->local.host, cfg.host, NODE_HOST_MAX - 1);
+    node->local.port = cfg.port;
+    node->local.cookie = cfg.cookie;
+    node->local.node_id = cfg.node_number ? cfg.node_number : node_number_from_name(cfg.name);
 
-        /* Send our handshake response */
-        if (!send_handshake(client_fd, &node->local)) {
-            close(client_fd);
-            continue;
-        }
+    node->config = cfg;
+    node->peers = NULL;
+    node->peer_count = 0;
+    node->listen_fd = -1;
+    node->monitors = NULL;
+    node->monitor_count = 0;
+    node->running = false;
+
+    node->callback_ctx = NULL;
+    node->on_node_up = NULL;
+    node->on_node_down = NULL;
+    node->on_message = NULL;
 
-        /* Get client address info */
-        inet_ntop(AF_INET, &client_addr.sin_addr, peer_id.host, NODE_HOST_MAX);
-        peer_id.port = ntohs(client_addr.sin_port);
-        peer_id.node_id = timer_current_time_ms();
+    pthread_mutex_init(&node->lock, NULL);
 
-        /* Create connection and add to peers */
-        NodeConnection *conn = calloc(1, sizeof(NodeConnection));
-        if (!conn) {
-            close(client_fd);
-            continue;
-        }
+    return node;
+}
 
-        conn->peer = peer_id;
-        conn->state = NODE_CONNECTED;
-        conn->socket_fd = client_fd;
-        conn->connected_at = timer_current_time_ms();
-        conn->last_heartbeat = conn->connected_at;
-        conn->recv_running = true;
-        conn->node = node;
+void node_free(DistributedNode *node) {
+    if (!node) return;
 
-        /* Add to peers list */
-        pthread_mutex_lock(&node->lock);
-        conn->next = node->peers;
-        node->peers = conn;
-        node->peer_count++;
-        pthread_mutex_unlock(&node->lock);
+    node_stop(node);
+    io_loop_stop(node);  /* Outbound connections start the loop without node_start */
 
-        /* Start receiver thread */
-        if (pthread_create(&conn->recv_thread, NULL, receiver_thread_fn, conn) != 0) {
-            /* Thread creation failed - clean up connection */
-            pthread_mutex_lock(&node->lock);
-            node->peers = conn->next;
-            node->peer_count--;
-            pthread_mutex_unlock(&node->lock);
-            close(conn->socket_fd);
-            free(conn);
-            continue;
-        }
+    pthread_mutex_lock(&node->lock);
 
-        /* Notify callback */
-        if (node->on_node_up) {
-            node->on_node_up(node->callback_ctx, &conn->peer);
-        }
+    /* Free peer connections */
+    NodeConnection *peer = node->peers;
+    while (peer) {
+        NodeConnection *next = peer->next;
+        connection_release(peer);
+        peer = next;
     }
 
-    return NULL;
+    /* Free monitors */
+    NodeMonitor *mon = node->monitors;
+    while (mon) {
+        NodeMonitor *next = mon->next;
+        free(mon);
+        mon = next;
+    }
+
+    pthread_mutex_unlock(&node->lock);
+    pthread_mutex_destroy(&node->lock);
+
+    io_loop_destroy(node->io);
+    free(node);
 }
 
 bool node_start(DistributedNode *node) {
@@ -403,25 +1177,28 @@ bool node_start(DistributedNode *node) {
         return false;
     }
 
-    /* Listen */
+    /* Listen; the event loop accepts until the backlog would block */
     if (listen(node->listen_fd, 10) < 0) {
         close(node->listen_fd);
         node->listen_fd = -1;
         return false;
     }
+    fcntl(node->listen_fd, F_SETFL, fcntl(node->listen_fd, F_GETFL, 0) | O_NONBLOCK);
 
-    /* Start accept thread */
-    node->accept_running = true;
-    node->running = true;
+    if (!io_watch(node->io, node->listen_fd, &io_tag_listen)) {
+        close(node->listen_fd);
+        node->listen_fd = -1;
+        return false;
+    }
 
-    if (pthread_create(&node->accept_thread, NULL, accept_thread_fn, node) != 0) {
+    if (!io_loop_start(node)) {
+        io_unwatch(node->io, node->listen_fd, &io_tag_listen);
         close(node->listen_fd);
         node->listen_fd = -1;
-        node->accept_running = false;
-        node->running = false;
         return false;
     }
 
+    node->running = true;
     return true;
 }
 
@@ -429,73 +1206,69 @@ void node_stop(DistributedNode *node) {
     if (!node || !node->running) return;
 
     node->running = false;
-    node->accept_running = false;
 
-    /* Close listening socket to unblock accept */
+    /* Stop the event loop before closing the sockets it watches */
+    io_loop_stop(node);
+
     if (node->listen_fd >= 0) {
-        shutdown(node->listen_fd, SHUT_RDWR);
+        io_unwatch(node->io, node->listen_fd, &io_tag_listen);
         close(node->listen_fd);
         node->listen_fd = -1;
     }
 
-    /* Wait for accept thread */
-    pthread_join(node->accept_thread, NULL);
-
-    /* Stop all peer receiver threads */
+    /* Shut down peer connections */
     pthread_mutex_lock(&node->lock);
     NodeConnection *peer = node->peers;
     while (peer) {
-        if (peer->recv_running) {
-            peer->recv_running = false;
-            if (peer->socket_fd >= 0) {
-                shutdown(peer->socket_fd, SHUT_RDWR);
-            }
+        if (conn_unwatch(node->io, peer) && peer->socket_fd >= 0) {
+            shutdown(peer->socket_fd, SHUT_RDWR);
         }
         peer = peer->next;
     }
     pthread_mutex_unlock(&node->lock);
 }
 
-/* Peer Connections */
+static bool scheduler_remote_send(void *ctx, Pid target, Pid sender, Value *value) {
+    return node_send_remote((DistributedNode *)ctx, target, sender, value);
+}
 
-bool node_connect(DistributedNode *node, const char *peer_name,
-                  const char *host, uint16_t port) {
-    if (!node || !peer_name || !host) return false;
+static bool node_signal_remote(DistributedNode *node, RemoteSignal signal, Pid target_pid,
+                               Pid from_pid, const char *reason, int code);
 
-    pthread_mutex_lock(&node->lock);
+static bool scheduler_remote_signal(void *ctx, RemoteSignal signal, Pid target, Pid from,
+                                    const char *reason, int code) {
+    return node_signal_remote((DistributedNode *)ctx, signal, target, from, reason, code);
+}
 
-    /* Check if already connected */
-    NodeConnection *existing = node->peers;
-    while (existing) {
-        if (strcmp(existing->peer.name, peer_name) == 0) {
-            pthread_mutex_unlock(&node->lock);
-            return existing->state == NODE_CONNECTED;
-        }
-        existing = existing->next;
-    }
+bool node_attach_scheduler(DistributedNode *node, Scheduler *scheduler) {
+    if (!node || !scheduler) return false;
 
-    /* Create connection */
-    NodeConnection *conn = calloc(1, sizeof(NodeConnection));
-    if (!conn) {
-        pthread_mutex_unlock(&node->lock);
+    /* Deliveries come from the event loop thread, which only worker
+     * run queues accept */
+    if (!scheduler_is_multithreaded(scheduler)) {
+        LOG_ERROR("node: %s needs a scheduler with worker threads", node->local.name);
         return false;
     }
 
-    strncpy(conn->peer.name, peer_name, NODE_NAME_MAX - 1);
-    strncpy(conn->peer.host, host, NODE_HOST_MAX - 1);
-    conn->peer.port = port;
-    conn->peer.cookie = node->config.cookie;
-    conn->state = NODE_CONNECTING;
-    conn->socket_fd = -1;
-    conn->node = node;
+    scheduler_set_node(scheduler, (uint16_t)node->local.node_id,
+                       scheduler_remote_send, scheduler_remote_signal, node);
+    node->scheduler = scheduler;
+    return true;
+}
 
-    /* Add to list */
-    conn->next = node->peers;
-    node->peers = conn;
-    node->peer_count++;
+/* Peer Connections */
 
-    pthread_mutex_unlock(&node->lock);
+/* The named peer, connected or not. Caller holds node->lock. */
+static NodeConnection *peer_by_name(DistributedNode *node, const char *peer_name) {
+    for (NodeConnection *conn = node->peers; conn; conn = conn->next) {
+        if (strcmp(conn->peer.name, peer_name) == 0) return conn;
+    }
+    return NULL;
+}
 
+/* Open the socket and handshake for a connection already in the peer list */
+static bool conn_establish(DistributedNode *node, NodeConnection *conn,
+                           const char *host, uint16_t port) {
     /* Create socket */
     int sock = socket(AF_INET, SOCK_STREAM, 0);
     if (sock < 0) {
@@ -571,27 +1344,44 @@ bool node_connect(DistributedNode *node, const char *peer_name,
     conn->socket_fd = sock;
     conn->connected_at = timer_current_time_ms();
     conn->last_heartbeat = conn->connected_at;
+    conn->last_sent = conn->connected_at;
 
     /* Send handshake */
     if (!send_handshake(sock, &node->local)) {
         close(sock);
+        conn->socket_fd = -1;
         conn->state = NODE_FAILED;
         return false;
     }
 
     /* Read handshake response */
     NodeId peer_response = {0};
-    if (!read_handshake(sock, node->config.cookie, &peer_response)) {
+    bool accepted = read_handshake(sock, node->config.cookie, &peer_response);
+    if (accepted) {
+        /* Report the name we dialed; the number is claimed under the lock */
+        strncpy(peer_response.name, conn->peer.name, NODE_NAME_MAX - 1);
+        pthread_mutex_lock(&node->lock);
+        accepted = peer_number_free(node, conn, &peer_response);
+        if (accepted) conn->peer.node_id = peer_response.node_id;
+        pthread_mutex_unlock(&node->lock);
+    }
+    if (!accepted) {
         close(sock);
+        conn->socket_fd = -1;
         conn->state = NODE_FAILED;
         return false;
     }
 
     conn->state = NODE_CONNECTED;
-    conn->recv_running = true;
 
-    /* Start receiver thread */
-    pthread_create(&conn->recv_thread, NULL, receiver_thread_fn, conn);
+    /* Hand the socket to the event loop for receiving */
+    if (!conn_watch(node->io, conn) || !io_loop_start(node)) {
+        conn_unwatch(node->io, conn);
+        close(sock);
+        conn->socket_fd = -1;
+        conn->state = NODE_FAILED;
+        return false;
+    }
 
     /* Notify callback */
     if (node->on_node_up) {
@@ -601,6 +1391,46 @@ bool node_connect(DistributedNode *node, const char *peer_name,
     return true;
 }
 
+bool node_connect(DistributedNode *node, const char *peer_name,
+                  const char *host, uint16_t port) {
+    if (!node || !peer_name || !host) return false;
+
+    pthread_mutex_lock(&node->lock);
+
+    /* Check if already connected */
+    NodeConnection *existing = peer_by_name(node, peer_name);
+    if (existing) {
+        bool connected = existing->state == NODE_CONNECTED;
+        pthread_mutex_unlock(&node->lock);
+        return connected;
+    }
+
+    /* Create connection */
+    NodeConnection *conn = connection_new(node);
+    if (!conn) {
+        pthread_mutex_unlock(&node->lock);
+        return false;
+    }
+
+    strncpy(conn->peer.name, peer_name, NODE_NAME_MAX - 1);
+    strncpy(conn->peer.host, host, NODE_HOST_MAX - 1);
+    conn->peer.port = port;
+    conn->peer.cookie = node->config.cookie;
+    conn->state = NODE_CONNECTING;
+
+    /* Add to list; our own reference survives a concurrent node_disconnect */
+    conn->next = node->peers;
+    node->peers = conn;
+    node->peer_count++;
+    connection_retain(conn);
+
+    pthread_mutex_unlock(&node->lock);
+
+    bool ok = conn_establish(node, conn, host, port);
+    connection_release(conn);
+    return ok;
+}
+
 void node_disconnect(DistributedNode *node, const char *peer_name) {
     if (!node || !peer_name) return;
 
@@ -615,26 +1445,21 @@ void node_disconnect(DistributedNode *node, const char *peer_name) {
             node->peer_count--;
             pthread_mutex_unlock(&node->lock);
 
-            /* Stop receiver thread - shutdown socket to unblock recv */
-            bool was_running = conn->recv_running;
-            conn->recv_running = false;
+            NodeId peer = conn->peer;
+            bool was_connected =
+                atomic_exchange(&conn->state, NODE_DISCONNECTED) == NODE_CONNECTED;
+
+            /* Stop receiving and let the event loop close and free it */
+            conn_unwatch(node->io, conn);
             if (conn->socket_fd >= 0) {
                 shutdown(conn->socket_fd, SHUT_RDWR);
-                close(conn->socket_fd);
-                conn->socket_fd = -1;
             }
+            io_retire(node->io, conn);
 
-            /* Wait for receiver thread to finish */
-            if (was_running) {
-                pthread_join(conn->recv_thread, NULL);
+            /* A peer the event loop already lost was reported then */
+            if (was_connected) {
+                peer_down(node, &peer);
             }
-
-            /* Notify callback */
-            if (node->on_node_down) {
-                node->on_node_down(node->callback_ctx, &conn->peer);
-            }
-
-            free(conn);
             return;
         }
         pp = &conn->next;
@@ -647,18 +1472,20 @@ NodeConnection *node_get_peer(DistributedNode *node, const char *peer_name) {
     if (!node || !peer_name) return NULL;
 
     pthread_mutex_lock(&node->lock);
+    NodeConnection *conn = peer_by_name(node, peer_name);
+    pthread_mutex_unlock(&node->lock);
+    return conn;
+}
 
-    NodeConnection *conn = node->peers;
-    while (conn) {
-        if (strcmp(conn->peer.name, peer_name) == 0) {
-            pthread_mutex_unlock(&node->lock);
-            return conn;
-        }
-        conn = conn->next;
-    }
+/* A reference to the named peer for sending; release it when done */
+static NodeConnection *peer_acquire(DistributedNode *node, const char *peer_name) {
+    if (!node || !peer_name) return NULL;
 
+    pthread_mutex_lock(&node->lock);
+    NodeConnection *conn = peer_by_name(node, peer_name);
+    if (conn) connection_retain(conn);
     pthread_mutex_unlock(&node->lock);
-    return NULL;
+    return conn;
 }
 
 const NodeId *node_list_peers(DistributedNode *node, size_t *count) {
@@ -710,65 +1537,122 @@ const NodeId *node_list_peers(DistributedNode *node, size_t *count) {
 }
 
 bool node_is_connected(DistributedNode *node, const char *peer_name) {
-    NodeConnection *conn = node_get_peer(node, peer_name);
-    return conn && conn->state == NODE_CONNECTED;
+    if (!node || !peer_name) return false;
+
+    pthread_mutex_lock(&node->lock);
+    NodeConnection *conn = peer_by_name(node, peer_name);
+    bool connected = conn && conn->state == NODE_CONNECTED;
+    pthread_mutex_unlock(&node->lock);
+    return connected;
 }
 
 /* Messaging */
 
-bool node_send(DistributedNode *node, const char *peer_name,
-               Pid target_pid, Pid sender_pid, const void *data, size_t len) {
-    NodeConnection *conn = node_get_peer(node, peer_name);
+/* Account for a frame written or queued. Caller holds send_lock. */
+static void conn_count_sent(NodeConnection *conn, uint8_t type, size_t frame_len) {
+    if (type == DIST_MSG_HEARTBEAT) {
+        conn->heartbeats_sent++;
+    } else {
+        conn->messages_sent++;
+    }
+    conn->bytes_sent += frame_len;
+    conn->last_sent = timer_current_time_ms();
+}
+
+/* Frame and write one message, or queue it behind the current writer */
+static bool conn_send(DistributedNode *node, NodeConnection *conn, uint8_t type,
+                      Pid target_pid, Pid sender_pid, const void *data, size_t len) {
     if (!conn || conn->state != NODE_CONNECTED || conn->socket_fd < 0) {
         return false;
     }
+    if (len > DIST_MAX_MESSAGE_SIZE - 16) {
+        return false;
+    }
+    if (!data) len = 0;
 
-    /* Message format: [type:1][length:4][target_pid:8][sender_pid:8][payload:...]
-     * where length = 16 + payload_len (PIDs + payload) */
-    uint8_t header[5];
-    size_t hlen = 0;
-
-    /* Message type */
-    header[hlen++] = DIST_MSG_SEND;
+    uint8_t header[DIST_SEND_HEADER_SIZE];
+    frame_send_header(header, type, target_pid, sender_pid, len);
+    size_t frame_len = DIST_SEND_HEADER_SIZE + len;
 
-    /* Message length (4 bytes big-endian): PIDs (16 bytes) + payload */
-    uint32_t msg_len = 16 + (uint32_t)len;
-    header[hlen++] = (msg_len >> 24) & 0xFF;
-    header[hlen++] = (msg_len >> 16) & 0xFF;
-    header[hlen++] = (msg_len >> 8) & 0xFF;
-    header[hlen++] = msg_len & 0xFF;
+    pthread_mutex_lock(&conn->send_lock);
 
-    /* Send message header */
-    if (!socket_write_exact(conn->socket_fd, header, hlen)) {
-        return false;
+    /* Another sender owns the socket: leave the frame for its next batch */
+    if (conn->send_flushing) {
+        bool ok = send_queue_append(conn, header, data, len);
+        if (ok) {
+            conn_count_sent(conn, type, frame_len);
+        }
+        pthread_mutex_unlock(&conn->send_lock);
+        return ok;
     }
 
-    /* Send PIDs (16 bytes total) */
-    uint8_t pids[16];
-    for (int i = 7; i >= 0; i--) {
-        pids[7 - i] = (target_pid >> (i * 8)) & 0xFF;
-        pids[15 - i] = (sender_pid >> (i * 8)) & 0xFF;
+    conn->send_flushing = true;
+    bool ok = true;
+
+    if (node->config.flush_delay_us > 0) {
+        /* Give concurrent senders a window to join this batch */
+        ok = send_queue_append(conn, header, data, len);
+        pthread_mutex_unlock(&conn->send_lock);
+
+        if (ok) {
+            struct timespec ts = {
+                .tv_sec = node->config.flush_delay_us / 1000000,
+                .tv_nsec = (long)(node->config.flush_delay_us % 1000000) * 1000,
+            };
+            nanosleep(&ts, NULL);
+        }
+    } else {
+        pthread_mutex_unlock(&conn->send_lock);
+
+        struct iovec iov[2] = {
+            { .iov_base = header, .iov_len = DIST_SEND_HEADER_SIZE },
+            { .iov_base = (void *)data, .iov_len = len },
+        };
+        ok = socket_writev_exact(conn->socket_fd, iov, len > 0 ? 2 : 1);
     }
-    if (!socket_write_exact(conn->socket_fd, pids, 16)) {
-        return false;
+
+    pthread_mutex_lock(&conn->send_lock);
+    if (ok) {
+        conn_count_sent(conn, type, frame_len);
+        if (node->config.flush_delay_us == 0) conn->flushes++;
     }
 
-    /* Send payload */
-    if (len > 0 && data) {
-        if (!socket_write_exact(conn->socket_fd, data, len)) {
-            return false;
+    /* Drain whatever queued up behind us, one write per batch */
+    while (ok && conn->send_queue_len > 0) {
+        uint8_t *batch = conn->send_queue;
+        size_t batch_len = conn->send_queue_len;
+        size_t batch_cap = conn->send_queue_cap;
+        conn->send_queue = NULL;
+        conn->send_queue_len = 0;
+        conn->send_queue_cap = 0;
+        pthread_mutex_unlock(&conn->send_lock);
+
+        struct iovec iov = { .iov_base = batch, .iov_len = batch_len };
+        ok = socket_writev_exact(conn->socket_fd, &iov, 1);
+
+        pthread_mutex_lock(&conn->send_lock);
+        conn->flushes++;
+        if (!conn->send_queue && batch_cap <= DIST_SEND_QUEUE_RETAIN) {
+            conn->send_queue = batch;
+            conn->send_queue_cap = batch_cap;
+        } else {
+            free(batch);
         }
     }
 
-    conn->messages_sent++;
-    conn->bytes_sent += hlen + 16 + len;
+    if (!ok) {
+        /* The stream is broken; frames behind the failed write cannot be sent */
+        conn->send_queue_len = 0;
+    }
+    conn->send_flushing = false;
+    pthread_mutex_unlock(&conn->send_lock);
 
-    return true;
+    return ok;
 }
 
-bool node_send_value(DistributedNode *node, const char *peer_name,
-                     Pid target_pid, Pid sender_pid, struct Value *value) {
-    if (!value) return false;
+static bool conn_send_value(DistributedNode *node, NodeConnection *conn,
+                            Pid target_pid, Pid sender_pid, Value *value) {
+    if (!conn || !value) return false;
 
     /* Serialize value */
     SerialBuffer buf;
@@ -780,12 +1664,79 @@ bool node_send_value(DistributedNode *node, const char *peer_name,
         return false;
     }
 
-    bool ok = node_send(node, peer_name, target_pid, sender_pid, buf.data, buf.size);
+    bool ok = conn_send(node, conn, DIST_MSG_SEND, target_pid, sender_pid,
+                        buf.data, buf.size);
     serial_buffer_free(&buf);
 
     return ok;
 }
 
+bool node_send(DistributedNode *node, const char *peer_name,
+               Pid target_pid, Pid sender_pid, const void *data, size_t len) {
+    NodeConnection *conn = peer_acquire(node, peer_name);
+    bool ok = conn_send(node, conn, DIST_MSG_SEND, target_pid, sender_pid, data, len);
+    connection_release(conn);
+    return ok;
+}
+
+bool node_send_value(DistributedNode *node, const char *peer_name,
+                     Pid target_pid, Pid sender_pid, struct Value *value) {
+    NodeConnection *conn = peer_acquire(node, peer_name);
+    bool ok = conn_send_value(node, conn, target_pid, sender_pid, value);
+    connection_release(conn);
+    return ok;
+}
+
+/* A reference to the connected peer whose blocks carry the node number in
+ * pid; release it when done */
+static NodeConnection *peer_for_pid(DistributedNode *node, Pid pid) {
+    uint16_t number = pid_node(pid);
+    pthread_mutex_lock(&node->lock);
+    NodeConnection *conn = node->peers;
+    while (conn && !(conn->state == NODE_CONNECTED && conn->peer.node_id == number)) {
+        conn = conn->next;
+    }
+    if (conn) connection_retain(conn);
+    pthread_mutex_unlock(&node->lock);
+    return conn;
+}
+
+bool node_send_remote(DistributedNode *node, Pid target_pid, Pid sender_pid,
+                      struct Value *value) {
+    if (!node) return false;
+
+    NodeConnection *conn = peer_for_pid(node, target_pid);
+    bool ok = conn_send_value(node, conn, target_pid, sender_pid, value);
+    connection_release(conn);
+    return ok;
+}
+
+static bool node_signal_remote(DistributedNode *node, RemoteSignal signal, Pid target_pid,
+                               Pid from_pid, const char *reason, int code) {
+    NodeConnection *conn = peer_for_pid(node, target_pid);
+    if (!conn) return false;
+
+    /* Payload for exits and downs: [code:4][reason:...] */
+    uint8_t payload[4 + DIST_REASON_MAX];
+    size_t payload_len = 0;
+    if (signal == REMOTE_EXIT || signal == REMOTE_DOWN) {
+        size_t reason_len = reason ? strlen(reason) : 0;
+        if (reason_len > DIST_REASON_MAX - 1) reason_len = DIST_REASON_MAX - 1;
+        uint32_t ucode = (uint32_t)code;
+        payload[0] = (ucode >> 24) & 0xFF;
+        payload[1] = (ucode >> 16) & 0xFF;
+        payload[2] = (ucode >> 8) & 0xFF;
+        payload[3] = ucode & 0xFF;
+        if (reason_len > 0) memcpy(payload + 4, reason, reason_len);
+        payload_len = 4 + reason_len;
+    }
+
+    bool ok = conn_send(node, conn, remote_signal_type(signal), target_pid, from_pid,
+                        payload_len > 0 ? payload : NULL, payload_len);
+    connection_release(conn);
+    return ok;
+}
+
 /* Monitoring */
 
 bool node_monitor(DistributedNode *node, Pid watcher_pid, const char *peer_name) {
@@ -793,7 +1744,7 @@ bool node_monitor(DistributedNode *node, Pid watcher_pid, const char *peer_name)
 
     pthread_mutex_lock(&node->lock);
 
-    NodeMonitor *mon = malloc(sizeof(NodeMonitor));
+    NodeMonitor *mon = calloc(1, sizeof(NodeMonitor));
     if (!mon) {
         pthread_mutex_unlock(&node->lock);
         return false;
@@ -802,8 +1753,6 @@ bool node_monitor(DistributedNode *node, Pid watcher_pid, const char *peer_name)
     mon->watcher_pid = watcher_pid;
     if (peer_name) {
         strncpy(mon->node_name, peer_name, NODE_NAME_MAX - 1);
-    } else {
-        mon->node_name[0] = '\0';
     }
     mon->next = node->monitors;
     node->monitors = mon;
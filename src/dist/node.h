@@ -13,9 +13,11 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
 
 #include "runtime/mailbox.h"
+#include "vm/value.h"
 
 /* Node Identity */
 
@@ -30,11 +32,12 @@ typedef struct NodeId {
     char host[NODE_HOST_MAX];   /* Hostname or IP address */
     uint16_t port;              /* Port number */
     uint64_t cookie;            /* Authentication cookie (shared secret) */
-    uint64_t node_id;           /* Unique numeric ID for fast comparison */
+    uint64_t node_id;           /* Node number carried in PIDs (see pid_node) */
 } NodeId;
 
 /**
- * Extended block identifier for distributed blocks.
+ * Extended block identifier for distributed blocks. PIDs already carry
+ * their node number; this pairs one with the full node identity.
  */
 typedef struct GlobalBlockId {
     Pid local_pid;              /* Local PID (within node) */
@@ -52,23 +55,41 @@ typedef enum NodeState {
 
 /**
  * Connection to a peer node.
+ *
+ * The list holding the connection (peers, handshaking or the event loop's
+ * retired list) owns one reference; threads sending on it take their own
+ * under the node lock. The socket is closed when the last one is dropped.
  */
 typedef struct NodeConnection {
     NodeId peer;                /* Peer node identity */
-    NodeState state;            /* Connection state */
+    _Atomic(NodeState) state;   /* Connection state */
+    _Atomic(uint32_t) refcount;
     int socket_fd;              /* TCP socket file descriptor */
     uint64_t connected_at;      /* Connection timestamp */
-    uint64_t last_heartbeat;    /* Last heartbeat received */
-
-    /* Statistics */
-    uint64_t messages_sent;
-    uint64_t messages_received;
-    uint64_t bytes_sent;
-    uint64_t bytes_received;
-
-    /* Threading */
-    pthread_t recv_thread;      /* Receiver thread */
-    bool recv_running;          /* Receiver thread running */
+    uint64_t last_heartbeat;    /* Last frame of any type received */
+    uint64_t last_sent;         /* Last frame written (guarded by send_lock) */
+
+    /* Statistics (atomic: written by senders and the event loop, read by anyone) */
+    _Atomic(uint64_t) messages_sent;
+    _Atomic(uint64_t) messages_received;
+    _Atomic(uint64_t) bytes_sent;
+    _Atomic(uint64_t) bytes_received;
+    _Atomic(uint64_t) flushes;          /* Socket writes issued for sent frames */
+    _Atomic(uint64_t) heartbeats_sent;  /* Heartbeats written because the link was idle */
+
+    /* Outgoing frames (guarded by send_lock) */
+    pthread_mutex_t send_lock;
+    uint8_t *send_queue;        /* Frames queued while another sender flushes */
+    size_t send_queue_len;
+    size_t send_queue_cap;
+    bool send_flushing;         /* A sender currently owns the socket */
+
+    /* Receive buffer (owned by the node's event loop). Values decoded by
+     * on_value may borrow slices of it, so it is only rewritten in place
+     * while no one else holds a reference. */
+    SharedBuffer *recv_buf;
+    size_t recv_len;            /* Bytes read but not yet parsed */
+    atomic_bool watched;        /* Registered with the event loop */
 
     /* Parent node reference for callbacks */
     struct DistributedNode *node;
@@ -80,14 +101,22 @@ typedef struct NodeConnection {
 
 /**
  * Configuration for a distributed node.
+ *
+ * PIDs carry a 16-bit node number, derived from the name unless
+ * node_number is set. Two names can hash to the same number; a node then
+ * refuses the handshake of a peer whose number matches its own or another
+ * peer's and logs both names. Give one of the two nodes an explicit
+ * node_number, unique within the cluster, to resolve the collision.
  */
 typedef struct NodeConfig {
     char name[NODE_NAME_MAX];   /* This node's name */
     char host[NODE_HOST_MAX];   /* Listen address */
     uint16_t port;              /* Listen port */
     uint64_t cookie;            /* Authentication cookie */
-    uint32_t heartbeat_ms;      /* Heartbeat interval (default: 5000) */
-    uint32_t timeout_ms;        /* Connection timeout (default: 10000) */
+    uint32_t heartbeat_ms;      /* Idle interval before a heartbeat is sent (default: 5000, 0 = off) */
+    uint32_t timeout_ms;        /* Silence before a peer is declared down (default: 10000) */
+    uint32_t flush_delay_us;    /* Wait before flushing to batch sends (default: 0) */
+    uint16_t node_number;       /* Number carried in this node's PIDs (0 = derive from name) */
 } NodeConfig;
 
 /**
@@ -106,8 +135,12 @@ typedef struct DistributedNode {
 
     /* Listening socket */
     int listen_fd;
-    pthread_t accept_thread;
-    bool accept_running;
+
+    /* Event loop owning the listening and peer sockets */
+    struct NodeIoLoop *io;
+
+    /* Scheduler receiving DIST_MSG_SEND payloads, if attached */
+    struct Scheduler *scheduler;
 
     /* Node monitors (processes watching for node down) */
     struct NodeMonitor *monitors;
@@ -119,11 +152,15 @@ typedef struct DistributedNode {
     /* State */
     bool running;
 
-    /* Callbacks */
+    /* Callbacks (invoked on the event loop thread; msg is only valid
+     * for the duration of on_message) */
     void *callback_ctx;
     void (*on_node_up)(void *ctx, const NodeId *node);
-    void (*on_node_down)(void *ctx, const NodeId *node);
+    void (*on_node_down)(void *ctx, const NodeId *node);  /* After links and monitors fired */
     void (*on_message)(void *ctx, const NodeId *from, Pid target, void *msg, size_t len);
+    /* Payload decoded in place from the receive buffer; the callee owns
+     * value. Not called while a scheduler is attached. */
+    void (*on_value)(void *ctx, const NodeId *from, Pid target, struct Value *value);
 } DistributedNode;
 
 /**
@@ -162,6 +199,18 @@ bool node_start(DistributedNode *node);
  */
 void node_stop(DistributedNode *node);
 
+/**
+ * Route a scheduler's messages through this node: its PIDs are stamped
+ * with this node's number, sends to PIDs of connected peers go out as
+ * DIST_MSG_SEND frames, and incoming frames are delivered to its blocks.
+ * Links and monitors across nodes travel as DIST_MSG_LINK..DIST_MSG_DOWN
+ * frames; when a peer is lost, local blocks linked to or monitoring its
+ * blocks get an exit or down with reason "noconnection".
+ * The scheduler needs worker threads. Attach before spawning blocks and
+ * before connecting to peers.
+ */
+bool node_attach_scheduler(DistributedNode *node, struct Scheduler *scheduler);
+
 /* Node API - Connections */
 
 /**
@@ -178,6 +227,8 @@ void node_disconnect(DistributedNode *node, const char *peer_name);
 
 /**
  * Get connection to a peer.
+ * The pointer is borrowed: it stays valid until the peer is disconnected
+ * or the node freed, so only use it from the thread that controls those.
  */
 NodeConnection *node_get_peer(DistributedNode *node, const char *peer_name);
 
@@ -195,6 +246,10 @@ bool node_is_connected(DistributedNode *node, const char *peer_name);
 
 /**
  * Send a message to a remote block.
+ *
+ * Frames are written with a single vectored write. If another thread is
+ * already writing to the peer, the frame is queued and goes out in that
+ * thread's next batch.
  * Returns true if message was queued for sending.
  */
 bool node_send(DistributedNode *node, const char *peer_name,
@@ -206,10 +261,19 @@ bool node_send(DistributedNode *node, const char *peer_name,
 bool node_send_value(DistributedNode *node, const char *peer_name,
                      Pid target_pid, Pid sender_pid, struct Value *value);
 
+/**
+ * Send a value to a block on another node, picking the connected peer
+ * from the node number in target_pid.
+ */
+bool node_send_remote(DistributedNode *node, Pid target_pid, Pid sender_pid,
+                      struct Value *value);
+
 /* Node API - Monitoring */
 
 /**
- * Monitor a node (receive nodedown message on disconnect).
+ * Monitor a node: when it disconnects or times out, watcher_pid receives
+ * {type: "nodedown", node: name} through the attached scheduler. A NULL
+ * peer_name watches every peer.
  */
 bool node_monitor(DistributedNode *node, Pid watcher_pid, const char *peer_name);
 
@@ -254,6 +318,6 @@ void node_format_ref(const NodeId *node, char *buf, size_t buf_size);
 #define DIST_MSG_DOWN       0x09
 
 /* Protocol version */
-#define DIST_PROTOCOL_VERSION 1
+#define DIST_PROTOCOL_VERSION 2
 
 #endif /* AGIM_DIST_NODE_H */
@@ -10,6 +10,7 @@
 #include "lang/parser.h"
 #include "lang/typechecker.h"
 #include "lang/compiler.h"
+#include "lang/regcompiler.h"
 #include "vm/vm.h"
 #include "util/alloc.h"
 #include "debug/log.h"
@@ -25,6 +26,27 @@ void agim_set_strict_types(bool strict) {
     g_strict_types = strict;
 }
 
+/*
+ * Run the type checker. Its expression types are left on the AST for the
+ * compiler either way, but a type error only fails the compile in strict
+ * mode. On failure the error is stored in *error and false returned.
+ */
+static bool check_types(AstNode *ast, const char **error) {
+    TypeChecker *tc = typechecker_new();
+    bool ok = typechecker_check(tc, ast) || !g_strict_types;
+
+    if (!ok && error && typechecker_error(tc)) {
+        char buffer[512];
+        snprintf(buffer, sizeof(buffer), "line %d: type error: %s",
+                 typechecker_error_line(tc), typechecker_error(tc));
+        size_t len = strlen(buffer);
+        *error = agim_alloc(len + 1);
+        memcpy((char *)*error, buffer, len + 1);
+    }
+    typechecker_free(tc);
+    return ok;
+}
+
 Bytecode *agim_compile(const char *source, const char **error) {
     if (error) *error = NULL;
 
@@ -47,25 +69,12 @@ Bytecode *agim_compile(const char *source, const char **error) {
         return NULL;
     }
 
-    /* Type check (if strict mode enabled) */
-    if (g_strict_types) {
-        TypeChecker *tc = typechecker_new();
-        if (!typechecker_check(tc, ast)) {
-            if (error && typechecker_error(tc)) {
-                char buffer[512];
-                snprintf(buffer, sizeof(buffer), "line %d: type error: %s",
-                         typechecker_error_line(tc), typechecker_error(tc));
-                size_t len = strlen(buffer);
-                *error = agim_alloc(len + 1);
-                memcpy((char *)*error, buffer, len + 1);
-            }
-            typechecker_free(tc);
-            ast_free(ast);
-            parser_free(parser);
-            lexer_free(lexer);
-            return NULL;
-        }
-        typechecker_free(tc);
+    /* Type check (errors are fatal only in strict mode) */
+    if (!check_types(ast, error)) {
+        ast_free(ast);
+        parser_free(parser);
+        lexer_free(lexer);
+        return NULL;
     }
 
     /* Compile */
@@ -147,26 +156,13 @@ Bytecode *agim_compile_file(const char *path, const char **error) {
         return NULL;
     }
 
-    /* Type check (if strict mode enabled) */
-    if (g_strict_types) {
-        TypeChecker *tc = typechecker_new();
-        if (!typechecker_check(tc, ast)) {
-            if (error && typechecker_error(tc)) {
-                char buffer[512];
-                snprintf(buffer, sizeof(buffer), "line %d: type error: %s",
-                         typechecker_error_line(tc), typechecker_error(tc));
-                size_t len = strlen(buffer);
-                *error = agim_alloc(len + 1);
-                memcpy((char *)*error, buffer, len + 1);
-            }
-            typechecker_free(tc);
-            ast_free(ast);
-            parser_free(parser);
-            lexer_free(lexer);
-            agim_free(source);
-            return NULL;
-        }
-        typechecker_free(tc);
+    /* Type check (errors are fatal only in strict mode) */
+    if (!check_types(ast, error)) {
+        ast_free(ast);
+        parser_free(parser);
+        lexer_free(lexer);
+        agim_free(source);
+        return NULL;
     }
 
     /* Compile with source path for import resolution */
@@ -191,6 +187,56 @@ Bytecode *agim_compile_file(const char *path, const char **error) {
     return code;
 }
 
+RegChunk *agim_compile_reg(const char *source, const char **error) {
+    if (error) *error = NULL;
+
+    /* Lex */
+    Lexer *lexer = lexer_new(source);
+
+    /* Parse */
+    Parser *parser = parser_new(lexer);
+    AstNode *ast = parser_parse(parser);
+
+    if (!ast) {
+        if (error && parser_error(parser)) {
+            LOG_ERROR("compile: parse error: %s", parser_error(parser));
+            size_t len = strlen(parser_error(parser));
+            *error = agim_alloc(len + 1);
+            memcpy((char *)*error, parser_error(parser), len + 1);
+        }
+        parser_free(parser);
+        lexer_free(lexer);
+        return NULL;
+    }
+
+    /* Type check (errors are fatal only in strict mode) */
+    if (!check_types(ast, error)) {
+        ast_free(ast);
+        parser_free(parser);
+        lexer_free(lexer);
+        return NULL;
+    }
+
+    /* Compile to register code */
+    RegChunk *program = regcompile(ast);
+
+    if (!program) {
+        if (error && regcompile_error()) {
+            size_t len = strlen(regcompile_error());
+            *error = agim_alloc(len + 1);
+            memcpy((char *)*error, regcompile_error(), len + 1);
+        }
+    } else {
+        LOG_DEBUG("compile: compiled source to register code");
+    }
+
+    ast_free(ast);
+    parser_free(parser);
+    lexer_free(lexer);
+
+    return program;
+}
+
 void agim_error_free(const char *error) {
     if (error) {
         agim_free((char *)error);
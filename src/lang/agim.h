@@ -9,11 +9,13 @@
 #define AGIM_LANG_H
 
 #include "vm/bytecode.h"
+#include "vm/regvm.h"
 #include <stdbool.h>
 
 void agim_set_strict_types(bool strict);
 Bytecode *agim_compile(const char *source, const char **error);
 Bytecode *agim_compile_file(const char *path, const char **error);
+RegChunk *agim_compile_reg(const char *source, const char **error);
 void agim_error_free(const char *error);
 
 typedef enum AgimResult {
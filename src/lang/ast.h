@@ -79,6 +79,14 @@ typedef enum NodeType {
     NODE_RANGE,
 } NodeType;
 
+/* Static operand type of an arithmetic node, filled in by the type
+ * checker so the compiler can pick an int-only or float-only opcode */
+typedef enum TypeHint {
+    TYPE_HINT_NONE,
+    TYPE_HINT_INT,
+    TYPE_HINT_FLOAT,
+} TypeHint;
+
 /* AST Node Structure */
 
 typedef struct AstNode AstNode;
@@ -86,6 +94,7 @@ typedef struct AstNode AstNode;
 struct AstNode {
     NodeType type;
     int line;
+    TypeHint hint;
 
     union {
         struct {
@@ -7,6 +7,7 @@
 
 #include "lang/compiler.h"
 #include "lang/module.h"
+#include "lang/optimizer.h"
 #include "util/alloc.h"
 #include "vm/value.h"
 #include "debug/log.h"
@@ -42,6 +43,11 @@ typedef struct FunctionContext {
     LoopContext loops[32];
     size_t loop_depth;
     struct FunctionContext *enclosing;
+
+    /* Peephole state (see peephole()) */
+    size_t recent[4];           /* Start offsets of the latest instructions */
+    size_t recent_count;
+    size_t label;               /* Latest jump target in the chunk */
 } FunctionContext;
 
 /* Compiler Structure */
@@ -54,6 +60,12 @@ struct Compiler {
     bool had_error;
     ModuleCache *module_cache;  /* Cache for imported modules */
     char *source_path;          /* Path of current source file */
+
+    /* Stub compilation (see compiler_compile_stub) */
+    AstNode **stub_operands;    /* Nodes read from local slots 0..count-1 */
+    size_t stub_operand_count;
+    AstNode *stub_root;
+    bool stub_plain_call;       /* stub_root turned out to be a user call */
 };
 
 /* Error Handling */
@@ -80,12 +92,140 @@ static Chunk *current_chunk(Compiler *c) {
     return c->current->chunk;
 }
 
+/* Peephole Fusion */
+
+/*
+ * Common opcode runs are fused into superinstructions as soon as the
+ * instruction completing the run is emitted. Fusion only shrinks the tail
+ * of the chunk, and never across a jump target, so no emitted jump needs
+ * re-patching; a fused conditional jump keeps its operand last, where
+ * emit_jump() expects it. The runs were picked from opcode-pair counts
+ * over examples/ plus the loop headers the compiler generates itself.
+ */
+
+/* Opcode `back` instructions before the latest, or -1 across a jump target */
+static int recent_op(FunctionContext *fn, size_t back) {
+    if (back >= fn->recent_count) return -1;
+    size_t start = fn->recent[fn->recent_count - 1 - back];
+    if (start < fn->label && back > 0) return -1;
+    return fn->chunk->code[start];
+}
+
+static uint16_t recent_arg(FunctionContext *fn, size_t back, size_t index) {
+    size_t start = fn->recent[fn->recent_count - 1 - back];
+    return chunk_read_arg(fn->chunk, start + 1 + index * 2);
+}
+
+/* Replace the latest `count` instructions with `op` and its operands */
+static void fuse(FunctionContext *fn, size_t count, Opcode op,
+                 const uint16_t *args, size_t arg_count) {
+    Chunk *chunk = fn->chunk;
+    size_t start = fn->recent[fn->recent_count - count];
+    int line = chunk->lines[start];
+
+    chunk->code_size = start;
+    fn->recent_count -= count - 1;
+    chunk_write_opcode(chunk, op, line);
+    for (size_t i = 0; i < arg_count; i++) {
+        chunk_write_arg(chunk, args[i], line);
+    }
+}
+
+static bool is_int_one(Chunk *chunk, uint16_t index) {
+    return index < chunk->constants_size &&
+           value_is_int(chunk->constants[index]) &&
+           chunk->constants[index]->as.integer == 1;
+}
+
+static void peephole(Compiler *c) {
+    FunctionContext *fn = c->current;
+    Chunk *chunk = fn->chunk;
+    if (fn->recent_count == 0) return;
+
+    size_t start = fn->recent[fn->recent_count - 1];
+    size_t length = chunk->code_size - start;
+
+    switch (chunk->code[start]) {
+    case OP_ADD:
+    case OP_ADD_INT:
+        /* GET_LOCAL a; GET_LOCAL b; ADD */
+        if (length == 1 && recent_op(fn, 1) == OP_GET_LOCAL &&
+            recent_op(fn, 2) == OP_GET_LOCAL) {
+            uint16_t args[] = {recent_arg(fn, 2, 0), recent_arg(fn, 1, 0)};
+            fuse(fn, 3, OP_ADD_LOCAL_LOCAL, args, 2);
+        }
+        break;
+
+    case OP_SET_LOCAL:
+        /* GET_LOCAL s; CONST 1; ADD; SET_LOCAL s */
+        if (length == 3 &&
+            (recent_op(fn, 1) == OP_ADD || recent_op(fn, 1) == OP_ADD_INT) &&
+            recent_op(fn, 2) == OP_CONST && recent_op(fn, 3) == OP_GET_LOCAL &&
+            is_int_one(chunk, recent_arg(fn, 2, 0)) &&
+            recent_arg(fn, 3, 0) == recent_arg(fn, 0, 0)) {
+            uint16_t args[] = {recent_arg(fn, 0, 0)};
+            fuse(fn, 4, OP_INC_LOCAL, args, 1);
+        }
+        break;
+
+    case OP_MAP_GET_IC:
+        /* GET_LOCAL s; MAP_GET_IC key ic */
+        if (length == 5 && recent_op(fn, 1) == OP_GET_LOCAL) {
+            uint16_t args[] = {recent_arg(fn, 1, 0), recent_arg(fn, 0, 0),
+                               recent_arg(fn, 0, 1)};
+            fuse(fn, 2, OP_GET_LOCAL_MAP_GET_IC, args, 3);
+        }
+        break;
+
+    case OP_JUMP_UNLESS:
+        /* GET_LOCAL s; CONST k | GET_LOCAL b; LT; JUMP_UNLESS */
+        if (length == 3 && recent_op(fn, 1) == OP_LT &&
+            recent_op(fn, 3) == OP_GET_LOCAL) {
+            int rhs = recent_op(fn, 2);
+            uint16_t args[] = {recent_arg(fn, 3, 0), recent_arg(fn, 2, 0),
+                               recent_arg(fn, 0, 0)};
+            if (rhs == OP_CONST) {
+                fuse(fn, 4, OP_LT_LOCAL_CONST_JUMP_UNLESS, args, 3);
+            } else if (rhs == OP_GET_LOCAL) {
+                fuse(fn, 4, OP_LT_LOCAL_LOCAL_JUMP_UNLESS, args, 3);
+            }
+        }
+        break;
+
+    case OP_RETURN:
+        /* CALL n; RETURN: the callee can take over this function's frame.
+         * RETURN stays behind, since a jump may still land on it. */
+        if (fn->enclosing && fn->recent_count >= 2 &&
+            chunk->code[fn->recent[fn->recent_count - 2]] == OP_CALL) {
+            chunk->code[fn->recent[fn->recent_count - 2]] = OP_TAIL_CALL;
+        }
+        break;
+
+    default:
+        break;
+    }
+}
+
+/* Record a jump target at the current offset; fusion never crosses it */
+static size_t mark_label(Compiler *c) {
+    c->current->label = current_chunk(c)->code_size;
+    return c->current->label;
+}
+
 static void emit_byte(Compiler *c, uint8_t byte, int line) {
     chunk_write_byte(current_chunk(c), byte, line);
+    peephole(c);
 }
 
 static void emit_op(Compiler *c, Opcode op, int line) {
+    FunctionContext *fn = c->current;
+    if (fn->recent_count == 4) {
+        memmove(fn->recent, fn->recent + 1, 3 * sizeof(size_t));
+        fn->recent_count = 3;
+    }
+    fn->recent[fn->recent_count++] = current_chunk(c)->code_size;
     chunk_write_opcode(current_chunk(c), op, line);
+    peephole(c);
 }
 
 static void emit_bytes(Compiler *c, uint8_t b1, uint8_t b2, int line) {
@@ -102,6 +242,7 @@ static size_t emit_jump(Compiler *c, Opcode op, int line) {
 
 static void patch_jump(Compiler *c, size_t offset) {
     chunk_patch_jump(current_chunk(c), offset);
+    mark_label(c);
 }
 
 static void emit_loop(Compiler *c, size_t loop_start, int line) {
@@ -184,6 +325,16 @@ static int resolve_local(Compiler *c, const char *name, size_t length) {
     return -1;
 }
 
+/* Slot of an already-evaluated stub operand, or -1 */
+static int resolve_operand(Compiler *c, const AstNode *node) {
+    for (size_t i = 0; i < c->stub_operand_count; i++) {
+        if (c->stub_operands[i] == node) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
 /* Loop Management */
 
 static void begin_loop(Compiler *c, size_t start) {
@@ -299,7 +450,7 @@ static void compile_ident(Compiler *c, AstNode *node) {
         emit_byte(c, slot & 0xFF, node->line);
     } else {
         /* Global variable */
-        size_t index = bytecode_add_string(c->code, name);
+        size_t index = bytecode_add_global(c->code, name);
         emit_op(c, OP_GET_GLOBAL, node->line);
         emit_byte(c, (index >> 8) & 0xFF, node->line);
         emit_byte(c, index & 0xFF, node->line);
@@ -334,6 +485,24 @@ static void compile_binary(Compiler *c, AstNode *node) {
     compile_expr(c, node->as.binary.left);
     compile_expr(c, node->as.binary.right);
 
+    /* Operands the type checker saw as one numeric type */
+    if (node->hint == TYPE_HINT_INT) {
+        switch (op) {
+        case TOK_PLUS: emit_op(c, OP_ADD_INT, node->line); return;
+        case TOK_MINUS: emit_op(c, OP_SUB_INT, node->line); return;
+        case TOK_STAR: emit_op(c, OP_MUL_INT, node->line); return;
+        default: break;
+        }
+    } else if (node->hint == TYPE_HINT_FLOAT) {
+        switch (op) {
+        case TOK_PLUS: emit_op(c, OP_ADD_FLOAT, node->line); return;
+        case TOK_MINUS: emit_op(c, OP_SUB_FLOAT, node->line); return;
+        case TOK_STAR: emit_op(c, OP_MUL_FLOAT, node->line); return;
+        case TOK_SLASH: emit_op(c, OP_DIV_FLOAT, node->line); return;
+        default: break;
+        }
+    }
+
     switch (op) {
     case TOK_PLUS: emit_op(c, OP_ADD, node->line); break;
     case TOK_MINUS: emit_op(c, OP_SUB, node->line); break;
@@ -688,14 +857,17 @@ static void compile_call(Compiler *c, AstNode *node) {
              * 1. Update the original variable for COW correctness
              * 2. Pop the array since push() returns nil */
             if (arr_arg->type == NODE_IDENT) {
-                int slot = resolve_local(c, arr_arg->as.ident.name, strlen(arr_arg->as.ident.name));
+                int slot = resolve_operand(c, arr_arg);
+                if (slot == -1) {
+                    slot = resolve_local(c, arr_arg->as.ident.name, strlen(arr_arg->as.ident.name));
+                }
                 if (slot != -1) {
                     /* Local variable */
                     emit_op(c, OP_SET_LOCAL, node->line);
                     emit_bytes(c, (slot >> 8) & 0xFF, slot & 0xFF, node->line);
                 } else {
                     /* Global variable */
-                    size_t index = bytecode_add_string(c->code, arr_arg->as.ident.name);
+                    size_t index = bytecode_add_global(c->code, arr_arg->as.ident.name);
                     emit_op(c, OP_SET_GLOBAL, node->line);
                     emit_byte(c, (index >> 8) & 0xFF, node->line);
                     emit_byte(c, index & 0xFF, node->line);
@@ -721,14 +893,17 @@ static void compile_call(Compiler *c, AstNode *node) {
              * 1. Update the original variable with modified array (for COW correctness)
              * 2. Pop the array, leaving popped_element as return value */
             if (arr_arg->type == NODE_IDENT) {
-                int slot = resolve_local(c, arr_arg->as.ident.name, strlen(arr_arg->as.ident.name));
+                int slot = resolve_operand(c, arr_arg);
+                if (slot == -1) {
+                    slot = resolve_local(c, arr_arg->as.ident.name, strlen(arr_arg->as.ident.name));
+                }
                 if (slot != -1) {
                     /* Local variable */
                     emit_op(c, OP_SET_LOCAL, node->line);
                     emit_bytes(c, (slot >> 8) & 0xFF, slot & 0xFF, node->line);
                 } else {
                     /* Global variable */
-                    size_t index = bytecode_add_string(c->code, arr_arg->as.ident.name);
+                    size_t index = bytecode_add_global(c->code, arr_arg->as.ident.name);
                     emit_op(c, OP_SET_GLOBAL, node->line);
                     emit_byte(c, (index >> 8) & 0xFF, node->line);
                     emit_byte(c, index & 0xFF, node->line);
@@ -784,6 +959,17 @@ static void compile_call(Compiler *c, AstNode *node) {
             return;
         }
 
+        /* freeze(x) -> OP_FREEZE */
+        if (strcmp(name, "freeze") == 0) {
+            if (node->as.call.arg_count != 1) {
+                compile_error(c, node->line, "freeze() takes exactly 1 argument");
+                return;
+            }
+            compile_expr(c, node->as.call.args[0]);
+            emit_op(c, OP_FREEZE, node->line);
+            return;
+        }
+
         /* shell(command) -> OP_SHELL */
         if (strcmp(name, "shell") == 0) {
             if (node->as.call.arg_count != 1) {
@@ -828,6 +1014,29 @@ static void compile_call(Compiler *c, AstNode *node) {
             return;
         }
 
+        /* receive_timeout(ms) -> OP_RECEIVE_TIMEOUT (Ok(msg) or Err("timeout")) */
+        if (strcmp(name, "receive_timeout") == 0) {
+            if (node->as.call.arg_count != 1) {
+                compile_error(c, node->line, "receive_timeout() takes exactly 1 argument");
+                return;
+            }
+            compile_expr(c, node->as.call.args[0]);
+            emit_op(c, OP_RECEIVE_TIMEOUT, node->line);
+            return;
+        }
+
+        /* receive_many(n, ms) -> OP_RECEIVE_MANY ([[sender, msg], ...], [] on timeout) */
+        if (strcmp(name, "receive_many") == 0) {
+            if (node->as.call.arg_count != 2) {
+                compile_error(c, node->line, "receive_many() takes exactly 2 arguments");
+                return;
+            }
+            compile_expr(c, node->as.call.args[0]);
+            compile_expr(c, node->as.call.args[1]);
+            emit_op(c, OP_RECEIVE_MANY, node->line);
+            return;
+        }
+
         /* self() -> OP_SELF */
         if (strcmp(name, "self") == 0) {
             if (node->as.call.arg_count != 0) {
@@ -1597,6 +1806,11 @@ static void compile_call(Compiler *c, AstNode *node) {
     }
 
     /* Regular function call */
+    if (node == c->stub_root) {
+        c->stub_plain_call = true;
+        return;
+    }
+
     compile_expr(c, callee);
 
     for (size_t i = 0; i < node->as.call.arg_count; i++) {
@@ -1676,7 +1890,7 @@ static void compile_assign(Compiler *c, AstNode *node) {
             emit_byte(c, (slot >> 8) & 0xFF, node->line);
             emit_byte(c, slot & 0xFF, node->line);
         } else {
-            size_t index = bytecode_add_string(c->code, name);
+            size_t index = bytecode_add_global(c->code, name);
             emit_op(c, OP_SET_GLOBAL, node->line);
             emit_byte(c, (index >> 8) & 0xFF, node->line);
             emit_byte(c, index & 0xFF, node->line);
@@ -2142,6 +2356,15 @@ static void compile_match(Compiler *c, AstNode *node) {
 static void compile_expr(Compiler *c, AstNode *node) {
     if (c->had_error) return;
 
+    if (c->stub_operand_count > 0) {
+        int slot = resolve_operand(c, node);
+        if (slot >= 0) {
+            emit_op(c, OP_GET_LOCAL, node->line);
+            emit_bytes(c, (slot >> 8) & 0xFF, slot & 0xFF, node->line);
+            return;
+        }
+    }
+
     switch (node->type) {
     case NODE_NIL:
     case NODE_BOOL:
@@ -2251,7 +2474,7 @@ static void compile_let(Compiler *c, AstNode *node, bool is_const) {
         add_local(c, node->as.var_decl.name, strlen(node->as.var_decl.name), is_const, node->line);
     } else {
         /* Global variable */
-        size_t index = bytecode_add_string(c->code, node->as.var_decl.name);
+        size_t index = bytecode_add_global(c->code, node->as.var_decl.name);
         emit_op(c, OP_SET_GLOBAL, node->line);
         emit_byte(c, (index >> 8) & 0xFF, node->line);
         emit_byte(c, index & 0xFF, node->line);
@@ -2259,43 +2482,56 @@ static void compile_let(Compiler *c, AstNode *node, bool is_const) {
     }
 }
 
+static void compile_if(Compiler *c, AstNode *node);
+
+/* Compile an if branch as an expression (keeps its value on the stack) */
+static void compile_branch(Compiler *c, AstNode *branch, int line) {
+    if (!branch) {
+        /* Missing else: nil is the branch value */
+        emit_op(c, OP_NIL, line);
+    } else if (branch->type == NODE_BLOCK) {
+        compile_block_expr(c, branch);
+    } else if (branch->type == NODE_IF) {
+        /* Else-if chain */
+        compile_if(c, branch);
+    } else {
+        compile_expr(c, branch);
+    }
+}
+
 static void compile_if(Compiler *c, AstNode *node) {
+    /* A literal condition always takes one branch; skip the other */
+    bool truthy;
+    if (ast_literal_truthy(node->as.if_stmt.cond, &truthy)) {
+        compile_branch(c, truthy ? node->as.if_stmt.then_block
+                                 : node->as.if_stmt.else_block, node->line);
+        return;
+    }
+
     compile_expr(c, node->as.if_stmt.cond);
     size_t else_jump = emit_jump(c, OP_JUMP_UNLESS, node->line);
     emit_op(c, OP_POP, node->line);
 
-    /* Compile then branch as expression (keeps value on stack) */
-    if (node->as.if_stmt.then_block->type == NODE_BLOCK) {
-        compile_block_expr(c, node->as.if_stmt.then_block);
-    } else {
-        compile_expr(c, node->as.if_stmt.then_block);
-    }
+    compile_branch(c, node->as.if_stmt.then_block, node->line);
 
     size_t end_jump = emit_jump(c, OP_JUMP, node->line);
 
     patch_jump(c, else_jump);
     emit_op(c, OP_POP, node->line);
 
-    if (node->as.if_stmt.else_block) {
-        /* Compile else branch as expression */
-        if (node->as.if_stmt.else_block->type == NODE_BLOCK) {
-            compile_block_expr(c, node->as.if_stmt.else_block);
-        } else if (node->as.if_stmt.else_block->type == NODE_IF) {
-            /* Else-if chain */
-            compile_if(c, node->as.if_stmt.else_block);
-        } else {
-            compile_expr(c, node->as.if_stmt.else_block);
-        }
-    } else {
-        /* No else: push nil as the else value */
-        emit_op(c, OP_NIL, node->line);
-    }
+    compile_branch(c, node->as.if_stmt.else_block, node->line);
 
     patch_jump(c, end_jump);
 }
 
 static void compile_while(Compiler *c, AstNode *node) {
-    size_t loop_start = current_chunk(c)->code_size;
+    /* A loop whose condition is a falsy literal never runs */
+    bool truthy;
+    if (ast_literal_truthy(node->as.while_stmt.cond, &truthy) && !truthy) {
+        return;
+    }
+
+    size_t loop_start = mark_label(c);
     begin_loop(c, loop_start);
 
     compile_expr(c, node->as.while_stmt.cond);
@@ -2339,7 +2575,7 @@ static void compile_for_range(Compiler *c, AstNode *node, AstNode *range) {
     int var_slot = resolve_local(c, var_name, strlen(var_name));
 
     /* Loop start */
-    size_t loop_start = current_chunk(c)->code_size;
+    size_t loop_start = mark_label(c);
     begin_loop(c, loop_start);
 
     /* Condition: i < __end (or i <= __end for inclusive) */
@@ -2413,7 +2649,7 @@ static void compile_for(Compiler *c, AstNode *node) {
     int idx_slot = resolve_local(c, "__idx", 5);
 
     /* Loop start */
-    size_t loop_start = current_chunk(c)->code_size;
+    size_t loop_start = mark_label(c);
     begin_loop(c, loop_start);
 
     /* Condition: __idx < len(__iter) */
@@ -2521,6 +2757,62 @@ static void compile_stmt(Compiler *c, AstNode *node) {
 
 /* Declaration Compilation */
 
+void compiler_add_tool(Bytecode *code, AstNode *node, size_t fn_index) {
+    const char **param_names = NULL;
+    const char **param_types = NULL;
+    const char **param_descriptions = NULL;
+
+    if (node->as.fn_decl.param_count > 0) {
+        param_names = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
+        param_types = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
+        param_descriptions = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
+
+        /* Extract parameter descriptions from params_map if present */
+        AstNode *params_map = node->as.fn_decl.params_map;
+
+        for (size_t i = 0; i < node->as.fn_decl.param_count; i++) {
+            AstNode *param = node->as.fn_decl.params[i];
+            param_names[i] = param->as.param.name;
+            param_descriptions[i] = NULL;
+
+            /* Extract type name from type annotation node */
+            if (param->as.param.type_ann && param->as.param.type_ann->type == NODE_TYPE_NAME) {
+                param_types[i] = param->as.param.type_ann->as.type_name.name;
+            } else {
+                param_types[i] = NULL;
+            }
+
+            /* Look up description in params_map */
+            if (params_map && params_map->type == NODE_MAP) {
+                for (size_t j = 0; j < params_map->as.map.count; j++) {
+                    if (strcmp(params_map->as.map.keys[j], param->as.param.name) == 0) {
+                        AstNode *desc_node = params_map->as.map.values[j];
+                        if (desc_node && desc_node->type == NODE_STRING) {
+                            param_descriptions[i] = desc_node->as.string_val;
+                        }
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    /* Extract return type name if present */
+    const char *ret_type = NULL;
+    if (node->as.fn_decl.return_type && node->as.fn_decl.return_type->type == NODE_TYPE_NAME) {
+        ret_type = node->as.fn_decl.return_type->as.type_name.name;
+    }
+
+    bytecode_add_tool(code, node->as.fn_decl.name, fn_index,
+                      param_names, param_types, param_descriptions,
+                      node->as.fn_decl.param_count, ret_type,
+                      node->as.fn_decl.description);
+
+    if (param_names) agim_free(param_names);
+    if (param_types) agim_free(param_types);
+    if (param_descriptions) agim_free(param_descriptions);
+}
+
 static void compile_fn(Compiler *c, AstNode *node, bool is_tool) {
     /* Create new function chunk */
     Chunk *fn_chunk = chunk_new();
@@ -2532,6 +2824,8 @@ static void compile_fn(Compiler *c, AstNode *node, bool is_tool) {
     fn_ctx.local_count = 0;
     fn_ctx.scope_depth = 0;
     fn_ctx.loop_depth = 0;
+    fn_ctx.recent_count = 0;
+    fn_ctx.label = 0;
     fn_ctx.enclosing = c->current;
     c->current = &fn_ctx;
 
@@ -2576,66 +2870,14 @@ static void compile_fn(Compiler *c, AstNode *node, bool is_tool) {
     emit_op(c, OP_CONST, node->line);
     emit_bytes(c, (const_idx >> 8) & 0xFF, const_idx & 0xFF, node->line);
 
-    size_t name_idx = bytecode_add_string(c->code, node->as.fn_decl.name);
+    size_t name_idx = bytecode_add_global(c->code, node->as.fn_decl.name);
     emit_op(c, OP_SET_GLOBAL, node->line);
     emit_bytes(c, (name_idx >> 8) & 0xFF, name_idx & 0xFF, node->line);
     emit_op(c, OP_POP, node->line);
 
     /* Register tool metadata */
     if (is_tool) {
-        const char **param_names = NULL;
-        const char **param_types = NULL;
-        const char **param_descriptions = NULL;
-
-        if (node->as.fn_decl.param_count > 0) {
-            param_names = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
-            param_types = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
-            param_descriptions = agim_alloc(sizeof(char *) * node->as.fn_decl.param_count);
-
-            /* Extract parameter descriptions from params_map if present */
-            AstNode *params_map = node->as.fn_decl.params_map;
-
-            for (size_t i = 0; i < node->as.fn_decl.param_count; i++) {
-                AstNode *param = node->as.fn_decl.params[i];
-                param_names[i] = param->as.param.name;
-                param_descriptions[i] = NULL;
-
-                /* Extract type name from type annotation node */
-                if (param->as.param.type_ann && param->as.param.type_ann->type == NODE_TYPE_NAME) {
-                    param_types[i] = param->as.param.type_ann->as.type_name.name;
-                } else {
-                    param_types[i] = NULL;
-                }
-
-                /* Look up description in params_map */
-                if (params_map && params_map->type == NODE_MAP) {
-                    for (size_t j = 0; j < params_map->as.map.count; j++) {
-                        if (strcmp(params_map->as.map.keys[j], param->as.param.name) == 0) {
-                            AstNode *desc_node = params_map->as.map.values[j];
-                            if (desc_node && desc_node->type == NODE_STRING) {
-                                param_descriptions[i] = desc_node->as.string_val;
-                            }
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
-        /* Extract return type name if present */
-        const char *ret_type = NULL;
-        if (node->as.fn_decl.return_type && node->as.fn_decl.return_type->type == NODE_TYPE_NAME) {
-            ret_type = node->as.fn_decl.return_type->as.type_name.name;
-        }
-
-        bytecode_add_tool(c->code, node->as.fn_decl.name, fn_index,
-                          param_names, param_types, param_descriptions,
-                          node->as.fn_decl.param_count, ret_type,
-                          node->as.fn_decl.description);
-
-        if (param_names) agim_free(param_names);
-        if (param_types) agim_free(param_types);
-        if (param_descriptions) agim_free(param_descriptions);
+        compiler_add_tool(c->code, node, fn_index);
     }
 }
 
@@ -2815,6 +3057,10 @@ Compiler *compiler_new(void) {
     c->had_error = false;
     c->module_cache = NULL;
     c->source_path = NULL;
+    c->stub_operands = NULL;
+    c->stub_operand_count = 0;
+    c->stub_root = NULL;
+    c->stub_plain_call = false;
     LOG_DEBUG("compiler: created new compiler instance");
     return c;
 }
@@ -2845,6 +3091,8 @@ void compiler_set_source_path(Compiler *c, const char *path) {
 Bytecode *compiler_compile(Compiler *c, AstNode *ast) {
     if (!ast) return NULL;
 
+    ast_optimize(ast);
+
     c->code = bytecode_new();
     c->had_error = false;
 
@@ -2854,6 +3102,8 @@ Bytecode *compiler_compile(Compiler *c, AstNode *ast) {
     main_ctx.local_count = 0;
     main_ctx.scope_depth = 0;
     main_ctx.loop_depth = 0;
+    main_ctx.recent_count = 0;
+    main_ctx.label = 0;
     main_ctx.enclosing = NULL;
     c->current = &main_ctx;
 
@@ -2874,6 +3124,60 @@ Bytecode *compiler_compile(Compiler *c, AstNode *ast) {
     return result;
 }
 
+StubResult compiler_compile_stub(Compiler *c, Bytecode *code, AstNode *expr,
+                                 AstNode **operands, size_t count, size_t *offset) {
+    if (!c || !code || !expr || !offset) return STUB_ERROR;
+    if (count > 255) {
+        compile_error(c, expr->line, "too many operands");
+        return STUB_ERROR;
+    }
+
+    Bytecode *saved_code = c->code;
+    FunctionContext *saved_current = c->current;
+
+    /* Operands occupy the first slots, so they can never shadow a name */
+    FunctionContext stub_ctx;
+    stub_ctx.chunk = code->main;
+    stub_ctx.scope_depth = 1;
+    stub_ctx.loop_depth = 0;
+    stub_ctx.recent_count = 0;
+    stub_ctx.label = code->main->code_size;
+    stub_ctx.enclosing = NULL;
+    for (size_t i = 0; i < count; i++) {
+        stub_ctx.locals[i].name = (char *)"";
+        stub_ctx.locals[i].depth = 1;
+        stub_ctx.locals[i].is_const = false;
+    }
+    stub_ctx.local_count = count;
+
+    c->code = code;
+    c->current = &stub_ctx;
+    c->stub_operands = operands;
+    c->stub_operand_count = count;
+    c->stub_root = expr;
+    c->stub_plain_call = false;
+
+    *offset = code->main->code_size;
+    compile_expr(c, expr);
+    emit_op(c, OP_HALT, expr->line);
+
+    StubResult result = STUB_OK;
+    if (c->had_error) {
+        result = STUB_ERROR;
+    } else if (c->stub_plain_call) {
+        code->main->code_size = *offset;
+        result = STUB_PLAIN_CALL;
+    }
+
+    c->code = saved_code;
+    c->current = saved_current;
+    c->stub_operands = NULL;
+    c->stub_operand_count = 0;
+    c->stub_root = NULL;
+    c->stub_plain_call = false;
+    return result;
+}
+
 const char *compiler_error(Compiler *c) {
     return c->error;
 }
@@ -13,6 +13,12 @@
 
 typedef struct Compiler Compiler;
 
+typedef enum StubResult {
+    STUB_OK,            /* Stub appended at *offset */
+    STUB_PLAIN_CALL,    /* Expression is a call to a user function; nothing emitted */
+    STUB_ERROR,
+} StubResult;
+
 Compiler *compiler_new(void);
 void compiler_free(Compiler *compiler);
 void compiler_set_source_path(Compiler *compiler, const char *path);
@@ -20,4 +26,17 @@ Bytecode *compiler_compile(Compiler *compiler, AstNode *ast);
 const char *compiler_error(Compiler *compiler);
 int compiler_error_line(Compiler *compiler);
 
+/* Record tool metadata for a @tool function compiled at fn_index */
+void compiler_add_tool(Bytecode *code, AstNode *tool_decl, size_t fn_index);
+
+/*
+ * Compile one expression into a stand-alone stack fragment appended to
+ * code->main, for backends that delegate operations they lack to the
+ * stack VM. Each node in operands is taken as already evaluated: it reads
+ * local slot i, and push()/pop() write their array back to that slot.
+ * The fragment halts with the expression value on top of the stack.
+ */
+StubResult compiler_compile_stub(Compiler *compiler, Bytecode *code, AstNode *expr,
+                                 AstNode **operands, size_t count, size_t *offset);
+
 #endif /* AGIM_LANG_COMPILER_H */
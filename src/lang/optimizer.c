@@ -0,0 +1,402 @@
+/*
+ * Agim - AST Optimizer
+ *
+ * Copyright (c) 2025 Agim Language Contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "lang/optimizer.h"
+#include "util/alloc.h"
+
+#include <string.h>
+
+/*
+ * Folding must give the same value the VM would compute. The VM keeps
+ * 48-bit integers and wraps anything wider, so only literals and results
+ * inside that range are folded; everything else is left for runtime,
+ * as are operations that fail there (division by zero, `%` on floats).
+ */
+#define FOLD_INT_MIN (-((int64_t)1 << 47))
+#define FOLD_INT_MAX (((int64_t)1 << 47) - 1)
+
+static bool fold_int_in_range(int64_t value) {
+    return value >= FOLD_INT_MIN && value <= FOLD_INT_MAX;
+}
+
+bool ast_literal_truthy(const AstNode *node, bool *truthy) {
+    if (!node) return false;
+
+    switch (node->type) {
+    case NODE_NIL:
+        *truthy = false;
+        return true;
+    case NODE_BOOL:
+        *truthy = node->as.bool_val;
+        return true;
+    case NODE_INT:
+        if (!fold_int_in_range(node->as.int_val)) return false;
+        *truthy = node->as.int_val != 0;
+        return true;
+    case NODE_FLOAT:
+        *truthy = node->as.float_val != 0.0;
+        return true;
+    case NODE_STRING:
+        *truthy = true;
+        return true;
+    default:
+        return false;
+    }
+}
+
+static bool is_number(const AstNode *node) {
+    if (node->type == NODE_FLOAT) return true;
+    return node->type == NODE_INT && fold_int_in_range(node->as.int_val);
+}
+
+static double number_value(const AstNode *node) {
+    return node->type == NODE_INT ? (double)node->as.int_val : node->as.float_val;
+}
+
+static AstNode *fold_ints(TokenType op, int64_t a, int64_t b, int line) {
+    int64_t result;
+
+    switch (op) {
+    case TOK_PLUS: result = a + b; break;
+    case TOK_MINUS: result = a - b; break;
+    case TOK_STAR:
+        if (__builtin_mul_overflow(a, b, &result)) return NULL;
+        break;
+    case TOK_SLASH:
+        if (b == 0) return NULL;
+        result = a / b;
+        break;
+    case TOK_PERCENT:
+        if (b == 0) return NULL;
+        result = a % b;
+        break;
+    case TOK_EQ: return ast_bool(a == b, line);
+    case TOK_NE: return ast_bool(a != b, line);
+    case TOK_LT: return ast_bool(a < b, line);
+    case TOK_LE: return ast_bool(a <= b, line);
+    case TOK_GT: return ast_bool(a > b, line);
+    case TOK_GE: return ast_bool(a >= b, line);
+    default: return NULL;
+    }
+
+    if (!fold_int_in_range(result)) return NULL;
+    return ast_int(result, line);
+}
+
+static AstNode *fold_floats(TokenType op, double a, double b, int line) {
+    switch (op) {
+    case TOK_PLUS: return ast_float(a + b, line);
+    case TOK_MINUS: return ast_float(a - b, line);
+    case TOK_STAR: return ast_float(a * b, line);
+    case TOK_SLASH:
+        if (b == 0.0) return NULL;
+        return ast_float(a / b, line);
+    case TOK_LT: return ast_bool(a < b, line);
+    case TOK_LE: return ast_bool(a <= b, line);
+    case TOK_GT: return ast_bool(a > b, line);
+    case TOK_GE: return ast_bool(a >= b, line);
+    default: return NULL;
+    }
+}
+
+static AstNode *fold_strings(TokenType op, const char *a, const char *b, int line) {
+    switch (op) {
+    case TOK_PLUS: {
+        /* Literal text is already unescaped, so build the node directly */
+        size_t len_a = strlen(a);
+        size_t len_b = strlen(b);
+        AstNode *node = ast_new(NODE_STRING, line);
+        node->as.string_val = agim_alloc(len_a + len_b + 1);
+        memcpy(node->as.string_val, a, len_a);
+        memcpy(node->as.string_val + len_a, b, len_b + 1);
+        return node;
+    }
+    case TOK_EQ: return ast_bool(strcmp(a, b) == 0, line);
+    case TOK_NE: return ast_bool(strcmp(a, b) != 0, line);
+    default: return NULL;
+    }
+}
+
+/* Detach a child so freeing its parent leaves it alive */
+static AstNode *take(AstNode **child) {
+    AstNode *node = *child;
+    *child = NULL;
+    return node;
+}
+
+/* Replacement for a binary node with constant operands, or NULL */
+static AstNode *fold_binary(AstNode *node) {
+    TokenType op = node->as.binary.op;
+    AstNode *left = node->as.binary.left;
+    AstNode *right = node->as.binary.right;
+    bool truthy;
+
+    /* and/or with a literal left side: the jump always goes one way */
+    if (op == TOK_AND || op == TOK_OR) {
+        if (!ast_literal_truthy(left, &truthy)) return NULL;
+        bool keep_left = (op == TOK_AND) ? !truthy : truthy;
+        return take(keep_left ? &node->as.binary.left : &node->as.binary.right);
+    }
+
+    if (left->type == NODE_INT && right->type == NODE_INT) {
+        if (!is_number(left) || !is_number(right)) return NULL;
+        return fold_ints(op, left->as.int_val, right->as.int_val, node->line);
+    }
+
+    if (is_number(left) && is_number(right)) {
+        return fold_floats(op, number_value(left), number_value(right), node->line);
+    }
+
+    if (left->type == NODE_STRING && right->type == NODE_STRING) {
+        return fold_strings(op, left->as.string_val, right->as.string_val, node->line);
+    }
+
+    if ((op == TOK_EQ || op == TOK_NE) && left->type == right->type) {
+        bool equal;
+        if (left->type == NODE_BOOL) {
+            equal = left->as.bool_val == right->as.bool_val;
+        } else if (left->type == NODE_NIL) {
+            equal = true;
+        } else {
+            return NULL;
+        }
+        return ast_bool(op == TOK_EQ ? equal : !equal, node->line);
+    }
+
+    return NULL;
+}
+
+static AstNode *fold_unary(AstNode *node) {
+    AstNode *operand = node->as.unary.operand;
+    bool truthy;
+
+    switch (node->as.unary.op) {
+    case TOK_MINUS:
+        if (operand->type == NODE_INT && fold_int_in_range(operand->as.int_val) &&
+            fold_int_in_range(-operand->as.int_val)) {
+            return ast_int(-operand->as.int_val, node->line);
+        }
+        if (operand->type == NODE_FLOAT) {
+            return ast_float(-operand->as.float_val, node->line);
+        }
+        return NULL;
+    case TOK_NOT:
+        if (!ast_literal_truthy(operand, &truthy)) return NULL;
+        return ast_bool(!truthy, node->line);
+    default:
+        return NULL;
+    }
+}
+
+static AstNode *fold_ternary(AstNode *node) {
+    bool truthy;
+    if (!ast_literal_truthy(node->as.ternary.cond, &truthy)) return NULL;
+    return take(truthy ? &node->as.ternary.then_expr : &node->as.ternary.else_expr);
+}
+
+static void optimize(AstNode **slot);
+
+static void optimize_list(AstNode **nodes, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        optimize(&nodes[i]);
+    }
+}
+
+/* A statement that never lets control reach the next one */
+static bool ends_flow(const AstNode *stmt) {
+    return stmt->type == NODE_RETURN || stmt->type == NODE_BREAK ||
+           stmt->type == NODE_CONTINUE;
+}
+
+/* A statement whose body never runs, so it has no effect */
+static bool is_dead(const AstNode *stmt) {
+    bool truthy;
+    switch (stmt->type) {
+    case NODE_WHILE:
+        return ast_literal_truthy(stmt->as.while_stmt.cond, &truthy) && !truthy;
+    case NODE_IF:
+        return !stmt->as.if_stmt.else_block &&
+               ast_literal_truthy(stmt->as.if_stmt.cond, &truthy) && !truthy;
+    default:
+        return false;
+    }
+}
+
+/*
+ * Optimize a statement list, then drop statements that never run:
+ * those after a return/break/continue (in blocks) and dead loops and
+ * ifs. The last statement is always kept, since it decides the value
+ * of the block or program.
+ */
+static void optimize_stmts(AstNode **stmts, size_t *count, bool prune_tail) {
+    size_t kept = 0;
+
+    for (size_t i = 0; i < *count; i++) {
+        AstNode *stmt = stmts[i];
+        if (kept > 0 && prune_tail && ends_flow(stmts[kept - 1])) {
+            ast_free(stmt);
+            continue;
+        }
+
+        optimize(&stmt);
+        if (i + 1 < *count && is_dead(stmt)) {
+            ast_free(stmt);
+            continue;
+        }
+        stmts[kept++] = stmt;
+    }
+    *count = kept;
+}
+
+static void optimize(AstNode **slot) {
+    AstNode *node = *slot;
+    if (!node) return;
+
+    AstNode *folded = NULL;
+
+    switch (node->type) {
+    case NODE_PROGRAM:
+        optimize_stmts(node->as.program.decls, &node->as.program.count, false);
+        break;
+
+    case NODE_TOOL_DECL:
+    case NODE_FN_DECL:
+        optimize(&node->as.fn_decl.body);
+        break;
+
+    case NODE_EXPORT:
+        optimize(&node->as.export_stmt.decl);
+        break;
+
+    case NODE_BLOCK:
+        optimize_stmts(node->as.block.stmts, &node->as.block.count, true);
+        break;
+
+    case NODE_LET:
+    case NODE_CONST:
+        optimize(&node->as.var_decl.value);
+        break;
+
+    case NODE_IF:
+        optimize(&node->as.if_stmt.cond);
+        optimize(&node->as.if_stmt.then_block);
+        optimize(&node->as.if_stmt.else_block);
+        break;
+
+    case NODE_FOR:
+        optimize(&node->as.for_stmt.iterable);
+        optimize(&node->as.for_stmt.body);
+        break;
+
+    case NODE_WHILE:
+        optimize(&node->as.while_stmt.cond);
+        optimize(&node->as.while_stmt.body);
+        break;
+
+    case NODE_RETURN:
+    case NODE_EXPR_STMT:
+        optimize(&node->as.return_stmt.value);
+        break;
+
+    case NODE_BINARY:
+        optimize(&node->as.binary.left);
+        optimize(&node->as.binary.right);
+        folded = fold_binary(node);
+        break;
+
+    case NODE_UNARY:
+        optimize(&node->as.unary.operand);
+        folded = fold_unary(node);
+        break;
+
+    case NODE_CALL:
+        optimize(&node->as.call.callee);
+        optimize_list(node->as.call.args, node->as.call.arg_count);
+        break;
+
+    case NODE_MEMBER:
+        optimize(&node->as.member.object);
+        break;
+
+    case NODE_INDEX:
+        optimize(&node->as.index_expr.object);
+        optimize(&node->as.index_expr.index);
+        break;
+
+    case NODE_TERNARY:
+        optimize(&node->as.ternary.cond);
+        optimize(&node->as.ternary.then_expr);
+        optimize(&node->as.ternary.else_expr);
+        folded = fold_ternary(node);
+        break;
+
+    case NODE_ASSIGN:
+        optimize(&node->as.assign.target);
+        optimize(&node->as.assign.value);
+        break;
+
+    case NODE_ARRAY:
+        optimize_list(node->as.array.elements, node->as.array.count);
+        break;
+
+    case NODE_MAP:
+        optimize_list(node->as.map.values, node->as.map.count);
+        break;
+
+    case NODE_MATCH:
+        optimize(&node->as.match_expr.expr);
+        optimize_list(node->as.match_expr.arms, node->as.match_expr.arm_count);
+        break;
+
+    case NODE_MATCH_ARM:
+        optimize(&node->as.match_arm.body);
+        break;
+
+    case NODE_RESULT_OK:
+    case NODE_RESULT_ERR:
+        optimize(&node->as.result_expr.value);
+        break;
+
+    case NODE_TRY:
+        optimize(&node->as.try_expr.expr);
+        break;
+
+    case NODE_SOME:
+        optimize(&node->as.some_expr.value);
+        break;
+
+    case NODE_STRUCT_INIT:
+        optimize_list(node->as.struct_init.field_values, node->as.struct_init.field_count);
+        optimize(&node->as.struct_init.spread);
+        break;
+
+    case NODE_SPREAD:
+        optimize(&node->as.spread_expr.expr);
+        break;
+
+    case NODE_ENUM_EXPR:
+        optimize(&node->as.enum_expr.payload);
+        break;
+
+    case NODE_RANGE:
+        optimize(&node->as.range.start);
+        optimize(&node->as.range.end);
+        break;
+
+    default:
+        break;
+    }
+
+    if (folded) {
+        *slot = folded;
+        ast_free(node);
+    }
+}
+
+void ast_optimize(AstNode *program) {
+    optimize(&program);
+}
@@ -0,0 +1,23 @@
+/*
+ * Agim - AST Optimizer
+ *
+ * Constant folding and dead-code elimination, run over the parsed
+ * program before either compiler generates code.
+ *
+ * Copyright (c) 2025 Agim Language Contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+#ifndef AGIM_LANG_OPTIMIZER_H
+#define AGIM_LANG_OPTIMIZER_H
+
+#include "lang/ast.h"
+#include <stdbool.h>
+
+/* Fold constant expressions and drop unreachable code, in place */
+void ast_optimize(AstNode *program);
+
+/* Runtime truthiness of a literal; returns false if node is not one */
+bool ast_literal_truthy(const AstNode *node, bool *truthy);
+
+#endif /* AGIM_LANG_OPTIMIZER_H */
@@ -1,8 +1,10 @@
 /*
  * Agim - Register Allocator
  *
- * Simple linear-scan register allocator for the register-based VM.
- * Maps local variables to virtual registers (0-255).
+ * Stack-discipline register allocator for the register-based VM.
+ * Locals and temporaries are taken from the top of the frame window and
+ * released in LIFO order, so a call's callee and arguments always sit
+ * in consecutive registers above every live value.
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -21,31 +23,21 @@
 /* Register Allocator */
 
 typedef struct RegAlloc {
-    uint8_t next_reg;
-    uint8_t max_used;
-    uint8_t local_to_reg[REG_MAX];
-    int local_count;
-    uint8_t temp_base;
-    uint8_t temp_count;
-    uint8_t result_reg;
+    uint16_t top;       /* Next free register */
+    uint16_t max_used;  /* High-water mark, registers ever in use */
 } RegAlloc;
 
 /* Register Allocator API */
 
 void regalloc_init(RegAlloc *ra);
-void regalloc_reset(RegAlloc *ra);
-uint8_t regalloc_local(RegAlloc *ra, int local_slot);
-uint8_t regalloc_get_local(RegAlloc *ra, int local_slot);
-uint8_t regalloc_temp(RegAlloc *ra);
-void regalloc_free_temp(RegAlloc *ra, uint8_t reg);
-void regalloc_free_all_temps(RegAlloc *ra);
-uint8_t regalloc_count(const RegAlloc *ra);
-bool regalloc_is_temp(const RegAlloc *ra, uint8_t reg);
 
-/* Expression Result Tracking */
+/* Take the next register, REG_NONE when the window is full */
+uint8_t regalloc_push(RegAlloc *ra);
+
+/* Release every register at or above mark */
+void regalloc_release(RegAlloc *ra, uint8_t mark);
 
-void regalloc_set_result(RegAlloc *ra, uint8_t reg);
-uint8_t regalloc_get_result(const RegAlloc *ra);
-uint8_t regalloc_new_result(RegAlloc *ra);
+uint8_t regalloc_top(const RegAlloc *ra);
+uint8_t regalloc_count(const RegAlloc *ra);
 
 #endif /* AGIM_LANG_REGALLOC_H */
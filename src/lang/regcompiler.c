@@ -1,12 +1,21 @@
 /*
  * Agim - Register Bytecode Compiler Implementation
  *
+ * Locals and temporaries live in registers handed out by a stack
+ * allocator (see regalloc.h). Arithmetic, control flow, calls, globals
+ * and containers compile to register instructions; everything else
+ * (builtins, Result/Option, structs, enums, messaging) is compiled by
+ * the stack compiler into a stub that ROP_STACK runs on the stack VM.
+ *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
  */
 
 #include "lang/regcompiler.h"
 #include "lang/regalloc.h"
+#include "lang/compiler.h"
+#include "lang/module.h"
+#include "lang/optimizer.h"
 #include "lang/ast.h"
 #include "vm/value.h"
 #include "util/alloc.h"
@@ -24,6 +33,17 @@ typedef struct {
     uint8_t reg;  /* Register holding this local */
 } RegLocal;
 
+typedef struct {
+    size_t *jumps;
+    size_t count;
+    size_t capacity;
+} JumpList;
+
+typedef struct {
+    JumpList breaks;
+    JumpList continues;
+} RegLoop;
+
 typedef struct RegFuncContext {
     RegChunk *chunk;
     RegAlloc alloc;
@@ -32,36 +52,69 @@ typedef struct RegFuncContext {
     int local_count;
     int scope_depth;
 
+    RegLoop loops[32];
+    int loop_depth;
+
+    bool is_function;  /* Tail calls are only emitted inside functions */
+
     struct RegFuncContext *enclosing;
 } RegFuncContext;
 
+/* Single-opcode stub cached by opcode and string operand */
+typedef struct {
+    Opcode op;
+    const char *operand;
+    size_t offset;
+} RegFragment;
+
 typedef struct RegCompiler {
     RegFuncContext *current;
-    RegChunk *chunk;  /* Main chunk */
+    RegChunk *program;      /* Main chunk, owns functions and stubs */
+
+    Compiler *stack;        /* Compiles stubs into program->stubs */
+    ModuleCache *modules;
+    const char *source_path;
+
+    RegFragment *fragments;
+    size_t fragment_count;
+    size_t fragment_capacity;
 
-    const char *error;
-    int error_line;
     bool had_error;
 } RegCompiler;
 
 static RegCompiler *compiler = NULL;
 
+/* Kept past the compile so callers can report it */
+static char error_message[256];
+static int error_line = 0;
+
 /* Error Handling */
 
 static void compile_error(int line, const char *msg) {
     if (!compiler || compiler->had_error) return;
     compiler->had_error = true;
-    compiler->error = msg;
-    compiler->error_line = line;
+    snprintf(error_message, sizeof(error_message), "line %d: %s", line, msg);
+    error_line = line;
     LOG_ERROR("regcompiler: line %d: %s", line, msg);
 }
 
+/* Adopt the stack compiler's error after a failed stub */
+static void stub_error(int line) {
+    if (compiler->had_error) return;
+    compiler->had_error = true;
+    const char *msg = compiler_error(compiler->stack);
+    snprintf(error_message, sizeof(error_message), "%s",
+             msg ? msg : "failed to compile stub");
+    error_line = compiler_error_line(compiler->stack);
+    if (error_line == 0) error_line = line;
+}
+
 const char *regcompile_error(void) {
-    return compiler ? compiler->error : NULL;
+    return error_message[0] ? error_message : NULL;
 }
 
 int regcompile_error_line(void) {
-    return compiler ? compiler->error_line : 0;
+    return error_line;
 }
 
 /* Code Generation Helpers */
@@ -89,17 +142,52 @@ static void emit_imm(RegOp op, uint8_t rd, uint16_t imm, int line) {
 static size_t emit_jump(RegOp op, uint8_t cond, int line) {
     /* Emit placeholder jump, returns offset to patch */
     size_t offset = current_chunk()->code_size;
-    emit(reg_instr_cond_jump(op, cond, 0), line);
+    if (op == ROP_JMP) {
+        emit(reg_instr_jump(ROP_JMP, 0), line);
+    } else {
+        emit(reg_instr_cond_jump(op, cond, 0), line);
+    }
     return offset;
 }
 
 static void patch_jump(size_t offset) {
     RegChunk *chunk = current_chunk();
-    int16_t jump = (int16_t)(chunk->code_size - offset - 1);
+    RegInstr *instr = &chunk->code[offset];
+    int32_t jump = (int32_t)(chunk->code_size - offset - 1);
 
-    /* Update the jump offset in rs1/rs2 */
-    chunk->code[offset].rs1 = (jump >> 8) & 0xFF;
-    chunk->code[offset].rs2 = jump & 0xFF;
+    if (instr->op == ROP_JMP) {
+        if (jump > 0x7FFFFF) {
+            compile_error(chunk->lines[offset], "jump too large");
+            return;
+        }
+        *instr = reg_instr_jump(ROP_JMP, jump);
+    } else {
+        if (jump > INT16_MAX) {
+            compile_error(chunk->lines[offset], "jump too large");
+            return;
+        }
+        *instr = reg_instr_cond_jump((RegOp)instr->op, instr->rd, (int16_t)jump);
+    }
+}
+
+/* Backward jump to target; far conditional jumps go through a JMP */
+static void emit_jump_to(RegOp op, uint8_t cond, size_t target, int line) {
+    int32_t offset = (int32_t)target - (int32_t)(current_chunk()->code_size + 1);
+
+    if (op != ROP_JMP && offset >= INT16_MIN) {
+        emit(reg_instr_cond_jump(op, cond, (int16_t)offset), line);
+        return;
+    }
+    if (op != ROP_JMP) {
+        RegOp inverse = op == ROP_JMP_IF ? ROP_JMP_UNLESS : ROP_JMP_IF;
+        emit(reg_instr_cond_jump(inverse, cond, 1), line);
+        offset--;
+    }
+    if (offset < -0x800000) {
+        compile_error(line, "loop body too large");
+        return;
+    }
+    emit(reg_instr_jump(ROP_JMP, offset), line);
 }
 
 static size_t add_constant(Value *value, int line) {
@@ -111,650 +199,1395 @@ static size_t add_constant(Value *value, int line) {
     return idx;
 }
 
+/* Names and keys are looked up often; reuse an existing constant */
+static uint16_t string_constant(const char *str, int line) {
+    RegChunk *chunk = current_chunk();
+    for (size_t i = 0; i < chunk->constants_size && i <= 0xFFFF; i++) {
+        Value *k = chunk->constants[i];
+        if (k && value_is_string(k) && strcmp(k->as.string->data, str) == 0) {
+            return (uint16_t)i;
+        }
+    }
+    return (uint16_t)add_constant(value_string(str), line);
+}
+
+static void emit_load_int(uint8_t rd, int64_t val, int line) {
+    if (val >= INT16_MIN && val <= INT16_MAX) {
+        emit_imm(ROP_LOAD_INT, rd, (uint16_t)(int16_t)val, line);
+    } else {
+        emit_imm(ROP_LOAD_K, rd, (uint16_t)add_constant(value_int(val), line), line);
+    }
+}
+
+/* Register Management */
+
+static uint8_t push_reg(int line) {
+    uint8_t reg = regalloc_push(current_alloc());
+    if (reg == REG_NONE) {
+        compile_error(line, "expression needs too many registers");
+        return 0;
+    }
+    return reg;
+}
+
+static uint8_t reg_mark(void) {
+    return regalloc_top(current_alloc());
+}
+
+static void reg_release(uint8_t mark) {
+    regalloc_release(current_alloc(), mark);
+}
+
 /* Scope Management */
 
 static void begin_scope(void) {
     compiler->current->scope_depth++;
 }
 
-static void end_scope(int line) {
-    (void)line;
-    compiler->current->scope_depth--;
+static void end_scope(void) {
+    RegFuncContext *ctx = compiler->current;
+    ctx->scope_depth--;
 
-    /* Remove locals going out of scope */
-    while (compiler->current->local_count > 0 &&
-           compiler->current->locals[compiler->current->local_count - 1].depth >
-               compiler->current->scope_depth) {
-        RegLocal *local = &compiler->current->locals[compiler->current->local_count - 1];
+    /* Remove locals going out of scope, freeing their registers */
+    uint8_t lowest = REG_NONE;
+    while (ctx->local_count > 0 &&
+           ctx->locals[ctx->local_count - 1].depth > ctx->scope_depth) {
+        RegLocal *local = &ctx->locals[ctx->local_count - 1];
+        if (local->reg < lowest) lowest = local->reg;
         agim_free(local->name);
-        compiler->current->local_count--;
+        ctx->local_count--;
+    }
+    if (lowest != REG_NONE) {
+        reg_release(lowest);
     }
 }
 
-static int add_local(const char *name, size_t length, bool is_const, int line) {
-    if (compiler->current->local_count >= 256) {
+static void add_local(const char *name, bool is_const, uint8_t reg, int line) {
+    RegFuncContext *ctx = compiler->current;
+    if (ctx->local_count >= 256) {
         compile_error(line, "too many local variables");
-        return -1;
+        return;
     }
 
-    RegLocal *local = &compiler->current->locals[compiler->current->local_count];
-    local->name = agim_alloc(length + 1);
-    memcpy(local->name, name, length);
-    local->name[length] = '\0';
-    local->depth = compiler->current->scope_depth;
-    local->is_const = is_const;
-    local->reg = regalloc_local(current_alloc(), compiler->current->local_count);
+    for (int i = ctx->local_count - 1; i >= 0; i--) {
+        RegLocal *local = &ctx->locals[i];
+        if (local->depth < ctx->scope_depth) break;
+        if (strcmp(local->name, name) == 0) {
+            compile_error(line, "variable already declared in this scope");
+            return;
+        }
+    }
 
-    return compiler->current->local_count++;
+    RegLocal *local = &ctx->locals[ctx->local_count++];
+    local->name = agim_strdup(name);
+    local->depth = ctx->scope_depth;
+    local->is_const = is_const;
+    local->reg = reg;
 }
 
-static int resolve_local(const char *name, size_t length) {
+static int resolve_local(const char *name) {
     for (int i = compiler->current->local_count - 1; i >= 0; i--) {
-        RegLocal *local = &compiler->current->locals[i];
-        if (strlen(local->name) == length &&
-            memcmp(local->name, name, length) == 0) {
+        if (strcmp(compiler->current->locals[i].name, name) == 0) {
             return i;
         }
     }
     return -1;
 }
 
+/* Register of a local variable node, or REG_NONE */
+static uint8_t local_reg(AstNode *node) {
+    if (node->type != NODE_IDENT) return REG_NONE;
+    int slot = resolve_local(node->as.ident.name);
+    return slot >= 0 ? compiler->current->locals[slot].reg : REG_NONE;
+}
+
+/* Loop Management */
+
+static void jump_list_add(JumpList *list, size_t offset) {
+    if (list->count >= list->capacity) {
+        list->capacity = list->capacity == 0 ? 8 : list->capacity * 2;
+        list->jumps = agim_realloc(list->jumps, sizeof(size_t) * list->capacity);
+    }
+    list->jumps[list->count++] = offset;
+}
+
+/* Patch every jump in list to the current position */
+static void jump_list_patch(JumpList *list) {
+    for (size_t i = 0; i < list->count; i++) {
+        patch_jump(list->jumps[i]);
+    }
+    list->count = 0;
+}
+
+static void begin_loop(int line) {
+    RegFuncContext *ctx = compiler->current;
+    if (ctx->loop_depth >= 32) {
+        compile_error(line, "too many nested loops");
+        return;
+    }
+    memset(&ctx->loops[ctx->loop_depth++], 0, sizeof(RegLoop));
+}
+
+static RegLoop *current_loop(void) {
+    RegFuncContext *ctx = compiler->current;
+    return ctx->loop_depth > 0 ? &ctx->loops[ctx->loop_depth - 1] : NULL;
+}
+
+static void end_loop(void) {
+    RegLoop *loop = current_loop();
+    if (!loop) return;
+
+    jump_list_patch(&loop->breaks);
+    agim_free(loop->breaks.jumps);
+    agim_free(loop->continues.jumps);
+    compiler->current->loop_depth--;
+}
+
 /* Forward Declarations */
 
-static void compile_node(AstNode *node);
 static uint8_t compile_expr(AstNode *node);
+static void compile_expr_to(AstNode *node, uint8_t dst);
+static void compile_discard(AstNode *node);
 static void compile_stmt(AstNode *node);
+static void compile_decl(AstNode *node);
+static void compile_block(AstNode *node);
+static void compile_return(AstNode *node);
 
-/* Expression Compilation */
+/* Stack Stubs */
 
-static uint8_t compile_nil(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    emit_op(ROP_LOAD_NIL, rd, 0, 0, node->line);
-    return rd;
+/*
+ * Compile expr as a stack stub whose operands are evaluated into
+ * consecutive registers starting at *base. Nothing is emitted when the
+ * expression turns out to be a plain user call.
+ */
+static StubResult compile_stub(AstNode *expr, AstNode **operands, size_t count,
+                               uint8_t dst, uint8_t *base) {
+    size_t offset = 0;
+    StubResult result = compiler_compile_stub(compiler->stack, compiler->program->stubs,
+                                              expr, operands, count, &offset);
+    if (result == STUB_ERROR) {
+        stub_error(expr->line);
+        return result;
+    }
+    if (result == STUB_PLAIN_CALL) {
+        return result;
+    }
+    if (offset > UINT32_MAX) {
+        compile_error(expr->line, "too much stub code");
+        return STUB_ERROR;
+    }
+
+    if (dst == REG_NONE) {
+        dst = push_reg(expr->line);
+    }
+
+    /* A lone local is passed in place; it is only rewritten by pop() */
+    *base = count == 1 ? local_reg(operands[0]) : REG_NONE;
+    if (*base == REG_NONE) {
+        *base = reg_mark();
+        for (size_t i = 0; i < count; i++) {
+            compile_expr_to(operands[i], push_reg(expr->line));
+        }
+    }
+
+    emit_op(ROP_STACK, dst, *base, (uint8_t)count, expr->line);
+    emit((RegInstr){ .raw = (uint32_t)offset }, expr->line);
+    return STUB_OK;
 }
 
-static uint8_t compile_bool(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    emit_op(node->as.bool_val ? ROP_LOAD_TRUE : ROP_LOAD_FALSE,
-            rd, 0, 0, node->line);
-    return rd;
+static void compile_stub_expr(AstNode *expr, AstNode **operands, size_t count,
+                              uint8_t dst) {
+    uint8_t mark = reg_mark();
+    uint8_t base;
+    if (compile_stub(expr, operands, count, dst, &base) == STUB_PLAIN_CALL) {
+        compile_error(expr->line, "cannot compile expression");
+    }
+    reg_release(mark);
 }
 
-static uint8_t compile_int(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    int64_t val = node->as.int_val;
+/* Offset of GET_LOCAL 0; op [operand]; HALT in the stub code */
+static size_t fragment_offset(Opcode op, const char *operand, int line) {
+    for (size_t i = 0; i < compiler->fragment_count; i++) {
+        RegFragment *f = &compiler->fragments[i];
+        if (f->op == op && ((!f->operand && !operand) ||
+                            (f->operand && operand && strcmp(f->operand, operand) == 0))) {
+            return f->offset;
+        }
+    }
 
-    if (val >= -32768 && val <= 32767) {
-        emit_imm(ROP_LOAD_INT, rd, (uint16_t)(int16_t)val, node->line);
-    } else {
-        size_t idx = add_constant(value_int(val), node->line);
-        emit_imm(ROP_LOAD_K, rd, (uint16_t)idx, node->line);
+    Bytecode *stubs = compiler->program->stubs;
+    Chunk *chunk = stubs->main;
+    size_t offset = chunk->code_size;
+
+    chunk_write_opcode(chunk, OP_GET_LOCAL, line);
+    chunk_write_byte(chunk, 0, line);
+    chunk_write_byte(chunk, 0, line);
+    chunk_write_opcode(chunk, op, line);
+    if (operand) {
+        size_t idx = bytecode_add_string(stubs, operand);
+        chunk_write_byte(chunk, (idx >> 8) & 0xFF, line);
+        chunk_write_byte(chunk, idx & 0xFF, line);
     }
-    return rd;
-}
+    chunk_write_opcode(chunk, OP_HALT, line);
 
-static uint8_t compile_float(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    size_t idx = add_constant(value_float(node->as.float_val), node->line);
-    emit_imm(ROP_LOAD_K, rd, (uint16_t)idx, node->line);
-    return rd;
+    if (compiler->fragment_count >= compiler->fragment_capacity) {
+        compiler->fragment_capacity = compiler->fragment_capacity == 0
+                                          ? 8 : compiler->fragment_capacity * 2;
+        compiler->fragments = agim_realloc(compiler->fragments,
+                                           sizeof(RegFragment) * compiler->fragment_capacity);
+    }
+    compiler->fragments[compiler->fragment_count++] = (RegFragment){ op, operand, offset };
+    return offset;
 }
 
-static uint8_t compile_string(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    size_t idx = add_constant(value_string(node->as.string_val), node->line);
-    emit_imm(ROP_LOAD_K, rd, (uint16_t)idx, node->line);
-    return rd;
+/* dst = op(src), run as a one-operand stub */
+static void emit_fragment(Opcode op, const char *operand, uint8_t dst, uint8_t src, int line) {
+    size_t offset = fragment_offset(op, operand, line);
+    emit_op(ROP_STACK, dst, src, 1, line);
+    emit((RegInstr){ .raw = (uint32_t)offset }, line);
 }
 
-static uint8_t compile_identifier(AstNode *node) {
-    const char *name = node->as.ident.name;
-    size_t length = strlen(name);
+/* Expression Compilation */
 
-    int slot = resolve_local(name, length);
-    if (slot >= 0) {
-        /* Local variable - just return its register */
-        return compiler->current->locals[slot].reg;
+static RegOp binary_op(TokenType op) {
+    switch (op) {
+    case TOK_PLUS:    return ROP_ADD;
+    case TOK_MINUS:   return ROP_SUB;
+    case TOK_STAR:    return ROP_MUL;
+    case TOK_SLASH:   return ROP_DIV;
+    case TOK_PERCENT: return ROP_MOD;
+    case TOK_EQ:      return ROP_EQ;
+    case TOK_NE:      return ROP_NE;
+    case TOK_LT:      return ROP_LT;
+    case TOK_LE:      return ROP_LE;
+    case TOK_GT:      return ROP_GT;
+    case TOK_GE:      return ROP_GE;
+    default:          return ROP_COUNT;
     }
+}
 
-    /* Global variable - load from globals map */
-    uint8_t rd = regalloc_new_result(current_alloc());
-    size_t idx = add_constant(value_string(name), node->line);
-    emit_imm(ROP_GET_GLOBAL, rd, (uint16_t)idx, node->line);
-    return rd;
+static RegOp compound_op(TokenType op) {
+    switch (op) {
+    case TOK_PLUS_ASSIGN:  return ROP_ADD;
+    case TOK_MINUS_ASSIGN: return ROP_SUB;
+    case TOK_STAR_ASSIGN:  return ROP_MUL;
+    case TOK_SLASH_ASSIGN: return ROP_DIV;
+    default:               return ROP_COUNT;
+    }
 }
 
-static uint8_t compile_binary(AstNode *node) {
-    uint8_t left = compile_expr(node->as.binary.left);
-    uint8_t right = compile_expr(node->as.binary.right);
-    uint8_t rd = regalloc_new_result(current_alloc());
-
-    RegOp op;
-    switch (node->as.binary.op) {
-    case TOK_PLUS:    op = ROP_ADD; break;
-    case TOK_MINUS:   op = ROP_SUB; break;
-    case TOK_STAR:    op = ROP_MUL; break;
-    case TOK_SLASH:   op = ROP_DIV; break;
-    case TOK_PERCENT: op = ROP_MOD; break;
-    case TOK_EQ:      op = ROP_EQ; break;
-    case TOK_NE:      op = ROP_NE; break;
-    case TOK_LT:      op = ROP_LT; break;
-    case TOK_LE:      op = ROP_LE; break;
-    case TOK_GT:      op = ROP_GT; break;
-    case TOK_GE:      op = ROP_GE; break;
-    case TOK_AND:     op = ROP_AND; break;
-    case TOK_OR:      op = ROP_OR; break;
+/*
+ * Expressions that write their destination before they are done reading
+ * their operands; assigning one to a local goes through a temporary.
+ */
+static bool writes_early(AstNode *node) {
+    switch (node->type) {
+    case NODE_ARRAY:
+    case NODE_MAP:
+    case NODE_TERNARY:
+    case NODE_IF:
+    case NODE_MATCH:
+        return true;
+    case NODE_BINARY:
+        return node->as.binary.op == TOK_AND || node->as.binary.op == TOK_OR;
     default:
-        compile_error(node->line, "unknown binary operator");
-        return rd;
+        return false;
     }
+}
 
-    emit_op(op, rd, left, right, node->line);
+static void compile_ident(AstNode *node, uint8_t dst) {
+    uint8_t reg = local_reg(node);
+    if (reg != REG_NONE) {
+        if (reg != dst) {
+            emit_op(ROP_MOV, dst, reg, 0, node->line);
+        }
+        return;
+    }
+
+    emit_imm(ROP_GET_GLOBAL, dst, string_constant(node->as.ident.name, node->line),
+             node->line);
+}
 
-    /* Free temps if they were temporaries */
-    if (regalloc_is_temp(current_alloc(), right)) {
-        regalloc_free_temp(current_alloc(), right);
+static void compile_binary(AstNode *node, uint8_t dst) {
+    TokenType op = node->as.binary.op;
+
+    /* Short-circuit for and/or: the deciding operand is the result */
+    if (op == TOK_AND || op == TOK_OR) {
+        compile_expr_to(node->as.binary.left, dst);
+        size_t end_jump = emit_jump(op == TOK_AND ? ROP_JMP_UNLESS : ROP_JMP_IF,
+                                    dst, node->line);
+        compile_expr_to(node->as.binary.right, dst);
+        patch_jump(end_jump);
+        return;
     }
-    if (regalloc_is_temp(current_alloc(), left)) {
-        regalloc_free_temp(current_alloc(), left);
+
+    RegOp rop = binary_op(op);
+    if (rop == ROP_COUNT) {
+        compile_error(node->line, "unknown binary operator");
+        return;
     }
 
-    return rd;
+    uint8_t mark = reg_mark();
+    uint8_t left = compile_expr(node->as.binary.left);
+    uint8_t right = compile_expr(node->as.binary.right);
+    emit_op(rop, dst, left, right, node->line);
+    reg_release(mark);
 }
 
-static uint8_t compile_unary(AstNode *node) {
+static void compile_unary(AstNode *node, uint8_t dst) {
+    uint8_t mark = reg_mark();
     uint8_t operand = compile_expr(node->as.unary.operand);
-    uint8_t rd = regalloc_new_result(current_alloc());
 
     switch (node->as.unary.op) {
-    case TOK_MINUS:
-        emit_op(ROP_NEG, rd, operand, 0, node->line);
-        break;
-    case TOK_NOT:
-        emit_op(ROP_NOT, rd, operand, 0, node->line);
-        break;
+    case TOK_MINUS: emit_op(ROP_NEG, dst, operand, 0, node->line); break;
+    case TOK_NOT: emit_op(ROP_NOT, dst, operand, 0, node->line); break;
     default:
         compile_error(node->line, "unknown unary operator");
+        break;
     }
-
-    if (regalloc_is_temp(current_alloc(), operand)) {
-        regalloc_free_temp(current_alloc(), operand);
-    }
-
-    return rd;
+    reg_release(mark);
 }
 
-static uint8_t compile_array(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    emit_op(ROP_ARRAY_NEW, rd, 0, 0, node->line);
+static void compile_array(AstNode *node, uint8_t dst) {
+    emit_op(ROP_ARRAY_NEW, dst, 0, 0, node->line);
 
     for (size_t i = 0; i < node->as.array.count; i++) {
+        uint8_t mark = reg_mark();
         uint8_t elem = compile_expr(node->as.array.elements[i]);
-        emit_op(ROP_ARRAY_PUSH, rd, elem, 0, node->line);
-        if (regalloc_is_temp(current_alloc(), elem)) {
-            regalloc_free_temp(current_alloc(), elem);
-        }
+        emit_op(ROP_ARRAY_PUSH, dst, elem, 0, node->line);
+        reg_release(mark);
     }
-
-    return rd;
 }
 
-static uint8_t compile_map(AstNode *node) {
-    uint8_t rd = regalloc_new_result(current_alloc());
-    emit_op(ROP_MAP_NEW, rd, 0, 0, node->line);
+static void compile_map(AstNode *node, uint8_t dst) {
+    emit_op(ROP_MAP_NEW, dst, 0, 0, node->line);
 
     for (size_t i = 0; i < node->as.map.count; i++) {
-        /* Keys are strings in the AST */
-        size_t key_idx = add_constant(value_string(node->as.map.keys[i]), node->line);
-        uint8_t key = regalloc_temp(current_alloc());
-        emit_imm(ROP_LOAD_K, key, (uint16_t)key_idx, node->line);
-
+        uint8_t mark = reg_mark();
+        uint8_t key = push_reg(node->line);
+        emit_imm(ROP_LOAD_K, key, string_constant(node->as.map.keys[i], node->line),
+                 node->line);
         uint8_t val = compile_expr(node->as.map.values[i]);
-        emit_op(ROP_MAP_SET, val, rd, key, node->line);
-
-        if (regalloc_is_temp(current_alloc(), val)) {
-            regalloc_free_temp(current_alloc(), val);
-        }
-        regalloc_free_temp(current_alloc(), key);
+        emit_op(ROP_MAP_SET, val, dst, key, node->line);
+        reg_release(mark);
     }
-
-    return rd;
 }
 
-static uint8_t compile_index(AstNode *node) {
+static void compile_index(AstNode *node, uint8_t dst) {
+    uint8_t mark = reg_mark();
     uint8_t obj = compile_expr(node->as.index_expr.object);
     uint8_t idx = compile_expr(node->as.index_expr.index);
-    uint8_t rd = regalloc_new_result(current_alloc());
+    emit_op(ROP_ARRAY_GET, dst, obj, idx, node->line);
+    reg_release(mark);
+}
+
+static void compile_member(AstNode *node, uint8_t dst) {
+    uint8_t mark = reg_mark();
+    uint8_t obj = compile_expr(node->as.member.object);
+    uint8_t key = push_reg(node->line);
+    emit_imm(ROP_LOAD_K, key, string_constant(node->as.member.field, node->line),
+             node->line);
+    emit_op(ROP_MAP_GET, dst, obj, key, node->line);
+    reg_release(mark);
+}
+
+/*
+ * Calls to spawn/self/yield/print/len are native instructions; other
+ * builtins and module calls run as stubs. Returns true when a tail call
+ * was emitted, which only happens for user calls with tail set.
+ */
+static bool compile_call(AstNode *node, uint8_t dst, bool tail) {
+    AstNode *callee = node->as.call.callee;
+    size_t argc = node->as.call.arg_count;
+    uint8_t mark = reg_mark();
+
+    if (callee->type == NODE_IDENT) {
+        const char *name = callee->as.ident.name;
+
+        if (strcmp(name, "spawn") == 0 || strcmp(name, "len") == 0 ||
+            strcmp(name, "print") == 0) {
+            if (argc != 1) {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "%s() takes exactly 1 argument", name);
+                compile_error(node->line, msg);
+                return false;
+            }
+            uint8_t arg = compile_expr(node->as.call.args[0]);
+            if (name[0] == 'p') {
+                emit_op(ROP_PRINT, arg, 0, 0, node->line);
+                if (dst != REG_NONE) {
+                    emit_op(ROP_LOAD_NIL, dst, 0, 0, node->line);
+                }
+            } else {
+                if (dst == REG_NONE) dst = push_reg(node->line);
+                emit_op(name[0] == 's' ? ROP_SPAWN : ROP_LEN, dst, arg, 0, node->line);
+            }
+            reg_release(mark);
+            return false;
+        }
+
+        if (strcmp(name, "self") == 0 || strcmp(name, "yield") == 0) {
+            if (argc != 0) {
+                char msg[64];
+                snprintf(msg, sizeof(msg), "%s() takes no arguments", name);
+                compile_error(node->line, msg);
+                return false;
+            }
+            if (dst == REG_NONE) dst = push_reg(node->line);
+            emit_op(name[0] == 's' ? ROP_SELF : ROP_YIELD, dst, 0, 0, node->line);
+            reg_release(mark);
+            return false;
+        }
+
+        /* Children of a stack supervisor must be stack functions */
+        if (strcmp(name, "supervisor_add_child") == 0) {
+            compile_error(node->line,
+                          "supervisor_add_child() is not supported by the register backend");
+            return false;
+        }
+    }
 
-    /* Use ARRAY_GET for index access (works for both arrays and maps) */
-    emit_op(ROP_ARRAY_GET, rd, obj, idx, node->line);
+    if (callee->type == NODE_IDENT || callee->type == NODE_MEMBER) {
+        uint8_t base;
+        StubResult result = compile_stub(node, node->as.call.args, argc, dst, &base);
+        if (result == STUB_ERROR) {
+            return false;
+        }
+        if (result == STUB_OK) {
+            /* push()/pop() hand back the updated array in the operand register */
+            AstNode *arr = argc > 0 ? node->as.call.args[0] : NULL;
+            if (callee->type == NODE_IDENT && arr && arr->type == NODE_IDENT &&
+                (strcmp(callee->as.ident.name, "push") == 0 ||
+                 strcmp(callee->as.ident.name, "pop") == 0)) {
+                uint8_t reg = local_reg(arr);
+                if (reg == REG_NONE) {
+                    emit_imm(ROP_SET_GLOBAL, base,
+                             string_constant(arr->as.ident.name, node->line), node->line);
+                } else if (reg != base) {
+                    emit_op(ROP_MOV, reg, base, 0, node->line);
+                }
+            }
+            reg_release(mark);
+            return false;
+        }
+    }
 
-    if (regalloc_is_temp(current_alloc(), idx)) {
-        regalloc_free_temp(current_alloc(), idx);
+    /* Regular function call: callee and arguments in consecutive registers */
+    if (argc > 254) {
+        compile_error(node->line, "too many arguments");
+        return false;
     }
-    if (regalloc_is_temp(current_alloc(), obj)) {
-        regalloc_free_temp(current_alloc(), obj);
+
+    uint8_t fn = push_reg(node->line);
+    compile_expr_to(callee, fn);
+    for (size_t i = 0; i < argc; i++) {
+        compile_expr_to(node->as.call.args[i], push_reg(node->line));
     }
 
-    return rd;
+    if (tail) {
+        emit_op(ROP_TAIL_CALL, 0, fn, (uint8_t)argc, node->line);
+    } else {
+        emit_op(ROP_CALL, dst != REG_NONE ? dst : fn, fn, (uint8_t)argc, node->line);
+    }
+    reg_release(mark);
+    return tail;
 }
 
-static uint8_t compile_member(AstNode *node) {
-    uint8_t obj = compile_expr(node->as.member.object);
-    uint8_t rd = regalloc_new_result(current_alloc());
+static void compile_ternary(AstNode *node, uint8_t dst) {
+    uint8_t mark = reg_mark();
+    uint8_t cond = compile_expr(node->as.ternary.cond);
+    size_t else_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
+    reg_release(mark);
 
-    /* Load the field name as a string constant */
-    size_t idx = add_constant(value_string(node->as.member.field), node->line);
-    uint8_t key = regalloc_temp(current_alloc());
-    emit_imm(ROP_LOAD_K, key, (uint16_t)idx, node->line);
+    compile_expr_to(node->as.ternary.then_expr, dst);
+    size_t end_jump = emit_jump(ROP_JMP, 0, node->line);
 
-    emit_op(ROP_MAP_GET, rd, obj, key, node->line);
+    patch_jump(else_jump);
+    compile_expr_to(node->as.ternary.else_expr, dst);
+    patch_jump(end_jump);
+}
 
-    regalloc_free_temp(current_alloc(), key);
-    if (regalloc_is_temp(current_alloc(), obj)) {
-        regalloc_free_temp(current_alloc(), obj);
+/* Evaluate a block, leaving its last expression statement in dst */
+static void compile_block_to(AstNode *node, uint8_t dst) {
+    begin_scope();
+    bool has_value = false;
+    for (size_t i = 0; i < node->as.block.count; i++) {
+        AstNode *stmt = node->as.block.stmts[i];
+        bool is_last = (i == node->as.block.count - 1);
+
+        if (is_last && stmt->type == NODE_EXPR_STMT) {
+            compile_expr_to(stmt->as.return_stmt.value, dst);
+            has_value = true;
+        } else {
+            compile_stmt(stmt);
+        }
     }
+    if (!has_value) {
+        emit_op(ROP_LOAD_NIL, dst, 0, 0, node->line);
+    }
+    end_scope();
+}
 
-    return rd;
+/* Branch of an if or match arm; dst is REG_NONE when the value is unused */
+static void compile_branch(AstNode *node, uint8_t dst) {
+    if (node->type == NODE_BLOCK) {
+        if (dst == REG_NONE) {
+            compile_block(node);
+        } else {
+            compile_block_to(node, dst);
+        }
+    } else if (node->type == NODE_RETURN) {
+        compile_return(node);
+    } else if (dst == REG_NONE) {
+        compile_discard(node);
+    } else {
+        compile_expr_to(node, dst);
+    }
 }
 
-static uint8_t compile_call(AstNode *node) {
-    /* Compile callee */
-    uint8_t callee = compile_expr(node->as.call.callee);
+static void compile_if(AstNode *node, uint8_t dst) {
+    uint8_t mark = reg_mark();
+    uint8_t cond = compile_expr(node->as.if_stmt.cond);
+    size_t else_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
+    reg_release(mark);
 
-    /* Compile arguments */
-    uint8_t arg_regs[256];
-    size_t arg_count = node->as.call.arg_count;
-    if (arg_count > 255) {
-        compile_error(node->line, "too many arguments");
-        arg_count = 255;
-    }
+    compile_branch(node->as.if_stmt.then_block, dst);
 
-    for (size_t i = 0; i < arg_count; i++) {
-        arg_regs[i] = compile_expr(node->as.call.args[i]);
+    AstNode *else_block = node->as.if_stmt.else_block;
+    if (!else_block && dst == REG_NONE) {
+        patch_jump(else_jump);
+        return;
     }
 
-    uint8_t rd = regalloc_new_result(current_alloc());
+    size_t end_jump = emit_jump(ROP_JMP, 0, node->line);
+    patch_jump(else_jump);
 
-    /* Emit CALL: rd = call(callee, arg_count) */
-    /* First argument register is assumed to follow callee in a contiguous block */
-    emit_op(ROP_CALL, rd, callee, (uint8_t)arg_count, node->line);
+    if (else_block && else_block->type == NODE_IF) {
+        compile_if(else_block, dst);
+    } else if (else_block) {
+        compile_branch(else_block, dst);
+    } else {
+        emit_op(ROP_LOAD_NIL, dst, 0, 0, node->line);
+    }
+    patch_jump(end_jump);
+}
 
-    /* Free temps */
-    for (size_t i = arg_count; i > 0; i--) {
-        if (regalloc_is_temp(current_alloc(), arg_regs[i - 1])) {
-            regalloc_free_temp(current_alloc(), arg_regs[i - 1]);
+static void compile_assign(AstNode *node, uint8_t dst) {
+    AstNode *target = node->as.assign.target;
+    AstNode *value = node->as.assign.value;
+    TokenType op = node->as.assign.op;
+    RegOp arith = ROP_COUNT;
+
+    if (op != TOK_ASSIGN) {
+        arith = compound_op(op);
+        if (arith == ROP_COUNT) {
+            compile_error(node->line, "unknown assignment operator");
+            return;
         }
     }
-    if (regalloc_is_temp(current_alloc(), callee)) {
-        regalloc_free_temp(current_alloc(), callee);
+
+    uint8_t mark = reg_mark();
+
+    if (target->type == NODE_IDENT) {
+        const char *name = target->as.ident.name;
+        int slot = resolve_local(name);
+
+        if (slot >= 0) {
+            RegLocal *local = &compiler->current->locals[slot];
+            if (local->is_const) {
+                compile_error(node->line, "cannot assign to constant");
+                return;
+            }
+            uint8_t reg = local->reg;
+            if (op != TOK_ASSIGN) {
+                uint8_t rhs = compile_expr(value);
+                emit_op(arith, reg, reg, rhs, node->line);
+            } else if (writes_early(value)) {
+                uint8_t tmp = push_reg(node->line);
+                compile_expr_to(value, tmp);
+                emit_op(ROP_MOV, reg, tmp, 0, node->line);
+            } else {
+                compile_expr_to(value, reg);
+            }
+            if (dst != REG_NONE && dst != reg) {
+                emit_op(ROP_MOV, dst, reg, 0, node->line);
+            }
+        } else {
+            uint16_t k = string_constant(name, node->line);
+            uint8_t reg = dst != REG_NONE ? dst : push_reg(node->line);
+            if (op != TOK_ASSIGN) {
+                emit_imm(ROP_GET_GLOBAL, reg, k, node->line);
+                uint8_t rhs = compile_expr(value);
+                emit_op(arith, reg, reg, rhs, node->line);
+            } else {
+                compile_expr_to(value, reg);
+            }
+            emit_imm(ROP_SET_GLOBAL, reg, k, node->line);
+        }
+    } else if (target->type == NODE_INDEX || target->type == NODE_MEMBER) {
+        /* A local container is updated in place with the possibly-copied value */
+        bool is_index = target->type == NODE_INDEX;
+        uint8_t obj = compile_expr(is_index ? target->as.index_expr.object
+                                            : target->as.member.object);
+        uint8_t key;
+        if (is_index) {
+            key = compile_expr(target->as.index_expr.index);
+        } else {
+            key = push_reg(node->line);
+            emit_imm(ROP_LOAD_K, key, string_constant(target->as.member.field, node->line),
+                     node->line);
+        }
+
+        uint8_t val;
+        if (op != TOK_ASSIGN) {
+            val = push_reg(node->line);
+            emit_op(is_index ? ROP_ARRAY_GET : ROP_MAP_GET, val, obj, key, node->line);
+            uint8_t rhs = compile_expr(value);
+            emit_op(arith, val, val, rhs, node->line);
+        } else {
+            val = compile_expr(value);
+        }
+
+        if (is_index) {
+            emit_op(ROP_ARRAY_SET, obj, key, val, node->line);
+        } else {
+            emit_op(ROP_MAP_SET, val, obj, key, node->line);
+        }
+        /* Like the stack VM, the expression's value is the container */
+        if (dst != REG_NONE) {
+            emit_op(ROP_MOV, dst, obj, 0, node->line);
+        }
+    } else {
+        compile_error(node->line, "invalid assignment target");
     }
 
-    return rd;
+    reg_release(mark);
 }
 
-static uint8_t compile_ternary(AstNode *node) {
-    uint8_t cond = compile_expr(node->as.ternary.cond);
-    size_t else_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
+static void compile_try(AstNode *node, uint8_t dst) {
+    /*
+     * v = expr
+     * if result_is_err(v) return v
+     * dst = result_unwrap(v)
+     */
+    uint8_t mark = reg_mark();
+    uint8_t val = compile_expr(node->as.try_expr.expr);
+    uint8_t is_err = push_reg(node->line);
+    emit_fragment(OP_RESULT_IS_ERR, NULL, is_err, val, node->line);
+    size_t ok_jump = emit_jump(ROP_JMP_UNLESS, is_err, node->line);
+    emit_op(ROP_RET, val, 0, 0, node->line);
+    patch_jump(ok_jump);
+    emit_fragment(OP_RESULT_UNWRAP, NULL, dst, val, node->line);
+    reg_release(mark);
+}
 
-    if (regalloc_is_temp(current_alloc(), cond)) {
-        regalloc_free_temp(current_alloc(), cond);
+/* Arm body with its binding, when it has one, set to unwrap(src) */
+static void compile_match_arm(AstNode *arm, uint8_t dst, uint8_t src, Opcode unwrap) {
+    begin_scope();
+    const char *binding = arm->as.match_arm.binding_name;
+    if (binding && unwrap != OP_NOP) {
+        uint8_t reg = push_reg(arm->line);
+        emit_fragment(unwrap, NULL, reg, src, arm->line);
+        add_local(binding, true, reg, arm->line);
     }
+    compile_branch(arm->as.match_arm.body, dst);
+    end_scope();
+}
 
-    uint8_t rd = regalloc_new_result(current_alloc());
-
-    /* Then branch */
-    uint8_t then_val = compile_expr(node->as.ternary.then_expr);
-    emit_op(ROP_MOV, rd, then_val, 0, node->line);
-    if (regalloc_is_temp(current_alloc(), then_val)) {
-        regalloc_free_temp(current_alloc(), then_val);
+static void compile_match(AstNode *node, uint8_t dst) {
+    AstNode *ok_arm = NULL;
+    AstNode *err_arm = NULL;
+    AstNode *some_arm = NULL;
+    AstNode *none_arm = NULL;
+    bool has_enum_arms = false;
+
+    for (size_t i = 0; i < node->as.match_expr.arm_count; i++) {
+        AstNode *arm = node->as.match_expr.arms[i];
+        switch (arm->as.match_arm.pattern_kind) {
+        case MATCH_PATTERN_OK: ok_arm = arm; break;
+        case MATCH_PATTERN_ERR: err_arm = arm; break;
+        case MATCH_PATTERN_SOME: some_arm = arm; break;
+        case MATCH_PATTERN_NONE: none_arm = arm; break;
+        case MATCH_PATTERN_ENUM: has_enum_arms = true; break;
+        }
     }
 
-    size_t end_jump = emit_jump(ROP_JMP, 0, node->line);
-    patch_jump(else_jump);
+    bool is_result_match = (ok_arm != NULL || err_arm != NULL);
+    bool is_option_match = (some_arm != NULL || none_arm != NULL);
 
-    /* Else branch */
-    uint8_t else_val = compile_expr(node->as.ternary.else_expr);
-    emit_op(ROP_MOV, rd, else_val, 0, node->line);
-    if (regalloc_is_temp(current_alloc(), else_val)) {
-        regalloc_free_temp(current_alloc(), else_val);
+    if ((is_result_match && is_option_match) ||
+        (is_result_match && has_enum_arms) ||
+        (is_option_match && has_enum_arms)) {
+        compile_error(node->line, "cannot mix different pattern types in match");
+        return;
+    }
+    if (is_result_match && (!ok_arm || !err_arm)) {
+        compile_error(node->line, "match expression must have both ok and err arms");
+        return;
+    }
+    if (is_option_match && (!some_arm || !none_arm)) {
+        compile_error(node->line, "match expression must have both some and none arms");
+        return;
+    }
+    if (!is_result_match && !is_option_match && !has_enum_arms) {
+        compile_error(node->line, "match expression must have ok/err, some/none, or enum variant arms");
+        return;
     }
 
-    patch_jump(end_jump);
+    uint8_t mark = reg_mark();
+    uint8_t val = compile_expr(node->as.match_expr.expr);
+    uint8_t cond = push_reg(node->line);
+
+    if (is_result_match || is_option_match) {
+        emit_fragment(is_result_match ? OP_RESULT_IS_OK : OP_IS_SOME, NULL, cond, val,
+                      node->line);
+        size_t else_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
 
-    return rd;
+        if (is_result_match) {
+            compile_match_arm(ok_arm, dst, val, OP_RESULT_UNWRAP);
+        } else {
+            compile_match_arm(some_arm, dst, val, OP_UNWRAP_OPTION);
+        }
+        size_t end_jump = emit_jump(ROP_JMP, 0, node->line);
+
+        patch_jump(else_jump);
+        if (is_result_match) {
+            compile_match_arm(err_arm, dst, val, OP_RESULT_UNWRAP);
+        } else {
+            compile_match_arm(none_arm, dst, val, OP_NOP);
+        }
+        patch_jump(end_jump);
+    } else {
+        /* Enum match: test each variant in turn, nil when none matches */
+        JumpList end_jumps = {0};
+        for (size_t i = 0; i < node->as.match_expr.arm_count; i++) {
+            AstNode *arm = node->as.match_expr.arms[i];
+            if (arm->as.match_arm.pattern_kind != MATCH_PATTERN_ENUM) continue;
+
+            emit_fragment(OP_ENUM_IS, arm->as.match_arm.variant_name, cond, val, arm->line);
+            size_t next_jump = emit_jump(ROP_JMP_UNLESS, cond, arm->line);
+            compile_match_arm(arm, dst, val, OP_ENUM_PAYLOAD);
+            jump_list_add(&end_jumps, emit_jump(ROP_JMP, 0, arm->line));
+            patch_jump(next_jump);
+        }
+        if (dst != REG_NONE) {
+            emit_op(ROP_LOAD_NIL, dst, 0, 0, node->line);
+        }
+        jump_list_patch(&end_jumps);
+        agim_free(end_jumps.jumps);
+    }
+
+    reg_release(mark);
 }
 
+/* Value in any register: a local's own, or a freshly pushed temporary */
 static uint8_t compile_expr(AstNode *node) {
+    uint8_t reg = node ? local_reg(node) : REG_NONE;
+    if (reg != REG_NONE) {
+        return reg;
+    }
+
+    reg = push_reg(node ? node->line : 0);
+    compile_expr_to(node, reg);
+    return reg;
+}
+
+static void compile_expr_to(AstNode *node, uint8_t dst) {
     if (!node) {
-        uint8_t rd = regalloc_new_result(current_alloc());
-        emit_op(ROP_LOAD_NIL, rd, 0, 0, 0);
-        return rd;
+        emit_op(ROP_LOAD_NIL, dst, 0, 0, 0);
+        return;
     }
+    if (compiler->had_error) return;
 
     switch (node->type) {
     case NODE_NIL:
-        return compile_nil(node);
+        emit_op(ROP_LOAD_NIL, dst, 0, 0, node->line);
+        break;
     case NODE_BOOL:
-        return compile_bool(node);
+        emit_op(node->as.bool_val ? ROP_LOAD_TRUE : ROP_LOAD_FALSE, dst, 0, 0, node->line);
+        break;
     case NODE_INT:
-        return compile_int(node);
+        emit_load_int(dst, node->as.int_val, node->line);
+        break;
     case NODE_FLOAT:
-        return compile_float(node);
+        emit_imm(ROP_LOAD_K, dst,
+                 (uint16_t)add_constant(value_float(node->as.float_val), node->line),
+                 node->line);
+        break;
     case NODE_STRING:
-        return compile_string(node);
+        emit_imm(ROP_LOAD_K, dst, string_constant(node->as.string_val, node->line),
+                 node->line);
+        break;
     case NODE_IDENT:
-        return compile_identifier(node);
+        compile_ident(node, dst);
+        break;
     case NODE_BINARY:
-        return compile_binary(node);
+        compile_binary(node, dst);
+        break;
     case NODE_UNARY:
-        return compile_unary(node);
-    case NODE_ARRAY:
-        return compile_array(node);
-    case NODE_MAP:
-        return compile_map(node);
-    case NODE_INDEX:
-        return compile_index(node);
-    case NODE_MEMBER:
-        return compile_member(node);
+        compile_unary(node, dst);
+        break;
     case NODE_CALL:
-        return compile_call(node);
+        compile_call(node, dst, false);
+        break;
+    case NODE_MEMBER:
+        compile_member(node, dst);
+        break;
+    case NODE_INDEX:
+        compile_index(node, dst);
+        break;
     case NODE_TERNARY:
-        return compile_ternary(node);
+        compile_ternary(node, dst);
+        break;
+    case NODE_IF:
+        compile_if(node, dst);
+        break;
+    case NODE_ASSIGN:
+        compile_assign(node, dst);
+        break;
+    case NODE_ARRAY:
+        compile_array(node, dst);
+        break;
+    case NODE_MAP:
+        compile_map(node, dst);
+        break;
+    case NODE_RESULT_OK:
+    case NODE_RESULT_ERR:
+        compile_stub_expr(node, &node->as.result_expr.value, 1, dst);
+        break;
+    case NODE_SOME:
+        compile_stub_expr(node, &node->as.some_expr.value, 1, dst);
+        break;
+    case NODE_NONE:
+        compile_stub_expr(node, NULL, 0, dst);
+        break;
+    case NODE_STRUCT_INIT:
+        compile_stub_expr(node, node->as.struct_init.field_values,
+                          node->as.struct_init.field_count, dst);
+        break;
+    case NODE_ENUM_EXPR:
+        compile_stub_expr(node, &node->as.enum_expr.payload,
+                          node->as.enum_expr.payload ? 1 : 0, dst);
+        break;
+    case NODE_TRY:
+        compile_try(node, dst);
+        break;
+    case NODE_MATCH:
+        compile_match(node, dst);
+        break;
     default:
-        compile_error(node->line, "cannot compile expression");
-        return regalloc_new_result(current_alloc());
+        compile_error(node->line, "unexpected expression type");
+        break;
+    }
+}
+
+/* Evaluate for side effects only */
+static void compile_discard(AstNode *node) {
+    switch (node->type) {
+    case NODE_ASSIGN:
+        compile_assign(node, REG_NONE);
+        break;
+    case NODE_IF:
+        compile_if(node, REG_NONE);
+        break;
+    case NODE_CALL:
+        compile_call(node, REG_NONE, false);
+        break;
+    case NODE_MATCH:
+        compile_match(node, REG_NONE);
+        break;
+    default: {
+        uint8_t mark = reg_mark();
+        compile_expr(node);
+        reg_release(mark);
+        break;
+    }
     }
 }
 
 /* Statement Compilation */
 
-static void compile_var_decl(AstNode *node, bool is_const) {
-    uint8_t init_reg;
-    if (node->as.var_decl.value) {
-        init_reg = compile_expr(node->as.var_decl.value);
-    } else {
-        init_reg = regalloc_temp(current_alloc());
-        emit_op(ROP_LOAD_NIL, init_reg, 0, 0, node->line);
-    }
+static void compile_let(AstNode *node, bool is_const) {
+    AstNode *value = node->as.var_decl.value;
 
     if (compiler->current->scope_depth > 0) {
-        /* Local variable */
-        int slot = add_local(node->as.var_decl.name, strlen(node->as.var_decl.name),
-                            is_const, node->line);
-        if (slot >= 0) {
-            uint8_t local_reg = compiler->current->locals[slot].reg;
-            if (local_reg != init_reg) {
-                emit_op(ROP_MOV, local_reg, init_reg, 0, node->line);
-            }
-        }
+        /* Local variable: evaluated straight into its register */
+        uint8_t reg = push_reg(node->line);
+        compile_expr_to(value, reg);
+        add_local(node->as.var_decl.name, is_const, reg, node->line);
     } else {
         /* Global variable */
-        size_t idx = add_constant(value_string(node->as.var_decl.name), node->line);
-        emit_imm(ROP_SET_GLOBAL, init_reg, (uint16_t)idx, node->line);
+        uint8_t mark = reg_mark();
+        uint8_t reg = compile_expr(value);
+        emit_imm(ROP_SET_GLOBAL, reg, string_constant(node->as.var_decl.name, node->line),
+                 node->line);
+        reg_release(mark);
     }
+}
 
-    if (regalloc_is_temp(current_alloc(), init_reg)) {
-        regalloc_free_temp(current_alloc(), init_reg);
+static void compile_block(AstNode *node) {
+    begin_scope();
+    for (size_t i = 0; i < node->as.block.count; i++) {
+        compile_stmt(node->as.block.stmts[i]);
     }
+    end_scope();
 }
 
-static void compile_assignment(AstNode *node) {
-    uint8_t val_reg = compile_expr(node->as.assign.value);
+static void compile_while(AstNode *node) {
+    /*
+     *   JMP cond
+     * body:
+     *   <body>
+     * cond:
+     *   c = <cond>
+     *   JMP_IF c, body
+     */
+    size_t cond_jump = emit_jump(ROP_JMP, 0, node->line);
+    size_t body_start = current_chunk()->code_size;
+
+    begin_loop(node->line);
+    compile_stmt(node->as.while_stmt.body);
 
-    AstNode *target = node->as.assign.target;
-    if (target->type == NODE_IDENT) {
-        const char *name = target->as.ident.name;
-        int slot = resolve_local(name, strlen(name));
+    RegLoop *loop = current_loop();
+    if (loop) jump_list_patch(&loop->continues);
+    patch_jump(cond_jump);
 
-        if (slot >= 0) {
-            uint8_t local_reg = compiler->current->locals[slot].reg;
-            if (local_reg != val_reg) {
-                emit_op(ROP_MOV, local_reg, val_reg, 0, node->line);
-            }
-        } else {
-            size_t idx = add_constant(value_string(name), node->line);
-            emit_imm(ROP_SET_GLOBAL, val_reg, (uint16_t)idx, node->line);
-        }
-    } else if (target->type == NODE_INDEX) {
-        uint8_t obj = compile_expr(target->as.index_expr.object);
-        uint8_t idx = compile_expr(target->as.index_expr.index);
-        emit_op(ROP_ARRAY_SET, val_reg, obj, idx, node->line);
-        if (regalloc_is_temp(current_alloc(), idx)) {
-            regalloc_free_temp(current_alloc(), idx);
-        }
-        if (regalloc_is_temp(current_alloc(), obj)) {
-            regalloc_free_temp(current_alloc(), obj);
-        }
-    } else if (target->type == NODE_MEMBER) {
-        uint8_t obj = compile_expr(target->as.member.object);
-        size_t idx = add_constant(value_string(target->as.member.field), node->line);
-        uint8_t key = regalloc_temp(current_alloc());
-        emit_imm(ROP_LOAD_K, key, (uint16_t)idx, node->line);
-        emit_op(ROP_MAP_SET, val_reg, obj, key, node->line);
-        regalloc_free_temp(current_alloc(), key);
-        if (regalloc_is_temp(current_alloc(), obj)) {
-            regalloc_free_temp(current_alloc(), obj);
-        }
-    }
+    uint8_t mark = reg_mark();
+    uint8_t cond = compile_expr(node->as.while_stmt.cond);
+    emit_jump_to(ROP_JMP_IF, cond, body_start, node->line);
+    reg_release(mark);
 
-    if (regalloc_is_temp(current_alloc(), val_reg)) {
-        regalloc_free_temp(current_alloc(), val_reg);
-    }
+    end_loop();
 }
 
-static void compile_if(AstNode *node) {
-    uint8_t cond = compile_expr(node->as.if_stmt.cond);
-    size_t else_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
+static void compile_for_range(AstNode *node, AstNode *range) {
+    /*
+     * for i in start..end { body }    (exclusive)
+     * for i in start..=end { body }   (inclusive)
+     *
+     * end and the step live in hidden registers; continue jumps to the
+     * increment.
+     */
+    uint8_t mark = reg_mark();
+    begin_scope();
 
-    if (regalloc_is_temp(current_alloc(), cond)) {
-        regalloc_free_temp(current_alloc(), cond);
-    }
+    uint8_t end = push_reg(node->line);
+    compile_expr_to(range->as.range.end, end);
 
-    compile_stmt(node->as.if_stmt.then_block);
+    uint8_t var = push_reg(node->line);
+    compile_expr_to(range->as.range.start, var);
+    add_local(node->as.for_stmt.var, false, var, node->line);
 
-    if (node->as.if_stmt.else_block) {
-        size_t end_jump = emit_jump(ROP_JMP, 0, node->line);
-        patch_jump(else_jump);
-        compile_stmt(node->as.if_stmt.else_block);
-        patch_jump(end_jump);
-    } else {
-        patch_jump(else_jump);
-    }
-}
+    uint8_t one = push_reg(node->line);
+    emit_load_int(one, 1, node->line);
+    uint8_t cmp = push_reg(node->line);
 
-static void compile_while(AstNode *node) {
-    size_t loop_start = current_chunk()->code_size;
+    size_t cond_jump = emit_jump(ROP_JMP, 0, node->line);
+    size_t body_start = current_chunk()->code_size;
 
-    uint8_t cond = compile_expr(node->as.while_stmt.cond);
-    size_t exit_jump = emit_jump(ROP_JMP_UNLESS, cond, node->line);
+    begin_loop(node->line);
+    compile_stmt(node->as.for_stmt.body);
 
-    if (regalloc_is_temp(current_alloc(), cond)) {
-        regalloc_free_temp(current_alloc(), cond);
+    RegLoop *loop = current_loop();
+    if (loop) jump_list_patch(&loop->continues);
+    emit_op(ROP_ADD, var, var, one, node->line);
+
+    patch_jump(cond_jump);
+    emit_op(range->as.range.inclusive ? ROP_LE : ROP_LT, cmp, var, end, node->line);
+    emit_jump_to(ROP_JMP_IF, cmp, body_start, node->line);
+
+    end_loop();
+    end_scope();
+    reg_release(mark);
+}
+
+static void compile_for(AstNode *node) {
+    if (node->as.for_stmt.iterable->type == NODE_RANGE) {
+        compile_for_range(node, node->as.for_stmt.iterable);
+        return;
     }
 
-    compile_stmt(node->as.while_stmt.body);
+    /*
+     * for item in iterable { body }
+     *
+     * The length is re-read every iteration, as the body may grow or
+     * shrink the array.
+     */
+    uint8_t mark = reg_mark();
+    begin_scope();
 
-    /* Loop back */
-    int16_t offset = (int16_t)(loop_start - current_chunk()->code_size - 1);
-    emit(reg_instr_cond_jump(ROP_JMP, 0, offset), node->line);
+    uint8_t iter = push_reg(node->line);
+    compile_expr_to(node->as.for_stmt.iterable, iter);
+    uint8_t idx = push_reg(node->line);
+    emit_load_int(idx, 0, node->line);
+    uint8_t one = push_reg(node->line);
+    emit_load_int(one, 1, node->line);
+    uint8_t len = push_reg(node->line);
+    uint8_t cmp = push_reg(node->line);
 
-    patch_jump(exit_jump);
-}
+    size_t cond_jump = emit_jump(ROP_JMP, 0, node->line);
+    size_t body_start = current_chunk()->code_size;
 
-static void compile_block(AstNode *node) {
+    begin_loop(node->line);
+
+    /* Inner scope for the loop variable */
     begin_scope();
-    for (size_t i = 0; i < node->as.block.count; i++) {
-        compile_stmt(node->as.block.stmts[i]);
-    }
-    end_scope(node->line);
+    uint8_t item = push_reg(node->line);
+    emit_op(ROP_ARRAY_GET, item, iter, idx, node->line);
+    add_local(node->as.for_stmt.var, true, item, node->line);
+    compile_stmt(node->as.for_stmt.body);
+    end_scope();
+
+    RegLoop *loop = current_loop();
+    if (loop) jump_list_patch(&loop->continues);
+    emit_op(ROP_ADD, idx, idx, one, node->line);
+
+    patch_jump(cond_jump);
+    emit_op(ROP_LEN, len, iter, 0, node->line);
+    emit_op(ROP_LT, cmp, idx, len, node->line);
+    emit_jump_to(ROP_JMP_IF, cmp, body_start, node->line);
+
+    end_loop();
+    end_scope();
+    reg_release(mark);
 }
 
 static void compile_return(AstNode *node) {
-    uint8_t val;
-    if (node->as.return_stmt.value) {
-        val = compile_expr(node->as.return_stmt.value);
+    AstNode *value = node->as.return_stmt.value;
+    uint8_t mark = reg_mark();
+
+    /* return f(x) reuses the frame inside functions */
+    if (value && value->type == NODE_CALL && compiler->current->is_function) {
+        uint8_t reg = push_reg(node->line);
+        if (!compile_call(value, reg, true)) {
+            emit_op(ROP_RET, reg, 0, 0, node->line);
+        }
+    } else if (value) {
+        emit_op(ROP_RET, compile_expr(value), 0, 0, node->line);
     } else {
-        val = regalloc_temp(current_alloc());
-        emit_op(ROP_LOAD_NIL, val, 0, 0, node->line);
+        uint8_t reg = push_reg(node->line);
+        emit_op(ROP_LOAD_NIL, reg, 0, 0, node->line);
+        emit_op(ROP_RET, reg, 0, 0, node->line);
     }
-    emit_op(ROP_RET, val, 0, 0, node->line);
+    reg_release(mark);
 }
 
-static void compile_expr_stmt(AstNode *node) {
-    /* NODE_EXPR_STMT wraps an expression */
-    /* The statement itself is the wrapper, containing a single child expression */
-    /* But looking at the AST, NODE_EXPR_STMT is just a marker - we compile its child */
-    /* Actually, looking at AST more carefully - there's no explicit expr_stmt union member */
-    /* Let me check: the node itself may be an expression directly used as statement */
-
-    /* For expression statements, we just evaluate and discard */
-    uint8_t reg = compile_expr(node);
-    if (regalloc_is_temp(current_alloc(), reg)) {
-        regalloc_free_temp(current_alloc(), reg);
+static void compile_jump_stmt(AstNode *node) {
+    bool is_break = node->type == NODE_BREAK;
+    RegLoop *loop = current_loop();
+    if (!loop) {
+        compile_error(node->line, is_break ? "break outside of loop"
+                                           : "continue outside of loop");
+        return;
     }
+
+    /* Registers need no cleanup; just jump */
+    size_t jump = emit_jump(ROP_JMP, 0, node->line);
+    jump_list_add(is_break ? &loop->breaks : &loop->continues, jump);
 }
 
 static void compile_stmt(AstNode *node) {
-    if (!node) return;
+    if (!node || compiler->had_error) return;
+
+    uint8_t mark = reg_mark();
 
     switch (node->type) {
-    case NODE_LET:
-        compile_var_decl(node, false);
+    case NODE_BLOCK:
+        compile_block(node);
         break;
+    case NODE_LET:
+        compile_let(node, false);
+        return;  /* Keeps its register */
     case NODE_CONST:
-        compile_var_decl(node, true);
-        break;
-    case NODE_ASSIGN:
-        compile_assignment(node);
-        break;
+        compile_let(node, true);
+        return;
     case NODE_IF:
-        compile_if(node);
+        compile_if(node, REG_NONE);
         break;
     case NODE_WHILE:
         compile_while(node);
         break;
-    case NODE_BLOCK:
-        compile_block(node);
+    case NODE_FOR:
+        compile_for(node);
         break;
     case NODE_RETURN:
         compile_return(node);
         break;
+    case NODE_BREAK:
+    case NODE_CONTINUE:
+        compile_jump_stmt(node);
+        break;
     case NODE_EXPR_STMT:
-        compile_expr_stmt(node);
+        compile_discard(node->as.return_stmt.value);
         break;
     default:
-        /* Try as expression (for things like function calls used as statements) */
-        {
-            uint8_t reg = compile_expr(node);
-            if (regalloc_is_temp(current_alloc(), reg)) {
-                regalloc_free_temp(current_alloc(), reg);
-            }
-        }
+        compile_error(node->line, "unexpected statement type");
         break;
     }
 
-    /* Free all temps after each statement */
-    regalloc_free_all_temps(current_alloc());
+    reg_release(mark);
 }
 
-static void compile_node(AstNode *node) {
-    compile_stmt(node);
+/* Declaration Compilation */
+
+static void free_locals(RegFuncContext *ctx) {
+    for (int i = 0; i < ctx->local_count; i++) {
+        agim_free(ctx->locals[i].name);
+    }
+    ctx->local_count = 0;
 }
 
-/* Public API */
+static void init_context(RegFuncContext *ctx, RegChunk *chunk, bool is_function) {
+    ctx->chunk = chunk;
+    regalloc_init(&ctx->alloc);
+    ctx->local_count = 0;
+    ctx->scope_depth = 0;
+    ctx->loop_depth = 0;
+    ctx->is_function = is_function;
+    ctx->enclosing = compiler->current;
+}
 
-RegChunk *regcompile(AstNode *ast) {
-    if (!ast) return NULL;
+static void compile_fn(AstNode *node, bool is_tool) {
+    size_t param_count = node->as.fn_decl.param_count;
+    if (param_count > 255) {
+        compile_error(node->line, "too many parameters");
+        return;
+    }
 
-    /* Initialize compiler */
-    RegCompiler comp;
-    comp.had_error = false;
-    comp.error = NULL;
-    comp.error_line = 0;
-    comp.chunk = regchunk_new();
+    RegChunk *fn = regchunk_new();
+    fn->name = agim_strdup(node->as.fn_decl.name);
+    fn->num_params = (uint8_t)param_count;
+    size_t fn_index = regchunk_add_function(compiler->program, fn);
 
-    RegFuncContext main_ctx;
-    main_ctx.chunk = comp.chunk;
-    regalloc_init(&main_ctx.alloc);
-    main_ctx.local_count = 0;
-    main_ctx.scope_depth = 0;
-    main_ctx.enclosing = NULL;
+    RegFuncContext fn_ctx;
+    init_context(&fn_ctx, fn, true);
+    compiler->current = &fn_ctx;
 
-    comp.current = &main_ctx;
-    compiler = &comp;
+    begin_scope();
 
-    /* Compile program */
-    if (ast->type == NODE_PROGRAM) {
-        for (size_t i = 0; i < ast->as.program.count; i++) {
-            compile_node(ast->as.program.decls[i]);
-            if (comp.had_error) break;
-        }
-    } else {
-        compile_node(ast);
+    /* Parameters arrive in r0 .. rN-1 */
+    for (size_t i = 0; i < param_count; i++) {
+        AstNode *param = node->as.fn_decl.params[i];
+        add_local(param->as.param.name, false, push_reg(param->line), param->line);
+    }
+
+    AstNode *body = node->as.fn_decl.body;
+    for (size_t i = 0; i < body->as.block.count; i++) {
+        compile_stmt(body->as.block.stmts[i]);
     }
 
-    /* Add halt at end */
-    emit_op(ROP_HALT, 0, 0, 0, 0);
+    /* Implicit return nil */
+    uint8_t reg = push_reg(node->line);
+    emit_op(ROP_LOAD_NIL, reg, 0, 0, node->line);
+    emit_op(ROP_RET, reg, 0, 0, node->line);
 
-    /* Record register usage */
-    comp.chunk->num_regs = regalloc_count(&main_ctx.alloc);
+    fn->num_regs = regalloc_count(&fn_ctx.alloc);
 
-    /* Cleanup locals */
-    for (int i = 0; i < main_ctx.local_count; i++) {
-        agim_free(main_ctx.locals[i].name);
+    compiler->current = fn_ctx.enclosing;
+    free_locals(&fn_ctx);
+
+    /* Listed by --tools; the stack-side tool registry is not used */
+    if (is_tool) {
+        compiler_add_tool(compiler->program->stubs, node, fn_index);
     }
+}
 
-    compiler = NULL;
+static void compile_module_decls(Module *mod) {
+    if (!mod || !mod->ast || mod->ast->type != NODE_PROGRAM) return;
 
-    if (comp.had_error) {
-        regchunk_free(comp.chunk);
+    const char *saved_path = compiler->source_path;
+    compiler->source_path = mod->path;
+
+    for (size_t i = 0; i < mod->ast->as.program.count && !compiler->had_error; i++) {
+        AstNode *decl = mod->ast->as.program.decls[i];
+        if (decl->type == NODE_EXPORT) {
+            decl = decl->as.export_stmt.decl;
+        }
+        compile_decl(decl);
+    }
+
+    compiler->source_path = saved_path;
+}
+
+static Module *load_module(const char *path, int line) {
+    if (!compiler->modules) {
+        compiler->modules = module_cache_new();
+    }
+
+    char *error = NULL;
+    Module *mod = module_load(path, compiler->source_path, compiler->modules, &error);
+    if (!mod) {
+        compile_error(line, error ? error : "failed to load module");
+        if (error) agim_free(error);
         return NULL;
     }
 
-    return comp.chunk;
+    if (!mod->is_compiled) {
+        mod->is_compiled = true;
+        compile_module_decls(mod);
+    }
+    return mod;
 }
 
-RegChunk *regcompile_expr(AstNode *ast) {
-    if (!ast) return NULL;
+static void compile_import_from(AstNode *node) {
+    Module *mod = load_module(node->as.import_from.path, node->line);
+    if (!mod) return;
 
-    /* Initialize compiler */
-    RegCompiler comp;
-    comp.had_error = false;
-    comp.error = NULL;
-    comp.error_line = 0;
-    comp.chunk = regchunk_new();
+    for (size_t i = 0; i < node->as.import_from.name_count; i++) {
+        const char *name = node->as.import_from.names[i];
+        bool found = false;
 
-    RegFuncContext main_ctx;
-    main_ctx.chunk = comp.chunk;
-    regalloc_init(&main_ctx.alloc);
-    main_ctx.local_count = 0;
-    main_ctx.scope_depth = 0;
-    main_ctx.enclosing = NULL;
+        for (size_t j = 0; j < mod->export_count; j++) {
+            if (strcmp(mod->exports[j], name) == 0) {
+                found = true;
+                break;
+            }
+        }
 
-    comp.current = &main_ctx;
-    compiler = &comp;
+        if (!found) {
+            char msg[256];
+            snprintf(msg, sizeof(msg), "'%s' is not exported from module", name);
+            compile_error(node->line, msg);
+            return;
+        }
+    }
+}
 
-    /* Compile expression */
-    uint8_t result = compile_expr(ast);
+static void compile_decl(AstNode *node) {
+    if (compiler->had_error) return;
 
-    /* Move result to r0 for consistent return value location */
-    if (result != 0) {
-        emit_op(ROP_MOV, 0, result, 0, ast->line);
+    switch (node->type) {
+    case NODE_TOOL_DECL:
+        compile_fn(node, true);
+        break;
+    case NODE_FN_DECL:
+        compile_fn(node, false);
+        break;
+    case NODE_IMPORT:
+        load_module(node->as.import_stmt.path, node->line);
+        break;
+    case NODE_IMPORT_FROM:
+        compile_import_from(node);
+        break;
+    case NODE_EXPORT:
+        compile_decl(node->as.export_stmt.decl);
+        break;
+    case NODE_STRUCT_DECL:
+    case NODE_ENUM_DECL:
+        /* Type-only, no runtime code */
+        break;
+    default:
+        compile_stmt(node);
+        break;
     }
+}
+
+/* Public API */
 
-    /* Return r0 */
-    emit_op(ROP_RET, 0, 0, 0, ast->line);
+static bool regcompiler_begin(RegCompiler *comp, RegFuncContext *main_ctx) {
+    memset(comp, 0, sizeof(RegCompiler));
+    error_message[0] = '\0';
+    error_line = 0;
 
-    /* Record register usage */
-    comp.chunk->num_regs = regalloc_count(&main_ctx.alloc);
+    comp->program = regchunk_new();
+    comp->stack = compiler_new();
+    if (comp->program) {
+        comp->program->stubs = bytecode_new();
+    }
+    if (!comp->program || !comp->stack || !comp->program->stubs) {
+        snprintf(error_message, sizeof(error_message), "out of memory");
+        regchunk_free(comp->program);
+        compiler_free(comp->stack);
+        return false;
+    }
+
+    compiler = comp;
+    init_context(main_ctx, comp->program, false);
+    comp->current = main_ctx;
+    return true;
+}
 
+static void pin_constants(Chunk *chunk) {
+    for (size_t i = 0; i < chunk->constants_size; i++) {
+        value_pin(chunk->constants[i]);
+    }
+}
+
+static RegChunk *regcompiler_end(RegCompiler *comp, RegFuncContext *main_ctx) {
+    comp->program->num_regs = regalloc_count(&main_ctx->alloc);
+    free_locals(main_ctx);
+
+    compiler_free(comp->stack);
+    if (comp->modules) {
+        module_cache_free(comp->modules);
+    }
+    agim_free(comp->fragments);
     compiler = NULL;
 
-    if (comp.had_error) {
-        regchunk_free(comp.chunk);
+    if (comp->had_error) {
+        regchunk_free(comp->program);
         return NULL;
     }
 
-    return comp.chunk;
+    /* Stubs hand out their constants uncounted too */
+    Bytecode *stubs = comp->program->stubs;
+    pin_constants(stubs->main);
+    for (size_t i = 0; i < stubs->functions_count; i++) {
+        pin_constants(stubs->functions[i]);
+    }
+    return comp->program;
+}
+
+RegChunk *regcompile(AstNode *ast) {
+    if (!ast) return NULL;
+
+    ast_optimize(ast);
+
+    RegCompiler comp;
+    RegFuncContext main_ctx;
+    if (!regcompiler_begin(&comp, &main_ctx)) return NULL;
+
+    /* The value of a trailing expression or if is the program's result */
+    uint8_t result = REG_NONE;
+    if (ast->type == NODE_PROGRAM) {
+        for (size_t i = 0; i < ast->as.program.count && !comp.had_error; i++) {
+            AstNode *decl = ast->as.program.decls[i];
+            bool is_last = (i == ast->as.program.count - 1);
+
+            if (is_last && decl->type == NODE_EXPR_STMT) {
+                result = push_reg(decl->line);
+                compile_expr_to(decl->as.return_stmt.value, result);
+            } else if (is_last && decl->type == NODE_IF) {
+                result = push_reg(decl->line);
+                compile_if(decl, result);
+            } else {
+                compile_decl(decl);
+            }
+        }
+    } else {
+        compile_decl(ast);
+    }
+
+    if (result == REG_NONE) {
+        result = push_reg(ast->line);
+        emit_op(ROP_LOAD_NIL, result, 0, 0, ast->line);
+    }
+    emit_op(ROP_RET, result, 0, 0, ast->line);
+
+    return regcompiler_end(&comp, &main_ctx);
+}
+
+RegChunk *regcompile_expr(AstNode *ast) {
+    if (!ast) return NULL;
+
+    RegCompiler comp;
+    RegFuncContext main_ctx;
+    if (!regcompiler_begin(&comp, &main_ctx)) return NULL;
+
+    /* Result in r0 for a consistent return value location */
+    uint8_t result = push_reg(ast->line);
+    compile_expr_to(ast, result);
+    emit_op(ROP_RET, result, 0, 0, ast->line);
+
+    return regcompiler_end(&comp, &main_ctx);
 }
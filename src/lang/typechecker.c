@@ -687,6 +687,13 @@ static Type *check_expr(TypeChecker *tc, AstNode *node) {
                 return type_string();
             }
 
+            /* Operands of one numeric type can skip the VM's type dispatch */
+            if (left->kind == TYPE_INT && right->kind == TYPE_INT) {
+                node->hint = TYPE_HINT_INT;
+            } else if (left->kind == TYPE_FLOAT && right->kind == TYPE_FLOAT) {
+                node->hint = TYPE_HINT_FLOAT;
+            }
+
             /* Numeric operations */
             if (left->kind == TYPE_FLOAT || right->kind == TYPE_FLOAT) {
                 type_free(left);
@@ -814,7 +821,7 @@ static Type *check_expr(TypeChecker *tc, AstNode *node) {
     }
 
     case NODE_MATCH: {
-        check_expr(tc, node->as.match_expr.expr);
+        type_free(check_expr(tc, node->as.match_expr.expr));
         if (node->as.match_expr.arm_count > 0) {
             return check_expr(tc, node->as.match_expr.arms[0]->as.match_arm.body);
         }
@@ -877,7 +884,7 @@ static void check_stmt(TypeChecker *tc, AstNode *node) {
     }
 
     case NODE_IF:
-        check_expr(tc, node->as.if_stmt.cond);
+        type_free(check_expr(tc, node->as.if_stmt.cond));
         type_env_push_scope(tc->env);
         check_stmt(tc, node->as.if_stmt.then_block);
         type_env_pop_scope(tc->env);
@@ -889,7 +896,7 @@ static void check_stmt(TypeChecker *tc, AstNode *node) {
         break;
 
     case NODE_WHILE:
-        check_expr(tc, node->as.while_stmt.cond);
+        type_free(check_expr(tc, node->as.while_stmt.cond));
         type_env_push_scope(tc->env);
         check_stmt(tc, node->as.while_stmt.body);
         type_env_pop_scope(tc->env);
@@ -899,10 +906,9 @@ static void check_stmt(TypeChecker *tc, AstNode *node) {
         type_env_push_scope(tc->env);
         {
             Type *iter_type = check_expr(tc, node->as.for_stmt.iterable);
-            Type *elem_type = type_any();
-            if (iter_type->kind == TYPE_ARRAY) {
-                elem_type = type_clone(iter_type->as.array.elem_type);
-            }
+            Type *elem_type = iter_type->kind == TYPE_ARRAY
+                ? type_clone(iter_type->as.array.elem_type)
+                : type_any();
             type_env_define(tc->env, node->as.for_stmt.var, elem_type, false);
             if (node->as.for_stmt.index_var) {
                 type_env_define(tc->env, node->as.for_stmt.index_var, type_int(), false);
@@ -915,7 +921,7 @@ static void check_stmt(TypeChecker *tc, AstNode *node) {
 
     case NODE_RETURN:
         if (node->as.return_stmt.value) {
-            check_expr(tc, node->as.return_stmt.value);
+            type_free(check_expr(tc, node->as.return_stmt.value));
         }
         break;
 
@@ -926,7 +932,7 @@ static void check_stmt(TypeChecker *tc, AstNode *node) {
         break;
 
     case NODE_EXPR_STMT:
-        check_expr(tc, node->as.return_stmt.value);
+        type_free(check_expr(tc, node->as.return_stmt.value));
         break;
 
     case NODE_BREAK:
@@ -9,6 +9,7 @@
 
 #include "runtime/block.h"
 #include "runtime/mailbox.h"
+#include "runtime/scheduler.h"
 #include "runtime/supervisor.h"
 #include "runtime/telemetry.h"
 #include "debug/log.h"
@@ -36,14 +37,17 @@ bool block_send(Block *target, Pid sender, Value *value) {
 
     /*
      * Message passing with COW optimization:
-     * - Immutable types: share directly with refcounting
+     * - Immutable types and frozen trees: share directly with refcounting
      * - Mutable types (array, map): COW sharing
+     * - Large bytes: borrow one off-heap buffer
      * - Unsafe types (closure): deep copy
      */
     Value *msg_value;
 
     if (!value) {
         msg_value = value_nil();
+    } else if (value->flags & VALUE_IMMUTABLE) {
+        msg_value = value_retain(value);
     } else {
         switch (value->type) {
         case VAL_NIL:
@@ -63,6 +67,10 @@ bool block_send(Block *target, Pid sender, Value *value) {
             break;
 
         case VAL_BYTES:
+            /* Rehoming storage other holders can see would race them */
+            if (!value_needs_cow(value)) {
+                bytes_share(value);
+            }
             msg_value = value_copy(value);
             break;
 
@@ -88,6 +96,18 @@ bool block_send(Block *target, Pid sender, Value *value) {
 
     atomic_fetch_add(&target->counters.messages_received, 1);
 
+    /*
+     * Wake a parked receiver directly so the scheduler never has to scan
+     * for waiting blocks with mail. scheduler_wake_block() only enqueues on
+     * a successful WAITING->RUNNABLE CAS, so concurrent senders and timers
+     * cannot double-enqueue. A receiver that is still running re-checks its
+     * mailbox in block_park.
+     */
+    if (atomic_load(&target->state) == BLOCK_WAITING &&
+        target->vm && target->vm->scheduler) {
+        scheduler_wake_block((Scheduler *)target->vm->scheduler, target);
+    }
+
     return true;
 }
 
@@ -96,6 +116,11 @@ Message *block_receive(Block *block) {
     return mailbox_pop(&block->mailbox);
 }
 
+size_t block_receive_batch(Block *block, Message **out, size_t max) {
+    if (!block) return 0;
+    return mailbox_pop_batch(&block->mailbox, out, max);
+}
+
 bool block_has_messages(const Block *block) {
     return block && !mailbox_empty(&block->mailbox);
 }
@@ -133,6 +158,7 @@ Block *block_new(Pid pid, const char *name, const BlockLimits *limits) {
     }
 
     block->code = NULL;
+    block->regvm = NULL;
 
     mailbox_init(&block->mailbox);
 
@@ -164,17 +190,25 @@ Block *block_new(Pid pid, const char *name, const BlockLimits *limits) {
 
     block->next = NULL;
     block->prev = NULL;
+    block->inbox_next = NULL;
+    block->retire_epoch = 0;
+    atomic_store(&block->exit_signal, NULL);
 
     block->pending_timer = NULL;
+    block->timer_wheel = NULL;
     block->timeout_fired = false;
+    block->wait_for_mail = false;
 
     block->save_queue_head = NULL;
     block->save_queue_tail = NULL;
+    block->save_scan_mark = NULL;
+    block->save_scan_pattern = NULL;
 
     block->tracer = NULL;
 
     block->module_name = NULL;
     block->pending_upgrade = false;
+    block->retain_on_exit = false;
 
     block->vm->block = block;
 
@@ -184,6 +218,10 @@ Block *block_new(Pid pid, const char *name, const BlockLimits *limits) {
 void block_free(Block *block) {
     if (!block) return;
 
+    if (block->regvm) {
+        regvm_free(block->regvm);
+    }
+
     if (block->vm) {
         vm_free(block->vm);
     }
@@ -221,6 +259,7 @@ void block_free(Block *block) {
     free((void *)block->name);
 
     free((void *)block->u.exit.exit_reason);
+    free(atomic_load(&block->exit_signal));
 
     free(block);
 }
@@ -235,8 +274,60 @@ bool block_load(Block *block, Bytecode *code) {
     return true;
 }
 
+bool block_load_reg(Block *block, RegChunk *program, RegChunk *entry) {
+    if (!block || !program || !entry) return false;
+
+    if (!block->regvm) {
+        block->regvm = regvm_new();
+        if (!block->regvm) return false;
+    }
+    block->regvm->block = block;
+    block->regvm->stack_vm = block->vm;
+
+    if (!regvm_load(block->regvm, program, entry)) return false;
+    atomic_store(&block->state, BLOCK_RUNNABLE);
+
+    return true;
+}
+
 /* Execution */
 
+static BlockRunResult block_run_reg(Block *block) {
+    RegVM *regvm = block->regvm;
+    regvm->scheduler = block->vm->scheduler;
+    regvm->reduction_limit = block->limits.max_reductions;
+    regvm->reductions = 0;
+
+    RegVMResult result = regvm_resume(regvm);
+
+    /* Workers read the slice's reductions from the stack VM */
+    block->vm->reductions = regvm->reductions;
+    block->counters.reductions += regvm->reductions;
+
+    switch (result) {
+    case REGVM_OK:
+        atomic_store(&block->state, BLOCK_DEAD);
+        block->u.exit.exit_code = 0;
+        return BLOCK_RUN_OK;
+
+    case REGVM_HALT:
+        atomic_store(&block->state, BLOCK_DEAD);
+        block->u.exit.exit_code = 0;
+        return BLOCK_RUN_HALTED;
+
+    case REGVM_YIELD:
+        atomic_store(&block->state, BLOCK_RUNNABLE);
+        return BLOCK_RUN_YIELD;
+
+    case REGVM_WAITING:
+        return BLOCK_RUN_WAITING;
+
+    default:
+        block_crash(block, regvm_error(regvm) ? regvm_error(regvm) : "unknown VM error");
+        return BLOCK_RUN_ERROR;
+    }
+}
+
 BlockRunResult block_run(Block *block) {
     if (!block) return BLOCK_RUN_ERROR;
 
@@ -253,6 +344,10 @@ BlockRunResult block_run(Block *block) {
         return BLOCK_RUN_ERROR;
     }
 
+    if (block->regvm) {
+        return block_run_reg(block);
+    }
+
     block->vm->reduction_limit = block->limits.max_reductions;
     block->vm->reductions = 0;
 
@@ -297,6 +392,27 @@ BlockRunResult block_run(Block *block) {
     }
 }
 
+bool block_park(Block *block) {
+    if (!block) return true;
+
+    /* Once WAITING the block may already be running elsewhere; only atomics
+     * are safe to read after the transition */
+    bool wait_for_mail = block->wait_for_mail;
+    if (!block_try_transition(block, BLOCK_RUNNING, BLOCK_WAITING)) {
+        return true;
+    }
+
+    /* Senders, timers and exit signals that came in while the block was
+     * still running saw it RUNNING and left the wakeup to us. The fence pairs
+     * with the sender's count increment before it loads our state. A stale
+     * read here at worst wakes the block once more to retry its wait. */
+    atomic_thread_fence(memory_order_seq_cst);
+    bool woken = atomic_load(&block->timeout_fired) ||
+                 atomic_load(&block->exit_signal) != NULL ||
+                 (wait_for_mail && block_has_messages(block));
+    return !(woken && block_try_transition(block, BLOCK_WAITING, BLOCK_RUNNABLE));
+}
+
 BlockState block_state(const Block *block) {
     return block ? atomic_load(&block->state) : BLOCK_DEAD;
 }
@@ -352,6 +468,13 @@ bool block_link(Block *block, Pid other) {
 
     pthread_mutex_lock(&block->link_mutex);
 
+    /* Checked under the lock: a dying block snapshots its links under the
+     * same lock after going DEAD, so a late link is refused, never lost */
+    if (atomic_load(&block->state) == BLOCK_DEAD) {
+        pthread_mutex_unlock(&block->link_mutex);
+        return false;
+    }
+
     for (size_t i = 0; i < block->link_count; i++) {
         if (block->links[i] == other) {
             pthread_mutex_unlock(&block->link_mutex);
@@ -397,7 +520,7 @@ const Pid *block_get_links(const Block *block, size_t *count) {
         return NULL;
     }
     /* Note: Caller must ensure block is not concurrently modified,
-     * or use block_get_links_copy() for a safe snapshot */
+     * or snapshot the array under link_mutex */
     if (count) *count = block->link_count;
     return block->links;
 }
@@ -453,6 +576,11 @@ bool block_add_monitored_by(Block *block, Pid monitor_pid) {
 
     pthread_mutex_lock(&block->link_mutex);
 
+    if (atomic_load(&block->state) == BLOCK_DEAD) {
+        pthread_mutex_unlock(&block->link_mutex);
+        return false;
+    }
+
     for (size_t i = 0; i < block->monitored_by_count; i++) {
         if (block->monitored_by[i] == monitor_pid) {
             pthread_mutex_unlock(&block->link_mutex);
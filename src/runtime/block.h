@@ -22,6 +22,7 @@
 #include "runtime/timer.h"
 #include "vm/bytecode.h"
 #include "vm/gc.h"
+#include "vm/regvm.h"
 #include "vm/value.h"
 #include "vm/vm.h"
 
@@ -55,6 +56,7 @@ typedef struct BlockCounters {
     _Atomic(size_t) messages_received;  /* Atomic: updated by multiple sender threads */
     size_t gc_collections;
     size_t gc_bytes_collected;
+    size_t match_tests;      /* Messages tested against receive_match patterns */
 } BlockCounters;
 
 /* Block Structure */
@@ -81,6 +83,7 @@ typedef struct Block {
     } u;
 
     VM *vm;
+    RegVM *regvm;        /* Set when the block runs register code; vm then runs its stubs */
     Heap *heap;
     Bytecode *code;
 
@@ -110,17 +113,26 @@ typedef struct Block {
 
     struct Block *next;
     struct Block *prev;
+    struct Block *inbox_next;  /* Link in a worker's injection inbox */
+    uint64_t retire_epoch;     /* Reclamation epoch once retired by a worker */
+
+    _Atomic(char *) exit_signal;  /* Pending crash reason sent by another thread */
 
     TimerEntry *pending_timer;
-    bool timeout_fired;
+    TimerWheel *timer_wheel;      /* Wheel that owns pending_timer */
+    _Atomic(bool) timeout_fired;  /* Set by the timer wheel, possibly from another worker */
+    bool wait_for_mail;           /* Set with VM_WAITING: a message, not just the timer, ends the wait */
 
     Message *save_queue_head;
     Message *save_queue_tail;
+    Message *save_scan_mark;        /* Last saved message tested against the pending pattern */
+    const Value *save_scan_pattern; /* receive_match pattern still waiting on the stack */
 
     Tracer *tracer;
 
     char *module_name;
     bool pending_upgrade;
+    bool retain_on_exit;  /* Keep registered after exit so the spawner can read the result */
 } Block;
 
 /* Lifecycle */
@@ -129,6 +141,7 @@ BlockLimits block_limits_default(void);
 Block *block_new(Pid pid, const char *name, const BlockLimits *limits);
 void block_free(Block *block);
 bool block_load(Block *block, Bytecode *code);
+bool block_load_reg(Block *block, RegChunk *program, RegChunk *entry);
 
 /* Execution */
 
@@ -141,6 +154,13 @@ typedef enum BlockRunResult {
 } BlockRunResult;
 
 BlockRunResult block_run(Block *block);
+
+/* Park a block whose slice returned BLOCK_RUN_WAITING. Call it on the thread
+ * that ran the block once it is done touching it: as soon as the block is
+ * WAITING a send or timer may requeue it on another worker. Returns false
+ * if a wakeup arrived during the slice; the block is then RUNNABLE again
+ * and the caller must requeue it. */
+bool block_park(Block *block);
 BlockState block_state(const Block *block);
 void block_set_state(Block *block, BlockState state);
 bool block_try_transition(Block *block, BlockState from, BlockState to);
@@ -170,6 +190,7 @@ const Pid *block_get_monitors(const Block *block, size_t *count);
 
 bool block_send(Block *target, Pid sender, Value *value);
 Message *block_receive(Block *block);
+size_t block_receive_batch(Block *block, Message **out, size_t max);
 bool block_has_messages(const Block *block);
 
 /* Termination */
@@ -59,8 +59,10 @@ Checkpoint *checkpoint_create(Block *block) {
     serial_buffer_init(&cp->globals_state);
     serial_buffer_init(&cp->mailbox_state);
 
-    if (block->vm && block->vm->globals) {
-        SerializeResult res = serialize_value(block->vm->globals, &cp->globals_state);
+    if (block->vm) {
+        Value *globals = vm_globals_snapshot(block->vm);
+        SerializeResult res = serialize_value(globals, &cp->globals_state);
+        value_free(globals);
         if (res != SERIALIZE_OK) {
             LOG_ERROR("checkpoint: failed to serialize globals for block %lu", block->pid);
             checkpoint_free(cp);
@@ -117,10 +119,9 @@ Pid checkpoint_restore(Checkpoint *cp, Scheduler *sched) {
         SerializeResult res = SERIALIZE_OK;
         Value *globals = deserialize_value(&cp->globals_state, &res);
         if (globals && res == SERIALIZE_OK && block->vm) {
-            if (block->vm->globals) {
-                value_free(block->vm->globals);
-            }
-            block->vm->globals = globals;
+            vm_restore_globals(block->vm, globals);
+        } else {
+            value_free(globals);
         }
     }
 
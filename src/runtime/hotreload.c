@@ -726,15 +726,22 @@ void module_apply_upgrade_block(Block *block) {
         return;
     }
 
+    /* Globals move between versions by name; slot layouts may differ */
     Value *old_state = NULL;
     if (block->vm) {
-        old_state = block->vm->globals;
+        old_state = vm_globals_snapshot(block->vm);
     }
 
     Value *new_state = NULL;
     bool success = module_apply_upgrade(g_module_registry, block->module_name,
                                          block->pid, old_state, &new_state);
 
+    /* Migration hands back either old_state itself or a fresh map */
+    Value *state = (success && new_state) ? new_state : old_state;
+    if (state != old_state) {
+        value_free(old_state);
+    }
+
     if (success) {
         ModuleVersion *new_ver = module_get(g_module_registry, block->module_name);
         if (new_ver && new_ver->code) {
@@ -742,14 +749,13 @@ void module_apply_upgrade_block(Block *block) {
 
             if (block->vm) {
                 vm_load(block->vm, new_ver->code);
-
-                if (new_state && new_state != old_state) {
-                    block->vm->globals = new_state;
-                }
+                vm_restore_globals(block->vm, state);
+                state = NULL;
             }
         }
         module_version_release(new_ver);
     }
+    value_free(state);
 
     block->pending_upgrade = false;
 }
@@ -13,16 +13,22 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "runtime/mailbox.h"
+#include "util/worker_alloc.h"
 #include "vm/value.h"
 #include "debug/log.h"
 
 #include <stdlib.h>
 #include <time.h>
 
-/* Message Operations */
+/* Message Operations
+ *
+ * Messages come from the sending worker's pool rather than malloc. The
+ * receiver frees them back through that pool's remote list, so a burst of
+ * sends costs no global allocator traffic and drains walk a few chunks.
+ */
 
 Message *message_new(Pid sender, Value *value) {
-    Message *msg = malloc(sizeof(Message));
+    Message *msg = worker_alloc(sizeof(Message));
     if (!msg) {
         LOG_ERROR("mailbox: failed to allocate message from sender %lu", (unsigned long)sender);
         return NULL;
@@ -40,7 +46,7 @@ void message_free(Message *msg) {
     if (msg->value) {
         value_free(msg->value);
     }
-    free(msg);
+    worker_alloc_release(msg);
 }
 
 /* Lock-Free MPSC Queue */
@@ -97,11 +103,13 @@ void mailbox_free(Mailbox *mailbox) {
 bool mailbox_push(Mailbox *mailbox, Message *msg, size_t max_size) {
     if (!mailbox || !msg) return false;
 
-    if (max_size > 0) {
-        size_t current = atomic_load_explicit(&mailbox->count, memory_order_relaxed);
-        if (current >= max_size) {
-            return false;
-        }
+    /* Count the message before linking it: once linked the consumer may pop
+     * it, and a decrement ahead of our increment would wrap the count. The
+     * reservation also keeps racing senders from overshooting max_size. */
+    size_t current = atomic_fetch_add_explicit(&mailbox->count, 1, memory_order_seq_cst);
+    if (max_size > 0 && current >= max_size) {
+        atomic_fetch_sub_explicit(&mailbox->count, 1, memory_order_relaxed);
+        return false;
     }
 
     atomic_store_explicit(&msg->next, NULL, memory_order_release);
@@ -110,8 +118,6 @@ bool mailbox_push(Mailbox *mailbox, Message *msg, size_t max_size) {
 
     atomic_store_explicit(&prev->next, msg, memory_order_release);
 
-    atomic_fetch_add_explicit(&mailbox->count, 1, memory_order_relaxed);
-
     return true;
 }
 
@@ -187,6 +193,39 @@ Message *mailbox_pop(Mailbox *mailbox) {
     return NULL;
 }
 
+/* Messages with a successor are fully linked and can be unhooked without
+ * touching the tail. Only the last one needs mailbox_pop's stub swap. */
+size_t mailbox_pop_batch(Mailbox *mailbox, Message **out, size_t max) {
+    if (!mailbox || !out) return 0;
+
+    size_t taken = 0;
+    Message *head = atomic_load_explicit(&mailbox->head, memory_order_relaxed);
+
+    while (taken < max) {
+        Message *next = atomic_load_explicit(&head->next, memory_order_acquire);
+        if (next == NULL) break;
+
+        if (head != &mailbox->stub) {
+            atomic_store_explicit(&head->next, NULL, memory_order_relaxed);
+            out[taken++] = head;
+        }
+        head = next;
+    }
+
+    atomic_store_explicit(&mailbox->head, head, memory_order_relaxed);
+    if (taken > 0) {
+        atomic_fetch_sub_explicit(&mailbox->count, taken, memory_order_relaxed);
+    }
+
+    while (taken < max) {
+        Message *msg = mailbox_pop(mailbox);
+        if (!msg) break;
+        out[taken++] = msg;
+    }
+
+    return taken;
+}
+
 bool mailbox_empty(const Mailbox *mailbox) {
     if (!mailbox) return true;
 
@@ -283,10 +322,10 @@ SendResult mailbox_push_ex(Mailbox *mailbox, Message *msg) {
         }
     }
 
+    atomic_fetch_add_explicit(&mailbox->count, 1, memory_order_seq_cst);
     atomic_store_explicit(&msg->next, NULL, memory_order_release);
     Message *prev = atomic_exchange_explicit(&mailbox->tail, msg, memory_order_acq_rel);
     atomic_store_explicit(&prev->next, msg, memory_order_release);
-    atomic_fetch_add_explicit(&mailbox->count, 1, memory_order_relaxed);
     atomic_fetch_add_explicit(&mailbox->current_bytes, msg_size, memory_order_relaxed);
     atomic_fetch_add_explicit(&mailbox->total_received, 1, memory_order_relaxed);
 
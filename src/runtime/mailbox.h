@@ -26,6 +26,18 @@ typedef uint64_t Pid;
 
 #define PID_INVALID 0
 
+/* A PID names its node in bits 32-47 (0 = not distributed) and the block
+ * within that node in the low 32 bits, so PIDs still fit a NaN-boxed
+ * payload and can be sent to other nodes as plain values. */
+#define PID_NODE_SHIFT 32
+#define PID_NODE_MAX   0xFFFF
+#define PID_LOCAL_MASK 0xFFFFFFFFULL
+
+#define pid_node(pid)  ((uint16_t)(((pid) >> PID_NODE_SHIFT) & PID_NODE_MAX))
+#define pid_local(pid) ((pid) & PID_LOCAL_MASK)
+#define pid_make(node, local) \
+    (((Pid)(node) << PID_NODE_SHIFT) | ((Pid)(local) & PID_LOCAL_MASK))
+
 /* Overflow Policies */
 
 typedef enum OverflowPolicy {
@@ -74,6 +86,8 @@ typedef struct Mailbox {
 
 /* Message Operations */
 
+/* Allocated from the calling worker's pool when there is one; release
+ * with message_free from any thread */
 Message *message_new(Pid sender, Value *value);
 void message_free(Message *msg);
 
@@ -84,6 +98,10 @@ void mailbox_free(Mailbox *mailbox);
 bool mailbox_push(Mailbox *mailbox, Message *msg, size_t max_size);
 SendResult mailbox_push_ex(Mailbox *mailbox, Message *msg);
 Message *mailbox_pop(Mailbox *mailbox);
+
+/* Pop up to max messages into out in arrival order, returning how many
+ * were taken. The count is adjusted once for the whole batch. */
+size_t mailbox_pop_batch(Mailbox *mailbox, Message **out, size_t max);
 bool mailbox_empty(const Mailbox *mailbox);
 size_t mailbox_count(const Mailbox *mailbox);
 
@@ -6,6 +6,7 @@
  */
 
 #define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE  /* For usleep */
 
 #include "runtime/scheduler.h"
 #include "runtime/worker.h"
@@ -164,7 +165,6 @@ static Block *registry_lookup(BlockRegistry *reg, Pid pid) {
     return NULL;
 }
 
-__attribute__((unused))
 static void registry_remove(BlockRegistry *reg, Pid pid) {
     size_t shard_idx = registry_shard_index(pid);
     RegistryShard *shard = &reg->shards[shard_idx];
@@ -217,7 +217,6 @@ static void runqueue_init(RunQueue *queue) {
     queue->head = NULL;
     queue->tail = NULL;
     queue->count = 0;
-    pthread_mutex_init(&queue->lock, NULL);
 }
 
 static void runqueue_push(RunQueue *queue, Block *block) {
@@ -274,15 +273,11 @@ static void runqueue_remove(RunQueue *queue, Block *block) {
     runqueue_remove_internal(queue, block);
 }
 
-/* Thread-safe version for multi-threaded scheduler */
+/* In multi-threaded mode blocks sit in worker deques and inboxes, never in
+ * the run queue; workers drop dead blocks when they pop them */
 static void scheduler_runqueue_remove(Scheduler *scheduler, Block *block) {
-    if (scheduler->worker_count > 0) {
-        pthread_mutex_lock(&scheduler->run_queue.lock);
-        runqueue_remove_internal(&scheduler->run_queue, block);
-        pthread_mutex_unlock(&scheduler->run_queue.lock);
-    } else {
-        runqueue_remove_internal(&scheduler->run_queue, block);
-    }
+    if (scheduler->worker_count > 0) return;
+    runqueue_remove_internal(&scheduler->run_queue, block);
 }
 
 /* Scheduler Lifecycle */
@@ -303,13 +298,23 @@ Scheduler *scheduler_new(const SchedulerConfig *config) {
 
     runqueue_init(&scheduler->run_queue);
 
+    scheduler->timers = timer_wheel_new(NULL);
+    if (!scheduler->timers) {
+        registry_free(&scheduler->registry);
+        free(scheduler);
+        return NULL;
+    }
+
     scheduler->workers = NULL;
     scheduler->worker_count = 0;
     atomic_store(&scheduler->next_worker, 0);
+    scheduler->idle_workers = NULL;
+    scheduler->idle_words = 0;
 
     if (scheduler->config.num_workers > 0) {
         scheduler->workers = malloc(sizeof(Worker *) * scheduler->config.num_workers);
         if (!scheduler->workers) {
+            timer_wheel_free(scheduler->timers);
             registry_free(&scheduler->registry);
             free(scheduler);
             return NULL;
@@ -322,19 +327,40 @@ Scheduler *scheduler_new(const SchedulerConfig *config) {
                     worker_free(scheduler->workers[j]);
                 }
                 free(scheduler->workers);
+                timer_wheel_free(scheduler->timers);
                 registry_free(&scheduler->registry);
                 free(scheduler);
                 return NULL;
             }
         }
         scheduler->worker_count = scheduler->config.num_workers;
+
+        scheduler->idle_words = (scheduler->worker_count + 63) / 64;
+        scheduler->idle_workers = calloc(scheduler->idle_words, sizeof(*scheduler->idle_workers));
+        if (!scheduler->idle_workers) {
+            for (size_t i = 0; i < scheduler->worker_count; i++) {
+                worker_free(scheduler->workers[i]);
+            }
+            free(scheduler->workers);
+            timer_wheel_free(scheduler->timers);
+            registry_free(&scheduler->registry);
+            free(scheduler);
+            return NULL;
+        }
     }
+    atomic_store(&scheduler->spinning_workers, 0);
 
     atomic_store(&scheduler->running, false);
+    atomic_store(&scheduler->blocked, false);
     scheduler->current = NULL;
 
     pthread_mutex_init(&scheduler->block_mutex, NULL);
 
+    scheduler->node_number = 0;
+    scheduler->remote_send = NULL;
+    scheduler->remote_signal = NULL;
+    scheduler->remote_ctx = NULL;
+
     scheduler->primitives = NULL;
     scheduler->groups = NULL;
     scheduler->tracer = NULL;
@@ -344,6 +370,9 @@ Scheduler *scheduler_new(const SchedulerConfig *config) {
     atomic_store(&scheduler->total_reductions, 0);
     atomic_store(&scheduler->context_switches, 0);
     atomic_store(&scheduler->blocks_in_flight, 0);
+    atomic_store(&scheduler->total_retired, 0);
+    atomic_store(&scheduler->reclaim_epoch, 1);
+    atomic_store(&scheduler->foreign_readers, 0);
 
     scheduler->start_time_ms = timer_current_time_ms();
 
@@ -373,10 +402,12 @@ void scheduler_free(Scheduler *scheduler) {
         }
         free(scheduler->workers);
     }
+    free(scheduler->idle_workers);
 
     registry_free(&scheduler->registry);
 
-    pthread_mutex_destroy(&scheduler->run_queue.lock);
+    timer_wheel_free(scheduler->timers);
+
 
     if (scheduler->groups) {
         procgroup_registry_free(scheduler->groups);
@@ -425,22 +456,25 @@ Pid scheduler_spawn(Scheduler *scheduler, Bytecode *code, const char *name) {
     return scheduler_spawn_ex(scheduler, code, name, CAP_NONE, NULL);
 }
 
-Pid scheduler_spawn_ex(Scheduler *scheduler, Bytecode *code, const char *name,
-                       CapabilitySet caps, const BlockLimits *limits) {
-    if (!scheduler || !code) return PID_INVALID;
-
+static Block *spawn_new_block(Scheduler *scheduler, const char *name,
+                              CapabilitySet caps, const BlockLimits *limits) {
     Pid pid = atomic_fetch_add(&scheduler->next_pid, 1);
 
+    BlockLimits default_limits;
+    if (!limits && scheduler->config.default_reductions > 0) {
+        default_limits = block_limits_default();
+        default_limits.max_reductions = scheduler->config.default_reductions;
+        limits = &default_limits;
+    }
+
     Block *block = block_new(pid, name, limits);
-    if (!block) return PID_INVALID;
+    if (!block) return NULL;
 
     block->capabilities = caps;
+    return block;
+}
 
-    if (!block_load(block, code)) {
-        block_free(block);
-        return PID_INVALID;
-    }
-
+static Pid spawn_start_block(Scheduler *scheduler, Block *block, Bytecode *code) {
     if (!register_block(scheduler, block)) {
         block_free(block);
         return PID_INVALID;
@@ -448,10 +482,20 @@ Pid scheduler_spawn_ex(Scheduler *scheduler, Bytecode *code, const char *name,
 
     block->vm->scheduler = scheduler;
 
-    if (scheduler->primitives) {
+    if (scheduler->primitives && code) {
         tools_register_from_bytecode(&scheduler->primitives->tools, code, block->vm);
     }
 
+    /* Count the spawn before a worker can see the block, so a fast exit
+     * never makes terminated catch up with spawned while others still live */
+    atomic_fetch_add(&scheduler->total_spawned, 1);
+
+    /* Once enqueued, a worker may run, finish and free the block before
+     * this thread gets another look at it */
+    Pid pid = block->pid;
+    LOG_DEBUG("spawned block: pid=%lu, name=%s, caps=0x%x",
+              pid, block->name ? block->name : "(none)", block->capabilities);
+
     if (scheduler->worker_count > 0) {
         size_t worker_idx = atomic_fetch_add(&scheduler->next_worker, 1) %
                             scheduler->worker_count;
@@ -460,12 +504,39 @@ Pid scheduler_spawn_ex(Scheduler *scheduler, Bytecode *code, const char *name,
         scheduler_enqueue(scheduler, block);
     }
 
-    atomic_fetch_add(&scheduler->total_spawned, 1);
+    return pid;
+}
 
-    LOG_DEBUG("spawned block: pid=%lu, name=%s, caps=0x%x",
-              pid, name ? name : "(none)", caps);
+Pid scheduler_spawn_ex(Scheduler *scheduler, Bytecode *code, const char *name,
+                       CapabilitySet caps, const BlockLimits *limits) {
+    if (!scheduler || !code) return PID_INVALID;
 
-    return pid;
+    Block *block = spawn_new_block(scheduler, name, caps, limits);
+    if (!block) return PID_INVALID;
+
+    if (!block_load(block, code)) {
+        block_free(block);
+        return PID_INVALID;
+    }
+
+    return spawn_start_block(scheduler, block, code);
+}
+
+Pid scheduler_spawn_reg(Scheduler *scheduler, RegChunk *program, RegChunk *entry,
+                        const char *name, CapabilitySet caps,
+                        const BlockLimits *limits) {
+    if (!scheduler || !program || !entry) return PID_INVALID;
+
+    Block *block = spawn_new_block(scheduler, name, caps, limits);
+    if (!block) return PID_INVALID;
+
+    if (!block_load_reg(block, program, entry)) {
+        block_free(block);
+        return PID_INVALID;
+    }
+
+    /* Tool functions are register code; the stack-side registry cannot call them */
+    return spawn_start_block(scheduler, block, NULL);
 }
 
 Block *scheduler_get_block(Scheduler *scheduler, Pid pid) {
@@ -473,21 +544,52 @@ Block *scheduler_get_block(Scheduler *scheduler, Pid pid) {
     return registry_lookup(&scheduler->registry, pid);
 }
 
+/* Worker threads are covered by their reclamation epoch; any other
+ * thread pins dead blocks while it holds pointers from the registry */
+static bool scheduler_pin(Scheduler *scheduler) {
+    Worker *self = worker_current();
+    bool foreign = !self || self->scheduler != scheduler;
+    if (foreign) atomic_fetch_add(&scheduler->foreign_readers, 1);
+    return foreign;
+}
+
+static void scheduler_unpin(Scheduler *scheduler, bool foreign) {
+    if (foreign) atomic_fetch_sub(&scheduler->foreign_readers, 1);
+}
+
+bool scheduler_send(Scheduler *scheduler, Pid target, Pid sender, Value *value) {
+    if (!scheduler) return false;
+
+    if (scheduler_pid_is_remote(scheduler, target)) {
+        return scheduler->remote_send(scheduler->remote_ctx, target, sender, value);
+    }
+
+    bool foreign = scheduler_pin(scheduler);
+    Block *block = scheduler_get_block(scheduler, target);
+    bool sent = block && block_send(block, sender, value);
+    scheduler_unpin(scheduler, foreign);
+    return sent;
+}
+
 void scheduler_kill(Scheduler *scheduler, Pid pid) {
     Block *block = scheduler_get_block(scheduler, pid);
     if (!block) return;
 
+    /* A worker may be running the block; let it terminate there */
+    if (scheduler->worker_count > 0) {
+        scheduler_signal_exit(scheduler, block, "killed");
+        return;
+    }
+
     if (block_is_alive(block)) {
+        /* block_crash marks the block DEAD, so look before it does */
+        bool queued = atomic_load(&block->state) == BLOCK_RUNNABLE;
         block_crash(block, "killed");
 
-        if (atomic_load(&block->state) == BLOCK_RUNNABLE) {
+        if (queued) {
             scheduler_runqueue_remove(scheduler, block);
         }
-
-        scheduler->total_terminated++;
-
-        /* Propagate exit to linked blocks */
-        scheduler_propagate_exit(scheduler, block);
+        scheduler_terminate_block(scheduler, block);
     }
 }
 
@@ -529,11 +631,6 @@ void scheduler_propagate_exit(Scheduler *scheduler, Block *exited_block) {
                 map_set(exit_msg, "reason", value_string(exited_block->u.exit.exit_reason));
             }
             block_send(linked_block, exited_pid, exit_msg);
-
-            /* Wake the block if it was waiting */
-            if (atomic_load(&linked_block->state) == BLOCK_WAITING) {
-                scheduler_wake_block(scheduler, linked_block);
-            }
         } else if (abnormal) {
             /* Crash linked block if exit was abnormal */
             char reason[256];
@@ -552,20 +649,205 @@ void scheduler_propagate_exit(Scheduler *scheduler, Block *exited_block) {
     }
 }
 
+/* Termination
+ *
+ * Every block that stops running, whether it returned, halted, crashed or
+ * was killed, goes through scheduler_terminate_block exactly once, on the
+ * thread that observed the exit. It counts the exit, notifies links and
+ * monitors, and in multi-threaded mode unregisters the block and hands it
+ * to the worker for deferred freeing.
+ *
+ * Single-threaded mode crashes linked blocks in place and keeps dead
+ * blocks registered so callers can inspect them after a run. Worker
+ * threads cannot touch a block another worker may be running, so they
+ * post an exit signal instead and let whichever worker next picks the
+ * block up terminate it. */
+
+static Pid *pids_dup(const Pid *pids, uint32_t count, size_t *out_count) {
+    Pid *copy = count ? malloc(sizeof(Pid) * count) : NULL;
+    if (copy) memcpy(copy, pids, sizeof(Pid) * count);
+    *out_count = copy ? count : 0;
+    return copy;
+}
+
+bool scheduler_signal_exit(Scheduler *scheduler, Block *block, const char *reason) {
+    if (!scheduler || !block || !block_is_alive(block)) return false;
+
+    char *copy = strdup(reason ? reason : "killed");
+    if (!copy) return false;
+
+    char *expected = NULL;
+    if (!atomic_compare_exchange_strong(&block->exit_signal, &expected, copy)) {
+        free(copy);  /* First signal wins */
+        return false;
+    }
+
+    /* A parked block is requeued here; a running one sees the signal when
+     * its worker next picks it up */
+    scheduler_wake_block(scheduler, block);
+    return true;
+}
+
+bool scheduler_take_exit_signal(Scheduler *scheduler, Block *block) {
+    char *reason = atomic_exchange(&block->exit_signal, NULL);
+    if (!reason) return false;
+
+    if (block_is_alive(block)) {
+        block_crash(block, reason);
+        scheduler_terminate_block(scheduler, block);
+    }
+    free(reason);
+    return true;
+}
+
+static void scheduler_crash_linked(Scheduler *scheduler, Block *linked, Pid exited) {
+    char reason[64];
+    snprintf(reason, sizeof(reason), "linked process %llu crashed",
+             (unsigned long long)exited);
+
+    if (scheduler->worker_count > 0) {
+        scheduler_signal_exit(scheduler, linked, reason);
+        return;
+    }
+
+    bool queued = atomic_load(&linked->state) == BLOCK_RUNNABLE;
+    block_crash(linked, reason);
+    if (queued) {
+        scheduler_runqueue_remove(scheduler, linked);
+    }
+    scheduler_terminate_block(scheduler, linked);
+}
+
+/* Tell a block that a block linked to it exited */
+static void notify_linked(Scheduler *scheduler, Block *linked, Pid from,
+                          const char *reason, int code, bool abnormal) {
+    if (block_has_cap(linked, CAP_TRAP_EXIT)) {
+        Value *exit_msg = value_map();
+        exit_msg = map_set(exit_msg, "type", value_string("exit"));
+        exit_msg = map_set(exit_msg, "pid", value_pid(from));
+        exit_msg = map_set(exit_msg, "reason", value_string(reason));
+        exit_msg = map_set(exit_msg, "code", value_int(code));
+
+        block_send(linked, from, exit_msg);
+        value_free(exit_msg);
+    } else if (abnormal) {
+        scheduler_crash_linked(scheduler, linked, from);
+    }
+}
+
+/* Tell a block that a block it monitored exited */
+static void notify_monitor(Block *monitor, Pid from, const char *reason, int code) {
+    Value *down_msg = value_map();
+    down_msg = map_set(down_msg, "type", value_string("down"));
+    down_msg = map_set(down_msg, "pid", value_pid(from));
+    down_msg = map_set(down_msg, "reason", value_string(reason));
+    down_msg = map_set(down_msg, "code", value_int(code));
+
+    block_send(monitor, from, down_msg);
+    value_free(down_msg);
+}
+
+void scheduler_terminate_block(Scheduler *scheduler, Block *block) {
+    if (!scheduler || !block) return;
+
+    atomic_fetch_add(&scheduler->total_terminated, 1);
+    scheduler_cancel_timer(scheduler, block);
+
+    Pid pid = block->pid;
+    int code = block->u.exit.exit_code;
+    bool abnormal = code != 0 || block->u.exit.exit_reason != NULL;
+    const char *reason = abnormal
+        ? (block->u.exit.exit_reason ? block->u.exit.exit_reason : "error")
+        : "normal";
+
+    /* The block is DEAD, so block_link and block_add_monitored_by refuse
+     * new entries and this snapshot is final */
+    size_t link_count, monitor_count, watcher_count;
+    pthread_mutex_lock(&block->link_mutex);
+    Pid *links = pids_dup(block->links, block->link_count, &link_count);
+    Pid *monitors = pids_dup(block->monitors, block->monitor_count, &monitor_count);
+    Pid *watchers = pids_dup(block->monitored_by, block->monitored_by_count,
+                             &watcher_count);
+    pthread_mutex_unlock(&block->link_mutex);
+
+    /* Notify linked blocks; remote ones decide on their own node */
+    for (size_t i = 0; i < link_count; i++) {
+        if (scheduler_pid_is_remote(scheduler, links[i])) {
+            scheduler_signal_remote(scheduler, REMOTE_EXIT, links[i], pid, reason, code);
+            continue;
+        }
+
+        Block *linked = scheduler_get_block(scheduler, links[i]);
+        if (!linked || !block_is_alive(linked)) continue;
+
+        /* Unlink first so a crash we cause cannot bounce back to us */
+        block_unlink(linked, pid);
+        notify_linked(scheduler, linked, pid, reason, code, abnormal);
+    }
+
+    /* Notify monitors */
+    for (size_t i = 0; i < watcher_count; i++) {
+        if (scheduler_pid_is_remote(scheduler, watchers[i])) {
+            scheduler_signal_remote(scheduler, REMOTE_DOWN, watchers[i], pid, reason, code);
+            continue;
+        }
+
+        Block *monitor = scheduler_get_block(scheduler, watchers[i]);
+        if (!monitor || !block_is_alive(monitor)) continue;
+
+        notify_monitor(monitor, pid, reason, code);
+        block_demonitor(monitor, pid);
+    }
+
+    /* Stop watching blocks we monitored, so they do not keep our pid */
+    for (size_t i = 0; i < monitor_count; i++) {
+        if (scheduler_pid_is_remote(scheduler, monitors[i])) {
+            scheduler_signal_remote(scheduler, REMOTE_DEMONITOR, monitors[i], pid, NULL, 0);
+            continue;
+        }
+
+        Block *target = scheduler_get_block(scheduler, monitors[i]);
+        if (target) {
+            block_remove_monitored_by(target, pid);
+        }
+    }
+
+    free(links);
+    free(monitors);
+    free(watchers);
+
+    Worker *self = worker_current();
+    if (self && self->scheduler == scheduler && !block->retain_on_exit) {
+        registry_remove(&scheduler->registry, pid);
+        atomic_fetch_add(&scheduler->total_retired, 1);
+        worker_retire(self, block);
+    }
+}
+
 Block *scheduler_current(Scheduler *scheduler) {
     return scheduler ? scheduler->current : NULL;
 }
 
 /* Execution */
 
+/* Route a block to a worker: the calling worker's own deque when we are
+ * on one, otherwise round-robin into a peer's injection inbox */
+static Worker *scheduler_pick_worker(Scheduler *scheduler) {
+    Worker *self = worker_current();
+    if (self && self->scheduler == scheduler) {
+        return self;
+    }
+    size_t worker_idx = atomic_fetch_add(&scheduler->next_worker, 1) %
+                        scheduler->worker_count;
+    return scheduler->workers[worker_idx];
+}
+
 void scheduler_enqueue(Scheduler *scheduler, Block *block) {
     if (!scheduler || !block) return;
 
     if (atomic_load(&block->state) == BLOCK_RUNNABLE) {
         if (scheduler->worker_count > 0) {
-            pthread_mutex_lock(&scheduler->run_queue.lock);
-            runqueue_push(&scheduler->run_queue, block);
-            pthread_mutex_unlock(&scheduler->run_queue.lock);
+            worker_enqueue(scheduler_pick_worker(scheduler), block);
         } else {
             runqueue_push(&scheduler->run_queue, block);
         }
@@ -574,13 +856,6 @@ void scheduler_enqueue(Scheduler *scheduler, Block *block) {
 
 Block *scheduler_dequeue(Scheduler *scheduler) {
     if (!scheduler) return NULL;
-
-    if (scheduler->worker_count > 0) {
-        pthread_mutex_lock(&scheduler->run_queue.lock);
-        Block *block = runqueue_pop(&scheduler->run_queue);
-        pthread_mutex_unlock(&scheduler->run_queue.lock);
-        return block;
-    }
     return runqueue_pop(&scheduler->run_queue);
 }
 
@@ -588,38 +863,37 @@ bool scheduler_queue_empty(const Scheduler *scheduler) {
     return !scheduler || scheduler->run_queue.count == 0;
 }
 
-typedef struct {
-    size_t waiting_count;
-    size_t waiting_with_messages;
-} WaitingBlocksInfo;
-
-static void check_waiting_callback(Block *block, void *ctx) {
-    WaitingBlocksInfo *info = (WaitingBlocksInfo *)ctx;
-    if (atomic_load(&block->state) == BLOCK_WAITING) {
-        info->waiting_count++;
-        if (block_has_messages(block)) {
-            info->waiting_with_messages++;
-        }
-    }
+/* Fire due timers; cheap when nothing is armed */
+static size_t scheduler_fire_timers(Scheduler *scheduler) {
+    if (timer_next_deadline(scheduler->timers) == 0) return 0;
+    return timer_run_expired(scheduler->timers, timer_current_time_ms());
 }
 
-static bool has_wakeable_waiting_blocks(Scheduler *scheduler) {
-    WaitingBlocksInfo info = {0, 0};
-    registry_iterate(&scheduler->registry, check_waiting_callback, &info);
-
-    if (info.waiting_with_messages > 0) {
-        return true;
+/* Idle until the earliest pending timer is due */
+static void scheduler_wait_for_timer(Scheduler *scheduler) {
+    uint64_t deadline = timer_next_deadline(scheduler->timers);
+    uint64_t now = timer_current_time_ms();
+    uint64_t wait_ms = scheduler->timers->tick_ms;
+    if (deadline > now && deadline - now < wait_ms) {
+        wait_ms = deadline - now;
     }
-
-    return false;
+    usleep((useconds_t)(wait_ms * 1000));
 }
 
 bool scheduler_step(Scheduler *scheduler) {
     if (!scheduler) return false;
 
+    scheduler_fire_timers(scheduler);
+
     Block *block = scheduler_dequeue(scheduler);
     if (!block) {
-        if (has_wakeable_waiting_blocks(scheduler)) {
+        /*
+         * Sends and timers enqueue the blocks they wake, so an empty run
+         * queue with no armed timer means every live block is waiting on
+         * mail that nobody can send.
+         */
+        if (timer_has_pending(scheduler->timers)) {
+            scheduler_wait_for_timer(scheduler);
             return true;
         }
         return false;
@@ -639,68 +913,15 @@ bool scheduler_step(Scheduler *scheduler) {
         break;
 
     case BLOCK_RUN_WAITING:
+        if (!block_park(block)) {
+            scheduler_enqueue(scheduler, block);
+        }
         break;
 
     case BLOCK_RUN_OK:
     case BLOCK_RUN_HALTED:
     case BLOCK_RUN_ERROR:
-        scheduler->total_terminated++;
-
-        const char *exit_reason_str = (result == BLOCK_RUN_ERROR)
-            ? (block->u.exit.exit_reason ? block->u.exit.exit_reason : "error")
-            : "normal";
-        bool is_abnormal = (result == BLOCK_RUN_ERROR);
-
-        /* Notify linked blocks */
-        {
-            size_t link_count;
-            const Pid *links = block_get_links(block, &link_count);
-            for (size_t i = 0; i < link_count; i++) {
-                Block *linked = scheduler_get_block(scheduler, links[i]);
-                if (linked && block_is_alive(linked)) {
-                    if (block_has_cap(linked, CAP_TRAP_EXIT)) {
-                        Value *exit_msg = value_map();
-                        exit_msg = map_set(exit_msg, "type", value_string("exit"));
-                        exit_msg = map_set(exit_msg, "pid", value_pid(block->pid));
-                        exit_msg = map_set(exit_msg, "reason", value_string(exit_reason_str));
-                        exit_msg = map_set(exit_msg, "code", value_int(block->u.exit.exit_code));
-
-                        if (block_send(linked, block->pid, exit_msg)) {
-                            if (block_try_transition(linked, BLOCK_WAITING, BLOCK_RUNNABLE)) {
-                                scheduler_enqueue(scheduler, linked);
-                            }
-                        }
-                    } else if (is_abnormal) {
-                        block_crash(linked, "linked process crashed");
-                        if (atomic_load(&linked->state) == BLOCK_RUNNABLE) {
-                            scheduler_runqueue_remove(scheduler, linked);
-                        }
-                    }
-                    block_unlink(linked, block->pid);
-                }
-            }
-        }
-
-        /* Notify monitors */
-        {
-            for (size_t i = 0; i < block->monitored_by_count; i++) {
-                Block *monitor = scheduler_get_block(scheduler, block->monitored_by[i]);
-                if (monitor && block_is_alive(monitor)) {
-                    Value *down_msg = value_map();
-                    down_msg = map_set(down_msg, "type", value_string("down"));
-                    down_msg = map_set(down_msg, "pid", value_pid(block->pid));
-                    down_msg = map_set(down_msg, "reason", value_string(exit_reason_str));
-                    down_msg = map_set(down_msg, "code", value_int(block->u.exit.exit_code));
-
-                    if (block_send(monitor, block->pid, down_msg)) {
-                        if (block_try_transition(monitor, BLOCK_WAITING, BLOCK_RUNNABLE)) {
-                            scheduler_enqueue(scheduler, monitor);
-                        }
-                    }
-                    block_demonitor(monitor, block->pid);
-                }
-            }
-        }
+        scheduler_terminate_block(scheduler, block);
         break;
     }
 
@@ -713,6 +934,13 @@ void scheduler_run(Scheduler *scheduler) {
     atomic_store(&scheduler->running, true);
 
     if (scheduler->worker_count > 0) {
+        atomic_store(&scheduler->blocked, false);
+
+        /* No worker thread exists yet, so this thread may seed the deques
+         * with blocks spawned before the run; peers can steal them at once */
+        for (size_t i = 0; i < scheduler->worker_count; i++) {
+            worker_drain_inbox(scheduler->workers[i]);
+        }
         for (size_t i = 0; i < scheduler->worker_count; i++) {
             worker_start(scheduler->workers[i]);
         }
@@ -792,6 +1020,7 @@ SchedulerStats scheduler_stats(const Scheduler *scheduler) {
     stats.blocks_total = scheduler->total_spawned;
     stats.total_reductions = scheduler->total_reductions;
     stats.context_switches = scheduler->context_switches;
+    stats.blocks_dead = atomic_load(&scheduler->total_retired);
 
     registry_iterate((BlockRegistry *)&scheduler->registry, count_block_states_callback, &stats);
 
@@ -898,6 +1127,192 @@ void scheduler_print(const Scheduler *scheduler) {
     printf("}\n");
 }
 
+/* Distribution */
+
+void scheduler_set_node(Scheduler *scheduler, uint16_t node_number,
+                        RemoteSendFn remote_send, RemoteSignalFn remote_signal,
+                        void *ctx) {
+    if (!scheduler) return;
+
+    /* PIDs handed out from here on carry the node number */
+    Pid next = atomic_load(&scheduler->next_pid);
+    atomic_store(&scheduler->next_pid, pid_make(node_number, pid_local(next)));
+
+    scheduler->node_number = node_number;
+    scheduler->remote_send = remote_send;
+    scheduler->remote_signal = remote_signal;
+    scheduler->remote_ctx = ctx;
+}
+
+bool scheduler_pid_is_remote(const Scheduler *scheduler, Pid pid) {
+    if (!scheduler || !scheduler->remote_send) return false;
+    uint16_t node = pid_node(pid);
+    return node != 0 && node != scheduler->node_number;
+}
+
+bool scheduler_signal_remote(Scheduler *scheduler, RemoteSignal signal, Pid target,
+                             Pid from, const char *reason, int code) {
+    if (!scheduler || !scheduler->remote_signal) return false;
+    return scheduler->remote_signal(scheduler->remote_ctx, signal, target, from,
+                                    reason, code);
+}
+
+/* Remove pid from a link or monitor list. Caller holds link_mutex. */
+static bool pids_take(Pid *pids, uint32_t *count, Pid pid) {
+    for (uint32_t i = 0; i < *count; i++) {
+        if (pids[i] == pid) {
+            pids[i] = pids[--(*count)];
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Drop a link, reporting whether it was still there: an exit that raced
+ * an unlink must not be delivered */
+static bool take_link(Block *block, Pid other) {
+    pthread_mutex_lock(&block->link_mutex);
+    bool found = pids_take(block->links, &block->link_count, other);
+    pthread_mutex_unlock(&block->link_mutex);
+    return found;
+}
+
+static bool take_monitor(Block *block, Pid target) {
+    pthread_mutex_lock(&block->link_mutex);
+    bool found = pids_take(block->monitors, &block->monitor_count, target);
+    pthread_mutex_unlock(&block->link_mutex);
+    return found;
+}
+
+void scheduler_handle_remote(Scheduler *scheduler, RemoteSignal signal, Pid target,
+                             Pid from, const char *reason, int code) {
+    if (!scheduler) return;
+    if (!reason) reason = "error";
+
+    bool foreign = scheduler_pin(scheduler);
+    Block *block = scheduler_get_block(scheduler, target);
+
+    switch (signal) {
+    case REMOTE_LINK:
+        /* The linker already holds its side; a dead target answers with
+         * an exit, as a local link to it would have failed */
+        if (!block || !block_link(block, from)) {
+            scheduler_signal_remote(scheduler, REMOTE_EXIT, from, target, "noproc", -1);
+        }
+        break;
+
+    case REMOTE_UNLINK:
+        if (block) block_unlink(block, from);
+        break;
+
+    case REMOTE_MONITOR:
+        if (!block || !block_add_monitored_by(block, from)) {
+            scheduler_signal_remote(scheduler, REMOTE_DOWN, from, target, "noproc", -1);
+        }
+        break;
+
+    case REMOTE_DEMONITOR:
+        if (block) block_remove_monitored_by(block, from);
+        break;
+
+    case REMOTE_EXIT:
+        if (block && block_is_alive(block) && take_link(block, from)) {
+            bool abnormal = code != 0 || strcmp(reason, "normal") != 0;
+            notify_linked(scheduler, block, from, reason, code, abnormal);
+        }
+        break;
+
+    case REMOTE_DOWN:
+        if (block && block_is_alive(block) && take_monitor(block, from)) {
+            notify_monitor(block, from, reason, code);
+        }
+        break;
+    }
+
+    scheduler_unpin(scheduler, foreign);
+}
+
+/* One link or monitor between a local block and a block on a lost node */
+typedef struct NodeDownEntry {
+    Pid local;
+    Pid remote;
+    RemoteSignal kind;  /* REMOTE_EXIT: link, REMOTE_DOWN: local monitors remote,
+                         * REMOTE_DEMONITOR: remote monitors local */
+} NodeDownEntry;
+
+typedef struct NodeDownScan {
+    uint16_t node_number;
+    NodeDownEntry *entries;
+    size_t count;
+    size_t capacity;
+} NodeDownScan;
+
+static void node_down_collect(NodeDownScan *scan, Pid local, const Pid *pids,
+                              uint32_t count, RemoteSignal kind) {
+    for (uint32_t i = 0; i < count; i++) {
+        if (pid_node(pids[i]) != scan->node_number) continue;
+
+        if (scan->count == scan->capacity) {
+            size_t cap = scan->capacity ? scan->capacity * 2 : 16;
+            NodeDownEntry *entries = realloc(scan->entries, cap * sizeof(NodeDownEntry));
+            if (!entries) {
+                LOG_ERROR("scheduler: failed to grow node-down list to %zu entries", cap);
+                return;
+            }
+            scan->entries = entries;
+            scan->capacity = cap;
+        }
+        scan->entries[scan->count++] = (NodeDownEntry){ local, pids[i], kind };
+    }
+}
+
+static void node_down_scan(Block *block, void *ctx) {
+    NodeDownScan *scan = (NodeDownScan *)ctx;
+
+    pthread_mutex_lock(&block->link_mutex);
+    node_down_collect(scan, block->pid, block->links, block->link_count, REMOTE_EXIT);
+    node_down_collect(scan, block->pid, block->monitors, block->monitor_count,
+                      REMOTE_DOWN);
+    node_down_collect(scan, block->pid, block->monitored_by,
+                      block->monitored_by_count, REMOTE_DEMONITOR);
+    pthread_mutex_unlock(&block->link_mutex);
+}
+
+void scheduler_node_down(Scheduler *scheduler, uint16_t node_number) {
+    if (!scheduler || node_number == 0 || node_number == scheduler->node_number) return;
+
+    /* One pass over the registry finds every block tied to the node; the
+     * exits and downs go out afterwards, outside the shard locks */
+    NodeDownScan scan = { .node_number = node_number };
+    bool foreign = scheduler_pin(scheduler);
+    registry_iterate(&scheduler->registry, node_down_scan, &scan);
+
+    for (size_t i = 0; i < scan.count; i++) {
+        NodeDownEntry *entry = &scan.entries[i];
+        Block *block = scheduler_get_block(scheduler, entry->local);
+        if (!block) continue;
+
+        switch (entry->kind) {
+        case REMOTE_EXIT:
+            if (block_is_alive(block) && take_link(block, entry->remote)) {
+                notify_linked(scheduler, block, entry->remote, "noconnection", -1, true);
+            }
+            break;
+        case REMOTE_DOWN:
+            if (block_is_alive(block) && take_monitor(block, entry->remote)) {
+                notify_monitor(block, entry->remote, "noconnection", -1);
+            }
+            break;
+        default:
+            block_remove_monitored_by(block, entry->remote);
+            break;
+        }
+    }
+
+    scheduler_unpin(scheduler, foreign);
+    free(scan.entries);
+}
+
 /* Multi-threaded */
 
 bool scheduler_is_multithreaded(const Scheduler *scheduler) {
@@ -917,15 +1332,54 @@ void scheduler_wake_block(Scheduler *scheduler, Block *block) {
     if (!scheduler || !block) return;
 
     if (block_try_transition(block, BLOCK_WAITING, BLOCK_RUNNABLE)) {
+        scheduler_enqueue(scheduler, block);
+    }
+}
 
-        if (scheduler->worker_count > 0) {
-            size_t worker_idx = atomic_fetch_add(&scheduler->next_worker, 1) %
-                                scheduler->worker_count;
-            worker_enqueue(scheduler->workers[worker_idx], block);
-        } else {
-            scheduler_enqueue(scheduler, block);
-        }
+/* Timers */
+
+static void scheduler_timer_fired(void *ctx, Pid pid) {
+    Scheduler *scheduler = (Scheduler *)ctx;
+    Block *block = scheduler_get_block(scheduler, pid);
+    if (!block) return;
+
+    atomic_store(&block->timeout_fired, true);
+    scheduler_wake_block(scheduler, block);
+}
+
+bool scheduler_arm_timer(Scheduler *scheduler, Block *block, uint64_t timeout_ms) {
+    if (!scheduler || !block) return false;
+
+    /* Arm on the calling worker's wheel so the thread that parked the
+     * block is the one that ticks it; fall back to the shared wheel */
+    TimerWheel *wheel = scheduler->timers;
+    Worker *self = worker_current();
+    if (self && self->scheduler == scheduler) {
+        wheel = self->timers;
+    }
+
+    atomic_store(&block->timeout_fired, false);
+    block->pending_timer = timer_add(wheel, block->pid, timeout_ms,
+                                     scheduler_timer_fired, scheduler);
+    block->timer_wheel = block->pending_timer ? wheel : NULL;
+
+    /* A parked worker may be sleeping past the new shared deadline */
+    if (block->pending_timer && wheel == scheduler->timers) {
+        worker_wake_idle(scheduler, NULL);
     }
+    return block->pending_timer != NULL;
+}
+
+void scheduler_cancel_timer(Scheduler *scheduler, Block *block) {
+    (void)scheduler;
+    if (!block || !block->pending_timer) return;
+
+    /* Either removes the entry or waits until its callback has finished,
+     * so a late expiry cannot leak into the next timed wait */
+    timer_cancel_for(block->timer_wheel, block->pending_timer, block->pid);
+    block->pending_timer = NULL;
+    block->timer_wheel = NULL;
+    atomic_store(&block->timeout_fired, false);
 }
 
 /* Block Count */
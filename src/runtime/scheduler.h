@@ -56,19 +56,39 @@ typedef struct BlockRegistry {
     _Atomic(size_t) total_count;
 } BlockRegistry;
 
-/* Run Queue */
+/* Run Queue - single-threaded mode only; worker threads use their own
+ * deques fed by lock-free injection inboxes */
 
 typedef struct RunQueue {
     Block *head;
     Block *tail;
     size_t count;
-    pthread_mutex_t lock;  /* Protects run queue in multi-threaded mode */
 } RunQueue;
 
 /* Scheduler */
 
 typedef struct Worker Worker;
 
+/* Delivers a message to a PID on another node; installed by the
+ * distribution layer. Returns false if the node is unreachable. */
+typedef bool (*RemoteSendFn)(void *ctx, Pid target, Pid sender, Value *value);
+
+/* Link and monitor traffic between blocks on different nodes */
+typedef enum RemoteSignal {
+    REMOTE_LINK,        /* from links to target */
+    REMOTE_UNLINK,
+    REMOTE_MONITOR,     /* from monitors target */
+    REMOTE_DEMONITOR,
+    REMOTE_EXIT,        /* Linked block from exited with reason/code */
+    REMOTE_DOWN,        /* Monitored block from exited with reason/code */
+} RemoteSignal;
+
+/* Delivers a link/monitor signal to a PID on another node; reason and
+ * code are only meaningful for REMOTE_EXIT and REMOTE_DOWN. Returns false
+ * if the node is unreachable. */
+typedef bool (*RemoteSignalFn)(void *ctx, RemoteSignal signal, Pid target, Pid from,
+                               const char *reason, int code);
+
 typedef struct Scheduler {
     SchedulerConfig config;
 
@@ -76,12 +96,17 @@ typedef struct Scheduler {
     _Atomic(Pid) next_pid;
 
     RunQueue run_queue;
+    TimerWheel *timers;  /* Timers armed outside worker threads */
 
     Worker **workers;
     size_t worker_count;
     _Atomic(size_t) next_worker;
+    _Atomic(uint64_t) *idle_workers;     /* Bitmap of parked workers, one bit per worker */
+    size_t idle_words;
+    _Atomic(size_t) spinning_workers;    /* Workers searching for work before parking */
 
     _Atomic(bool) running;
+    _Atomic(bool) blocked;  /* Workers found every live block waiting on mail nobody can send */
     Block *current;
 
     pthread_mutex_t block_mutex;
@@ -95,6 +120,15 @@ typedef struct Scheduler {
     _Atomic(size_t) total_reductions;
     _Atomic(size_t) context_switches;
     _Atomic(size_t) blocks_in_flight;  /* Track blocks currently being executed */
+    _Atomic(size_t) total_retired;     /* Dead blocks unregistered by workers */
+
+    _Atomic(uint64_t) reclaim_epoch;   /* Advanced each time a worker retires a block */
+    _Atomic(size_t) foreign_readers;   /* Non-worker threads inside scheduler_send */
+
+    uint16_t node_number;       /* Stamped into spawned PIDs (0 = not distributed) */
+    RemoteSendFn remote_send;   /* Route for PIDs of other nodes */
+    RemoteSignalFn remote_signal;
+    void *remote_ctx;
 
     uint64_t start_time_ms;
 } Scheduler;
@@ -110,12 +144,22 @@ void scheduler_free(Scheduler *scheduler);
 Pid scheduler_spawn(Scheduler *scheduler, Bytecode *code, const char *name);
 Pid scheduler_spawn_ex(Scheduler *scheduler, Bytecode *code, const char *name,
                        CapabilitySet caps, const BlockLimits *limits);
+Pid scheduler_spawn_reg(Scheduler *scheduler, RegChunk *program, RegChunk *entry,
+                        const char *name, CapabilitySet caps,
+                        const BlockLimits *limits);
 bool scheduler_register_block(Scheduler *scheduler, Block *block);
 Block *scheduler_get_block(Scheduler *scheduler, Pid pid);
+bool scheduler_send(Scheduler *scheduler, Pid target, Pid sender, Value *value);
 void scheduler_kill(Scheduler *scheduler, Pid pid);
 void scheduler_propagate_exit(Scheduler *scheduler, Block *exited_block);
 Block *scheduler_current(Scheduler *scheduler);
 
+/* Termination */
+
+void scheduler_terminate_block(Scheduler *scheduler, Block *block);
+bool scheduler_signal_exit(Scheduler *scheduler, Block *block, const char *reason);
+bool scheduler_take_exit_signal(Scheduler *scheduler, Block *block);
+
 /* Execution */
 
 void scheduler_run(Scheduler *scheduler);
@@ -174,12 +218,29 @@ bool scheduler_is_ready(const Scheduler *scheduler);
 
 void scheduler_print(const Scheduler *scheduler);
 
+/* Distribution */
+
+void scheduler_set_node(Scheduler *scheduler, uint16_t node_number,
+                        RemoteSendFn remote_send, RemoteSignalFn remote_signal,
+                        void *ctx);
+bool scheduler_pid_is_remote(const Scheduler *scheduler, Pid pid);
+bool scheduler_signal_remote(Scheduler *scheduler, RemoteSignal signal, Pid target,
+                             Pid from, const char *reason, int code);
+void scheduler_handle_remote(Scheduler *scheduler, RemoteSignal signal, Pid target,
+                             Pid from, const char *reason, int code);
+void scheduler_node_down(Scheduler *scheduler, uint16_t node_number);
+
 /* Multi-threaded */
 
 bool scheduler_is_multithreaded(const Scheduler *scheduler);
 size_t scheduler_worker_count(const Scheduler *scheduler);
 Worker *scheduler_get_worker(Scheduler *scheduler, size_t index);
 void scheduler_wake_block(Scheduler *scheduler, Block *block);
+
+/* Timers */
+
+bool scheduler_arm_timer(Scheduler *scheduler, Block *block, uint64_t timeout_ms);
+void scheduler_cancel_timer(Scheduler *scheduler, Block *block);
 size_t scheduler_block_count(const Scheduler *scheduler);
 
 /* Process Groups */
@@ -28,6 +28,7 @@ void serial_buffer_init(SerialBuffer *buf) {
     buf->size = 0;
     buf->capacity = 0;
     buf->read_pos = 0;
+    buf->shared = NULL;
 }
 
 void serial_buffer_init_data(SerialBuffer *buf, const uint8_t *data, size_t size) {
@@ -36,11 +37,26 @@ void serial_buffer_init_data(SerialBuffer *buf, const uint8_t *data, size_t size
     buf->size = size;
     buf->capacity = size;
     buf->read_pos = 0;
+    buf->shared = NULL;
+}
+
+/* Read size bytes at offset in shared without copying them. The buffer
+ * holds a reference until serial_buffer_free. */
+void serial_buffer_init_shared(SerialBuffer *buf, SharedBuffer *shared,
+                               size_t offset, size_t size) {
+    if (!buf) return;
+    serial_buffer_init_data(buf, shared->data + offset, size);
+    buf->shared = shared_buffer_retain(shared);
 }
 
 void serial_buffer_free(SerialBuffer *buf) {
     if (!buf) return;
-    free(buf->data);
+    if (buf->shared) {
+        shared_buffer_release(buf->shared);
+        buf->shared = NULL;
+    } else {
+        free(buf->data);
+    }
     buf->data = NULL;
     buf->size = 0;
     buf->capacity = 0;
@@ -131,6 +147,22 @@ bool serial_write_f64(SerialBuffer *buf, double value) {
     return serial_write_u64(buf, conv.u);
 }
 
+/* LEB128: seven bits per byte, low bits first */
+bool serial_write_uvarint(SerialBuffer *buf, uint64_t value) {
+    if (!serial_buffer_ensure(buf, SERIAL_VARINT_MAX)) return false;
+    while (value >= 0x80) {
+        buf->data[buf->size++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    buf->data[buf->size++] = (uint8_t)value;
+    return true;
+}
+
+/* Zigzag keeps small negative numbers short */
+bool serial_write_svarint(SerialBuffer *buf, int64_t value) {
+    return serial_write_uvarint(buf, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+}
+
 bool serial_write_bytes(SerialBuffer *buf, const uint8_t *data, size_t len) {
     if (!serial_buffer_ensure(buf, len)) return false;
     memcpy(buf->data + buf->size, data, len);
@@ -201,6 +233,29 @@ bool serial_read_f64(SerialBuffer *buf, double *value) {
     return true;
 }
 
+bool serial_read_uvarint(SerialBuffer *buf, uint64_t *value) {
+    if (!buf) return false;
+
+    uint64_t result = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (buf->read_pos >= buf->size) return false;
+        uint8_t byte = buf->data[buf->read_pos++];
+        result |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;  /* More than ten bytes */
+}
+
+bool serial_read_svarint(SerialBuffer *buf, int64_t *value) {
+    uint64_t u;
+    if (!serial_read_uvarint(buf, &u)) return false;
+    *value = (int64_t)(u >> 1) ^ -(int64_t)(u & 1);
+    return true;
+}
+
 bool serial_read_bytes(SerialBuffer *buf, uint8_t *data, size_t len) {
     if (!buf || buf->read_pos + len > buf->size) return false;
     memcpy(data, buf->data + buf->read_pos, len);
@@ -225,154 +280,234 @@ char *serial_read_string(SerialBuffer *buf) {
     return str;
 }
 
-/* Value Serialization */
+/* Format v2
+ *
+ * A v2 stream starts with SERIAL_MAGIC and the version; v1 streams start
+ * straight with a type tag, which is how old data is still told apart.
+ * Lengths, counts and PIDs are varints and integers are zigzag varints.
+ * Map keys, struct and enum names and short strings go through a string
+ * table built as the message is written: the first use is inline
+ * ([len << 1][bytes]) and later uses are back references ([index << 1 | 1]).
+ * Arrays whose elements share a tag write the tag once.
+ */
 
-SerializeResult serialize_value(Value *value, SerialBuffer *buf) {
-    if (!buf) return SERIALIZE_ERROR_BUFFER;
+#define STRING_TABLE_INITIAL 64
+
+typedef struct StringSlot {
+    const char *data;   /* NULL = empty slot */
+    uint32_t len;
+    uint32_t hash;
+    uint32_t index;
+} StringSlot;
+
+typedef struct SerialWriter {
+    SerialBuffer *buf;
+    StringSlot *slots;
+    size_t capacity;
+    size_t count;
+} SerialWriter;
+
+static uint32_t table_hash(const char *data, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)data[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static StringSlot *writer_find_slot(StringSlot *slots, size_t capacity,
+                                    const char *data, uint32_t len, uint32_t hash) {
+    size_t i = hash & (capacity - 1);
+    while (slots[i].data) {
+        if (slots[i].hash == hash && slots[i].len == len &&
+            memcmp(slots[i].data, data, len) == 0) {
+            break;
+        }
+        i = (i + 1) & (capacity - 1);
+    }
+    return &slots[i];
+}
 
-    if (!value) {
-        if (!serial_write_u8(buf, SERIAL_TAG_NIL)) return SERIALIZE_ERROR_BUFFER;
-        return SERIALIZE_OK;
+static bool writer_grow(SerialWriter *w) {
+    size_t capacity = w->capacity ? w->capacity * 2 : STRING_TABLE_INITIAL;
+    StringSlot *slots = calloc(capacity, sizeof(StringSlot));
+    if (!slots) {
+        LOG_ERROR("serialize: failed to grow string table to %zu slots", capacity);
+        return false;
+    }
+    for (size_t i = 0; i < w->capacity; i++) {
+        StringSlot *old = &w->slots[i];
+        if (old->data) {
+            *writer_find_slot(slots, capacity, old->data, old->len, old->hash) = *old;
+        }
+    }
+    free(w->slots);
+    w->slots = slots;
+    w->capacity = capacity;
+    return true;
+}
+
+/* Names always go in the table; other strings only when short */
+static bool write_string_ref(SerialWriter *w, const char *data, size_t len, bool name) {
+    if (!name && len > SERIAL_INTERN_MAX) {
+        if (!serial_write_uvarint(w->buf, (uint64_t)len << 1)) return false;
+        return serial_write_bytes(w->buf, (const uint8_t *)data, len);
+    }
+
+    if (w->count * 4 >= w->capacity * 3 && !writer_grow(w)) return false;
+
+    uint32_t hash = table_hash(data, len);
+    StringSlot *slot = writer_find_slot(w->slots, w->capacity, data, (uint32_t)len, hash);
+    if (slot->data) {
+        return serial_write_uvarint(w->buf, ((uint64_t)slot->index << 1) | 1);
     }
 
+    /* Empty strings still need a non-NULL key */
+    slot->data = len > 0 ? data : "";
+    slot->len = (uint32_t)len;
+    slot->hash = hash;
+    slot->index = (uint32_t)w->count++;
+
+    if (!serial_write_uvarint(w->buf, (uint64_t)len << 1)) return false;
+    return serial_write_bytes(w->buf, (const uint8_t *)data, len);
+}
+
+static bool write_name_ref(SerialWriter *w, const char *str) {
+    return write_string_ref(w, str ? str : "", str ? strlen(str) : 0, true);
+}
+
+/* Tag a value is written under, or 0xFF if it cannot be serialized */
+static uint8_t value_tag(const Value *value) {
+    if (!value) return SERIAL_TAG_NIL;
+
     switch (value->type) {
-    case VAL_NIL:
-        if (!serial_write_u8(buf, SERIAL_TAG_NIL)) return SERIALIZE_ERROR_BUFFER;
+    case VAL_NIL:    return SERIAL_TAG_NIL;
+    case VAL_BOOL:   return SERIAL_TAG_BOOL;
+    case VAL_INT:    return SERIAL_TAG_INT;
+    case VAL_FLOAT:  return SERIAL_TAG_FLOAT;
+    case VAL_STRING: return SERIAL_TAG_STRING;
+    case VAL_PID:    return SERIAL_TAG_PID;
+    case VAL_ARRAY:  return SERIAL_TAG_ARRAY;
+    case VAL_MAP:    return SERIAL_TAG_MAP;
+    case VAL_BYTES:  return SERIAL_TAG_BYTES;
+    case VAL_RESULT: return SERIAL_TAG_RESULT;
+    case VAL_OPTION: return SERIAL_TAG_OPTION;
+    case VAL_STRUCT: return SERIAL_TAG_STRUCT;
+    case VAL_ENUM:   return SERIAL_TAG_ENUM;
+    default:         return 0xFF;
+    }
+}
+
+static bool value_tag_known(uint8_t tag) {
+    switch (tag) {
+    case SERIAL_TAG_NIL: case SERIAL_TAG_BOOL: case SERIAL_TAG_INT:
+    case SERIAL_TAG_FLOAT: case SERIAL_TAG_STRING: case SERIAL_TAG_PID:
+    case SERIAL_TAG_ARRAY: case SERIAL_TAG_MAP: case SERIAL_TAG_BYTES:
+    case SERIAL_TAG_RESULT: case SERIAL_TAG_OPTION: case SERIAL_TAG_STRUCT:
+    case SERIAL_TAG_ENUM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+static SerializeResult write_value(SerialWriter *w, Value *value);
+
+/* Everything after the tag */
+static SerializeResult write_body(SerialWriter *w, Value *value, uint8_t tag) {
+    SerialBuffer *buf = w->buf;
+
+    switch (tag) {
+    case SERIAL_TAG_NIL:
         break;
 
-    case VAL_BOOL:
-        if (!serial_write_u8(buf, SERIAL_TAG_BOOL)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_BOOL:
         if (!serial_write_u8(buf, value->as.boolean ? 1 : 0)) return SERIALIZE_ERROR_BUFFER;
         break;
 
-    case VAL_INT:
-        if (!serial_write_u8(buf, SERIAL_TAG_INT)) return SERIALIZE_ERROR_BUFFER;
-        if (!serial_write_i64(buf, value->as.integer)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_INT:
+        if (!serial_write_svarint(buf, value->as.integer)) return SERIALIZE_ERROR_BUFFER;
         break;
 
-    case VAL_FLOAT:
-        if (!serial_write_u8(buf, SERIAL_TAG_FLOAT)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_FLOAT:
         if (!serial_write_f64(buf, value->as.floating)) return SERIALIZE_ERROR_BUFFER;
         break;
 
-    case VAL_STRING:
-        if (!serial_write_u8(buf, SERIAL_TAG_STRING)) return SERIALIZE_ERROR_BUFFER;
-        if (!value->as.string) {
-            if (!serial_write_u32(buf, 0)) return SERIALIZE_ERROR_BUFFER;
-        } else {
-            if (!serial_write_u32(buf, (uint32_t)value->as.string->length)) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_bytes(buf, (uint8_t *)value->as.string->data, value->as.string->length))
-                return SERIALIZE_ERROR_BUFFER;
-        }
+    case SERIAL_TAG_STRING: {
+        String *str = value->as.string;
+        if (!write_string_ref(w, str ? str->data : "", str ? str->length : 0, false))
+            return SERIALIZE_ERROR_BUFFER;
         break;
+    }
 
-    case VAL_PID:
-        if (!serial_write_u8(buf, SERIAL_TAG_PID)) return SERIALIZE_ERROR_BUFFER;
-        if (!serial_write_u64(buf, value->as.pid)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_PID:
+        if (!serial_write_uvarint(buf, value->as.pid)) return SERIALIZE_ERROR_BUFFER;
         break;
 
-    case VAL_ARRAY: {
-        if (!serial_write_u8(buf, SERIAL_TAG_ARRAY)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_ARRAY: {
+        /* Header was written by write_value, which picks the array form */
         size_t len = array_length(value);
-        if (!serial_write_u32(buf, (uint32_t)len)) return SERIALIZE_ERROR_BUFFER;
         for (size_t i = 0; i < len; i++) {
-            Value *elem = array_get(value, i);
-            SerializeResult res = serialize_value(elem, buf);
+            SerializeResult res = write_value(w, array_get(value, i));
             if (res != SERIALIZE_OK) return res;
         }
         break;
     }
 
-    case VAL_MAP: {
-        if (!serial_write_u8(buf, SERIAL_TAG_MAP)) return SERIALIZE_ERROR_BUFFER;
-        Value *keys = map_keys(value);
-        size_t len = keys ? array_length(keys) : 0;
-        if (!serial_write_u32(buf, (uint32_t)len)) return SERIALIZE_ERROR_BUFFER;
-        for (size_t i = 0; i < len; i++) {
-            Value *key = array_get(keys, i);
-            if (!key || !value_is_string(key)) continue;
-
-            if (!serial_write_string(buf, key->as.string->data)) return SERIALIZE_ERROR_BUFFER;
-
-            Value *val = map_get(value, key->as.string->data);
-            SerializeResult res = serialize_value(val, buf);
-            if (res != SERIALIZE_OK) return res;
+    case SERIAL_TAG_MAP: {
+        Map *map = value->as.map;
+        if (!serial_write_uvarint(buf, map->size)) return SERIALIZE_ERROR_BUFFER;
+        for (size_t i = 0; i < map->capacity; i++) {
+            for (MapEntry *entry = map->buckets[i]; entry; entry = entry->next) {
+                if (!write_string_ref(w, entry->key->data, entry->key->length, true))
+                    return SERIALIZE_ERROR_BUFFER;
+                SerializeResult res = write_value(w, entry->value);
+                if (res != SERIALIZE_OK) return res;
+            }
         }
         break;
     }
 
-    case VAL_BYTES: {
-        if (!serial_write_u8(buf, SERIAL_TAG_BYTES)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_BYTES: {
         size_t len = value->as.bytes ? value->as.bytes->length : 0;
-        if (!serial_write_u32(buf, (uint32_t)len)) return SERIALIZE_ERROR_BUFFER;
-        if (len > 0 && value->as.bytes->data) {
-            if (!serial_write_bytes(buf, value->as.bytes->data, len)) return SERIALIZE_ERROR_BUFFER;
-        }
+        if (!serial_write_uvarint(buf, len)) return SERIALIZE_ERROR_BUFFER;
+        if (len > 0 && !serial_write_bytes(buf, value->as.bytes->data, len))
+            return SERIALIZE_ERROR_BUFFER;
         break;
     }
 
-    case VAL_RESULT: {
-        if (!serial_write_u8(buf, SERIAL_TAG_RESULT)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_RESULT:
         if (!serial_write_u8(buf, value->as.result->is_ok ? 1 : 0)) return SERIALIZE_ERROR_BUFFER;
-        SerializeResult res = serialize_value(value->as.result->value, buf);
-        if (res != SERIALIZE_OK) return res;
-        break;
-    }
+        return write_value(w, value->as.result->value);
 
-    case VAL_OPTION: {
-        if (!serial_write_u8(buf, SERIAL_TAG_OPTION)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_OPTION: {
         bool is_some = value->as.option && value->as.option->value != NULL;
         if (!serial_write_u8(buf, is_some ? 1 : 0)) return SERIALIZE_ERROR_BUFFER;
-        if (is_some) {
-            SerializeResult res = serialize_value(value->as.option->value, buf);
-            if (res != SERIALIZE_OK) return res;
-        }
+        if (is_some) return write_value(w, value->as.option->value);
         break;
     }
 
-    case VAL_FUNCTION:
-    case VAL_CLOSURE:
-        return SERIALIZE_ERROR_UNSUPPORTED;
-
-    case VAL_VECTOR:
-        return SERIALIZE_ERROR_UNSUPPORTED;
-
-    case VAL_STRUCT: {
-        if (!serial_write_u8(buf, SERIAL_TAG_STRUCT)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_STRUCT: {
         StructInstance *s = value->as.struct_val;
-        if (!s) {
-            if (!serial_write_string(buf, "")) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_u32(buf, 0)) return SERIALIZE_ERROR_BUFFER;
-        } else {
-            if (!serial_write_string(buf, s->type_name ? s->type_name : "")) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_u32(buf, (uint32_t)s->field_count)) return SERIALIZE_ERROR_BUFFER;
-            for (size_t i = 0; i < s->field_count; i++) {
-                if (!serial_write_string(buf, s->field_names[i] ? s->field_names[i] : ""))
-                    return SERIALIZE_ERROR_BUFFER;
-                SerializeResult res = serialize_value(s->fields[i], buf);
-                if (res != SERIALIZE_OK) return res;
-            }
+        size_t count = s ? s->field_count : 0;
+        if (!write_name_ref(w, s ? s->type_name : NULL)) return SERIALIZE_ERROR_BUFFER;
+        if (!serial_write_uvarint(buf, count)) return SERIALIZE_ERROR_BUFFER;
+        for (size_t i = 0; i < count; i++) {
+            if (!write_name_ref(w, s->field_names[i])) return SERIALIZE_ERROR_BUFFER;
+            SerializeResult res = write_value(w, s->fields[i]);
+            if (res != SERIALIZE_OK) return res;
         }
         break;
     }
 
-    case VAL_ENUM: {
-        if (!serial_write_u8(buf, SERIAL_TAG_ENUM)) return SERIALIZE_ERROR_BUFFER;
+    case SERIAL_TAG_ENUM: {
         EnumInstance *e = value->as.enum_val;
-        if (!e) {
-            if (!serial_write_string(buf, "")) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_string(buf, "")) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_u8(buf, 0)) return SERIALIZE_ERROR_BUFFER;
-        } else {
-            if (!serial_write_string(buf, e->type_name ? e->type_name : "")) return SERIALIZE_ERROR_BUFFER;
-            if (!serial_write_string(buf, e->variant_name ? e->variant_name : "")) return SERIALIZE_ERROR_BUFFER;
-            bool has_payload = e->payload != NULL;
-            if (!serial_write_u8(buf, has_payload ? 1 : 0)) return SERIALIZE_ERROR_BUFFER;
-            if (has_payload) {
-                SerializeResult res = serialize_value(e->payload, buf);
-                if (res != SERIALIZE_OK) return res;
-            }
-        }
+        bool has_payload = e && e->payload != NULL;
+        if (!write_name_ref(w, e ? e->type_name : NULL)) return SERIALIZE_ERROR_BUFFER;
+        if (!write_name_ref(w, e ? e->variant_name : NULL)) return SERIALIZE_ERROR_BUFFER;
+        if (!serial_write_u8(buf, has_payload ? 1 : 0)) return SERIALIZE_ERROR_BUFFER;
+        if (has_payload) return write_value(w, e->payload);
         break;
     }
 
@@ -383,16 +518,381 @@ SerializeResult serialize_value(Value *value, SerialBuffer *buf) {
     return SERIALIZE_OK;
 }
 
+/* Arrays of one element type drop the per-element tag. Nested arrays
+ * keep theirs, since each picks its own form. */
+static SerializeResult write_array(SerialWriter *w, Value *value) {
+    size_t len = array_length(value);
+    uint8_t elem_tag = len >= 2 ? value_tag(array_get(value, 0)) : 0xFF;
+    if (elem_tag == SERIAL_TAG_NIL) elem_tag = 0xFF;
+    for (size_t i = 1; i < len && elem_tag != 0xFF; i++) {
+        if (value_tag(array_get(value, i)) != elem_tag) elem_tag = 0xFF;
+    }
+
+    if (elem_tag == 0xFF) {
+        if (!serial_write_u8(w->buf, SERIAL_TAG_ARRAY)) return SERIALIZE_ERROR_BUFFER;
+        if (!serial_write_uvarint(w->buf, len)) return SERIALIZE_ERROR_BUFFER;
+        return write_body(w, value, SERIAL_TAG_ARRAY);
+    }
+
+    if (!serial_write_u8(w->buf, SERIAL_TAG_ARRAY_OF)) return SERIALIZE_ERROR_BUFFER;
+    if (!serial_write_uvarint(w->buf, len)) return SERIALIZE_ERROR_BUFFER;
+    if (!serial_write_u8(w->buf, elem_tag)) return SERIALIZE_ERROR_BUFFER;
+    for (size_t i = 0; i < len; i++) {
+        Value *elem = array_get(value, i);
+        SerializeResult res = elem_tag == SERIAL_TAG_ARRAY ? write_array(w, elem)
+                                                           : write_body(w, elem, elem_tag);
+        if (res != SERIALIZE_OK) return res;
+    }
+    return SERIALIZE_OK;
+}
+
+static SerializeResult write_value(SerialWriter *w, Value *value) {
+    uint8_t tag = value_tag(value);
+    if (tag == 0xFF) return SERIALIZE_ERROR_UNSUPPORTED;
+    if (tag == SERIAL_TAG_ARRAY) return write_array(w, value);
+
+    if (!serial_write_u8(w->buf, tag)) return SERIALIZE_ERROR_BUFFER;
+    return write_body(w, value, tag);
+}
+
+SerializeResult serialize_value(Value *value, SerialBuffer *buf) {
+    if (!buf) return SERIALIZE_ERROR_BUFFER;
+
+    if (!serial_write_u8(buf, SERIAL_MAGIC)) return SERIALIZE_ERROR_BUFFER;
+    if (!serial_write_u8(buf, SERIAL_VERSION)) return SERIALIZE_ERROR_BUFFER;
+
+    SerialWriter w = { .buf = buf };
+    SerializeResult res = write_value(&w, value);
+    free(w.slots);
+    return res;
+}
+
 /* Value Deserialization */
 
-/* Internal function with depth tracking */
-static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *result, int depth);
+typedef struct TableString {
+    const char *data;   /* Points into the message */
+    uint32_t len;
+    char *cstr;         /* NUL-terminated copy, made on first use */
+} TableString;
+
+typedef struct SerialReader {
+    SerialBuffer *buf;
+    TableString *strings;
+    size_t count;
+    size_t capacity;
+    TableString scratch;    /* Inline string too long for the table */
+} SerialReader;
+
+static Value *deserialize_v1(SerialBuffer *buf, SerializeResult *result, int depth);
+
+static void reader_free(SerialReader *r) {
+    for (size_t i = 0; i < r->count; i++) {
+        free(r->strings[i].cstr);
+    }
+    free(r->strings);
+    free(r->scratch.cstr);
+}
+
+/* Read a string reference; the entry may move on the next read, but a
+ * name's cstr copy stays valid until the reader is freed */
+static TableString *read_string_ref(SerialReader *r, bool name) {
+    uint64_t ref;
+    if (!serial_read_uvarint(r->buf, &ref)) return NULL;
+
+    if (ref & 1) {
+        uint64_t index = ref >> 1;
+        return index < r->count ? &r->strings[index] : NULL;
+    }
+
+    uint64_t len = ref >> 1;
+    if (len > serial_buffer_remaining(r->buf)) return NULL;
+    const char *data = (const char *)r->buf->data + r->buf->read_pos;
+    r->buf->read_pos += len;
+
+    TableString *str;
+    if (!name && len > SERIAL_INTERN_MAX) {
+        free(r->scratch.cstr);
+        str = &r->scratch;
+    } else {
+        if (r->count == r->capacity) {
+            size_t capacity = r->capacity ? r->capacity * 2 : STRING_TABLE_INITIAL;
+            TableString *strings = realloc(r->strings, capacity * sizeof(TableString));
+            if (!strings) return NULL;
+            r->strings = strings;
+            r->capacity = capacity;
+        }
+        str = &r->strings[r->count++];
+    }
+    str->data = data;
+    str->len = (uint32_t)len;
+    str->cstr = NULL;
+    return str;
+}
+
+static const char *table_cstr(TableString *str) {
+    if (!str->cstr) {
+        str->cstr = malloc(str->len + 1);
+        if (!str->cstr) return NULL;
+        memcpy(str->cstr, str->data, str->len);
+        str->cstr[str->len] = '\0';
+    }
+    return str->cstr;
+}
+
+static Value *read_value(SerialReader *r, SerializeResult *result, int depth);
+
+/* Decode everything after the tag. On failure *result is set and the
+ * partial value freed. */
+static Value *read_body(SerialReader *r, uint8_t tag, SerializeResult *result, int depth) {
+    SerialBuffer *buf = r->buf;
+    *result = SERIALIZE_ERROR_CORRUPT;
+
+    if (depth > MAX_SERIALIZE_DEPTH) {
+        *result = SERIALIZE_ERROR_OVERFLOW;
+        return NULL;
+    }
+
+    switch (tag) {
+    case SERIAL_TAG_NIL:
+        *result = SERIALIZE_OK;
+        return value_nil();
+
+    case SERIAL_TAG_BOOL: {
+        uint8_t b;
+        if (!serial_read_u8(buf, &b)) return NULL;
+        *result = SERIALIZE_OK;
+        return value_bool(b != 0);
+    }
+
+    case SERIAL_TAG_INT: {
+        int64_t v;
+        if (!serial_read_svarint(buf, &v)) return NULL;
+        *result = SERIALIZE_OK;
+        return value_int(v);
+    }
+
+    case SERIAL_TAG_FLOAT: {
+        double v;
+        if (!serial_read_f64(buf, &v)) return NULL;
+        *result = SERIALIZE_OK;
+        return value_float(v);
+    }
+
+    case SERIAL_TAG_STRING: {
+        TableString *str = read_string_ref(r, false);
+        if (!str) return NULL;
+        *result = SERIALIZE_OK;
+        return value_string_n(str->data, str->len);
+    }
+
+    case SERIAL_TAG_PID: {
+        uint64_t pid;
+        if (!serial_read_uvarint(buf, &pid)) return NULL;
+        *result = SERIALIZE_OK;
+        return value_pid(pid);
+    }
+
+    case SERIAL_TAG_ARRAY:
+    case SERIAL_TAG_ARRAY_OF: {
+        uint64_t len;
+        uint8_t elem_tag = 0;
+        if (!serial_read_uvarint(buf, &len)) return NULL;
+        if (tag == SERIAL_TAG_ARRAY_OF && !serial_read_u8(buf, &elem_tag)) return NULL;
+
+        /* Every element takes at least a byte */
+        if (len > serial_buffer_remaining(buf)) return NULL;
+
+        Value *arr = value_array_with_capacity((size_t)len);
+        if (!arr) {
+            *result = SERIALIZE_ERROR_BUFFER;
+            return NULL;
+        }
+        for (uint64_t i = 0; i < len; i++) {
+            Value *elem = tag == SERIAL_TAG_ARRAY_OF && elem_tag != SERIAL_TAG_ARRAY
+                              ? read_body(r, elem_tag, result, depth + 1)
+                              : read_value(r, result, depth + 1);
+            if (*result != SERIALIZE_OK) {
+                value_free(arr);
+                return NULL;
+            }
+            arr = array_push(arr, elem);
+        }
+        *result = SERIALIZE_OK;
+        return arr;
+    }
+
+    case SERIAL_TAG_MAP: {
+        uint64_t len;
+        if (!serial_read_uvarint(buf, &len) || len > serial_buffer_remaining(buf)) return NULL;
+
+        Value *map = value_map_with_capacity((size_t)len);
+        if (!map) {
+            *result = SERIALIZE_ERROR_BUFFER;
+            return NULL;
+        }
+        for (uint64_t i = 0; i < len; i++) {
+            /* Keys are inserted straight from the buffer */
+            TableString *key = read_string_ref(r, true);
+            if (!key) {
+                *result = SERIALIZE_ERROR_CORRUPT;
+                value_free(map);
+                return NULL;
+            }
+            const char *key_data = key->data;
+            size_t key_len = key->len;
+
+            Value *val = read_value(r, result, depth + 1);
+            if (*result != SERIALIZE_OK) {
+                value_free(map);
+                return NULL;
+            }
+            map = map_set_n(map, key_data, key_len, val);
+        }
+        *result = SERIALIZE_OK;
+        return map;
+    }
+
+    case SERIAL_TAG_BYTES: {
+        uint64_t len;
+        if (!serial_read_uvarint(buf, &len) || len > serial_buffer_remaining(buf)) return NULL;
+
+        Value *bytes;
+        if (buf->shared && len >= SERIAL_SLICE_MIN) {
+            bytes = value_bytes_slice(buf->shared, buf->data + buf->read_pos, (size_t)len);
+        } else {
+            bytes = value_bytes((size_t)len);
+            if (bytes && len > 0) {
+                bytes_append(bytes, buf->data + buf->read_pos, (size_t)len);
+            }
+        }
+        buf->read_pos += len;
+        *result = bytes ? SERIALIZE_OK : SERIALIZE_ERROR_BUFFER;
+        return bytes;
+    }
+
+    case SERIAL_TAG_RESULT: {
+        uint8_t is_ok;
+        if (!serial_read_u8(buf, &is_ok)) return NULL;
+        Value *val = read_value(r, result, depth + 1);
+        if (*result != SERIALIZE_OK) return NULL;
+        return is_ok ? value_result_ok(val) : value_result_err(val);
+    }
+
+    case SERIAL_TAG_OPTION: {
+        uint8_t is_some;
+        if (!serial_read_u8(buf, &is_some)) return NULL;
+        if (!is_some) {
+            *result = SERIALIZE_OK;
+            return value_none();
+        }
+        Value *val = read_value(r, result, depth + 1);
+        if (*result != SERIALIZE_OK) return NULL;
+        return value_some(val);
+    }
+
+    case SERIAL_TAG_STRUCT: {
+        /* Names are always in the table, so their copies stay put */
+        TableString *type_name = read_string_ref(r, true);
+        const char *type = type_name ? table_cstr(type_name) : NULL;
+        uint64_t field_count;
+        if (!type || !serial_read_uvarint(buf, &field_count) ||
+            field_count > serial_buffer_remaining(buf)) {
+            return NULL;
+        }
+
+        Value *s = value_struct_new(type, (size_t)field_count);
+        if (!s) {
+            *result = SERIALIZE_ERROR_BUFFER;
+            return NULL;
+        }
+        for (uint64_t i = 0; i < field_count; i++) {
+            TableString *field_name = read_string_ref(r, true);
+            const char *field = field_name ? table_cstr(field_name) : NULL;
+            if (!field) {
+                *result = SERIALIZE_ERROR_CORRUPT;
+                value_free(s);
+                return NULL;
+            }
+            Value *field_val = read_value(r, result, depth + 1);
+            if (*result != SERIALIZE_OK) {
+                value_free(s);
+                return NULL;
+            }
+            value_struct_set_field(s, (size_t)i, field, field_val);
+        }
+        *result = SERIALIZE_OK;
+        return s;
+    }
+
+    case SERIAL_TAG_ENUM: {
+        TableString *type_name = read_string_ref(r, true);
+        const char *type = type_name ? table_cstr(type_name) : NULL;
+        if (!type) return NULL;
+        TableString *variant_name = read_string_ref(r, true);
+        const char *variant = variant_name ? table_cstr(variant_name) : NULL;
+        uint8_t has_payload;
+        if (!variant || !serial_read_u8(buf, &has_payload)) return NULL;
+
+        if (!has_payload) {
+            *result = SERIALIZE_OK;
+            return value_enum_unit(type, variant);
+        }
+        Value *payload = read_value(r, result, depth + 1);
+        if (*result != SERIALIZE_OK) return NULL;
+        return value_enum_with_payload(type, variant, payload);
+    }
+
+    default:
+        *result = SERIALIZE_ERROR_UNSUPPORTED;
+        return NULL;
+    }
+}
+
+static Value *read_value(SerialReader *r, SerializeResult *result, int depth) {
+    uint8_t tag;
+    if (!serial_read_u8(r->buf, &tag)) {
+        *result = SERIALIZE_ERROR_CORRUPT;
+        return NULL;
+    }
+    if (tag == SERIAL_TAG_ARRAY_OF || value_tag_known(tag)) {
+        return read_body(r, tag, result, depth);
+    }
+    *result = SERIALIZE_ERROR_UNSUPPORTED;
+    return NULL;
+}
 
 Value *deserialize_value(SerialBuffer *buf, SerializeResult *result) {
-    return deserialize_value_internal(buf, result, 0);
+    SerializeResult res = SERIALIZE_ERROR_BUFFER;
+    Value *value = NULL;
+
+    if (buf && serial_buffer_remaining(buf) > 0 &&
+        buf->data[buf->read_pos] == SERIAL_MAGIC) {
+        uint8_t version = 0;
+        buf->read_pos++;
+        if (!serial_read_u8(buf, &version)) {
+            res = SERIALIZE_ERROR_CORRUPT;
+        } else if (version != SERIAL_VERSION) {
+            res = SERIALIZE_ERROR_VERSION;
+        } else {
+            SerialReader r = { .buf = buf };
+            value = read_value(&r, &res, 0);
+            reader_free(&r);
+        }
+    } else if (buf) {
+        value = deserialize_v1(buf, &res, 0);
+    }
+
+    if (result) *result = res;
+    return value;
 }
 
-static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *result, int depth) {
+/* Format v1 Reader
+ *
+ * Fixed-width big-endian lengths and integers, every name written in
+ * full. Only read, for checkpoints and peers that predate v2.
+ */
+
+static Value *deserialize_v1(SerialBuffer *buf, SerializeResult *result, int depth) {
     if (!buf) {
         if (result) *result = SERIALIZE_ERROR_BUFFER;
         return NULL;
@@ -484,7 +984,7 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
         Value *arr = value_array();
         for (uint32_t i = 0; i < len; i++) {
             SerializeResult elem_result;
-            Value *elem = deserialize_value_internal(buf, &elem_result, depth + 1);
+            Value *elem = deserialize_v1(buf, &elem_result, depth + 1);
             if (elem_result != SERIALIZE_OK) {
                 if (result) *result = elem_result;
                 return NULL;
@@ -503,20 +1003,22 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
         }
         Value *map = value_map();
         for (uint32_t i = 0; i < len; i++) {
-            char *key = serial_read_string(buf);
-            if (!key) {
+            /* Keys are inserted straight from the buffer */
+            uint32_t key_len;
+            if (!serial_read_u32(buf, &key_len) || buf->read_pos + key_len > buf->size) {
                 if (result) *result = SERIALIZE_ERROR_CORRUPT;
                 return NULL;
             }
+            const char *key = (const char *)buf->data + buf->read_pos;
+            buf->read_pos += key_len;
+
             SerializeResult val_result;
-            Value *val = deserialize_value_internal(buf, &val_result, depth + 1);
+            Value *val = deserialize_v1(buf, &val_result, depth + 1);
             if (val_result != SERIALIZE_OK) {
-                free(key);
                 if (result) *result = val_result;
                 return NULL;
             }
-            map_set(map, key, val);
-            free(key);
+            map_set_n(map, key, key_len, val);
         }
         if (result) *result = SERIALIZE_OK;
         return map;
@@ -532,9 +1034,14 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
             if (result) *result = SERIALIZE_ERROR_CORRUPT;
             return NULL;
         }
-        Value *bytes = value_bytes(len);
-        if (len > 0) {
-            bytes_append(bytes, buf->data + buf->read_pos, len);
+        Value *bytes;
+        if (buf->shared && len >= SERIAL_SLICE_MIN) {
+            bytes = value_bytes_slice(buf->shared, buf->data + buf->read_pos, len);
+        } else {
+            bytes = value_bytes(len);
+            if (bytes && len > 0) {
+                bytes_append(bytes, buf->data + buf->read_pos, len);
+            }
         }
         buf->read_pos += len;
         if (result) *result = SERIALIZE_OK;
@@ -548,7 +1055,7 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
             return NULL;
         }
         SerializeResult val_result;
-        Value *val = deserialize_value_internal(buf, &val_result, depth + 1);
+        Value *val = deserialize_v1(buf, &val_result, depth + 1);
         if (val_result != SERIALIZE_OK) {
             if (result) *result = val_result;
             return NULL;
@@ -568,7 +1075,7 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
             return value_none();
         }
         SerializeResult val_result;
-        Value *val = deserialize_value_internal(buf, &val_result, depth + 1);
+        Value *val = deserialize_v1(buf, &val_result, depth + 1);
         if (val_result != SERIALIZE_OK) {
             if (result) *result = val_result;
             return NULL;
@@ -602,7 +1109,7 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
                 return NULL;
             }
             SerializeResult field_result;
-            Value *field_val = deserialize_value_internal(buf, &field_result, depth + 1);
+            Value *field_val = deserialize_v1(buf, &field_result, depth + 1);
             if (field_result != SERIALIZE_OK) {
                 free(field_name);
                 if (result) *result = field_result;
@@ -637,7 +1144,7 @@ static Value *deserialize_value_internal(SerialBuffer *buf, SerializeResult *res
         Value *e;
         if (has_payload) {
             SerializeResult payload_result;
-            Value *payload = deserialize_value_internal(buf, &payload_result, depth + 1);
+            Value *payload = deserialize_v1(buf, &payload_result, depth + 1);
             if (payload_result != SERIALIZE_OK) {
                 free(type_name);
                 free(variant_name);
@@ -24,10 +24,13 @@ typedef struct SerialBuffer {
     size_t size;
     size_t capacity;
     size_t read_pos;
+    SharedBuffer *shared;   /* Storage data lies in; decoded Bytes may borrow it */
 } SerialBuffer;
 
 void serial_buffer_init(SerialBuffer *buf);
 void serial_buffer_init_data(SerialBuffer *buf, const uint8_t *data, size_t size);
+void serial_buffer_init_shared(SerialBuffer *buf, SharedBuffer *shared,
+                               size_t offset, size_t size);
 void serial_buffer_free(SerialBuffer *buf);
 bool serial_buffer_ensure(SerialBuffer *buf, size_t needed);
 size_t serial_buffer_position(const SerialBuffer *buf);
@@ -57,6 +60,8 @@ bool serial_write_u32(SerialBuffer *buf, uint32_t value);
 bool serial_write_u64(SerialBuffer *buf, uint64_t value);
 bool serial_write_i64(SerialBuffer *buf, int64_t value);
 bool serial_write_f64(SerialBuffer *buf, double value);
+bool serial_write_uvarint(SerialBuffer *buf, uint64_t value);
+bool serial_write_svarint(SerialBuffer *buf, int64_t value);
 bool serial_write_bytes(SerialBuffer *buf, const uint8_t *data, size_t len);
 bool serial_write_string(SerialBuffer *buf, const char *str);
 
@@ -66,9 +71,21 @@ bool serial_read_u32(SerialBuffer *buf, uint32_t *value);
 bool serial_read_u64(SerialBuffer *buf, uint64_t *value);
 bool serial_read_i64(SerialBuffer *buf, int64_t *value);
 bool serial_read_f64(SerialBuffer *buf, double *value);
+bool serial_read_uvarint(SerialBuffer *buf, uint64_t *value);
+bool serial_read_svarint(SerialBuffer *buf, int64_t *value);
 bool serial_read_bytes(SerialBuffer *buf, uint8_t *data, size_t len);
 char *serial_read_string(SerialBuffer *buf);
 
+#define SERIAL_VARINT_MAX 10
+
+/* Strings up to this long are shared through the per-message string
+ * table; names always are */
+#define SERIAL_INTERN_MAX 64
+
+/* Bytes at least this long are decoded as slices of a shared buffer
+ * instead of being copied */
+#define SERIAL_SLICE_MIN 256
+
 /* Type Tags */
 
 #define SERIAL_TAG_NIL      0x00
@@ -87,7 +104,11 @@ char *serial_read_string(SerialBuffer *buf);
 #define SERIAL_TAG_ENUM     0x0D
 #define SERIAL_TAG_VECTOR   0x0E
 #define SERIAL_TAG_CLOSURE  0x0F
+#define SERIAL_TAG_ARRAY_OF 0x10    /* v2: [len][elem tag][untagged elements] */
+
+/* Leads a versioned stream; v1 streams start straight with a type tag */
+#define SERIAL_MAGIC 0xA6
 
-#define SERIAL_VERSION 1
+#define SERIAL_VERSION 2
 
 #endif /* AGIM_RUNTIME_SERIALIZE_H */
@@ -57,6 +57,7 @@ static void timer_entry_free(TimerWheel *wheel, TimerEntry *entry) {
     entry->next = wheel->free_list;
     entry->prev = NULL;
     entry->cancelled = false;
+    entry->slot = TIMER_SLOT_DETACHED;
     wheel->free_list = entry;
 }
 
@@ -109,6 +110,7 @@ TimerWheel *timer_wheel_new(const TimerConfig *config) {
     wheel->free_list = NULL;
     wheel->allocated = 0;
     atomic_init(&wheel->min_deadline, 0);
+    atomic_init(&wheel->pending, 0);
 
     wheel->buckets = calloc(wheel->wheel_size, sizeof(TimerBucket));
     if (!wheel->buckets) {
@@ -118,6 +120,7 @@ TimerWheel *timer_wheel_new(const TimerConfig *config) {
     }
 
     pthread_mutex_init(&wheel->lock, NULL);
+    pthread_mutex_init(&wheel->fire_lock, NULL);
 
     LOG_DEBUG("timer: created wheel with %zu slots, %lums tick",
               wheel->wheel_size, (unsigned long)wheel->tick_ms);
@@ -148,6 +151,7 @@ void timer_wheel_free(TimerWheel *wheel) {
     free(wheel->buckets);
     pthread_mutex_unlock(&wheel->lock);
     pthread_mutex_destroy(&wheel->lock);
+    pthread_mutex_destroy(&wheel->fire_lock);
     free(wheel);
 }
 
@@ -186,6 +190,7 @@ TimerEntry *timer_add(TimerWheel *wheel, Pid block_pid, uint64_t timeout_ms,
     entry->slot = slot;  /* Store slot for O(1) removal */
 
     bucket_add(&wheel->buckets[slot], entry);
+    atomic_fetch_add_explicit(&wheel->pending, 1, memory_order_relaxed);
 
     /* Update min_deadline atomically using CAS loop.
      * This prevents concurrent timer_add calls from losing updates. */
@@ -204,26 +209,45 @@ TimerEntry *timer_add(TimerWheel *wheel, Pid block_pid, uint64_t timeout_ms,
 }
 
 bool timer_cancel(TimerWheel *wheel, TimerEntry *entry) {
+    if (!entry) return false;
+    return timer_cancel_for(wheel, entry, entry->block_pid);
+}
+
+bool timer_cancel_for(TimerWheel *wheel, TimerEntry *entry, Pid block_pid) {
     if (!wheel || !entry) return false;
 
     pthread_mutex_lock(&wheel->lock);
 
-    if (entry->cancelled) {
+    /* A fired entry may have been recycled for another block's timer */
+    if (entry->cancelled || entry->block_pid != block_pid) {
         pthread_mutex_unlock(&wheel->lock);
         return false;
     }
 
-    entry->cancelled = true;
-
     /* O(1) removal using stored slot index */
     size_t slot = entry->slot;
     if (slot < wheel->wheel_size) {
+        entry->cancelled = true;
         bucket_remove(&wheel->buckets[slot], entry);
         timer_entry_free(wheel, entry);
+        if (atomic_fetch_sub_explicit(&wheel->pending, 1, memory_order_relaxed) == 1) {
+            /* Nothing left armed; don't leave a stale deadline behind */
+            atomic_store_explicit(&wheel->min_deadline, 0, memory_order_relaxed);
+        }
+        pthread_mutex_unlock(&wheel->lock);
+        return true;
     }
 
     pthread_mutex_unlock(&wheel->lock);
-    return true;
+
+    /*
+     * Already detached by timer_tick: the callback is running or about to.
+     * Wait for timer_run_expired to finish so the caller can rely on the
+     * callback not running after we return.
+     */
+    pthread_mutex_lock(&wheel->fire_lock);
+    pthread_mutex_unlock(&wheel->fire_lock);
+    return false;
 }
 
 TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fired_count) {
@@ -237,7 +261,8 @@ TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fire
     uint64_t new_min_deadline = 0;
     bool found_pending = false;
 
-    uint64_t elapsed = current_time_ms - wheel->current_time_ms;
+    uint64_t elapsed = current_time_ms > wheel->current_time_ms
+                       ? current_time_ms - wheel->current_time_ms : 0;
     size_t ticks = (size_t)(elapsed / wheel->tick_ms);
     if (ticks == 0 && elapsed > 0) ticks = 1;
 
@@ -255,6 +280,8 @@ TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fire
 
             if (!entry->cancelled && entry->deadline_ms <= current_time_ms) {
                 bucket_remove(bucket, entry);
+                entry->slot = TIMER_SLOT_DETACHED;
+                atomic_fetch_sub_explicit(&wheel->pending, 1, memory_order_relaxed);
 
                 entry->next = NULL;
                 entry->prev = fired_tail;
@@ -291,8 +318,10 @@ TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fire
         }
     }
 
-    /* Recalculate min_deadline if timers fired (only when needed) */
-    if (*fired_count > 0) {
+    /* Recalculate min_deadline if timers fired or the cached value is stale
+     * (cancellation does not lower it, so it may point into the past) */
+    uint64_t cached_min = atomic_load_explicit(&wheel->min_deadline, memory_order_relaxed);
+    if (*fired_count > 0 || (cached_min != 0 && cached_min <= current_time_ms)) {
         /* Scan all buckets to find new minimum (only after firing) */
         for (size_t i = 0; i < wheel->wheel_size; i++) {
             TimerEntry *e = wheel->buckets[i].head;
@@ -309,12 +338,42 @@ TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fire
         atomic_store_explicit(&wheel->min_deadline, found_pending ? new_min_deadline : 0, memory_order_relaxed);
     }
 
-    wheel->current_time_ms = current_time_ms;
+    if (current_time_ms > wheel->current_time_ms) {
+        wheel->current_time_ms = current_time_ms;
+    }
 
     pthread_mutex_unlock(&wheel->lock);
     return fired_head;
 }
 
+size_t timer_run_expired(TimerWheel *wheel, uint64_t current_time_ms) {
+    if (!wheel) return 0;
+
+    uint64_t next = timer_next_deadline(wheel);
+    if (next == 0 || next > current_time_ms) return 0;
+
+    /* fire_lock lets timer_cancel wait out callbacks of detached entries */
+    pthread_mutex_lock(&wheel->fire_lock);
+
+    size_t fired_count = 0;
+    TimerEntry *fired = timer_tick(wheel, current_time_ms, &fired_count);
+
+    /* Callbacks run without the wheel lock so they may arm new timers */
+    while (fired) {
+        TimerEntry *next_entry = fired->next;
+        if (fired->callback) {
+            fired->callback(fired->callback_ctx, fired->block_pid);
+        }
+        pthread_mutex_lock(&wheel->lock);
+        timer_entry_free(wheel, fired);
+        pthread_mutex_unlock(&wheel->lock);
+        fired = next_entry;
+    }
+
+    pthread_mutex_unlock(&wheel->fire_lock);
+    return fired_count;
+}
+
 uint64_t timer_next_deadline(const TimerWheel *wheel) {
     if (!wheel) return 0;
     /* O(1) access using cached min_deadline */
@@ -323,16 +382,5 @@ uint64_t timer_next_deadline(const TimerWheel *wheel) {
 
 bool timer_has_pending(const TimerWheel *wheel) {
     if (!wheel) return false;
-
-    pthread_mutex_lock((pthread_mutex_t *)&wheel->lock);
-
-    for (size_t i = 0; i < wheel->wheel_size; i++) {
-        if (wheel->buckets[i].head) {
-            pthread_mutex_unlock((pthread_mutex_t *)&wheel->lock);
-            return true;
-        }
-    }
-
-    pthread_mutex_unlock((pthread_mutex_t *)&wheel->lock);
-    return false;
+    return atomic_load_explicit(&((TimerWheel *)wheel)->pending, memory_order_relaxed) > 0;
 }
@@ -32,6 +32,9 @@ typedef struct TimerEntry {
     size_t slot;  /* Stored slot for O(1) removal during cancel */
 } TimerEntry;
 
+/* Slot of an entry that is no longer in a bucket (fired or recycled) */
+#define TIMER_SLOT_DETACHED SIZE_MAX
+
 typedef struct TimerBucket {
     TimerEntry *head;
     TimerEntry *tail;
@@ -51,7 +54,9 @@ typedef struct TimerWheel {
     TimerEntry *free_list;
     size_t allocated;
     pthread_mutex_t lock;
+    pthread_mutex_t fire_lock;  /* Held while timer_run_expired runs callbacks */
     _Atomic(uint64_t) min_deadline;  /* Track minimum deadline for O(1) next_deadline */
+    _Atomic(size_t) pending;         /* Armed entries, for O(1) has_pending */
 } TimerWheel;
 
 /* Timer Wheel API */
@@ -62,8 +67,11 @@ void timer_wheel_free(TimerWheel *wheel);
 
 TimerEntry *timer_add(TimerWheel *wheel, Pid block_pid, uint64_t timeout_ms,
                       TimerCallback callback, void *ctx);
+/* Returns false if the entry already fired; its callback has then completed */
 bool timer_cancel(TimerWheel *wheel, TimerEntry *entry);
+bool timer_cancel_for(TimerWheel *wheel, TimerEntry *entry, Pid block_pid);
 TimerEntry *timer_tick(TimerWheel *wheel, uint64_t current_time_ms, size_t *fired_count);
+size_t timer_run_expired(TimerWheel *wheel, uint64_t current_time_ms);
 uint64_t timer_next_deadline(const TimerWheel *wheel);
 bool timer_has_pending(const TimerWheel *wheel);
 
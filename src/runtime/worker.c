@@ -6,16 +6,17 @@
  */
 
 #define _POSIX_C_SOURCE 200809L
-#define _DEFAULT_SOURCE  /* For usleep */
 
 #include "runtime/worker.h"
 #include "runtime/scheduler.h"
 #include "vm/vm.h"
 #include "debug/log.h"
 
+#include <errno.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
 /* Work-Stealing Deque (Chase-Lev) */
@@ -210,6 +211,12 @@ static inline uint64_t xorshift64(uint64_t *state) {
 
 static void *worker_loop(void *arg);
 
+static _Thread_local Worker *tls_current_worker = NULL;
+
+Worker *worker_current(void) {
+    return tls_current_worker;
+}
+
 Worker *worker_new(int id, Scheduler *scheduler) {
     Worker *worker = malloc(sizeof(Worker));
     if (!worker) {
@@ -226,16 +233,39 @@ Worker *worker_new(int id, Scheduler *scheduler) {
         return NULL;
     }
 
+    worker->timers = timer_wheel_new(NULL);
+    if (!worker->timers) {
+        LOG_ERROR("worker: timer wheel creation failed for worker %d", id);
+        vm_free(worker->vm);
+        free(worker);
+        return NULL;
+    }
+
     deque_init(&worker->runq);
+    atomic_store(&worker->inbox, NULL);
 
     worker_alloc_init(&worker->allocator, id);
 
+    /* Park deadlines are relative, so wait on the monotonic clock */
+    pthread_condattr_t cond_attr;
+    pthread_condattr_init(&cond_attr);
+    pthread_condattr_setclock(&cond_attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&worker->park_cond, &cond_attr);
+    pthread_condattr_destroy(&cond_attr);
+    pthread_mutex_init(&worker->park_lock, NULL);
+    worker->park_notified = false;
+
     atomic_store(&worker->state, WORKER_IDLE);
     atomic_store(&worker->thread_started, false);
     atomic_store(&worker->blocks_executed, 0);
     atomic_store(&worker->steals_attempted, 0);
     atomic_store(&worker->steals_successful, 0);
     atomic_store(&worker->total_reductions, 0);
+    atomic_store(&worker->parks, 0);
+    atomic_store(&worker->epoch, WORKER_EPOCH_OFFLINE);
+    worker->retired_head = NULL;
+    worker->retired_tail = NULL;
+    atomic_store(&worker->blocks_reclaimed, 0);
 
     worker->rng_state = (uint64_t)id * 2654435761UL + (uint64_t)(uintptr_t)worker;
     if (worker->rng_state == 0) worker->rng_state = 1;
@@ -250,7 +280,18 @@ void worker_free(Worker *worker) {
     worker_stop(worker);
     worker_join(worker);
 
+    /* Workers are joined, so nothing can still reference these */
+    Block *retired = worker->retired_head;
+    while (retired) {
+        Block *next = retired->next;
+        block_free(retired);
+        retired = next;
+    }
+
     deque_free(&worker->runq);
+    timer_wheel_free(worker->timers);
+    pthread_cond_destroy(&worker->park_cond);
+    pthread_mutex_destroy(&worker->park_lock);
     worker_alloc_free(&worker->allocator);
     if (worker->vm) {
         vm_free(worker->vm);
@@ -278,6 +319,7 @@ bool worker_start(Worker *worker) {
 void worker_stop(Worker *worker) {
     if (!worker) return;
     atomic_store(&worker->state, WORKER_STOPPED);
+    worker_unpark(worker);
 }
 
 void worker_join(Worker *worker) {
@@ -289,9 +331,77 @@ void worker_join(Worker *worker) {
     }
 }
 
+/* Injection Inbox
+ *
+ * Chase-Lev deques only allow their owner to push, so blocks made runnable
+ * by any other thread go through a lock-free Treiber stack instead. Any
+ * number of producers CAS onto the head; consumers detach the whole list
+ * with one exchange, so there is no ABA and no lock. The owner drains it
+ * into its deque in a batch, and idle peers can take it wholesale when the
+ * owner is busy running a block. */
+
+static void inbox_push(Worker *worker, Block *block) {
+    Block *head = atomic_load_explicit(&worker->inbox, memory_order_relaxed);
+    do {
+        block->inbox_next = head;
+    } while (!atomic_compare_exchange_weak_explicit(
+                 &worker->inbox, &head, block,
+                 memory_order_release, memory_order_relaxed));
+}
+
+/* Detach the inbox and return it in FIFO order */
+static Block *inbox_take(Worker *worker) {
+    if (!atomic_load_explicit(&worker->inbox, memory_order_relaxed)) return NULL;
+
+    Block *list = atomic_exchange_explicit(&worker->inbox, NULL, memory_order_acquire);
+    Block *fifo = NULL;
+    while (list) {
+        Block *next = list->inbox_next;
+        list->inbox_next = fifo;
+        fifo = list;
+        list = next;
+    }
+    return fifo;
+}
+
+/* Move a detached list onto the caller's own deque */
+static size_t inbox_transfer(WorkDeque *deque, Block *list) {
+    size_t count = 0;
+    while (list) {
+        Block *next = list->inbox_next;
+        list->inbox_next = NULL;
+        deque_push(deque, list);
+        list = next;
+        count++;
+    }
+    return count;
+}
+
+size_t worker_drain_inbox(Worker *worker) {
+    if (!worker) return 0;
+    return inbox_transfer(&worker->runq, inbox_take(worker));
+}
+
 void worker_enqueue(Worker *worker, Block *block) {
     if (!worker || !block) return;
-    deque_push(&worker->runq, block);
+
+    /* Only the owning thread may push onto the deque. Everyone else goes
+     * through the inbox, even before the worker starts: its state can
+     * flip to RUNNING between any check and the push */
+    if (worker == tls_current_worker) {
+        deque_push(&worker->runq, block);
+
+        /* A worker feeding its own deque runs the block as soon as the
+         * current one parks or yields; only surplus work is worth waking
+         * a peer for, otherwise a ping-pong pair would migrate between
+         * threads every hop */
+        if (deque_size(&worker->runq) <= 1) {
+            return;
+        }
+    } else {
+        inbox_push(worker, block);
+    }
+    worker_wake_idle(worker->scheduler, worker);
 }
 
 Block *worker_steal(Worker *worker) {
@@ -317,12 +427,92 @@ Block *worker_steal(Worker *worker) {
         }
     }
 
+    /* Nothing queued; take a busy peer's undrained inbox */
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        size_t victim_idx = (start + i) % sched->worker_count;
+        if (victim_idx == (size_t)worker->id) continue;
+
+        Worker *victim = sched->workers[victim_idx];
+        if (!victim) continue;
+
+        if (inbox_transfer(&worker->runq, inbox_take(victim)) > 0) {
+            return deque_pop(&worker->runq);
+        }
+    }
+
     return NULL;
 }
 
+/* Reclamation
+ *
+ * Dead blocks are unregistered by the worker that terminates them, but a
+ * peer may still hold a pointer it looked up earlier in its own iteration.
+ * Workers therefore publish the global epoch at the top of every loop
+ * iteration, when they hold no block pointers (quiescent-state based
+ * reclamation). A retired block is freed once every online peer has
+ * published an epoch newer than the one it was retired in, and no foreign
+ * thread is inside scheduler_send. */
+
+void worker_retire(Worker *worker, Block *block) {
+    if (!worker || !block) return;
+
+    block->retire_epoch = atomic_fetch_add(&worker->scheduler->reclaim_epoch, 1);
+    block->next = NULL;
+    block->prev = NULL;
+
+    if (worker->retired_tail) {
+        worker->retired_tail->next = block;
+    } else {
+        worker->retired_head = block;
+    }
+    worker->retired_tail = block;
+}
+
+/* Oldest epoch any other online worker may still be reading under */
+static uint64_t worker_min_peer_epoch(Worker *worker) {
+    Scheduler *sched = worker->scheduler;
+    uint64_t min = WORKER_EPOCH_OFFLINE;
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        Worker *w = sched->workers[i];
+        if (w == worker) continue;
+        uint64_t epoch = atomic_load(&w->epoch);
+        if (epoch < min) min = epoch;
+    }
+    return min;
+}
+
+/* Free retired blocks whose grace period has passed. Must be called at a
+ * quiescent point. */
+size_t worker_reclaim(Worker *worker) {
+    if (!worker || !worker->retired_head) return 0;
+
+    Scheduler *sched = worker->scheduler;
+    uint64_t min = worker_min_peer_epoch(worker);
+    if (atomic_load(&sched->foreign_readers) != 0) return 0;
+
+    size_t freed = 0;
+    while (worker->retired_head && worker->retired_head->retire_epoch < min) {
+        Block *block = worker->retired_head;
+        worker->retired_head = block->next;
+        block_free(block);
+        freed++;
+    }
+    if (!worker->retired_head) {
+        worker->retired_tail = NULL;
+    }
+
+    if (freed > 0) {
+        atomic_fetch_add(&worker->blocks_reclaimed, freed);
+    }
+    return freed;
+}
+
 /* Worker Main Loop */
 
 static bool all_work_done(Scheduler *sched) {
+    if (atomic_load(&sched->blocked)) return true;
+
     size_t spawned = atomic_load(&sched->total_spawned);
     size_t terminated = atomic_load(&sched->total_terminated);
     size_t in_flight = atomic_load(&sched->blocks_in_flight);
@@ -330,20 +520,231 @@ static bool all_work_done(Scheduler *sched) {
     return spawned > 0 && terminated >= spawned && in_flight == 0;
 }
 
+/* Fire due timers on this worker's wheel and the scheduler's shared wheel.
+ * Woken blocks land on this worker's deque. */
+static size_t worker_fire_timers(Worker *worker) {
+    TimerWheel *shared = worker->scheduler->timers;
+    if (timer_next_deadline(worker->timers) == 0 && timer_next_deadline(shared) == 0) {
+        return 0;
+    }
+
+    uint64_t now = timer_current_time_ms();
+    return timer_run_expired(worker->timers, now) + timer_run_expired(shared, now);
+}
+
+/* Parking
+ *
+ * An idle worker spins briefly, then sets its bit in the scheduler's idle
+ * bitmap and sleeps on its condition variable. Producers push first and
+ * then look at the bitmap; the parker sets its bit first and then looks at
+ * the queues. Both sides go through a seq_cst fence, so at least one of
+ * them sees the other and a push can never strand a parked worker.
+ *
+ * Wake-ups are skipped while any worker is still spinning: that worker
+ * will find the new block itself, which avoids a thundering herd when a
+ * burst of blocks becomes runnable. */
+
+/* Workers built outside scheduler_new have no idle bit and are woken directly */
+static bool worker_is_tracked(Scheduler *sched, Worker *worker) {
+    return sched->idle_workers && worker->id >= 0 &&
+           (size_t)worker->id < sched->worker_count &&
+           sched->workers[worker->id] == worker;
+}
+
+static bool idle_try_claim(Scheduler *sched, int id) {
+    uint64_t bit = 1ULL << (id % 64);
+    uint64_t old = atomic_fetch_and(&sched->idle_workers[id / 64], ~bit);
+    return (old & bit) != 0;
+}
+
+void worker_unpark(Worker *worker) {
+    if (!worker) return;
+
+    pthread_mutex_lock(&worker->park_lock);
+    worker->park_notified = true;
+    pthread_cond_signal(&worker->park_cond);
+    pthread_mutex_unlock(&worker->park_lock);
+}
+
+bool worker_wake_idle(Scheduler *sched, Worker *prefer) {
+    if (!sched) return false;
+
+    if (prefer && !worker_is_tracked(sched, prefer)) {
+        worker_unpark(prefer);
+        return true;
+    }
+    if (!sched->idle_workers) return false;
+
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load(&sched->spinning_workers) > 0) return false;
+
+    /* The target's own deque is the cheapest place to find the block */
+    if (prefer && idle_try_claim(sched, prefer->id)) {
+        worker_unpark(prefer);
+        return true;
+    }
+
+    for (size_t w = 0; w < sched->idle_words; w++) {
+        uint64_t word = atomic_load(&sched->idle_workers[w]);
+        while (word) {
+            int id = (int)(w * 64) + __builtin_ctzll(word);
+            if (idle_try_claim(sched, id)) {
+                worker_unpark(sched->workers[id]);
+                return true;
+            }
+            word &= word - 1;
+        }
+    }
+
+    return false;
+}
+
+void worker_wake_all(Scheduler *sched) {
+    if (!sched || !sched->idle_workers) return;
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        idle_try_claim(sched, (int)i);
+        worker_unpark(sched->workers[i]);
+    }
+}
+
+/* Earliest deadline across this worker's wheel and the shared wheel, 0 if none */
+static uint64_t worker_next_deadline(Worker *worker) {
+    uint64_t deadline = timer_next_deadline(worker->timers);
+    uint64_t shared = timer_next_deadline(worker->scheduler->timers);
+    if (shared != 0 && (deadline == 0 || shared < deadline)) {
+        deadline = shared;
+    }
+    return deadline;
+}
+
+static bool worker_has_visible_work(Worker *worker) {
+    Scheduler *sched = worker->scheduler;
+
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        Worker *w = sched->workers[i];
+        if (!deque_empty(&w->runq) || atomic_load(&w->inbox) != NULL) return true;
+    }
+    return false;
+}
+
+/* True when every tracked worker is parked, nothing is queued or running,
+ * no timer is armed and no peer node is attached: only a thread outside
+ * the pool could wake any of the remaining blocks. Mirrors scheduler_step
+ * returning false in single-threaded mode. Called by a parker after its
+ * own checks. */
+static bool worker_run_blocked(Worker *worker) {
+    Scheduler *sched = worker->scheduler;
+
+    /* Read the idle bits first: each peer armed its timers and finished
+     * its last block before setting its bit */
+    size_t idle = 0;
+    for (size_t w = 0; w < sched->idle_words; w++) {
+        idle += (size_t)__builtin_popcountll(atomic_load(&sched->idle_workers[w]));
+    }
+    if (idle < sched->worker_count) return false;
+
+    /* Peer nodes can send at any time */
+    if (sched->remote_send) return false;
+
+    if (atomic_load(&sched->blocks_in_flight) != 0) return false;
+    if (timer_has_pending(sched->timers)) return false;
+    for (size_t i = 0; i < sched->worker_count; i++) {
+        if (timer_has_pending(sched->workers[i]->timers)) return false;
+    }
+    return true;
+}
+
+/* Sleep until notified, stopped, or the next timer is due. Called while
+ * counted as spinning; returns still counted as spinning. */
+static void worker_park(Worker *worker) {
+    Scheduler *sched = worker->scheduler;
+    bool tracked = worker_is_tracked(sched, worker);
+    uint64_t bit = tracked ? 1ULL << (worker->id % 64) : 0;
+    _Atomic(uint64_t) *word = tracked ? &sched->idle_workers[worker->id / 64] : NULL;
+
+    if (tracked) atomic_fetch_or(word, bit);
+    atomic_fetch_sub(&sched->spinning_workers, 1);
+    atomic_thread_fence(memory_order_seq_cst);
+
+    uint64_t deadline = worker_next_deadline(worker);
+    uint64_t now = deadline ? timer_current_time_ms() : 0;
+
+    if (!deque_empty(&worker->runq) || atomic_load(&worker->inbox) != NULL ||
+        worker_has_visible_work(worker) ||
+        all_work_done(sched) || atomic_load(&worker->state) == WORKER_STOPPED ||
+        (deadline != 0 && deadline <= now)) {
+        if (tracked) atomic_fetch_and(word, ~bit);
+        atomic_fetch_add(&sched->spinning_workers, 1);
+        return;
+    }
+
+    /* The last worker to park with nothing left to wait for ends the run */
+    if (tracked && deadline == 0 && worker_run_blocked(worker)) {
+        LOG_DEBUG("worker %d: all live blocks are blocked, stopping", worker->id);
+        atomic_store(&sched->blocked, true);
+        atomic_fetch_and(word, ~bit);
+        atomic_fetch_add(&sched->spinning_workers, 1);
+        worker_wake_all(sched);
+        return;
+    }
+
+    struct timespec abstime;
+    if (deadline != 0) {
+        clock_gettime(CLOCK_MONOTONIC, &abstime);
+        uint64_t wait_ms = deadline - now;
+        abstime.tv_sec += (time_t)(wait_ms / 1000);
+        abstime.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+        if (abstime.tv_nsec >= 1000000000L) {
+            abstime.tv_sec++;
+            abstime.tv_nsec -= 1000000000L;
+        }
+    }
+
+    atomic_fetch_add(&worker->parks, 1);
+
+    /* A sleeping worker holds no block pointers; do not stall reclamation */
+    atomic_store(&worker->epoch, WORKER_EPOCH_OFFLINE);
+
+    pthread_mutex_lock(&worker->park_lock);
+    while (!worker->park_notified && atomic_load(&worker->state) != WORKER_STOPPED) {
+        if (deadline == 0) {
+            pthread_cond_wait(&worker->park_cond, &worker->park_lock);
+        } else if (pthread_cond_timedwait(&worker->park_cond, &worker->park_lock,
+                                          &abstime) == ETIMEDOUT) {
+            break;
+        }
+    }
+    worker->park_notified = false;
+    pthread_mutex_unlock(&worker->park_lock);
+
+    atomic_store(&worker->epoch, atomic_load(&sched->reclaim_epoch));
+
+    if (tracked) atomic_fetch_and(word, ~bit);
+    atomic_fetch_add(&sched->spinning_workers, 1);
+}
+
 static void *worker_loop(void *arg) {
     Worker *worker = (Worker *)arg;
     if (!worker) return NULL;
 
+    Scheduler *sched = worker->scheduler;
+
     worker_alloc_set_current(&worker->allocator);
+    tls_current_worker = worker;
 
     size_t idle_spins = 0;
-    const size_t SPIN_THRESHOLD = 20;  /* Reduced from 100 for better performance */
-    const size_t TERMINATION_CHECK_INTERVAL = 100;
-
-    size_t backoff_us = 10;
-    const size_t MAX_BACKOFF_US = 1000;
+    const size_t SPIN_THRESHOLD = 20;
+    bool spinning = false;
 
     while (atomic_load(&worker->state) != WORKER_STOPPED) {
+        /* Quiescent point: no block pointers survive across iterations */
+        atomic_store(&worker->epoch, atomic_load(&sched->reclaim_epoch));
+        worker_reclaim(worker);
+
+        worker_fire_timers(worker);
+        worker_drain_inbox(worker);
+
         Block *block = deque_pop(&worker->runq);
 
         if (!block) {
@@ -356,67 +757,86 @@ static void *worker_loop(void *arg) {
 
         if (block) {
             idle_spins = 0;
-            backoff_us = 10;
+            if (spinning) {
+                spinning = false;
+                atomic_fetch_sub(&sched->spinning_workers, 1);
+            }
 
             /* Track block as in-flight to prevent premature termination */
-            atomic_fetch_add(&worker->scheduler->blocks_in_flight, 1);
+            atomic_fetch_add(&sched->blocks_in_flight, 1);
+
+            bool terminated = false;
+            if (scheduler_take_exit_signal(sched, block)) {
+                /* Killed by a link or scheduler_kill while queued */
+                terminated = true;
+            } else if (block_is_alive(block)) {
+                /* Senders read this to wake the block; only blocks
+                 * registered from outside still need it set */
+                if (block->vm->scheduler != sched) {
+                    block->vm->scheduler = sched;
+                }
 
-            VM *vm = block->vm;
-            vm->scheduler = worker->scheduler;
+                BlockRunResult result = block_run(block);
 
-            vm->reduction_limit = block->limits.max_reductions;
-            vm->reductions = 0;
+                atomic_fetch_add(&worker->blocks_executed, 1);
+                atomic_fetch_add(&worker->total_reductions, block->vm->reductions);
 
-            VMResult result = vm_run(vm);
+                switch (result) {
+                case BLOCK_RUN_YIELD:
+                    if (atomic_load(&block->state) == BLOCK_RUNNABLE) {
+                        deque_push(&worker->runq, block);
+                    }
+                    break;
 
-            atomic_fetch_add(&worker->blocks_executed, 1);
-            atomic_fetch_add(&worker->total_reductions, vm->reductions);
+                case BLOCK_RUN_WAITING:
+                    /* Last touch of the block this slice: once parked, a
+                     * send or timer may hand it to another worker */
+                    if (!block_park(block)) {
+                        deque_push(&worker->runq, block);
+                    }
+                    break;
 
-            switch (result) {
-            case VM_YIELD:
-                if (atomic_load(&block->state) == BLOCK_RUNNABLE) {
-                    deque_push(&worker->runq, block);
+                case BLOCK_RUN_OK:
+                case BLOCK_RUN_HALTED:
+                case BLOCK_RUN_ERROR:
+                    scheduler_terminate_block(sched, block);
+                    terminated = true;
+                    break;
                 }
-                break;
-
-            case VM_WAITING:
-                break;
-
-            case VM_OK:
-            case VM_HALT:
-                atomic_store(&block->state, BLOCK_DEAD);
-                atomic_fetch_add(&worker->scheduler->total_terminated, 1);
-                break;
-
-            default:
-                atomic_store(&block->state, BLOCK_DEAD);
-                atomic_fetch_add(&worker->scheduler->total_terminated, 1);
-                break;
             }
 
             /* Mark block as no longer in-flight */
-            atomic_fetch_sub(&worker->scheduler->blocks_in_flight, 1);
+            atomic_fetch_sub(&sched->blocks_in_flight, 1);
+
+            /* The last block out releases every parked worker so they exit */
+            if (terminated && all_work_done(sched)) {
+                worker_wake_all(sched);
+            }
         } else {
-            idle_spins++;
+            if (!spinning) {
+                spinning = true;
+                atomic_fetch_add(&sched->spinning_workers, 1);
+            }
 
-            if (idle_spins % TERMINATION_CHECK_INTERVAL == 0) {
-                if (all_work_done(worker->scheduler)) {
-                    break;
-                }
+            if (all_work_done(sched)) {
+                break;
             }
 
-            if (idle_spins > SPIN_THRESHOLD) {
-                usleep((useconds_t)backoff_us);
-                if (backoff_us < MAX_BACKOFF_US) {
-                    backoff_us *= 2;
-                    if (backoff_us > MAX_BACKOFF_US) {
-                        backoff_us = MAX_BACKOFF_US;
-                    }
-                }
+            if (++idle_spins > SPIN_THRESHOLD) {
+                worker_park(worker);
+                idle_spins = 0;
             }
         }
     }
 
+    if (spinning) {
+        atomic_fetch_sub(&sched->spinning_workers, 1);
+    }
+
+    atomic_store(&worker->epoch, WORKER_EPOCH_OFFLINE);
+    worker_reclaim(worker);
+
+    tls_current_worker = NULL;
     worker_alloc_set_current(NULL);
 
     return NULL;
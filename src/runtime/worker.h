@@ -66,24 +66,50 @@ typedef struct Worker {
     pthread_t thread;
     _Atomic(bool) thread_started;
     WorkDeque runq;
+    _Atomic(Block *) inbox;  /* Blocks pushed by other threads, LIFO */
     VM *vm;
     Scheduler *scheduler;
     WorkerAllocator allocator;
+    TimerWheel *timers;  /* Timers armed by blocks running on this worker */
     _Atomic(WorkerState) state;
+    pthread_mutex_t park_lock;
+    pthread_cond_t park_cond;
+    bool park_notified;  /* Protected by park_lock */
     uint64_t rng_state;
     _Atomic(size_t) blocks_executed;
     _Atomic(size_t) steals_attempted;
     _Atomic(size_t) steals_successful;
     _Atomic(size_t) total_reductions;
+    _Atomic(size_t) parks;
+    _Atomic(uint64_t) epoch;  /* Reclamation epoch seen at the last quiescent point */
+    Block *retired_head;      /* Dead blocks awaiting a grace period, oldest first */
+    Block *retired_tail;
+    _Atomic(size_t) blocks_reclaimed;
 } Worker;
 
+/* Published while a worker holds no block pointers, e.g. parked or exited */
+#define WORKER_EPOCH_OFFLINE UINT64_MAX
+
 Worker *worker_new(int id, Scheduler *scheduler);
 void worker_free(Worker *worker);
 bool worker_start(Worker *worker);
 void worker_stop(Worker *worker);
 void worker_join(Worker *worker);
 void worker_enqueue(Worker *worker, Block *block);
+size_t worker_drain_inbox(Worker *worker);
 Block *worker_steal(Worker *worker);
+Worker *worker_current(void);
+
+/* Reclamation */
+
+void worker_retire(Worker *worker, Block *block);
+size_t worker_reclaim(Worker *worker);
+
+/* Parking */
+
+void worker_unpark(Worker *worker);
+bool worker_wake_idle(Scheduler *scheduler, Worker *prefer);
+void worker_wake_all(Scheduler *scheduler);
 
 /* Multi-threaded Scheduler Configuration */
 
@@ -25,36 +25,36 @@ Heap *array_get_gc_heap(void) {
 
 /* Array Creation */
 
-Value *value_array_with_capacity(size_t capacity) {
-    Value *v = agim_alloc(sizeof(Value));
-    if (!v) {
-        LOG_ERROR("array: failed to allocate Value");
-        return NULL;
-    }
-
-    v->type = VAL_ARRAY;
-    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
-    v->flags = 0;
-    v->gc_state = 0;
-    v->next = NULL;
-
-    Array *arr = agim_alloc(sizeof(Array));
+bool value_init_array(Value *v, size_t capacity) {
+    Array *arr = value_mem_alloc(sizeof(Array));
     if (!arr) {
         LOG_ERROR("array: failed to allocate Array struct");
-        agim_free(v);
-        return NULL;
+        return false;
     }
     arr->length = 0;
     arr->capacity = capacity > 0 ? capacity : 8;
     arr->items = agim_alloc(sizeof(Value *) * arr->capacity);
     if (!arr->items) {
         LOG_ERROR("array: failed to allocate items buffer for capacity %zu", arr->capacity);
-        agim_free(arr);
-        agim_free(v);
-        return NULL;
+        value_mem_free(arr);
+        return false;
     }
 
+    value_init_header(v, VAL_ARRAY, 0);
     v->as.array = arr;
+    return true;
+}
+
+Value *value_array_with_capacity(size_t capacity) {
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) {
+        LOG_ERROR("array: failed to allocate Value");
+        return NULL;
+    }
+    if (!value_init_array(v, capacity)) {
+        value_mem_free(v);
+        return NULL;
+    }
     return v;
 }
 
@@ -142,25 +142,28 @@ static bool array_ensure_capacity(Array *arr, size_t needed) {
 static Value *array_ensure_writable(Value *v) {
     if (!v || v->type != VAL_ARRAY) return v;
 
-    if (!value_needs_cow(v)) {
+    /* Frozen values are copied even when unshared, since their children
+     * may be reachable from other blocks */
+    bool shared = value_needs_cow(v);
+    if (!shared && !(v->flags & VALUE_IMMUTABLE)) {
         return v;
     }
 
     Array *old = v->as.array;
 
-    Value *new_v = agim_alloc(sizeof(Value));
+    Value *new_v = value_mem_alloc(sizeof(Value));
     if (!new_v) return NULL;
 
-    Array *new_arr = agim_alloc(sizeof(Array));
+    Array *new_arr = value_mem_alloc(sizeof(Array));
     if (!new_arr) {
-        agim_free(new_v);
+        value_mem_free(new_v);
         return NULL;
     }
 
     Value **items = agim_alloc(sizeof(Value *) * old->capacity);
     if (!items) {
-        agim_free(new_arr);
-        agim_free(new_v);
+        value_mem_free(new_arr);
+        value_mem_free(new_v);
         return NULL;
     }
 
@@ -180,7 +183,10 @@ static Value *array_ensure_writable(Value *v) {
 
     new_v->as.array = new_arr;
 
-    value_release(v);
+    /* The copy replaces the caller's reference to the original, which
+     * goes if that was the last one (always so for an unshared frozen
+     * value) */
+    value_free(v);
 
     return new_v;
 }
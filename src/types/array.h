@@ -26,6 +26,7 @@ typedef struct Array {
 
 Value *value_array(void);
 Value *value_array_with_capacity(size_t capacity);
+bool value_init_array(Value *v, size_t capacity);
 
 /* Array Properties */
 
@@ -28,7 +28,7 @@ Heap *closure_get_gc_heap(void) {
 Value *value_closure(Function *function, size_t upvalue_count) {
     if (!function) return value_nil();
 
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) {
         LOG_ERROR("closure: failed to allocate Value");
         return NULL;
@@ -37,7 +37,7 @@ Value *value_closure(Function *function, size_t upvalue_count) {
     Closure *closure = agim_alloc(sizeof(Closure));
     if (!closure) {
         LOG_ERROR("closure: failed to allocate Closure");
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
 
@@ -47,7 +47,7 @@ Value *value_closure(Function *function, size_t upvalue_count) {
         if (!upvalues) {
             LOG_ERROR("closure: failed to allocate %zu upvalues", upvalue_count);
             agim_free(closure);
-            agim_free(v);
+            value_mem_free(v);
             return NULL;
         }
         memset(upvalues, 0, sizeof(Upvalue *) * upvalue_count);
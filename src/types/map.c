@@ -27,37 +27,37 @@ Heap *map_get_gc_heap(void) {
 
 /* Map Creation */
 
-Value *value_map_with_capacity(size_t capacity) {
-    Value *v = agim_alloc(sizeof(Value));
-    if (!v) {
-        LOG_ERROR("map: failed to allocate Value");
-        return NULL;
-    }
-
-    v->type = VAL_MAP;
-    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
-    v->flags = 0;
-    v->gc_state = 0;
-    v->next = NULL;
-
-    Map *map = agim_alloc(sizeof(Map));
+bool value_init_map(Value *v, size_t capacity) {
+    Map *map = value_mem_alloc(sizeof(Map));
     if (!map) {
         LOG_ERROR("map: failed to allocate Map struct");
-        agim_free(v);
-        return NULL;
+        return false;
     }
     map->size = 0;
     map->capacity = capacity > 0 ? capacity : 16;
     map->buckets = agim_alloc(sizeof(MapEntry *) * map->capacity);
     if (!map->buckets) {
         LOG_ERROR("map: failed to allocate buckets for capacity %zu", map->capacity);
-        agim_free(map);
-        agim_free(v);
-        return NULL;
+        value_mem_free(map);
+        return false;
     }
     memset(map->buckets, 0, sizeof(MapEntry *) * map->capacity);
 
+    value_init_header(v, VAL_MAP, 0);
     v->as.map = map;
+    return true;
+}
+
+Value *value_map_with_capacity(size_t capacity) {
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) {
+        LOG_ERROR("map: failed to allocate Value");
+        return NULL;
+    }
+    if (!value_init_map(v, capacity)) {
+        value_mem_free(v);
+        return NULL;
+    }
     return v;
 }
 
@@ -82,14 +82,15 @@ size_t map_capacity(const Value *v) {
 /* Limit chain depth to protect against hash collision DoS */
 #define MAP_MAX_CHAIN_DEPTH 16
 
-static MapEntry *find_entry_internal(Map *map, const char *key, size_t key_hash) {
+static MapEntry *find_entry_internal(Map *map, const char *key, size_t key_len,
+                                     size_t key_hash) {
     size_t index = key_hash % map->capacity;
     MapEntry *entry = map->buckets[index];
     size_t depth = 0;
 
     while (entry && depth < MAP_MAX_CHAIN_DEPTH) {
-        if (entry->key->hash == key_hash &&
-            strcmp(entry->key->data, key) == 0) {
+        if (entry->key->hash == key_hash && entry->key->length == key_len &&
+            memcmp(entry->key->data, key, key_len) == 0) {
             return entry;
         }
         entry = entry->next;
@@ -135,26 +136,29 @@ static void map_resize(Map *map, size_t new_capacity) {
 static Value *map_ensure_writable(Value *v) {
     if (!v || v->type != VAL_MAP) return v;
 
-    if (!value_needs_cow(v)) {
+    /* Frozen values are copied even when unshared, since their children
+     * may be reachable from other blocks */
+    bool shared = value_needs_cow(v);
+    if (!shared && !(v->flags & VALUE_IMMUTABLE)) {
         return v;
     }
 
     /* COW: create new Value with cloned Map */
     Map *old = v->as.map;
 
-    Value *new_v = agim_alloc(sizeof(Value));
+    Value *new_v = value_mem_alloc(sizeof(Value));
     if (!new_v) return NULL;
 
-    Map *new_map = agim_alloc(sizeof(Map));
+    Map *new_map = value_mem_alloc(sizeof(Map));
     if (!new_map) {
-        agim_free(new_v);
+        value_mem_free(new_v);
         return NULL;
     }
 
     MapEntry **buckets = agim_alloc(sizeof(MapEntry *) * old->capacity);
     if (!buckets) {
-        agim_free(new_map);
-        agim_free(new_v);
+        value_mem_free(new_map);
+        value_mem_free(new_v);
         return NULL;
     }
     memset(buckets, 0, sizeof(MapEntry *) * old->capacity);
@@ -174,7 +178,7 @@ static Value *map_ensure_writable(Value *v) {
         MapEntry **dst = &new_map->buckets[i];
 
         while (src) {
-            MapEntry *entry = agim_alloc(sizeof(MapEntry));
+            MapEntry *entry = value_mem_alloc(sizeof(MapEntry));
             if (!entry) {
                 /* Cleanup on allocation failure */
                 new_v->as.map = new_map;
@@ -183,9 +187,9 @@ static Value *map_ensure_writable(Value *v) {
             }
 
             size_t key_len = src->key->length;
-            String *key_str = agim_alloc(sizeof(String) + key_len + 1);
+            String *key_str = value_mem_alloc(sizeof(String) + key_len + 1);
             if (!key_str) {
-                agim_free(entry);
+                value_mem_free(entry);
                 new_v->as.map = new_map;
                 value_free(new_v);
                 return NULL;
@@ -205,7 +209,10 @@ static Value *map_ensure_writable(Value *v) {
     }
 
     new_v->as.map = new_map;
-    value_release(v);
+    /* The copy replaces the caller's reference to the original, which
+     * goes if that was the last one (always so for an unshared frozen
+     * value) */
+    value_free(v);
 
     return new_v;
 }
@@ -216,8 +223,9 @@ MapEntry *map_find_entry(const Value *v, const char *key) {
     if (!v || v->type != VAL_MAP) return NULL;
     Map *map = v->as.map;
 
-    size_t key_hash = agim_hash_cstring(key);
-    return find_entry_internal(map, key, key_hash);
+    size_t key_len = strlen(key);
+    size_t key_hash = agim_hash_string(key, key_len);
+    return find_entry_internal(map, key, key_len, key_hash);
 }
 
 Value *map_get(const Value *v, const char *key) {
@@ -226,6 +234,11 @@ Value *map_get(const Value *v, const char *key) {
 }
 
 Value *map_set(Value *v, const char *key, Value *value) {
+    if (!key) return v;
+    return map_set_n(v, key, strlen(key), value);
+}
+
+Value *map_set_n(Value *v, const char *key, size_t key_len, Value *value) {
     if (!v || v->type != VAL_MAP) return v;
 
     Value *writable = map_ensure_writable(v);
@@ -238,10 +251,9 @@ Value *map_set(Value *v, const char *key, Value *value) {
         gc_write_barrier(heap, writable, value);
     }
 
-    size_t key_len = strlen(key);
     size_t key_hash = agim_hash_string(key, key_len);
 
-    MapEntry *existing = find_entry_internal(map, key, key_hash);
+    MapEntry *existing = find_entry_internal(map, key, key_len, key_hash);
     if (existing) {
         /* Free the old value being replaced */
         if (existing->value) {
@@ -265,17 +277,18 @@ Value *map_set(Value *v, const char *key, Value *value) {
         index = key_hash % map->capacity;
     }
 
-    MapEntry *entry = agim_alloc(sizeof(MapEntry));
+    MapEntry *entry = value_mem_alloc(sizeof(MapEntry));
     if (!entry) return writable;
 
-    String *key_str = agim_alloc(sizeof(String) + key_len + 1);
+    String *key_str = value_mem_alloc(sizeof(String) + key_len + 1);
     if (!key_str) {
-        agim_free(entry);
+        value_mem_free(entry);
         return writable;
     }
     key_str->length = key_len;
     key_str->hash = key_hash;
-    memcpy(key_str->data, key, key_len + 1);
+    memcpy(key_str->data, key, key_len);
+    key_str->data[key_len] = '\0';
 
     entry->key = key_str;
     entry->value = value;
@@ -317,8 +330,8 @@ Value *map_delete(Value *v, const char *key) {
             if (entry->value) {
                 value_free(entry->value);
             }
-            agim_free(entry->key);
-            agim_free(entry);
+            value_mem_free(entry->key);
+            value_mem_free(entry);
             map->size--;
             return writable;
         }
@@ -344,8 +357,8 @@ Value *map_clear(Value *v) {
             if (entry->value) {
                 value_free(entry->value);
             }
-            agim_free(entry->key);
-            agim_free(entry);
+            value_mem_free(entry->key);
+            value_mem_free(entry);
             entry = next;
         }
         map->buckets[i] = NULL;
@@ -32,6 +32,7 @@ typedef struct Map {
 
 Value *value_map(void);
 Value *value_map_with_capacity(size_t capacity);
+bool value_init_map(Value *v, size_t capacity);
 
 /* Map Properties */
 
@@ -42,6 +43,7 @@ size_t map_capacity(const Value *v);
 
 Value *map_get(const Value *v, const char *key);
 Value *map_set(Value *v, const char *key, Value *value);
+Value *map_set_n(Value *v, const char *key, size_t key_len, Value *value);
 bool map_has(const Value *v, const char *key);
 Value *map_delete(Value *v, const char *key);
 Value *map_clear(Value *v);
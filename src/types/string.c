@@ -19,31 +19,32 @@
 
 /* String Creation */
 
-Value *value_string_n(const char *str, size_t length) {
-    Value *v = agim_alloc(sizeof(Value));
-    if (!v) {
-        LOG_ERROR("string: failed to allocate Value for string");
-        return NULL;
-    }
-
-    v->type = VAL_STRING;
-    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
-    v->flags = VALUE_IMMUTABLE;
-    v->gc_state = 0;
-    v->next = NULL;
-
-    String *s = agim_alloc(sizeof(String) + length + 1);
+bool value_init_string_n(Value *v, const char *str, size_t length) {
+    String *s = value_mem_alloc(sizeof(String) + length + 1);
     if (!s) {
         LOG_ERROR("string: failed to allocate String data of length %zu", length);
-        agim_free(v);
-        return NULL;
+        return false;
     }
     s->length = length;
     s->hash = agim_hash_string(str, length);
     memcpy(s->data, str, length);
     s->data[length] = '\0';
 
+    value_init_header(v, VAL_STRING, VALUE_IMMUTABLE);
     v->as.string = s;
+    return true;
+}
+
+Value *value_string_n(const char *str, size_t length) {
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) {
+        LOG_ERROR("string: failed to allocate Value for string");
+        return NULL;
+    }
+    if (!value_init_string_n(v, str, length)) {
+        value_mem_free(v);
+        return NULL;
+    }
     return v;
 }
 
@@ -175,7 +176,7 @@ Value *string_concat(const Value *a, const Value *b) {
     size_t total = len_a + len_b;
 
     /* Allocate Value and String directly without temporary buffer */
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return value_nil();
 
     v->type = VAL_STRING;
@@ -184,9 +185,9 @@ Value *string_concat(const Value *a, const Value *b) {
     v->gc_state = 0;
     v->next = NULL;
 
-    String *s = agim_alloc(sizeof(String) + total + 1);
+    String *s = value_mem_alloc(sizeof(String) + total + 1);
     if (!s) {
-        agim_free(v);
+        value_mem_free(v);
         return value_nil();
     }
     s->length = total;
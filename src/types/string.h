@@ -26,6 +26,7 @@ typedef struct String {
 
 Value *value_string(const char *str);
 Value *value_string_n(const char *str, size_t length);
+bool value_init_string_n(Value *v, const char *str, size_t length);
 
 /* String interning for commonly used strings */
 Value *string_intern(const char *str, size_t len);
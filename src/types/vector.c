@@ -16,44 +16,46 @@
 
 /* Vector Creation */
 
-Value *value_vector(size_t dim) {
-    if (dim == 0) return value_nil();
-
-    Value *v = agim_alloc(sizeof(Value));
-    if (!v) {
-        LOG_ERROR("vector: failed to allocate Value");
-        return NULL;
-    }
+bool value_init_vector(Value *v, size_t dim) {
+    if (dim == 0) return false;
 
     Vector *vec = agim_alloc(sizeof(Vector) + sizeof(double) * dim);
     if (!vec) {
         LOG_ERROR("vector: failed to allocate Vector of dim %zu", dim);
-        agim_free(v);
-        return NULL;
+        return false;
     }
-
-    v->type = VAL_VECTOR;
-    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
-    v->flags = VALUE_IMMUTABLE;
-    v->gc_state = 0;
-    v->next = NULL;
-
     vec->dim = dim;
     memset(vec->data, 0, sizeof(double) * dim);
 
+    value_init_header(v, VAL_VECTOR, VALUE_IMMUTABLE);
     v->as.vector = vec;
+    return true;
+}
+
+Value *value_vector(size_t dim) {
+    if (dim == 0) return value_nil();
+
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) {
+        LOG_ERROR("vector: failed to allocate Value");
+        return NULL;
+    }
+    if (!value_init_vector(v, dim)) {
+        value_mem_free(v);
+        return NULL;
+    }
     return v;
 }
 
 Value *value_vector_from(const double *data, size_t dim) {
     if (!data || dim == 0) return value_nil();
 
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
 
     Vector *vec = agim_alloc(sizeof(Vector) + sizeof(double) * dim);
     if (!vec) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
 
@@ -26,6 +26,7 @@ typedef struct Vector {
 /* Vector Creation */
 
 Value *value_vector(size_t dim);
+bool value_init_vector(Value *v, size_t dim);
 Value *value_vector_from(const double *data, size_t dim);
 
 /* Vector Properties */
@@ -5,12 +5,16 @@
  * SPDX-License-Identifier: MIT
  */
 
+#define _DEFAULT_SOURCE
+
 #include "util/worker_alloc.h"
 #include "util/alloc.h"
 #include "debug/log.h"
 
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 
 /* Pool Size Configuration */
 
@@ -27,14 +31,150 @@ static inline int find_pool_index(size_t size) {
     return -1;
 }
 
-/* Pool Operations */
+static size_t pool_block_size(size_t size) {
+    if (size < sizeof(WorkerFreeBlock)) {
+        size = sizeof(WorkerFreeBlock);
+    }
+    return align_size(size, 8);
+}
 
-static void pool_init(WorkerPool *pool, size_t block_size) {
-    if (block_size < sizeof(WorkerFreeBlock)) {
-        block_size = sizeof(WorkerFreeBlock);
+static size_t chunk_capacity(uint32_t pool) {
+    return (WORKER_ALLOC_CHUNK_SIZE - sizeof(WorkerChunk)) / pool_block_size(pool_sizes[pool]);
+}
+
+static inline WorkerChunk *chunk_of(const void *ptr) {
+    return (WorkerChunk *)((uintptr_t)ptr & ~(uintptr_t)(WORKER_ALLOC_CHUNK_SIZE - 1));
+}
+
+/* Chunk Region
+ *
+ * Pages are committed on first touch and never unmapped. Chunks given up
+ * by an allocator go on a global free list for the next one to reuse;
+ * chunks it gave up with blocks still out wait on the orphan list until
+ * those blocks are freed.
+ */
+
+static _Atomic(char *) region_base = NULL;
+static _Atomic(size_t) region_used = 0;
+static pthread_once_t region_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t region_lock = PTHREAD_MUTEX_INITIALIZER;
+static WorkerChunk *region_free_chunks = NULL;
+static WorkerRemote *region_orphans = NULL;
+
+static void region_init(void) {
+    void *base = mmap(NULL, WORKER_ALLOC_REGION_SIZE, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR("worker_alloc: failed to reserve %zu bytes for pool chunks",
+                  (size_t)WORKER_ALLOC_REGION_SIZE);
+        return;
+    }
+
+    /* Align the base so chunk headers can be found by masking */
+    uintptr_t aligned = ((uintptr_t)base + WORKER_ALLOC_CHUNK_SIZE - 1) &
+                        ~(uintptr_t)(WORKER_ALLOC_CHUNK_SIZE - 1);
+    atomic_store_explicit(&region_used, aligned - (uintptr_t)base, memory_order_relaxed);
+    atomic_store_explicit(&region_base, (char *)base, memory_order_release);
+}
+
+/* Caller holds region_lock */
+static void region_push_free(WorkerChunk *chunk) {
+    chunk->next = region_free_chunks;
+    region_free_chunks = chunk;
+}
+
+/* Count the blocks freed into an orphan since the last look and give back
+ * every chunk that is whole again. Once none are left no block can reach
+ * the lists any more. Caller holds region_lock. */
+static bool orphan_collect(WorkerRemote *orphan) {
+    for (int i = 0; i < WORKER_ALLOC_NUM_POOLS; i++) {
+        WorkerFreeBlock *block = atomic_exchange_explicit(&orphan->free_lists[i], NULL,
+                                                          memory_order_acquire);
+        while (block) {
+            chunk_of(block)->free_blocks++;
+            block = block->next;
+        }
+    }
+
+    WorkerChunk **pp = &orphan->orphaned_chunks;
+    while (*pp) {
+        WorkerChunk *chunk = *pp;
+        if (chunk->free_blocks == chunk_capacity(chunk->pool)) {
+            *pp = chunk->next;
+            region_push_free(chunk);
+        } else {
+            pp = &chunk->next;
+        }
+    }
+    return orphan->orphaned_chunks == NULL;
+}
+
+/* Caller holds region_lock */
+static void region_collect_orphans(void) {
+    WorkerRemote **pp = &region_orphans;
+    while (*pp) {
+        WorkerRemote *orphan = *pp;
+        if (orphan_collect(orphan)) {
+            *pp = orphan->next_orphan;
+            free(orphan);
+        } else {
+            pp = &orphan->next_orphan;
+        }
+    }
+}
+
+static WorkerChunk *region_chunk_acquire(void) {
+    pthread_once(&region_once, region_init);
+    char *base = atomic_load_explicit(&region_base, memory_order_acquire);
+    if (!base) return NULL;
+
+    pthread_mutex_lock(&region_lock);
+    if (!region_free_chunks) {
+        region_collect_orphans();
+    }
+    WorkerChunk *chunk = region_free_chunks;
+    if (chunk) {
+        region_free_chunks = chunk->next;
     }
+    pthread_mutex_unlock(&region_lock);
+    if (chunk) return chunk;
+
+    size_t offset = atomic_fetch_add_explicit(&region_used, WORKER_ALLOC_CHUNK_SIZE,
+                                              memory_order_relaxed);
+    if (offset + WORKER_ALLOC_CHUNK_SIZE > WORKER_ALLOC_REGION_SIZE) {
+        LOG_ERROR("worker_alloc: pool chunk region exhausted");
+        return NULL;
+    }
+    return (WorkerChunk *)(base + offset);
+}
 
-    pool->block_size = align_size(block_size, 8);
+static void region_chunk_release(WorkerChunk *chunk) {
+    pthread_mutex_lock(&region_lock);
+    region_push_free(chunk);
+    pthread_mutex_unlock(&region_lock);
+}
+
+/* Leave chunks with blocks still out to the allocator's remote lists */
+static void region_orphan(WorkerRemote *remote, WorkerChunk *chunks) {
+    pthread_mutex_lock(&region_lock);
+    remote->orphaned_chunks = chunks;
+    remote->next_orphan = region_orphans;
+    region_orphans = remote;
+    pthread_mutex_unlock(&region_lock);
+}
+
+bool worker_alloc_owns(const void *ptr) {
+    /* A pointer from the region was handed over after the region was
+     * published, so a relaxed load is enough to classify it */
+    const char *base = atomic_load_explicit(&region_base, memory_order_relaxed);
+    return base && (const char *)ptr >= base &&
+           (const char *)ptr < base + WORKER_ALLOC_REGION_SIZE;
+}
+
+/* Pool Operations */
+
+static void pool_init(WorkerPool *pool, size_t block_size) {
+    pool->block_size = pool_block_size(block_size);
     pool->blocks_per_chunk = (WORKER_ALLOC_CHUNK_SIZE - sizeof(WorkerChunk)) / pool->block_size;
     pool->free_list = NULL;
     pool->chunks = NULL;
@@ -42,11 +182,26 @@ static void pool_init(WorkerPool *pool, size_t block_size) {
     pool->free_count = 0;
 }
 
-static void pool_free_all(WorkerPool *pool) {
+/* Give the pool's wholly free chunks back to the region. The rest go on
+ * in_use, with their free blocks counted, to wait for the blocks still out
+ * elsewhere. */
+static void pool_free_all(WorkerPool *pool, WorkerChunk **in_use) {
+    for (WorkerChunk *chunk = pool->chunks; chunk; chunk = chunk->next) {
+        chunk->free_blocks = 0;
+    }
+    for (WorkerFreeBlock *block = pool->free_list; block; block = block->next) {
+        chunk_of(block)->free_blocks++;
+    }
+
     WorkerChunk *chunk = pool->chunks;
     while (chunk) {
         WorkerChunk *next = chunk->next;
-        free(chunk);
+        if (chunk->free_blocks == pool->blocks_per_chunk) {
+            region_chunk_release(chunk);
+        } else {
+            chunk->next = *in_use;
+            *in_use = chunk;
+        }
         chunk = next;
     }
     pool->chunks = NULL;
@@ -55,15 +210,14 @@ static void pool_free_all(WorkerPool *pool) {
     pool->free_count = 0;
 }
 
-static bool pool_grow(WorkerPool *pool) {
-    size_t chunk_size = sizeof(WorkerChunk) + pool->block_size * pool->blocks_per_chunk;
-    WorkerChunk *chunk = malloc(chunk_size);
-    if (!chunk) {
-        LOG_ERROR("worker_alloc: failed to allocate chunk of %zu bytes", chunk_size);
-        return false;
-    }
+static bool pool_grow(WorkerAllocator *alloc, int idx) {
+    WorkerPool *pool = &alloc->pools[idx];
+    WorkerChunk *chunk = region_chunk_acquire();
+    if (!chunk) return false;
 
     chunk->next = pool->chunks;
+    chunk->owner = alloc->remote;
+    chunk->pool = (uint32_t)idx;
     pool->chunks = chunk;
 
     char *block = chunk->data;
@@ -78,9 +232,34 @@ static bool pool_grow(WorkerPool *pool) {
     return true;
 }
 
-static void *pool_alloc(WorkerPool *pool) {
+/* Take back everything other threads have freed into this pool */
+static bool pool_drain_remote(WorkerAllocator *alloc, int idx) {
+    if (!alloc->remote) return false;
+
+    WorkerFreeBlock *list = atomic_exchange_explicit(&alloc->remote->free_lists[idx], NULL,
+                                                     memory_order_acquire);
+    if (!list) return false;
+
+    WorkerPool *pool = &alloc->pools[idx];
+    size_t count = 1;
+    WorkerFreeBlock *tail = list;
+    while (tail->next) {
+        tail = tail->next;
+        count++;
+    }
+
+    tail->next = pool->free_list;
+    pool->free_list = list;
+    pool->allocated_count -= count;
+    pool->free_count += count;
+    return true;
+}
+
+static void *pool_alloc(WorkerAllocator *alloc, int idx) {
+    WorkerPool *pool = &alloc->pools[idx];
+
     if (!pool->free_list) {
-        if (!pool_grow(pool)) {
+        if (!pool_drain_remote(alloc, idx) && !pool_grow(alloc, idx)) {
             return NULL;
         }
     }
@@ -103,12 +282,37 @@ static void pool_dealloc(WorkerPool *pool, void *ptr) {
     pool->free_count++;
 }
 
+/* Free a pool block on behalf of whichever thread is running */
+static void chunk_block_free(WorkerAllocator *local, void *ptr) {
+    WorkerChunk *chunk = chunk_of(ptr);
+    WorkerRemote *owner = chunk->owner;
+
+    if (local && owner && local->remote == owner) {
+        pool_dealloc(&local->pools[chunk->pool], ptr);
+        return;
+    }
+    if (!owner) return;  /* Allocator had no remote lists; the block leaks */
+
+    _Atomic(WorkerFreeBlock *) *head = &owner->free_lists[chunk->pool];
+    WorkerFreeBlock *block = (WorkerFreeBlock *)ptr;
+    WorkerFreeBlock *expected = atomic_load_explicit(head, memory_order_relaxed);
+    do {
+        block->next = expected;
+    } while (!atomic_compare_exchange_weak_explicit(head, &expected, block,
+                                                    memory_order_release,
+                                                    memory_order_relaxed));
+}
+
 /* Worker Allocator Implementation */
 
 void worker_alloc_init(WorkerAllocator *alloc, int worker_id) {
     if (!alloc) return;
 
     alloc->worker_id = worker_id;
+    alloc->remote = calloc(1, sizeof(WorkerRemote));
+    if (!alloc->remote) {
+        LOG_ERROR("worker_alloc: failed to allocate remote-free lists for worker %d", worker_id);
+    }
 
     for (int i = 0; i < WORKER_ALLOC_NUM_POOLS; i++) {
         pool_init(&alloc->pools[i], pool_sizes[i]);
@@ -118,9 +322,20 @@ void worker_alloc_init(WorkerAllocator *alloc, int worker_id) {
 void worker_alloc_free(WorkerAllocator *alloc) {
     if (!alloc) return;
 
+    WorkerChunk *in_use = NULL;
     for (int i = 0; i < WORKER_ALLOC_NUM_POOLS; i++) {
-        pool_free_all(&alloc->pools[i]);
+        pool_drain_remote(alloc, i);
+        pool_free_all(&alloc->pools[i], &in_use);
     }
+
+    /* Blocks still out get freed onto the remote lists, so those outlive
+     * us until the chunks come back. Without lists the chunks are lost. */
+    if (in_use && alloc->remote) {
+        region_orphan(alloc->remote, in_use);
+    } else {
+        free(alloc->remote);
+    }
+    alloc->remote = NULL;
 }
 
 void *worker_alloc_alloc(WorkerAllocator *alloc, size_t size) {
@@ -130,7 +345,7 @@ void *worker_alloc_alloc(WorkerAllocator *alloc, size_t size) {
 
     int idx = find_pool_index(size);
     if (idx >= 0) {
-        return pool_alloc(&alloc->pools[idx]);
+        return pool_alloc(alloc, idx);
     }
 
     return malloc(size);
@@ -139,14 +354,9 @@ void *worker_alloc_alloc(WorkerAllocator *alloc, size_t size) {
 void worker_alloc_dealloc(WorkerAllocator *alloc, void *ptr, size_t size) {
     if (!ptr) return;
 
-    if (!alloc) {
-        free(ptr);
-        return;
-    }
-
-    int idx = find_pool_index(size);
-    if (idx >= 0) {
-        pool_dealloc(&alloc->pools[idx], ptr);
+    (void)size;
+    if (worker_alloc_owns(ptr)) {
+        chunk_block_free(alloc, ptr);
         return;
     }
 
@@ -168,20 +378,18 @@ WorkerAllocator *worker_alloc_get_current(void) {
 void *worker_alloc(size_t size) {
     WorkerAllocator *alloc = tls_current_alloc;
     if (alloc) {
-        return worker_alloc_alloc(alloc, size);
+        void *ptr = worker_alloc_alloc(alloc, size);
+        if (ptr) return ptr;
     }
     return malloc(size);
 }
 
 void worker_dealloc(void *ptr, size_t size) {
-    if (!ptr) return;
+    worker_alloc_dealloc(tls_current_alloc, ptr, size);
+}
 
-    WorkerAllocator *alloc = tls_current_alloc;
-    if (alloc) {
-        worker_alloc_dealloc(alloc, ptr, size);
-        return;
-    }
-    free(ptr);
+void worker_alloc_release(void *ptr) {
+    worker_alloc_dealloc(tls_current_alloc, ptr, 0);
 }
 
 /* Statistics */
@@ -192,7 +400,6 @@ WorkerAllocStats worker_alloc_stats(const WorkerAllocator *alloc) {
     if (!alloc) return stats;
 
     size_t total_chunks = 0;
-    size_t total_memory = 0;
 
     for (int i = 0; i < WORKER_ALLOC_NUM_POOLS; i++) {
         const WorkerPool *pool = &alloc->pools[i];
@@ -203,13 +410,12 @@ WorkerAllocStats worker_alloc_stats(const WorkerAllocator *alloc) {
         WorkerChunk *chunk = pool->chunks;
         while (chunk) {
             total_chunks++;
-            total_memory += sizeof(WorkerChunk) + pool->block_size * pool->blocks_per_chunk;
             chunk = chunk->next;
         }
     }
 
     stats.total_chunks = total_chunks;
-    stats.total_memory = total_memory;
+    stats.total_memory = total_chunks * WORKER_ALLOC_CHUNK_SIZE;
 
     return stats;
 }
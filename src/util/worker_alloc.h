@@ -3,6 +3,13 @@
  *
  * Thread-local allocator with pools for common allocation sizes.
  *
+ * Pool chunks are carved from one reserved address range, so any pointer
+ * can be classified as pool memory with a bounds check and its chunk found
+ * by masking. That lets memory be freed from any thread: blocks freed by
+ * their owning worker go straight back on its free list, while blocks
+ * freed elsewhere (typically after being sent in a message) are pushed
+ * onto the owner's lock-free remote-free list and reclaimed on refill.
+ *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
  */
@@ -10,14 +17,17 @@
 #ifndef AGIM_UTIL_WORKER_ALLOC_H
 #define AGIM_UTIL_WORKER_ALLOC_H
 
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 
 /* Configuration */
 
 #define WORKER_ALLOC_NUM_POOLS 6
 #define WORKER_ALLOC_MAX_SIZE 512
-#define WORKER_ALLOC_CHUNK_SIZE 4096
+#define WORKER_ALLOC_CHUNK_SIZE 4096                  /* Chunks are aligned to their size */
+#define WORKER_ALLOC_REGION_SIZE ((size_t)1 << 30)    /* Address space reserved for chunks */
 
 /* Free List Node */
 
@@ -25,11 +35,25 @@ typedef struct WorkerFreeBlock {
     struct WorkerFreeBlock *next;
 } WorkerFreeBlock;
 
+/* Remote Frees - one lock-free stack per pool, drained by the owner. Once
+ * the owner is freed with blocks still out, the lists are orphaned along
+ * with the chunks holding those blocks, and drained by later chunk
+ * acquisitions until every block is back. */
+
+typedef struct WorkerRemote {
+    _Atomic(WorkerFreeBlock *) free_lists[WORKER_ALLOC_NUM_POOLS];
+    struct WorkerChunk *orphaned_chunks;  /* Guarded by the region lock */
+    struct WorkerRemote *next_orphan;
+} WorkerRemote;
+
 /* Chunk */
 
 typedef struct WorkerChunk {
     struct WorkerChunk *next;
-    char data[];
+    WorkerRemote *owner;  /* Remote-free lists of the allocator that carved it */
+    uint32_t pool;        /* Index of the pool its blocks belong to */
+    uint32_t free_blocks; /* Counted when the owner gives the chunk up */
+    _Alignas(16) char data[];
 } WorkerChunk;
 
 /* Per-Size Pool */
@@ -47,6 +71,7 @@ typedef struct WorkerPool {
 
 typedef struct WorkerAllocator {
     WorkerPool pools[WORKER_ALLOC_NUM_POOLS];
+    WorkerRemote *remote;  /* Outlives the allocator while its blocks are in use */
     int worker_id;
 } WorkerAllocator;
 
@@ -64,6 +89,11 @@ WorkerAllocator *worker_alloc_get_current(void);
 void *worker_alloc(size_t size);
 void worker_dealloc(void *ptr, size_t size);
 
+/* Any-Thread Release - frees worker_alloc or malloc memory from any thread */
+
+bool worker_alloc_owns(const void *ptr);
+void worker_alloc_release(void *ptr);
+
 /* Statistics */
 
 typedef struct WorkerAllocStats {
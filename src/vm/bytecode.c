@@ -16,7 +16,7 @@
 #include <string.h>
 
 #define AGIM_MAGIC 0x4147494D
-#define AGIM_BYTECODE_VERSION 1
+#define AGIM_BYTECODE_VERSION 2
 
 /* Memory Helpers */
 
@@ -174,6 +174,10 @@ Bytecode *bytecode_new(void) {
     code->strings_count = 0;
     code->strings = alloc(sizeof(char *) * code->strings_capacity);
 
+    code->globals_capacity = 16;
+    code->globals_count = 0;
+    code->globals = alloc(sizeof(char *) * code->globals_capacity);
+
     code->tools_capacity = 8;
     code->tools_count = 0;
     code->tools = alloc(sizeof(ToolInfo) * code->tools_capacity);
@@ -199,6 +203,11 @@ void bytecode_free(Bytecode *code) {
     }
     free(code->strings);
 
+    for (size_t i = 0; i < code->globals_count; i++) {
+        free(code->globals[i]);
+    }
+    free(code->globals);
+
     for (size_t i = 0; i < code->tools_count; i++) {
         free(code->tools[i].name);
         free(code->tools[i].description);
@@ -267,6 +276,40 @@ const char *bytecode_get_string(Bytecode *code, size_t index) {
     return code->strings[index];
 }
 
+/* Globals */
+
+bool bytecode_find_global(const Bytecode *code, const char *name, size_t *slot) {
+    for (size_t i = 0; i < code->globals_count; i++) {
+        if (strcmp(code->globals[i], name) == 0) {
+            *slot = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t bytecode_add_global(Bytecode *code, const char *name) {
+    size_t slot;
+    if (bytecode_find_global(code, name, &slot)) {
+        return slot;
+    }
+
+    if (code->globals_count >= code->globals_capacity) {
+        code->globals_capacity *= 2;
+        code->globals = realloc_safe(
+            code->globals,
+            sizeof(char *) * code->globals_capacity);
+    }
+
+    code->globals[code->globals_count] = strdup(name);
+    return code->globals_count++;
+}
+
+const char *bytecode_get_global(const Bytecode *code, size_t slot) {
+    if (slot >= code->globals_count) return NULL;
+    return code->globals[slot];
+}
+
 /* Tools */
 
 size_t bytecode_add_tool(Bytecode *code, const char *name, size_t func_index,
@@ -413,6 +456,11 @@ uint8_t *bytecode_serialize(const Bytecode *code, size_t *size) {
         total += 4 + strlen(code->strings[i]) + 1;
     }
 
+    total += 4;
+    for (size_t i = 0; i < code->globals_count; i++) {
+        total += 4 + strlen(code->globals[i]);
+    }
+
     uint8_t *buffer = alloc(total);
     uint8_t *p = buffer;
 
@@ -436,6 +484,15 @@ uint8_t *bytecode_serialize(const Bytecode *code, size_t *size) {
         p += len;
     }
 
+    write_u32(&p, (uint32_t)code->globals_count);
+
+    for (size_t i = 0; i < code->globals_count; i++) {
+        size_t len = strlen(code->globals[i]);
+        write_u32(&p, (uint32_t)len);
+        memcpy(p, code->globals[i], len);
+        p += len;
+    }
+
     *size = (size_t)(p - buffer);
     return buffer;
 }
@@ -601,6 +658,33 @@ Bytecode *bytecode_deserialize(const uint8_t *data, size_t size) {
         free(str);
     }
 
+    /* Version 1 indexed globals by string, so the string table is the slot table */
+    if (version < 2) {
+        for (size_t i = 0; i < code->strings_count; i++) {
+            bytecode_add_global(code, code->strings[i]);
+        }
+        return code;
+    }
+
+    if (p + 4 > end) goto error;
+    uint32_t global_count = read_u32(&p);
+
+    for (uint32_t i = 0; i < global_count; i++) {
+        if (p + 4 > end) goto error;
+        uint32_t len = read_u32(&p);
+        if (p + len > end) goto error;
+        char *name = malloc(len + 1);
+        if (!name) {
+            LOG_ERROR("bytecode: failed to allocate global name of %u bytes during load", len);
+            goto error;
+        }
+        memcpy(name, p, len);
+        name[len] = '\0';
+        p += len;
+        bytecode_add_global(code, name);
+        free(name);
+    }
+
     return code;
 
 error:
@@ -658,6 +742,8 @@ static const char *opcode_names[] = {
     [OP_SPAWN] = "SPAWN",
     [OP_SEND] = "SEND",
     [OP_RECEIVE] = "RECEIVE",
+    [OP_RECEIVE_TIMEOUT] = "RECEIVE_TIMEOUT",
+    [OP_RECEIVE_MANY] = "RECEIVE_MANY",
     [OP_SELF] = "SELF",
     [OP_YIELD] = "YIELD",
     [OP_INFER] = "INFER",
@@ -673,6 +759,7 @@ static const char *opcode_names[] = {
     [OP_TO_STRING] = "TO_STRING",
     [OP_TO_INT] = "TO_INT",
     [OP_TO_FLOAT] = "TO_FLOAT",
+    [OP_FREEZE] = "FREEZE",
     [OP_FILE_READ] = "FILE_READ",
     [OP_FILE_WRITE] = "FILE_WRITE",
     [OP_FILE_EXISTS] = "FILE_EXISTS",
@@ -754,6 +841,19 @@ static const char *opcode_names[] = {
     [OP_ENUM_NEW] = "ENUM_NEW",
     [OP_ENUM_IS] = "ENUM_IS",
     [OP_ENUM_PAYLOAD] = "ENUM_PAYLOAD",
+    [OP_ADD_LOCAL_LOCAL] = "ADD_LOCAL_LOCAL",
+    [OP_INC_LOCAL] = "INC_LOCAL",
+    [OP_GET_LOCAL_MAP_GET_IC] = "GET_LOCAL_MAP_GET_IC",
+    [OP_LT_LOCAL_CONST_JUMP_UNLESS] = "LT_LOCAL_CONST_JUMP_UNLESS",
+    [OP_LT_LOCAL_LOCAL_JUMP_UNLESS] = "LT_LOCAL_LOCAL_JUMP_UNLESS",
+    [OP_ADD_INT] = "ADD_INT",
+    [OP_SUB_INT] = "SUB_INT",
+    [OP_MUL_INT] = "MUL_INT",
+    [OP_ADD_FLOAT] = "ADD_FLOAT",
+    [OP_SUB_FLOAT] = "SUB_FLOAT",
+    [OP_MUL_FLOAT] = "MUL_FLOAT",
+    [OP_DIV_FLOAT] = "DIV_FLOAT",
+    [OP_TAIL_CALL] = "TAIL_CALL",
     [OP_HALT] = "HALT",
 };
 
@@ -791,7 +891,9 @@ size_t chunk_disassemble_instruction(Chunk *chunk, size_t offset) {
     case OP_GET_GLOBAL:
     case OP_SET_GLOBAL:
     case OP_CALL:
-    case OP_CLOSURE: {
+    case OP_TAIL_CALL:
+    case OP_CLOSURE:
+    case OP_INC_LOCAL: {
         uint16_t arg = chunk_read_arg(chunk, offset + 1);
         printf(" %d", arg);
         if (instruction == OP_CONST && arg < chunk->constants_size) {
@@ -824,6 +926,30 @@ size_t chunk_disassemble_instruction(Chunk *chunk, size_t offset) {
         return offset + 5;
     }
 
+    case OP_ADD_LOCAL_LOCAL: {
+        uint16_t a = chunk_read_arg(chunk, offset + 1);
+        uint16_t b = chunk_read_arg(chunk, offset + 3);
+        printf(" %d %d\n", a, b);
+        return offset + 5;
+    }
+
+    case OP_GET_LOCAL_MAP_GET_IC: {
+        uint16_t slot = chunk_read_arg(chunk, offset + 1);
+        uint16_t key_idx = chunk_read_arg(chunk, offset + 3);
+        uint16_t ic_slot = chunk_read_arg(chunk, offset + 5);
+        printf(" %d key=%d ic=%d\n", slot, key_idx, ic_slot);
+        return offset + 7;
+    }
+
+    case OP_LT_LOCAL_CONST_JUMP_UNLESS:
+    case OP_LT_LOCAL_LOCAL_JUMP_UNLESS: {
+        uint16_t slot = chunk_read_arg(chunk, offset + 1);
+        uint16_t rhs = chunk_read_arg(chunk, offset + 3);
+        uint16_t jump = chunk_read_arg(chunk, offset + 5);
+        printf(" %d %d -> %zu\n", slot, rhs, offset + 7 + jump);
+        return offset + 7;
+    }
+
     case OP_STRUCT_GET:
     case OP_STRUCT_SET:
     case OP_ENUM_IS: {
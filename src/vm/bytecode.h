@@ -88,6 +88,7 @@ typedef enum Opcode {
     OP_SEND,
     OP_RECEIVE,
     OP_RECEIVE_TIMEOUT,
+    OP_RECEIVE_MANY,
     OP_SELF,
     OP_YIELD,
 
@@ -136,6 +137,7 @@ typedef enum Opcode {
     OP_TO_STRING,
     OP_TO_INT,
     OP_TO_FLOAT,
+    OP_FREEZE,
 
     /* File I/O */
     OP_FILE_READ,
@@ -263,6 +265,25 @@ typedef enum Opcode {
     OP_ENUM_IS,
     OP_ENUM_PAYLOAD,
 
+    /* Superinstructions, fused by the compiler (see peephole()) */
+    OP_ADD_LOCAL_LOCAL,
+    OP_INC_LOCAL,
+    OP_GET_LOCAL_MAP_GET_IC,
+    OP_LT_LOCAL_CONST_JUMP_UNLESS,
+    OP_LT_LOCAL_LOCAL_JUMP_UNLESS,
+
+    /* Arithmetic on operands the type checker saw as int/float */
+    OP_ADD_INT,
+    OP_SUB_INT,
+    OP_MUL_INT,
+    OP_ADD_FLOAT,
+    OP_SUB_FLOAT,
+    OP_MUL_FLOAT,
+    OP_DIV_FLOAT,
+
+    /* Call that reuses the caller's frame (CALL n; RETURN) */
+    OP_TAIL_CALL,
+
     /* End */
     OP_HALT,
 } Opcode;
@@ -318,6 +339,11 @@ typedef struct Bytecode {
     size_t strings_count;
     size_t strings_capacity;
 
+    /* Global names; OP_GET_GLOBAL/OP_SET_GLOBAL operands index this table */
+    char **globals;
+    size_t globals_count;
+    size_t globals_capacity;
+
     ToolInfo *tools;
     size_t tools_count;
     size_t tools_capacity;
@@ -354,6 +380,10 @@ size_t bytecode_add_function(Bytecode *code, Chunk *chunk);
 size_t bytecode_add_string(Bytecode *code, const char *str);
 const char *bytecode_get_string(Bytecode *code, size_t index);
 
+size_t bytecode_add_global(Bytecode *code, const char *name);
+const char *bytecode_get_global(const Bytecode *code, size_t slot);
+bool bytecode_find_global(const Bytecode *code, const char *name, size_t *slot);
+
 size_t bytecode_add_tool(Bytecode *code, const char *name, size_t func_index,
                          const char **param_names, const char **param_types,
                          const char **param_descriptions, size_t param_count,
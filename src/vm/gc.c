@@ -11,6 +11,7 @@
 #include "util/alloc.h"
 #include "debug/log.h"
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -47,6 +48,11 @@ Heap *heap_new(const GCConfig *config) {
     if (!heap) return NULL;
 
     heap->objects = NULL;
+    heap->old_objects = NULL;
+    pthread_mutex_init(&heap->lock, NULL);
+    heap->nursery = NULL;
+    heap->nursery_spare = NULL;
+    heap->nursery_chunks = 0;
     heap->bytes_allocated = 0;
     heap->next_gc = config ? config->initial_heap_size : gc_config_default().initial_heap_size;
     heap->max_size = config ? config->max_heap_size : gc_config_default().max_heap_size;
@@ -55,6 +61,7 @@ Heap *heap_new(const GCConfig *config) {
     heap->mark_cursor = NULL;
     heap->sweep_cursor = NULL;
     heap->sweep_prev = NULL;
+    heap->sweeping_old = false;
     heap->step_budget = config ? config->incremental_step : 100;
 
     /* Gray list for tri-color marking */
@@ -84,6 +91,89 @@ Heap *heap_new(const GCConfig *config) {
     return heap;
 }
 
+/* Nursery
+ *
+ * Headers of heap-allocated values are bump-allocated out of aligned chunks
+ * owned by the heap rather than malloc'd one at a time; payloads still come
+ * from the regular allocators. Objects never move: values are shared by raw
+ * pointer with mailboxes and other blocks, so a survivor is promoted in
+ * place by moving it from the young list to the old list, which is a plain
+ * list rather than paged storage. A chunk goes back to the heap once every
+ * slot handed out from it has been reclaimed, and the current chunk simply
+ * rewinds its bump pointer. Callers hold heap->lock.
+ */
+
+#define NURSERY_CHUNK_SIZE 8192
+
+struct NurseryChunk {
+    struct NurseryChunk *next;
+    uint32_t used;  /* Slots handed out by the bump pointer */
+    uint32_t live;  /* Handed-out slots not yet reclaimed */
+    Value slots[];
+};
+
+#define NURSERY_CHUNK_SLOTS \
+    ((NURSERY_CHUNK_SIZE - sizeof(NurseryChunk)) / sizeof(Value))
+
+static inline NurseryChunk *nursery_chunk_of(Value *v) {
+    return (NurseryChunk *)((uintptr_t)v & ~(uintptr_t)(NURSERY_CHUNK_SIZE - 1));
+}
+
+static Value *nursery_bump(Heap *heap) {
+    NurseryChunk *chunk = heap->nursery;
+
+    if (!chunk || chunk->used == NURSERY_CHUNK_SLOTS) {
+        chunk = heap->nursery_spare;
+        if (chunk) {
+            heap->nursery_spare = NULL;
+        } else {
+            chunk = aligned_alloc(NURSERY_CHUNK_SIZE, NURSERY_CHUNK_SIZE);
+            if (!chunk) {
+                LOG_ERROR("gc: failed to allocate nursery chunk");
+                return NULL;
+            }
+        }
+        chunk->used = 0;
+        chunk->live = 0;
+        chunk->next = heap->nursery;
+        heap->nursery = chunk;
+        heap->nursery_chunks++;
+    }
+
+    chunk->live++;
+    return &chunk->slots[chunk->used++];
+}
+
+/* Take back the slot nursery_bump just handed out */
+static void nursery_unbump(Heap *heap) {
+    heap->nursery->used--;
+    heap->nursery->live--;
+}
+
+/* Hand a dead object's slot back. The object must already be unlinked. */
+static void nursery_release(Heap *heap, Value *v) {
+    NurseryChunk *chunk = nursery_chunk_of(v);
+    if (--chunk->live > 0) return;
+
+    if (chunk == heap->nursery) {
+        chunk->used = 0;
+        return;
+    }
+
+    NurseryChunk **link = &heap->nursery;
+    while (*link != chunk) {
+        link = &(*link)->next;
+    }
+    *link = chunk->next;
+    heap->nursery_chunks--;
+
+    if (heap->nursery_spare) {
+        free(chunk);
+    } else {
+        heap->nursery_spare = chunk;
+    }
+}
+
 /* Free a value's immediate memory without recursing into children.
  * Used by heap_free since all objects are in the heap's object list
  * and will be freed individually - we don't want to double-free children. */
@@ -92,12 +182,12 @@ static void gc_free_shallow(Value *v) {
 
     switch (v->type) {
     case VAL_STRING:
-        agim_free(v->as.string);
+        value_mem_free(v->as.string);
         break;
     case VAL_ARRAY:
         /* Don't free elements - they're separate heap objects */
         agim_free(v->as.array->items);
-        agim_free(v->as.array);
+        value_mem_free(v->as.array);
         break;
     case VAL_MAP: {
         Map *map = v->as.map;
@@ -106,13 +196,13 @@ static void gc_free_shallow(Value *v) {
             while (entry) {
                 MapEntry *next = entry->next;
                 /* Don't free entry->value - it's a separate heap object */
-                agim_free(entry->key);
-                agim_free(entry);
+                value_mem_free(entry->key);
+                value_mem_free(entry);
                 entry = next;
             }
         }
         agim_free(map->buckets);
-        agim_free(map);
+        value_mem_free(map);
         break;
     }
     case VAL_FUNCTION:
@@ -120,7 +210,11 @@ static void gc_free_shallow(Value *v) {
         agim_free(v->as.function);
         break;
     case VAL_BYTES:
-        agim_free(v->as.bytes->data);
+        if (v->as.bytes->shared) {
+            shared_buffer_release(v->as.bytes->shared);
+        } else {
+            agim_free(v->as.bytes->data);
+        }
         agim_free(v->as.bytes);
         break;
     case VAL_VECTOR:
@@ -168,21 +262,39 @@ static void gc_free_shallow(Value *v) {
         break;
     }
 
-    agim_free(v);
+    if (!(v->flags & VALUE_NURSERY)) {
+        value_mem_free(v);
+    }
 }
 
-void heap_free(Heap *heap) {
-    if (!heap) return;
-
-    Value *object = heap->objects;
+static void heap_free_list(Value *object) {
     while (object) {
         Value *next = object->next;
-        gc_free_shallow(object);
+        /* value_free already released the payload of a freeing object */
+        if (atomic_load_explicit(&object->refcount, memory_order_acquire) != REFCOUNT_FREEING) {
+            gc_free_shallow(object);
+        }
         object = next;
     }
+}
+
+void heap_free(Heap *heap) {
+    if (!heap) return;
+
+    heap_free_list(heap->objects);
+    heap_free_list(heap->old_objects);
+
+    NurseryChunk *chunk = heap->nursery;
+    while (chunk) {
+        NurseryChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    free(heap->nursery_spare);
 
     free(heap->remember_set);
     free(heap->gray_list);
+    pthread_mutex_destroy(&heap->lock);
     free(heap);
 }
 
@@ -213,7 +325,60 @@ static size_t value_size(ValueType type) {
     }
 }
 
-Value *heap_alloc_with_gc(Heap *heap, ValueType type, VM *vm) {
+/* Build a zeroed value of the given type directly in a nursery slot and
+ * link it into the young list */
+static Value *heap_construct(Heap *heap, ValueType type) {
+    Value *value = nursery_bump(heap);
+    if (!value) return NULL;
+
+    bool ok = true;
+    switch (type) {
+    case VAL_NIL:
+    case VAL_BOOL:
+    case VAL_INT:
+    case VAL_FLOAT:
+    case VAL_PID:
+        value_init_header(value, type, 0);
+        break;
+    case VAL_STRING:
+        ok = value_init_string_n(value, "", 0);
+        break;
+    case VAL_ARRAY:
+        ok = value_init_array(value, 8);
+        break;
+    case VAL_MAP:
+        ok = value_init_map(value, 16);
+        break;
+    case VAL_FUNCTION:
+        ok = value_init_function(value, NULL, 0);
+        break;
+    case VAL_BYTES:
+        ok = value_init_bytes(value, 64);
+        break;
+    case VAL_VECTOR:
+        ok = value_init_vector(value, 1);
+        break;
+    case VAL_CLOSURE:
+    case VAL_RESULT:
+    case VAL_OPTION:
+    case VAL_STRUCT:
+    case VAL_ENUM:
+        ok = false;
+        break;
+    }
+
+    if (!ok) {
+        nursery_unbump(heap);
+        return NULL;
+    }
+
+    value->flags |= VALUE_NURSERY;
+    value->next = heap->objects;
+    heap->objects = value;
+    return value;
+}
+
+static Value *heap_alloc_with_gc_locked(Heap *heap, ValueType type, VM *vm) {
     size_t size = value_size(type);
 
     if (heap->needs_full_gc && vm) {
@@ -258,55 +423,9 @@ Value *heap_alloc_with_gc(Heap *heap, ValueType type, VM *vm) {
         }
     }
 
-    Value *value = NULL;
-    switch (type) {
-    case VAL_NIL:
-        value = value_nil();
-        break;
-    case VAL_BOOL:
-        value = value_bool(false);
-        break;
-    case VAL_INT:
-        value = value_int(0);
-        break;
-    case VAL_FLOAT:
-        value = value_float(0.0);
-        break;
-    case VAL_STRING:
-        value = value_string("");
-        break;
-    case VAL_ARRAY:
-        value = value_array();
-        break;
-    case VAL_MAP:
-        value = value_map();
-        break;
-    case VAL_PID:
-        value = value_pid(0);
-        break;
-    case VAL_FUNCTION:
-        value = value_function(NULL, 0);
-        break;
-    case VAL_BYTES:
-        value = value_bytes(64);
-        break;
-    case VAL_VECTOR:
-        value = value_vector(1);
-        break;
-    case VAL_CLOSURE:
-    case VAL_RESULT:
-    case VAL_OPTION:
-    case VAL_STRUCT:
-    case VAL_ENUM:
-        return NULL;
-    }
-
+    Value *value = heap_construct(heap, type);
     if (!value) return NULL;
 
-    value->gc_state = 0;
-    value->next = heap->objects;
-    heap->objects = value;
-
     heap->bytes_allocated += size;
     heap->total_allocated += size;
 
@@ -318,7 +437,7 @@ Value *heap_alloc_with_gc(Heap *heap, ValueType type, VM *vm) {
     return value;
 }
 
-Value *heap_alloc(Heap *heap, ValueType type) {
+static Value *heap_alloc_locked(Heap *heap, ValueType type) {
     size_t size = value_size(type);
 
     if (heap->bytes_allocated + size > heap->next_gc) {
@@ -336,55 +455,9 @@ Value *heap_alloc(Heap *heap, ValueType type) {
         return NULL;
     }
 
-    Value *value = NULL;
-    switch (type) {
-    case VAL_NIL:
-        value = value_nil();
-        break;
-    case VAL_BOOL:
-        value = value_bool(false);
-        break;
-    case VAL_INT:
-        value = value_int(0);
-        break;
-    case VAL_FLOAT:
-        value = value_float(0.0);
-        break;
-    case VAL_STRING:
-        value = value_string("");
-        break;
-    case VAL_ARRAY:
-        value = value_array();
-        break;
-    case VAL_MAP:
-        value = value_map();
-        break;
-    case VAL_PID:
-        value = value_pid(0);
-        break;
-    case VAL_FUNCTION:
-        value = value_function(NULL, 0);
-        break;
-    case VAL_BYTES:
-        value = value_bytes(64);
-        break;
-    case VAL_VECTOR:
-        value = value_vector(1);
-        break;
-    case VAL_CLOSURE:
-    case VAL_RESULT:
-    case VAL_OPTION:
-    case VAL_STRUCT:
-    case VAL_ENUM:
-        return NULL;
-    }
-
+    Value *value = heap_construct(heap, type);
     if (!value) return NULL;
 
-    value->gc_state = 0;
-    value->next = heap->objects;
-    heap->objects = value;
-
     heap->bytes_allocated += size;
     heap->total_allocated += size;
 
@@ -396,6 +469,21 @@ Value *heap_alloc(Heap *heap, ValueType type) {
     return value;
 }
 
+/* Two threads bumping the same chunk would be handed the same slot */
+Value *heap_alloc_with_gc(Heap *heap, ValueType type, VM *vm) {
+    pthread_mutex_lock(&heap->lock);
+    Value *value = heap_alloc_with_gc_locked(heap, type, vm);
+    pthread_mutex_unlock(&heap->lock);
+    return value;
+}
+
+Value *heap_alloc(Heap *heap, ValueType type) {
+    pthread_mutex_lock(&heap->lock);
+    Value *value = heap_alloc_locked(heap, type);
+    pthread_mutex_unlock(&heap->lock);
+    return value;
+}
+
 /* Marking */
 
 void gc_mark_value(Value *value) {
@@ -455,7 +543,10 @@ void gc_mark_roots(VM *vm) {
         gc_mark_nanvalue(*slot);
     }
 
-    gc_mark_value(vm->globals);
+    for (size_t i = 0; i < vm->globals_count; i++) {
+        gc_mark_nanvalue(vm->globals[i]);
+    }
+    gc_mark_value(vm->pending_globals);
 
     Upvalue *upvalue = vm->open_upvalues;
     while (upvalue) {
@@ -482,15 +573,64 @@ void gc_mark_roots(VM *vm) {
 
 /* Sweeping */
 
-static void sweep(Heap *heap) {
-    Value **object = &heap->objects;
+/* Unlink-side bookkeeping for a dead object. Objects the sweep claimed
+ * still own their payload; ones already released through value_free only
+ * need their slot back. */
+static void heap_reclaim(Heap *heap, Value *obj, bool claimed) {
+    size_t size = value_size(obj->type);
+    heap->bytes_allocated -= size;
+    heap->total_freed += size;
+
+    if (heap->generational_enabled) {
+        if (value_is_old_gen(obj)) {
+            heap->old_count--;
+            heap->old_bytes -= size;
+        } else {
+            heap->young_count--;
+            heap->young_bytes -= size;
+        }
+    }
+
+    bool nursery = obj->flags & VALUE_NURSERY;
+    if (claimed) {
+        gc_free_shallow(obj);
+    }
+    if (nursery) {
+        nursery_release(heap, obj);
+    }
+}
+
+/* Claim an unmarked object for freeing. Fails if it is still referenced
+ * from outside the heap; *claimed is false if value_free got there first. */
+static bool sweep_claim(Value *obj, bool *claimed) {
+    uint32_t expected = 0;
+    *claimed = atomic_compare_exchange_strong_explicit(
+        &obj->refcount, &expected, REFCOUNT_FREEING,
+        memory_order_acq_rel, memory_order_acquire);
+    return *claimed || expected == REFCOUNT_FREEING;
+}
+
+/* Sweep one object list. A minor sweep leaves old objects alone and only
+ * files any it finds in the young list with the old generation. */
+static void sweep_list(Heap *heap, Value **list, bool minor) {
+    bool young_list = list == &heap->objects;
+    Value **object = list;
 
     while (*object) {
         Value *obj = *object;
+        bool tenured = value_is_old_gen(obj);
+
+        if (minor && tenured) {
+            *object = obj->next;
+            obj->next = heap->old_objects;
+            heap->old_objects = obj;
+            continue;
+        }
+
         if (value_is_marked(obj)) {
             value_set_marked(obj, false);
 
-            if (heap->generational_enabled && !value_is_old_gen(obj)) {
+            if (heap->generational_enabled && !tenured) {
                 value_inc_survival(obj);
                 if (value_survival_count(obj) >= heap->promotion_threshold) {
                     size_t size = value_size(obj->type);
@@ -499,41 +639,40 @@ static void sweep(Heap *heap) {
                     heap->old_count++;
                     heap->old_bytes += size;
                     value_set_old_gen(obj);
+                    tenured = true;
                 }
             }
 
-            object = &obj->next;
-        } else {
-            uint32_t expected = 0;
-            if (!atomic_compare_exchange_strong_explicit(
-                    &obj->refcount, &expected, REFCOUNT_FREEING,
-                    memory_order_acq_rel, memory_order_acquire)) {
-                value_set_marked(obj, false);
-                object = &obj->next;
+            if (tenured && young_list && heap->generational_enabled) {
+                *object = obj->next;
+                obj->next = heap->old_objects;
+                heap->old_objects = obj;
                 continue;
             }
 
-            *object = obj->next;
-
-            size_t size = value_size(obj->type);
-            heap->bytes_allocated -= size;
-            heap->total_freed += size;
-
-            if (heap->generational_enabled) {
-                if (value_is_old_gen(obj)) {
-                    heap->old_count--;
-                    heap->old_bytes -= size;
-                } else {
-                    heap->young_count--;
-                    heap->young_bytes -= size;
-                }
-            }
+            object = &obj->next;
+            continue;
+        }
 
-            value_free(obj);
+        bool claimed;
+        if (!sweep_claim(obj, &claimed)) {
+            value_set_marked(obj, false);
+            object = &obj->next;
+            continue;
         }
+
+        *object = obj->next;
+        heap_reclaim(heap, obj, claimed);
     }
 }
 
+/* Old objects are swept first so that survivors promoted out of the young
+ * list are not visited twice. */
+static void sweep(Heap *heap) {
+    sweep_list(heap, &heap->old_objects, false);
+    sweep_list(heap, &heap->objects, false);
+}
+
 /* Collection */
 
 void gc_collect(Heap *heap, VM *vm) {
@@ -571,10 +710,11 @@ size_t heap_used(const Heap *heap) {
 
 HeapStats heap_stats(const Heap *heap) {
     size_t object_count = 0;
-    Value *obj = heap->objects;
-    while (obj) {
+    for (Value *obj = heap->objects; obj; obj = obj->next) {
+        object_count++;
+    }
+    for (Value *obj = heap->old_objects; obj; obj = obj->next) {
         object_count++;
-        obj = obj->next;
     }
 
     return (HeapStats){
@@ -654,36 +794,31 @@ static bool gc_step_marking(Heap *heap) {
 static bool gc_step_sweeping(Heap *heap) {
     size_t processed = 0;
 
-    while (*heap->sweep_prev && processed < heap->step_budget) {
+    while (processed < heap->step_budget) {
+        if (!*heap->sweep_prev) {
+            if (heap->sweeping_old) break;
+            heap->sweep_prev = &heap->old_objects;
+            heap->sweeping_old = true;
+            continue;
+        }
+
         Value *obj = *heap->sweep_prev;
+        bool claimed;
 
         if (value_is_marked(obj)) {
             value_set_marked(obj, false);
             heap->sweep_prev = &obj->next;
+        } else if (!sweep_claim(obj, &claimed)) {
+            heap->sweep_prev = &obj->next;
         } else {
-            uint32_t expected = 0;
-            if (!atomic_compare_exchange_strong_explicit(
-                    &obj->refcount, &expected, REFCOUNT_FREEING,
-                    memory_order_acq_rel, memory_order_acquire)) {
-                value_set_marked(obj, false);
-                heap->sweep_prev = &obj->next;
-                processed++;
-                continue;
-            }
-
             *heap->sweep_prev = obj->next;
-
-            size_t size = value_size(obj->type);
-            heap->bytes_allocated -= size;
-            heap->total_freed += size;
-
-            value_free(obj);
+            heap_reclaim(heap, obj, claimed);
         }
 
         processed++;
     }
 
-    return *heap->sweep_prev != NULL;
+    return heap->sweeping_old ? *heap->sweep_prev != NULL : true;
 }
 
 bool gc_step(Heap *heap, VM *vm) {
@@ -698,6 +833,7 @@ bool gc_step(Heap *heap, VM *vm) {
         if (!gc_step_marking(heap)) {
             heap->gc_phase = GC_SWEEPING;
             heap->sweep_prev = &heap->objects;
+            heap->sweeping_old = false;
         }
         return true;
 
@@ -859,9 +995,11 @@ void gc_write_barrier(Heap *heap, Value *container, Value *value) {
     if (!heap || !heap->generational_enabled) return;
     if (!container || !value) return;
 
+    pthread_mutex_lock(&heap->lock);
     if (value_is_old_gen(container) && !value_is_old_gen(value)) {
         remember_set_add(heap, container);
     }
+    pthread_mutex_unlock(&heap->lock);
 }
 
 static void gc_mark_young(Heap *heap, VM *vm) {
@@ -910,51 +1048,7 @@ static void gc_mark_young(Heap *heap, VM *vm) {
 }
 
 static void sweep_young(Heap *heap) {
-    Value **object = &heap->objects;
-
-    while (*object) {
-        Value *obj = *object;
-
-        if (value_is_old_gen(obj)) {
-            object = &obj->next;
-            continue;
-        }
-
-        if (value_is_marked(obj)) {
-            value_set_marked(obj, false);
-            value_inc_survival(obj);
-
-            if (value_survival_count(obj) >= heap->promotion_threshold) {
-                size_t size = value_size(obj->type);
-                heap->young_count--;
-                heap->young_bytes -= size;
-                heap->old_count++;
-                heap->old_bytes += size;
-                value_set_old_gen(obj);
-            }
-
-            object = &obj->next;
-        } else {
-            uint32_t expected = 0;
-            if (!atomic_compare_exchange_strong_explicit(
-                    &obj->refcount, &expected, REFCOUNT_FREEING,
-                    memory_order_acq_rel, memory_order_acquire)) {
-                value_set_marked(obj, false);
-                object = &obj->next;
-                continue;
-            }
-
-            *object = obj->next;
-
-            size_t size = value_size(obj->type);
-            heap->bytes_allocated -= size;
-            heap->young_count--;
-            heap->young_bytes -= size;
-            heap->total_freed += size;
-
-            value_free(obj);
-        }
-    }
+    sweep_list(heap, &heap->objects, true);
 }
 
 void gc_collect_young(Heap *heap, VM *vm) {
@@ -992,8 +1086,8 @@ void gc_collect_full(Heap *heap, VM *vm) {
 #endif
 
     gc_mark_roots(vm);
-    sweep(heap);
     remember_set_clear(heap);
+    sweep(heap);
 
     heap->next_gc = (size_t)(heap->bytes_allocated * 2.0f);
     if (heap->next_gc > heap->max_size) {
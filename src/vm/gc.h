@@ -8,6 +8,7 @@
 #ifndef AGIM_VM_GC_H
 #define AGIM_VM_GC_H
 
+#include <pthread.h>
 #include <stdbool.h>
 #include <stddef.h>
 
@@ -36,10 +37,28 @@ typedef enum GCPhase {
 /* Incremental marking constants */
 #define GC_MARK_WORK_PACKET_SIZE 256
 
-/* Heap (Per-Block) */
+/* Heap (Per-Block)
+ *
+ * A heap tracks the values created through heap_alloc/heap_alloc_with_gc.
+ * The VM's own constructors (value_int, value_array, ...) do not go through
+ * it: they use value_mem_alloc and are released by reference counting.
+ *
+ * Allocation and the write barrier may be called from any thread and are
+ * serialized on the heap lock. Collection, marking and heap_free must only
+ * be run by the heap's owner while no other thread uses the heap.
+ */
+
+typedef struct NurseryChunk NurseryChunk;
 
 typedef struct Heap {
-    Value *objects;
+    Value *objects;      /* Young objects, newest first (all objects when not generational) */
+    Value *old_objects;  /* Objects promoted out of the young list */
+    pthread_mutex_t lock;         /* Serializes allocation and write barriers */
+
+    /* Nursery: Value headers are bump-allocated from per-heap chunks */
+    NurseryChunk *nursery;        /* Chunk being bump-allocated, then older chunks */
+    NurseryChunk *nursery_spare;  /* Emptied chunk kept for the next refill */
+    size_t nursery_chunks;
 
     size_t bytes_allocated;
     size_t next_gc;
@@ -50,6 +69,7 @@ typedef struct Heap {
     Value *mark_cursor;
     Value *sweep_cursor;
     Value **sweep_prev;
+    bool sweeping_old;
     size_t step_budget;
 
     /* Gray list for tri-color marking */
@@ -46,6 +46,9 @@ typedef uint64_t NanValue;
 #define NANBOX_TRUE  (NANBOX_TAG_SPECIAL | 2ULL)
 #define NANBOX_FALSE (NANBOX_TAG_SPECIAL | 3ULL)
 
+/* Never a program value; marks storage that has not been assigned */
+#define NANBOX_EMPTY (NANBOX_TAG_SPECIAL | 0ULL)
+
 /* Type Checking */
 
 static inline bool nanbox_is_double(NanValue v) {
@@ -30,6 +30,38 @@ static inline Value *nanbox_to_value(NanValue v) {
     return value_nil();
 }
 
+/*
+ * Borrow a read-only Value view of a NanValue without allocating.
+ * Primitives are materialized into caller-provided scratch storage and
+ * objects return their heap pointer. The result must not be stored in a
+ * container or outlive the scratch; use nanbox_to_value() for that.
+ */
+static inline Value *nanbox_borrow_value(NanValue v, Value *scratch) {
+    if (nanbox_is_obj(v)) {
+        return (Value *)nanbox_as_obj(v);
+    }
+    atomic_store_explicit(&scratch->refcount, 1, memory_order_relaxed);
+    scratch->flags = VALUE_IMMUTABLE;
+    scratch->gc_state = 0;
+    scratch->next = NULL;
+    if (nanbox_is_bool(v)) {
+        scratch->type = VAL_BOOL;
+        scratch->as.boolean = nanbox_as_bool(v);
+    } else if (nanbox_is_int(v)) {
+        scratch->type = VAL_INT;
+        scratch->as.integer = nanbox_as_int(v);
+    } else if (nanbox_is_double(v)) {
+        scratch->type = VAL_FLOAT;
+        scratch->as.floating = nanbox_as_double(v);
+    } else if (nanbox_is_pid(v)) {
+        scratch->type = VAL_PID;
+        scratch->as.pid = nanbox_as_pid(v);
+    } else {
+        scratch->type = VAL_NIL;
+    }
+    return scratch;
+}
+
 static inline NanValue value_to_nanbox(Value *val) {
     if (!val) return NANBOX_NIL;
 
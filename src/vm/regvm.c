@@ -6,9 +6,12 @@
  */
 
 #include "vm/regvm.h"
+#include "vm/vm.h"
 #include "vm/value.h"
 #include "vm/ic.h"
 #include "vm/nanbox_convert.h"
+#include "runtime/block.h"
+#include "runtime/scheduler.h"
 #include "types/array.h"
 #include "types/map.h"
 #include "types/string.h"
@@ -16,7 +19,6 @@
 #include "util/alloc.h"
 #include "debug/log.h"
 
-#include <assert.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -50,21 +52,51 @@ RegChunk *regchunk_new(void) {
     chunk->num_params = 0;
     chunk->num_upvalues = 0;
 
+    chunk->name = NULL;
+    chunk->functions = NULL;
+    chunk->functions_count = 0;
+    chunk->functions_capacity = 0;
+    chunk->stubs = NULL;
+
     return chunk;
 }
 
+/* bytecode_free leaves constants to their users; the program owns its stubs' */
+static void regchunk_free_stub_constants(Chunk *chunk) {
+    for (size_t i = 0; i < chunk->constants_size; i++) {
+        value_free_pinned(chunk->constants[i]);
+    }
+}
+
 void regchunk_free(RegChunk *chunk) {
     if (!chunk) return;
 
     agim_free(chunk->code);
 
+    /* Constants are pinned, so globals and containers that picked them up
+     * never freed them; they go with the chunk */
     for (size_t i = 0; i < chunk->constants_size; i++) {
-        value_free(chunk->constants[i]);
+        value_free_pinned(chunk->constants[i]);
     }
     agim_free(chunk->constants);
 
     agim_free(chunk->ic_slots);
     agim_free(chunk->lines);
+
+    for (size_t i = 0; i < chunk->functions_count; i++) {
+        regchunk_free(chunk->functions[i]);
+    }
+    agim_free(chunk->functions);
+
+    if (chunk->stubs) {
+        regchunk_free_stub_constants(chunk->stubs->main);
+        for (size_t i = 0; i < chunk->stubs->functions_count; i++) {
+            regchunk_free_stub_constants(chunk->stubs->functions[i]);
+        }
+        bytecode_free(chunk->stubs);
+    }
+
+    agim_free(chunk->name);
     agim_free(chunk);
 }
 
@@ -91,16 +123,143 @@ size_t regchunk_add_constant(RegChunk *chunk, Value *value) {
                                         sizeof(Value *) * chunk->constants_capacity);
     }
 
+    /* Registers hand constants out uncounted; pinning keeps a global or
+     * container that took one from freeing it under the chunk */
+    value_pin(value);
     chunk->constants[chunk->constants_size] = value;
     return chunk->constants_size++;
 }
 
+size_t regchunk_add_function(RegChunk *program, RegChunk *fn) {
+    if (program->functions_count >= program->functions_capacity) {
+        size_t new_capacity = program->functions_capacity < 8 ? 8 : program->functions_capacity * 2;
+        program->functions = agim_realloc(program->functions,
+                                          sizeof(RegChunk *) * new_capacity);
+        program->functions_capacity = new_capacity;
+    }
+
+    program->functions[program->functions_count] = fn;
+    return program->functions_count++;
+}
+
 /* Register VM Lifecycle */
 
+#define REG_INITIAL_REGISTERS 1024
+
+/*
+ * Temporaries
+ *
+ * Registers borrow. Every value an instruction or stub builds is adopted
+ * into vm->temps; storing a value into a container or global claims it,
+ * moving the reference out of the set (or taking a new one when the value
+ * already had an owner). Whatever is left goes with the VM.
+ */
+
+static Value temp_tombstone_slot;
+#define TEMP_TOMBSTONE (&temp_tombstone_slot)
+
+static size_t temp_slot(const RegVM *vm, const Value *v) {
+    uintptr_t h = (uintptr_t)v;
+    h ^= h >> 17;
+    h *= 0x9E3779B97F4A7C15ull;
+    return (size_t)(h >> 7) & (vm->temps_capacity - 1);
+}
+
+static bool temps_grow(RegVM *vm) {
+    size_t capacity = vm->temps_capacity ? vm->temps_capacity * 2 : 64;
+    /* Mostly tombstones: rehash at the same size */
+    if (vm->temps_count * 4 < vm->temps_capacity) {
+        capacity = vm->temps_capacity;
+    }
+    Value **old = vm->temps;
+    size_t old_capacity = vm->temps_capacity;
+
+    vm->temps = agim_alloc(sizeof(Value *) * capacity);
+    if (!vm->temps) {
+        vm->temps = old;
+        return false;
+    }
+    memset(vm->temps, 0, sizeof(Value *) * capacity);
+    vm->temps_capacity = capacity;
+    vm->temps_used = vm->temps_count;
+
+    for (size_t n = 0; n < old_capacity; n++) {
+        Value *v = old[n];
+        if (!v || v == TEMP_TOMBSTONE) continue;
+        size_t slot = temp_slot(vm, v);
+        while (vm->temps[slot]) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        vm->temps[slot] = v;
+    }
+    agim_free(old);
+    return true;
+}
+
+static bool temps_contains(const RegVM *vm, const Value *v) {
+    if (vm->temps_count == 0) return false;
+    size_t slot = temp_slot(vm, v);
+    while (vm->temps[slot]) {
+        if (vm->temps[slot] == v) return true;
+        slot = (slot + 1) & (vm->temps_capacity - 1);
+    }
+    return false;
+}
+
+/* Take ownership of a value the VM just built */
+static void regvm_adopt(RegVM *vm, Value *v) {
+    if (!v || value_is_pinned(v)) return;
+    if ((vm->temps_used + 1) * 4 > vm->temps_capacity * 3 && !temps_grow(vm)) {
+        return;     /* Out of memory: leak rather than lose track */
+    }
+
+    size_t slot = temp_slot(vm, v);
+    Value **tombstone = NULL;
+    while (vm->temps[slot]) {
+        if (vm->temps[slot] == v) return;
+        if (vm->temps[slot] == TEMP_TOMBSTONE && !tombstone) {
+            tombstone = &vm->temps[slot];
+        }
+        slot = (slot + 1) & (vm->temps_capacity - 1);
+    }
+    if (tombstone) {
+        *tombstone = v;
+    } else {
+        vm->temps[slot] = v;
+        vm->temps_used++;
+    }
+    vm->temps_count++;
+}
+
+/* Hand a reference to a register value to a container or global */
+static Value *regvm_claim(RegVM *vm, NanValue nv) {
+    Value *v = nanbox_to_value(nv);
+    if (!nanbox_is_obj(nv) || !v) return v;
+
+    if (vm->temps_count > 0) {
+        size_t slot = temp_slot(vm, v);
+        while (vm->temps[slot]) {
+            if (vm->temps[slot] == v) {
+                vm->temps[slot] = TEMP_TOMBSTONE;
+                vm->temps_count--;
+                return v;
+            }
+            slot = (slot + 1) & (vm->temps_capacity - 1);
+        }
+    }
+    return value_retain(v);
+}
+
 RegVM *regvm_new(void) {
     RegVM *vm = agim_alloc(sizeof(RegVM));
 
     vm->frame_count = 0;
+    vm->registers = NULL;
+    vm->registers_capacity = 0;
+    vm->program = NULL;
+    vm->result = NANBOX_NIL;
+    vm->stack_vm = NULL;
+    vm->owns_stack_vm = false;
     vm->globals = value_map();
     vm->open_upvalues = NULL;
     vm->error = NULL;
@@ -109,13 +268,27 @@ RegVM *regvm_new(void) {
     vm->reduction_limit = 10000;
     vm->block = NULL;
     vm->scheduler = NULL;
+    vm->temps = NULL;
+    vm->temps_count = 0;
+    vm->temps_used = 0;
+    vm->temps_capacity = 0;
 
     return vm;
 }
 
 void regvm_free(RegVM *vm) {
     if (!vm) return;
+    if (vm->owns_stack_vm) {
+        vm_free(vm->stack_vm);
+    }
+    agim_free(vm->registers);
     value_free(vm->globals);
+    for (size_t n = 0; n < vm->temps_capacity; n++) {
+        if (vm->temps[n] && vm->temps[n] != TEMP_TOMBSTONE) {
+            value_free(vm->temps[n]);
+        }
+    }
+    agim_free(vm->temps);
     agim_free(vm);
 }
 
@@ -141,862 +314,888 @@ int regvm_error_line(const RegVM *vm) {
     return vm->error_line;
 }
 
-/* Arithmetic Helpers */
+/* Register File */
 
-static NanValue nanbox_add(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_int(nanbox_as_int(a) + nanbox_as_int(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_double(nanbox_as_double(a) + nanbox_as_double(b));
-    }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_double((double)nanbox_as_int(a) + nanbox_as_double(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_double(nanbox_as_double(a) + (double)nanbox_as_int(b));
-    }
-    return NANBOX_NIL;
+static inline size_t regchunk_window(const RegChunk *chunk) {
+    return chunk->num_regs > 0 ? chunk->num_regs : REG_MAX_REGISTERS;
 }
 
-static NanValue nanbox_sub(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_int(nanbox_as_int(a) - nanbox_as_int(b));
+/* Grow the register file to at least needed slots, rebasing live frames */
+static bool regvm_ensure_registers(RegVM *vm, size_t needed) {
+    if (needed <= vm->registers_capacity) {
+        return true;
     }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_double(nanbox_as_double(a) - nanbox_as_double(b));
+
+    size_t new_capacity = vm->registers_capacity > 0 ? vm->registers_capacity
+                                                     : REG_INITIAL_REGISTERS;
+    while (new_capacity < needed) {
+        new_capacity *= 2;
     }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_double((double)nanbox_as_int(a) - nanbox_as_double(b));
+
+    NanValue *old = vm->registers;
+    NanValue *registers = agim_realloc(old, sizeof(NanValue) * new_capacity);
+    if (!registers) {
+        return false;
     }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_double(nanbox_as_double(a) - (double)nanbox_as_int(b));
+
+    for (int f = 0; f < vm->frame_count; f++) {
+        vm->frames[f].regs = registers + (vm->frames[f].regs - old);
     }
-    return NANBOX_NIL;
+    vm->registers = registers;
+    vm->registers_capacity = new_capacity;
+    return true;
 }
 
-static NanValue nanbox_mul(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_int(nanbox_as_int(a) * nanbox_as_int(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_double(nanbox_as_double(a) * nanbox_as_double(b));
+static void regvm_clear_registers(NanValue *regs, size_t from, size_t to) {
+    for (size_t r = from; r < to; r++) {
+        regs[r] = NANBOX_NIL;
     }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_double((double)nanbox_as_int(a) * nanbox_as_double(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_double(nanbox_as_double(a) * (double)nanbox_as_int(b));
-    }
-    return NANBOX_NIL;
 }
 
-static NanValue nanbox_div(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        int64_t bv = nanbox_as_int(b);
-        if (bv == 0) return NANBOX_NIL;
-        return nanbox_int(nanbox_as_int(a) / bv);
-    }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_double(nanbox_as_double(a) / nanbox_as_double(b));
-    }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_double((double)nanbox_as_int(a) / nanbox_as_double(b));
+/* Loading */
+
+bool regvm_load(RegVM *vm, RegChunk *program, RegChunk *entry) {
+    if (!vm || !program || !entry) return false;
+
+    regvm_reset(vm);
+    vm->program = program;
+    vm->result = NANBOX_NIL;
+
+    for (size_t f = 0; f < program->functions_count; f++) {
+        RegChunk *fn = program->functions[f];
+        Value *fn_val = value_function(fn->name ? fn->name : "", fn->num_params);
+        if (!fn_val) return false;
+        fn_val->as.function->code_offset = f;
+        if (fn->name) {
+            vm->globals = map_set(vm->globals, fn->name, fn_val);
+        } else {
+            value_free(fn_val);
+        }
     }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_double(nanbox_as_double(a) / (double)nanbox_as_int(b));
+
+    size_t window = regchunk_window(entry);
+    if (!regvm_ensure_registers(vm, window)) {
+        regvm_set_error(vm, "out of memory");
+        return false;
     }
-    return NANBOX_NIL;
+    regvm_clear_registers(vm->registers, 0, window);
+
+    RegCallFrame *frame = &vm->frames[vm->frame_count++];
+    frame->ip = entry->code;
+    frame->regs = vm->registers;
+    frame->chunk = entry;
+    frame->result_reg = 0;
+    return true;
 }
 
-static NanValue nanbox_mod(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        int64_t bv = nanbox_as_int(b);
-        if (bv == 0) return NANBOX_NIL;
-        return nanbox_int(nanbox_as_int(a) % bv);
-    }
-    return NANBOX_NIL;
+/* Value Helpers */
+
+static inline bool reg_is_string_or_nil(NanValue v) {
+    return nanbox_is_nil(v) ||
+           (nanbox_is_obj(v) && value_is_string((Value *)nanbox_as_obj(v)));
 }
 
-static NanValue nanbox_neg(NanValue a) {
-    if (nanbox_is_int(a)) {
-        return nanbox_int(-nanbox_as_int(a));
-    }
-    if (nanbox_is_double(a)) {
-        return nanbox_double(-nanbox_as_double(a));
+static inline bool reg_values_equal(NanValue a, NanValue b) {
+    if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
+        return value_equals((Value *)nanbox_as_obj(a), (Value *)nanbox_as_obj(b));
     }
-    return NANBOX_NIL;
+    return nanbox_equal(a, b);
 }
 
-/* Comparison Helpers */
+/* Resolve a function value to its chunk in the loaded program */
+static RegChunk *regvm_function(RegVM *vm, NanValue callee) {
+    if (!nanbox_is_obj(callee) || !vm->program) return NULL;
+    Value *v = (Value *)nanbox_as_obj(callee);
+    if (!v || v->type != VAL_FUNCTION) return NULL;
+    size_t index = v->as.function->code_offset;
+    if (index >= vm->program->functions_count) return NULL;
+    return vm->program->functions[index];
+}
 
-static NanValue nanbox_eq(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_bool(nanbox_as_int(a) == nanbox_as_int(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_bool(nanbox_as_double(a) == nanbox_as_double(b));
-    }
-    if (nanbox_is_bool(a) && nanbox_is_bool(b)) {
-        return nanbox_bool(nanbox_as_bool(a) == nanbox_as_bool(b));
-    }
-    if (nanbox_is_nil(a) && nanbox_is_nil(b)) {
-        return nanbox_bool(true);
-    }
-    /* Object comparison by reference */
-    if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
-        return nanbox_bool(nanbox_as_obj(a) == nanbox_as_obj(b));
-    }
-    return nanbox_bool(false);
+/* String concatenation, nil reads as "" */
+static NanValue regvm_concat(RegVM *vm, NanValue a, NanValue b) {
+    Value *str_a = nanbox_is_nil(a) ? value_string("") : (Value *)nanbox_as_obj(a);
+    Value *str_b = nanbox_is_nil(b) ? value_string("") : (Value *)nanbox_as_obj(b);
+    Value *result = string_concat(str_a, str_b);
+    if (nanbox_is_nil(a)) value_free(str_a);
+    if (nanbox_is_nil(b)) value_free(str_b);
+    regvm_adopt(vm, result);
+    return value_to_nanbox(result);
 }
 
-static NanValue nanbox_lt(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_bool(nanbox_as_int(a) < nanbox_as_int(b));
-    }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_bool(nanbox_as_double(a) < nanbox_as_double(b));
+/*
+ * Stack Stubs
+ *
+ * Operations the register set has no instruction for (builtins, Result,
+ * Option, structs, enums, messaging) are compiled into small stack-VM
+ * fragments in program->stubs. A stub reads its operands as locals,
+ * writes by-reference operands back to their slot and halts with its
+ * result on top of the stack.
+ */
+
+/* Runs body for each value v holds directly; arrays and maps are not walked */
+#define FOR_EACH_CHILD(v, child, body)                                      \
+    do {                                                                    \
+        Value *child;                                                       \
+        switch ((v)->type) {                                                \
+        case VAL_RESULT:                                                    \
+            if ((child = (v)->as.result->value)) { body; }                  \
+            break;                                                          \
+        case VAL_OPTION:                                                    \
+            if ((v)->as.option->is_some && (child = (v)->as.option->value)) { body; } \
+            break;                                                          \
+        case VAL_ENUM:                                                      \
+            if ((child = (v)->as.enum_val->payload)) { body; }              \
+            break;                                                          \
+        case VAL_STRUCT:                                                    \
+            for (size_t f_ = 0; f_ < (v)->as.struct_val->field_count; f_++) { \
+                if ((child = (v)->as.struct_val->fields[f_])) { body; }     \
+            }                                                               \
+            break;                                                          \
+        default:                                                            \
+            break;                                                          \
+        }                                                                   \
+    } while (0)
+
+typedef struct StubInputs {
+    Value *values[UINT8_MAX];
+    size_t lengths[UINT8_MAX];      /* Array length before the stub ran */
+    uint8_t count;
+} StubInputs;
+
+static int stub_input_index(const StubInputs *in, const Value *v) {
+    for (int a = 0; a < in->count; a++) {
+        if (in->values[a] == v) return a;
+    }
+    return -1;
+}
+
+static void stub_claim_input(RegVM *vm, const StubInputs *in, Value *child) {
+    if (stub_input_index(in, child) >= 0) {
+        regvm_claim(vm, value_to_nanbox(child));
     }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_bool((double)nanbox_as_int(a) < nanbox_as_double(b));
+}
+
+/*
+ * Stubs follow the stack VM's rules: constructors take their operands
+ * without retaining them and return fresh values. Settle ownership of one
+ * stub output: operands it absorbed are claimed, and a value no one owned
+ * before is adopted. Outputs that are operands, or operands' children
+ * (unwrap), stay borrowed.
+ */
+static void regvm_settle_stub_output(RegVM *vm, const StubInputs *in, NanValue out) {
+    if (!nanbox_is_obj(out)) return;
+    Value *v = (Value *)nanbox_as_obj(out);
+
+    int a = stub_input_index(in, v);
+    if (a >= 0) {
+        /* push() appends its operand in place */
+        if (value_is_array(v)) {
+            Array *arr = v->as.array;
+            for (size_t n = in->lengths[a]; n < arr->length; n++) {
+                stub_claim_input(vm, in, arr->items[n]);
+            }
+        }
+        return;
     }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_bool(nanbox_as_double(a) < (double)nanbox_as_int(b));
+    if (value_is_pinned(v) || temps_contains(vm, v)) return;
+    for (a = 0; a < in->count; a++) {
+        if (!in->values[a]) continue;
+        FOR_EACH_CHILD(in->values[a], child, if (child == v) return);
     }
-    if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
-        Value *va = (Value *)nanbox_as_obj(a);
-        Value *vb = (Value *)nanbox_as_obj(b);
-        if (value_is_string(va) && value_is_string(vb)) {
-            return nanbox_bool(string_compare(va, vb) < 0);
-        }
+
+    FOR_EACH_CHILD(v, child, stub_claim_input(vm, in, child));
+    if (value_is_array(v) && v->as.array->length > 0) {
+        stub_claim_input(vm, in, v->as.array->items[v->as.array->length - 1]);
     }
-    return nanbox_bool(false);
+    regvm_adopt(vm, v);
 }
 
-static NanValue nanbox_le(NanValue a, NanValue b) {
-    if (nanbox_is_int(a) && nanbox_is_int(b)) {
-        return nanbox_bool(nanbox_as_int(a) <= nanbox_as_int(b));
+static RegVMResult regvm_run_stub(RegVM *vm, NanValue *regs, RegInstr i, uint32_t offset) {
+    Bytecode *stubs = vm->program ? vm->program->stubs : NULL;
+    if (!stubs || offset >= stubs->main->code_size) {
+        regvm_set_error(vm, "invalid stub offset");
+        return REGVM_ERROR_RUNTIME;
     }
-    if (nanbox_is_double(a) && nanbox_is_double(b)) {
-        return nanbox_bool(nanbox_as_double(a) <= nanbox_as_double(b));
+
+    VM *svm = vm->stack_vm;
+    if (!svm) {
+        svm = vm_new();
+        if (!svm) {
+            regvm_set_error(vm, "out of memory");
+            return REGVM_ERROR_RUNTIME;
+        }
+        vm->stack_vm = svm;
+        vm->owns_stack_vm = true;
     }
-    if (nanbox_is_int(a) && nanbox_is_double(b)) {
-        return nanbox_bool((double)nanbox_as_int(a) <= nanbox_as_double(b));
+    if (vm->owns_stack_vm) {
+        svm->block = vm->block;
+        svm->scheduler = vm->scheduler;
     }
-    if (nanbox_is_double(a) && nanbox_is_int(b)) {
-        return nanbox_bool(nanbox_as_double(a) <= (double)nanbox_as_int(b));
+
+    vm_load(svm, stubs);
+    if (svm->frame_count == 0) {
+        regvm_set_error(vm, "failed to initialize stack VM");
+        return REGVM_ERROR_RUNTIME;
     }
-    if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
-        Value *va = (Value *)nanbox_as_obj(a);
-        Value *vb = (Value *)nanbox_as_obj(b);
-        if (value_is_string(va) && value_is_string(vb)) {
-            return nanbox_bool(string_compare(va, vb) <= 0);
+    svm->frames[0].ip += offset;
+
+    StubInputs inputs;
+    inputs.count = i.rs2;
+    for (uint8_t a = 0; a < i.rs2; a++) {
+        NanValue arg = regs[i.rs1 + a];
+        Value *v = nanbox_is_obj(arg) ? (Value *)nanbox_as_obj(arg) : NULL;
+        inputs.values[a] = v;
+        inputs.lengths[a] = v && value_is_array(v) ? v->as.array->length : 0;
+    }
+
+    for (uint8_t a = 0; a < i.rs2; a++) {
+        if (vm_push_nan(svm, regs[i.rs1 + a]) != VM_OK) {
+            regvm_set_error(vm, "stack overflow");
+            return REGVM_ERROR_OVERFLOW;
         }
     }
-    return nanbox_bool(false);
-}
 
-static bool reg_nanbox_is_truthy(NanValue v) {
-    if (nanbox_is_nil(v)) return false;
-    if (nanbox_is_bool(v)) return nanbox_as_bool(v);
-    if (nanbox_is_int(v)) return nanbox_as_int(v) != 0;
-    if (nanbox_is_double(v)) return nanbox_as_double(v) != 0.0;
-    return true; /* Objects are truthy */
+    /* Preemption is counted by the register loop, not inside stubs */
+    size_t saved_limit = svm->reduction_limit;
+    svm->reduction_limit = SIZE_MAX;
+    VMResult result = vm_run(svm);
+    svm->reduction_limit = saved_limit;
+
+    switch (result) {
+    case VM_OK:
+    case VM_HALT:
+        for (uint8_t a = 0; a < i.rs2; a++) {
+            regs[i.rs1 + a] = svm->stack[a];
+            regvm_settle_stub_output(vm, &inputs, svm->stack[a]);
+        }
+        regs[i.rd] = svm->stack_top - svm->stack > i.rs2 ? svm->stack_top[-1]
+                                                         : NANBOX_NIL;
+        regvm_settle_stub_output(vm, &inputs, regs[i.rd]);
+        return REGVM_OK;
+
+    case VM_YIELD:
+        return REGVM_YIELD;
+
+    case VM_WAITING:
+        return REGVM_WAITING;
+
+    default:
+        vm->error = svm->error ? svm->error : "stub failed";
+        vm->error_line = svm->error_line;
+        return REGVM_ERROR_RUNTIME;
+    }
 }
 
 /* Register VM Execution */
 
-/* Check for computed goto support */
-#if defined(__GNUC__) || defined(__clang__)
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(AGIM_NO_COMPUTED_GOTO)
 #define USE_REG_COMPUTED_GOTO 1
 #else
 #define USE_REG_COMPUTED_GOTO 0
 #endif
 
-RegVMResult regvm_run(RegVM *vm, RegChunk *chunk) {
-    if (!vm || !chunk) return REGVM_ERROR_RUNTIME;
-
-    /* Set up initial frame */
-    RegCallFrame *frame = &vm->frames[vm->frame_count++];
-    frame->ip = chunk->code;
-    frame->chunk = chunk;
-    frame->base = 0;
-    frame->result_reg = 0;
-
-    /* Lazy register initialization: only initialize registers actually used.
-     * This reduces per-call overhead from 2KB to typically <256 bytes. */
-    uint8_t max_reg = chunk->num_regs > 0 ? chunk->num_regs : 16;
-    for (int i = 0; i <= max_reg && i < REG_MAX_REGISTERS; i++) {
-        frame->regs[i] = NANBOX_NIL;
-    }
-
-    /* Convenience macro for register access.
-     * Note: Bytecode should be validated at load time to ensure register
-     * indices are within bounds. Runtime bounds checking would be too slow. */
-    #define R(n) frame->regs[n]
-    /* In debug builds, verify bounds before accessing */
-    #ifndef NDEBUG
-    #define CHECK_REG(n) assert((n) < REG_MAX_REGISTERS)
-    #else
-    #define CHECK_REG(n) ((void)0)
-    #endif
+static RegVMResult regvm_execute(RegVM *vm) {
+    RegCallFrame *frame = &vm->frames[vm->frame_count - 1];
+    NanValue *regs = frame->regs;
+    RegInstr i;
+
+    #define R(n) regs[n]
+
+    #define RUNTIME_ERROR(msg, result)                                      \
+        do {                                                                \
+            vm->error = (msg);                                              \
+            vm->error_line = frame->chunk->lines[frame->ip - frame->chunk->code - 1]; \
+            return (result);                                                \
+        } while (0)
+
+    /* Reductions are charged on calls and backward jumps, so every loop
+     * and every recursion gives the scheduler a chance to preempt */
+    #define REDUCE()                                                        \
+        do {                                                                \
+            if (++vm->reductions >= vm->reduction_limit)                    \
+                return REGVM_YIELD;                                         \
+        } while (0)
+
+    #define JUMP_BY(offset)                                                 \
+        do {                                                                \
+            int32_t off_ = (offset);                                        \
+            frame->ip += off_;                                              \
+            if (off_ < 0) REDUCE();                                         \
+        } while (0)
+
+    #define ARITH_OP(op)                                                    \
+        do {                                                                \
+            NanValue a = R(i.rs1), b = R(i.rs2);                            \
+            if (nanbox_is_int(a) && nanbox_is_int(b)) {                     \
+                R(i.rd) = nanbox_int(nanbox_as_int(a) op nanbox_as_int(b)); \
+            } else if (nanbox_is_number(a) && nanbox_is_number(b)) {        \
+                R(i.rd) = nanbox_double(nanbox_to_float(a) op nanbox_to_float(b)); \
+            } else {                                                        \
+                RUNTIME_ERROR("operands must be numbers", REGVM_ERROR_TYPE); \
+            }                                                               \
+        } while (0)
+
+    #define COMPARE_OP(op)                                                  \
+        do {                                                                \
+            NanValue a = R(i.rs1), b = R(i.rs2);                            \
+            if (nanbox_is_int(a) && nanbox_is_int(b)) {                     \
+                R(i.rd) = nanbox_bool(nanbox_as_int(a) op nanbox_as_int(b)); \
+            } else if (nanbox_is_number(a) && nanbox_is_number(b)) {        \
+                R(i.rd) = nanbox_bool(nanbox_to_float(a) op nanbox_to_float(b)); \
+            } else if (nanbox_is_obj(a) && nanbox_is_obj(b) &&              \
+                       value_is_string((Value *)nanbox_as_obj(a)) &&        \
+                       value_is_string((Value *)nanbox_as_obj(b))) {        \
+                R(i.rd) = nanbox_bool(string_compare((Value *)nanbox_as_obj(a), \
+                                                     (Value *)nanbox_as_obj(b)) op 0); \
+            } else {                                                        \
+                RUNTIME_ERROR("cannot compare these types", REGVM_ERROR_TYPE); \
+            }                                                               \
+        } while (0)
 
 #if USE_REG_COMPUTED_GOTO
-    /* Computed goto dispatch */
-
     static void *dispatch_table[ROP_COUNT] = {
-        [ROP_NOP] = &&op_nop,
-        [ROP_MOV] = &&op_mov,
-        [ROP_LOAD_K] = &&op_load_k,
-        [ROP_LOAD_NIL] = &&op_load_nil,
-        [ROP_LOAD_TRUE] = &&op_load_true,
-        [ROP_LOAD_FALSE] = &&op_load_false,
-        [ROP_LOAD_INT] = &&op_load_int,
-        [ROP_ADD] = &&op_add,
-        [ROP_SUB] = &&op_sub,
-        [ROP_MUL] = &&op_mul,
-        [ROP_DIV] = &&op_div,
-        [ROP_MOD] = &&op_mod,
-        [ROP_NEG] = &&op_neg,
-        [ROP_EQ] = &&op_eq,
-        [ROP_NE] = &&op_ne,
-        [ROP_LT] = &&op_lt,
-        [ROP_LE] = &&op_le,
-        [ROP_GT] = &&op_gt,
-        [ROP_GE] = &&op_ge,
-        [ROP_NOT] = &&op_not,
-        [ROP_AND] = &&op_and,
-        [ROP_OR] = &&op_or,
-        [ROP_JMP] = &&op_jmp,
-        [ROP_JMP_IF] = &&op_jmp_if,
-        [ROP_JMP_UNLESS] = &&op_jmp_unless,
-        [ROP_LOOP] = &&op_loop,
-        [ROP_CALL] = &&op_call,
-        [ROP_RET] = &&op_ret,
-        [ROP_ARRAY_NEW] = &&op_array_new,
-        [ROP_ARRAY_PUSH] = &&op_array_push,
-        [ROP_ARRAY_GET] = &&op_array_get,
-        [ROP_MAP_NEW] = &&op_map_new,
-        [ROP_MAP_GET] = &&op_map_get,
-        [ROP_MAP_SET] = &&op_map_set,
-        [ROP_CONCAT] = &&op_concat,
-        [ROP_LEN] = &&op_len,
-        [ROP_PRINT] = &&op_print,
-        [ROP_HALT] = &&op_halt,
+        [ROP_NOP] = &&op_NOP, [ROP_MOV] = &&op_MOV,
+        [ROP_LOAD_K] = &&op_LOAD_K, [ROP_LOAD_NIL] = &&op_LOAD_NIL,
+        [ROP_LOAD_TRUE] = &&op_LOAD_TRUE, [ROP_LOAD_FALSE] = &&op_LOAD_FALSE,
+        [ROP_LOAD_INT] = &&op_LOAD_INT,
+        [ROP_ADD] = &&op_ADD, [ROP_SUB] = &&op_SUB, [ROP_MUL] = &&op_MUL,
+        [ROP_DIV] = &&op_DIV, [ROP_MOD] = &&op_MOD, [ROP_NEG] = &&op_NEG,
+        [ROP_EQ] = &&op_EQ, [ROP_NE] = &&op_NE, [ROP_LT] = &&op_LT,
+        [ROP_LE] = &&op_LE, [ROP_GT] = &&op_GT, [ROP_GE] = &&op_GE,
+        [ROP_NOT] = &&op_NOT, [ROP_AND] = &&op_AND, [ROP_OR] = &&op_OR,
+        [ROP_JMP] = &&op_JMP, [ROP_JMP_IF] = &&op_JMP_IF,
+        [ROP_JMP_UNLESS] = &&op_JMP_UNLESS, [ROP_LOOP] = &&op_LOOP,
+        [ROP_CALL] = &&op_CALL, [ROP_TAIL_CALL] = &&op_TAIL_CALL,
+        [ROP_RET] = &&op_RET,
+        [ROP_GET_GLOBAL] = &&op_GET_GLOBAL, [ROP_SET_GLOBAL] = &&op_SET_GLOBAL,
+        [ROP_ARRAY_NEW] = &&op_ARRAY_NEW, [ROP_ARRAY_PUSH] = &&op_ARRAY_PUSH,
+        [ROP_ARRAY_GET] = &&op_ARRAY_GET, [ROP_ARRAY_SET] = &&op_ARRAY_SET,
+        [ROP_MAP_NEW] = &&op_MAP_NEW, [ROP_MAP_GET] = &&op_MAP_GET,
+        [ROP_MAP_SET] = &&op_MAP_SET, [ROP_MAP_GET_IC] = &&op_unsupported,
+        [ROP_CONCAT] = &&op_CONCAT,
+        [ROP_CLOSURE] = &&op_unsupported, [ROP_GET_UPVALUE] = &&op_unsupported,
+        [ROP_SET_UPVALUE] = &&op_unsupported, [ROP_CLOSE_UPVALUE] = &&op_unsupported,
+        [ROP_SPAWN] = &&op_SPAWN, [ROP_SEND] = &&op_unsupported,
+        [ROP_RECEIVE] = &&op_unsupported, [ROP_SELF] = &&op_SELF,
+        [ROP_YIELD] = &&op_YIELD,
+        [ROP_LEN] = &&op_LEN, [ROP_TYPE] = &&op_unsupported,
+        [ROP_PRINT] = &&op_PRINT, [ROP_STACK] = &&op_STACK,
+        [ROP_HALT] = &&op_HALT,
     };
 
-    /* Pre-fetch instruction to avoid reading before buffer on first dispatch */
-    RegInstr cur_instr;
-    #define DISPATCH() do { cur_instr = *frame->ip++; goto *dispatch_table[cur_instr.op]; } while(0)
+    #define TARGET(op) op_##op:
+    #define DISPATCH()                                                      \
+        do {                                                                \
+            i = *frame->ip++;                                               \
+            if (i.op >= ROP_COUNT) goto op_unsupported;                     \
+            goto *dispatch_table[i.op];                                     \
+        } while (0)
 
     DISPATCH();
+#else
+    #define TARGET(op) case ROP_##op:
+    #define DISPATCH() goto dispatch
 
-    op_nop:
+dispatch:
+    i = *frame->ip++;
+    switch (i.op) {
+#endif
+
+    TARGET(NOP)
         DISPATCH();
 
-    op_mov: {
-        RegInstr i = cur_instr;
+    TARGET(MOV)
         R(i.rd) = R(i.rs1);
         DISPATCH();
-    }
 
-    op_load_k: {
-        RegInstr i = cur_instr;
+    TARGET(LOAD_K) {
         uint16_t idx = reg_get_imm(i);
-        if (idx < chunk->constants_size) {
-            R(i.rd) = value_to_nanbox(chunk->constants[idx]);
+        if (idx >= frame->chunk->constants_size) {
+            RUNTIME_ERROR("invalid constant index", REGVM_ERROR_RUNTIME);
         }
+        R(i.rd) = value_to_nanbox(frame->chunk->constants[idx]);
         DISPATCH();
     }
 
-    op_load_nil: {
-        RegInstr i = cur_instr;
+    TARGET(LOAD_NIL)
         R(i.rd) = NANBOX_NIL;
         DISPATCH();
-    }
 
-    op_load_true: {
-        RegInstr i = cur_instr;
+    TARGET(LOAD_TRUE)
         R(i.rd) = nanbox_bool(true);
         DISPATCH();
-    }
 
-    op_load_false: {
-        RegInstr i = cur_instr;
+    TARGET(LOAD_FALSE)
         R(i.rd) = nanbox_bool(false);
         DISPATCH();
-    }
 
-    op_load_int: {
-        RegInstr i = cur_instr;
+    TARGET(LOAD_INT)
         R(i.rd) = nanbox_int((int16_t)reg_get_imm(i));
         DISPATCH();
-    }
 
-    op_add: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_add(R(i.rs1), R(i.rs2));
+    TARGET(ADD) {
+        /* String concatenation, nil reads as "" */
+        NanValue a = R(i.rs1), b = R(i.rs2);
+        if (reg_is_string_or_nil(a) && reg_is_string_or_nil(b)) {
+            R(i.rd) = regvm_concat(vm, a, b);
+            DISPATCH();
+        }
+        ARITH_OP(+);
         DISPATCH();
     }
 
-    op_sub: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_sub(R(i.rs1), R(i.rs2));
+    TARGET(SUB)
+        ARITH_OP(-);
         DISPATCH();
-    }
 
-    op_mul: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_mul(R(i.rs1), R(i.rs2));
+    TARGET(MUL)
+        ARITH_OP(*);
         DISPATCH();
-    }
 
-    op_div: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_div(R(i.rs1), R(i.rs2));
+    TARGET(DIV) {
+        NanValue b = R(i.rs2);
+        if ((nanbox_is_int(b) && nanbox_as_int(b) == 0) ||
+            (nanbox_is_double(b) && nanbox_as_double(b) == 0.0)) {
+            RUNTIME_ERROR("division by zero", REGVM_ERROR_RUNTIME);
+        }
+        ARITH_OP(/);
         DISPATCH();
     }
 
-    op_mod: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_mod(R(i.rs1), R(i.rs2));
+    TARGET(MOD) {
+        NanValue a = R(i.rs1), b = R(i.rs2);
+        if (!nanbox_is_int(a) || !nanbox_is_int(b)) {
+            RUNTIME_ERROR("modulo requires integers", REGVM_ERROR_TYPE);
+        }
+        if (nanbox_as_int(b) == 0) {
+            RUNTIME_ERROR("division by zero", REGVM_ERROR_RUNTIME);
+        }
+        R(i.rd) = nanbox_int(nanbox_as_int(a) % nanbox_as_int(b));
         DISPATCH();
     }
 
-    op_neg: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_neg(R(i.rs1));
+    TARGET(NEG) {
+        NanValue a = R(i.rs1);
+        if (nanbox_is_int(a)) {
+            R(i.rd) = nanbox_int(-nanbox_as_int(a));
+        } else if (nanbox_is_double(a)) {
+            R(i.rd) = nanbox_double(-nanbox_as_double(a));
+        } else {
+            RUNTIME_ERROR("operand must be a number", REGVM_ERROR_TYPE);
+        }
         DISPATCH();
     }
 
-    op_eq: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_eq(R(i.rs1), R(i.rs2));
+    TARGET(EQ)
+        R(i.rd) = nanbox_bool(reg_values_equal(R(i.rs1), R(i.rs2)));
         DISPATCH();
-    }
 
-    op_ne: {
-        RegInstr i = cur_instr;
-        NanValue eq = nanbox_eq(R(i.rs1), R(i.rs2));
-        R(i.rd) = nanbox_bool(!nanbox_as_bool(eq));
+    TARGET(NE)
+        R(i.rd) = nanbox_bool(!reg_values_equal(R(i.rs1), R(i.rs2)));
         DISPATCH();
-    }
 
-    op_lt: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_lt(R(i.rs1), R(i.rs2));
+    TARGET(LT)
+        COMPARE_OP(<);
         DISPATCH();
-    }
 
-    op_le: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_le(R(i.rs1), R(i.rs2));
+    TARGET(LE)
+        COMPARE_OP(<=);
         DISPATCH();
-    }
 
-    op_gt: {
-        RegInstr i = cur_instr;
-        /* a > b is equivalent to b < a */
-        R(i.rd) = nanbox_lt(R(i.rs2), R(i.rs1));
+    TARGET(GT)
+        COMPARE_OP(>);
         DISPATCH();
-    }
 
-    op_ge: {
-        RegInstr i = cur_instr;
-        /* a >= b is equivalent to b <= a */
-        R(i.rd) = nanbox_le(R(i.rs2), R(i.rs1));
+    TARGET(GE)
+        COMPARE_OP(>=);
         DISPATCH();
-    }
 
-    op_not: {
-        RegInstr i = cur_instr;
-        R(i.rd) = nanbox_bool(!reg_nanbox_is_truthy(R(i.rs1)));
+    TARGET(NOT)
+        R(i.rd) = nanbox_bool(!nanbox_is_truthy(R(i.rs1)));
         DISPATCH();
-    }
 
-    op_and: {
-        RegInstr i = cur_instr;
-        if (!reg_nanbox_is_truthy(R(i.rs1))) {
-            R(i.rd) = R(i.rs1);
-        } else {
-            R(i.rd) = R(i.rs2);
-        }
+    TARGET(AND)
+        R(i.rd) = nanbox_is_truthy(R(i.rs1)) ? R(i.rs2) : R(i.rs1);
         DISPATCH();
-    }
 
-    op_or: {
-        RegInstr i = cur_instr;
-        if (reg_nanbox_is_truthy(R(i.rs1))) {
-            R(i.rd) = R(i.rs1);
-        } else {
-            R(i.rd) = R(i.rs2);
-        }
+    TARGET(OR)
+        R(i.rd) = nanbox_is_truthy(R(i.rs1)) ? R(i.rs1) : R(i.rs2);
         DISPATCH();
-    }
 
-    op_jmp: {
-        RegInstr i = cur_instr;
-        frame->ip += reg_get_offset(i);
+    TARGET(JMP)
+        JUMP_BY(reg_get_offset(i));
         DISPATCH();
-    }
 
-    op_jmp_if: {
-        RegInstr i = cur_instr;
-        if (reg_nanbox_is_truthy(R(i.rd))) {
-            frame->ip += reg_get_cond_offset(i);
+    TARGET(JMP_IF)
+        if (nanbox_is_truthy(R(i.rd))) {
+            JUMP_BY(reg_get_cond_offset(i));
         }
         DISPATCH();
-    }
 
-    op_jmp_unless: {
-        RegInstr i = cur_instr;
-        if (!reg_nanbox_is_truthy(R(i.rd))) {
-            frame->ip += reg_get_cond_offset(i);
+    TARGET(JMP_UNLESS)
+        if (!nanbox_is_truthy(R(i.rd))) {
+            JUMP_BY(reg_get_cond_offset(i));
         }
         DISPATCH();
-    }
 
-    op_loop: {
-        RegInstr i = cur_instr;
-        frame->ip -= (-reg_get_offset(i)); /* Negative offset for backward jump */
+    TARGET(LOOP)
+        JUMP_BY(reg_get_offset(i));
         DISPATCH();
-    }
 
-    op_call: {
-        /* ROP_CALL: rd = rs1(args starting at rs2)
-         * rs1 = register containing the function value (with RegChunk pointer)
-         * rs2 = first argument register
-         * rd = destination register for result
-         *
-         * The register VM uses a different function representation than the
-         * stack-based VM. Function values are RegChunk pointers wrapped as objects.
-         */
-        RegInstr i = cur_instr;
-        NanValue func_val = R(i.rs1);
-        uint8_t first_arg_reg = i.rs2;
-        uint8_t result_reg = i.rd;
-
-        /* Get the function value - expect an object pointer */
-        if (!nanbox_is_obj(func_val)) {
-            regvm_set_error(vm, "cannot call non-function value");
-            return REGVM_ERROR_TYPE;
+    TARGET(CALL) {
+        /* rd = rs1(rs1+1 .. rs1+rs2); the callee window starts at rs1+1 */
+        RegChunk *target = regvm_function(vm, R(i.rs1));
+        if (!target) {
+            RUNTIME_ERROR("cannot call non-function value", REGVM_ERROR_TYPE);
+        }
+        if (i.rs2 != target->num_params) {
+            RUNTIME_ERROR("wrong number of arguments", REGVM_ERROR_RUNTIME);
+        }
+        if (vm->frame_count >= REG_MAX_FRAMES) {
+            RUNTIME_ERROR("stack overflow", REGVM_ERROR_OVERFLOW);
         }
 
-        void *obj = nanbox_as_obj(func_val);
-        if (!obj) {
-            regvm_set_error(vm, "cannot call nil value");
-            return REGVM_ERROR_TYPE;
+        size_t base = (size_t)(regs - vm->registers) + i.rs1 + 1;
+        size_t window = regchunk_window(target);
+        if (!regvm_ensure_registers(vm, base + window)) {
+            RUNTIME_ERROR("out of memory", REGVM_ERROR_RUNTIME);
         }
 
-        /* In the register VM, object pointers are RegChunk* for function calls. */
-        RegChunk *target_chunk = (RegChunk *)obj;
+        RegCallFrame *callee = &vm->frames[vm->frame_count++];
+        callee->ip = target->code;
+        callee->regs = vm->registers + base;
+        callee->chunk = target;
+        callee->result_reg = i.rd;
+        regvm_clear_registers(callee->regs, target->num_params, window);
 
-        /* Validate the chunk (simple check - it should have code) */
-        if (!target_chunk->code || target_chunk->code_size == 0) {
-            regvm_set_error(vm, "invalid function: no code");
-            return REGVM_ERROR_RUNTIME;
-        }
+        frame = callee;
+        regs = frame->regs;
+        REDUCE();
+        DISPATCH();
+    }
 
-        /* Check frame limit */
-        if (vm->frame_count >= REG_MAX_FRAMES) {
-            regvm_set_error(vm, "stack overflow");
-            return REGVM_ERROR_OVERFLOW;
+    TARGET(TAIL_CALL) {
+        /* Replace the current frame: args move down to r0 .. rs2-1 */
+        RegChunk *target = regvm_function(vm, R(i.rs1));
+        if (!target) {
+            RUNTIME_ERROR("cannot call non-function value", REGVM_ERROR_TYPE);
         }
-
-        /* Get arity from the target chunk */
-        uint8_t arity = target_chunk->num_params;
-
-        /* Push new frame */
-        RegCallFrame *new_frame = &vm->frames[vm->frame_count++];
-        new_frame->ip = target_chunk->code;
-        new_frame->chunk = target_chunk;
-        new_frame->base = 0;
-        new_frame->result_reg = result_reg;
-
-        /* Initialize only registers that will be used (lazy initialization).
-         * This reduces per-call overhead from 2KB to typically <256 bytes. */
-        uint8_t max_reg = target_chunk->num_regs > 0 ? target_chunk->num_regs : 16;
-        for (int j = 0; j <= max_reg && j < REG_MAX_REGISTERS; j++) {
-            new_frame->regs[j] = NANBOX_NIL;
+        if (i.rs2 != target->num_params) {
+            RUNTIME_ERROR("wrong number of arguments", REGVM_ERROR_RUNTIME);
         }
 
-        /* Copy arguments to new frame registers (registers 0 to arity-1) */
-        for (uint8_t j = 0; j < arity; j++) {
-            new_frame->regs[j] = R(first_arg_reg + j);
+        size_t base = (size_t)(regs - vm->registers);
+        size_t window = regchunk_window(target);
+        if (!regvm_ensure_registers(vm, base + window)) {
+            RUNTIME_ERROR("out of memory", REGVM_ERROR_RUNTIME);
         }
+        regs = frame->regs;
 
-        /* Store caller's frame result register info */
-        frame->result_reg = result_reg;
-
-        /* Switch to new frame */
-        frame = new_frame;
+        for (uint8_t a = 0; a < i.rs2; a++) {
+            regs[a] = regs[i.rs1 + 1 + a];
+        }
+        regvm_clear_registers(regs, target->num_params, window);
+        frame->chunk = target;
+        frame->ip = target->code;
+        REDUCE();
         DISPATCH();
     }
 
-    op_ret: {
-        RegInstr i = cur_instr;
+    TARGET(RET) {
         NanValue result = R(i.rd);
-
-        vm->frame_count--;
-        if (vm->frame_count == 0) {
+        if (vm->frame_count == 1) {
+            vm->frame_count = 0;
+            vm->result = result;
             return REGVM_OK;
         }
 
+        uint8_t dest = frame->result_reg;
+        vm->frame_count--;
         frame = &vm->frames[vm->frame_count - 1];
-        R(frame->result_reg) = result;
+        regs = frame->regs;
+        R(dest) = result;
         DISPATCH();
     }
 
-    op_array_new: {
-        RegInstr i = cur_instr;
-        R(i.rd) = value_to_nanbox(value_array());
+    TARGET(GET_GLOBAL) {
+        Value *name = frame->chunk->constants[reg_get_imm(i)];
+        Value *value = map_get(vm->globals, name->as.string->data);
+        if (!value) {
+            RUNTIME_ERROR("undefined variable", REGVM_ERROR_RUNTIME);
+        }
+        R(i.rd) = value_to_nanbox(value);
         DISPATCH();
     }
 
-    op_array_push: {
-        RegInstr i = cur_instr;
-        Value *arr = nanbox_to_value(R(i.rd));
-        Value *val = nanbox_to_value(R(i.rs1));
-        if (arr && value_is_array(arr)) {
-            arr = array_push(arr, val);
-            R(i.rd) = value_to_nanbox(arr);  /* Update register with possibly-new array */
+    TARGET(SET_GLOBAL) {
+        Value *name = frame->chunk->constants[reg_get_imm(i)];
+        NanValue value = R(i.rd);
+        /* Storing the same object back (after an in-place push) must not
+         * release it */
+        if (!nanbox_is_obj(value) ||
+            map_get(vm->globals, name->as.string->data) != nanbox_as_obj(value)) {
+            vm->globals = map_set(vm->globals, name->as.string->data,
+                                  regvm_claim(vm, value));
         }
         DISPATCH();
     }
 
-    op_array_get: {
-        RegInstr i = cur_instr;
-        Value *arr = nanbox_to_value(R(i.rs1));
-        if (arr && value_is_array(arr) && nanbox_is_int(R(i.rs2))) {
-            int64_t idx = nanbox_as_int(R(i.rs2));
-            if (idx >= 0) {
-                Value *item = array_get(arr, (size_t)idx);
-                R(i.rd) = item ? value_to_nanbox(item) : NANBOX_NIL;
-            } else {
-                R(i.rd) = NANBOX_NIL;
-            }
-        } else {
-            R(i.rd) = NANBOX_NIL;
-        }
+    TARGET(ARRAY_NEW) {
+        Value *arr = value_array();
+        regvm_adopt(vm, arr);
+        R(i.rd) = value_to_nanbox(arr);
         DISPATCH();
     }
 
-    op_map_new: {
-        RegInstr i = cur_instr;
-        R(i.rd) = value_to_nanbox(value_map());
+    TARGET(ARRAY_PUSH) {
+        Value *arr = nanbox_to_value(R(i.rd));
+        if (!value_is_array(arr)) {
+            RUNTIME_ERROR("expected array", REGVM_ERROR_TYPE);
+        }
+        Value *pushed = array_push(value_write_ref(arr), regvm_claim(vm, R(i.rs1)));
+        if (pushed != arr) regvm_adopt(vm, pushed);
+        R(i.rd) = value_to_nanbox(pushed);
         DISPATCH();
     }
 
-    op_map_get: {
-        RegInstr i = cur_instr;
-        Value *map = nanbox_to_value(R(i.rs1));
-        Value *key = nanbox_to_value(R(i.rs2));
-        if (map && value_is_map(map) && key && value_is_string(key)) {
-            Value *val = map_get(map, key->as.string->data);
-            R(i.rd) = val ? value_to_nanbox(val) : NANBOX_NIL;
+    TARGET(ARRAY_GET) {
+        NanValue container = R(i.rs1), index = R(i.rs2);
+        Value *c = nanbox_is_obj(container) ? (Value *)nanbox_as_obj(container) : NULL;
+        if (c && value_is_array(c)) {
+            if (!nanbox_is_int(index)) {
+                RUNTIME_ERROR("array index must be integer", REGVM_ERROR_TYPE);
+            }
+            /* Out-of-range reads yield nil */
+            int64_t idx = nanbox_as_int(index);
+            R(i.rd) = value_to_nanbox(idx < 0 ? NULL : array_get(c, (size_t)idx));
+        } else if (c && value_is_map(c)) {
+            Value *key = nanbox_is_obj(index) ? (Value *)nanbox_as_obj(index) : NULL;
+            if (!key || !value_is_string(key)) {
+                RUNTIME_ERROR("map key must be string", REGVM_ERROR_TYPE);
+            }
+            R(i.rd) = value_to_nanbox(map_get(c, key->as.string->data));
         } else {
-            R(i.rd) = NANBOX_NIL;
+            RUNTIME_ERROR("expected array or map", REGVM_ERROR_TYPE);
         }
         DISPATCH();
     }
 
-    op_map_set: {
-        RegInstr i = cur_instr;
-        Value *map = nanbox_to_value(R(i.rs1));
-        Value *key = nanbox_to_value(R(i.rs2));
-        Value *val = nanbox_to_value(R(i.rd));
-        if (map && value_is_map(map) && key && value_is_string(key)) {
-            map = map_set(map, key->as.string->data, val);
-            R(i.rs1) = value_to_nanbox(map);  /* Update register with possibly-new map */
+    TARGET(ARRAY_SET) {
+        /* rd[rs1] = rs2, rd updated with the possibly-copied container */
+        NanValue container = R(i.rd), index = R(i.rs1);
+        Value *c = nanbox_is_obj(container) ? (Value *)nanbox_as_obj(container) : NULL;
+        if (c && value_is_array(c)) {
+            if (!nanbox_is_int(index)) {
+                RUNTIME_ERROR("array index must be integer", REGVM_ERROR_TYPE);
+            }
+            int64_t idx = nanbox_as_int(index);
+            if (idx < 0 || (size_t)idx >= c->as.array->length) {
+                RUNTIME_ERROR("array index out of bounds", REGVM_ERROR_RUNTIME);
+            }
+            c = array_set(value_write_ref(c), (size_t)idx, regvm_claim(vm, R(i.rs2)));
+        } else if (c && value_is_map(c)) {
+            Value *key = nanbox_is_obj(index) ? (Value *)nanbox_as_obj(index) : NULL;
+            if (!key || !value_is_string(key)) {
+                RUNTIME_ERROR("map key must be string", REGVM_ERROR_TYPE);
+            }
+            c = map_set(value_write_ref(c), key->as.string->data, regvm_claim(vm, R(i.rs2)));
+        } else {
+            RUNTIME_ERROR("expected array or map", REGVM_ERROR_TYPE);
         }
+        if (c != nanbox_as_obj(container)) regvm_adopt(vm, c);
+        R(i.rd) = value_to_nanbox(c);
         DISPATCH();
     }
 
-    op_concat: {
-        RegInstr i = cur_instr;
-        Value *a = nanbox_to_value(R(i.rs1));
-        Value *b = nanbox_to_value(R(i.rs2));
-        /* Handle nil as empty string */
-        bool a_str = !a || value_is_nil(a) || value_is_string(a);
-        bool b_str = !b || value_is_nil(b) || value_is_string(b);
-        if (a_str && b_str) {
-            Value *str_a = (!a || value_is_nil(a)) ? value_string("") : a;
-            Value *str_b = (!b || value_is_nil(b)) ? value_string("") : b;
-            R(i.rd) = value_to_nanbox(string_concat(str_a, str_b));
-        } else {
-            R(i.rd) = NANBOX_NIL;
-        }
+    TARGET(MAP_NEW) {
+        Value *map = value_map();
+        regvm_adopt(vm, map);
+        R(i.rd) = value_to_nanbox(map);
         DISPATCH();
     }
 
-    op_len: {
-        RegInstr i = cur_instr;
-        Value *v = nanbox_to_value(R(i.rs1));
-        int64_t len = 0;
-        if (v) {
-            if (value_is_array(v)) {
-                len = (int64_t)array_length(v);
-            } else if (value_is_string(v)) {
-                len = (int64_t)string_length(v);
-            } else if (value_is_map(v)) {
-                len = (int64_t)map_size(v);
-            }
+    TARGET(MAP_GET) {
+        NanValue container = R(i.rs1), key_val = R(i.rs2);
+        Value *c = nanbox_is_obj(container) ? (Value *)nanbox_as_obj(container) : NULL;
+        Value *key = nanbox_is_obj(key_val) ? (Value *)nanbox_as_obj(key_val) : NULL;
+        if (!c || (!value_is_map(c) && !value_is_struct(c))) {
+            RUNTIME_ERROR("expected map or struct", REGVM_ERROR_TYPE);
         }
-        R(i.rd) = nanbox_int(len);
+        if (!key || !value_is_string(key)) {
+            RUNTIME_ERROR("map key must be string", REGVM_ERROR_TYPE);
+        }
+        Value *val = value_is_struct(c) ? value_struct_get_field(c, key->as.string->data)
+                                        : map_get(c, key->as.string->data);
+        R(i.rd) = val ? value_to_nanbox(val) : NANBOX_NIL;
         DISPATCH();
     }
 
-    op_print: {
-        RegInstr i = cur_instr;
-        Value *v = nanbox_to_value(R(i.rd));
-        value_print(v);
-        printf("\n");
+    TARGET(MAP_SET) {
+        /* rs1[rs2] = rd, rs1 updated with the possibly-copied map */
+        Value *map = nanbox_is_obj(R(i.rs1)) ? (Value *)nanbox_as_obj(R(i.rs1)) : NULL;
+        Value *key = nanbox_is_obj(R(i.rs2)) ? (Value *)nanbox_as_obj(R(i.rs2)) : NULL;
+        if (!map || !value_is_map(map)) {
+            RUNTIME_ERROR("expected map", REGVM_ERROR_TYPE);
+        }
+        if (!key || !value_is_string(key)) {
+            RUNTIME_ERROR("map key must be string", REGVM_ERROR_TYPE);
+        }
+        Value *updated = map_set(value_write_ref(map), key->as.string->data,
+                                 regvm_claim(vm, R(i.rd)));
+        if (updated != map) regvm_adopt(vm, updated);
+        R(i.rs1) = value_to_nanbox(updated);
         DISPATCH();
     }
 
-    op_halt:
-        return REGVM_HALT;
-
-    #undef DISPATCH
-
-#else
-    /* Switch-based dispatch (portable fallback) */
-
-    for (;;) {
-        RegInstr i = *frame->ip++;
-
-        switch (i.op) {
-        case ROP_NOP:
-            break;
-
-        case ROP_MOV:
-            R(i.rd) = R(i.rs1);
-            break;
-
-        case ROP_LOAD_K: {
-            uint16_t idx = reg_get_imm(i);
-            if (idx < chunk->constants_size) {
-                R(i.rd) = value_to_nanbox(chunk->constants[idx]);
-            }
-            break;
+    TARGET(CONCAT) {
+        NanValue a = R(i.rs1), b = R(i.rs2);
+        if (!reg_is_string_or_nil(a) || !reg_is_string_or_nil(b)) {
+            RUNTIME_ERROR("concat requires strings", REGVM_ERROR_TYPE);
         }
+        R(i.rd) = regvm_concat(vm, a, b);
+        DISPATCH();
+    }
 
-        case ROP_LOAD_NIL:
-            R(i.rd) = NANBOX_NIL;
-            break;
-
-        case ROP_LOAD_TRUE:
-            R(i.rd) = nanbox_bool(true);
-            break;
-
-        case ROP_LOAD_FALSE:
-            R(i.rd) = nanbox_bool(false);
-            break;
-
-        case ROP_LOAD_INT:
-            R(i.rd) = nanbox_int((int16_t)reg_get_imm(i));
-            break;
-
-        case ROP_ADD:
-            R(i.rd) = nanbox_add(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_SUB:
-            R(i.rd) = nanbox_sub(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_MUL:
-            R(i.rd) = nanbox_mul(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_DIV:
-            R(i.rd) = nanbox_div(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_MOD:
-            R(i.rd) = nanbox_mod(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_NEG:
-            R(i.rd) = nanbox_neg(R(i.rs1));
-            break;
-
-        case ROP_EQ:
-            R(i.rd) = nanbox_eq(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_NE: {
-            NanValue eq = nanbox_eq(R(i.rs1), R(i.rs2));
-            R(i.rd) = nanbox_bool(!nanbox_as_bool(eq));
-            break;
+    TARGET(SPAWN) {
+        Block *block = (Block *)vm->block;
+        Scheduler *sched = (Scheduler *)vm->scheduler;
+        if (!block || !sched) {
+            RUNTIME_ERROR("no runtime context for spawn", REGVM_ERROR_RUNTIME);
+        }
+        if (!block_has_cap(block, CAP_SPAWN)) {
+            RUNTIME_ERROR("spawn capability denied", REGVM_ERROR_RUNTIME);
         }
 
-        case ROP_LT:
-            R(i.rd) = nanbox_lt(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_LE:
-            R(i.rd) = nanbox_le(R(i.rs1), R(i.rs2));
-            break;
-
-        case ROP_GT:
-            R(i.rd) = nanbox_lt(R(i.rs2), R(i.rs1));
-            break;
-
-        case ROP_GE:
-            R(i.rd) = nanbox_le(R(i.rs2), R(i.rs1));
-            break;
-
-        case ROP_NOT:
-            R(i.rd) = nanbox_bool(!reg_nanbox_is_truthy(R(i.rs1)));
-            break;
-
-        case ROP_AND:
-            R(i.rd) = reg_nanbox_is_truthy(R(i.rs1)) ? R(i.rs2) : R(i.rs1);
-            break;
-
-        case ROP_OR:
-            R(i.rd) = reg_nanbox_is_truthy(R(i.rs1)) ? R(i.rs1) : R(i.rs2);
-            break;
-
-        case ROP_JMP:
-            frame->ip += reg_get_offset(i);
-            break;
-
-        case ROP_JMP_IF:
-            if (reg_nanbox_is_truthy(R(i.rd))) {
-                frame->ip += reg_get_cond_offset(i);
-            }
-            break;
+        RegChunk *fn = regvm_function(vm, R(i.rs1));
+        if (!fn) {
+            RUNTIME_ERROR("spawn requires function", REGVM_ERROR_TYPE);
+        }
 
-        case ROP_JMP_UNLESS:
-            if (!reg_nanbox_is_truthy(R(i.rd))) {
-                frame->ip += reg_get_cond_offset(i);
-            }
-            break;
+        char spawn_name[64];
+        snprintf(spawn_name, sizeof(spawn_name), "spawn_%lu",
+                 (unsigned long)sched->next_pid);
 
-        case ROP_LOOP:
-            frame->ip -= (-reg_get_offset(i));
-            break;
+        /* Inherit parent's capabilities minus spawn (prevent fork bomb) */
+        Pid child_pid = scheduler_spawn_reg(sched, vm->program, fn, spawn_name,
+                                            block->capabilities & ~CAP_SPAWN,
+                                            &block->limits);
+        if (child_pid == PID_INVALID) {
+            RUNTIME_ERROR("failed to spawn block", REGVM_ERROR_RUNTIME);
+        }
 
-        case ROP_RET: {
-            NanValue result = R(i.rd);
-            vm->frame_count--;
-            if (vm->frame_count == 0) {
-                return REGVM_OK;
-            }
-            frame = &vm->frames[vm->frame_count - 1];
-            R(frame->result_reg) = result;
-            break;
+        Block *child = scheduler_get_block(sched, child_pid);
+        if (child) {
+            child->parent = block->pid;
         }
 
-        case ROP_ARRAY_NEW:
-            R(i.rd) = value_to_nanbox(value_array());
-            break;
+        R(i.rd) = nanbox_pid(child_pid);
+        DISPATCH();
+    }
 
-        case ROP_ARRAY_PUSH: {
-            Value *arr = nanbox_to_value(R(i.rd));
-            Value *val = nanbox_to_value(R(i.rs1));
-            if (arr && value_is_array(arr)) {
-                arr = array_push(arr, val);
-                R(i.rd) = value_to_nanbox(arr);
-            }
-            break;
+    TARGET(SELF) {
+        Block *block = (Block *)vm->block;
+        if (!block) {
+            RUNTIME_ERROR("no runtime context", REGVM_ERROR_RUNTIME);
         }
+        R(i.rd) = nanbox_pid(block->pid);
+        DISPATCH();
+    }
 
-        case ROP_ARRAY_GET: {
-            Value *arr = nanbox_to_value(R(i.rs1));
-            if (arr && value_is_array(arr) && nanbox_is_int(R(i.rs2))) {
-                int64_t idx = nanbox_as_int(R(i.rs2));
-                if (idx >= 0) {
-                    Value *item = array_get(arr, (size_t)idx);
-                    R(i.rd) = item ? value_to_nanbox(item) : NANBOX_NIL;
-                } else {
-                    R(i.rd) = NANBOX_NIL;
-                }
-            } else {
-                R(i.rd) = NANBOX_NIL;
-            }
-            break;
-        }
+    TARGET(YIELD)
+        R(i.rd) = NANBOX_NIL;
+        return REGVM_YIELD;
 
-        case ROP_MAP_NEW:
-            R(i.rd) = value_to_nanbox(value_map());
-            break;
-
-        case ROP_MAP_GET: {
-            Value *map = nanbox_to_value(R(i.rs1));
-            Value *key = nanbox_to_value(R(i.rs2));
-            if (map && value_is_map(map) && key && value_is_string(key)) {
-                Value *val = map_get(map, key->as.string->data);
-                R(i.rd) = val ? value_to_nanbox(val) : NANBOX_NIL;
-            } else {
-                R(i.rd) = NANBOX_NIL;
-            }
-            break;
+    TARGET(LEN) {
+        Value *v = nanbox_is_obj(R(i.rs1)) ? (Value *)nanbox_as_obj(R(i.rs1)) : NULL;
+        int64_t len = 0;
+        if (nanbox_is_nil(R(i.rs1))) {
+            len = 0;
+        } else if (v && value_is_array(v)) {
+            len = (int64_t)array_length(v);
+        } else if (v && value_is_string(v)) {
+            len = (int64_t)string_length(v);
+        } else if (v && value_is_map(v)) {
+            len = (int64_t)map_size(v);
+        } else {
+            RUNTIME_ERROR("len() requires array, string, or map", REGVM_ERROR_TYPE);
         }
+        R(i.rd) = nanbox_int(len);
+        DISPATCH();
+    }
 
-        case ROP_MAP_SET: {
-            Value *map = nanbox_to_value(R(i.rs1));
-            Value *key = nanbox_to_value(R(i.rs2));
-            Value *val = nanbox_to_value(R(i.rd));
-            if (map && value_is_map(map) && key && value_is_string(key)) {
-                map = map_set(map, key->as.string->data, val);
-                R(i.rs1) = value_to_nanbox(map);
-            }
-            break;
-        }
+    TARGET(PRINT) {
+        Value scratch;
+        value_print(nanbox_borrow_value(R(i.rd), &scratch));
+        printf("\n");
+        DISPATCH();
+    }
 
-        case ROP_CONCAT: {
-            Value *a = nanbox_to_value(R(i.rs1));
-            Value *b = nanbox_to_value(R(i.rs2));
-            /* Handle nil as empty string */
-            bool a_str = !a || value_is_nil(a) || value_is_string(a);
-            bool b_str = !b || value_is_nil(b) || value_is_string(b);
-            if (a_str && b_str) {
-                Value *str_a = (!a || value_is_nil(a)) ? value_string("") : a;
-                Value *str_b = (!b || value_is_nil(b)) ? value_string("") : b;
-                R(i.rd) = value_to_nanbox(string_concat(str_a, str_b));
-            } else {
-                R(i.rd) = NANBOX_NIL;
-            }
-            break;
+    TARGET(STACK) {
+        uint32_t offset = frame->ip->raw;
+        frame->ip++;
+        RegVMResult result = regvm_run_stub(vm, regs, i, offset);
+        if (result == REGVM_YIELD || result == REGVM_WAITING) {
+            /* Blocked (receive, sleep): rerun the whole stub on resume */
+            frame->ip -= 2;
+            return result;
         }
-
-        case ROP_LEN: {
-            Value *v = nanbox_to_value(R(i.rs1));
-            int64_t len = 0;
-            if (v) {
-                if (value_is_array(v)) {
-                    len = (int64_t)array_length(v);
-                } else if (value_is_string(v)) {
-                    len = (int64_t)string_length(v);
-                } else if (value_is_map(v)) {
-                    len = (int64_t)map_size(v);
-                }
+        if (result != REGVM_OK) {
+            if (vm->error_line == 0) {
+                vm->error_line = frame->chunk->lines[frame->ip - frame->chunk->code - 2];
             }
-            R(i.rd) = nanbox_int(len);
-            break;
-        }
-
-        case ROP_PRINT: {
-            Value *v = nanbox_to_value(R(i.rd));
-            value_print(v);
-            printf("\n");
-            break;
+            return result;
         }
+        DISPATCH();
+    }
 
-        case ROP_HALT:
-            return REGVM_HALT;
+    TARGET(HALT)
+        return REGVM_HALT;
 
-        default:
-            regvm_set_error(vm, "unknown opcode");
-            return REGVM_ERROR_RUNTIME;
-        }
+#if USE_REG_COMPUTED_GOTO
+    op_unsupported:
+#else
+    default:
+#endif
+        RUNTIME_ERROR("unknown opcode", REGVM_ERROR_RUNTIME);
+
+#if !USE_REG_COMPUTED_GOTO
+    case ROP_MAP_GET_IC:
+    case ROP_CLOSURE:
+    case ROP_GET_UPVALUE:
+    case ROP_SET_UPVALUE:
+    case ROP_CLOSE_UPVALUE:
+    case ROP_SEND:
+    case ROP_RECEIVE:
+    case ROP_TYPE:
+    case ROP_COUNT:
+        RUNTIME_ERROR("unknown opcode", REGVM_ERROR_RUNTIME);
     }
 #endif
 
     #undef R
+    #undef RUNTIME_ERROR
+    #undef REDUCE
+    #undef JUMP_BY
+    #undef ARITH_OP
+    #undef COMPARE_OP
+    #undef TARGET
+    #undef DISPATCH
+}
+
+RegVMResult regvm_resume(RegVM *vm) {
+    if (!vm) return REGVM_ERROR_RUNTIME;
+    if (vm->frame_count == 0) {
+        regvm_set_error(vm, "no code loaded");
+        return REGVM_ERROR_RUNTIME;
+    }
+    return regvm_execute(vm);
+}
+
+RegVMResult regvm_run(RegVM *vm, RegChunk *chunk) {
+    if (!vm || !chunk) return REGVM_ERROR_RUNTIME;
+    if (!regvm_load(vm, chunk, chunk)) return REGVM_ERROR_RUNTIME;
+    return regvm_execute(vm);
 }
 
 /* Disassembly */
@@ -1054,14 +1253,15 @@ static const char *rop_names[] = {
     [ROP_LEN] = "LEN",
     [ROP_TYPE] = "TYPE",
     [ROP_PRINT] = "PRINT",
+    [ROP_STACK] = "STACK",
     [ROP_HALT] = "HALT",
 };
 
 void regchunk_disassemble(RegChunk *chunk, const char *name) {
     printf("== %s (register) ==\n", name);
 
-    for (size_t i = 0; i < chunk->code_size; i++) {
-        regchunk_disassemble_instruction(chunk, i);
+    for (size_t i = 0; i < chunk->code_size;) {
+        i = regchunk_disassemble_instruction(chunk, i);
     }
 }
 
@@ -1106,21 +1306,50 @@ size_t regchunk_disassemble_instruction(RegChunk *chunk, size_t offset) {
     case ROP_OR:
     case ROP_CONCAT:
     case ROP_ARRAY_GET:
+    case ROP_ARRAY_SET:
     case ROP_MAP_GET:
+    case ROP_MAP_SET:
         printf(" r%d, r%d, r%d", i.rd, i.rs1, i.rs2);
         break;
 
     case ROP_LOAD_K:
+    case ROP_GET_GLOBAL:
+    case ROP_SET_GLOBAL:
+        printf(" r%d, k%d", i.rd, reg_get_imm(i));
+        break;
+
     case ROP_LOAD_INT:
-        printf(" r%d, %d", i.rd, reg_get_imm(i));
+        printf(" r%d, %d", i.rd, (int16_t)reg_get_imm(i));
+        break;
+
+    case ROP_CALL:
+        printf(" r%d, r%d(%d)", i.rd, i.rs1, i.rs2);
         break;
 
+    case ROP_TAIL_CALL:
+        printf(" r%d(%d)", i.rs1, i.rs2);
+        break;
+
+    case ROP_ARRAY_PUSH:
+    case ROP_SPAWN:
+        printf(" r%d, r%d", i.rd, i.rs1);
+        break;
+
+    case ROP_STACK:
+        if (offset + 1 < chunk->code_size) {
+            printf(" r%d, r%d(%d) @%u", i.rd, i.rs1, i.rs2, chunk->code[offset + 1].raw);
+        }
+        printf("\n");
+        return offset + 2;
+
     case ROP_LOAD_NIL:
     case ROP_LOAD_TRUE:
     case ROP_LOAD_FALSE:
     case ROP_ARRAY_NEW:
     case ROP_MAP_NEW:
     case ROP_PRINT:
+    case ROP_SELF:
+    case ROP_YIELD:
         printf(" r%d", i.rd);
         break;
 
@@ -1131,7 +1360,8 @@ size_t regchunk_disassemble_instruction(RegChunk *chunk, size_t offset) {
 
     case ROP_JMP_IF:
     case ROP_JMP_UNLESS:
-        printf(" r%d, %+d", i.rd, reg_get_offset(i));
+        printf(" r%d, %+d -> %zu", i.rd, reg_get_cond_offset(i),
+               offset + 1 + reg_get_cond_offset(i));
         break;
 
     case ROP_RET:
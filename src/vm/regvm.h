@@ -114,22 +114,27 @@ typedef enum RegOp {
     ROP_TYPE,
     ROP_PRINT,
 
+    ROP_STACK,      /* Run a stack-VM stub: rd = stub(rs1..rs1+rs2-1), next word is the stub offset */
+
     ROP_HALT,
 
     ROP_COUNT
 } RegOp;
 
-/* Register Call Frame */
+/* Register Call Frame
+ *
+ * Frames share one register file: a callee's window starts at the
+ * caller's first argument register, so arguments are passed in place.
+ */
 
 #define REG_MAX_REGISTERS 256
-#define REG_MAX_FRAMES 64
+#define REG_MAX_FRAMES 256
 
 typedef struct RegCallFrame {
     RegInstr *ip;
-    NanValue regs[REG_MAX_REGISTERS];
+    NanValue *regs;                 /* Window into RegVM.registers */
     struct RegChunk *chunk;
-    uint8_t base;
-    uint8_t result_reg;
+    uint8_t result_reg;             /* Caller register receiving the result */
 } RegCallFrame;
 
 /* Register Chunk */
@@ -153,6 +158,14 @@ typedef struct RegChunk {
     uint8_t num_regs;
     uint8_t num_params;
     uint8_t num_upvalues;
+
+    char *name;
+
+    /* Program-level tables, only set on the entry chunk */
+    struct RegChunk **functions;    /* Indexed by function code_offset */
+    size_t functions_count;
+    size_t functions_capacity;
+    Bytecode *stubs;                /* Stack code run by ROP_STACK */
 } RegChunk;
 
 /* Register VM */
@@ -161,9 +174,26 @@ typedef struct RegVM {
     RegCallFrame frames[REG_MAX_FRAMES];
     int frame_count;
 
+    NanValue *registers;
+    size_t registers_capacity;
+
+    RegChunk *program;
+    NanValue result;                /* Value returned by the entry chunk */
+
+    struct VM *stack_vm;            /* Runs ROP_STACK stubs */
+    bool owns_stack_vm;
+
     Value *globals;
     struct Upvalue *open_upvalues;
 
+    /* Values the VM built and nothing else owns yet: registers only
+     * borrow, so these are released with the VM unless a container or
+     * global claims them first. Open-addressed pointer set. */
+    Value **temps;
+    size_t temps_count;             /* Live entries */
+    size_t temps_used;              /* Live entries plus tombstones */
+    size_t temps_capacity;
+
     const char *error;
     int error_line;
 
@@ -179,6 +209,7 @@ typedef enum RegVMResult {
     REGVM_OK,
     REGVM_HALT,
     REGVM_YIELD,
+    REGVM_WAITING,
     REGVM_ERROR_COMPILE,
     REGVM_ERROR_RUNTIME,
     REGVM_ERROR_TYPE,
@@ -192,6 +223,7 @@ void regchunk_free(RegChunk *chunk);
 
 void regchunk_write(RegChunk *chunk, RegInstr instr, int line);
 size_t regchunk_add_constant(RegChunk *chunk, Value *value);
+size_t regchunk_add_function(RegChunk *program, RegChunk *fn);
 
 static inline RegInstr reg_instr(RegOp op, uint8_t rd, uint8_t rs1, uint8_t rs2) {
     return (RegInstr){ .op = op, .rd = rd, .rs1 = rs1, .rs2 = rs2 };
@@ -234,11 +266,15 @@ RegVM *regvm_new(void);
 void regvm_free(RegVM *vm);
 void regvm_reset(RegVM *vm);
 
-RegVMResult regvm_run(RegVM *vm, RegChunk *chunk);
-RegVMResult regvm_call(RegVM *vm, Value *closure, int arg_count);
+/* Load program and start at entry (program's own code when entry is
+ * program). Every program function is defined as a global. */
+bool regvm_load(RegVM *vm, RegChunk *program, RegChunk *entry);
+
+/* Continue after REGVM_YIELD or REGVM_WAITING. Reductions are counted on
+ * calls and backward jumps; callers reset vm->reductions per slice. */
+RegVMResult regvm_resume(RegVM *vm);
 
-void regvm_push(RegVM *vm, Value *value);
-Value *regvm_pop(RegVM *vm);
+RegVMResult regvm_run(RegVM *vm, RegChunk *chunk);
 
 const char *regvm_error(const RegVM *vm);
 int regvm_error_line(const RegVM *vm);
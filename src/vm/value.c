@@ -10,15 +10,40 @@
 #include "vm/value.h"
 #include "util/alloc.h"
 #include "util/hash.h"
+#include "util/worker_alloc.h"
 #include "debug/log.h"
 
 #include <stdio.h>
 #include <string.h>
 
+/* Value Memory */
+
+void *value_mem_alloc(size_t size) {
+    void *ptr = worker_alloc(size);
+    if (!ptr && size > 0) {
+        agim_set_error(AGIM_E_NOMEM);
+        LOG_ERROR("value: failed to allocate %zu bytes", size);
+    }
+    return ptr;
+}
+
+void value_mem_free(void *ptr) {
+    worker_alloc_release(ptr);
+}
+
 /* Value Constructors */
 
+void value_init_header(Value *v, ValueType type, uint8_t flags) {
+    v->type = type;
+    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
+    v->flags = flags;
+    v->gc_state = 0;
+    v->next = NULL;
+    memset(&v->as, 0, sizeof(v->as));
+}
+
 Value *value_nil(void) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) {
         LOG_ERROR("value: failed to allocate nil value");
         return NULL;
@@ -32,7 +57,7 @@ Value *value_nil(void) {
 }
 
 Value *value_bool(bool value) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) {
         LOG_ERROR("value: failed to allocate bool value");
         return NULL;
@@ -47,7 +72,7 @@ Value *value_bool(bool value) {
 }
 
 Value *value_int(int64_t value) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) {
         LOG_ERROR("value: failed to allocate int value");
         return NULL;
@@ -62,7 +87,7 @@ Value *value_int(int64_t value) {
 }
 
 Value *value_float(double value) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) {
         LOG_ERROR("value: failed to allocate float value");
         return NULL;
@@ -77,7 +102,7 @@ Value *value_float(double value) {
 }
 
 Value *value_pid(uint64_t pid) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_PID;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -88,32 +113,59 @@ Value *value_pid(uint64_t pid) {
     return v;
 }
 
-Value *value_function(const char *name, size_t arity) {
-    Value *v = agim_alloc(sizeof(Value));
-    if (!v) return NULL;
-    v->type = VAL_FUNCTION;
-    atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
-    v->flags = 0;
-    v->gc_state = 0;
-    v->next = NULL;
-
+bool value_init_function(Value *v, const char *name, size_t arity) {
     Function *fn = agim_alloc(sizeof(Function));
-    if (!fn) {
-        agim_free(v);
-        return NULL;
-    }
+    if (!fn) return false;
     fn->name = name ? strdup(name) : NULL;
     fn->arity = arity;
     fn->code_offset = 0;
     fn->locals_count = 0;
     fn->parent = NULL;
 
+    value_init_header(v, VAL_FUNCTION, 0);
     v->as.function = fn;
+    return true;
+}
+
+Value *value_function(const char *name, size_t arity) {
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) return NULL;
+    if (!value_init_function(v, name, arity)) {
+        value_mem_free(v);
+        return NULL;
+    }
     return v;
 }
 
+bool value_init_bytes(Value *v, size_t capacity) {
+    Bytes *bytes = agim_alloc(sizeof(Bytes));
+    if (!bytes) return false;
+    bytes->length = 0;
+    bytes->capacity = capacity > 0 ? capacity : 64;
+    bytes->shared = NULL;
+    bytes->data = agim_alloc(bytes->capacity);
+    if (!bytes->data) {
+        agim_free(bytes);
+        return false;
+    }
+
+    value_init_header(v, VAL_BYTES, 0);
+    v->as.bytes = bytes;
+    return true;
+}
+
 Value *value_bytes(size_t capacity) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
+    if (!v) return NULL;
+    if (!value_init_bytes(v, capacity)) {
+        value_mem_free(v);
+        return NULL;
+    }
+    return v;
+}
+
+Value *value_bytes_slice(SharedBuffer *buf, const uint8_t *data, size_t length) {
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_BYTES;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -123,17 +175,13 @@ Value *value_bytes(size_t capacity) {
 
     Bytes *bytes = agim_alloc(sizeof(Bytes));
     if (!bytes) {
-        agim_free(v);
-        return NULL;
-    }
-    bytes->length = 0;
-    bytes->capacity = capacity > 0 ? capacity : 64;
-    bytes->data = agim_alloc(bytes->capacity);
-    if (!bytes->data) {
-        agim_free(bytes);
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
+    bytes->length = length;
+    bytes->capacity = length;
+    bytes->data = (uint8_t *)data;
+    bytes->shared = shared_buffer_retain(buf);
 
     v->as.bytes = bytes;
     return v;
@@ -142,7 +190,7 @@ Value *value_bytes(size_t capacity) {
 /* Result Constructors */
 
 Value *value_result_ok(Value *value) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_RESULT;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -152,7 +200,7 @@ Value *value_result_ok(Value *value) {
 
     Result *result = agim_alloc(sizeof(Result));
     if (!result) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     result->is_ok = true;
@@ -163,7 +211,7 @@ Value *value_result_ok(Value *value) {
 }
 
 Value *value_result_err(Value *error) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_RESULT;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -173,7 +221,7 @@ Value *value_result_err(Value *error) {
 
     Result *result = agim_alloc(sizeof(Result));
     if (!result) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     result->is_ok = false;
@@ -216,7 +264,7 @@ Value *value_result_unwrap_err(const Value *v) {
 /* Option Constructors */
 
 Value *value_some(Value *value) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_OPTION;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -226,7 +274,7 @@ Value *value_some(Value *value) {
 
     Option *opt = agim_alloc(sizeof(Option));
     if (!opt) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     opt->is_some = true;
@@ -237,7 +285,7 @@ Value *value_some(Value *value) {
 }
 
 Value *value_none(void) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_OPTION;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -247,7 +295,7 @@ Value *value_none(void) {
 
     Option *opt = agim_alloc(sizeof(Option));
     if (!opt) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     opt->is_some = false;
@@ -284,7 +332,7 @@ Value *value_option_unwrap_or(const Value *v, Value *default_val) {
 /* Struct Constructors */
 
 Value *value_struct_new(const char *type_name, size_t field_count) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_STRUCT;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -294,7 +342,7 @@ Value *value_struct_new(const char *type_name, size_t field_count) {
 
     StructInstance *inst = agim_alloc(sizeof(StructInstance));
     if (!inst) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     inst->type_name = strdup(type_name);
@@ -350,7 +398,7 @@ const char *value_struct_type_name(const Value *v) {
 /* Enum Constructors */
 
 Value *value_enum_unit(const char *type_name, const char *variant_name) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_ENUM;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -360,7 +408,7 @@ Value *value_enum_unit(const char *type_name, const char *variant_name) {
 
     EnumInstance *inst = agim_alloc(sizeof(EnumInstance));
     if (!inst) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     inst->type_name = strdup(type_name);
@@ -372,7 +420,7 @@ Value *value_enum_unit(const char *type_name, const char *variant_name) {
 }
 
 Value *value_enum_with_payload(const char *type_name, const char *variant_name, Value *payload) {
-    Value *v = agim_alloc(sizeof(Value));
+    Value *v = value_mem_alloc(sizeof(Value));
     if (!v) return NULL;
     v->type = VAL_ENUM;
     atomic_store_explicit(&v->refcount, 1, memory_order_relaxed);
@@ -382,7 +430,7 @@ Value *value_enum_with_payload(const char *type_name, const char *variant_name,
 
     EnumInstance *inst = agim_alloc(sizeof(EnumInstance));
     if (!inst) {
-        agim_free(v);
+        value_mem_free(v);
         return NULL;
     }
     inst->type_name = strdup(type_name);
@@ -545,6 +593,13 @@ bool value_equals(const Value *a, const Value *b) {
         }
         return true;
     }
+    case VAL_BYTES: {
+        Bytes *bytes_a = a->as.bytes;
+        Bytes *bytes_b = b->as.bytes;
+        return bytes_a->length == bytes_b->length &&
+               (bytes_a->length == 0 ||
+                memcmp(bytes_a->data, bytes_b->data, bytes_a->length) == 0);
+    }
     default:
         return a == b;
     }
@@ -648,13 +703,53 @@ size_t bytes_length(const Value *v) {
     return v->as.bytes->length;
 }
 
+/* Give a borrowed slice its own storage before it is modified */
+static bool bytes_detach(Bytes *bytes, size_t extra) {
+    size_t cap = bytes->length + extra;
+    if (cap < 64) cap = 64;
+
+    uint8_t *data = agim_alloc(cap);
+    if (!data) return false;
+    memcpy(data, bytes->data, bytes->length);
+
+    shared_buffer_release(bytes->shared);
+    bytes->shared = NULL;
+    bytes->data = data;
+    bytes->capacity = cap;
+    return true;
+}
+
+/* Move a large value's own storage into a shared buffer. Copies then
+ * borrow it, so every receiver of the same bytes points at one buffer
+ * instead of holding its own copy. */
+bool bytes_share(Value *v) {
+    if (!v || v->type != VAL_BYTES) return false;
+    Bytes *bytes = v->as.bytes;
+    if (bytes->shared) return true;
+    if (bytes->length < BYTES_SHARE_MIN) return false;
+
+    SharedBuffer *buf = shared_buffer_new(bytes->length);
+    if (!buf) return false;
+    memcpy(buf->data, bytes->data, bytes->length);
+
+    agim_free(bytes->data);
+    bytes->data = buf->data;
+    bytes->capacity = bytes->length;
+    bytes->shared = buf;
+    return true;
+}
+
 bool bytes_append(Value *v, const uint8_t *data, size_t length) {
     if (!v || v->type != VAL_BYTES) return false;
+    if (v->flags & VALUE_IMMUTABLE) return false;
     Bytes *bytes = v->as.bytes;
 
     if (bytes->length > SIZE_MAX - length) {
         return false;
     }
+    if (bytes->shared && !bytes_detach(bytes, length)) {
+        return false;
+    }
 
     while (bytes->length + length > bytes->capacity) {
         if (bytes->capacity > SIZE_MAX / 2) {
@@ -672,6 +767,30 @@ bool bytes_append(Value *v, const uint8_t *data, size_t length) {
     return true;
 }
 
+/* Shared Buffers */
+
+SharedBuffer *shared_buffer_new(size_t capacity) {
+    SharedBuffer *buf = agim_alloc(sizeof(SharedBuffer) + capacity);
+    if (!buf) return NULL;
+    atomic_store_explicit(&buf->refcount, 1, memory_order_relaxed);
+    buf->capacity = capacity;
+    return buf;
+}
+
+SharedBuffer *shared_buffer_retain(SharedBuffer *buf) {
+    if (buf) {
+        atomic_fetch_add_explicit(&buf->refcount, 1, memory_order_relaxed);
+    }
+    return buf;
+}
+
+void shared_buffer_release(SharedBuffer *buf) {
+    if (!buf) return;
+    if (atomic_fetch_sub_explicit(&buf->refcount, 1, memory_order_acq_rel) == 1) {
+        agim_free(buf);
+    }
+}
+
 /* Debug */
 
 void value_print(const Value *v) {
@@ -984,7 +1103,7 @@ void value_free(Value *v) {
 
     switch (v->type) {
     case VAL_STRING:
-        agim_free(v->as.string);
+        value_mem_free(v->as.string);
         break;
     case VAL_ARRAY: {
         Array *arr = v->as.array;
@@ -994,7 +1113,7 @@ void value_free(Value *v) {
             }
         }
         agim_free(arr->items);
-        agim_free(arr);
+        value_mem_free(arr);
         break;
     }
     case VAL_MAP: {
@@ -1006,13 +1125,13 @@ void value_free(Value *v) {
                 if (entry->value) {
                     value_free(entry->value);
                 }
-                agim_free(entry->key);
-                agim_free(entry);
+                value_mem_free(entry->key);
+                value_mem_free(entry);
                 entry = next;
             }
         }
         agim_free(map->buckets);
-        agim_free(map);
+        value_mem_free(map);
         break;
     }
     case VAL_FUNCTION:
@@ -1020,7 +1139,11 @@ void value_free(Value *v) {
         agim_free(v->as.function);
         break;
     case VAL_BYTES:
-        agim_free(v->as.bytes->data);
+        if (v->as.bytes->shared) {
+            shared_buffer_release(v->as.bytes->shared);
+        } else {
+            agim_free(v->as.bytes->data);
+        }
         agim_free(v->as.bytes);
         break;
     case VAL_VECTOR:
@@ -1082,7 +1205,10 @@ void value_free(Value *v) {
         break;
     }
 
-    agim_free(v);
+    /* Nursery headers are handed back by the owning heap's sweep */
+    if (!(v->flags & VALUE_NURSERY)) {
+        value_mem_free(v);
+    }
 }
 
 Value *value_copy(const Value *v) {
@@ -1133,6 +1259,18 @@ Value *value_copy(const Value *v) {
         Vector *vec = (Vector *)v->as.vector;
         return value_vector_from(vec->data, vec->dim);
     }
+    case VAL_BYTES: {
+        Bytes *bytes = v->as.bytes;
+        if (bytes->shared) {
+            /* Slices of shared storage are never written in place */
+            return value_bytes_slice(bytes->shared, bytes->data, bytes->length);
+        }
+        Value *copy = value_bytes(bytes->length);
+        if (copy && bytes->length > 0) {
+            bytes_append(copy, bytes->data, bytes->length);
+        }
+        return copy;
+    }
     case VAL_CLOSURE:
         return value_nil();
     case VAL_RESULT:
@@ -1218,6 +1356,22 @@ void value_release(Value *v) {
     }
 }
 
+void value_pin(Value *v) {
+    if (v) {
+        atomic_store_explicit(&v->refcount, REFCOUNT_SATURATED, memory_order_release);
+    }
+}
+
+bool value_is_pinned(const Value *v) {
+    return v && atomic_load_explicit(&v->refcount, memory_order_acquire) == REFCOUNT_SATURATED;
+}
+
+void value_free_pinned(Value *v) {
+    if (!v) return;
+    atomic_store_explicit(&v->refcount, 1, memory_order_release);
+    value_free(v);
+}
+
 bool value_needs_cow(const Value *v) {
     return v && atomic_load_explicit(&v->refcount, memory_order_acquire) > 1;
 }
@@ -1273,6 +1427,8 @@ bool value_is_immutable(const Value *v) {
     case VAL_MAP:
     case VAL_BYTES:
     case VAL_CLOSURE:
+    case VAL_RESULT:
+    case VAL_OPTION:
         return (v->flags & VALUE_IMMUTABLE) != 0;
 
     default:
@@ -1290,3 +1446,55 @@ Value *value_cow_share(Value *v) {
     v->flags |= VALUE_COW_SHARED;
     return value_retain(v);
 }
+
+/*
+ * Freezing marks a whole tree immutable in place. Nothing observable
+ * changes for the owner: writes to a frozen array or map copy it first,
+ * as they would if it were shared. In exchange, block_send can pass the
+ * root by refcount alone, because no holder can ever write through it or
+ * through any child it hands out.
+ */
+bool value_freeze(Value *v) {
+    if (!v || value_is_immutable(v)) return true;
+
+    switch (v->type) {
+    case VAL_ARRAY: {
+        Array *arr = v->as.array;
+        for (size_t i = 0; i < arr->length; i++) {
+            if (!value_freeze(arr->items[i])) return false;
+        }
+        break;
+    }
+    case VAL_MAP: {
+        Map *map = v->as.map;
+        for (size_t i = 0; i < map->capacity; i++) {
+            for (MapEntry *entry = map->buckets[i]; entry; entry = entry->next) {
+                if (!value_freeze(entry->value)) return false;
+            }
+        }
+        break;
+    }
+    case VAL_BYTES:
+        break;
+    case VAL_RESULT:
+        if (!value_freeze(v->as.result->value)) return false;
+        break;
+    case VAL_OPTION:
+        if (!value_freeze(v->as.option->value)) return false;
+        break;
+    default:
+        /* Closures, structs and enums are written in place */
+        return false;
+    }
+
+    v->flags |= VALUE_IMMUTABLE;
+    return true;
+}
+
+Value *value_write_ref(Value *v) {
+    if (v && (v->type == VAL_ARRAY || v->type == VAL_MAP) &&
+        (v->flags & VALUE_IMMUTABLE)) {
+        value_retain(v);
+    }
+    return v;
+}
@@ -54,10 +54,18 @@ typedef struct Function {
 
 /* Byte Buffer */
 
+/* Reference-counted storage that Bytes values can borrow slices of */
+typedef struct SharedBuffer {
+    _Atomic(uint32_t) refcount;
+    size_t capacity;
+    uint8_t data[];
+} SharedBuffer;
+
 typedef struct Bytes {
     size_t length;
     size_t capacity;
     uint8_t *data;
+    SharedBuffer *shared;   /* Storage data borrows from (NULL = owns data) */
 } Bytes;
 
 /* Result Type */
@@ -95,6 +103,7 @@ typedef struct EnumInstance {
 
 #define VALUE_COW_SHARED   0x01
 #define VALUE_IMMUTABLE    0x02
+#define VALUE_NURSERY      0x04  /* Header lives in a GC heap nursery chunk */
 
 #define REFCOUNT_FREEING   UINT32_MAX
 #define REFCOUNT_SATURATED (UINT32_MAX - 1)
@@ -222,6 +231,16 @@ static inline void value_set_remembered(Value *v, bool remembered) {
     }
 }
 
+/* Value Memory
+ *
+ * Headers and the String, Array and Map structures behind them come from
+ * the current worker's size-class pools on worker threads and from malloc
+ * elsewhere. value_mem_free accepts either and may run on any thread.
+ */
+
+void *value_mem_alloc(size_t size);
+void value_mem_free(void *ptr);
+
 /* Value Constructors */
 
 Value *value_nil(void);
@@ -231,6 +250,15 @@ Value *value_float(double value);
 Value *value_pid(uint64_t pid);
 Value *value_function(const char *name, size_t arity);
 Value *value_bytes(size_t capacity);
+Value *value_bytes_slice(SharedBuffer *buf, const uint8_t *data, size_t length);
+
+/* Initialise a caller-provided header in place (refcount 1, unlinked).
+ * The value_init_* functions for compound types allocate the payload and
+ * return false, leaving the header untouched, if that fails. */
+
+void value_init_header(Value *v, ValueType type, uint8_t flags);
+bool value_init_function(Value *v, const char *name, size_t arity);
+bool value_init_bytes(Value *v, size_t capacity);
 
 /* Result Constructors */
 
@@ -300,9 +328,19 @@ const char *value_to_string(const Value *v);
 
 /* Bytes Operations */
 
+/* Bytes at least this long are shared rather than copied between blocks */
+#define BYTES_SHARE_MIN 64
+
 size_t bytes_length(const Value *v);
+bool bytes_share(Value *v);
 bool bytes_append(Value *v, const uint8_t *data, size_t length);
 
+/* Shared Buffers */
+
+SharedBuffer *shared_buffer_new(size_t capacity);
+SharedBuffer *shared_buffer_retain(SharedBuffer *buf);
+void shared_buffer_release(SharedBuffer *buf);
+
 /* Debug */
 
 void value_print(const Value *v);
@@ -313,6 +351,12 @@ char *value_repr(const Value *v);
 void value_free(Value *v);
 Value *value_copy(const Value *v);
 
+/* A pinned value ignores retain and release until its owner frees it with
+ * value_free_pinned(), so any number of holders can share it uncounted */
+void value_pin(Value *v);
+bool value_is_pinned(const Value *v);
+void value_free_pinned(Value *v);
+
 /* Copy-on-Write Support */
 
 Value *value_retain(Value *v);
@@ -323,4 +367,14 @@ void value_mark_shared(Value *v);
 bool value_is_immutable(const Value *v);
 Value *value_cow_share(Value *v);
 
+/* Deep-mark v immutable so it can be sent by refcount alone. Fails on
+ * closures, structs and enums, which are written in place. */
+bool value_freeze(Value *v);
+
+/* A write to a frozen container copies it and releases the reference it
+ * was handed. Callers holding an uncounted reference (a VM slot) pass
+ * value_write_ref(v) instead, which counts one for the write, so the
+ * original stays with its owner. */
+Value *value_write_ref(Value *v);
+
 #endif /* AGIM_VM_VALUE_H */
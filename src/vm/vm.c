@@ -102,7 +102,9 @@ VM *vm_new(void) {
     vm->frames_capacity = 0;
     vm->initialized = false;
 
-    vm->globals = value_map();
+    vm->globals = NULL;
+    vm->globals_count = 0;
+    vm->pending_globals = NULL;
     vm->code = NULL;
     vm->open_upvalues = NULL;
     vm->error = NULL;
@@ -169,7 +171,13 @@ void vm_free(VM *vm) {
     free(vm->stack);
     free(vm->frames);
 
-    value_free(vm->globals);
+    for (size_t i = 0; i < vm->globals_count; i++) {
+        if (nanbox_is_obj(vm->globals[i])) {
+            value_free((Value *)nanbox_as_obj(vm->globals[i]));
+        }
+    }
+    free(vm->globals);
+    value_free(vm->pending_globals);
     free(vm);
 }
 
@@ -208,6 +216,9 @@ static bool vm_ensure_stack(VM *vm, size_t needed) {
     if (new_capacity > VM_STACK_MAX * 4) {
         new_capacity = VM_STACK_MAX * 4;
     }
+    if (new_capacity < required) {
+        return false;
+    }
 
     NanValue *new_stack = realloc(vm->stack, sizeof(NanValue) * new_capacity);
     if (!new_stack) {
@@ -245,6 +256,9 @@ static bool vm_ensure_frames(VM *vm) {
     if (new_capacity > VM_FRAMES_MAX * 4) {
         new_capacity = VM_FRAMES_MAX * 4;
     }
+    if (new_capacity <= vm->frames_capacity) {
+        return false;
+    }
 
     CallFrame *new_frames = realloc(vm->frames, sizeof(CallFrame) * new_capacity);
     if (!new_frames) {
@@ -352,6 +366,20 @@ Value *vm_peek(VM *vm, int distance) {
     return nanbox_to_value(v);
 }
 
+/* Borrowed Operands
+ *
+ * Cold-path opcodes that only inspect an operand use a borrowed view so
+ * primitives are read straight from the NanValue instead of being boxed.
+ */
+
+static inline Value *vm_pop_borrow(VM *vm, Value *scratch) {
+    return nanbox_borrow_value(vm_pop_nan(vm), scratch);
+}
+
+static inline Value *vm_peek_borrow(VM *vm, int distance, Value *scratch) {
+    return nanbox_borrow_value(vm_peek_nan(vm, distance), scratch);
+}
+
 /* Execution Helpers */
 
 static inline uint8_t read_byte(CallFrame *frame) {
@@ -400,6 +428,34 @@ static inline bool check_jump_backward(CallFrame *frame, uint16_t offset) {
     return frame->ip >= frame->chunk->code + offset;
 }
 
+/* Selective Receive Matching */
+
+/**
+ * Check a message against a receive_match pattern. A map pattern needs
+ * each of its keys present in a map message, with an equal value unless
+ * the pattern's value is nil. Anything else matches.
+ */
+static bool message_matches(const Value *pattern, Value *msg) {
+    if (!pattern || pattern->type != VAL_MAP || !msg || msg->type != VAL_MAP) {
+        return true;
+    }
+
+    Map *map = pattern->as.map;
+    for (size_t i = 0; i < map->capacity; i++) {
+        for (MapEntry *entry = map->buckets[i]; entry; entry = entry->next) {
+            Value *msg_val = map_get(msg, entry->key->data);
+            if (!msg_val) return false;
+
+            Value *pattern_val = entry->value;
+            if (pattern_val && pattern_val->type != VAL_NIL &&
+                !value_equals(pattern_val, msg_val)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 /* NaN-Boxed Binary Operation Macros */
 
 #define BINARY_OP_NUM_NAN(vm, op)                                       \
@@ -448,46 +504,158 @@ static inline bool check_jump_backward(CallFrame *frame, uint16_t offset) {
         }                                                               \
     } while (0)
 
-/* Keep old macros for compatibility with cold path */
-#define BINARY_OP_NUM(vm, op)                                           \
+/* Arithmetic the type checker saw as int-only or float-only. Its types
+ * are hints, not guarantees, so any other operands go to the generic
+ * handler `fallback`; both operands were peeked, so the result
+ * overwrites them in place. */
+#define TYPED_OP_NAN(vm, is_kind, unbox, box, op, fallback)             \
     do {                                                                \
-        Value *b = vm_pop(vm);                                          \
-        Value *a = vm_pop(vm);                                          \
-        if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;                  \
-        if (value_is_int(a) && value_is_int(b)) {                       \
-            vm_push(vm, value_int(a->as.integer op b->as.integer));     \
-        } else if ((value_is_int(a) || value_is_float(a)) &&            \
-                   (value_is_int(b) || value_is_float(b))) {            \
-            double da = value_to_float(a);                              \
-            double db = value_to_float(b);                              \
-            vm_push(vm, value_float(da op db));                         \
-        } else {                                                        \
-            vm_set_error(vm, "operands must be numbers");               \
-            return VM_ERROR_TYPE;                                       \
-        }                                                               \
+        NanValue b = vm_peek_nan(vm, 0);                                \
+        NanValue a = vm_peek_nan(vm, 1);                                \
+        if (!is_kind(a) || !is_kind(b)) goto fallback;                  \
+        vm->stack_top--;                                                \
+        vm->stack_top[-1] = box(unbox(a) op unbox(b));                  \
     } while (0)
 
-#define BINARY_OP_CMP(vm, op)                                           \
+/* Fused LT; JUMP_UNLESS on two operands already read from the frame.
+ * Leaves the comparison result on the stack like the unfused pair. */
+#define LT_JUMP_UNLESS_NAN(vm, frame, lhs, rhs)                         \
     do {                                                                \
-        Value *b = vm_pop(vm);                                          \
-        Value *a = vm_pop(vm);                                          \
-        if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;                  \
-        if (value_is_int(a) && value_is_int(b)) {                       \
-            vm_push(vm, value_bool(a->as.integer op b->as.integer));    \
-        } else if ((value_is_int(a) || value_is_float(a)) &&            \
-                   (value_is_int(b) || value_is_float(b))) {            \
-            double da = value_to_float(a);                              \
-            double db = value_to_float(b);                              \
-            vm_push(vm, value_bool(da op db));                          \
-        } else if (value_is_string(a) && value_is_string(b)) {          \
-            int cmp = string_compare(a, b);                             \
-            vm_push(vm, value_bool(cmp op 0));                          \
+        uint16_t jump = read_short(frame);                              \
+        if (nanbox_is_int(lhs) && nanbox_is_int(rhs)) {                 \
+            vm_push_nan(vm, nanbox_bool(nanbox_as_int(lhs) <            \
+                                        nanbox_as_int(rhs)));           \
         } else {                                                        \
-            vm_set_error(vm, "cannot compare these types");             \
-            return VM_ERROR_TYPE;                                       \
+            vm_push_nan(vm, lhs);                                       \
+            vm_push_nan(vm, rhs);                                       \
+            BINARY_OP_CMP_NAN(vm, <);                                   \
+        }                                                               \
+        if (!nanbox_is_truthy(vm_peek_nan(vm, 0))) {                    \
+            if (!check_jump_forward(frame, jump)) {                     \
+                vm_set_error(vm, "jump out of bounds");                 \
+                return VM_ERROR_RUNTIME;                                \
+            }                                                           \
+            frame->ip += jump;                                          \
         }                                                               \
     } while (0)
 
+/* Tail Calls */
+
+/**
+ * Call the function below the top `arg_count` values in place of the
+ * running function. The callee and its arguments slide down over the
+ * frame's slots and the frame is reused, so a function that ends by
+ * returning another call runs in constant frame and stack space.
+ */
+static VMResult vm_tail_call(VM *vm, CallFrame *frame, uint16_t arg_count) {
+    NanValue callee = vm_peek_nan(vm, arg_count);
+    Function *fn = NULL;
+
+    if (nanbox_is_obj(callee)) {
+        Value *callee_val = (Value *)nanbox_as_obj(callee);
+        if (callee_val && callee_val->type == VAL_FUNCTION) {
+            fn = callee_val->as.function;
+        } else if (callee_val && callee_val->type == VAL_CLOSURE) {
+            fn = closure_function(callee_val);
+        }
+    }
+
+    if (!fn) {
+        vm_set_error(vm, "can only call functions");
+        return VM_ERROR_TYPE;
+    }
+    if (arg_count != fn->arity) {
+        vm_set_error(vm, "wrong number of arguments");
+        return VM_ERROR_ARITY;
+    }
+    if (fn->code_offset >= vm->code->functions_count) {
+        vm_set_error(vm, "invalid function");
+        return VM_ERROR_TYPE;
+    }
+
+    close_upvalues(vm, frame->slots);
+
+    NanValue *callee_slot = vm->stack_top - arg_count - 1;
+    memmove(frame->slots, callee_slot, sizeof(NanValue) * ((size_t)arg_count + 1));
+    vm->stack_top = frame->slots + arg_count + 1;
+
+    frame->function = fn;
+    frame->chunk = vm->code->functions[fn->code_offset];
+    frame->ip = frame->chunk->code;
+    return VM_OK;
+}
+
+/* Inline Cached Field Access */
+
+/**
+ * Pop a map or struct and push its `key_idx` field, going through the
+ * chunk's inline cache slot `ic_slot` for maps.
+ */
+static VMResult map_get_ic(VM *vm, CallFrame *frame, uint16_t key_idx, uint16_t ic_slot) {
+    Value map_scratch;
+    Value *map = vm_pop_borrow(vm, &map_scratch);
+
+    if (!map) {
+        vm_set_error(vm, "expected map or struct");
+        return VM_ERROR_TYPE;
+    }
+
+    /* Handle struct field access */
+    if (value_is_struct(map)) {
+        const char *key = bytecode_get_string(vm->code, key_idx);
+        if (!key) {
+            vm_set_error(vm, "invalid string index");
+            return VM_ERROR_TYPE;
+        }
+        vm_push(vm, value_struct_get_field(map, key));
+        return VM_OK;
+    }
+
+    if (!value_is_map(map)) {
+        vm_set_error(vm, "expected map or struct");
+        return VM_ERROR_TYPE;
+    }
+
+    const char *key = bytecode_get_string(vm->code, key_idx);
+    if (!key) {
+        vm_set_error(vm, "invalid string index");
+        return VM_ERROR_TYPE;
+    }
+
+    /* Get the IC slot */
+    Chunk *chunk = frame->chunk;
+    if (!chunk || ic_slot >= chunk->ic_count) {
+        /* No IC available, fall back to normal lookup */
+        vm_push(vm, map_get(map, key));
+        return VM_OK;
+    }
+
+    InlineCache *ic = &chunk->ic_slots[ic_slot];
+    Value *result = NULL;
+
+    /* Try cache lookup first */
+    if (ic_lookup(ic, map, key, &result)) {
+        /* Cache hit - fast path */
+        vm_push(vm, result);
+        return VM_OK;
+    }
+
+    /* Cache miss - do normal lookup and update cache */
+    Map *m = map->as.map;
+    size_t key_len = strlen(key);
+    size_t key_hash = agim_hash_string(key, key_len);
+    size_t bucket = key_hash % m->capacity;
+
+    result = map_get(map, key);
+    if (result) {
+        /* Update cache with successful lookup */
+        ic_update(ic, map, bucket);
+    }
+
+    vm_push(vm, result);
+    return VM_OK;
+}
+
 /* Computed Goto Dispatch */
 
 #if defined(__GNUC__) && !defined(AGIM_NO_COMPUTED_GOTO)
@@ -503,6 +671,104 @@ static inline bool check_jump_backward(CallFrame *frame, uint16_t offset) {
 
 /* Main Execution Loop */
 
+/* Globals */
+
+/*
+ * Size the global slots for `code`. Reloading the same code keeps the
+ * values (the register VM reloads its stub code on every call); other
+ * code starts with every slot unset.
+ */
+static bool vm_bind_globals(VM *vm, Bytecode *code) {
+    size_t count = code->globals_count;
+    size_t keep = (code == vm->code && vm->globals_count <= count) ? vm->globals_count : 0;
+
+    /* Drop the values in every slot that is cleared or cut off below */
+    for (size_t i = keep; i < vm->globals_count; i++) {
+        if (nanbox_is_obj(vm->globals[i])) {
+            value_free((Value *)nanbox_as_obj(vm->globals[i]));
+        }
+        vm->globals[i] = NANBOX_EMPTY;
+    }
+
+    if (count != vm->globals_count) {
+        NanValue *slots = realloc(vm->globals, sizeof(NanValue) * (count ? count : 1));
+        if (!slots) {
+            LOG_ERROR("vm: globals allocation failed (%zu slots)", count);
+            return false;
+        }
+        vm->globals = slots;
+    }
+
+    for (size_t i = keep; i < count; i++) {
+        vm->globals[i] = NANBOX_EMPTY;
+    }
+    vm->globals_count = count;
+    return true;
+}
+
+/* Set each global the loaded code declares from a name-keyed map */
+static void vm_apply_globals(VM *vm, Value *state) {
+    Map *map = state->as.map;
+    for (size_t i = 0; i < map->capacity; i++) {
+        for (MapEntry *entry = map->buckets[i]; entry; entry = entry->next) {
+            size_t slot;
+            if (!bytecode_find_global(vm->code, entry->key->data, &slot)) continue;
+            NanValue v = value_to_nanbox(entry->value);
+            if (nanbox_is_obj(v)) {
+                value_retain(entry->value);
+            }
+            if (nanbox_is_obj(vm->globals[slot])) {
+                value_free((Value *)nanbox_as_obj(vm->globals[slot]));
+            }
+            vm->globals[slot] = v;
+        }
+    }
+}
+
+Value *vm_globals_snapshot(VM *vm) {
+    if (!vm->code) {
+        return vm->pending_globals ? value_copy(vm->pending_globals) : value_map();
+    }
+
+    Value *state = value_map_with_capacity(vm->globals_count * 2 + 1);
+    for (size_t i = 0; i < vm->globals_count; i++) {
+        NanValue v = vm->globals[i];
+        if (v == NANBOX_EMPTY) continue;
+        if (nanbox_is_obj(v)) {
+            value_retain((Value *)nanbox_as_obj(v));
+        }
+        state = map_set(state, vm->code->globals[i], nanbox_to_value(v));
+    }
+    return state;
+}
+
+void vm_restore_globals(VM *vm, Value *state) {
+    if (!state) return;
+    if (state->type != VAL_MAP) {
+        value_free(state);
+        return;
+    }
+
+    /* Nothing to lay the names out against yet; vm_load applies it */
+    if (!vm->code) {
+        value_free(vm->pending_globals);
+        vm->pending_globals = state;
+        return;
+    }
+
+    vm_apply_globals(vm, state);
+    value_free(state);
+}
+
+Value *vm_get_global(VM *vm, const char *name) {
+    size_t slot;
+    if (!vm->code || !bytecode_find_global(vm->code, name, &slot) ||
+        slot >= vm->globals_count || vm->globals[slot] == NANBOX_EMPTY) {
+        return NULL;
+    }
+    return nanbox_to_value(vm->globals[slot]);
+}
+
 void vm_load(VM *vm, Bytecode *code) {
     /* Ensure lazy initialization before accessing stack/frames */
     if (!vm_ensure_initialized(vm)) {
@@ -510,9 +776,17 @@ void vm_load(VM *vm, Bytecode *code) {
         return;
     }
 
+    if (!vm_bind_globals(vm, code)) return;
+
     vm_reset(vm);
     vm->code = code;
 
+    if (vm->pending_globals) {
+        vm_apply_globals(vm, vm->pending_globals);
+        value_free(vm->pending_globals);
+        vm->pending_globals = NULL;
+    }
+
     /* Set up initial frame */
     CallFrame *frame = &vm->frames[vm->frame_count++];
     frame->chunk = code->main;
@@ -568,12 +842,25 @@ VMResult vm_run(VM *vm) {
         [OP_MAP_GET_IC] = &&op_map_get_ic,
         [OP_CONCAT] = &&op_slow, [OP_SPAWN] = &&op_slow, [OP_SEND] = &&op_slow,
         [OP_RECEIVE] = &&op_slow, [OP_SELF] = &&op_slow, [OP_YIELD] = &&op_slow,
+        [OP_RECEIVE_TIMEOUT] = &&op_slow, [OP_RECEIVE_MATCH] = &&op_slow,
+        [OP_RECEIVE_MANY] = &&op_slow,
+        [OP_LINK] = &&op_slow, [OP_UNLINK] = &&op_slow,
+        [OP_MONITOR] = &&op_slow, [OP_DEMONITOR] = &&op_slow,
+        [OP_SUP_START] = &&op_slow, [OP_SUP_ADD_CHILD] = &&op_slow,
+        [OP_SUP_REMOVE_CHILD] = &&op_slow, [OP_SUP_WHICH_CHILDREN] = &&op_slow,
+        [OP_SUP_SHUTDOWN] = &&op_slow,
+        [OP_GROUP_JOIN] = &&op_slow, [OP_GROUP_LEAVE] = &&op_slow,
+        [OP_GROUP_SEND] = &&op_slow, [OP_GROUP_SEND_OTHERS] = &&op_slow,
+        [OP_GROUP_MEMBERS] = &&op_slow, [OP_GROUP_LIST] = &&op_slow,
+        [OP_GET_STATS] = &&op_slow, [OP_TRACE] = &&op_slow,
+        [OP_TRACE_OFF] = &&op_slow,
         [OP_INFER] = &&op_slow, [OP_TOOL_CALL] = &&op_slow,
         [OP_MEMORY_GET] = &&op_slow, [OP_MEMORY_SET] = &&op_slow,
         [OP_LEN] = &&op_slow, [OP_TYPE] = &&op_slow, [OP_KEYS] = &&op_slow,
         [OP_PUSH] = &&op_slow, [OP_POP_ARRAY] = &&op_slow,
         [OP_SLICE] = &&op_slow, [OP_TO_STRING] = &&op_slow,
         [OP_TO_INT] = &&op_slow, [OP_TO_FLOAT] = &&op_slow,
+        [OP_FREEZE] = &&op_slow,
         [OP_FILE_READ] = &&op_slow, [OP_FILE_WRITE] = &&op_slow,
         [OP_FILE_EXISTS] = &&op_slow, [OP_FILE_LINES] = &&op_slow,
         [OP_FILE_WRITE_BYTES] = &&op_slow,
@@ -617,6 +904,18 @@ VMResult vm_run(VM *vm) {
         /* Enum operations */
         [OP_ENUM_NEW] = &&op_slow, [OP_ENUM_IS] = &&op_slow,
         [OP_ENUM_PAYLOAD] = &&op_slow,
+        /* Superinstructions */
+        [OP_ADD_LOCAL_LOCAL] = &&op_add_local_local,
+        [OP_INC_LOCAL] = &&op_inc_local,
+        [OP_GET_LOCAL_MAP_GET_IC] = &&op_get_local_map_get_ic,
+        [OP_LT_LOCAL_CONST_JUMP_UNLESS] = &&op_lt_local_const_jump_unless,
+        [OP_LT_LOCAL_LOCAL_JUMP_UNLESS] = &&op_lt_local_local_jump_unless,
+        /* Typed arithmetic */
+        [OP_ADD_INT] = &&op_add_int, [OP_SUB_INT] = &&op_sub_int,
+        [OP_MUL_INT] = &&op_mul_int, [OP_ADD_FLOAT] = &&op_add_float,
+        [OP_SUB_FLOAT] = &&op_sub_float, [OP_MUL_FLOAT] = &&op_mul_float,
+        [OP_DIV_FLOAT] = &&op_div_float,
+        [OP_TAIL_CALL] = &&op_tail_call,
     };
 
     /* Dispatch macro: batched reduction check every REDUCTION_BATCH instructions */
@@ -830,22 +1129,22 @@ VMResult vm_run(VM *vm) {
     }
 
     TARGET(get_global): {
-        uint16_t index = read_short(frame);
-        const char *name = bytecode_get_string(vm->code, index);
-        Value *value = map_get(vm->globals, name);
-        if (!value) {
+        uint16_t slot = read_short(frame);
+        if (slot >= vm->globals_count || vm->globals[slot] == NANBOX_EMPTY) {
             vm_set_error(vm, "undefined variable");
             return VM_ERROR_UNDEFINED_VARIABLE;
         }
-        vm_push_nan(vm, value_to_nanbox(value));
+        vm_push_nan(vm, vm->globals[slot]);
         DISPATCH();
     }
 
     TARGET(set_global): {
-        uint16_t index = read_short(frame);
-        const char *name = bytecode_get_string(vm->code, index);
-        NanValue v = vm_peek_nan(vm, 0);
-        map_set(vm->globals, name, nanbox_to_value(v));
+        uint16_t slot = read_short(frame);
+        if (slot >= vm->globals_count) {
+            vm_set_error(vm, "global slot out of range");
+            return VM_ERROR_RUNTIME;
+        }
+        vm->globals[slot] = vm_peek_nan(vm, 0);
         DISPATCH();
     }
 
@@ -924,6 +1223,10 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_STACK_OVERFLOW;
             }
         }
+        if (fn->code_offset >= vm->code->functions_count) {
+            vm_set_error(vm, "invalid function");
+            return VM_ERROR_TYPE;
+        }
         CallFrame *new_frame = &vm->frames[vm->frame_count++];
         new_frame->function = fn;
         new_frame->chunk = vm->code->functions[fn->code_offset];
@@ -933,6 +1236,12 @@ VMResult vm_run(VM *vm) {
         DISPATCH();
     }
 
+    TARGET(tail_call): {
+        VMResult result = vm_tail_call(vm, frame, read_short(frame));
+        if (result != VM_OK) return result;
+        DISPATCH();
+    }
+
     TARGET(return): {
         NanValue result = vm_pop_nan(vm);
         close_upvalues(vm, frame->slots);
@@ -954,72 +1263,92 @@ VMResult vm_run(VM *vm) {
     TARGET(map_get_ic): {
         uint16_t key_idx = read_short(frame);
         uint16_t ic_slot = read_short(frame);
+        VMResult result = map_get_ic(vm, frame, key_idx, ic_slot);
+        if (result != VM_OK) return result;
+        DISPATCH();
+    }
 
-        NanValue map_val = vm_pop_nan(vm);
-        Value *map = nanbox_to_value(map_val);
-
-        if (!map) {
-            vm_set_error(vm, "expected map or struct");
-            return VM_ERROR_TYPE;
-        }
-
-        /* Handle struct field access */
-        if (value_is_struct(map)) {
-            const char *key = bytecode_get_string(vm->code, key_idx);
-            if (!key) {
-                vm_set_error(vm, "invalid string index");
-                return VM_ERROR_TYPE;
-            }
-            Value *result = value_struct_get_field(map, key);
-            vm_push(vm, result ? result : value_nil());
+    /* Superinstructions: each runs its unfused sequence in one dispatch */
+    TARGET(add_local_local): {
+        NanValue lhs = frame->slots[read_short(frame)];
+        NanValue rhs = frame->slots[read_short(frame)];
+        if (nanbox_is_int(lhs) && nanbox_is_int(rhs)) {
+            vm_push_nan(vm, nanbox_int(nanbox_as_int(lhs) + nanbox_as_int(rhs)));
             DISPATCH();
         }
+        vm_push_nan(vm, lhs);
+        vm_push_nan(vm, rhs);
+        goto TARGET(add);
+    }
 
-        if (!value_is_map(map)) {
-            vm_set_error(vm, "expected map or struct");
+    TARGET(inc_local): {
+        uint16_t slot = read_short(frame);
+        NanValue v = frame->slots[slot];
+        if (nanbox_is_int(v)) {
+            v = nanbox_int(nanbox_as_int(v) + 1);
+        } else if (nanbox_is_number(v)) {
+            v = nanbox_double(nanbox_to_float(v) + 1.0);
+        } else {
+            vm_set_error(vm, "operands must be numbers");
             return VM_ERROR_TYPE;
         }
+        frame->slots[slot] = v;
+        vm_push_nan(vm, v);
+        DISPATCH();
+    }
 
-        const char *key = bytecode_get_string(vm->code, key_idx);
-        if (!key) {
-            vm_set_error(vm, "invalid string index");
-            return VM_ERROR_TYPE;
-        }
+    TARGET(get_local_map_get_ic): {
+        uint16_t slot = read_short(frame);
+        vm_push_nan(vm, frame->slots[slot]);
+        goto TARGET(map_get_ic);
+    }
 
-        /* Get the IC slot */
-        Chunk *chunk = frame->chunk;
-        if (!chunk || ic_slot >= chunk->ic_count) {
-            /* No IC available, fall back to normal lookup */
-            Value *result = map_get(map, key);
-            vm_push(vm, result ? result : value_nil());
-            DISPATCH();
-        }
+    TARGET(lt_local_const_jump_unless): {
+        NanValue lhs = frame->slots[read_short(frame)];
+        NanValue rhs = read_constant_nan(frame);
+        LT_JUMP_UNLESS_NAN(vm, frame, lhs, rhs);
+        DISPATCH();
+    }
 
-        InlineCache *ic = &chunk->ic_slots[ic_slot];
-        Value *result = NULL;
+    TARGET(lt_local_local_jump_unless): {
+        NanValue lhs = frame->slots[read_short(frame)];
+        NanValue rhs = frame->slots[read_short(frame)];
+        LT_JUMP_UNLESS_NAN(vm, frame, lhs, rhs);
+        DISPATCH();
+    }
 
-        /* Try cache lookup first */
-        if (ic_lookup(ic, map, key, &result)) {
-            /* Cache hit - fast path */
-            vm_push(vm, result ? result : value_nil());
-            DISPATCH();
-        }
+    TARGET(add_int):
+        TYPED_OP_NAN(vm, nanbox_is_int, nanbox_as_int, nanbox_int, +, TARGET(add));
+        DISPATCH();
 
-        /* Cache miss - do normal lookup and update cache */
-        Map *m = map->as.map;
-        size_t key_len = strlen(key);
-        size_t key_hash = agim_hash_string(key, key_len);
-        size_t bucket = key_hash % m->capacity;
+    TARGET(sub_int):
+        TYPED_OP_NAN(vm, nanbox_is_int, nanbox_as_int, nanbox_int, -, TARGET(sub));
+        DISPATCH();
 
-        result = map_get(map, key);
-        if (result) {
-            /* Update cache with successful lookup */
-            ic_update(ic, map, bucket);
-        }
+    TARGET(mul_int):
+        TYPED_OP_NAN(vm, nanbox_is_int, nanbox_as_int, nanbox_int, *, TARGET(mul));
+        DISPATCH();
 
-        vm_push(vm, result ? result : value_nil());
+    TARGET(add_float):
+        TYPED_OP_NAN(vm, nanbox_is_double, nanbox_as_double, nanbox_double, +, TARGET(add));
+        DISPATCH();
+
+    TARGET(sub_float):
+        TYPED_OP_NAN(vm, nanbox_is_double, nanbox_as_double, nanbox_double, -, TARGET(sub));
+        DISPATCH();
+
+    TARGET(mul_float):
+        TYPED_OP_NAN(vm, nanbox_is_double, nanbox_as_double, nanbox_double, *, TARGET(mul));
+        DISPATCH();
+
+    TARGET(div_float):
+        /* A zero divisor takes the generic path, which reports it */
+        if (nanbox_is_double(vm_peek_nan(vm, 0)) &&
+            nanbox_as_double(vm_peek_nan(vm, 0)) == 0.0) {
+            goto TARGET(div);
+        }
+        TYPED_OP_NAN(vm, nanbox_is_double, nanbox_as_double, nanbox_double, /, TARGET(div));
         DISPATCH();
-    }
 
     /* Fallback for cold opcodes - rewind IP and use switch */
     op_slow:
@@ -1075,7 +1404,7 @@ VMResult vm_run(VM *vm) {
             break;
 
         case OP_POP:
-            vm_pop(vm);
+            vm_pop_nan(vm);
             break;
 
         case OP_DUP: {
@@ -1084,8 +1413,7 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "stack underflow");
                 return VM_ERROR_STACK_UNDERFLOW;
             }
-            Value *top = vm_peek(vm, 0);
-            vm_push(vm, top);
+            vm_push_nan(vm, vm_peek_nan(vm, 0));
             break;
         }
 
@@ -1096,10 +1424,10 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "stack underflow");
                 return VM_ERROR_STACK_UNDERFLOW;
             }
-            Value *b = vm_peek(vm, 0);
-            Value *a = vm_peek(vm, 1);
-            vm_push(vm, a);
-            vm_push(vm, b);
+            NanValue b = vm_peek_nan(vm, 0);
+            NanValue a = vm_peek_nan(vm, 1);
+            vm_push_nan(vm, a);
+            vm_push_nan(vm, b);
             break;
         }
 
@@ -1109,96 +1437,105 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "stack underflow");
                 return VM_ERROR_STACK_UNDERFLOW;
             }
-            Value *a = vm_pop(vm);
-            Value *b = vm_pop(vm);
-            vm_push(vm, a);
-            vm_push(vm, b);
+            NanValue a = vm_pop_nan(vm);
+            NanValue b = vm_pop_nan(vm);
+            vm_push_nan(vm, a);
+            vm_push_nan(vm, b);
             break;
         }
 
-        case OP_CONST: {
-            Value *constant = read_constant(frame);
-            vm_push(vm, value_copy(constant));
+        case OP_CONST:
+            vm_push_nan(vm, read_constant_nan(frame));
             break;
-        }
 
         case OP_NIL:
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
 
         case OP_TRUE:
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, NANBOX_TRUE);
             break;
 
         case OP_FALSE:
-            vm_push(vm, value_bool(false));
+            vm_push_nan(vm, NANBOX_FALSE);
             break;
 
+        case OP_ADD_LOCAL_LOCAL: {
+            NanValue lhs = frame->slots[read_short(frame)];
+            NanValue rhs = frame->slots[read_short(frame)];
+            vm_push_nan(vm, lhs);
+            vm_push_nan(vm, rhs);
+        }
+        /* fall through */
+        case OP_ADD_INT:
+        case OP_ADD_FLOAT:
         case OP_ADD: {
-            Value *b = vm_peek(vm, 0);
-            Value *a = vm_peek(vm, 1);
-            if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
-
+            NanValue b = vm_peek_nan(vm, 0);
+            NanValue a = vm_peek_nan(vm, 1);
             /* String concatenation - handle nil as empty string */
-            bool a_str = value_is_string(a) || value_is_nil(a);
-            bool b_str = value_is_string(b) || value_is_nil(b);
+            bool a_str = nanbox_is_nil(a) || (nanbox_is_obj(a) && value_is_string((Value *)nanbox_as_obj(a)));
+            bool b_str = nanbox_is_nil(b) || (nanbox_is_obj(b) && value_is_string((Value *)nanbox_as_obj(b)));
             if (a_str && b_str) {
-                vm_pop(vm);
-                vm_pop(vm);
-                Value *str_a = value_is_nil(a) ? value_string("") : a;
-                Value *str_b = value_is_nil(b) ? value_string("") : b;
+                vm_pop_nan(vm);
+                vm_pop_nan(vm);
+                Value *str_a = nanbox_is_nil(a) ? value_string("") : (Value *)nanbox_as_obj(a);
+                Value *str_b = nanbox_is_nil(b) ? value_string("") : (Value *)nanbox_as_obj(b);
                 vm_push(vm, string_concat(str_a, str_b));
             } else {
-                BINARY_OP_NUM(vm, +);
+                BINARY_OP_NUM_NAN(vm, +);
             }
             break;
         }
 
+        case OP_SUB_INT:
+        case OP_SUB_FLOAT:
         case OP_SUB:
-            BINARY_OP_NUM(vm, -);
+            BINARY_OP_NUM_NAN(vm, -);
             break;
 
+        case OP_MUL_INT:
+        case OP_MUL_FLOAT:
         case OP_MUL:
-            BINARY_OP_NUM(vm, *);
+            BINARY_OP_NUM_NAN(vm, *);
             break;
 
+        case OP_DIV_FLOAT:
         case OP_DIV: {
-            Value *b = vm_peek(vm, 0);
-            if (value_is_int(b) && b->as.integer == 0) {
+            NanValue b = vm_peek_nan(vm, 0);
+            if (nanbox_is_int(b) && nanbox_as_int(b) == 0) {
                 vm_set_error(vm, "division by zero");
                 return VM_ERROR_DIVISION_BY_ZERO;
             }
-            if (value_is_float(b) && b->as.floating == 0.0) {
+            if (nanbox_is_double(b) && nanbox_as_double(b) == 0.0) {
                 vm_set_error(vm, "division by zero");
                 return VM_ERROR_DIVISION_BY_ZERO;
             }
-            BINARY_OP_NUM(vm, /);
+            BINARY_OP_NUM_NAN(vm, /);
             break;
         }
 
         case OP_MOD: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
-            if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
-            if (!value_is_int(a) || !value_is_int(b)) {
+            NanValue b = vm_pop_nan(vm);
+            NanValue a = vm_pop_nan(vm);
+            if (!nanbox_is_int(a) || !nanbox_is_int(b)) {
                 vm_set_error(vm, "modulo requires integers");
                 return VM_ERROR_TYPE;
             }
-            if (b->as.integer == 0) {
+            int64_t ib = nanbox_as_int(b);
+            if (ib == 0) {
                 vm_set_error(vm, "division by zero");
                 return VM_ERROR_DIVISION_BY_ZERO;
             }
-            vm_push(vm, value_int(a->as.integer % b->as.integer));
+            vm_push_nan(vm, nanbox_int(nanbox_as_int(a) % ib));
             break;
         }
 
         case OP_NEG: {
-            Value *v = vm_pop(vm);
-            if (!v) return VM_ERROR_STACK_UNDERFLOW;
-            if (value_is_int(v)) {
-                vm_push(vm, value_int(-v->as.integer));
-            } else if (value_is_float(v)) {
-                vm_push(vm, value_float(-v->as.floating));
+            NanValue v = vm_pop_nan(vm);
+            if (nanbox_is_int(v)) {
+                vm_push_nan(vm, nanbox_int(-nanbox_as_int(v)));
+            } else if (nanbox_is_double(v)) {
+                vm_push_nan(vm, nanbox_double(-nanbox_as_double(v)));
             } else {
                 vm_set_error(vm, "operand must be a number");
                 return VM_ERROR_TYPE;
@@ -1207,43 +1544,48 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_EQ: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
-            if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
-            vm_push(vm, value_bool(value_equals(a, b)));
+            NanValue b = vm_pop_nan(vm);
+            NanValue a = vm_pop_nan(vm);
+            if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
+                vm_push_nan(vm, nanbox_bool(value_equals((Value *)nanbox_as_obj(a),
+                                                         (Value *)nanbox_as_obj(b))));
+            } else {
+                vm_push_nan(vm, nanbox_bool(nanbox_equal(a, b)));
+            }
             break;
         }
 
         case OP_NE: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
-            if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
-            vm_push(vm, value_bool(!value_equals(a, b)));
+            NanValue b = vm_pop_nan(vm);
+            NanValue a = vm_pop_nan(vm);
+            if (nanbox_is_obj(a) && nanbox_is_obj(b)) {
+                vm_push_nan(vm, nanbox_bool(!value_equals((Value *)nanbox_as_obj(a),
+                                                          (Value *)nanbox_as_obj(b))));
+            } else {
+                vm_push_nan(vm, nanbox_bool(!nanbox_equal(a, b)));
+            }
             break;
         }
 
         case OP_LT:
-            BINARY_OP_CMP(vm, <);
+            BINARY_OP_CMP_NAN(vm, <);
             break;
 
         case OP_LE:
-            BINARY_OP_CMP(vm, <=);
+            BINARY_OP_CMP_NAN(vm, <=);
             break;
 
         case OP_GT:
-            BINARY_OP_CMP(vm, >);
+            BINARY_OP_CMP_NAN(vm, >);
             break;
 
         case OP_GE:
-            BINARY_OP_CMP(vm, >=);
+            BINARY_OP_CMP_NAN(vm, >=);
             break;
 
-        case OP_NOT: {
-            Value *v = vm_pop(vm);
-            if (!v) return VM_ERROR_STACK_UNDERFLOW;
-            vm_push(vm, value_bool(!value_is_truthy(v)));
+        case OP_NOT:
+            vm_push_nan(vm, nanbox_bool(!nanbox_is_truthy(vm_pop_nan(vm))));
             break;
-        }
 
         case OP_GET_LOCAL: {
             uint16_t slot = read_short(frame);
@@ -1257,22 +1599,39 @@ VMResult vm_run(VM *vm) {
             break;
         }
 
+        case OP_INC_LOCAL: {
+            uint16_t slot = read_short(frame);
+            NanValue v = frame->slots[slot];
+            if (nanbox_is_int(v)) {
+                v = nanbox_int(nanbox_as_int(v) + 1);
+            } else if (nanbox_is_number(v)) {
+                v = nanbox_double(nanbox_to_float(v) + 1.0);
+            } else {
+                vm_set_error(vm, "operands must be numbers");
+                return VM_ERROR_TYPE;
+            }
+            frame->slots[slot] = v;
+            vm_push_nan(vm, v);
+            break;
+        }
+
         case OP_GET_GLOBAL: {
-            uint16_t index = read_short(frame);
-            const char *name = bytecode_get_string(vm->code, index);
-            Value *value = map_get(vm->globals, name);
-            if (!value) {
+            uint16_t slot = read_short(frame);
+            if (slot >= vm->globals_count || vm->globals[slot] == NANBOX_EMPTY) {
                 vm_set_error(vm, "undefined variable");
                 return VM_ERROR_UNDEFINED_VARIABLE;
             }
-            vm_push(vm, value);
+            vm_push_nan(vm, vm->globals[slot]);
             break;
         }
 
         case OP_SET_GLOBAL: {
-            uint16_t index = read_short(frame);
-            const char *name = bytecode_get_string(vm->code, index);
-            map_set(vm->globals, name, vm_peek(vm, 0));
+            uint16_t slot = read_short(frame);
+            if (slot >= vm->globals_count) {
+                vm_set_error(vm, "global slot out of range");
+                return VM_ERROR_RUNTIME;
+            }
+            vm->globals[slot] = vm_peek_nan(vm, 0);
             break;
         }
 
@@ -1288,7 +1647,7 @@ VMResult vm_run(VM *vm) {
 
         case OP_JUMP_IF: {
             uint16_t offset = read_short(frame);
-            if (value_is_truthy(vm_peek(vm, 0))) {
+            if (nanbox_is_truthy(vm_peek_nan(vm, 0))) {
                 if (!check_jump_forward(frame, offset)) {
                     vm_set_error(vm, "jump out of bounds");
                     return VM_ERROR_RUNTIME;
@@ -1300,7 +1659,7 @@ VMResult vm_run(VM *vm) {
 
         case OP_JUMP_UNLESS: {
             uint16_t offset = read_short(frame);
-            if (!value_is_truthy(vm_peek(vm, 0))) {
+            if (!nanbox_is_truthy(vm_peek_nan(vm, 0))) {
                 if (!check_jump_forward(frame, offset)) {
                     vm_set_error(vm, "jump out of bounds");
                     return VM_ERROR_RUNTIME;
@@ -1310,6 +1669,20 @@ VMResult vm_run(VM *vm) {
             break;
         }
 
+        case OP_LT_LOCAL_CONST_JUMP_UNLESS: {
+            NanValue lhs = frame->slots[read_short(frame)];
+            NanValue rhs = read_constant_nan(frame);
+            LT_JUMP_UNLESS_NAN(vm, frame, lhs, rhs);
+            break;
+        }
+
+        case OP_LT_LOCAL_LOCAL_JUMP_UNLESS: {
+            NanValue lhs = frame->slots[read_short(frame)];
+            NanValue rhs = frame->slots[read_short(frame)];
+            LT_JUMP_UNLESS_NAN(vm, frame, lhs, rhs);
+            break;
+        }
+
         case OP_LOOP: {
             uint16_t offset = read_short(frame);
             if (!check_jump_backward(frame, offset)) {
@@ -1322,7 +1695,8 @@ VMResult vm_run(VM *vm) {
 
         case OP_CALL: {
             uint16_t arg_count = read_short(frame);
-            Value *callee = vm_peek(vm, arg_count);
+            Value callee_scratch;
+            Value *callee = vm_peek_borrow(vm, arg_count, &callee_scratch);
 
             Function *fn = NULL;
 
@@ -1353,6 +1727,11 @@ VMResult vm_run(VM *vm) {
                 }
             }
 
+            if (fn->code_offset >= vm->code->functions_count) {
+                vm_set_error(vm, "invalid function");
+                return VM_ERROR_TYPE;
+            }
+
             CallFrame *new_frame = &vm->frames[vm->frame_count++];
             new_frame->function = fn;
             new_frame->chunk = vm->code->functions[fn->code_offset];
@@ -1362,8 +1741,14 @@ VMResult vm_run(VM *vm) {
             break;
         }
 
+        case OP_TAIL_CALL: {
+            VMResult result = vm_tail_call(vm, frame, read_short(frame));
+            if (result != VM_OK) return result;
+            break;
+        }
+
         case OP_RETURN: {
-            Value *result = vm_pop(vm);
+            NanValue result = vm_pop_nan(vm);
 
             /* Close any upvalues owned by this frame */
             close_upvalues(vm, frame->slots);
@@ -1371,12 +1756,12 @@ VMResult vm_run(VM *vm) {
             vm->frame_count--;
 
             if (vm->frame_count == 0) {
-                vm_pop(vm); /* Pop the script function */
+                vm_pop_nan(vm); /* Pop the script function */
                 return VM_OK;
             }
 
             vm->stack_top = frame->slots;
-            vm_push(vm, result);
+            vm_push_nan(vm, result);
             frame = &vm->frames[vm->frame_count - 1];
             break;
         }
@@ -1440,19 +1825,22 @@ VMResult vm_run(VM *vm) {
 
         case OP_ARRAY_PUSH: {
             Value *item = vm_pop(vm);
-            Value *arr = vm_pop(vm);  /* Pop to allow COW replacement */
+            Value arr_scratch;
+            Value *arr = vm_pop_borrow(vm, &arr_scratch);  /* Pop to allow COW replacement */
             if (!arr || !value_is_array(arr)) {
                 vm_set_error(vm, "expected array");
                 return VM_ERROR_TYPE;
             }
-            arr = array_push(arr, item);  /* May return new Value if COW */
+            arr = array_push(value_write_ref(arr), item);  /* May return new Value if COW */
             vm_push(vm, arr);  /* Push back (possibly new) array */
             break;
         }
 
         case OP_ARRAY_GET: {
-            Value *index = vm_pop(vm);
-            Value *container = vm_pop(vm);
+            Value index_scratch;
+            Value *index = vm_pop_borrow(vm, &index_scratch);
+            Value container_scratch;
+            Value *container = vm_pop_borrow(vm, &container_scratch);
             if (!container) {
                 vm_set_error(vm, "expected array or map");
                 return VM_ERROR_TYPE;
@@ -1473,14 +1861,14 @@ VMResult vm_run(VM *vm) {
                     return VM_ERROR_OUT_OF_BOUNDS;
                 }
                 Value *item = array_get(container, (size_t)idx);
-                vm_push(vm, item ? item : value_nil());
+                vm_push(vm, item);
             } else if (value_is_map(container)) {
                 if (!value_is_string(index)) {
                     vm_set_error(vm, "map key must be string");
                     return VM_ERROR_TYPE;
                 }
                 Value *item = map_get(container, index->as.string->data);
-                vm_push(vm, item ? item : value_nil());
+                vm_push(vm, item);
             } else {
                 vm_set_error(vm, "expected array or map");
                 return VM_ERROR_TYPE;
@@ -1490,8 +1878,10 @@ VMResult vm_run(VM *vm) {
 
         case OP_ARRAY_SET: {
             Value *value = vm_pop(vm);
-            Value *index = vm_pop(vm);
-            Value *container = vm_pop(vm);  /* Pop to allow COW replacement */
+            Value index_scratch;
+            Value *index = vm_pop_borrow(vm, &index_scratch);
+            Value container_scratch;
+            Value *container = vm_pop_borrow(vm, &container_scratch);  /* Pop to allow COW replacement */
             if (!container) {
                 vm_set_error(vm, "expected array or map");
                 return VM_ERROR_TYPE;
@@ -1511,13 +1901,13 @@ VMResult vm_run(VM *vm) {
                     vm_set_error(vm, "array index out of bounds");
                     return VM_ERROR_OUT_OF_BOUNDS;
                 }
-                container = array_set(container, (size_t)idx, value);
+                container = array_set(value_write_ref(container), (size_t)idx, value);
             } else if (value_is_map(container)) {
                 if (!value_is_string(index)) {
                     vm_set_error(vm, "map key must be string");
                     return VM_ERROR_TYPE;
                 }
-                container = map_set(container, index->as.string->data, value);
+                container = map_set(value_write_ref(container), index->as.string->data, value);
             } else {
                 vm_set_error(vm, "expected array or map");
                 return VM_ERROR_TYPE;
@@ -1531,8 +1921,10 @@ VMResult vm_run(VM *vm) {
             break;
 
         case OP_MAP_GET: {
-            Value *key = vm_pop(vm);
-            Value *map = vm_pop(vm);
+            Value key_scratch;
+            Value *key = vm_pop_borrow(vm, &key_scratch);
+            Value map_scratch;
+            Value *map = vm_pop_borrow(vm, &map_scratch);
             if (!map || !value_is_map(map)) {
                 vm_set_error(vm, "expected map");
                 return VM_ERROR_TYPE;
@@ -1542,14 +1934,27 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_TYPE;
             }
             Value *item = map_get(map, key->as.string->data);
-            vm_push(vm, item ? item : value_nil());
+            vm_push(vm, item);
+            break;
+        }
+
+        case OP_GET_LOCAL_MAP_GET_IC:
+            vm_push_nan(vm, frame->slots[read_short(frame)]);
+            /* fall through */
+        case OP_MAP_GET_IC: {
+            uint16_t key_idx = read_short(frame);
+            uint16_t ic_slot = read_short(frame);
+            VMResult result = map_get_ic(vm, frame, key_idx, ic_slot);
+            if (result != VM_OK) return result;
             break;
         }
 
         case OP_MAP_SET: {
             Value *val = vm_pop(vm);
-            Value *key = vm_pop(vm);
-            Value *map = vm_pop(vm);  /* Pop to allow COW replacement */
+            Value key_scratch;
+            Value *key = vm_pop_borrow(vm, &key_scratch);
+            Value map_scratch;
+            Value *map = vm_pop_borrow(vm, &map_scratch);  /* Pop to allow COW replacement */
             if (!map || !value_is_map(map)) {
                 vm_set_error(vm, "expected map");
                 return VM_ERROR_TYPE;
@@ -1558,14 +1963,16 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "map key must be string");
                 return VM_ERROR_TYPE;
             }
-            map = map_set(map, key->as.string->data, val);
+            map = map_set(value_write_ref(map), key->as.string->data, val);
             vm_push(vm, map);  /* Push back (possibly new) map */
             break;
         }
 
         case OP_CONCAT: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
+            Value b_scratch;
+            Value *b = vm_pop_borrow(vm, &b_scratch);
+            Value a_scratch;
+            Value *a = vm_pop_borrow(vm, &a_scratch);
             if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_string(a) || !value_is_string(b)) {
                 vm_set_error(vm, "concat requires strings");
@@ -1576,9 +1983,10 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_LEN: {
-            Value *v = vm_peek(vm, 0);
+            Value scratch;
+            Value *v = vm_peek_borrow(vm, 0, &scratch);
             int64_t len = 0;
-            if (!v || value_is_nil(v)) {
+            if (value_is_nil(v)) {
                 len = 0;
             } else if (value_is_array(v)) {
                 len = (int64_t)v->as.array->length;
@@ -1590,13 +1998,14 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "len() requires array, string, or map");
                 return VM_ERROR_TYPE;
             }
-            vm_pop(vm);
-            vm_push(vm, value_int(len));
+            vm_pop_nan(vm);
+            vm_push_nan(vm, nanbox_int(len));
             break;
         }
 
         case OP_TYPE: {
-            Value *v = vm_pop(vm);
+            Value scratch;
+            Value *v = vm_pop_borrow(vm, &scratch);
             const char *type_name = "nil";
             if (v) {
                 switch (v->type) {
@@ -1618,7 +2027,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_KEYS: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v || !value_is_map(v)) {
                 vm_set_error(vm, "keys() requires map");
                 return VM_ERROR_TYPE;
@@ -1637,40 +2047,43 @@ VMResult vm_run(VM *vm) {
 
         case OP_PUSH: {
             Value *val = vm_pop(vm);
-            Value *arr = vm_pop(vm);
+            Value arr_scratch;
+            Value *arr = vm_pop_borrow(vm, &arr_scratch);
             if (!arr || !value_is_array(arr)) {
                 vm_set_error(vm, "push() requires array");
                 return VM_ERROR_TYPE;
             }
-            arr = array_push(arr, val);
+            arr = array_push(value_write_ref(arr), val);
             vm_push(vm, arr);  /* Push back the (possibly new) array */
             break;
         }
 
         case OP_POP_ARRAY: {
-            Value *arr = vm_pop(vm);
+            Value arr_scratch;
+            Value *arr = vm_pop_borrow(vm, &arr_scratch);
             if (!arr || !value_is_array(arr)) {
                 vm_set_error(vm, "pop() requires array");
                 return VM_ERROR_TYPE;
             }
             Value *new_arr;
-            Value *val = array_pop(arr, &new_arr);
+            Value *val = array_pop(value_write_ref(arr), &new_arr);
             /* Push both values: popped element first, then modified array on top */
-            vm_push(vm, val ? val : value_nil());
+            vm_push(vm, val);
             vm_push(vm, new_arr);
             break;
         }
 
         case OP_SLICE: {
-            Value *end_v = vm_pop(vm);
-            Value *start_v = vm_pop(vm);
-            Value *container = vm_pop(vm);
-            if (!value_is_int(start_v) || !value_is_int(end_v)) {
+            NanValue end_v = vm_pop_nan(vm);
+            NanValue start_v = vm_pop_nan(vm);
+            Value container_scratch;
+            Value *container = vm_pop_borrow(vm, &container_scratch);
+            if (!nanbox_is_int(start_v) || !nanbox_is_int(end_v)) {
                 vm_set_error(vm, "slice indices must be integers");
                 return VM_ERROR_TYPE;
             }
-            int64_t start = start_v->as.integer;
-            int64_t end = end_v->as.integer;
+            int64_t start = nanbox_as_int(start_v);
+            int64_t end = nanbox_as_int(end_v);
             if (value_is_string(container)) {
                 size_t len = strlen(container->as.string->data);
                 /* Clamp indices to valid range (no negative indexing) */
@@ -1713,7 +2126,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_TO_STRING: {
-            Value *v = vm_pop(vm);
+            Value scratch;
+            Value *v = vm_pop_borrow(vm, &scratch);
             char *str = value_repr(v);
             vm_push(vm, value_string(str));
             free(str);
@@ -1721,34 +2135,44 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_TO_INT: {
-            Value *v = vm_pop(vm);
+            NanValue v = vm_pop_nan(vm);
             int64_t result = 0;
-            if (value_is_int(v)) {
-                result = v->as.integer;
-            } else if (value_is_float(v)) {
-                result = (int64_t)v->as.floating;
-            } else if (value_is_string(v)) {
-                result = strtol(v->as.string->data, NULL, 10);
-            } else if (value_is_bool(v)) {
-                result = v->as.boolean ? 1 : 0;
+            if (nanbox_is_int(v)) {
+                result = nanbox_as_int(v);
+            } else if (nanbox_is_double(v)) {
+                result = (int64_t)nanbox_as_double(v);
+            } else if (nanbox_is_bool(v)) {
+                result = nanbox_as_bool(v) ? 1 : 0;
+            } else if (nanbox_is_obj(v) && value_is_string((Value *)nanbox_as_obj(v))) {
+                result = strtol(((Value *)nanbox_as_obj(v))->as.string->data, NULL, 10);
             }
-            vm_push(vm, value_int(result));
+            vm_push_nan(vm, nanbox_int(result));
             break;
         }
 
         case OP_TO_FLOAT: {
-            Value *v = vm_pop(vm);
+            NanValue v = vm_pop_nan(vm);
             double result = 0.0;
-            if (value_is_float(v)) {
-                result = v->as.floating;
-            } else if (value_is_int(v)) {
-                result = (double)v->as.integer;
-            } else if (value_is_string(v)) {
-                result = strtod(v->as.string->data, NULL);
-            } else if (value_is_bool(v)) {
-                result = v->as.boolean ? 1.0 : 0.0;
+            if (nanbox_is_double(v)) {
+                result = nanbox_as_double(v);
+            } else if (nanbox_is_int(v)) {
+                result = (double)nanbox_as_int(v);
+            } else if (nanbox_is_bool(v)) {
+                result = nanbox_as_bool(v) ? 1.0 : 0.0;
+            } else if (nanbox_is_obj(v) && value_is_string((Value *)nanbox_as_obj(v))) {
+                result = strtod(((Value *)nanbox_as_obj(v))->as.string->data, NULL);
+            }
+            vm_push_nan(vm, nanbox_double(result));
+            break;
+        }
+
+        case OP_FREEZE: {
+            /* Frozen in place and left on the stack; primitives already are */
+            NanValue v = vm_peek_nan(vm, 0);
+            if (nanbox_is_obj(v) && !value_freeze((Value *)nanbox_as_obj(v))) {
+                vm_set_error(vm, "freeze() cannot freeze closures, structs or enums");
+                return VM_ERROR_TYPE;
             }
-            vm_push(vm, value_float(result));
             break;
         }
 
@@ -1759,7 +2183,8 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_result_err(value_string("file read requires CAP_FILE_READ")));
                 break;
             }
-            Value *path = vm_pop(vm);
+            Value path_scratch;
+            Value *path = vm_pop_borrow(vm, &path_scratch);
             if (!value_is_string(path)) {
                 vm_set_error(vm, "file path must be string");
                 return VM_ERROR_TYPE;
@@ -1804,8 +2229,10 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_result_err(value_string("file write requires CAP_FILE_WRITE")));
                 break;
             }
-            Value *content = vm_pop(vm);
-            Value *path = vm_pop(vm);
+            Value content_scratch;
+            Value *content = vm_pop_borrow(vm, &content_scratch);
+            Value path_scratch;
+            Value *path = vm_pop_borrow(vm, &path_scratch);
             if (!value_is_string(path) || !value_is_string(content)) {
                 vm_set_error(vm, "file_write requires string path and content");
                 return VM_ERROR_TYPE;
@@ -1841,10 +2268,11 @@ VMResult vm_run(VM *vm) {
             /* Capability check: require CAP_FILE_READ */
             Block *block = (Block *)vm->block;
             if (block && !block_has_cap(block, CAP_FILE_READ)) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
-            Value *path = vm_pop(vm);
+            Value path_scratch;
+            Value *path = vm_pop_borrow(vm, &path_scratch);
             if (!value_is_string(path)) {
                 vm_set_error(vm, "file path must be string");
                 return VM_ERROR_TYPE;
@@ -1853,21 +2281,21 @@ VMResult vm_run(VM *vm) {
             Sandbox *sandbox = sandbox_global();
             if (!sandbox_check_read(sandbox, path->as.string->data)) {
                 /* Path not allowed by sandbox - return false (as if doesn't exist) */
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
             char *resolved = sandbox_resolve_read(sandbox, path->as.string->data);
             if (!resolved) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
             FILE *f = fopen(resolved, "r");
             free(resolved);
             if (f) {
                 fclose(f);
-                vm_push(vm, value_bool(true));
+                vm_push_nan(vm, nanbox_bool(true));
             } else {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
             }
             break;
         }
@@ -1879,7 +2307,8 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_result_err(value_string("file read requires CAP_FILE_READ")));
                 break;
             }
-            Value *path = vm_pop(vm);
+            Value path_scratch;
+            Value *path = vm_pop_borrow(vm, &path_scratch);
             if (!value_is_string(path)) {
                 vm_set_error(vm, "file path must be string");
                 return VM_ERROR_TYPE;
@@ -1925,8 +2354,10 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_result_err(value_string("file write requires CAP_FILE_WRITE")));
                 break;
             }
-            Value *bytes_val = vm_pop(vm);
-            Value *path = vm_pop(vm);
+            Value bytes_val_scratch;
+            Value *bytes_val = vm_pop_borrow(vm, &bytes_val_scratch);
+            Value path_scratch;
+            Value *path = vm_pop_borrow(vm, &path_scratch);
 
             if (!value_is_string(path)) {
                 vm_set_error(vm, "file path must be string");
@@ -2007,7 +2438,8 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_result_err(value_string("shell requires CAP_SHELL capability")));
                 break;
             }
-            Value *cmd_val = vm_pop(vm);
+            Value cmd_val_scratch;
+            Value *cmd_val = vm_pop_borrow(vm, &cmd_val_scratch);
             if (!cmd_val || !value_is_string(cmd_val)) {
                 vm_set_error(vm, "command must be string");
                 return VM_ERROR_TYPE;
@@ -2073,7 +2505,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_JSON_PARSE: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !value_is_string(str)) {
                 vm_set_error(vm, "json_parse requires string");
                 return VM_ERROR_TYPE;
@@ -2230,7 +2663,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_JSON_ENCODE: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             char *json = value_repr(v);
             vm_push(vm, value_string(json));
             free(json);
@@ -2243,13 +2677,18 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "env_get requires CAP_ENV capability");
                 return VM_ERROR_CAPABILITY;
             }
-            Value *name = vm_pop(vm);
+            Value name_scratch;
+            Value *name = vm_pop_borrow(vm, &name_scratch);
             if (!name || !value_is_string(name)) {
                 vm_set_error(vm, "env_get requires string");
                 return VM_ERROR_TYPE;
             }
             const char *val = getenv(name->as.string->data);
-            vm_push(vm, val ? value_string(val) : value_nil());
+            if (val) {
+                vm_push(vm, value_string(val));
+            } else {
+                vm_push_nan(vm, NANBOX_NIL);
+            }
             break;
         }
 
@@ -2259,25 +2698,58 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "env_set requires CAP_ENV capability");
                 return VM_ERROR_CAPABILITY;
             }
-            Value *val = vm_pop(vm);
-            Value *name = vm_pop(vm);
+            Value val_scratch;
+            Value *val = vm_pop_borrow(vm, &val_scratch);
+            Value name_scratch;
+            Value *name = vm_pop_borrow(vm, &name_scratch);
             if (!name || !value_is_string(name) || !val || !value_is_string(val)) {
                 vm_set_error(vm, "env_set requires two strings");
                 return VM_ERROR_TYPE;
             }
             setenv(name->as.string->data, val->as.string->data, 1);
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
         case OP_SLEEP: {
-            Value *ms = vm_pop(vm);
+            Value ms_scratch;
+            Value *ms = vm_peek_borrow(vm, 0, &ms_scratch);
             if (!ms || !value_is_int(ms)) {
                 vm_set_error(vm, "sleep requires integer milliseconds");
                 return VM_ERROR_TYPE;
             }
-            usleep((useconds_t)(ms->as.integer * 1000));
-            vm_push(vm, value_nil());
+            int64_t sleep_ms = ms->as.integer;
+            Block *block = (Block *)vm->block;
+            Scheduler *sched = (Scheduler *)vm->scheduler;
+
+            if (sleep_ms > 0 && block && sched) {
+                /*
+                 * Park the block on the timer wheel instead of stalling the
+                 * worker thread. The operand stays on the stack and the
+                 * opcode re-executes once the timer has fired; wakeups from
+                 * incoming messages simply park it again.
+                 */
+                if (atomic_exchange(&block->timeout_fired, false)) {
+                    block->pending_timer = NULL;
+                    block->timer_wheel = NULL;
+                } else {
+                    if (!block->pending_timer) {
+                        scheduler_arm_timer(sched, block, (uint64_t)sleep_ms);
+                    }
+                    if (block->pending_timer) {
+                        /* The block stays RUNNING until its worker parks it */
+                        frame->ip--;
+                        block->wait_for_mail = false;
+                        return VM_WAITING;
+                    }
+                    usleep((useconds_t)(sleep_ms * 1000));
+                }
+            } else if (sleep_ms > 0) {
+                usleep((useconds_t)(sleep_ms * 1000));
+            }
+
+            vm_pop_nan(vm);
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
@@ -2285,13 +2757,15 @@ VMResult vm_run(VM *vm) {
             struct timeval tv;
             gettimeofday(&tv, NULL);
             int64_t ms = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
-            vm_push(vm, value_int(ms));
+            vm_push_nan(vm, nanbox_int(ms));
             break;
         }
 
         case OP_TIME_FORMAT: {
-            Value *fmt = vm_pop(vm);
-            Value *ts = vm_pop(vm);
+            Value fmt_scratch;
+            Value *fmt = vm_pop_borrow(vm, &fmt_scratch);
+            Value ts_scratch;
+            Value *ts = vm_pop_borrow(vm, &ts_scratch);
             if (!ts || !value_is_int(ts) || !fmt || !value_is_string(fmt)) {
                 vm_set_error(vm, "time_format requires timestamp and format string");
                 return VM_ERROR_TYPE;
@@ -2313,13 +2787,15 @@ VMResult vm_run(VM *vm) {
             uint64_t rnd = vm_xorshift64(&vm->rng_state);
             /* Convert to double in [0.0, 1.0) range */
             double r = (double)(rnd >> 11) / (double)(1ULL << 53);
-            vm_push(vm, value_float(r));
+            vm_push_nan(vm, nanbox_double(r));
             break;
         }
 
         case OP_RANDOM_INT: {
-            Value *max = vm_pop(vm);
-            Value *min = vm_pop(vm);
+            Value max_scratch;
+            Value *max = vm_pop_borrow(vm, &max_scratch);
+            Value min_scratch;
+            Value *min = vm_pop_borrow(vm, &min_scratch);
             if (!min || !max || !value_is_int(min) || !value_is_int(max)) {
                 vm_set_error(vm, "random_int requires two integers");
                 return VM_ERROR_TYPE;
@@ -2328,13 +2804,15 @@ VMResult vm_run(VM *vm) {
             /* Use secure xorshift64 PRNG */
             uint64_t rnd = vm_xorshift64(&vm->rng_state);
             int64_t r = min->as.integer + (int64_t)(rnd % (uint64_t)range);
-            vm_push(vm, value_int(r));
+            vm_push_nan(vm, nanbox_int(r));
             break;
         }
 
         case OP_SPLIT: {
-            Value *delim = vm_pop(vm);
-            Value *str = vm_pop(vm);
+            Value delim_scratch;
+            Value *delim = vm_pop_borrow(vm, &delim_scratch);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             /* Handle nil as empty array */
             if (!str || value_is_nil(str)) {
                 vm_push(vm, value_array());
@@ -2362,8 +2840,10 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_JOIN: {
-            Value *delim = vm_pop(vm);
-            Value *arr = vm_pop(vm);
+            Value delim_scratch;
+            Value *delim = vm_pop_borrow(vm, &delim_scratch);
+            Value arr_scratch;
+            Value *arr = vm_pop_borrow(vm, &arr_scratch);
             if (!arr || !delim || !value_is_array(arr) || !value_is_string(delim)) {
                 vm_set_error(vm, "join requires array and string");
                 return VM_ERROR_TYPE;
@@ -2415,7 +2895,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_TRIM: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             /* Handle nil as empty string */
             if (!str || value_is_nil(str)) {
                 vm_push(vm, value_string(""));
@@ -2443,9 +2924,12 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_REPLACE: {
-            Value *replacement = vm_pop(vm);
-            Value *search = vm_pop(vm);
-            Value *str = vm_pop(vm);
+            Value replacement_scratch;
+            Value *replacement = vm_pop_borrow(vm, &replacement_scratch);
+            Value search_scratch;
+            Value *search = vm_pop_borrow(vm, &search_scratch);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             /* Handle nil as empty string */
             if (!str || value_is_nil(str)) {
                 vm_push(vm, value_string(""));
@@ -2501,33 +2985,39 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_CONTAINS: {
-            Value *needle = vm_pop(vm);
-            Value *haystack = vm_pop(vm);
+            Value needle_scratch;
+            Value *needle = vm_pop_borrow(vm, &needle_scratch);
+            Value haystack_scratch;
+            Value *haystack = vm_pop_borrow(vm, &haystack_scratch);
             if (!haystack || !needle || !value_is_string(haystack) || !value_is_string(needle)) {
                 vm_set_error(vm, "contains requires two strings");
                 return VM_ERROR_TYPE;
             }
-            vm_push(vm, value_bool(strstr(haystack->as.string->data,
+            vm_push_nan(vm, nanbox_bool(strstr(haystack->as.string->data,
                                           needle->as.string->data) != NULL));
             break;
         }
 
         case OP_STARTS_WITH: {
-            Value *prefix = vm_pop(vm);
-            Value *str = vm_pop(vm);
+            Value prefix_scratch;
+            Value *prefix = vm_pop_borrow(vm, &prefix_scratch);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !prefix || !value_is_string(str) || !value_is_string(prefix)) {
                 vm_set_error(vm, "starts_with requires two strings");
                 return VM_ERROR_TYPE;
             }
             size_t plen = strlen(prefix->as.string->data);
-            vm_push(vm, value_bool(strncmp(str->as.string->data,
+            vm_push_nan(vm, nanbox_bool(strncmp(str->as.string->data,
                                            prefix->as.string->data, plen) == 0));
             break;
         }
 
         case OP_ENDS_WITH: {
-            Value *suffix = vm_pop(vm);
-            Value *str = vm_pop(vm);
+            Value suffix_scratch;
+            Value *suffix = vm_pop_borrow(vm, &suffix_scratch);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !suffix || !value_is_string(str) || !value_is_string(suffix)) {
                 vm_set_error(vm, "ends_with requires two strings");
                 return VM_ERROR_TYPE;
@@ -2535,16 +3025,17 @@ VMResult vm_run(VM *vm) {
             size_t slen = strlen(str->as.string->data);
             size_t suflen = strlen(suffix->as.string->data);
             if (suflen > slen) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
             } else {
-                vm_push(vm, value_bool(strcmp(str->as.string->data + slen - suflen,
+                vm_push_nan(vm, nanbox_bool(strcmp(str->as.string->data + slen - suflen,
                                               suffix->as.string->data) == 0));
             }
             break;
         }
 
         case OP_UPPER: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             /* Handle nil as empty string */
             if (!str || value_is_nil(str)) {
                 vm_push(vm, value_string(""));
@@ -2564,7 +3055,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_LOWER: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             /* Handle nil as empty string */
             if (!str || value_is_nil(str)) {
                 vm_push(vm, value_string(""));
@@ -2584,8 +3076,10 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_CHAR_AT: {
-            Value *idx = vm_pop(vm);
-            Value *str = vm_pop(vm);
+            Value idx_scratch;
+            Value *idx = vm_pop_borrow(vm, &idx_scratch);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !idx || !value_is_string(str) || !value_is_int(idx)) {
                 vm_set_error(vm, "char_at requires string and integer");
                 return VM_ERROR_TYPE;
@@ -2602,23 +3096,26 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_INDEX_OF: {
-            Value *needle = vm_pop(vm);
-            Value *haystack = vm_pop(vm);
+            Value needle_scratch;
+            Value *needle = vm_pop_borrow(vm, &needle_scratch);
+            Value haystack_scratch;
+            Value *haystack = vm_pop_borrow(vm, &haystack_scratch);
             if (!haystack || !needle || !value_is_string(haystack) || !value_is_string(needle)) {
                 vm_set_error(vm, "index_of requires two strings");
                 return VM_ERROR_TYPE;
             }
             const char *found = strstr(haystack->as.string->data, needle->as.string->data);
             if (found) {
-                vm_push(vm, value_int(found - haystack->as.string->data));
+                vm_push_nan(vm, nanbox_int(found - haystack->as.string->data));
             } else {
-                vm_push(vm, value_int(-1));
+                vm_push_nan(vm, nanbox_int(-1));
             }
             break;
         }
 
         case OP_BASE64_ENCODE: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !value_is_string(str)) {
                 vm_set_error(vm, "base64_encode requires string");
                 return VM_ERROR_TYPE;
@@ -2649,7 +3146,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_BASE64_DECODE: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !value_is_string(str)) {
                 vm_set_error(vm, "base64_decode requires string");
                 return VM_ERROR_TYPE;
@@ -2702,21 +3200,23 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_PRINT_ERR: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (v) {
                 char *s = value_repr(v);
                 fprintf(stderr, "%s\n", s);
                 free(s);
             }
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
         case OP_FLOOR: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_float(v)) {
-                vm_push(vm, value_int((int64_t)floor(v->as.floating)));
+                vm_push_nan(vm, nanbox_int((int64_t)floor(v->as.floating)));
             } else if (value_is_int(v)) {
                 vm_push(vm, v);
             } else {
@@ -2727,10 +3227,11 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_CEIL: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_float(v)) {
-                vm_push(vm, value_int((int64_t)ceil(v->as.floating)));
+                vm_push_nan(vm, nanbox_int((int64_t)ceil(v->as.floating)));
             } else if (value_is_int(v)) {
                 vm_push(vm, v);
             } else {
@@ -2741,10 +3242,11 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_ROUND: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_float(v)) {
-                vm_push(vm, value_int((int64_t)round(v->as.floating)));
+                vm_push_nan(vm, nanbox_int((int64_t)round(v->as.floating)));
             } else if (value_is_int(v)) {
                 vm_push(vm, v);
             } else {
@@ -2755,12 +3257,13 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_ABS: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_float(v)) {
-                vm_push(vm, value_float(fabs(v->as.floating)));
+                vm_push_nan(vm, nanbox_double(fabs(v->as.floating)));
             } else if (value_is_int(v)) {
-                vm_push(vm, value_int(v->as.integer < 0 ? -v->as.integer : v->as.integer));
+                vm_push_nan(vm, nanbox_int(v->as.integer < 0 ? -v->as.integer : v->as.integer));
             } else {
                 vm_set_error(vm, "abs requires number");
                 return VM_ERROR_TYPE;
@@ -2769,47 +3272,54 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_SQRT: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             double n = value_is_float(v) ? v->as.floating : (double)v->as.integer;
-            vm_push(vm, value_float(sqrt(n)));
+            vm_push_nan(vm, nanbox_double(sqrt(n)));
             break;
         }
 
         case OP_POW: {
-            Value *exp = vm_pop(vm);
-            Value *base = vm_pop(vm);
+            Value exp_scratch;
+            Value *exp = vm_pop_borrow(vm, &exp_scratch);
+            Value base_scratch;
+            Value *base = vm_pop_borrow(vm, &base_scratch);
             if (!base || !exp) return VM_ERROR_STACK_UNDERFLOW;
             double b = value_is_float(base) ? base->as.floating : (double)base->as.integer;
             double e = value_is_float(exp) ? exp->as.floating : (double)exp->as.integer;
-            vm_push(vm, value_float(pow(b, e)));
+            vm_push_nan(vm, nanbox_double(pow(b, e)));
             break;
         }
 
         case OP_MIN: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
+            Value b_scratch;
+            Value *b = vm_pop_borrow(vm, &b_scratch);
+            Value a_scratch;
+            Value *a = vm_pop_borrow(vm, &a_scratch);
             if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_int(a) && value_is_int(b)) {
-                vm_push(vm, value_int(a->as.integer < b->as.integer ? a->as.integer : b->as.integer));
+                vm_push_nan(vm, nanbox_int(a->as.integer < b->as.integer ? a->as.integer : b->as.integer));
             } else {
                 double da = value_is_float(a) ? a->as.floating : (double)a->as.integer;
                 double db = value_is_float(b) ? b->as.floating : (double)b->as.integer;
-                vm_push(vm, value_float(da < db ? da : db));
+                vm_push_nan(vm, nanbox_double(da < db ? da : db));
             }
             break;
         }
 
         case OP_MAX: {
-            Value *b = vm_pop(vm);
-            Value *a = vm_pop(vm);
+            Value b_scratch;
+            Value *b = vm_pop_borrow(vm, &b_scratch);
+            Value a_scratch;
+            Value *a = vm_pop_borrow(vm, &a_scratch);
             if (!a || !b) return VM_ERROR_STACK_UNDERFLOW;
             if (value_is_int(a) && value_is_int(b)) {
-                vm_push(vm, value_int(a->as.integer > b->as.integer ? a->as.integer : b->as.integer));
+                vm_push_nan(vm, nanbox_int(a->as.integer > b->as.integer ? a->as.integer : b->as.integer));
             } else {
                 double da = value_is_float(a) ? a->as.floating : (double)a->as.integer;
                 double db = value_is_float(b) ? b->as.floating : (double)b->as.integer;
-                vm_push(vm, value_float(da > db ? da : db));
+                vm_push_nan(vm, nanbox_double(da > db ? da : db));
             }
             break;
         }
@@ -2838,8 +3348,10 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "exec requires CAP_EXEC capability");
                 return VM_ERROR_CAPABILITY;
             }
-            Value *input = vm_pop(vm);
-            Value *cmd = vm_pop(vm);
+            Value input_scratch;
+            Value *input = vm_pop_borrow(vm, &input_scratch);
+            Value cmd_scratch;
+            Value *cmd = vm_pop_borrow(vm, &cmd_scratch);
             if (!cmd || !value_is_string(cmd)) {
                 vm_set_error(vm, "exec requires command string");
                 return VM_ERROR_TYPE;
@@ -2854,7 +3366,7 @@ VMResult vm_run(VM *vm) {
             int stdout_pipe[2];
 
             if (pipe(stdin_pipe) == -1 || pipe(stdout_pipe) == -1) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -2862,7 +3374,7 @@ VMResult vm_run(VM *vm) {
             if (pid == -1) {
                 close(stdin_pipe[0]); close(stdin_pipe[1]);
                 close(stdout_pipe[0]); close(stdout_pipe[1]);
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -2900,7 +3412,7 @@ VMResult vm_run(VM *vm) {
             if (!output) {
                 close(stdout_pipe[0]);
                 waitpid(pid, NULL, 0);
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
             output[0] = '\0';
@@ -2914,7 +3426,7 @@ VMResult vm_run(VM *vm) {
                         free(output);
                         close(stdout_pipe[0]);
                         waitpid(pid, NULL, 0);
-                        vm_push(vm, value_nil());
+                        vm_push_nan(vm, NANBOX_NIL);
                         break;
                     }
                     output = new_output;
@@ -2943,7 +3455,8 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "exec_async requires CAP_EXEC capability");
                 return VM_ERROR_CAPABILITY;
             }
-            Value *cmd = vm_pop(vm);
+            Value cmd_scratch;
+            Value *cmd = vm_pop_borrow(vm, &cmd_scratch);
             if (!cmd || !value_is_string(cmd)) {
                 vm_set_error(vm, "exec_async requires command string");
                 return VM_ERROR_TYPE;
@@ -2956,7 +3469,7 @@ VMResult vm_run(VM *vm) {
             int stdout_pipe[2];
 
             if (pipe(stdin_pipe) == -1 || pipe(stdout_pipe) == -1) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -2964,7 +3477,7 @@ VMResult vm_run(VM *vm) {
             if (pid == -1) {
                 close(stdin_pipe[0]); close(stdin_pipe[1]);
                 close(stdout_pipe[0]); close(stdout_pipe[1]);
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -2996,20 +3509,22 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_PROC_WRITE: {
-            Value *data = vm_pop(vm);
-            Value *handle = vm_pop(vm);
+            Value data_scratch;
+            Value *data = vm_pop_borrow(vm, &data_scratch);
+            Value handle_scratch;
+            Value *handle = vm_pop_borrow(vm, &handle_scratch);
             if (!handle || !value_is_map(handle) || !data || !value_is_string(data)) {
                 vm_set_error(vm, "proc_write requires handle and string");
                 return VM_ERROR_TYPE;
             }
             Value *stdin_fd_val = map_get(handle, "_stdin_fd");
             if (!stdin_fd_val || !value_is_int(stdin_fd_val)) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
             int stdin_fd = (int)stdin_fd_val->as.integer;
             if (stdin_fd < 0) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
             const char *str = data->as.string->data;
@@ -3019,24 +3534,25 @@ VMResult vm_run(VM *vm) {
             if (written > 0) {
                 written = write(stdin_fd, "\n", 1);
             }
-            vm_push(vm, value_bool(written > 0));
+            vm_push_nan(vm, nanbox_bool(written > 0));
             break;
         }
 
         case OP_PROC_READ: {
-            Value *handle = vm_pop(vm);
+            Value handle_scratch;
+            Value *handle = vm_pop_borrow(vm, &handle_scratch);
             if (!handle || !value_is_map(handle)) {
                 vm_set_error(vm, "proc_read requires handle");
                 return VM_ERROR_TYPE;
             }
             Value *stdout_fd_val = map_get(handle, "_stdout_fd");
             if (!stdout_fd_val || !value_is_int(stdout_fd_val)) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
             int stdout_fd = (int)stdout_fd_val->as.integer;
             if (stdout_fd < 0) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
             /* Non-blocking read */
@@ -3052,7 +3568,8 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_PROC_CLOSE: {
-            Value *handle = vm_pop(vm);
+            Value handle_scratch;
+            Value *handle = vm_pop_borrow(vm, &handle_scratch);
             if (handle && value_is_map(handle)) {
                 Value *stdin_fd_val = map_get(handle, "_stdin_fd");
                 Value *stdout_fd_val = map_get(handle, "_stdout_fd");
@@ -3076,7 +3593,7 @@ VMResult vm_run(VM *vm) {
                 }
                 map_set(handle, "running", value_bool(false));
             }
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
@@ -3128,7 +3645,8 @@ VMResult vm_run(VM *vm) {
 
         /* Hashing - using fork/exec to avoid shell command injection */
         case OP_HASH_MD5: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !value_is_string(str)) {
                 vm_set_error(vm, "hash_md5 requires string");
                 return VM_ERROR_TYPE;
@@ -3140,7 +3658,7 @@ VMResult vm_run(VM *vm) {
             int stdin_pipe[2];
             int stdout_pipe[2];
             if (pipe(stdin_pipe) == -1 || pipe(stdout_pipe) == -1) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -3148,7 +3666,7 @@ VMResult vm_run(VM *vm) {
             if (pid == -1) {
                 close(stdin_pipe[0]); close(stdin_pipe[1]);
                 close(stdout_pipe[0]); close(stdout_pipe[1]);
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -3190,13 +3708,14 @@ VMResult vm_run(VM *vm) {
                 if (nl) *nl = '\0';
                 vm_push(vm, value_string(result));
             } else {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
             }
             break;
         }
 
         case OP_HASH_SHA256: {
-            Value *str = vm_pop(vm);
+            Value str_scratch;
+            Value *str = vm_pop_borrow(vm, &str_scratch);
             if (!str || !value_is_string(str)) {
                 vm_set_error(vm, "hash_sha256 requires string");
                 return VM_ERROR_TYPE;
@@ -3208,7 +3727,7 @@ VMResult vm_run(VM *vm) {
             int stdin_pipe[2];
             int stdout_pipe[2];
             if (pipe(stdin_pipe) == -1 || pipe(stdout_pipe) == -1) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -3216,7 +3735,7 @@ VMResult vm_run(VM *vm) {
             if (pid == -1) {
                 close(stdin_pipe[0]); close(stdin_pipe[1]);
                 close(stdout_pipe[0]); close(stdout_pipe[1]);
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -3258,13 +3777,14 @@ VMResult vm_run(VM *vm) {
                 if (nl) *nl = '\0';
                 vm_push(vm, value_string(result));
             } else {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
             }
             break;
         }
 
         case OP_PRINT: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (v) {
                 value_print(v);
                 printf("\n");
@@ -3288,23 +3808,26 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_RESULT_IS_OK: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             bool is_ok = value_result_is_ok(v);
-            vm_push(vm, value_bool(is_ok));
+            vm_push_nan(vm, nanbox_bool(is_ok));
             break;
         }
 
         case OP_RESULT_IS_ERR: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             bool is_err = value_result_is_err(v);
-            vm_push(vm, value_bool(is_err));
+            vm_push_nan(vm, nanbox_bool(is_err));
             break;
         }
 
         case OP_RESULT_UNWRAP: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             /* Handle both Result and Option types */
             if (value_is_option(v)) {
@@ -3322,7 +3845,7 @@ VMResult vm_run(VM *vm) {
                     if (inner) {
                         vm_push(vm, inner);
                     } else {
-                        vm_push(vm, value_nil());
+                        vm_push_nan(vm, NANBOX_NIL);
                     }
                 } else {
                     vm_push(vm, inner);
@@ -3335,8 +3858,10 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_RESULT_UNWRAP_OR: {
-            Value *default_val = vm_pop(vm);
-            Value *result = vm_pop(vm);
+            Value default_val_scratch;
+            Value *default_val = vm_pop_borrow(vm, &default_val_scratch);
+            Value result_scratch;
+            Value *result = vm_pop_borrow(vm, &result_scratch);
             if (!result || !default_val) return VM_ERROR_STACK_UNDERFLOW;
             /* Handle both Result and Option types */
             Value *unwrapped;
@@ -3369,23 +3894,26 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_IS_SOME: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             bool is_some = value_option_is_some(v);
-            vm_push(vm, value_bool(is_some));
+            vm_push_nan(vm, nanbox_bool(is_some));
             break;
         }
 
         case OP_IS_NONE: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             bool is_none = value_option_is_none(v);
-            vm_push(vm, value_bool(is_none));
+            vm_push_nan(vm, nanbox_bool(is_none));
             break;
         }
 
         case OP_UNWRAP_OPTION: {
-            Value *v = vm_pop(vm);
+            Value v_scratch;
+            Value *v = vm_pop_borrow(vm, &v_scratch);
             if (!v) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_option(v)) {
                 vm_set_error(vm, "unwrap on non-Option value");
@@ -3401,8 +3929,10 @@ VMResult vm_run(VM *vm) {
         }
 
         case OP_UNWRAP_OPTION_OR: {
-            Value *default_val = vm_pop(vm);
-            Value *option = vm_pop(vm);
+            Value default_val_scratch;
+            Value *default_val = vm_pop_borrow(vm, &default_val_scratch);
+            Value option_scratch;
+            Value *option = vm_pop_borrow(vm, &option_scratch);
             if (!option || !default_val) return VM_ERROR_STACK_UNDERFLOW;
             Value *unwrapped = value_option_unwrap_or(option, default_val);
             vm_push(vm, unwrapped);
@@ -3434,7 +3964,8 @@ VMResult vm_run(VM *vm) {
         case OP_STRUCT_GET: {
             uint16_t field_name_idx = read_short(frame);
             const char *field_name = bytecode_get_string(vm->code, field_name_idx);
-            Value *s = vm_pop(vm);
+            Value s_scratch;
+            Value *s = vm_pop_borrow(vm, &s_scratch);
             if (!s) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_struct(s)) {
                 vm_set_error(vm, "field access on non-struct value");
@@ -3453,7 +3984,8 @@ VMResult vm_run(VM *vm) {
             uint16_t field_name_idx = read_short(frame);
             const char *field_name = bytecode_get_string(vm->code, field_name_idx);
             Value *new_val = vm_pop(vm);
-            Value *s = vm_pop(vm);
+            Value s_scratch;
+            Value *s = vm_pop_borrow(vm, &s_scratch);
             if (!s || !new_val) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_struct(s)) {
                 vm_set_error(vm, "field assignment on non-struct value");
@@ -3479,7 +4011,8 @@ VMResult vm_run(VM *vm) {
 
         case OP_STRUCT_GET_INDEX: {
             uint8_t index = read_byte(frame);
-            Value *s = vm_pop(vm);
+            Value s_scratch;
+            Value *s = vm_pop_borrow(vm, &s_scratch);
             if (!s) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_struct(s)) {
                 vm_set_error(vm, "indexed field access on non-struct value");
@@ -3520,26 +4053,28 @@ VMResult vm_run(VM *vm) {
         case OP_ENUM_IS: {
             uint16_t variant_idx = read_short(frame);
             const char *variant_name = bytecode_get_string(vm->code, variant_idx);
-            Value *e = vm_pop(vm);
+            Value e_scratch;
+            Value *e = vm_pop_borrow(vm, &e_scratch);
             if (!e) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_enum(e)) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
             } else {
                 bool matches = value_enum_is_variant(e, variant_name);
-                vm_push(vm, value_bool(matches));
+                vm_push_nan(vm, nanbox_bool(matches));
             }
             break;
         }
 
         case OP_ENUM_PAYLOAD: {
-            Value *e = vm_pop(vm);
+            Value e_scratch;
+            Value *e = vm_pop_borrow(vm, &e_scratch);
             if (!e) return VM_ERROR_STACK_UNDERFLOW;
             if (!value_is_enum(e)) {
                 vm_set_error(vm, "payload access on non-enum value");
                 return VM_ERROR_TYPE;
             }
             Value *payload = value_enum_payload(e);
-            vm_push(vm, payload ? payload : value_nil());
+            vm_push(vm, payload);
             break;
         }
 
@@ -3556,7 +4091,7 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "no block context");
                 return VM_ERROR_RUNTIME;
             }
-            vm_push(vm, value_pid(block->pid));
+            vm_push_nan(vm, nanbox_pid(block->pid));
             break;
         }
 
@@ -3574,41 +4109,50 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_CAPABILITY;
             }
 
-            /* Pop target pid and message value */
-            Value *msg_value = vm_pop(vm);
-            Value *pid_value = vm_pop(vm);
+            /* Pop target pid and message value. A primitive message is
+             * boxed just for the send, which retains what it keeps */
+            NanValue msg_nan = vm_pop_nan(vm);
+            Value *msg_value = nanbox_to_value(msg_nan);
+            Value pid_value_scratch;
+            Value *pid_value = vm_pop_borrow(vm, &pid_value_scratch);
             if (!msg_value || !pid_value) return VM_ERROR_STACK_UNDERFLOW;
 
             if (pid_value->type != VAL_PID) {
+                if (!nanbox_is_obj(msg_nan)) value_free(msg_value);
                 vm_set_error(vm, "send target must be pid");
                 return VM_ERROR_TYPE;
             }
 
             Pid target_pid = pid_value->as.pid;
-            Block *target = scheduler_get_block(sched, target_pid);
 
-            if (!target || !block_is_alive(target)) {
-                vm_set_error(vm, "send to dead or invalid block");
-                return VM_ERROR_SEND_FAILED;
+            bool sent;
+            const char *send_error;
+            if (scheduler_pid_is_remote(sched, target_pid)) {
+                /* PIDs of other nodes go out through the distribution layer */
+                sent = scheduler_send(sched, target_pid, block->pid, msg_value);
+                send_error = "send to unreachable node";
+            } else {
+                Block *target = scheduler_get_block(sched, target_pid);
+                if (!target || !block_is_alive(target)) {
+                    sent = false;
+                    send_error = "send to dead or invalid block";
+                } else {
+                    /* Copies or shares the message, wakes a parked target */
+                    sent = block_send(target, block->pid, msg_value);
+                    send_error = "mailbox full or send failed";
+                }
             }
-
-            /* Send message (deep copy happens inside) */
-            if (!block_send(target, block->pid, msg_value)) {
-                vm_set_error(vm, "mailbox full or send failed");
+            if (!nanbox_is_obj(msg_nan)) value_free(msg_value);
+            if (!sent) {
+                vm_set_error(vm, send_error);
                 return VM_ERROR_SEND_FAILED;
             }
 
             /* Update sender counters */
             block->counters.messages_sent++;
 
-            /* Wake target if waiting */
-            if (target->state == BLOCK_WAITING) {
-                target->state = BLOCK_RUNNABLE;
-                scheduler_enqueue(sched, target);
-            }
-
             /* Push nil as result */
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
@@ -3640,9 +4184,11 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, result);
             } else {
                 /* No message available, block should wait.
-                 * Back up IP so we retry this instruction when resumed. */
+                 * Back up IP so we retry this instruction when resumed.
+                 * The worker parks the block once the slice is over and
+                 * catches any send that raced with the empty check. */
                 frame->ip--;
-                block->state = BLOCK_WAITING;
+                block->wait_for_mail = true;
                 return VM_WAITING;
             }
             break;
@@ -3663,7 +4209,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop function to spawn */
-            Value *func_val = vm_pop(vm);
+            Value func_val_scratch;
+            Value *func_val = vm_pop_borrow(vm, &func_val_scratch);
             if (!func_val) return VM_ERROR_STACK_UNDERFLOW;
 
             Function *fn = NULL;
@@ -3676,7 +4223,7 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_TYPE;
             }
 
-            if (!fn) {
+            if (!fn || fn->code_offset >= vm->code->functions_count) {
                 vm_set_error(vm, "invalid function for spawn");
                 return VM_ERROR_TYPE;
             }
@@ -3712,10 +4259,13 @@ VMResult vm_run(VM *vm) {
                 bytecode_add_function(spawn_code, dst);
             }
 
-            /* Copy string table */
+            /* Copy string and global tables */
             for (size_t i = 0; i < vm->code->strings_count; i++) {
                 bytecode_add_string(spawn_code, vm->code->strings[i]);
             }
+            for (size_t i = 0; i < vm->code->globals_count; i++) {
+                bytecode_add_global(spawn_code, vm->code->globals[i]);
+            }
 
             /* Spawn the new block */
             char spawn_name[64];
@@ -3741,7 +4291,7 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Push child PID */
-            vm_push(vm, value_pid(child_pid));
+            vm_push_nan(vm, nanbox_pid(child_pid));
             break;
         }
 
@@ -3796,8 +4346,10 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop tool name and argument count */
-            Value *arg_count_val = vm_pop(vm);
-            Value *tool_name_val = vm_pop(vm);
+            Value arg_count_val_scratch;
+            Value *arg_count_val = vm_pop_borrow(vm, &arg_count_val_scratch);
+            Value tool_name_val_scratch;
+            Value *tool_name_val = vm_pop_borrow(vm, &tool_name_val_scratch);
             if (!arg_count_val || !tool_name_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (!value_is_string(tool_name_val) || !value_is_int(arg_count_val)) {
@@ -3852,7 +4404,8 @@ VMResult vm_run(VM *vm) {
 
         case OP_TOOL_SCHEMA: {
             Scheduler *sched = (Scheduler *)vm->scheduler;
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (!value_is_string(name_val)) {
@@ -3861,20 +4414,20 @@ VMResult vm_run(VM *vm) {
             }
 
             if (!sched) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
             PrimitivesRuntime *rt = scheduler_get_primitives(sched);
             if (!rt) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
             /* Find tool and get schema */
             Tool *tool = tools_find(&rt->tools, name_val->as.string->data);
             if (!tool) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -3883,7 +4436,7 @@ VMResult vm_run(VM *vm) {
                 vm_push(vm, value_string(schema));
                 free(schema);
             } else {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
             }
             break;
         }
@@ -3909,7 +4462,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop key from stack */
-            Value *key = vm_pop(vm);
+            Value key_scratch;
+            Value *key = vm_pop_borrow(vm, &key_scratch);
             if (!key) return VM_ERROR_STACK_UNDERFLOW;
 
             if (!value_is_string(key)) {
@@ -3919,7 +4473,7 @@ VMResult vm_run(VM *vm) {
 
             /* Get value */
             Value *result = primitives_memory_get(rt, key->as.string->data);
-            vm_push(vm, result ? result : value_nil());
+            vm_push(vm, result);
             break;
         }
 
@@ -3945,7 +4499,8 @@ VMResult vm_run(VM *vm) {
 
             /* Pop value and key from stack */
             Value *val = vm_pop(vm);
-            Value *key = vm_pop(vm);
+            Value key_scratch;
+            Value *key = vm_pop_borrow(vm, &key_scratch);
             if (!key || !val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (!value_is_string(key)) {
@@ -3955,7 +4510,7 @@ VMResult vm_run(VM *vm) {
 
             /* Set value */
             primitives_memory_set(rt, key->as.string->data, val);
-            vm_push(vm, value_nil());
+            vm_push_nan(vm, NANBOX_NIL);
             break;
         }
 
@@ -3975,7 +4530,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop target PID */
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
             if (!pid_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (pid_val->type != VAL_PID) {
@@ -3984,6 +4540,19 @@ VMResult vm_run(VM *vm) {
             }
 
             Pid target_pid = pid_val->as.pid;
+            if (scheduler_pid_is_remote(sched, target_pid)) {
+                /* The target's node answers a dead target with an exit */
+                block_link(block, target_pid);
+                if (!scheduler_signal_remote(sched, REMOTE_LINK, target_pid, block->pid,
+                                             NULL, 0)) {
+                    block_unlink(block, target_pid);
+                    vm_set_error(vm, "cannot link to unreachable node");
+                    return VM_ERROR_RUNTIME;
+                }
+                vm_push_nan(vm, nanbox_bool(true));
+                break;
+            }
+
             Block *target = scheduler_get_block(sched, target_pid);
 
             if (!target || !block_is_alive(target)) {
@@ -3991,11 +4560,15 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            /* Create bidirectional link */
+            /* Link the target side first: it is refused once the target
+             * has started terminating, so we never hold a one-way link */
+            if (!block_link(target, block->pid)) {
+                vm_set_error(vm, "cannot link to dead or invalid block");
+                return VM_ERROR_RUNTIME;
+            }
             block_link(block, target_pid);
-            block_link(target, block->pid);
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4008,7 +4581,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop target PID */
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
             if (!pid_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (pid_val->type != VAL_PID) {
@@ -4017,15 +4591,20 @@ VMResult vm_run(VM *vm) {
             }
 
             Pid target_pid = pid_val->as.pid;
-            Block *target = scheduler_get_block(sched, target_pid);
 
             /* Remove bidirectional link */
             block_unlink(block, target_pid);
-            if (target) {
-                block_unlink(target, block->pid);
+            if (scheduler_pid_is_remote(sched, target_pid)) {
+                scheduler_signal_remote(sched, REMOTE_UNLINK, target_pid, block->pid,
+                                        NULL, 0);
+            } else {
+                Block *target = scheduler_get_block(sched, target_pid);
+                if (target) {
+                    block_unlink(target, block->pid);
+                }
             }
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4044,7 +4623,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop target PID */
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
             if (!pid_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (pid_val->type != VAL_PID) {
@@ -4053,23 +4633,38 @@ VMResult vm_run(VM *vm) {
             }
 
             Pid target_pid = pid_val->as.pid;
-            Block *target = scheduler_get_block(sched, target_pid);
+            const char *down_reason = NULL;
+
+            block_monitor(block, target_pid);
+            if (scheduler_pid_is_remote(sched, target_pid)) {
+                /* The target's node answers a dead target with a DOWN */
+                if (!scheduler_signal_remote(sched, REMOTE_MONITOR, target_pid,
+                                             block->pid, NULL, 0)) {
+                    down_reason = "noconnection";
+                }
+            } else {
+                /* Registering with the target fails once it has started
+                 * terminating, in which case its DOWN will never come */
+                Block *target = scheduler_get_block(sched, target_pid);
+                if (!target || !block_add_monitored_by(target, block->pid)) {
+                    down_reason = "noproc";
+                }
+            }
 
-            if (!target || !block_is_alive(target)) {
-                /* Target already dead - send immediate DOWN message */
+            if (down_reason) {
+                block_demonitor(block, target_pid);
+
+                /* Target unreachable - send immediate DOWN message */
                 Value *down_msg = value_map();
                 down_msg = map_set(down_msg, "type", value_string("down"));
                 down_msg = map_set(down_msg, "pid", value_pid(target_pid));
-                down_msg = map_set(down_msg, "reason", value_string("noproc"));
+                down_msg = map_set(down_msg, "reason", value_string(down_reason));
                 down_msg = map_set(down_msg, "code", value_int(-1));
                 block_send(block, target_pid, down_msg);
-            } else {
-                /* Set up monitoring */
-                block_monitor(block, target_pid);
-                block_add_monitored_by(target, block->pid);
+                value_free(down_msg);
             }
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4082,7 +4677,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop target PID */
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
             if (!pid_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (pid_val->type != VAL_PID) {
@@ -4091,15 +4687,20 @@ VMResult vm_run(VM *vm) {
             }
 
             Pid target_pid = pid_val->as.pid;
-            Block *target = scheduler_get_block(sched, target_pid);
 
             /* Remove monitoring */
             block_demonitor(block, target_pid);
-            if (target) {
-                block_remove_monitored_by(target, block->pid);
+            if (scheduler_pid_is_remote(sched, target_pid)) {
+                scheduler_signal_remote(sched, REMOTE_DEMONITOR, target_pid, block->pid,
+                                        NULL, 0);
+            } else {
+                Block *target = scheduler_get_block(sched, target_pid);
+                if (target) {
+                    block_remove_monitored_by(target, block->pid);
+                }
             }
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4118,7 +4719,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop strategy from stack */
-            Value *strategy_val = vm_pop(vm);
+            Value strategy_val_scratch;
+            Value *strategy_val = vm_pop_borrow(vm, &strategy_val_scratch);
             if (!strategy_val) return VM_ERROR_STACK_UNDERFLOW;
 
             SupervisorStrategy strategy = SUP_ONE_FOR_ONE;
@@ -4139,7 +4741,7 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4157,9 +4759,12 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop restart strategy, code function, and name */
-            Value *restart_val = vm_pop(vm);
-            Value *func_val = vm_pop(vm);
-            Value *name_val = vm_pop(vm);
+            Value restart_val_scratch;
+            Value *restart_val = vm_pop_borrow(vm, &restart_val_scratch);
+            Value func_val_scratch;
+            Value *func_val = vm_pop_borrow(vm, &func_val_scratch);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!restart_val || !func_val || !name_val) return VM_ERROR_STACK_UNDERFLOW;
 
             /* Parse restart strategy */
@@ -4191,6 +4796,10 @@ VMResult vm_run(VM *vm) {
                 vm_set_error(vm, "child must be a function");
                 return VM_ERROR_TYPE;
             }
+            if (!fn || fn->code_offset >= vm->code->functions_count) {
+                vm_set_error(vm, "invalid function for child");
+                return VM_ERROR_TYPE;
+            }
 
             /* Create bytecode for child (similar to OP_SPAWN) */
             Bytecode *spawn_code = bytecode_new();
@@ -4216,6 +4825,9 @@ VMResult vm_run(VM *vm) {
             for (size_t i = 0; i < vm->code->strings_count; i++) {
                 bytecode_add_string(spawn_code, vm->code->strings[i]);
             }
+            for (size_t i = 0; i < vm->code->globals_count; i++) {
+                bytecode_add_global(spawn_code, vm->code->globals[i]);
+            }
 
             /* Add child to supervisor */
             if (!supervisor_add_child(block->supervisor, sched, block,
@@ -4229,7 +4841,7 @@ VMResult vm_run(VM *vm) {
             ChildSpec *spec = supervisor_get_child(block->supervisor, child_name);
             Pid child_pid = spec ? spec->child_pid : PID_INVALID;
 
-            vm_push(vm, value_pid(child_pid));
+            vm_push_nan(vm, nanbox_pid(child_pid));
             break;
         }
 
@@ -4247,7 +4859,8 @@ VMResult vm_run(VM *vm) {
             }
 
             /* Pop child name */
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val) return VM_ERROR_STACK_UNDERFLOW;
 
             if (!value_is_string(name_val)) {
@@ -4256,7 +4869,7 @@ VMResult vm_run(VM *vm) {
             }
 
             bool ok = supervisor_remove_child(block->supervisor, sched, name_val->as.string->data);
-            vm_push(vm, value_bool(ok));
+            vm_push_nan(vm, nanbox_bool(ok));
             break;
         }
 
@@ -4304,7 +4917,7 @@ VMResult vm_run(VM *vm) {
             }
 
             supervisor_shutdown(block->supervisor, sched);
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4322,23 +4935,16 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_CAPABILITY;
             }
 
-            /* Check if timeout already fired */
-            if (block->timeout_fired) {
-                /* Timeout fired - return Err("timeout") */
-                block->timeout_fired = false;
-                block->pending_timer = NULL;
-                vm_push(vm, value_result_err(value_string("timeout")));
-                break;
-            }
+            /* The timeout operand is consumed when the timer is armed */
+            bool armed = block->pending_timer != NULL;
 
-            /* Try to receive a message first */
+            /* A queued message wins over a timeout that fired concurrently */
             Message *msg = block_receive(block);
             if (msg) {
-                /* Got a message - cancel any pending timer */
-                if (block->pending_timer) {
-                    /* Free the timer entry (malloc'd in this opcode) */
-                    free(block->pending_timer);
-                    block->pending_timer = NULL;
+                if (armed) {
+                    scheduler_cancel_timer(sched, block);
+                } else {
+                    vm_pop_nan(vm);
                 }
 
                 /* Create result map */
@@ -4353,10 +4959,17 @@ VMResult vm_run(VM *vm) {
                 break;
             }
 
-            /* No message available - set up timeout if not already pending */
-            if (!block->pending_timer) {
-                /* Pop timeout value from stack */
-                Value *timeout_val = vm_pop(vm);
+            if (armed && atomic_exchange(&block->timeout_fired, false)) {
+                /* The wheel recycles fired entries */
+                block->pending_timer = NULL;
+                block->timer_wheel = NULL;
+                vm_push(vm, value_result_err(value_string("timeout")));
+                break;
+            }
+
+            if (!armed) {
+                Value timeout_val_scratch;
+                Value *timeout_val = vm_pop_borrow(vm, &timeout_val_scratch);
                 if (!timeout_val || timeout_val->type != VAL_INT) {
                     vm_set_error(vm, "receive_timeout requires integer timeout");
                     return VM_ERROR_TYPE;
@@ -4369,34 +4982,104 @@ VMResult vm_run(VM *vm) {
                     break;
                 }
 
-                /* Store deadline in pending_timer (using timestamp for simplicity) */
-                /* In a full implementation, we'd use a timer wheel */
-                TimerEntry *timer = malloc(sizeof(TimerEntry));
-                if (timer) {
-                    timer->block_pid = block->pid;
-                    timer->deadline_ms = timer_current_time_ms() + (uint64_t)timeout_ms;
-                    timer->callback = NULL;
-                    timer->callback_ctx = NULL;
-                    timer->next = NULL;
-                    timer->prev = NULL;
-                    timer->cancelled = false;
-                    block->pending_timer = timer;
+                if (!scheduler_arm_timer(sched, block, (uint64_t)timeout_ms)) {
+                    vm_set_error(vm, "failed to arm receive timeout");
+                    return VM_ERROR_RUNTIME;
                 }
-            } else {
-                /* Check if deadline has passed */
-                if (timer_current_time_ms() >= block->pending_timer->deadline_ms) {
-                    /* Timer expired */
-                    free(block->pending_timer);
+            }
+
+            /*
+             * Wait for a message or the timer. Either may arrive after the
+             * checks above while we are still running; block_park picks
+             * up the wakeup once the worker is done with the slice.
+             */
+            frame->ip--;
+            block->wait_for_mail = true;
+            return VM_WAITING;
+        }
+
+        case OP_RECEIVE_MANY: {
+            Block *block = (Block *)vm->block;
+            Scheduler *sched = (Scheduler *)vm->scheduler;
+            if (!block || !sched) {
+                vm_set_error(vm, "no runtime context");
+                return VM_ERROR_RUNTIME;
+            }
+
+            if (!block_has_cap(block, CAP_RECEIVE)) {
+                vm_set_error(vm, "receive capability denied");
+                return VM_ERROR_CAPABILITY;
+            }
+
+            /* Stack is [count, timeout]; the timeout is consumed when the
+             * timer is armed and the count stays put across retries */
+            bool armed = block->pending_timer != NULL;
+            Value count_val_scratch;
+            Value *count_val = vm_peek_borrow(vm, armed ? 0 : 1, &count_val_scratch);
+            if (!count_val || count_val->type != VAL_INT || count_val->as.integer <= 0) {
+                vm_set_error(vm, "receive_many requires a positive integer count");
+                return VM_ERROR_TYPE;
+            }
+            size_t want = (size_t)count_val->as.integer;
+
+            int64_t timeout_ms = 0;
+            if (!armed) {
+                Value timeout_val_scratch;
+                Value *timeout_val = vm_peek_borrow(vm, 0, &timeout_val_scratch);
+                if (!timeout_val || timeout_val->type != VAL_INT) {
+                    vm_set_error(vm, "receive_many requires integer timeout");
+                    return VM_ERROR_TYPE;
+                }
+                timeout_ms = timeout_val->as.integer;
+            }
+
+            bool timed_out = armed && atomic_exchange(&block->timeout_fired, false);
+            if (block_has_messages(block) || timed_out || (!armed && timeout_ms <= 0)) {
+                if (armed && !timed_out) {
+                    scheduler_cancel_timer(sched, block);
+                } else if (timed_out) {
+                    /* The wheel recycles fired entries */
                     block->pending_timer = NULL;
-                    vm_push(vm, value_result_err(value_string("timeout")));
-                    break;
+                    block->timer_wheel = NULL;
                 }
+                if (!armed) vm_pop_nan(vm);
+                vm_pop_nan(vm);
+
+                /* Each message becomes a [sender, value] pair; an empty
+                 * array means the timeout expired first */
+                Value *result = value_array_with_capacity(want < 64 ? want : 64);
+                Message *batch[64];
+                size_t room, taken;
+                do {
+                    room = want < 64 ? want : 64;
+                    taken = block_receive_batch(block, batch, room);
+                    for (size_t i = 0; i < taken; i++) {
+                        Value *pair = value_array_with_capacity(2);
+                        pair = array_push(pair, value_pid(batch[i]->sender));
+                        pair = array_push(pair, batch[i]->value);
+                        batch[i]->value = NULL;
+                        message_free(batch[i]);
+                        result = array_push(result, pair);
+                    }
+                    want -= taken;
+                } while (want > 0 && taken == room);
+
+                vm_push(vm, result);
+                break;
             }
 
-            /* No message and timer not expired - yield and retry later */
-            frame->ip--;  /* Backup IP to retry this instruction */
-            block->state = BLOCK_WAITING;
-            return VM_YIELD;
+            if (!armed) {
+                vm_pop_nan(vm);
+                if (!scheduler_arm_timer(sched, block, (uint64_t)timeout_ms)) {
+                    vm_set_error(vm, "failed to arm receive timeout");
+                    return VM_ERROR_RUNTIME;
+                }
+            }
+
+            /* Wait as receive_timeout does */
+            frame->ip--;
+            block->wait_for_mail = true;
+            return VM_WAITING;
         }
 
         /* Process Groups */
@@ -4409,7 +5092,8 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val || name_val->type != VAL_STRING) {
                 vm_set_error(vm, "group_join requires string name");
                 return VM_ERROR_TYPE;
@@ -4422,7 +5106,7 @@ VMResult vm_run(VM *vm) {
             }
 
             bool ok = procgroup_join(groups, name_val->as.string->data, block->pid);
-            vm_push(vm, value_bool(ok));
+            vm_push_nan(vm, nanbox_bool(ok));
             break;
         }
 
@@ -4434,7 +5118,8 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val || name_val->type != VAL_STRING) {
                 vm_set_error(vm, "group_leave requires string name");
                 return VM_ERROR_TYPE;
@@ -4444,7 +5129,7 @@ VMResult vm_run(VM *vm) {
             if (groups) {
                 procgroup_leave(groups, name_val->as.string->data, block->pid);
             }
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4457,7 +5142,8 @@ VMResult vm_run(VM *vm) {
             }
 
             Value *message = vm_pop(vm);
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val || name_val->type != VAL_STRING) {
                 vm_set_error(vm, "group_send requires string name");
                 return VM_ERROR_TYPE;
@@ -4469,7 +5155,7 @@ VMResult vm_run(VM *vm) {
                 sent = procgroup_broadcast(groups, sched, name_val->as.string->data,
                                            block->pid, message);
             }
-            vm_push(vm, value_int((int64_t)sent));
+            vm_push_nan(vm, nanbox_int((int64_t)sent));
             break;
         }
 
@@ -4482,7 +5168,8 @@ VMResult vm_run(VM *vm) {
             }
 
             Value *message = vm_pop(vm);
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val || name_val->type != VAL_STRING) {
                 vm_set_error(vm, "group_send_others requires string name");
                 return VM_ERROR_TYPE;
@@ -4494,7 +5181,7 @@ VMResult vm_run(VM *vm) {
                 sent = procgroup_broadcast_others(groups, sched, name_val->as.string->data,
                                                   block->pid, message);
             }
-            vm_push(vm, value_int((int64_t)sent));
+            vm_push_nan(vm, nanbox_int((int64_t)sent));
             break;
         }
 
@@ -4506,7 +5193,8 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *name_val = vm_pop(vm);
+            Value name_val_scratch;
+            Value *name_val = vm_pop_borrow(vm, &name_val_scratch);
             if (!name_val || name_val->type != VAL_STRING) {
                 vm_set_error(vm, "group_members requires string name");
                 return VM_ERROR_TYPE;
@@ -4563,7 +5251,8 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
             Pid target_pid = block->pid;  /* Default to self */
             if (pid_val && pid_val->type == VAL_PID) {
                 target_pid = pid_val->as.pid;
@@ -4571,7 +5260,7 @@ VMResult vm_run(VM *vm) {
 
             Block *target = scheduler_get_block(sched, target_pid);
             if (!target) {
-                vm_push(vm, value_nil());
+                vm_push_nan(vm, NANBOX_NIL);
                 break;
             }
 
@@ -4599,8 +5288,10 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *flags_val = vm_pop(vm);
-            Value *pid_val = vm_pop(vm);
+            Value flags_val_scratch;
+            Value *flags_val = vm_pop_borrow(vm, &flags_val_scratch);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
 
             /* Get target PID (default to self) */
             Pid target_pid = block->pid;
@@ -4617,7 +5308,7 @@ VMResult vm_run(VM *vm) {
             /* Get target block */
             Block *target = scheduler_get_block(sched, target_pid);
             if (!target) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
 
@@ -4625,7 +5316,7 @@ VMResult vm_run(VM *vm) {
             if (!target->tracer) {
                 target->tracer = tracer_new(flags, 1024);  /* Buffer for 1024 events */
                 if (!target->tracer) {
-                    vm_push(vm, value_bool(false));
+                    vm_push_nan(vm, nanbox_bool(false));
                     break;
                 }
             } else {
@@ -4635,7 +5326,7 @@ VMResult vm_run(VM *vm) {
             tracer_set_enabled(target->tracer, true);
             tracer_set_target(target->tracer, block->pid);  /* Set tracer PID (who receives traces) */
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4648,7 +5339,8 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_RUNTIME;
             }
 
-            Value *pid_val = vm_pop(vm);
+            Value pid_val_scratch;
+            Value *pid_val = vm_pop_borrow(vm, &pid_val_scratch);
 
             /* Get target PID (default to self) */
             Pid target_pid = block->pid;
@@ -4659,7 +5351,7 @@ VMResult vm_run(VM *vm) {
             /* Get target block */
             Block *target = scheduler_get_block(sched, target_pid);
             if (!target) {
-                vm_push(vm, value_bool(false));
+                vm_push_nan(vm, nanbox_bool(false));
                 break;
             }
 
@@ -4668,7 +5360,7 @@ VMResult vm_run(VM *vm) {
                 tracer_set_enabled(target->tracer, false);
             }
 
-            vm_push(vm, value_bool(true));
+            vm_push_nan(vm, nanbox_bool(true));
             break;
         }
 
@@ -4687,45 +5379,27 @@ VMResult vm_run(VM *vm) {
                 return VM_ERROR_CAPABILITY;
             }
 
-            Value *pattern = vm_pop(vm);
+            Value pattern_scratch;
+            /* Stays on the stack until a match so a parked retry sees it */
+            Value *pattern = vm_peek_borrow(vm, 0, &pattern_scratch);
+            bool by_keys = pattern && pattern->type == VAL_MAP;
 
-            /* Helper function to check if a message matches the pattern */
-            bool matched = false;
             Message *matched_msg = NULL;
 
-            /* First, scan the save queue for a matching message */
+            /* A parked retry of this receive already tested every saved
+             * message against the pattern; only new mail needs a look.
+             * Any other receive starts over from the oldest saved message. */
             Message *prev = NULL;
             Message *scan = block->save_queue_head;
-            while (scan && !matched) {
-                bool msg_matches = true;
-
-                /* Pattern matching logic */
-                if (pattern && pattern->type == VAL_MAP && scan->value && scan->value->type == VAL_MAP) {
-                    Value *keys_val = map_keys(pattern);
-                    if (keys_val && keys_val->type == VAL_ARRAY) {
-                        Array *keys = keys_val->as.array;
-                        for (size_t i = 0; i < keys->length && msg_matches; i++) {
-                            Value *key = keys->items[i];
-                            if (key && key->type == VAL_STRING) {
-                                const char *key_str = key->as.string->data;
-                                Value *pattern_val = map_get(pattern, key_str);
-                                Value *msg_val = map_get(scan->value, key_str);
-
-                                if (!msg_val) {
-                                    msg_matches = false;
-                                } else if (pattern_val && pattern_val->type != VAL_NIL) {
-                                    if (!value_equals(pattern_val, msg_val)) {
-                                        msg_matches = false;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
+            if (by_keys && block->save_scan_pattern == pattern && block->save_scan_mark) {
+                prev = block->save_scan_mark;
+                scan = prev->next;
+            }
 
-                if (msg_matches) {
+            while (scan) {
+                block->counters.match_tests++;
+                if (message_matches(pattern, scan->value)) {
                     /* Found a match in save queue - remove it */
-                    matched = true;
                     matched_msg = scan;
 
                     if (prev) {
@@ -4736,45 +5410,19 @@ VMResult vm_run(VM *vm) {
                     if (scan == block->save_queue_tail) {
                         block->save_queue_tail = prev;
                     }
-                } else {
-                    prev = scan;
-                    scan = scan->next;
+                    break;
                 }
+                prev = scan;
+                scan = scan->next;
             }
 
             /* If not found in save queue, scan the mailbox */
-            while (!matched) {
+            while (!matched_msg) {
                 Message *msg = block_receive(block);
                 if (!msg) break;  /* No more messages */
 
-                bool msg_matches = true;
-
-                /* Pattern matching logic */
-                if (pattern && pattern->type == VAL_MAP && msg->value && msg->value->type == VAL_MAP) {
-                    Value *keys_val = map_keys(pattern);
-                    if (keys_val && keys_val->type == VAL_ARRAY) {
-                        Array *keys = keys_val->as.array;
-                        for (size_t i = 0; i < keys->length && msg_matches; i++) {
-                            Value *key = keys->items[i];
-                            if (key && key->type == VAL_STRING) {
-                                const char *key_str = key->as.string->data;
-                                Value *pattern_val = map_get(pattern, key_str);
-                                Value *msg_val = map_get(msg->value, key_str);
-
-                                if (!msg_val) {
-                                    msg_matches = false;
-                                } else if (pattern_val && pattern_val->type != VAL_NIL) {
-                                    if (!value_equals(pattern_val, msg_val)) {
-                                        msg_matches = false;
-                                    }
-                                }
-                            }
-                        }
-                    }
-                }
-
-                if (msg_matches) {
-                    matched = true;
+                block->counters.match_tests++;
+                if (message_matches(pattern, msg->value)) {
                     matched_msg = msg;
                 } else {
                     /* Non-matching message - add to save queue tail */
@@ -4788,19 +5436,27 @@ VMResult vm_run(VM *vm) {
                 }
             }
 
-            if (matched && matched_msg) {
+            /* Mark how far the saved messages have been tested, for as long
+             * as the pattern stays pending on the stack */
+            block->save_scan_pattern = matched_msg ? NULL : pattern;
+            block->save_scan_mark = matched_msg ? NULL : block->save_queue_tail;
+
+            if (matched_msg) {
                 /* Create result map with sender and value */
                 Value *result = value_map();
                 map_set(result, "sender", value_pid(matched_msg->sender));
                 map_set(result, "value", matched_msg->value);
                 matched_msg->value = NULL;
                 message_free(matched_msg);
+                vm_pop_nan(vm);
                 vm_push(vm, result);
             } else {
-                /* No matching message available - yield and retry */
+                /* No matching message - wait for the next send. Unmatched
+                 * messages are in the save queue, so anything in the
+                 * mailbox at park time arrived since the scan. */
                 frame->ip--;
-                block->state = BLOCK_WAITING;
-                return VM_YIELD;
+                block->wait_for_mail = true;
+                return VM_WAITING;
             }
             break;
         }
@@ -67,7 +67,10 @@ typedef struct VM {
 
     bool initialized;
 
-    Value *globals;
+    /* Global slots, laid out by code->globals; NANBOX_EMPTY until set */
+    NanValue *globals;
+    size_t globals_count;
+    Value *pending_globals; /* Name-keyed values waiting for vm_load */
     Bytecode *code;
 
     Upvalue *open_upvalues;
@@ -98,6 +101,12 @@ VMResult vm_run(VM *vm);
 VMResult vm_step(VM *vm);
 VMResult vm_resume(VM *vm);
 
+/* Globals (by name, for hot reload, checkpoints and debugging) */
+
+Value *vm_globals_snapshot(VM *vm);
+void vm_restore_globals(VM *vm, Value *state);
+Value *vm_get_global(VM *vm, const char *name);
+
 /* Stack Operations (NaN-boxed) */
 
 VMResult vm_push_nan(VM *vm, NanValue value);
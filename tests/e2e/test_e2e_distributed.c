@@ -14,43 +14,68 @@
 
 #include "../test_common.h"
 #include "dist/node.h"
+#include "runtime/scheduler.h"
 #include "runtime/timer.h"
+#include "vm/bytecode.h"
 #include "vm/value.h"
+#include "types/map.h"
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
 #include <unistd.h>
 #include <string.h>
 
-/* Callback tracking */
-static int node_up_count = 0;
-static int node_down_count = 0;
-static int message_count = 0;
+/* Callback tracking. Callbacks run on the nodes' threads, so the counters
+ * are atomic and the last node name is copied under its own lock. */
+static _Atomic(int) node_up_count = 0;
+static _Atomic(int) node_down_count = 0;
+static _Atomic(int) message_count = 0;
+static _Atomic(Pid) last_target_pid = 0;
 static char last_node_name[NODE_NAME_MAX] = {0};
-static Pid last_target_pid = 0;
+static pthread_mutex_t last_node_name_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void set_last_node_name(const char *name)
+{
+	pthread_mutex_lock(&last_node_name_lock);
+	strncpy(last_node_name, name, NODE_NAME_MAX - 1);
+	last_node_name[NODE_NAME_MAX - 1] = '\0';
+	pthread_mutex_unlock(&last_node_name_lock);
+}
+
+static void get_last_node_name(char *buf)
+{
+	pthread_mutex_lock(&last_node_name_lock);
+	memcpy(buf, last_node_name, NODE_NAME_MAX);
+	pthread_mutex_unlock(&last_node_name_lock);
+}
 
 static void reset_callbacks(void)
 {
-	node_up_count = 0;
-	node_down_count = 0;
-	message_count = 0;
-	last_node_name[0] = '\0';
-	last_target_pid = 0;
+	atomic_store(&node_up_count, 0);
+	atomic_store(&node_down_count, 0);
+	atomic_store(&message_count, 0);
+	atomic_store(&last_target_pid, 0);
+	set_last_node_name("");
 }
 
 static void on_node_up_callback(void *ctx, const NodeId *node)
 {
 	(void)ctx;
-	node_up_count++;
+	atomic_fetch_add(&node_up_count, 1);
 	if (node && node->name[0]) {
-		strncpy(last_node_name, node->name, NODE_NAME_MAX - 1);
+		set_last_node_name(node->name);
 	}
 }
 
 static void on_node_down_callback(void *ctx, const NodeId *node)
 {
 	(void)ctx;
-	node_down_count++;
+	atomic_fetch_add(&node_down_count, 1);
 	if (node && node->name[0]) {
-		strncpy(last_node_name, node->name, NODE_NAME_MAX - 1);
+		set_last_node_name(node->name);
 	}
 }
 
@@ -61,8 +86,31 @@ static void on_message_callback(void *ctx, const NodeId *from, Pid target,
 	(void)from;
 	(void)msg;
 	(void)len;
-	message_count++;
-	last_target_pid = target;
+	atomic_store(&last_target_pid, target);
+	atomic_fetch_add(&message_count, 1);
+}
+
+/* Node fields the event loop writes are read under the node lock */
+static size_t peer_count_of(DistributedNode *node)
+{
+	pthread_mutex_lock(&node->lock);
+	size_t count = node->peer_count;
+	pthread_mutex_unlock(&node->lock);
+	return count;
+}
+
+static uint64_t peer_node_id(DistributedNode *node, const char *peer_name)
+{
+	uint64_t id = 0;
+	pthread_mutex_lock(&node->lock);
+	for (NodeConnection *conn = node->peers; conn; conn = conn->next) {
+		if (strcmp(conn->peer.name, peer_name) == 0) {
+			id = conn->peer.node_id;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&node->lock);
+	return id;
 }
 
 /* Test 1: Default node configuration */
@@ -76,6 +124,8 @@ void test_node_config_default(void)
 	ASSERT_EQ(0, cfg.cookie);
 	ASSERT_EQ(5000, cfg.heartbeat_ms);
 	ASSERT_EQ(10000, cfg.timeout_ms);
+	ASSERT_EQ(0, cfg.flush_delay_us);
+	ASSERT_EQ(0, cfg.node_number);
 }
 
 /* Test 2: Node creation */
@@ -360,8 +410,8 @@ void test_message_sending(void)
 	usleep(50000);
 
 	/* Verify message received */
-	ASSERT_EQ(1, message_count);
-	ASSERT_EQ(42, last_target_pid);
+	ASSERT_EQ(1, atomic_load(&message_count));
+	ASSERT_EQ(42, atomic_load(&last_target_pid));
 
 	/* Cleanup */
 	node_stop(server);
@@ -406,7 +456,7 @@ void test_multiple_connections(void)
 	usleep(150000);
 
 	/* Server should have 2 peers */
-	ASSERT_EQ(2, server->peer_count);
+	ASSERT_EQ(2, peer_count_of(server));
 
 	/* Cleanup */
 	node_stop(server);
@@ -449,7 +499,191 @@ void test_connection_statistics(void)
 	usleep(50000);
 
 	/* Check stats updated */
-	ASSERT(peer->messages_sent > 0);
+	ASSERT(atomic_load(&peer->messages_sent) > 0);
+
+	node_stop(server);
+	node_stop(client);
+	node_free(server);
+	node_free(client);
+}
+
+/* Concurrent sender tracking: every payload is its sender PID repeated */
+#define SENDER_THREADS 4
+#define SENDS_PER_THREAD 200
+
+static _Atomic(int) intact_count = 0;
+static _Atomic(int) corrupt_count = 0;
+
+static void on_checked_message_callback(void *ctx, const NodeId *from,
+					Pid target, void *msg, size_t len)
+{
+	(void)ctx;
+	(void)from;
+	const uint8_t *bytes = msg;
+	bool intact = len > 0;
+	for (size_t i = 0; i < len; i++) {
+		if (bytes[i] != (uint8_t)target) {
+			intact = false;
+			break;
+		}
+	}
+	if (intact) {
+		atomic_fetch_add(&intact_count, 1);
+	} else {
+		atomic_fetch_add(&corrupt_count, 1);
+	}
+}
+
+typedef struct SenderArgs {
+	DistributedNode *node;
+	const char *peer;
+	Pid id;
+} SenderArgs;
+
+static void *sender_thread(void *arg)
+{
+	SenderArgs *args = arg;
+	uint8_t payload[300];
+	memset(payload, (int)args->id, sizeof(payload));
+
+	for (int i = 0; i < SENDS_PER_THREAD; i++) {
+		/* Vary the size so frames straddle each other's boundaries */
+		size_t len = 1 + (size_t)(i * 37) % sizeof(payload);
+		node_send(args->node, args->peer, args->id, args->id, payload, len);
+	}
+	return NULL;
+}
+
+static void run_concurrent_senders(uint16_t server_port, uint16_t client_port,
+				   uint32_t flush_delay_us, uint64_t *flushes)
+{
+	atomic_store(&intact_count, 0);
+	atomic_store(&corrupt_count, 0);
+
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "burst_server", NODE_NAME_MAX);
+	server_cfg.port = server_port;
+	server_cfg.cookie = 0x5EED5EED;
+
+	DistributedNode *server = node_new(&server_cfg);
+	server->on_message = on_checked_message_callback;
+	ASSERT(node_start(server));
+
+	NodeConfig client_cfg = node_config_default();
+	strncpy(client_cfg.name, "burst_client", NODE_NAME_MAX);
+	client_cfg.port = client_port;
+	client_cfg.cookie = 0x5EED5EED;
+	client_cfg.flush_delay_us = flush_delay_us;
+
+	DistributedNode *client = node_new(&client_cfg);
+	ASSERT(node_start(client));
+	ASSERT(node_connect(client, "burst_server", "127.0.0.1", server_port));
+	usleep(100000);
+
+	pthread_t threads[SENDER_THREADS];
+	SenderArgs args[SENDER_THREADS];
+	for (int i = 0; i < SENDER_THREADS; i++) {
+		args[i] = (SenderArgs){ client, "burst_server", (Pid)(i + 1) };
+		pthread_create(&threads[i], NULL, sender_thread, &args[i]);
+	}
+	for (int i = 0; i < SENDER_THREADS; i++) {
+		pthread_join(threads[i], NULL);
+	}
+
+	int expected = SENDER_THREADS * SENDS_PER_THREAD;
+	for (int i = 0; i < 200 && atomic_load(&intact_count) +
+				   atomic_load(&corrupt_count) < expected; i++) {
+		usleep(10000);
+	}
+
+	ASSERT_EQ(expected, atomic_load(&intact_count));
+	ASSERT_EQ(0, atomic_load(&corrupt_count));
+
+	NodeConnection *peer = node_get_peer(client, "burst_server");
+	ASSERT(peer != NULL);
+	ASSERT_EQ((uint64_t)expected, atomic_load(&peer->messages_sent));
+	*flushes = atomic_load(&peer->flushes);
+
+	node_stop(server);
+	node_stop(client);
+	node_free(server);
+	node_free(client);
+}
+
+/* Test 16: Concurrent senders on one connection keep frames intact */
+void test_concurrent_senders(void)
+{
+	uint64_t flushes = 0;
+	run_concurrent_senders(9117, 9118, 0, &flushes);
+	ASSERT(flushes > 0);
+	ASSERT(flushes <= SENDER_THREADS * SENDS_PER_THREAD);
+}
+
+/* Test 17: Flush delay batches queued frames into fewer writes */
+void test_flush_delay_batches(void)
+{
+	uint64_t flushes = 0;
+	run_concurrent_senders(9119, 9120, 2000, &flushes);
+	ASSERT(flushes > 0);
+	ASSERT(flushes < SENDER_THREADS * SENDS_PER_THREAD);
+}
+
+/* Test 18: The event loop notices a peer closing its end */
+void test_remote_close_detected(void)
+{
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "close_server", NODE_NAME_MAX);
+	server_cfg.port = 9121;
+	server_cfg.cookie = 0x0DDBA11;
+
+	DistributedNode *server = node_new(&server_cfg);
+	ASSERT(node_start(server));
+
+	NodeConfig client_cfg = node_config_default();
+	strncpy(client_cfg.name, "close_client", NODE_NAME_MAX);
+	client_cfg.port = 9122;
+	client_cfg.cookie = 0x0DDBA11;
+
+	DistributedNode *client = node_new(&client_cfg);
+	ASSERT(node_start(client));
+	ASSERT(node_connect(client, "close_server", "127.0.0.1", 9121));
+	usleep(100000);
+
+	ASSERT(node_is_connected(server, "close_client"));
+
+	node_disconnect(client, "close_server");
+	usleep(100000);
+
+	ASSERT(!node_is_connected(server, "close_client"));
+
+	node_stop(server);
+	node_stop(client);
+	node_free(server);
+	node_free(client);
+}
+
+/* Test 19: A peer with the wrong cookie never becomes a peer */
+void test_handshake_rejected(void)
+{
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "strict_server", NODE_NAME_MAX);
+	server_cfg.port = 9123;
+	server_cfg.cookie = 0x1111;
+
+	DistributedNode *server = node_new(&server_cfg);
+	ASSERT(node_start(server));
+
+	NodeConfig client_cfg = node_config_default();
+	strncpy(client_cfg.name, "intruder", NODE_NAME_MAX);
+	client_cfg.port = 9124;
+	client_cfg.cookie = 0x2222;
+
+	DistributedNode *client = node_new(&client_cfg);
+	ASSERT(node_start(client));
+	ASSERT(!node_connect(client, "strict_server", "127.0.0.1", 9123));
+	usleep(50000);
+
+	ASSERT_EQ(0, peer_count_of(server));
 
 	node_stop(server);
 	node_stop(client);
@@ -457,6 +691,665 @@ void test_connection_statistics(void)
 	node_free(client);
 }
 
+/* Decoded values handed over by on_value */
+#define VALUE_MESSAGES 8
+
+static Value *received_values[VALUE_MESSAGES];
+static _Atomic(int) received_value_count = 0;
+
+static void on_value_callback(void *ctx, const NodeId *from, Pid target,
+			      Value *value)
+{
+	(void)ctx;
+	(void)from;
+	(void)target;
+	int slot = atomic_load(&received_value_count);
+	if (slot < VALUE_MESSAGES) {
+		received_values[slot] = value;
+		atomic_store(&received_value_count, slot + 1);
+	} else {
+		value_free(value);
+	}
+}
+
+/* Test 20: Values are decoded in place and outlive the receive buffer */
+void test_value_receive(void)
+{
+	atomic_store(&received_value_count, 0);
+
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "value_server", NODE_NAME_MAX);
+	server_cfg.port = 9125;
+	server_cfg.cookie = 0xFEED;
+
+	DistributedNode *server = node_new(&server_cfg);
+	server->on_value = on_value_callback;
+	ASSERT(node_start(server));
+
+	NodeConfig client_cfg = node_config_default();
+	strncpy(client_cfg.name, "value_client", NODE_NAME_MAX);
+	client_cfg.port = 9126;
+	client_cfg.cookie = 0xFEED;
+
+	DistributedNode *client = node_new(&client_cfg);
+	ASSERT(node_start(client));
+	ASSERT(node_connect(client, "value_server", "127.0.0.1", 9125));
+	usleep(100000);
+
+	uint8_t chunk[4096];
+	for (int i = 0; i < VALUE_MESSAGES; i++) {
+		memset(chunk, 'a' + i, sizeof(chunk));
+		Value *blob = value_bytes(sizeof(chunk));
+		bytes_append(blob, chunk, sizeof(chunk));
+
+		Value *msg = value_map();
+		msg = map_set(msg, "seq", value_int(i));
+		msg = map_set(msg, "blob", blob);
+		ASSERT(node_send_value(client, "value_server", 7, 1, msg));
+		value_free(msg);
+	}
+
+	for (int i = 0; i < 200 && atomic_load(&received_value_count) < VALUE_MESSAGES; i++) {
+		usleep(10000);
+	}
+	ASSERT_EQ(VALUE_MESSAGES, atomic_load(&received_value_count));
+
+	/* Every blob still holds its own bytes after later frames were read */
+	for (int i = 0; i < VALUE_MESSAGES; i++) {
+		Value *msg = received_values[i];
+		ASSERT_EQ(i, map_get(msg, "seq")->as.integer);
+		Value *blob = map_get(msg, "blob");
+		ASSERT_EQ(sizeof(chunk), bytes_length(blob));
+		ASSERT_EQ('a' + i, blob->as.bytes->data[0]);
+		ASSERT_EQ('a' + i, blob->as.bytes->data[sizeof(chunk) - 1]);
+		value_free(msg);
+	}
+
+	node_stop(server);
+	node_stop(client);
+	node_free(server);
+	node_free(client);
+}
+
+/* Remote PIDs through the VM */
+
+static void emit_const(Chunk *chunk, Value *value)
+{
+	size_t idx = chunk_add_constant(chunk, value);
+	chunk_write_opcode(chunk, OP_CONST, 1);
+	chunk_write_byte(chunk, (idx >> 8) & 0xFF, 1);
+	chunk_write_byte(chunk, idx & 0xFF, 1);
+}
+
+/* send(peer, "ping"); receive() */
+static Bytecode *make_ping_code(Pid peer)
+{
+	Bytecode *code = bytecode_new();
+	emit_const(code->main, value_pid(peer));
+	emit_const(code->main, value_string("ping"));
+	chunk_write_opcode(code->main, OP_SEND, 1);
+	chunk_write_opcode(code->main, OP_POP, 1);
+	chunk_write_opcode(code->main, OP_RECEIVE, 2);
+	chunk_write_opcode(code->main, OP_POP, 2);
+	chunk_write_opcode(code->main, OP_HALT, 2);
+	return code;
+}
+
+/* send(receive().sender, 42) */
+static Bytecode *make_pong_code(void)
+{
+	Bytecode *code = bytecode_new();
+	chunk_write_opcode(code->main, OP_RECEIVE, 1);
+	emit_const(code->main, value_string("sender"));
+	chunk_write_opcode(code->main, OP_MAP_GET, 1);
+	emit_const(code->main, value_int(42));
+	chunk_write_opcode(code->main, OP_SEND, 1);
+	chunk_write_opcode(code->main, OP_POP, 1);
+	chunk_write_opcode(code->main, OP_HALT, 1);
+	return code;
+}
+
+static void *run_scheduler_thread(void *arg)
+{
+	scheduler_run((Scheduler *)arg);
+	return NULL;
+}
+
+/* Test 21: Blocks on two nodes exchange messages by PID alone; the reply
+ * goes to the sender PID carried in the frame */
+void test_remote_pid_send(void)
+{
+	SchedulerConfig sched_cfg = scheduler_config_default();
+	sched_cfg.num_workers = 2;
+
+	NodeConfig cfg_a = node_config_default();
+	strncpy(cfg_a.name, "pid_node_a", NODE_NAME_MAX);
+	cfg_a.port = 9127;
+	cfg_a.cookie = 0xACE;
+
+	NodeConfig cfg_b = node_config_default();
+	strncpy(cfg_b.name, "pid_node_b", NODE_NAME_MAX);
+	cfg_b.port = 9128;
+	cfg_b.cookie = 0xACE;
+	cfg_b.node_number = 7;
+
+	Scheduler *sched_a = scheduler_new(&sched_cfg);
+	Scheduler *sched_b = scheduler_new(&sched_cfg);
+	DistributedNode *node_a = node_new(&cfg_a);
+	DistributedNode *node_b = node_new(&cfg_b);
+	ASSERT_EQ(7, node_b->local.node_id);
+
+	ASSERT(node_attach_scheduler(node_a, sched_a));
+	ASSERT(node_attach_scheduler(node_b, sched_b));
+	ASSERT(node_start(node_a));
+	ASSERT(node_start(node_b));
+	ASSERT(node_connect(node_b, "pid_node_a", "127.0.0.1", 9127));
+	usleep(100000);
+
+	/* The handshake tells each side the other's number */
+	ASSERT_EQ(node_a->local.node_id, peer_node_id(node_b, "pid_node_a"));
+	ASSERT_EQ(7, peer_node_id(node_a, "pid_node_b"));
+
+	Bytecode *pong_code = make_pong_code();
+	Pid pong = scheduler_spawn_ex(sched_a, pong_code, "pong",
+				      CAP_SEND | CAP_RECEIVE, NULL);
+	ASSERT_EQ(node_a->local.node_id, pid_node(pong));
+	ASSERT(scheduler_pid_is_remote(sched_b, pong));
+	ASSERT(!scheduler_pid_is_remote(sched_a, pong));
+
+	Bytecode *ping_code = make_ping_code(pong);
+	Pid ping = scheduler_spawn_ex(sched_b, ping_code, "ping",
+				      CAP_SEND | CAP_RECEIVE, NULL);
+	ASSERT_EQ(7, pid_node(ping));
+
+	pthread_t thread_a, thread_b;
+	pthread_create(&thread_a, NULL, run_scheduler_thread, sched_a);
+	pthread_create(&thread_b, NULL, run_scheduler_thread, sched_b);
+
+	/* Both blocks halt only once their message has crossed the wire */
+	for (int i = 0; i < 300; i++) {
+		if (atomic_load(&sched_a->total_terminated) == 1 &&
+		    atomic_load(&sched_b->total_terminated) == 1) {
+			break;
+		}
+		usleep(10000);
+	}
+	ASSERT_EQ(1, atomic_load(&sched_a->total_terminated));
+	ASSERT_EQ(1, atomic_load(&sched_b->total_terminated));
+
+	scheduler_stop(sched_a);
+	scheduler_stop(sched_b);
+	pthread_join(thread_a, NULL);
+	pthread_join(thread_b, NULL);
+
+	ASSERT_EQ(1, atomic_load(&node_get_peer(node_a, "pid_node_b")->messages_received));
+	ASSERT_EQ(1, atomic_load(&node_get_peer(node_b, "pid_node_a")->messages_received));
+
+	/* A PID on a node nobody is connected to cannot be reached */
+	Value *msg = value_int(1);
+	ASSERT(!scheduler_send(sched_b, pid_make(9, 1), ping, msg));
+	value_free(msg);
+
+	node_stop(node_a);
+	node_stop(node_b);
+	node_free(node_a);
+	node_free(node_b);
+	scheduler_free(sched_a);
+	scheduler_free(sched_b);
+	bytecode_free(pong_code);
+	bytecode_free(ping_code);
+}
+
+/* Remote links and monitors */
+
+/* [op(target)]; halt if receive().value[key] == expected, crash otherwise */
+static Bytecode *make_expect_code(Opcode op, Pid target, const char *key,
+				  const char *expected)
+{
+	Bytecode *code = bytecode_new();
+	Chunk *chunk = code->main;
+
+	if (target != PID_INVALID) {
+		emit_const(chunk, value_pid(target));
+		chunk_write_opcode(chunk, op, 1);
+		chunk_write_opcode(chunk, OP_POP, 1);
+	}
+	chunk_write_opcode(chunk, OP_RECEIVE, 2);
+	emit_const(chunk, value_string("value"));
+	chunk_write_opcode(chunk, OP_MAP_GET, 2);
+	emit_const(chunk, value_string(key));
+	chunk_write_opcode(chunk, OP_MAP_GET, 2);
+	emit_const(chunk, value_string(expected));
+	chunk_write_opcode(chunk, OP_EQ, 2);
+	size_t ok_jump = chunk_write_jump(chunk, OP_JUMP_IF, 2);
+	chunk_write_opcode(chunk, OP_POP, 3);
+	emit_const(chunk, value_string("unexpected"));
+	chunk_write_opcode(chunk, OP_NEG, 3);
+	chunk_patch_jump(chunk, ok_jump);
+	chunk_write_opcode(chunk, OP_HALT, 4);
+	return code;
+}
+
+/* link(target); receive() */
+static Bytecode *make_linked_code(Pid target)
+{
+	Bytecode *code = bytecode_new();
+	emit_const(code->main, value_pid(target));
+	chunk_write_opcode(code->main, OP_LINK, 1);
+	chunk_write_opcode(code->main, OP_POP, 1);
+	chunk_write_opcode(code->main, OP_RECEIVE, 2);
+	chunk_write_opcode(code->main, OP_POP, 2);
+	chunk_write_opcode(code->main, OP_HALT, 2);
+	return code;
+}
+
+/* receive(); halt */
+static Bytecode *make_idle_code(void)
+{
+	Bytecode *code = bytecode_new();
+	chunk_write_opcode(code->main, OP_RECEIVE, 1);
+	chunk_write_opcode(code->main, OP_POP, 1);
+	chunk_write_opcode(code->main, OP_HALT, 1);
+	return code;
+}
+
+/* Spawn a block that stays registered after exit so its result can be read */
+static Pid spawn_retained(Scheduler *sched, Bytecode *code, CapabilitySet caps)
+{
+	Pid pid = scheduler_spawn_ex(sched, code, "retained", caps, NULL);
+	scheduler_get_block(sched, pid)->retain_on_exit = true;
+	return pid;
+}
+
+static bool wait_terminated(Scheduler *sched, size_t count)
+{
+	for (int i = 0; i < 300; i++) {
+		if (atomic_load(&sched->total_terminated) >= count) return true;
+		usleep(10000);
+	}
+	return false;
+}
+
+/* Link and monitored-by counts, read the way the runtime updates them */
+static uint32_t block_links_of(Block *block, uint32_t *watchers)
+{
+	pthread_mutex_lock(&block->link_mutex);
+	uint32_t links = block->link_count;
+	*watchers = block->monitored_by_count;
+	pthread_mutex_unlock(&block->link_mutex);
+	return links;
+}
+
+static bool exited_normally(Scheduler *sched, Pid pid)
+{
+	Block *block = scheduler_get_block(sched, pid);
+	return block && !block_is_alive(block) && block->u.exit.exit_reason == NULL;
+}
+
+static void start_node_pair(const char *name_a, uint16_t port_a, const char *name_b,
+			    uint16_t port_b, Scheduler **sched_a, Scheduler **sched_b,
+			    DistributedNode **node_a, DistributedNode **node_b)
+{
+	SchedulerConfig sched_cfg = scheduler_config_default();
+	sched_cfg.num_workers = 2;
+
+	NodeConfig cfg_a = node_config_default();
+	strncpy(cfg_a.name, name_a, NODE_NAME_MAX - 1);
+	cfg_a.port = port_a;
+	cfg_a.cookie = 0x11AC;
+	cfg_a.node_number = 3;
+
+	NodeConfig cfg_b = node_config_default();
+	strncpy(cfg_b.name, name_b, NODE_NAME_MAX - 1);
+	cfg_b.port = port_b;
+	cfg_b.cookie = 0x11AC;
+	cfg_b.node_number = 4;
+
+	*sched_a = scheduler_new(&sched_cfg);
+	*sched_b = scheduler_new(&sched_cfg);
+	*node_a = node_new(&cfg_a);
+	*node_b = node_new(&cfg_b);
+	node_attach_scheduler(*node_a, *sched_a);
+	node_attach_scheduler(*node_b, *sched_b);
+	node_start(*node_a);
+	node_start(*node_b);
+	node_connect(*node_a, name_b, "127.0.0.1", port_b);
+	usleep(100000);
+}
+
+/* Test 22: A monitor on a remote block gets its DOWN across the wire, and
+ * a monitor on a PID the remote node does not know gets "noproc" */
+void test_remote_monitor_down(void)
+{
+	Scheduler *sched_a, *sched_b;
+	DistributedNode *node_a, *node_b;
+	start_node_pair("mon_node_a", 9129, "mon_node_b", 9130,
+			&sched_a, &sched_b, &node_a, &node_b);
+	ASSERT(node_is_connected(node_a, "mon_node_b"));
+
+	Bytecode *target_code = make_idle_code();
+	Pid target = scheduler_spawn_ex(sched_b, target_code, "target", CAP_RECEIVE, NULL);
+
+	Bytecode *watcher_code = make_expect_code(OP_MONITOR, target, "reason", "normal");
+	Pid watcher = spawn_retained(sched_a, watcher_code, CAP_MONITOR | CAP_RECEIVE);
+
+	Bytecode *missing_code = make_expect_code(OP_MONITOR, pid_make(4, 9999),
+						  "reason", "noproc");
+	Pid missing = spawn_retained(sched_a, missing_code, CAP_MONITOR | CAP_RECEIVE);
+
+	pthread_t thread_a, thread_b;
+	pthread_create(&thread_a, NULL, run_scheduler_thread, sched_a);
+	pthread_create(&thread_b, NULL, run_scheduler_thread, sched_b);
+
+	/* Stop the target once the watcher is registered with it */
+	Block *target_block = scheduler_get_block(sched_b, target);
+	uint32_t watchers = 0;
+	for (int i = 0; i < 300; i++) {
+		block_links_of(target_block, &watchers);
+		if (watchers == 1) break;
+		usleep(10000);
+	}
+	ASSERT_EQ(1, watchers);
+	Value *stop = value_nil();
+	ASSERT(scheduler_send(sched_b, target, PID_INVALID, stop));
+	value_free(stop);
+
+	ASSERT(wait_terminated(sched_a, 2));
+	ASSERT(exited_normally(sched_a, watcher));
+	ASSERT(exited_normally(sched_a, missing));
+
+	scheduler_stop(sched_a);
+	scheduler_stop(sched_b);
+	pthread_join(thread_a, NULL);
+	pthread_join(thread_b, NULL);
+
+	node_stop(node_a);
+	node_stop(node_b);
+	node_free(node_a);
+	node_free(node_b);
+	scheduler_free(sched_a);
+	scheduler_free(sched_b);
+	bytecode_free(target_code);
+	bytecode_free(watcher_code);
+	bytecode_free(missing_code);
+}
+
+/* Test 23: Losing a node turns every link and monitor on its blocks into
+ * exits and downs with reason "noconnection", and node monitors hear of it */
+void test_node_down_fanout(void)
+{
+	Scheduler *sched_a, *sched_b;
+	DistributedNode *node_a, *node_b;
+	start_node_pair("fan_node_a", 9131, "fan_node_b", 9132,
+			&sched_a, &sched_b, &node_a, &node_b);
+	ASSERT(node_is_connected(node_a, "fan_node_b"));
+
+	Bytecode *remote_code = make_idle_code();
+	Pid remote = spawn_retained(sched_b, remote_code, CAP_RECEIVE);
+
+	Bytecode *trap_code = make_expect_code(OP_LINK, remote, "reason", "noconnection");
+	Pid trapper = spawn_retained(sched_a, trap_code,
+				     CAP_LINK | CAP_TRAP_EXIT | CAP_RECEIVE);
+
+	Bytecode *watch_code = make_expect_code(OP_MONITOR, remote, "reason", "noconnection");
+	Pid watcher = spawn_retained(sched_a, watch_code, CAP_MONITOR | CAP_RECEIVE);
+
+	Bytecode *linked_code = make_linked_code(remote);
+	Pid linked = spawn_retained(sched_a, linked_code, CAP_LINK | CAP_RECEIVE);
+
+	Bytecode *nodedown_code = make_expect_code(OP_NOP, PID_INVALID, "type", "nodedown");
+	Pid nodedown = spawn_retained(sched_a, nodedown_code, CAP_RECEIVE);
+	ASSERT(node_monitor(node_a, nodedown, "fan_node_b"));
+
+	pthread_t thread_a, thread_b;
+	pthread_create(&thread_a, NULL, run_scheduler_thread, sched_a);
+	pthread_create(&thread_b, NULL, run_scheduler_thread, sched_b);
+
+	Block *remote_block = scheduler_get_block(sched_b, remote);
+	uint32_t links = 0, watchers = 0;
+	for (int i = 0; i < 300; i++) {
+		links = block_links_of(remote_block, &watchers);
+		if (links == 2 && watchers == 1) break;
+		usleep(10000);
+	}
+	ASSERT_EQ(2, links);
+	ASSERT_EQ(1, watchers);
+
+	node_disconnect(node_a, "fan_node_b");
+
+	ASSERT(wait_terminated(sched_a, 4));
+	ASSERT(exited_normally(sched_a, trapper));
+	ASSERT(exited_normally(sched_a, watcher));
+	ASSERT(exited_normally(sched_a, nodedown));
+
+	/* Without trap_exit the lost link takes the block down */
+	Block *linked_block = scheduler_get_block(sched_a, linked);
+	ASSERT(!block_is_alive(linked_block));
+	ASSERT(linked_block->u.exit.exit_reason != NULL);
+
+	/* Links hold both ways: the other side loses its links to our blocks */
+	ASSERT(wait_terminated(sched_b, 1));
+	ASSERT(!block_is_alive(remote_block));
+	ASSERT(remote_block->u.exit.exit_reason != NULL);
+
+	scheduler_stop(sched_a);
+	scheduler_stop(sched_b);
+	pthread_join(thread_a, NULL);
+	pthread_join(thread_b, NULL);
+
+	node_stop(node_a);
+	node_stop(node_b);
+	node_free(node_a);
+	node_free(node_b);
+	scheduler_free(sched_a);
+	scheduler_free(sched_b);
+	bytecode_free(remote_code);
+	bytecode_free(trap_code);
+	bytecode_free(watch_code);
+	bytecode_free(linked_code);
+	bytecode_free(nodedown_code);
+}
+
+/* Liveness */
+
+typedef struct BusySender {
+	DistributedNode *node;
+	const char *peer;
+	_Atomic(bool) stop;
+} BusySender;
+
+static void *busy_sender_thread(void *arg)
+{
+	BusySender *sender = (BusySender *)arg;
+	while (!atomic_load(&sender->stop)) {
+		node_send(sender->node, sender->peer, 1, 0, "tick", 4);
+		usleep(5000);
+	}
+	return NULL;
+}
+
+/* Test 24: Idle peers stay connected on heartbeats; a peer that is sending
+ * anyway sends none */
+void test_heartbeat_idle_only(void)
+{
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "beat_server", NODE_NAME_MAX);
+	server_cfg.port = 9133;
+	server_cfg.cookie = 0xBEA7;
+	server_cfg.heartbeat_ms = 50;
+	server_cfg.timeout_ms = 200;
+
+	NodeConfig client_cfg = server_cfg;
+	strncpy(client_cfg.name, "beat_client", NODE_NAME_MAX);
+	client_cfg.port = 9134;
+
+	DistributedNode *server = node_new(&server_cfg);
+	DistributedNode *client = node_new(&client_cfg);
+	ASSERT(node_start(server));
+	ASSERT(node_start(client));
+	ASSERT(node_connect(client, "beat_server", "127.0.0.1", 9133));
+
+	/* Well past the timeout with no traffic but heartbeats */
+	usleep(500000);
+	ASSERT(node_is_connected(server, "beat_client"));
+	ASSERT(node_is_connected(client, "beat_server"));
+
+	NodeConnection *to_server = node_get_peer(client, "beat_server");
+	NodeConnection *to_client = node_get_peer(server, "beat_client");
+	pthread_mutex_lock(&to_server->send_lock);
+	ASSERT(atomic_load(&to_server->heartbeats_sent) > 0);
+	ASSERT_EQ(0, atomic_load(&to_server->messages_sent));
+	pthread_mutex_unlock(&to_server->send_lock);
+	pthread_mutex_lock(&to_client->send_lock);
+	ASSERT(atomic_load(&to_client->heartbeats_sent) > 0);
+	pthread_mutex_unlock(&to_client->send_lock);
+
+	BusySender sender = { .node = client, .peer = "beat_server" };
+	pthread_t thread;
+	pthread_create(&thread, NULL, busy_sender_thread, &sender);
+	usleep(50000);
+
+	pthread_mutex_lock(&to_server->send_lock);
+	uint64_t beats_before = atomic_load(&to_server->heartbeats_sent);
+	pthread_mutex_unlock(&to_server->send_lock);
+
+	usleep(300000);
+	atomic_store(&sender.stop, true);
+	pthread_join(thread, NULL);
+
+	pthread_mutex_lock(&to_server->send_lock);
+	ASSERT_EQ(beats_before, atomic_load(&to_server->heartbeats_sent));
+	ASSERT(atomic_load(&to_server->messages_sent) > 0);
+	pthread_mutex_unlock(&to_server->send_lock);
+	ASSERT(node_is_connected(server, "beat_client"));
+
+	node_stop(server);
+	node_stop(client);
+	node_free(server);
+	node_free(client);
+}
+
+/* Test 25: A peer that completes the handshake and then goes silent is
+ * dropped after the timeout */
+void test_silent_peer_times_out(void)
+{
+	reset_callbacks();
+
+	NodeConfig cfg = node_config_default();
+	strncpy(cfg.name, "timeout_server", NODE_NAME_MAX);
+	cfg.port = 9135;
+	cfg.cookie = 0x5EED;
+	cfg.heartbeat_ms = 50;
+	cfg.timeout_ms = 200;
+
+	DistributedNode *server = node_new(&cfg);
+	server->on_node_down = on_node_down_callback;
+	ASSERT(node_start(server));
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	struct sockaddr_in addr = {0};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(9135);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	ASSERT_EQ(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+
+	/* [type][version][cookie:8][node_number:2][name_len][name] */
+	const char *name = "mute";
+	uint8_t hello[13 + 4] = { DIST_MSG_HANDSHAKE, DIST_PROTOCOL_VERSION };
+	for (int i = 0; i < 8; i++) {
+		hello[2 + i] = (uint8_t)(cfg.cookie >> ((7 - i) * 8));
+	}
+	hello[11] = 42;
+	hello[12] = 4;
+	memcpy(hello + 13, name, 4);
+	ASSERT_EQ((ssize_t)sizeof(hello), write(fd, hello, sizeof(hello)));
+
+	usleep(100000);
+	ASSERT(node_is_connected(server, "mute"));
+
+	/* Heartbeats arrive but are never answered */
+	usleep(500000);
+	ASSERT(!node_is_connected(server, "mute"));
+	char down_name[NODE_NAME_MAX];
+	get_last_node_name(down_name);
+	ASSERT_EQ(1, atomic_load(&node_down_count));
+	ASSERT_STR_EQ("mute", down_name);
+	ASSERT(atomic_load(&node_get_peer(server, "mute")->heartbeats_sent) > 0);
+
+	close(fd);
+	node_stop(server);
+	node_free(server);
+}
+
+/* Test 26: Names that hash to one node number are refused, and an
+ * explicit node_number lets the node in */
+void test_node_number_collision(void)
+{
+	/* "node97" and "node179" fold to the same number, as do "alpha" and
+	 * "alpha24254" */
+	NodeConfig server_cfg = node_config_default();
+	strncpy(server_cfg.name, "node97", NODE_NAME_MAX);
+	server_cfg.port = 9136;
+	server_cfg.cookie = 0x3333;
+	DistributedNode *server = node_new(&server_cfg);
+	ASSERT(node_start(server));
+
+	NodeConfig twin_cfg = node_config_default();
+	strncpy(twin_cfg.name, "node179", NODE_NAME_MAX);
+	twin_cfg.port = 9137;
+	twin_cfg.cookie = 0x3333;
+	DistributedNode *twin = node_new(&twin_cfg);
+	ASSERT(node_start(twin));
+	ASSERT_EQ(node_self(server)->node_id, node_self(twin)->node_id);
+
+	/* Same number as the node it dials */
+	ASSERT(!node_connect(twin, "node97", "127.0.0.1", 9136));
+
+	NodeConfig alpha_cfg = node_config_default();
+	strncpy(alpha_cfg.name, "alpha", NODE_NAME_MAX);
+	alpha_cfg.port = 9138;
+	alpha_cfg.cookie = 0x3333;
+	DistributedNode *alpha = node_new(&alpha_cfg);
+	ASSERT(node_start(alpha));
+	ASSERT(node_connect(alpha, "node97", "127.0.0.1", 9136));
+
+	NodeConfig rival_cfg = node_config_default();
+	strncpy(rival_cfg.name, "alpha24254", NODE_NAME_MAX);
+	rival_cfg.port = 9139;
+	rival_cfg.cookie = 0x3333;
+	DistributedNode *rival = node_new(&rival_cfg);
+	ASSERT(node_start(rival));
+	ASSERT_EQ(node_self(alpha)->node_id, node_self(rival)->node_id);
+
+	/* Same number as a peer the server already has */
+	ASSERT(!node_connect(rival, "node97", "127.0.0.1", 9136));
+	usleep(50000);
+	ASSERT(node_is_connected(server, "alpha"));
+	ASSERT(!node_is_connected(server, "alpha24254"));
+	ASSERT(!node_is_connected(server, "node179"));
+
+	/* An explicit number resolves the collision */
+	NodeConfig fixed_cfg = rival_cfg;
+	fixed_cfg.port = 9140;
+	fixed_cfg.node_number = 4242;
+	DistributedNode *fixed = node_new(&fixed_cfg);
+	ASSERT(node_start(fixed));
+	ASSERT(node_connect(fixed, "node97", "127.0.0.1", 9136));
+	usleep(50000);
+	ASSERT(node_is_connected(server, "alpha24254"));
+
+	node_stop(fixed);
+	node_stop(rival);
+	node_stop(alpha);
+	node_stop(twin);
+	node_stop(server);
+	node_free(fixed);
+	node_free(rival);
+	node_free(alpha);
+	node_free(twin);
+	node_free(server);
+}
+
 int main(void)
 {
 	printf("=== E2E Distributed Node Tests ===\n\n");
@@ -476,6 +1369,17 @@ int main(void)
 	RUN_TEST(test_message_sending);
 	RUN_TEST(test_multiple_connections);
 	RUN_TEST(test_connection_statistics);
+	RUN_TEST(test_concurrent_senders);
+	RUN_TEST(test_flush_delay_batches);
+	RUN_TEST(test_remote_close_detected);
+	RUN_TEST(test_handshake_rejected);
+	RUN_TEST(test_value_receive);
+	RUN_TEST(test_remote_pid_send);
+	RUN_TEST(test_remote_monitor_down);
+	RUN_TEST(test_node_down_fanout);
+	RUN_TEST(test_heartbeat_idle_only);
+	RUN_TEST(test_silent_peer_times_out);
+	RUN_TEST(test_node_number_collision);
 
 	return TEST_RESULT();
 }
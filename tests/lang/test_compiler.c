@@ -430,6 +430,83 @@ void test_tool_params_map(void) {
     bytecode_free(code);
 }
 
+/* Superinstruction Tests */
+
+/* First opcode of the first function compiled from source */
+static int first_fn_opcode(const char *source, size_t offset) {
+    Bytecode *code = agim_compile(source, NULL);
+    if (!code || code->functions_count == 0) {
+        bytecode_free(code);
+        return -1;
+    }
+    Chunk *chunk = code->functions[0];
+    int op = offset < chunk->code_size ? chunk->code[offset] : -1;
+    bytecode_free(code);
+    return op;
+}
+
+void test_fused_add_local_local(void) {
+    printf("  Testing ADD_LOCAL_LOCAL fusion...\n");
+
+    ASSERT_EQ(OP_ADD_LOCAL_LOCAL,
+              first_fn_opcode("fn add(a, b) { return a + b }\nadd(1, 2)", 0));
+    ASSERT_EQ(42, run_and_get_int("fn add(a, b) { return a + b }\nadd(40, 2)"));
+    ASSERT_STR_EQ("foobar",
+                  run_and_get_string("fn add(a, b) { return a + b }\nadd(\"foo\", \"bar\")"));
+}
+
+void test_fused_loop(void) {
+    printf("  Testing INC_LOCAL and LT_*_JUMP_UNLESS fusion...\n");
+
+    const char *source =
+        "fn sum() {\n"
+        "    let i = 0\n"
+        "    let s = 0\n"
+        "    while i < 10 {\n"
+        "        i = i + 1\n"
+        "        s = s + i\n"
+        "    }\n"
+        "    return s\n"
+        "}\n"
+        "sum()";
+    /* Two CONSTs, the loop condition, its POP, then the increment */
+    ASSERT_EQ(OP_LT_LOCAL_CONST_JUMP_UNLESS, first_fn_opcode(source, 6));
+    ASSERT_EQ(OP_INC_LOCAL, first_fn_opcode(source, 14));
+    ASSERT_EQ(55, run_and_get_int(source));
+
+    const char *range =
+        "fn sum(n) {\n"
+        "    let s = 0\n"
+        "    for k in 0..n { s = s + k }\n"
+        "    return s\n"
+        "}\n"
+        "sum(5)";
+    ASSERT_EQ(10, run_and_get_int(range));
+}
+
+void test_fused_member(void) {
+    printf("  Testing GET_LOCAL_MAP_GET_IC fusion...\n");
+
+    const char *source =
+        "fn name(p) { return p.name }\n"
+        "name({name: \"ada\"})";
+    ASSERT_EQ(OP_GET_LOCAL_MAP_GET_IC, first_fn_opcode(source, 0));
+    ASSERT_STR_EQ("ada", run_and_get_string(source));
+}
+
+void test_fusion_stops_at_jump_target(void) {
+    printf("  Testing fusion does not cross a jump target...\n");
+
+    /* The ternary's join point lands between the two GET_LOCALs */
+    const char *fn = "fn pick(c, a, b, d) { return (c ? a : b) + d }\n";
+    char source[256];
+
+    snprintf(source, sizeof(source), "%spick(true, 1, 10, 100)", fn);
+    ASSERT_EQ(101, run_and_get_int(source));
+    snprintf(source, sizeof(source), "%spick(false, 1, 10, 100)", fn);
+    ASSERT_EQ(110, run_and_get_int(source));
+}
+
 /* Main */
 
 int main(void) {
@@ -481,6 +558,12 @@ int main(void) {
     RUN_TEST(test_tool_basic);
     RUN_TEST(test_tool_params_map);
 
+    printf("\nSuperinstruction tests:\n");
+    RUN_TEST(test_fused_add_local_local);
+    RUN_TEST(test_fused_loop);
+    RUN_TEST(test_fused_member);
+    RUN_TEST(test_fusion_stops_at_jump_target);
+
     printf("\n=================================================\n");
     return TEST_RESULT();
 }
@@ -0,0 +1,249 @@
+/*
+ * Agim - Optimizer Tests
+ *
+ * Constant folding, dead-code elimination and typed arithmetic opcodes.
+ *
+ * Copyright (c) 2025 Agim Language Contributors
+ * SPDX-License-Identifier: MIT
+ */
+
+#include "../test_common.h"
+#include "lang/agim.h"
+#include "vm/vm.h"
+#include "vm/bytecode.h"
+
+/* Run source and return its result, or NULL (printing why) on failure */
+static Value *run(const char *source, VM **out_vm, Bytecode **out_code) {
+    const char *error = NULL;
+    Bytecode *code = agim_compile(source, &error);
+    if (!code) {
+        printf("    Compile error: %s\n", error);
+        agim_error_free(error);
+        return NULL;
+    }
+
+    VM *vm = vm_new();
+    vm->reduction_limit = 1000000;
+    vm_load(vm, code);
+    VMResult result = vm_run(vm);
+
+    *out_vm = vm;
+    *out_code = code;
+    if (result != VM_OK && result != VM_HALT) {
+        printf("    Runtime error: %s\n", vm_error(vm));
+        return NULL;
+    }
+    return vm_peek(vm, 0);
+}
+
+static int64_t run_int(const char *source) {
+    VM *vm = NULL;
+    Bytecode *code = NULL;
+    Value *top = run(source, &vm, &code);
+    int64_t val = top && top->type == VAL_INT ? top->as.integer : -999999;
+    vm_free(vm);
+    bytecode_free(code);
+    return val;
+}
+
+static double run_float(const char *source) {
+    VM *vm = NULL;
+    Bytecode *code = NULL;
+    Value *top = run(source, &vm, &code);
+    double val = top && top->type == VAL_FLOAT ? top->as.floating : -999999.0;
+    vm_free(vm);
+    bytecode_free(code);
+    return val;
+}
+
+static const char *run_string(const char *source) {
+    static char buffer[256];
+    VM *vm = NULL;
+    Bytecode *code = NULL;
+    Value *top = run(source, &vm, &code);
+    if (top && top->type == VAL_STRING) {
+        strncpy(buffer, top->as.string->data, sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = '\0';
+    } else {
+        buffer[0] = '\0';
+    }
+    vm_free(vm);
+    bytecode_free(code);
+    return buffer;
+}
+
+static bool run_fails(const char *source) {
+    Bytecode *code = agim_compile(source, NULL);
+    if (!code) return false;
+
+    VM *vm = vm_new();
+    vm->reduction_limit = 1000000;
+    vm_load(vm, code);
+    VMResult result = vm_run(vm);
+
+    vm_free(vm);
+    bytecode_free(code);
+    return result != VM_OK && result != VM_HALT;
+}
+
+static bool run_nil(const char *source) {
+    VM *vm = NULL;
+    Bytecode *code = NULL;
+    Value *top = run(source, &vm, &code);
+    bool is_nil = top && value_is_nil(top);
+    vm_free(vm);
+    bytecode_free(code);
+    return is_nil;
+}
+
+/* Opcode at `offset` in main (fn < 0) or the given function chunk */
+static int opcode_at(const char *source, int fn, size_t offset) {
+    Bytecode *code = agim_compile(source, NULL);
+    if (!code || (fn >= 0 && (size_t)fn >= code->functions_count)) {
+        bytecode_free(code);
+        return -1;
+    }
+    Chunk *chunk = fn < 0 ? code->main : code->functions[fn];
+    int op = offset < chunk->code_size ? chunk->code[offset] : -1;
+    bytecode_free(code);
+    return op;
+}
+
+/* Constant Folding Tests */
+
+void test_fold_arithmetic(void) {
+    printf("  Testing arithmetic folding...\n");
+
+    /* One constant, then HALT */
+    ASSERT_EQ(OP_CONST, opcode_at("60 * 60 * 1000", -1, 0));
+    ASSERT_EQ(OP_HALT, opcode_at("60 * 60 * 1000", -1, 3));
+    ASSERT_EQ(3600000, run_int("60 * 60 * 1000"));
+    ASSERT_EQ(-7, run_int("-(10 - 3)"));
+    ASSERT_EQ(2, run_int("17 % 5 * 1"));
+    ASSERT(run_float("1.5 * 2 + 0.25") == 3.25);
+    ASSERT_EQ(1, run_int("(3 < 4) == true ? 1 : 0"));
+}
+
+void test_fold_strings(void) {
+    printf("  Testing string folding...\n");
+
+    ASSERT_EQ(OP_CONST, opcode_at("\"a\\n\" + \"b\"", -1, 0));
+    ASSERT_EQ(OP_HALT, opcode_at("\"a\\n\" + \"b\"", -1, 3));
+    ASSERT_STR_EQ("a\nb", run_string("\"a\\n\" + \"b\""));
+    ASSERT_EQ(1, run_int("\"x\" == \"x\" ? 1 : 0"));
+}
+
+void test_fold_leaves_runtime_behaviour(void) {
+    printf("  Testing folding keeps runtime semantics...\n");
+
+    /* Errors still happen at runtime */
+    ASSERT(run_fails("1 / 0"));
+    ASSERT(run_fails("1.0 / 0.0"));
+    ASSERT(run_fails("5.5 % 2"));
+
+    /* Results past the VM's 48-bit integers wrap the same way */
+    ASSERT_EQ(-140737488355328, run_int("140737488355327 + 1"));
+}
+
+void test_fold_logic(void) {
+    printf("  Testing and/or folding...\n");
+
+    /* The right side is never evaluated, so the call never happens */
+    ASSERT_EQ(OP_FALSE, opcode_at("false and missing()", -1, 0));
+    ASSERT_EQ(OP_TRUE, opcode_at("true or missing()", -1, 0));
+    ASSERT_EQ(5, run_int("nil or 5"));
+    ASSERT_EQ(6, run_int("1 and 6"));
+    ASSERT_EQ(1, run_int("!nil ? 1 : 0"));
+}
+
+/* Dead-Code Elimination Tests */
+
+void test_dce_if(void) {
+    printf("  Testing literal if pruning...\n");
+
+    const char *source = "if false { 1 } else { 2 }";
+    ASSERT_EQ(OP_CONST, opcode_at(source, -1, 0));
+    ASSERT_EQ(OP_HALT, opcode_at(source, -1, 3));
+    ASSERT_EQ(2, run_int(source));
+    ASSERT_EQ(1, run_int("if 1 { 1 } else { 2 }"));
+    ASSERT_EQ(3, run_int("if nil { 1 } else if true { 3 } else { 4 }"));
+}
+
+void test_dce_statements(void) {
+    printf("  Testing dead statement removal...\n");
+
+    /* The loop and the if leave no code behind */
+    ASSERT_EQ(OP_CONST, opcode_at("while false { x() }\nif false { y() }\n7", -1, 0));
+    ASSERT_EQ(7, run_int("while false { x() }\nif false { y() }\n7"));
+
+    /* Code after return is dropped; the function still returns */
+    const char *source =
+        "fn f() {\n"
+        "    return 1\n"
+        "    missing()\n"
+        "}\n"
+        "f()";
+    ASSERT_EQ(OP_RETURN, opcode_at(source, 0, 3));
+    ASSERT_EQ(1, run_int(source));
+
+    /* A trailing dead statement still decides the block's value */
+    ASSERT(run_nil("if true { 5\nwhile false { } }"));
+}
+
+/* Typed Arithmetic Tests */
+
+void test_typed_int(void) {
+    printf("  Testing int-only opcodes...\n");
+
+    const char *source = "fn area(w: int, h: int) { return w * h }\narea(6, 7)";
+    ASSERT_EQ(OP_MUL_INT, opcode_at(source, 0, 6));
+    ASSERT_EQ(42, run_int(source));
+
+    /* The hint is not trusted: other operands take the generic path */
+    ASSERT(run_float("fn area(w: int, h: int) { return w * h }\narea(1.5, 2.0)") == 3.0);
+    const char *concat = "fn thrice(a: int) { return a + a + a }\nthrice(\"ab\")";
+    ASSERT_EQ(OP_ADD_INT, opcode_at(concat, 0, 8));
+    ASSERT_STR_EQ("ababab", run_string(concat));
+}
+
+void test_typed_float(void) {
+    printf("  Testing float-only opcodes...\n");
+
+    const char *source = "fn ratio(a: float, b: float) { return a / b }\nratio(1.0, 4.0)";
+    ASSERT_EQ(OP_DIV_FLOAT, opcode_at(source, 0, 6));
+    ASSERT(run_float(source) == 0.25);
+    ASSERT(run_fails("fn ratio(a: float, b: float) { return a / b }\nratio(1.0, 0.0)"));
+    ASSERT_EQ(5, run_int("fn ratio(a: float, b: float) { return a / b }\nratio(10, 2)"));
+}
+
+void test_typed_untyped(void) {
+    printf("  Testing untyped operands keep generic opcodes...\n");
+
+    ASSERT_EQ(OP_MUL, opcode_at("fn f(a, b) { return a * b }\nf(2, 3)", 0, 6));
+    ASSERT_EQ(OP_MUL, opcode_at("fn f(a: int, b: float) { return a * b }\nf(2, 3.0)", 0, 6));
+}
+
+int main(void) {
+    printf("\n");
+    printf("=================================================\n");
+    printf("Agim Optimizer Tests\n");
+    printf("=================================================\n\n");
+
+    printf("Constant folding tests:\n");
+    RUN_TEST(test_fold_arithmetic);
+    RUN_TEST(test_fold_strings);
+    RUN_TEST(test_fold_leaves_runtime_behaviour);
+    RUN_TEST(test_fold_logic);
+
+    printf("\nDead-code elimination tests:\n");
+    RUN_TEST(test_dce_if);
+    RUN_TEST(test_dce_statements);
+
+    printf("\nTyped arithmetic tests:\n");
+    RUN_TEST(test_typed_int);
+    RUN_TEST(test_typed_float);
+    RUN_TEST(test_typed_untyped);
+
+    printf("\n=================================================\n");
+    return TEST_RESULT();
+}
@@ -284,6 +284,61 @@ void test_mutual_recursion(void) {
     ASSERT_EQ(1, run_program(source));
 }
 
+void test_tail_calls(void) {
+    printf("  Testing tail calls run in constant frames...\n");
+
+    /* Far deeper than the frame limit allows for ordinary calls */
+    const char *loop =
+        "fn loop(n, acc) {\n"
+        "    if n == 0 { return acc }\n"
+        "    return loop(n - 1, acc + n)\n"
+        "}\n"
+        "loop(100000, 0)";
+    ASSERT_EQ(5000050000, run_program(loop));
+
+    const char *mutual =
+        "fn is_even(n) {\n"
+        "    if n == 0 { return 1 }\n"
+        "    return is_odd(n - 1)\n"
+        "}\n"
+        "fn is_odd(n) {\n"
+        "    if n == 0 { return 0 }\n"
+        "    return is_even(n - 1)\n"
+        "}\n"
+        "is_even(50001)";
+    ASSERT_EQ(0, run_program(mutual));
+
+    /* The same depth without a tail call hits the frame limit cleanly */
+    const char *deep =
+        "fn depth(n) {\n"
+        "    if n == 0 { return 0 }\n"
+        "    return 1 + depth(n - 1)\n"
+        "}\n"
+        "depth(100000)";
+    ASSERT_EQ(-999999, run_program(deep));
+
+    /* A tail call with more locals than the caller, and the frames never grow */
+    Bytecode *code = agim_compile(
+        "fn step(n) {\n"
+        "    let a = n - 1\n"
+        "    let b = a\n"
+        "    if b <= 0 { return b }\n"
+        "    return spin(b, 1, 2)\n"
+        "}\n"
+        "fn spin(n, x, y) { return step(n) }\n"
+        "step(20000)", NULL);
+    ASSERT(code != NULL);
+    VM *vm = vm_new();
+    vm->reduction_limit = 10000000;
+    vm_load(vm, code);
+    VMResult result = vm_run(vm);
+    ASSERT(result == VM_OK || result == VM_HALT);
+    ASSERT_EQ(0, vm_peek(vm, 0)->as.integer);
+    ASSERT_EQ(VM_FRAMES_INITIAL, vm->frames_capacity);
+    vm_free(vm);
+    bytecode_free(code);
+}
+
 /* Map Tests */
 
 void test_map_operations(void) {
@@ -381,6 +436,7 @@ int main(void) {
     printf("\nFunctions:\n");
     RUN_TEST(test_higher_order);
     RUN_TEST(test_mutual_recursion);
+    RUN_TEST(test_tail_calls);
 
     printf("\nMaps:\n");
     RUN_TEST(test_map_operations);
@@ -1,7 +1,8 @@
 /*
  * Agim - Register Compiler Tests
  *
- * Tests the register bytecode compiler by building AST nodes directly.
+ * Tests the register bytecode compiler by building AST nodes directly,
+ * and whole programs compiled from source.
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -9,10 +10,16 @@
 
 #include "../test_common.h"
 #include "lang/ast.h"
+#include "lang/agim.h"
 #include "lang/regcompiler.h"
+#include "runtime/block.h"
+#include "runtime/scheduler.h"
+#include "vm/nanbox_convert.h"
 #include "vm/regvm.h"
 #include "vm/value.h"
 
+#include <string.h>
+
 #include <math.h>
 
 /* Helper Functions */
@@ -35,6 +42,50 @@ static NanValue run_chunk(RegChunk *chunk) {
     return ret;
 }
 
+/* Compile source and run it to completion, resuming after each slice.
+ * An object result outlives the VM; the caller frees it. */
+static NanValue run_source(const char *source, size_t reduction_limit, int *slices) {
+    const char *error = NULL;
+    RegChunk *program = agim_compile_reg(source, &error);
+    if (!program) {
+        printf("  compile error: %s\n", error ? error : "?");
+        agim_error_free(error);
+        return NANBOX_NIL;
+    }
+
+    RegVM *vm = regvm_new();
+    regvm_load(vm, program, program);
+    vm->reduction_limit = reduction_limit;
+
+    RegVMResult result;
+    int count = 0;
+    do {
+        vm->reductions = 0;
+        result = regvm_resume(vm);
+        count++;
+    } while (result == REGVM_YIELD);
+
+    NanValue ret = NANBOX_NIL;
+    if (result == REGVM_OK || result == REGVM_HALT) {
+        ret = vm->result;
+        if (nanbox_is_obj(ret)) {
+            ret = value_to_nanbox(value_copy((Value *)nanbox_as_obj(ret)));
+        }
+    } else {
+        printf("  runtime error: %s\n", regvm_error(vm) ? regvm_error(vm) : "?");
+    }
+    if (slices) *slices = count;
+
+    regvm_free(vm);
+    regchunk_free(program);
+    return ret;
+}
+
+static int64_t run_source_int(const char *source) {
+    NanValue v = run_source(source, 1000000, NULL);
+    return nanbox_is_int(v) ? nanbox_as_int(v) : -1;
+}
+
 /* Expression Tests */
 
 void test_compile_int_literal(void) {
@@ -344,6 +395,174 @@ void test_code_generated(void) {
     ast_free(ast);
 }
 
+/* Program Tests */
+
+void test_program_functions(void) {
+    ASSERT_EQ(610, run_source_int(
+        "fn fib(n) {\n"
+        "    if n < 2 { return n }\n"
+        "    return fib(n - 1) + fib(n - 2)\n"
+        "}\n"
+        "fib(15)\n"));
+
+    /* Self tail calls reuse the frame, so depth is not limited by frames */
+    ASSERT_EQ(50005000, run_source_int(
+        "fn sum(n, acc) {\n"
+        "    if n == 0 { return acc }\n"
+        "    return sum(n - 1, acc + n)\n"
+        "}\n"
+        "sum(10000, 0)\n"));
+}
+
+void test_program_loops(void) {
+    ASSERT_EQ(25, run_source_int(
+        "let total = 0\n"
+        "for i in 0..10 {\n"
+        "    if i == 3 { continue }\n"
+        "    if i == 8 { break }\n"
+        "    total += i\n"
+        "}\n"
+        "total\n"));
+
+    ASSERT_EQ(15, run_source_int(
+        "fn f() {\n"
+        "    let arr = [1, 2, 3, 4]\n"
+        "    push(arr, 5)\n"
+        "    let s = 0\n"
+        "    for x in arr { s = s + x }\n"
+        "    let n = 0\n"
+        "    while n < len(arr) { n += 1 }\n"
+        "    return s + n - len(arr)\n"
+        "}\n"
+        "f()\n"));
+
+    /* push() on a global writes the grown array back */
+    ASSERT_EQ(4, run_source_int(
+        "let arr = [1, 2, 3]\n"
+        "push(arr, 4)\n"
+        "len(arr)\n"));
+
+    /* Writes through an alias copy a frozen container and leave it intact */
+    ASSERT_EQ(231, run_source_int(
+        "fn f() {\n"
+        "    let a = freeze([1, 2])\n"
+        "    let b = a\n"
+        "    push(b, 3)\n"
+        "    b[0] = 10\n"
+        "    return len(a) * 100 + len(b) * 10 + a[0]\n"
+        "}\n"
+        "f()\n"));
+    ASSERT_EQ(12, run_source_int(
+        "fn g() {\n"
+        "    let m = freeze({x: 1})\n"
+        "    let n = m\n"
+        "    n.y = 2\n"
+        "    return m.x * 10 + n.y\n"
+        "}\n"
+        "g()\n"));
+}
+
+void test_program_match(void) {
+    ASSERT_EQ(42, run_source_int(
+        "fn div(a, b) {\n"
+        "    if b == 0 { return err(\"div by zero\") }\n"
+        "    return ok(a / b)\n"
+        "}\n"
+        "fn twice(a, b) {\n"
+        "    let q = try div(a, b)\n"
+        "    return ok(q * 2)\n"
+        "}\n"
+        "let a = match twice(42, 2) { ok(v) => v, err(e) => 0 }\n"
+        "let b = match twice(1, 0) { ok(v) => 100, err(e) => len(e) }\n"
+        "a + b - 11\n"));
+
+    ASSERT_EQ(13, run_source_int(
+        "enum Shape { Circle(int), Empty }\n"
+        "fn area(s) {\n"
+        "    return match s {\n"
+        "        Circle(r) => r * r * 3\n"
+        "        Empty => 1\n"
+        "    }\n"
+        "}\n"
+        "let o = some(0)\n"
+        "let z = match o { some(v) => v, none => 99 }\n"
+        "area(Shape::Circle(2)) + area(Shape::Empty) + z\n"));
+}
+
+void test_program_structs_and_builtins(void) {
+    NanValue v = run_source(
+        "struct P { x: int, y: int }\n"
+        "let p = P { x: 3, y: 4 }\n"
+        "let m = {a: 1, b: \"two\"}\n"
+        "m.a = m.a + p.x * p.y\n"
+        "str(m.a) + m[\"b\"]\n", 1000000, NULL);
+    ASSERT(nanbox_is_obj(v));
+    Value *s = (Value *)nanbox_as_obj(v);
+    ASSERT(value_is_string(s));
+    ASSERT_STR_EQ("13two", s->as.string->data);
+    value_free(s);
+}
+
+void test_program_preemption(void) {
+    /* A small budget splits the loop into many slices with the same result */
+    int slices = 0;
+    NanValue v = run_source(
+        "let n = 0\n"
+        "while n < 1000 { n += 1 }\n"
+        "n\n", 100, &slices);
+    ASSERT(nanbox_is_int(v));
+    ASSERT_EQ(1000, nanbox_as_int(v));
+    ASSERT(slices >= 10);
+}
+
+void test_program_compile_errors(void) {
+    const char *error = NULL;
+    ASSERT(agim_compile_reg("break\n", &error) == NULL);
+    ASSERT(error != NULL);
+    ASSERT(strstr(error, "break outside of loop") != NULL);
+    agim_error_free(error);
+
+    error = NULL;
+    ASSERT(agim_compile_reg("fn f() {\n    const x = 1\n    x = 2\n}\n", &error) == NULL);
+    ASSERT(error != NULL);
+    ASSERT(strstr(error, "cannot assign to constant") != NULL);
+    agim_error_free(error);
+}
+
+void test_program_spawn_receive(void) {
+    /* Blocks running register code exchange messages under the scheduler */
+    RegChunk *program = agim_compile_reg(
+        "fn worker() {\n"
+        "    let msg = receive()\n"
+        "    send(msg.sender, msg.value + 1)\n"
+        "}\n"
+        "let pid = spawn(worker)\n"
+        "send(pid, 41)\n"
+        "receive().value\n", NULL);
+    ASSERT(program != NULL);
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 0;
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_reg(sched, program, program, "main",
+                                  CAP_SPAWN | CAP_SEND | CAP_RECEIVE, NULL);
+    ASSERT(pid != PID_INVALID);
+    Block *main_block = scheduler_get_block(sched, pid);
+    main_block->retain_on_exit = true;
+
+    scheduler_run(sched);
+
+    ASSERT(main_block->regvm != NULL);
+    ASSERT(main_block->regvm->error == NULL);
+    ASSERT(nanbox_is_int(main_block->regvm->result));
+    ASSERT_EQ(42, nanbox_as_int(main_block->regvm->result));
+
+    scheduler_free(sched);
+    regchunk_free(program);
+}
+
 /* Main */
 
 int main(void) {
@@ -369,5 +588,13 @@ int main(void) {
     RUN_TEST(test_registers_allocated);
     RUN_TEST(test_code_generated);
 
+    RUN_TEST(test_program_functions);
+    RUN_TEST(test_program_loops);
+    RUN_TEST(test_program_match);
+    RUN_TEST(test_program_structs_and_builtins);
+    RUN_TEST(test_program_preemption);
+    RUN_TEST(test_program_compile_errors);
+    RUN_TEST(test_program_spawn_receive);
+
     return TEST_RESULT();
 }
@@ -6,6 +6,7 @@
  * - block_send to dead block
  * - block_send COW for arrays
  * - block_send COW for maps
+ * - block_send shares frozen values and large bytes
  * - block_send copies closures
  * - block_receive pops message
  * - block_receive empty returns NULL
@@ -20,6 +21,8 @@
 #include "runtime/mailbox.h"
 #include "vm/value.h"
 
+#include <string.h>
+
 /*
  * Test: Block starts with empty mailbox
  */
@@ -248,6 +251,76 @@ void test_send_map_cow(void) {
     block_free(target);
 }
 
+/*
+ * Test: a frozen tree is sent by refcount alone, to every receiver
+ */
+void test_send_frozen_shares(void) {
+    Block *a = block_new(1, "a", NULL);
+    Block *b = block_new(2, "b", NULL);
+
+    Value *doc = value_map();
+    Value *items = value_array();
+    items = array_push(items, value_int(1));
+    doc = map_set(doc, "items", items);
+    ASSERT(value_freeze(doc));
+
+    ASSERT(block_send(a, 3, doc));
+    ASSERT(block_send(b, 3, doc));
+    ASSERT_EQ(3, atomic_load(&doc->refcount));
+    ASSERT(!(doc->flags & VALUE_COW_SHARED));
+
+    Message *got_a = block_receive(a);
+    Message *got_b = block_receive(b);
+    ASSERT(got_a->value == doc);
+    ASSERT(got_b->value == doc);
+
+    /* A receiver that writes gets its own copy */
+    Value *mine = map_set(got_a->value, "extra", value_int(2));
+    ASSERT(mine != doc);
+    ASSERT(map_get(doc, "extra") == NULL);
+    ASSERT_EQ(2, atomic_load(&doc->refcount));
+    got_a->value = mine;
+
+    message_free(got_a);
+    message_free(got_b);
+    value_free(doc);
+    block_free(a);
+    block_free(b);
+}
+
+/*
+ * Test: large bytes are moved off-heap once and borrowed by each send
+ */
+void test_send_large_bytes_shares(void) {
+    Block *a = block_new(1, "a", NULL);
+    Block *b = block_new(2, "b", NULL);
+
+    uint8_t payload[1024];
+    memset(payload, 'd', sizeof(payload));
+    Value *bytes = value_bytes(sizeof(payload));
+    ASSERT(bytes_append(bytes, payload, sizeof(payload)));
+
+    ASSERT(block_send(a, 3, bytes));
+    ASSERT(block_send(b, 3, bytes));
+
+    SharedBuffer *buf = bytes->as.bytes->shared;
+    ASSERT(buf != NULL);
+    ASSERT_EQ(3, atomic_load(&buf->refcount));
+
+    Message *got_a = block_receive(a);
+    Message *got_b = block_receive(b);
+    ASSERT(got_a->value->as.bytes->data == bytes->as.bytes->data);
+    ASSERT(got_b->value->as.bytes->data == bytes->as.bytes->data);
+    ASSERT_EQ(1024, bytes_length(got_b->value));
+
+    message_free(got_a);
+    message_free(got_b);
+    ASSERT_EQ(1, atomic_load(&buf->refcount));
+    value_free(bytes);
+    block_free(a);
+    block_free(b);
+}
+
 /*
  * Test: block_receive returns NULL for empty mailbox
  */
@@ -608,6 +681,8 @@ int main(void) {
     printf("\nCOW tests:\n");
     RUN_TEST(test_send_array_cow);
     RUN_TEST(test_send_map_cow);
+    RUN_TEST(test_send_frozen_shares);
+    RUN_TEST(test_send_large_bytes_shares);
 
     printf("\nblock_receive tests:\n");
     RUN_TEST(test_receive_empty_returns_null);
@@ -113,6 +113,43 @@ void test_bytecode_functions(void) {
     bytecode_free(code);
 }
 
+void test_bytecode_globals(void) {
+    Bytecode *code = bytecode_new();
+
+    ASSERT_EQ(0, bytecode_add_global(code, "counter"));
+    ASSERT_EQ(1, bytecode_add_global(code, "main"));
+    ASSERT_EQ(0, bytecode_add_global(code, "counter")); /* Same slot */
+    ASSERT_STR_EQ("main", bytecode_get_global(code, 1));
+    ASSERT(bytecode_get_global(code, 2) == NULL);
+
+    size_t slot = 0;
+    ASSERT(bytecode_find_global(code, "main", &slot));
+    ASSERT_EQ(1, slot);
+    ASSERT(!bytecode_find_global(code, "missing", &slot));
+
+    /* The slot table survives a round trip */
+    bytecode_add_string(code, "label");
+    size_t size = 0;
+    uint8_t *data = bytecode_serialize(code, &size);
+    Bytecode *loaded = bytecode_deserialize(data, size);
+    ASSERT(loaded != NULL);
+    ASSERT_EQ(2, loaded->globals_count);
+    ASSERT_STR_EQ("counter", bytecode_get_global(loaded, 0));
+    ASSERT_STR_EQ("main", bytecode_get_global(loaded, 1));
+    bytecode_free(loaded);
+
+    /* Version 1 files named globals by string index */
+    data[7] = 1;
+    loaded = bytecode_deserialize(data, size);
+    ASSERT(loaded != NULL);
+    ASSERT_EQ(1, loaded->globals_count);
+    ASSERT_STR_EQ("label", bytecode_get_global(loaded, 0));
+    bytecode_free(loaded);
+
+    free(data);
+    bytecode_free(code);
+}
+
 int main(void) {
     RUN_TEST(test_chunk_create);
     RUN_TEST(test_chunk_write);
@@ -121,6 +158,7 @@ int main(void) {
     RUN_TEST(test_bytecode_create);
     RUN_TEST(test_bytecode_strings);
     RUN_TEST(test_bytecode_functions);
+    RUN_TEST(test_bytecode_globals);
 
     return TEST_RESULT();
 }
@@ -295,6 +295,68 @@ void test_mark_shared(void) {
     value_free(arr);
 }
 
+/* Freeze Tests */
+
+void test_freeze_deep(void) {
+    Value *inner = value_map();
+    inner = map_set(inner, "n", value_int(1));
+    Value *arr = value_array();
+    arr = array_push(arr, inner);
+    arr = array_push(arr, value_string("s"));
+
+    ASSERT(value_freeze(arr));
+    ASSERT(value_is_immutable(arr));
+    ASSERT(value_is_immutable(inner));
+
+    /* Writes copy, and consume the reference they were handed */
+    Value *copy = array_push(value_retain(arr), value_int(2));
+    ASSERT(copy != arr);
+    ASSERT_EQ(2, array_length(arr));
+    ASSERT_EQ(3, array_length(copy));
+    ASSERT(!value_is_immutable(copy));
+    ASSERT_EQ(1, arr->refcount);
+
+    Value *inner_copy = map_set(value_retain(inner), "n", value_int(5));
+    ASSERT(inner_copy != inner);
+    ASSERT_EQ(1, map_get(inner, "n")->as.integer);
+
+    value_free(inner_copy);
+    value_free(copy);
+    value_free(arr);
+}
+
+void test_freeze_write_releases_original(void) {
+    /* The only reference to a frozen value goes to the copy; under ASan a
+     * leaked original fails the run */
+    Value *arr = value_array();
+    arr = array_push(arr, value_string("kept"));
+    ASSERT(value_freeze(arr));
+    arr = array_push(arr, value_int(2));
+    ASSERT(!value_is_immutable(arr));
+    ASSERT_EQ(2, array_length(arr));
+    ASSERT_STR_EQ("kept", array_get(arr, 0)->as.string->data);
+
+    Value *map = value_map();
+    map = map_set(map, "a", value_int(1));
+    ASSERT(value_freeze(map));
+    map = map_set(map, "b", value_int(2));
+    ASSERT(!value_is_immutable(map));
+    ASSERT_EQ(2, map_size(map));
+
+    value_free(map);
+    value_free(arr);
+}
+
+void test_freeze_rejects_struct(void) {
+    Value *arr = value_array();
+    arr = array_push(arr, value_struct_new("Point", 2));
+
+    ASSERT(!value_freeze(arr));
+    ASSERT(!value_is_immutable(arr));
+
+    value_free(arr);
+}
+
 /* Main */
 
 int main(void) {
@@ -320,5 +382,10 @@ int main(void) {
     RUN_TEST(test_can_share);
     RUN_TEST(test_mark_shared);
 
+    /* Freeze tests */
+    RUN_TEST(test_freeze_deep);
+    RUN_TEST(test_freeze_write_releases_original);
+    RUN_TEST(test_freeze_rejects_struct);
+
     return TEST_RESULT();
 }
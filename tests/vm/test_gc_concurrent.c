@@ -13,6 +13,7 @@
  * - value_retain during sweep
  * - value_release races
  * - COW during GC
+ * - Allocation from a shared heap
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -28,7 +29,9 @@
 #define _DEFAULT_SOURCE  /* For usleep */
 #include <pthread.h>
 #include <stdatomic.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 
@@ -809,6 +812,74 @@ void test_write_barrier_concurrent(void) {
     ASSERT_EQ(0, atomic_load(&test_errors));
 }
 
+/* ========== Test: Shared Heap Allocation ========== */
+
+#define SHARED_ALLOCS_PER_THREAD 5000
+
+typedef struct {
+    Heap *heap;
+    Value **values;
+} SharedAllocArgs;
+
+static int compare_pointers(const void *a, const void *b) {
+    uintptr_t x = (uintptr_t)*(Value *const *)a;
+    uintptr_t y = (uintptr_t)*(Value *const *)b;
+    return (x > y) - (x < y);
+}
+
+static void *shared_alloc_thread(void *arg) {
+    SharedAllocArgs *args = (SharedAllocArgs *)arg;
+
+    wait_for_start();
+
+    for (int i = 0; i < SHARED_ALLOCS_PER_THREAD; i++) {
+        args->values[i] = heap_alloc(args->heap, VAL_INT);
+    }
+
+    return NULL;
+}
+
+void test_shared_heap_alloc(void) {
+    printf("  Testing allocation from one heap on many threads...\n");
+    reset_sync();
+
+    GCConfig config = gc_config_default();
+    config.initial_heap_size = 1024 * 1024;
+    config.max_heap_size = 16 * 1024 * 1024;
+    Heap *heap = heap_new(&config);
+
+    static Value *values[NUM_THREADS * SHARED_ALLOCS_PER_THREAD];
+    pthread_t threads[NUM_THREADS];
+    SharedAllocArgs args[NUM_THREADS];
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        args[i].heap = heap;
+        args[i].values = &values[i * SHARED_ALLOCS_PER_THREAD];
+        pthread_create(&threads[i], NULL, shared_alloc_thread, &args[i]);
+    }
+
+    signal_start(NUM_THREADS);
+
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Every allocation got its own slot */
+    size_t total = NUM_THREADS * SHARED_ALLOCS_PER_THREAD;
+    qsort(values, total, sizeof(Value *), compare_pointers);
+    int missing = 0, duplicates = 0;
+    for (size_t i = 0; i < total; i++) {
+        if (!values[i]) missing++;
+        if (i > 0 && values[i] == values[i - 1]) duplicates++;
+    }
+    ASSERT_EQ(0, missing);
+    ASSERT_EQ(0, duplicates);
+    ASSERT_EQ(total * sizeof(Value), heap_used(heap));
+
+    heap_free(heap);
+    #undef SHARED_ALLOCS_PER_THREAD
+}
+
 /* ========== Main ========== */
 
 int main(void) {
@@ -844,6 +915,9 @@ int main(void) {
     /* Write barrier concurrent */
     RUN_TEST(test_write_barrier_concurrent);
 
+    /* Shared heap allocation */
+    RUN_TEST(test_shared_heap_alloc);
+
     printf("\n");
     return TEST_RESULT();
 }
@@ -11,6 +11,7 @@
  * - Full collection
  * - needs_full_gc flag
  * - young_gc_threshold adjustment
+ * - Bump-allocated nursery
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -739,6 +740,130 @@ void test_gc_stats_track_minor_major(void) {
     heap_free(heap);
 }
 
+/* ============================================================================
+ * Nursery Tests
+ * ============================================================================ */
+
+void test_nursery_bump_allocates_adjacent_slots(void) {
+    GCConfig config = gc_config_default();
+    Heap *heap = heap_new(&config);
+
+    Value *v1 = heap_alloc(heap, VAL_INT);
+    Value *v2 = heap_alloc(heap, VAL_STRING);
+    Value *v3 = heap_alloc(heap, VAL_INT);
+
+    /* Headers come from consecutive slots of one chunk */
+    ASSERT(v2 == v1 + 1);
+    ASSERT(v3 == v2 + 1);
+    ASSERT_EQ(1, heap->nursery_chunks);
+
+    heap_free(heap);
+}
+
+void test_nursery_constructs_compound_values_in_place(void) {
+    GCConfig config = gc_config_default();
+    Heap *heap = heap_new(&config);
+
+    Value *str = heap_alloc(heap, VAL_STRING);
+    Value *map = heap_alloc(heap, VAL_MAP);
+    ASSERT(map == str + 1);
+
+    ASSERT_EQ(VAL_STRING, str->type);
+    ASSERT_EQ(0, str->as.string->length);
+    ASSERT(str->flags & VALUE_IMMUTABLE);
+    ASSERT(str->flags & VALUE_NURSERY);
+    ASSERT_EQ(1, atomic_load(&str->refcount));
+
+    ASSERT_EQ(VAL_MAP, map->type);
+    ASSERT_EQ(0, map_size(map));
+    ASSERT(map->flags & VALUE_NURSERY);
+
+    /* A type the heap cannot build hands its slot straight back */
+    ASSERT(heap_alloc(heap, VAL_CLOSURE) == NULL);
+    ASSERT(heap_alloc(heap, VAL_INT) == map + 1);
+
+    heap_free(heap);
+}
+
+void test_nursery_rewinds_after_minor_gc(void) {
+    GCConfig config = gc_config_default();
+    Heap *heap = heap_new(&config);
+    VM *vm = vm_new();
+
+    gc_set_generational(heap, true);
+
+    Value *first = heap_alloc(heap, VAL_INT);
+    value_release(first);
+    for (int i = 0; i < 1000; i++) {
+        value_release(heap_alloc(heap, VAL_INT));
+    }
+    ASSERT(heap->nursery_chunks > 1);
+
+    gc_collect_young(heap, vm);
+
+    /* Everything died, so the nursery is back to a single empty chunk */
+    ASSERT_EQ(0, heap->young_count);
+    ASSERT(heap->objects == NULL);
+    ASSERT_EQ(1, heap->nursery_chunks);
+
+    Value *next = heap_alloc(heap, VAL_INT);
+    ASSERT(next != NULL);
+    ASSERT_EQ(1, heap->young_count);
+
+    vm_free(vm);
+    heap_free(heap);
+}
+
+void test_promoted_object_leaves_young_list(void) {
+    GCConfig config = gc_config_default();
+    Heap *heap = heap_new(&config);
+    VM *vm = vm_new();
+
+    gc_set_generational(heap, true);
+
+    Value *survivor = heap_alloc(heap, VAL_ARRAY);
+    vm_push(vm, survivor);
+
+    for (int i = 0; i < heap->promotion_threshold; i++) {
+        gc_collect_young(heap, vm);
+    }
+
+    /* Promoted in place: same address, now on the old list */
+    ASSERT(value_is_old_gen(survivor));
+    ASSERT(heap->objects == NULL);
+    ASSERT(heap->old_objects == survivor);
+
+    /* Minor collections no longer visit it */
+    Value *garbage = heap_alloc(heap, VAL_INT);
+    value_release(garbage);
+    gc_collect_young(heap, vm);
+    ASSERT(heap->old_objects == survivor);
+    ASSERT_EQ(0, heap->young_count);
+
+    value_release(survivor);
+    vm_free(vm);
+    heap_free(heap);
+}
+
+void test_value_free_on_nursery_object(void) {
+    GCConfig config = gc_config_default();
+    Heap *heap = heap_new(&config);
+    VM *vm = vm_new();
+
+    Value *s = heap_alloc(heap, VAL_STRING);
+    size_t before = heap->bytes_allocated;
+
+    /* Dropping the last reference frees the payload; the sweep reclaims the slot */
+    value_free(s);
+    gc_collect(heap, vm);
+
+    ASSERT(heap->bytes_allocated < before);
+    ASSERT(heap->objects == NULL);
+
+    vm_free(vm);
+    heap_free(heap);
+}
+
 /* ============================================================================
  * Main
  * ============================================================================ */
@@ -792,5 +917,12 @@ int main(void) {
     RUN_TEST(test_promotion_with_children);
     RUN_TEST(test_gc_stats_track_minor_major);
 
+    /* Nursery */
+    RUN_TEST(test_nursery_bump_allocates_adjacent_slots);
+    RUN_TEST(test_nursery_constructs_compound_values_in_place);
+    RUN_TEST(test_nursery_rewinds_after_minor_gc);
+    RUN_TEST(test_promoted_object_leaves_young_list);
+    RUN_TEST(test_value_free_on_nursery_object);
+
     return TEST_RESULT();
 }
@@ -276,19 +276,32 @@ void test_mark_roots_marks_stack(void) {
 
 void test_mark_roots_marks_globals(void) {
     VM *vm = vm_new();
+    Bytecode *code = bytecode_new();
+    bytecode_add_global(code, "x");
+    bytecode_add_global(code, "y");
+    vm_load(vm, code);
 
     /* Set up globals */
-    vm->globals = value_map();
-    vm->globals = map_set(vm->globals, "x", value_int(42));
-    vm->globals = map_set(vm->globals, "y", value_string("test"));
+    Value *y = value_string("test");
+    Value *state = value_map();
+    state = map_set(state, "x", value_int(42));
+    state = map_set(state, "y", y);
+    vm_restore_globals(vm, state);
+
+    /* Pending globals (restored before any code is loaded) are roots too */
+    VM *fresh = vm_new();
+    Value *pending = value_map();
+    vm_restore_globals(fresh, pending);
 
     gc_mark_roots(vm);
+    gc_mark_roots(fresh);
 
-    ASSERT(value_is_marked(vm->globals));
-    ASSERT(value_is_marked(map_get(vm->globals, "x")));
-    ASSERT(value_is_marked(map_get(vm->globals, "y")));
+    ASSERT(value_is_marked(y));
+    ASSERT(value_is_marked(pending));
 
+    vm_free(fresh);
     vm_free(vm);
+    bytecode_free(code);
 }
 
 void test_mark_roots_marks_constants(void) {
@@ -5,7 +5,7 @@
  * - Multiple producers single consumer (MPSC)
  * - Producer consumer interleaving
  * - Stub node handling
- * - Atomic ordering
+ * - Atomic ordering, for single and batch pops
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -471,6 +471,7 @@ typedef struct {
     _Atomic(int64_t) *last_seen;
     _Atomic(int) *out_of_order;
     int producer_id;
+    bool batch;
 } OrderingArgs;
 
 static void *ordering_producer(void *arg) {
@@ -505,8 +506,23 @@ static void *ordering_consumer(void *arg) {
     int attempts = 0;
 
     while (received < TOTAL_MESSAGES && attempts < max_attempts) {
-        Message *msg = mailbox_pop(args->mailbox);
-        if (msg) {
+        Message *batch[16];
+        size_t taken;
+        if (args->batch) {
+            taken = mailbox_pop_batch(args->mailbox, batch, 16);
+        } else {
+            batch[0] = mailbox_pop(args->mailbox);
+            taken = batch[0] ? 1 : 0;
+        }
+
+        if (taken == 0) {
+            sched_yield();
+            attempts++;
+            continue;
+        }
+
+        for (size_t i = 0; i < taken; i++) {
+            Message *msg = batch[i];
             int64_t value = msg->value->as.integer;
             int producer = (int)(value / 1000000);
             int64_t seq = value % 1000000;
@@ -522,17 +538,13 @@ static void *ordering_consumer(void *arg) {
 
             received++;
             message_free(msg);
-        } else {
-            sched_yield();
-            attempts++;
         }
     }
 
     return NULL;
 }
 
-void test_atomic_ordering_per_producer(void) {
-    printf("  Testing atomic ordering (FIFO per producer)...\n");
+static void check_ordering_per_producer(bool batch) {
     reset_sync();
 
     Mailbox mailbox;
@@ -549,7 +561,8 @@ void test_atomic_ordering_per_producer(void) {
         .mailbox = &mailbox,
         .last_seen = &last_seen,
         .out_of_order = &out_of_order,
-        .producer_id = 0
+        .producer_id = 0,
+        .batch = batch
     };
 
     pthread_create(&consumer, NULL, ordering_consumer, &consumer_args);
@@ -580,10 +593,21 @@ void test_atomic_ordering_per_producer(void) {
     int errors = atomic_load(&out_of_order);
     printf("    Out-of-order messages: %d (should be 0)\n", errors);
     ASSERT_EQ(0, errors);
+    ASSERT_EQ(0, mailbox_count(&mailbox));
 
     mailbox_free(&mailbox);
 }
 
+void test_atomic_ordering_per_producer(void) {
+    printf("  Testing atomic ordering (FIFO per producer)...\n");
+    check_ordering_per_producer(false);
+}
+
+void test_batch_ordering_per_producer(void) {
+    printf("  Testing batch pop ordering (FIFO per producer)...\n");
+    check_ordering_per_producer(true);
+}
+
 /* ========== Test: High Contention ========== */
 
 typedef struct {
@@ -974,6 +998,7 @@ int main(void) {
 
     /* Atomic ordering */
     RUN_TEST(test_atomic_ordering_per_producer);
+    RUN_TEST(test_batch_ordering_per_producer);
 
     /* Additional concurrent tests */
     RUN_TEST(test_high_contention);
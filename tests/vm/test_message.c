@@ -8,8 +8,11 @@
 #include "../test_common.h"
 #include "runtime/block.h"
 #include "runtime/scheduler.h"
+#include "util/worker_alloc.h"
 #include "vm/primitives.h"
 
+#include <pthread.h>
+
 /* Mailbox Unit Tests */
 
 void test_mailbox_init(void) {
@@ -61,6 +64,42 @@ void test_mailbox_push_pop(void) {
     mailbox_free(&mailbox);
 }
 
+void test_mailbox_pop_batch(void) {
+    Mailbox mailbox;
+    mailbox_init(&mailbox);
+
+    for (int i = 0; i < 5; i++) {
+        ASSERT(mailbox_push(&mailbox, message_new((Pid)(i + 1), value_int(i)), 100));
+    }
+
+    Message *out[8];
+    ASSERT_EQ(3, mailbox_pop_batch(&mailbox, out, 3));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(i + 1, out[i]->sender);
+        ASSERT_EQ(i, out[i]->value->as.integer);
+        message_free(out[i]);
+    }
+    ASSERT_EQ(2, mailbox_count(&mailbox));
+
+    /* The last message goes through the stub swap */
+    ASSERT_EQ(2, mailbox_pop_batch(&mailbox, out, 8));
+    ASSERT_EQ(3, out[0]->value->as.integer);
+    ASSERT_EQ(4, out[1]->value->as.integer);
+    message_free(out[0]);
+    message_free(out[1]);
+    ASSERT(mailbox_empty(&mailbox));
+    ASSERT_EQ(0, mailbox_pop_batch(&mailbox, out, 8));
+
+    /* The queue stays usable after a full drain */
+    ASSERT(mailbox_push(&mailbox, message_new(9, value_int(9)), 100));
+    ASSERT_EQ(1, mailbox_pop_batch(&mailbox, out, 8));
+    ASSERT_EQ(9, out[0]->sender);
+    message_free(out[0]);
+    ASSERT_EQ(0, mailbox_count(&mailbox));
+
+    mailbox_free(&mailbox);
+}
+
 void test_mailbox_limit(void) {
     Mailbox mailbox;
     mailbox_init(&mailbox);
@@ -129,6 +168,49 @@ void test_mailbox_notify(void) {
     mailbox_free(&mailbox);
 }
 
+static void *drain_mailbox_thread(void *arg) {
+    Mailbox *mailbox = (Mailbox *)arg;
+    Message *msg;
+    while ((msg = mailbox_pop(mailbox)) != NULL) {
+        message_free(msg);
+    }
+    return NULL;
+}
+
+void test_message_pooled(void) {
+    WorkerAllocator alloc;
+    worker_alloc_init(&alloc, 0);
+    worker_alloc_set_current(&alloc);
+
+    Mailbox mailbox;
+    mailbox_init(&mailbox);
+
+    /* Fill exactly one chunk of the pool messages come from */
+    size_t count = alloc.pools[1].blocks_per_chunk;
+    for (size_t i = 0; i < count; i++) {
+        Message *msg = message_new(1, NULL);
+        ASSERT(worker_alloc_owns(msg));
+        ASSERT(mailbox_push(&mailbox, msg, 0));
+    }
+    ASSERT_EQ(1, worker_alloc_stats(&alloc).total_chunks);
+
+    /* The receiver frees them on its own thread */
+    pthread_t thread;
+    pthread_create(&thread, NULL, drain_mailbox_thread, &mailbox);
+    pthread_join(thread, NULL);
+    ASSERT(mailbox_empty(&mailbox));
+
+    /* The next sends reuse those nodes instead of carving a new chunk */
+    for (size_t i = 0; i < count; i++) {
+        ASSERT(mailbox_push(&mailbox, message_new(1, NULL), 0));
+    }
+    ASSERT_EQ(1, worker_alloc_stats(&alloc).total_chunks);
+
+    mailbox_free(&mailbox);
+    worker_alloc_set_current(NULL);
+    worker_alloc_free(&alloc);
+}
+
 /* Block Message Tests */
 
 void test_block_send_receive(void) {
@@ -460,15 +542,80 @@ void test_primitives_infer(void) {
     primitives_free(rt);
 }
 
+/* receive_match({"type": "reply"}) */
+static Bytecode *make_receive_match_code(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    Value *pattern = value_map();
+    pattern = map_set(pattern, "type", value_string("reply"));
+    size_t idx = chunk_add_constant(chunk, pattern);
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, (idx >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, idx & 0xFF, 1);
+    chunk_write_opcode(chunk, OP_RECEIVE_MATCH, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+static void send_typed(Block *block, const char *type, int64_t n) {
+    Value *msg = value_map();
+    msg = map_set(msg, "type", value_string(type));
+    msg = map_set(msg, "n", value_int(n));
+    block_send(block, 1, msg);
+    value_free(msg);
+}
+
+void test_receive_match_skips_tested(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    Bytecode *code = make_receive_match_code();
+    Pid pid = scheduler_spawn_ex(sched, code, "matcher", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    for (int i = 0; i < 5; i++) send_typed(block, "event", i);
+    scheduler_step(sched);
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+    ASSERT_EQ(5, block->counters.match_tests);
+
+    /* Waking for more events tests only the new ones */
+    for (int i = 5; i < 8; i++) send_typed(block, "event", i);
+    scheduler_step(sched);
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+    ASSERT_EQ(8, block->counters.match_tests);
+
+    send_typed(block, "reply", 99);
+    scheduler_run(sched);
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT_EQ(9, block->counters.match_tests);
+
+    Value *result = vm_peek(block->vm, 0);
+    ASSERT(result != NULL && result->type == VAL_MAP);
+    ASSERT_EQ(99, map_get(map_get(result, "value"), "n")->as.integer);
+
+    /* The skipped events stay queued in arrival order */
+    size_t saved = 0;
+    for (Message *msg = block->save_queue_head; msg; msg = msg->next) {
+        ASSERT_EQ((int64_t)saved, map_get(msg->value, "n")->as.integer);
+        saved++;
+    }
+    ASSERT_EQ(8, saved);
+
+    scheduler_free(sched);
+    bytecode_free(code);
+}
+
 /* Main */
 
 int main(void) {
     /* Mailbox tests */
     RUN_TEST(test_mailbox_init);
     RUN_TEST(test_mailbox_push_pop);
+    RUN_TEST(test_mailbox_pop_batch);
     RUN_TEST(test_mailbox_limit);
     RUN_TEST(test_mailbox_receive_timeout);
     RUN_TEST(test_mailbox_notify);
+    RUN_TEST(test_message_pooled);
 
     /* Block message tests */
     RUN_TEST(test_block_send_receive);
@@ -479,6 +626,7 @@ int main(void) {
     RUN_TEST(test_opcode_send_receive);
     RUN_TEST(test_send_wakes_waiting_block);
     RUN_TEST(test_send_without_capability);
+    RUN_TEST(test_receive_match_skips_tested);
 
     /* Primitives tests */
     RUN_TEST(test_primitives_memory);
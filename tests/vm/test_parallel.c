@@ -8,11 +8,15 @@
  * SPDX-License-Identifier: MIT
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "../test_common.h"
 #include "runtime/scheduler.h"
 #include "runtime/worker.h"
 #include "vm/vm.h"
 
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <time.h>
 
@@ -79,6 +83,21 @@ static Bytecode *make_simple_code(int64_t value) {
     return code;
 }
 
+/* Helper: create bytecode that sleeps for ms then halts */
+static Bytecode *make_sleep_code(int64_t ms) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(ms));
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_SLEEP, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
 void test_parallel_basic(void) {
     printf("  Testing basic parallel execution with 4 workers...\n");
 
@@ -259,6 +278,439 @@ void test_work_stealing(void) {
     }
 }
 
+void test_parallel_sleep_overlaps(void) {
+    printf("  Testing sleeping blocks do not hold workers (16 x 50ms, 2 workers)...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 2;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *codes[16];
+    for (int i = 0; i < 16; i++) {
+        codes[i] = make_sleep_code(50);
+        scheduler_spawn(sched, codes[i], "sleeper");
+    }
+
+    uint64_t start = timer_current_time_ms();
+    scheduler_run(sched);
+    uint64_t elapsed = timer_current_time_ms() - start;
+
+    printf("    Elapsed: %lu ms\n", (unsigned long)elapsed);
+
+    /* Blocking sleeps would serialize to 8 x 50ms per worker */
+    ASSERT(elapsed >= 50);
+    ASSERT(elapsed < 300);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(16, stats.blocks_dead);
+
+    scheduler_free(sched);
+    for (int i = 0; i < 16; i++) {
+        bytecode_free(codes[i]);
+    }
+}
+
+void test_parallel_idle_workers_park(void) {
+    printf("  Testing idle workers park (1 x 100ms sleep, 4 workers)...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *code = make_sleep_code(100);
+    scheduler_spawn(sched, code, "sleeper");
+
+    struct timespec cpu_start, cpu_end;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_start);
+    scheduler_run(sched);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_end);
+
+    double cpu_ms = (cpu_end.tv_sec - cpu_start.tv_sec) * 1000.0 +
+                    (cpu_end.tv_nsec - cpu_start.tv_nsec) / 1000000.0;
+
+    size_t parks = 0;
+    for (size_t i = 0; i < scheduler_worker_count(sched); i++) {
+        parks += atomic_load(&scheduler_get_worker(sched, i)->parks);
+    }
+
+    printf("    CPU: %.1f ms, parks: %zu\n", cpu_ms, parks);
+
+    /* Four spinning workers would burn ~400ms of CPU over the sleep */
+    ASSERT(parks >= 4);
+    ASSERT(cpu_ms < 100.0);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(1, stats.blocks_dead);
+
+    scheduler_free(sched);
+    bytecode_free(code);
+}
+
+typedef struct SpawnThread {
+    pthread_t thread;
+    Scheduler *sched;
+    Bytecode *code;
+    int count;
+} SpawnThread;
+
+static void *spawn_thread_main(void *arg) {
+    SpawnThread *t = (SpawnThread *)arg;
+    for (int i = 0; i < t->count; i++) {
+        scheduler_spawn(t->sched, t->code, "injected");
+    }
+    return NULL;
+}
+
+static void *scheduler_thread_main(void *arg) {
+    scheduler_run((Scheduler *)arg);
+    return NULL;
+}
+
+/* Test: Foreign threads spawn into running workers */
+void test_parallel_external_spawn(void) {
+    printf("  Testing spawns from 4 foreign threads while workers run...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    /* Keeps the workers alive until every spawner has finished */
+    Bytecode *sentinel_code = make_sleep_code(100);
+    scheduler_spawn(sched, sentinel_code, "sentinel");
+
+    pthread_t sched_thread;
+    pthread_create(&sched_thread, NULL, scheduler_thread_main, sched);
+
+    Bytecode *code = make_loop_code(100);
+    SpawnThread threads[4];
+    for (int i = 0; i < 4; i++) {
+        threads[i] = (SpawnThread){.sched = sched, .code = code, .count = 250};
+        pthread_create(&threads[i].thread, NULL, spawn_thread_main, &threads[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        pthread_join(threads[i].thread, NULL);
+    }
+    pthread_join(sched_thread, NULL);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    printf("    Completed: %zu\n", stats.blocks_dead);
+    ASSERT_EQ(1001, stats.blocks_dead);
+
+    scheduler_free(sched);
+    bytecode_free(code);
+    bytecode_free(sentinel_code);
+}
+
+/* Helper: receive one message then halt */
+static Bytecode *make_receive_code(void) {
+    Bytecode *code = bytecode_new();
+    chunk_write_opcode(code->main, OP_RECEIVE, 1);
+    chunk_write_opcode(code->main, OP_POP, 1);
+    chunk_write_opcode(code->main, OP_HALT, 1);
+    return code;
+}
+
+/* Helper: crash on stack underflow */
+static Bytecode *make_crash_code(void) {
+    Bytecode *code = bytecode_new();
+    chunk_write_opcode(code->main, OP_DUP, 1);
+    chunk_write_opcode(code->main, OP_HALT, 1);
+    return code;
+}
+
+/* Test: Monitors get DOWN from a block that exits on a worker */
+void test_parallel_monitor_down(void) {
+    printf("  Testing monitor DOWN delivery with 2 workers...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 2;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *halt_code = make_simple_code(1);
+    Bytecode *recv_code = make_receive_code();
+
+    /* The monitor only exits once the DOWN message arrives */
+    Pid monitor_pid = scheduler_spawn_ex(sched, recv_code, "monitor",
+                                         CAP_MONITOR | CAP_RECEIVE, NULL);
+    Pid target_pid = scheduler_spawn(sched, halt_code, "target");
+
+    Block *monitor = scheduler_get_block(sched, monitor_pid);
+    Block *target = scheduler_get_block(sched, target_pid);
+    ASSERT(block_monitor(monitor, target_pid));
+    ASSERT(block_add_monitored_by(target, monitor_pid));
+
+    scheduler_run(sched);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(2, stats.blocks_dead);
+    ASSERT_EQ(0, stats.blocks_alive);
+
+    scheduler_free(sched);
+    bytecode_free(halt_code);
+    bytecode_free(recv_code);
+}
+
+/* Test: A crash on one worker takes down a linked block parked on another */
+void test_parallel_link_crash(void) {
+    printf("  Testing link crash propagation with 2 workers...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 2;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *crash_code = make_crash_code();
+    Bytecode *recv_code = make_receive_code();
+
+    /* Nothing ever sends to the linked block; only the crash ends it */
+    Pid linked_pid = scheduler_spawn_ex(sched, recv_code, "linked",
+                                        CAP_LINK | CAP_RECEIVE, NULL);
+    Pid crasher_pid = scheduler_spawn(sched, crash_code, "crasher");
+
+    Block *linked = scheduler_get_block(sched, linked_pid);
+    Block *crasher = scheduler_get_block(sched, crasher_pid);
+    ASSERT(block_link(linked, crasher_pid));
+    ASSERT(block_link(crasher, linked_pid));
+
+    scheduler_run(sched);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(2, stats.blocks_dead);
+    ASSERT_EQ(0, stats.blocks_alive);
+
+    scheduler_free(sched);
+    bytecode_free(crash_code);
+    bytecode_free(recv_code);
+}
+
+/* Test: Dead blocks leave the registry once their worker retires them */
+void test_parallel_reclaims_dead_blocks(void) {
+    printf("  Testing dead block reclamation (500 blocks, 4 workers)...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *code = make_loop_code(10);
+    for (int i = 0; i < 500; i++) {
+        scheduler_spawn(sched, code, "churn");
+    }
+    ASSERT_EQ(500, scheduler_block_count(sched));
+
+    scheduler_run(sched);
+
+    size_t reclaimed = 0;
+    for (size_t i = 0; i < scheduler_worker_count(sched); i++) {
+        reclaimed += atomic_load(&scheduler_get_worker(sched, i)->blocks_reclaimed);
+    }
+    printf("    Reclaimed before shutdown: %zu\n", reclaimed);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(0, scheduler_block_count(sched));
+    ASSERT_EQ(500, stats.blocks_dead);
+    ASSERT(reclaimed > 0);
+
+    scheduler_free(sched);
+    bytecode_free(code);
+}
+
+/* Test: A run where every live block waits on mail returns, as in single-threaded mode */
+void test_parallel_blocked_run_returns(void) {
+    printf("  Testing blocked receivers end the run with 4 workers...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *halt_code = make_simple_code(1);
+    Bytecode *recv_code = make_receive_code();
+
+    Pid waiter = scheduler_spawn_ex(sched, recv_code, "waiter", CAP_RECEIVE, NULL);
+    scheduler_spawn(sched, halt_code, "done");
+
+    scheduler_run(sched);
+
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(1, stats.blocks_dead);
+    ASSERT_EQ(1, stats.blocks_waiting);
+    ASSERT_EQ(BLOCK_WAITING, block_state(scheduler_get_block(sched, waiter)));
+
+    scheduler_free(sched);
+    bytecode_free(halt_code);
+    bytecode_free(recv_code);
+}
+
+/* Helper: wait count times in a loop, then halt. Each wait receives one
+ * message, or sleeps for sleep_ms when it is positive. */
+static Bytecode *make_wait_loop_code(int count, int64_t sleep_ms) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(count));
+    chunk_add_constant(chunk, value_int(1));
+    chunk_add_constant(chunk, value_int(0));
+    chunk_add_constant(chunk, value_int(sleep_ms));
+
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+
+    size_t loop_start = chunk->code_size;
+
+    chunk_write_opcode(chunk, OP_DUP, 2);
+    chunk_write_opcode(chunk, OP_CONST, 2);
+    chunk_write_byte(chunk, 0, 2);
+    chunk_write_byte(chunk, 2, 2);
+    chunk_write_opcode(chunk, OP_LE, 2);
+
+    size_t exit_jump = chunk_write_jump(chunk, OP_JUMP_IF, 2);
+    chunk_write_opcode(chunk, OP_POP, 2);
+
+    if (sleep_ms > 0) {
+        chunk_write_opcode(chunk, OP_CONST, 3);
+        chunk_write_byte(chunk, 0, 3);
+        chunk_write_byte(chunk, 3, 3);
+        chunk_write_opcode(chunk, OP_SLEEP, 3);
+    } else {
+        chunk_write_opcode(chunk, OP_RECEIVE, 3);
+    }
+    chunk_write_opcode(chunk, OP_POP, 3);
+
+    chunk_write_opcode(chunk, OP_CONST, 4);
+    chunk_write_byte(chunk, 0, 4);
+    chunk_write_byte(chunk, 1, 4);
+    chunk_write_opcode(chunk, OP_SUB, 4);
+
+    chunk_write_opcode(chunk, OP_LOOP, 5);
+    size_t offset = chunk->code_size - loop_start + 2;
+    chunk_write_byte(chunk, (offset >> 8) & 0xFF, 5);
+    chunk_write_byte(chunk, offset & 0xFF, 5);
+
+    chunk_patch_jump(chunk, exit_jump);
+    chunk_write_opcode(chunk, OP_POP, 6);
+    chunk_write_opcode(chunk, OP_HALT, 6);
+
+    return code;
+}
+
+#define STRESS_RECEIVERS 16
+#define STRESS_SENDERS 4
+#define STRESS_MESSAGES 250  /* Per sender per receiver */
+
+typedef struct SendThread {
+    pthread_t thread;
+    Scheduler *sched;
+    Pid *receivers;
+    size_t sent;
+} SendThread;
+
+static void *send_thread_main(void *arg) {
+    SendThread *t = (SendThread *)arg;
+    Value *msg = value_int(7);
+    for (int i = 0; i < STRESS_MESSAGES; i++) {
+        for (int r = 0; r < STRESS_RECEIVERS; r++) {
+            if (scheduler_send(t->sched, t->receivers[r], PID_INVALID, msg)) {
+                t->sent++;
+            }
+        }
+        /* Let receivers drain and park so the next round has to wake them */
+        sched_yield();
+    }
+    value_free(msg);
+    return NULL;
+}
+
+/* Test: Foreign senders race receivers parking and waking on workers */
+void test_parallel_send_receive_stress(void) {
+    printf("  Testing %d senders against %d receivers with 4 workers...\n",
+           STRESS_SENDERS, STRESS_RECEIVERS);
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    /* Keeps the run going until every sender has finished */
+    Bytecode *sentinel_code = make_sleep_code(60000);
+    Pid sentinel = scheduler_spawn(sched, sentinel_code, "sentinel");
+
+    /* Room for every message, so a send only fails if delivery is broken */
+    BlockLimits limits = block_limits_default();
+    limits.max_mailbox_size = STRESS_SENDERS * STRESS_MESSAGES;
+
+    Bytecode *recv_code = make_wait_loop_code(STRESS_SENDERS * STRESS_MESSAGES, 0);
+    Pid receivers[STRESS_RECEIVERS];
+    for (int r = 0; r < STRESS_RECEIVERS; r++) {
+        receivers[r] = scheduler_spawn_ex(sched, recv_code, "receiver", CAP_RECEIVE, &limits);
+    }
+
+    pthread_t sched_thread;
+    pthread_create(&sched_thread, NULL, scheduler_thread_main, sched);
+
+    SendThread senders[STRESS_SENDERS];
+    for (int i = 0; i < STRESS_SENDERS; i++) {
+        senders[i] = (SendThread){.sched = sched, .receivers = receivers};
+        pthread_create(&senders[i].thread, NULL, send_thread_main, &senders[i]);
+    }
+    size_t sent = 0;
+    for (int i = 0; i < STRESS_SENDERS; i++) {
+        pthread_join(senders[i].thread, NULL);
+        sent += senders[i].sent;
+    }
+    scheduler_kill(sched, sentinel);
+    pthread_join(sched_thread, NULL);
+
+    /* Every message was delivered and consumed exactly once */
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(STRESS_SENDERS * STRESS_MESSAGES * STRESS_RECEIVERS, sent);
+    ASSERT_EQ(STRESS_RECEIVERS + 1, stats.blocks_dead);
+    ASSERT_EQ(0, stats.blocks_alive);
+
+    scheduler_free(sched);
+    bytecode_free(recv_code);
+    bytecode_free(sentinel_code);
+}
+
+/* Test: Short sleeps whose timers fire while the sleeper is still on its worker */
+void test_parallel_sleep_stress(void) {
+    printf("  Testing 32 blocks sleeping 1ms 50 times with 4 workers...\n");
+
+    SchedulerConfig config = scheduler_config_default();
+    config.num_workers = 4;
+
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *code = make_wait_loop_code(50, 1);
+    for (int i = 0; i < 32; i++) {
+        scheduler_spawn(sched, code, "sleeper");
+    }
+
+    scheduler_run(sched);
+
+    /* A lost timer wakeup would strand a sleeper and end the run early */
+    SchedulerStats stats = scheduler_stats(sched);
+    ASSERT_EQ(32, stats.blocks_dead);
+    ASSERT_EQ(0, stats.blocks_alive);
+
+    scheduler_free(sched);
+    bytecode_free(code);
+}
+
 int main(void) {
     printf("\n=== Parallel Execution Tests ===\n\n");
 
@@ -266,6 +718,15 @@ int main(void) {
     RUN_TEST(test_parallel_heavy_load);
     RUN_TEST(test_parallel_vs_single);
     RUN_TEST(test_work_stealing);
+    RUN_TEST(test_parallel_sleep_overlaps);
+    RUN_TEST(test_parallel_idle_workers_park);
+    RUN_TEST(test_parallel_external_spawn);
+    RUN_TEST(test_parallel_monitor_down);
+    RUN_TEST(test_parallel_link_crash);
+    RUN_TEST(test_parallel_reclaims_dead_blocks);
+    RUN_TEST(test_parallel_blocked_run_returns);
+    RUN_TEST(test_parallel_send_receive_stress);
+    RUN_TEST(test_parallel_sleep_stress);
 
     printf("\n");
     return TEST_RESULT();
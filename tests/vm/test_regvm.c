@@ -8,6 +8,7 @@
 #include "../test_common.h"
 #include "vm/regvm.h"
 #include "vm/value.h"
+#include "util/alloc.h"
 
 /* Basic Tests */
 
@@ -244,6 +245,71 @@ void test_regvm_load_constant(void) {
     regvm_free(vm);
 }
 
+/* Call Tests */
+
+void test_regvm_call(void) {
+    RegVM *vm = regvm_new();
+    RegChunk *program = regchunk_new();
+
+    /* fn double(x) { return x + x } */
+    RegChunk *fn = regchunk_new();
+    fn->name = agim_strdup("double");
+    fn->num_params = 1;
+    fn->num_regs = 2;
+    regchunk_write(fn, reg_instr(ROP_ADD, 1, 0, 0), 1);
+    regchunk_write(fn, reg_instr(ROP_RET, 1, 0, 0), 1);
+    regchunk_add_function(program, fn);
+
+    /* r0 = double(21); r1 = r0; result r1 */
+    size_t name = regchunk_add_constant(program, value_string("double"));
+    program->num_regs = 3;
+    regchunk_write(program, reg_instr_imm(ROP_GET_GLOBAL, 0, (uint16_t)name), 1);
+    regchunk_write(program, reg_instr_imm(ROP_LOAD_INT, 1, 21), 1);
+    regchunk_write(program, reg_instr(ROP_CALL, 2, 0, 1), 1);
+    regchunk_write(program, reg_instr(ROP_RET, 2, 0, 0), 1);
+
+    RegVMResult result = regvm_run(vm, program);
+    ASSERT_EQ(REGVM_OK, result);
+    ASSERT(nanbox_is_int(vm->result));
+    ASSERT_EQ(42, nanbox_as_int(vm->result));
+
+    regchunk_free(program);
+    regvm_free(vm);
+}
+
+void test_regvm_reductions_resume(void) {
+    RegVM *vm = regvm_new();
+    RegChunk *chunk = regchunk_new();
+
+    /* Count to 1000; each backward jump costs a reduction */
+    chunk->num_regs = 4;
+    regchunk_write(chunk, reg_instr_imm(ROP_LOAD_INT, 0, 0), 1);
+    regchunk_write(chunk, reg_instr_imm(ROP_LOAD_INT, 1, 1000), 1);
+    regchunk_write(chunk, reg_instr_imm(ROP_LOAD_INT, 2, 1), 1);
+    regchunk_write(chunk, reg_instr(ROP_ADD, 0, 0, 2), 1);
+    regchunk_write(chunk, reg_instr(ROP_LT, 3, 0, 1), 1);
+    regchunk_write(chunk, reg_instr_cond_jump(ROP_JMP_IF, 3, -3), 1);
+    regchunk_write(chunk, reg_instr(ROP_RET, 0, 0, 0), 1);
+
+    ASSERT(regvm_load(vm, chunk, chunk));
+    vm->reduction_limit = 100;
+
+    RegVMResult result;
+    int slices = 0;
+    do {
+        vm->reductions = 0;
+        result = regvm_resume(vm);
+        slices++;
+    } while (result == REGVM_YIELD && slices < 100);
+
+    ASSERT_EQ(REGVM_OK, result);
+    ASSERT(slices >= 10);
+    ASSERT_EQ(1000, nanbox_as_int(vm->result));
+
+    regchunk_free(chunk);
+    regvm_free(vm);
+}
+
 /* Main */
 
 int main(void) {
@@ -264,6 +330,10 @@ int main(void) {
     /* Control flow tests */
     RUN_TEST(test_regvm_loop);
 
+    /* Call and scheduling tests */
+    RUN_TEST(test_regvm_call);
+    RUN_TEST(test_regvm_reductions_resume);
+
     /* Data structure tests */
     RUN_TEST(test_regvm_array);
     RUN_TEST(test_regvm_map);
@@ -83,6 +83,67 @@ static Bytecode *create_value_bytecode(int64_t value) {
     return code;
 }
 
+/* Helper: Create bytecode that sleeps for ms then halts */
+static Bytecode *create_sleep_bytecode(int64_t ms) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(ms));
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_SLEEP, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+/* Helper: Create bytecode that returns whether receive_timeout(ms) timed out */
+static Bytecode *create_receive_timeout_bytecode(int64_t ms) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(ms));
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_RECEIVE_TIMEOUT, 1);
+    chunk_write_opcode(chunk, OP_RESULT_IS_ERR, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+/* Helper: Create bytecode that returns receive_many(count, ms) */
+static Bytecode *create_receive_many_bytecode(int64_t count, int64_t ms) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(count));
+    chunk_add_constant(chunk, value_int(ms));
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 1, 1);
+    chunk_write_opcode(chunk, OP_RECEIVE_MANY, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
+/* Helper: Create bytecode that receives one message then halts */
+static Bytecode *create_receive_bytecode(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_write_opcode(chunk, OP_RECEIVE, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    return code;
+}
+
 /*
  * Test: scheduler_run completes all blocks
  */
@@ -551,6 +612,233 @@ void test_execution_stats_coherent(void) {
     scheduler_free(sched);
 }
 
+/*
+ * Test: sleep parks the block on the timer wheel
+ */
+void test_execution_sleep_parks_block(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid sleeper = scheduler_spawn(sched, create_sleep_bytecode(30), "sleeper");
+    Pid other = scheduler_spawn(sched, create_minimal_bytecode(), "other");
+
+    uint64_t start = timer_current_time_ms();
+
+    /* First step parks the sleeper without blocking the thread */
+    ASSERT(scheduler_step(sched));
+    Block *block = scheduler_get_block(sched, sleeper);
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+    ASSERT(block->pending_timer != NULL);
+    ASSERT(timer_has_pending(sched->timers));
+
+    /* The other block runs immediately */
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_DEAD, block_state(scheduler_get_block(sched, other)));
+    ASSERT(timer_current_time_ms() - start < 30);
+
+    /* Running to completion waits for the timer and resumes the sleeper */
+    scheduler_run(sched);
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT_EQ(0, block->u.exit.exit_code);
+    ASSERT(block->pending_timer == NULL);
+    ASSERT(timer_current_time_ms() - start >= 30);
+    ASSERT(!timer_has_pending(sched->timers));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: a message does not cut a sleep short
+ */
+void test_execution_sleep_ignores_messages(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid sleeper = scheduler_spawn(sched, create_sleep_bytecode(30), "sleeper");
+    uint64_t start = timer_current_time_ms();
+    ASSERT(scheduler_step(sched));
+
+    Block *block = scheduler_get_block(sched, sleeper);
+    ASSERT(block_send(block, PID_INVALID, value_int(1)));
+    scheduler_wake_block(sched, block);
+    ASSERT_EQ(BLOCK_RUNNABLE, block_state(block));
+
+    /* Re-executing the sleep parks the block again */
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+
+    scheduler_run(sched);
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(timer_current_time_ms() - start >= 30);
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: receive_timeout parks on the timer wheel and times out
+ */
+void test_execution_receive_timeout_expires(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_timeout_bytecode(30),
+                                 "waiter", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    uint64_t start = timer_current_time_ms();
+    scheduler_run(sched);
+
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(timer_current_time_ms() - start >= 30);
+    ASSERT(nanbox_is_true(vm_peek_nan(block->vm, 0)));
+    ASSERT(block->pending_timer == NULL);
+
+    /* Parked once, woken once: no yield-and-poll loop */
+    ASSERT_EQ(2, sched->context_switches);
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: a message cancels the pending receive timeout
+ */
+void test_execution_receive_timeout_message(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_timeout_bytecode(10000),
+                                 "waiter", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+    ASSERT(timer_has_pending(sched->timers));
+
+    ASSERT(block_send(block, PID_INVALID, value_int(7)));
+    scheduler_wake_block(sched, block);
+    scheduler_run(sched);
+
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(nanbox_is_false(vm_peek_nan(block->vm, 0)));
+    ASSERT(block->pending_timer == NULL);
+    ASSERT(!timer_has_pending(sched->timers));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: receive_many wakes on mail and takes at most count messages
+ */
+void test_execution_receive_many_batch(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_many_bytecode(2, 10000),
+                                 "aggregator", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+    ASSERT(timer_has_pending(sched->timers));
+
+    for (int i = 1; i <= 3; i++) {
+        ASSERT(block_send(block, (Pid)(10 + i), value_int(i)));
+    }
+    scheduler_run(sched);
+
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(block->pending_timer == NULL);
+    ASSERT(!timer_has_pending(sched->timers));
+
+    Value *batch = vm_peek(block->vm, 0);
+    ASSERT(batch != NULL && batch->type == VAL_ARRAY);
+    ASSERT_EQ(2, array_length(batch));
+    for (size_t i = 0; i < 2; i++) {
+        Value *pair = array_get(batch, i);
+        ASSERT_EQ(2, array_length(pair));
+        ASSERT_EQ(11 + i, array_get(pair, 0)->as.pid);
+        ASSERT_EQ((int64_t)i + 1, array_get(pair, 1)->as.integer);
+    }
+
+    /* The third message is left for the next receive */
+    ASSERT_EQ(1, mailbox_count(&block->mailbox));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: receive_many returns an empty batch when the timeout expires
+ */
+void test_execution_receive_many_timeout(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_many_bytecode(8, 20),
+                                 "aggregator", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    uint64_t start = timer_current_time_ms();
+    scheduler_run(sched);
+
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(timer_current_time_ms() - start >= 20);
+    ASSERT(block->pending_timer == NULL);
+
+    Value *batch = vm_peek(block->vm, 0);
+    ASSERT(batch != NULL && batch->type == VAL_ARRAY);
+    ASSERT_EQ(0, array_length(batch));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: block_send wakes a parked receiver without a registry scan
+ */
+void test_execution_send_wakes_receiver(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_bytecode(),
+                                 "receiver", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_WAITING, block_state(block));
+
+    /* Nothing runnable and no timers: idle without scanning waiters */
+    ASSERT(!scheduler_step(sched));
+
+    ASSERT(block_send(block, PID_INVALID, value_int(42)));
+    ASSERT_EQ(BLOCK_RUNNABLE, block_state(block));
+    ASSERT(!scheduler_queue_empty(sched));
+
+    ASSERT(scheduler_step(sched));
+    ASSERT_EQ(BLOCK_DEAD, block_state(block));
+    ASSERT(scheduler_queue_empty(sched));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: repeated sends enqueue a waiting block only once
+ */
+void test_execution_send_wakes_once(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Pid pid = scheduler_spawn_ex(sched, create_receive_bytecode(),
+                                 "receiver", CAP_RECEIVE, NULL);
+    Block *block = scheduler_get_block(sched, pid);
+    ASSERT(scheduler_step(sched));
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT(block_send(block, PID_INVALID, value_int(i)));
+    }
+    ASSERT_EQ(1, sched->run_queue.count);
+
+    scheduler_free(sched);
+}
+
 int main(void) {
     printf("Running scheduler execution tests...\n");
 
@@ -604,5 +892,19 @@ int main(void) {
     RUN_TEST(test_execution_spawned_count);
     RUN_TEST(test_execution_stats_coherent);
 
+    printf("\nSleep tests:\n");
+    RUN_TEST(test_execution_sleep_parks_block);
+    RUN_TEST(test_execution_sleep_ignores_messages);
+
+    printf("\nReceive timeout tests:\n");
+    RUN_TEST(test_execution_receive_timeout_expires);
+    RUN_TEST(test_execution_receive_timeout_message);
+    RUN_TEST(test_execution_receive_many_batch);
+    RUN_TEST(test_execution_receive_many_timeout);
+
+    printf("\nWakeup tests:\n");
+    RUN_TEST(test_execution_send_wakes_receiver);
+    RUN_TEST(test_execution_send_wakes_once);
+
     return TEST_RESULT();
 }
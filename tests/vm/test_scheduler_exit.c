@@ -15,6 +15,7 @@
 #include "runtime/scheduler.h"
 #include "runtime/block.h"
 #include "runtime/capability.h"
+#include "types/map.h"
 #include "vm/bytecode.h"
 
 /* Helper: Create minimal bytecode that just halts */
@@ -130,11 +131,7 @@ void test_exit_kill_null_scheduler(void) {
 }
 
 /*
- * Test: Killed block becomes dead (queue cleanup happens on step)
- *
- * Note: Due to the order of operations in scheduler_kill, the block state
- * is set to DEAD before the runqueue removal check, so the block may remain
- * in the queue until the next step processes and discards it.
+ * Test: Killed block becomes dead
  */
 void test_exit_kill_block_is_dead(void) {
     Scheduler *sched = scheduler_new(NULL);
@@ -155,6 +152,57 @@ void test_exit_kill_block_is_dead(void) {
     scheduler_free(sched);
 }
 
+/*
+ * Test: Killed block leaves the run queue
+ */
+void test_exit_kill_removes_from_runqueue(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+
+    Bytecode *code = create_minimal_bytecode();
+    Pid pid = scheduler_spawn(sched, code, "victim");
+    ASSERT(!scheduler_queue_empty(sched));
+
+    scheduler_kill(sched, pid);
+
+    ASSERT(scheduler_queue_empty(sched));
+
+    scheduler_free(sched);
+}
+
+/*
+ * Test: Monitor of a killed block receives DOWN
+ */
+void test_exit_kill_notifies_monitor(void) {
+    Scheduler *sched = scheduler_new(NULL);
+    ASSERT(sched != NULL);
+    ASSERT_EQ(0, sched->worker_count);
+
+    Bytecode *target_code = create_infinite_bytecode();
+    Bytecode *monitor_code = create_receive_bytecode();
+    Pid target_pid = scheduler_spawn(sched, target_code, "target");
+    Pid monitor_pid = scheduler_spawn(sched, monitor_code, "monitor");
+
+    Block *target = scheduler_get_block(sched, target_pid);
+    Block *monitor = scheduler_get_block(sched, monitor_pid);
+    block_monitor(monitor, target_pid);
+    block_add_monitored_by(target, monitor_pid);
+
+    scheduler_kill(sched, target_pid);
+
+    ASSERT(block_is_alive(monitor));
+    ASSERT(block_has_messages(monitor));
+
+    Message *msg = block_receive(monitor);
+    ASSERT(msg != NULL);
+    ASSERT_EQ(target_pid, msg->sender);
+    ASSERT_STR_EQ("down", map_get(msg->value, "type")->as.string->data);
+    ASSERT_STR_EQ("killed", map_get(msg->value, "reason")->as.string->data);
+    message_free(msg);
+
+    scheduler_free(sched);
+}
+
 /*
  * Test: Multiple kills don't double-count terminations
  */
@@ -573,6 +621,8 @@ int main(void) {
     RUN_TEST(test_exit_kill_invalid_pid);
     RUN_TEST(test_exit_kill_null_scheduler);
     RUN_TEST(test_exit_kill_block_is_dead);
+    RUN_TEST(test_exit_kill_removes_from_runqueue);
+    RUN_TEST(test_exit_kill_notifies_monitor);
     RUN_TEST(test_exit_double_kill);
     RUN_TEST(test_exit_terminated_count_kill);
     RUN_TEST(test_exit_kill_during_step);
@@ -381,6 +381,26 @@ void test_spawn_ex_null_limits_uses_defaults(void) {
     scheduler_free(sched);
 }
 
+/*
+ * Test: NULL limits take the reduction budget from the scheduler config
+ */
+void test_spawn_ex_null_limits_uses_config_reductions(void) {
+    SchedulerConfig config = scheduler_config_default();
+    config.default_reductions = 500;
+    Scheduler *sched = scheduler_new(&config);
+    ASSERT(sched != NULL);
+
+    Bytecode *code = create_minimal_bytecode();
+    Pid pid = scheduler_spawn_ex(sched, code, "test_block", CAP_NONE, NULL);
+    ASSERT(pid != PID_INVALID);
+
+    Block *block = scheduler_get_block(sched, pid);
+    ASSERT_EQ(500, block->limits.max_reductions);
+    ASSERT_EQ(block_limits_default().max_heap_size, block->limits.max_heap_size);
+
+    scheduler_free(sched);
+}
+
 /*
  * Test: spawn at max_blocks fails
  */
@@ -872,6 +892,7 @@ int main(void) {
     printf("\nScheduler_spawn_ex limits tests:\n");
     RUN_TEST(test_spawn_ex_with_limits);
     RUN_TEST(test_spawn_ex_null_limits_uses_defaults);
+    RUN_TEST(test_spawn_ex_null_limits_uses_config_reductions);
     RUN_TEST(test_spawn_with_restrictive_limits);
 
     printf("\nBlock initialization tests:\n");
@@ -466,6 +466,71 @@ void test_timers_same_slot(void) {
     timer_wheel_free(wheel);
 }
 
+/*
+ * Test: timer_run_expired fires due timers and recycles their entries
+ */
+void test_timer_run_expired(void) {
+    reset_callback_tracking();
+
+    TimerWheel *wheel = timer_wheel_new(NULL);
+    ASSERT(wheel != NULL);
+
+    timer_add(wheel, 7, 0, test_callback, NULL);
+    timer_add(wheel, 8, 10000, test_callback, NULL);
+    size_t allocated = wheel->allocated;
+
+    uint64_t now = timer_current_time_ms();
+    ASSERT_EQ(1, timer_run_expired(wheel, now + 100));
+    ASSERT_EQ(1, g_callback_count);
+    ASSERT_EQ(7, g_last_callback_pid);
+    ASSERT(timer_has_pending(wheel));
+
+    /* Nothing else is due yet */
+    ASSERT_EQ(0, timer_run_expired(wheel, now + 200));
+
+    /* The fired entry went back on the free list */
+    timer_add(wheel, 9, 10000, test_callback, NULL);
+    ASSERT_EQ(allocated, wheel->allocated);
+
+    timer_wheel_free(wheel);
+}
+
+/*
+ * Test: timer_cancel reports a timer that already fired
+ */
+void test_timer_cancel_after_fire(void) {
+    reset_callback_tracking();
+
+    TimerWheel *wheel = timer_wheel_new(NULL);
+    ASSERT(wheel != NULL);
+
+    TimerEntry *entry = timer_add(wheel, 3, 0, test_callback, NULL);
+    ASSERT_EQ(1, timer_run_expired(wheel, timer_current_time_ms() + 100));
+
+    /* Recycled entries stay owned by the wheel, so this is safe */
+    ASSERT(!timer_cancel(wheel, entry));
+    ASSERT_EQ(1, g_callback_count);
+
+    timer_wheel_free(wheel);
+}
+
+/*
+ * Test: timer_cancel_for ignores entries owned by another block
+ */
+void test_timer_cancel_for_owner(void) {
+    TimerWheel *wheel = timer_wheel_new(NULL);
+    ASSERT(wheel != NULL);
+
+    TimerEntry *entry = timer_add(wheel, 1, 1000, test_callback, NULL);
+    ASSERT(!timer_cancel_for(wheel, entry, 2));
+    ASSERT(timer_has_pending(wheel));
+
+    ASSERT(timer_cancel_for(wheel, entry, 1));
+    ASSERT(!timer_has_pending(wheel));
+
+    timer_wheel_free(wheel);
+}
+
 int main(void) {
     printf("Running timer wheel tests...\n");
 
@@ -490,6 +555,8 @@ int main(void) {
     RUN_TEST(test_timer_cancel);
     RUN_TEST(test_timer_cancel_null_entry);
     RUN_TEST(test_timer_cancel_null_wheel);
+    RUN_TEST(test_timer_cancel_after_fire);
+    RUN_TEST(test_timer_cancel_for_owner);
 
     printf("\ntimer_tick tests:\n");
     RUN_TEST(test_timer_tick_fires);
@@ -497,6 +564,7 @@ int main(void) {
     RUN_TEST(test_timer_tick_fires_multiple);
     RUN_TEST(test_timer_tick_callback_context);
     RUN_TEST(test_timer_tick_null_wheel);
+    RUN_TEST(test_timer_run_expired);
 
     printf("\ntimer_next_deadline tests:\n");
     RUN_TEST(test_timer_next_deadline);
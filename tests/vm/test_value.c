@@ -8,6 +8,12 @@
 #include "../test_common.h"
 #include "vm/value.h"
 #include "types/string.h"
+#include "types/array.h"
+#include "types/map.h"
+#include "runtime/mailbox.h"
+#include "runtime/serialize.h"
+
+#include <string.h>
 
 void test_nil(void) {
     Value *v = value_nil();
@@ -181,6 +187,230 @@ void test_string_intern(void) {
     value_free(s3);
 }
 
+/* Bytes borrowing shared storage */
+void test_bytes_slice(void) {
+    SharedBuffer *buf = shared_buffer_new(64);
+    ASSERT(buf != NULL);
+    memset(buf->data, 'x', 64);
+
+    Value *slice = value_bytes_slice(buf, buf->data + 8, 16);
+    ASSERT(slice != NULL);
+    ASSERT_EQ(16, bytes_length(slice));
+    ASSERT(slice->as.bytes->data == buf->data + 8);
+    ASSERT_EQ(2, atomic_load(&buf->refcount));
+
+    /* Copies share the storage too */
+    Value *copy = value_copy(slice);
+    ASSERT(copy->as.bytes->data == slice->as.bytes->data);
+    ASSERT_EQ(3, atomic_load(&buf->refcount));
+
+    /* Appending detaches instead of writing into the shared buffer */
+    const uint8_t more[4] = {'y', 'y', 'y', 'y'};
+    ASSERT(bytes_append(copy, more, sizeof(more)));
+    ASSERT(copy->as.bytes->shared == NULL);
+    ASSERT_EQ(20, bytes_length(copy));
+    ASSERT_EQ('x', buf->data[24]);
+    ASSERT_EQ(2, atomic_load(&buf->refcount));
+
+    /* The slice keeps the storage alive after its creator lets go */
+    shared_buffer_release(buf);
+    ASSERT_EQ('x', slice->as.bytes->data[15]);
+
+    value_free(copy);
+    value_free(slice);
+}
+
+/* Only bytes past the threshold move off-heap, and frozen ones stay put */
+void test_bytes_share(void) {
+    uint8_t data[BYTES_SHARE_MIN];
+    memset(data, 'z', sizeof(data));
+
+    Value *small = value_bytes(16);
+    ASSERT(bytes_append(small, data, 16));
+    ASSERT(!bytes_share(small));
+    ASSERT(small->as.bytes->shared == NULL);
+
+    Value *large = value_bytes(sizeof(data));
+    ASSERT(bytes_append(large, data, sizeof(data)));
+    ASSERT(bytes_share(large));
+    ASSERT(large->as.bytes->shared != NULL);
+    ASSERT(large->as.bytes->data == large->as.bytes->shared->data);
+    ASSERT_EQ('z', large->as.bytes->data[BYTES_SHARE_MIN - 1]);
+
+    ASSERT(value_freeze(large));
+    ASSERT(!bytes_append(large, data, 1));
+    ASSERT_EQ(BYTES_SHARE_MIN, bytes_length(large));
+
+    value_free(small);
+    value_free(large);
+}
+
+/* Deserializing from a shared buffer borrows large byte strings */
+void test_deserialize_shared(void) {
+    Value *blob = value_bytes(1024);
+    uint8_t chunk[1024];
+    memset(chunk, 0xAB, sizeof(chunk));
+    bytes_append(blob, chunk, sizeof(chunk));
+
+    Value *small = value_bytes(8);
+    bytes_append(small, chunk, 8);
+
+    Value *map = value_map();
+    map = map_set(map, "blob", blob);
+    map = map_set(map, "small", small);
+    map = map_set(map, "name", value_string("agent"));
+
+    SerialBuffer out;
+    serial_buffer_init(&out);
+    ASSERT_EQ(SERIALIZE_OK, serialize_value(map, &out));
+
+    SharedBuffer *shared = shared_buffer_new(out.size);
+    memcpy(shared->data, out.data, out.size);
+    serial_buffer_free(&out);
+
+    SerialBuffer in;
+    serial_buffer_init_shared(&in, shared, 0, shared->capacity);
+    SerializeResult res;
+    Value *decoded = deserialize_value(&in, &res);
+    serial_buffer_free(&in);
+    shared_buffer_release(shared);
+
+    ASSERT_EQ(SERIALIZE_OK, res);
+    ASSERT(value_equals(map, decoded));
+    ASSERT_STR_EQ("agent", map_get(decoded, "name")->as.string->data);
+
+    Value *decoded_blob = map_get(decoded, "blob");
+    ASSERT(decoded_blob->as.bytes->shared != NULL);
+    ASSERT_EQ(1024, bytes_length(decoded_blob));
+    ASSERT_EQ(0xAB, decoded_blob->as.bytes->data[1023]);
+    ASSERT(map_get(decoded, "small")->as.bytes->shared == NULL);
+
+    value_free(decoded);
+    value_free(map);
+}
+
+static Value *roundtrip(Value *value, size_t *encoded_size) {
+    SerialBuffer out;
+    serial_buffer_init(&out);
+    ASSERT_EQ(SERIALIZE_OK, serialize_value(value, &out));
+    if (encoded_size) *encoded_size = out.size;
+
+    SerialBuffer in;
+    serial_buffer_init_data(&in, out.data, out.size);
+    SerializeResult res;
+    Value *decoded = deserialize_value(&in, &res);
+    ASSERT_EQ(SERIALIZE_OK, res);
+    ASSERT_EQ(out.size, serial_buffer_position(&in));
+    serial_buffer_free(&out);
+    return decoded;
+}
+
+void test_serialize_v2_roundtrip(void) {
+    Value *ints = value_array();
+    int64_t samples[] = { 0, 1, -1, 63, -64, 300, INT64_MAX, INT64_MIN };
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        ints = array_push(ints, value_int(samples[i]));
+    }
+
+    Value *mixed = value_array();
+    mixed = array_push(mixed, value_int(1));
+    mixed = array_push(mixed, value_string("two"));
+    mixed = array_push(mixed, value_nil());
+
+    Value *point = value_struct_new("Point", 2);
+    value_struct_set_field(point, 0, "x", value_float(1.5));
+    value_struct_set_field(point, 1, "y", value_float(-2.25));
+
+    Value *map = value_map();
+    map = map_set(map, "ints", ints);
+    map = map_set(map, "mixed", mixed);
+    map = map_set(map, "point", point);
+    map = map_set(map, "status", value_enum_with_payload("Status", "Busy", value_int(3)));
+    map = map_set(map, "reply", value_result_ok(value_some(value_pid(pid_make(7, 42)))));
+
+    Value *decoded = roundtrip(map, NULL);
+
+    Value *out_ints = map_get(decoded, "ints");
+    ASSERT_EQ(8, array_length(out_ints));
+    for (size_t i = 0; i < 8; i++) {
+        ASSERT(array_get(out_ints, i)->as.integer == samples[i]);
+    }
+    ASSERT(value_equals(mixed, map_get(decoded, "mixed")));
+
+    Value *out_point = map_get(decoded, "point");
+    ASSERT_STR_EQ("Point", out_point->as.struct_val->type_name);
+    ASSERT(value_struct_get_field(out_point, "y")->as.floating == -2.25);
+
+    Value *status = map_get(decoded, "status");
+    ASSERT_STR_EQ("Status", value_enum_type_name(status));
+    ASSERT(value_enum_is_variant(status, "Busy"));
+    ASSERT_EQ(3, value_enum_payload(status)->as.integer);
+
+    Value *reply = map_get(decoded, "reply");
+    ASSERT(reply->as.result->is_ok);
+    ASSERT_EQ(pid_make(7, 42), reply->as.result->value->as.option->value->as.pid);
+
+    value_free(decoded);
+    value_free(map);
+}
+
+void test_serialize_v2_dedups_keys(void) {
+    /* The shape of typical traffic: many records with the same keys */
+    Value *records = value_array();
+    for (int i = 0; i < 50; i++) {
+        Value *rec = value_map();
+        rec = map_set(rec, "timestamp", value_int(1700000000 + i));
+        rec = map_set(rec, "agent", value_string("planner"));
+        rec = map_set(rec, "score", value_int(i));
+        records = array_push(records, rec);
+    }
+
+    SerialBuffer out;
+    serial_buffer_init(&out);
+    ASSERT_EQ(SERIALIZE_OK, serialize_value(records, &out));
+    ASSERT_EQ(SERIAL_MAGIC, out.data[0]);
+    ASSERT_EQ(SERIAL_VERSION, out.data[1]);
+
+    /* Each key and the repeated value are written once */
+    size_t found = 0;
+    for (size_t i = 0; i + 9 <= out.size; i++) {
+        if (memcmp(out.data + i, "timestamp", 9) == 0) found++;
+    }
+    ASSERT_EQ(1, found);
+    ASSERT(out.size < 50 * 16);
+    serial_buffer_free(&out);
+
+    Value *decoded = roundtrip(records, NULL);
+    ASSERT(value_equals(records, decoded));
+    value_free(decoded);
+    value_free(records);
+}
+
+void test_deserialize_v1(void) {
+    /* {"k": 5, "s": "hi"} as written before the varint format */
+    const uint8_t v1[] = {
+        SERIAL_TAG_MAP, 0, 0, 0, 2,
+        0, 0, 0, 1, 'k', SERIAL_TAG_INT, 0, 0, 0, 0, 0, 0, 0, 5,
+        0, 0, 0, 1, 's', SERIAL_TAG_STRING, 0, 0, 0, 2, 'h', 'i',
+    };
+
+    SerialBuffer in;
+    serial_buffer_init_data(&in, v1, sizeof(v1));
+    SerializeResult res;
+    Value *decoded = deserialize_value(&in, &res);
+
+    ASSERT_EQ(SERIALIZE_OK, res);
+    ASSERT_EQ(5, map_get(decoded, "k")->as.integer);
+    ASSERT_STR_EQ("hi", map_get(decoded, "s")->as.string->data);
+    value_free(decoded);
+
+    /* Versions from the future are refused */
+    const uint8_t future[] = { SERIAL_MAGIC, SERIAL_VERSION + 1, SERIAL_TAG_NIL };
+    serial_buffer_init_data(&in, future, sizeof(future));
+    ASSERT(deserialize_value(&in, &res) == NULL);
+    ASSERT_EQ(SERIALIZE_ERROR_VERSION, res);
+}
+
 int main(void) {
     RUN_TEST(test_nil);
     RUN_TEST(test_bool);
@@ -193,6 +423,12 @@ int main(void) {
     RUN_TEST(test_equality);
     RUN_TEST(test_copy);
     RUN_TEST(test_string_intern);
+    RUN_TEST(test_bytes_slice);
+    RUN_TEST(test_bytes_share);
+    RUN_TEST(test_deserialize_shared);
+    RUN_TEST(test_serialize_v2_roundtrip);
+    RUN_TEST(test_serialize_v2_dedups_keys);
+    RUN_TEST(test_deserialize_v1);
 
     return TEST_RESULT();
 }
@@ -14,6 +14,7 @@
 
 #include "../test_common.h"
 #include "vm/nanbox.h"
+#include "vm/nanbox_convert.h"
 
 #include <math.h>
 #include <float.h>
@@ -439,6 +440,49 @@ void test_nanbox_pid_large(void) {
     ASSERT_EQ(large_pid, nanbox_as_pid(v));
 }
 
+/*
+ * Test: nanbox_borrow_value views primitives without allocating
+ */
+void test_nanbox_borrow_primitives(void) {
+    Value scratch;
+
+    Value *v = nanbox_borrow_value(nanbox_int(-42), &scratch);
+    ASSERT(v == &scratch);
+    ASSERT(value_is_int(v));
+    ASSERT_EQ(-42, v->as.integer);
+
+    v = nanbox_borrow_value(nanbox_double(2.5), &scratch);
+    ASSERT(v == &scratch);
+    ASSERT(value_is_float(v));
+    ASSERT(v->as.floating == 2.5);
+
+    v = nanbox_borrow_value(NANBOX_TRUE, &scratch);
+    ASSERT(value_is_bool(v) && v->as.boolean);
+
+    v = nanbox_borrow_value(nanbox_pid(77), &scratch);
+    ASSERT(value_is_pid(v));
+    ASSERT_EQ(77, v->as.pid);
+
+    v = nanbox_borrow_value(NANBOX_NIL, &scratch);
+    ASSERT(value_is_nil(v));
+
+    /* Re-encoding a borrowed view yields the original NanValue */
+    ASSERT(value_to_nanbox(nanbox_borrow_value(nanbox_int(7), &scratch)) == nanbox_int(7));
+}
+
+/*
+ * Test: nanbox_borrow_value returns heap objects unchanged
+ */
+void test_nanbox_borrow_object(void) {
+    Value scratch;
+    Value *str = value_string("hello");
+
+    Value *v = nanbox_borrow_value(nanbox_obj(str), &scratch);
+    ASSERT(v == str);
+
+    value_free(str);
+}
+
 int main(void) {
     printf("Running NaN-boxing tests...\n");
 
@@ -486,6 +530,10 @@ int main(void) {
     RUN_TEST(test_nanbox_equal_mixed_numeric);
     RUN_TEST(test_nanbox_equal_nan);
 
+    printf("\nBorrow tests:\n");
+    RUN_TEST(test_nanbox_borrow_primitives);
+    RUN_TEST(test_nanbox_borrow_object);
+
     printf("\nEdge case tests:\n");
     RUN_TEST(test_nanbox_zero);
 
@@ -7,6 +7,7 @@
 
 #include "../test_common.h"
 #include "vm/bytecode.h"
+#include "vm/nanbox_convert.h"
 #include "vm/vm.h"
 
 void test_vm_create(void) {
@@ -171,6 +172,45 @@ void test_vm_array(void) {
     bytecode_free(code);
 }
 
+void test_vm_freeze(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    chunk_add_constant(chunk, value_int(10));
+    chunk_add_constant(chunk, value_int(20));
+
+    /* freeze([10]), then push onto a second reference to it */
+    chunk_write_opcode(chunk, OP_ARRAY_NEW, 1);
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_ARRAY_PUSH, 1);
+    chunk_write_opcode(chunk, OP_FREEZE, 1);
+
+    chunk_write_opcode(chunk, OP_DUP, 2);
+    chunk_write_opcode(chunk, OP_CONST, 2);
+    chunk_write_byte(chunk, 0, 2);
+    chunk_write_byte(chunk, 1, 2);
+    chunk_write_opcode(chunk, OP_ARRAY_PUSH, 2);
+
+    chunk_write_opcode(chunk, OP_HALT, 3);
+
+    VM *vm = vm_new();
+    vm_load(vm, code);
+    VMResult result = vm_run(vm);
+
+    ASSERT_EQ(VM_HALT, result);
+    Value *frozen = vm_peek(vm, 1);
+    Value *pushed = vm_peek(vm, 0);
+    ASSERT(value_is_immutable(frozen));
+    ASSERT_EQ(1, array_length(frozen));
+    ASSERT(!value_is_immutable(pushed));
+    ASSERT_EQ(2, array_length(pushed));
+
+    vm_free(vm);
+    bytecode_free(code);
+}
+
 void test_vm_string_concat(void) {
     Bytecode *code = bytecode_new();
     Chunk *chunk = code->main;
@@ -200,6 +240,176 @@ void test_vm_string_concat(void) {
     bytecode_free(code);
 }
 
+void test_vm_cold_path_unboxed(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    /* len("abc") and abs(-2.5) are cold-path opcodes */
+    chunk_add_constant(chunk, value_string("abc"));
+    chunk_add_constant(chunk, value_float(-2.5));
+
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_opcode(chunk, OP_LEN, 1);
+
+    chunk_write_opcode(chunk, OP_CONST, 1);
+    chunk_write_byte(chunk, 0, 1);
+    chunk_write_byte(chunk, 1, 1);
+    chunk_write_opcode(chunk, OP_ABS, 1);
+
+    chunk_write_opcode(chunk, OP_TIME, 1);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    VM *vm = vm_new();
+    vm_load(vm, code);
+    VMResult result = vm_run(vm);
+
+    ASSERT_EQ(VM_HALT, result);
+
+    /* Results live on the stack as NaN-boxed primitives, not heap Values */
+    NanValue now = vm_peek_nan(vm, 0);
+    NanValue abs_val = vm_peek_nan(vm, 1);
+    NanValue len_val = vm_peek_nan(vm, 2);
+    ASSERT(nanbox_is_int(now));
+    ASSERT(nanbox_as_int(now) > 0);
+    ASSERT(nanbox_is_double(abs_val));
+    ASSERT(nanbox_as_double(abs_val) == 2.5);
+    ASSERT(nanbox_is_int(len_val));
+    ASSERT_EQ(3, nanbox_as_int(len_val));
+
+    vm_free(vm);
+    bytecode_free(code);
+}
+
+static void write_op_arg(Chunk *chunk, Opcode op, uint16_t arg) {
+    chunk_write_opcode(chunk, op, 1);
+    chunk_write_byte(chunk, (arg >> 8) & 0xFF, 1);
+    chunk_write_byte(chunk, arg & 0xFF, 1);
+}
+
+void test_vm_global_slots(void) {
+    Bytecode *code = bytecode_new();
+    Chunk *chunk = code->main;
+
+    /* total = 7; total */
+    size_t unused = bytecode_add_global(code, "unused");
+    size_t total = bytecode_add_global(code, "total");
+    chunk_add_constant(chunk, value_int(7));
+
+    write_op_arg(chunk, OP_CONST, 0);
+    write_op_arg(chunk, OP_SET_GLOBAL, (uint16_t)total);
+    chunk_write_opcode(chunk, OP_POP, 1);
+    write_op_arg(chunk, OP_GET_GLOBAL, (uint16_t)total);
+    chunk_write_opcode(chunk, OP_HALT, 1);
+
+    VM *vm = vm_new();
+    vm_load(vm, code);
+    ASSERT_EQ(VM_HALT, vm_run(vm));
+    ASSERT_EQ(7, nanbox_as_int(vm_peek_nan(vm, 0)));
+    ASSERT_EQ(7, nanbox_as_int(vm->globals[total]));
+    ASSERT(vm->globals[unused] == NANBOX_EMPTY);
+
+    /* Reloading the same code keeps the values */
+    vm_load(vm, code);
+    ASSERT_EQ(7, nanbox_as_int(vm->globals[total]));
+    vm_free(vm);
+
+    /* Reading a slot nothing has set is an error */
+    Bytecode *read = bytecode_new();
+    write_op_arg(read->main, OP_GET_GLOBAL, (uint16_t)bytecode_add_global(read, "total"));
+    chunk_write_opcode(read->main, OP_HALT, 1);
+
+    vm = vm_new();
+    vm_load(vm, read);
+    ASSERT_EQ(VM_ERROR_UNDEFINED_VARIABLE, vm_run(vm));
+    vm_free(vm);
+
+    bytecode_free(read);
+    bytecode_free(code);
+}
+
+void test_vm_globals_by_name(void) {
+    /* Two versions of a program that lay their globals out differently */
+    Bytecode *v1 = bytecode_new();
+    bytecode_add_global(v1, "count");
+    bytecode_add_global(v1, "name");
+    chunk_write_opcode(v1->main, OP_HALT, 1);
+
+    Bytecode *v2 = bytecode_new();
+    bytecode_add_global(v2, "name");
+    bytecode_add_global(v2, "count");
+    chunk_write_opcode(v2->main, OP_HALT, 1);
+
+    /* State restored before any code is loaded waits for vm_load */
+    VM *vm = vm_new();
+    Value *state = value_map();
+    state = map_set(state, "count", value_int(3));
+    state = map_set(state, "name", value_string("agent"));
+    state = map_set(state, "dropped", value_int(1));
+    vm_restore_globals(vm, state);
+    ASSERT(vm_get_global(vm, "count") == NULL);
+
+    vm_load(vm, v1);
+    ASSERT_EQ(3, nanbox_as_int(vm->globals[0]));
+    ASSERT_STR_EQ("agent", vm_get_global(vm, "name")->as.string->data);
+
+    /* Hot reload: snapshot by name, load the new layout, restore */
+    Value *snapshot = vm_globals_snapshot(vm);
+    ASSERT_EQ(2, map_size(snapshot));
+    vm_load(vm, v2);
+    ASSERT(vm->globals[1] == NANBOX_EMPTY);
+    vm_restore_globals(vm, snapshot);
+    ASSERT_EQ(3, nanbox_as_int(vm->globals[1]));
+    ASSERT_STR_EQ("agent", vm_get_global(vm, "name")->as.string->data);
+    ASSERT(vm_get_global(vm, "dropped") == NULL);
+
+    vm_free(vm);
+    bytecode_free(v2);
+    bytecode_free(v1);
+}
+
+void test_vm_globals_released(void) {
+    Bytecode *v1 = bytecode_new();
+    bytecode_add_global(v1, "count");
+    bytecode_add_global(v1, "name");
+    chunk_write_opcode(v1->main, OP_HALT, 1);
+
+    Bytecode *v2 = bytecode_new();
+    bytecode_add_global(v2, "count");
+    chunk_write_opcode(v2->main, OP_HALT, 1);
+
+    /* The slot holds one reference, the test the other */
+    Value *name = value_string("agent");
+    value_retain(name);
+
+    VM *vm = vm_new();
+    vm_load(vm, v1);
+    vm->globals[1] = value_to_nanbox(name);
+    ASSERT_EQ(2, atomic_load(&name->refcount));
+
+    /* Reloading the same code keeps the value */
+    vm_load(vm, v1);
+    ASSERT_EQ(2, atomic_load(&name->refcount));
+
+    /* Loading other code, here with fewer slots, drops it */
+    vm_load(vm, v2);
+    ASSERT_EQ(1, atomic_load(&name->refcount));
+
+    /* Restoring over a set slot releases the value it replaces */
+    vm_load(vm, v1);
+    vm->globals[1] = value_to_nanbox(name);
+    value_retain(name);
+    Value *state = map_set(value_map(), "name", value_string("other"));
+    vm_restore_globals(vm, state);
+    ASSERT_EQ(1, atomic_load(&name->refcount));
+
+    vm_free(vm);
+    value_free(name);
+    bytecode_free(v2);
+    bytecode_free(v1);
+}
+
 int main(void) {
     RUN_TEST(test_vm_create);
     RUN_TEST(test_vm_stack);
@@ -207,7 +417,12 @@ int main(void) {
     RUN_TEST(test_vm_comparison);
     RUN_TEST(test_vm_jump);
     RUN_TEST(test_vm_array);
+    RUN_TEST(test_vm_freeze);
     RUN_TEST(test_vm_string_concat);
+    RUN_TEST(test_vm_cold_path_unboxed);
+    RUN_TEST(test_vm_global_slots);
+    RUN_TEST(test_vm_globals_by_name);
+    RUN_TEST(test_vm_globals_released);
 
     return TEST_RESULT();
 }
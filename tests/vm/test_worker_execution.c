@@ -6,6 +6,7 @@
  * - Block state transitions during execution
  * - Statistics tracking (blocks_executed, total_reductions)
  * - Worker loop termination conditions
+ * - Value allocation from worker pools, including remote frees
  *
  * Copyright (c) 2025 Agim Language Contributors
  * SPDX-License-Identifier: MIT
@@ -70,8 +71,9 @@ void test_worker_executes_block(void) {
     ASSERT(block != NULL);
     block_load(block, code);
 
-    /* Enqueue block */
+    /* Enqueue block; the worker isn't running, so it lands in the inbox */
     worker_enqueue(worker, block);
+    ASSERT_EQ(1, worker_drain_inbox(worker));
     ASSERT(!deque_empty(&worker->runq));
 
     /* Pop and execute manually (simulating worker loop) */
@@ -269,6 +271,7 @@ void test_worker_handles_multiple_blocks(void) {
         worker_enqueue(worker, blocks[i]);
     }
 
+    ASSERT_EQ(3, worker_drain_inbox(worker));
     ASSERT_EQ(3, deque_size(&worker->runq));
 
     /* Pop and execute each */
@@ -352,6 +355,7 @@ void test_worker_deque_lifo_owner(void) {
     worker_enqueue(worker, b1);
     worker_enqueue(worker, b2);
     worker_enqueue(worker, b3);
+    ASSERT_EQ(3, worker_drain_inbox(worker));
 
     /* Pop returns in LIFO order */
     ASSERT_EQ(b3, deque_pop(&worker->runq));
@@ -447,6 +451,124 @@ void test_execution_with_reduction_limit(void) {
     scheduler_free(scheduler);
 }
 
+/*
+ * Test: Values built on a worker thread come from its pools
+ */
+void test_worker_allocator_backs_values(void) {
+    WorkerAllocator alloc;
+    worker_alloc_init(&alloc, 0);
+
+    Value *outside = value_int(1);
+    ASSERT(!worker_alloc_owns(outside));
+
+    worker_alloc_set_current(&alloc);
+    Value *str = value_string("pooled");
+    Value *arr = value_array();
+    ASSERT(worker_alloc_owns(str));
+    ASSERT(worker_alloc_owns(str->as.string));
+    ASSERT(worker_alloc_owns(arr->as.array));
+
+    value_free(str);
+    value_free(arr);
+    value_free(outside);
+
+    WorkerAllocStats stats = worker_alloc_stats(&alloc);
+    for (int i = 0; i < WORKER_ALLOC_NUM_POOLS; i++) {
+        ASSERT_EQ(0, stats.pool_allocated[i]);
+    }
+
+    worker_alloc_set_current(NULL);
+    worker_alloc_free(&alloc);
+}
+
+typedef struct RemoteFreeArgs {
+    void **blocks;
+    size_t count;
+} RemoteFreeArgs;
+
+static void *remote_free_thread(void *arg) {
+    RemoteFreeArgs *args = (RemoteFreeArgs *)arg;
+    for (size_t i = 0; i < args->count; i++) {
+        worker_alloc_release(args->blocks[i]);
+    }
+    return NULL;
+}
+
+/*
+ * Test: Blocks freed on another thread are reused by their owner
+ */
+void test_worker_allocator_remote_free(void) {
+    WorkerAllocator alloc;
+    worker_alloc_init(&alloc, 0);
+    worker_alloc_set_current(&alloc);
+
+    /* Exhaust exactly one chunk of the 32-byte pool */
+    size_t count = alloc.pools[1].blocks_per_chunk;
+    void **blocks = malloc(sizeof(void *) * count);
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = worker_alloc(32);
+        ASSERT(blocks[i] != NULL);
+    }
+    ASSERT_EQ(1, worker_alloc_stats(&alloc).total_chunks);
+
+    RemoteFreeArgs args = {.blocks = blocks, .count = count};
+    pthread_t thread;
+    pthread_create(&thread, NULL, remote_free_thread, &args);
+    pthread_join(thread, NULL);
+
+    /* The refill drains the remote list instead of carving a new chunk */
+    void *reused = worker_alloc(32);
+    ASSERT(reused != NULL);
+    WorkerAllocStats stats = worker_alloc_stats(&alloc);
+    ASSERT_EQ(1, stats.total_chunks);
+    ASSERT_EQ(1, stats.pool_allocated[1]);
+
+    worker_alloc_release(reused);
+    free(blocks);
+    worker_alloc_set_current(NULL);
+    worker_alloc_free(&alloc);
+}
+
+/*
+ * Test: Freeing an allocator with a block still out only keeps that chunk
+ */
+void test_worker_allocator_free_keeps_live_chunks(void) {
+    WorkerAllocator alloc;
+    worker_alloc_init(&alloc, 0);
+
+    /* Fill one chunk of the 32-byte pool and spill a block into a second */
+    size_t count = alloc.pools[1].blocks_per_chunk;
+    void **blocks = malloc(sizeof(void *) * count);
+    for (size_t i = 0; i < count; i++) {
+        blocks[i] = worker_alloc_alloc(&alloc, 32);
+        ASSERT(blocks[i] != NULL);
+    }
+    void *live = worker_alloc_alloc(&alloc, 32);
+    ASSERT(live != NULL);
+    ASSERT_EQ(2, worker_alloc_stats(&alloc).total_chunks);
+
+    /* Empty the first chunk, keep the spilled block out past the free */
+    for (size_t i = 0; i < count; i++) {
+        worker_alloc_dealloc(&alloc, blocks[i], 32);
+    }
+    worker_alloc_free(&alloc);
+
+    /* The emptied chunk went back to the region first in line */
+    WorkerAllocator next;
+    worker_alloc_init(&next, 1);
+    void *reused = worker_alloc_alloc(&next, 64);
+    ASSERT(reused != NULL);
+    ASSERT_EQ((uintptr_t)blocks[0] & ~(uintptr_t)(WORKER_ALLOC_CHUNK_SIZE - 1),
+              (uintptr_t)reused & ~(uintptr_t)(WORKER_ALLOC_CHUNK_SIZE - 1));
+
+    /* The block that outlived its allocator can still be released */
+    worker_alloc_release(live);
+
+    worker_alloc_dealloc(&next, reused, 64);
+    worker_alloc_free(&next);
+    free(blocks);
+}
+
 int main(void) {
     printf("Running worker execution tests...\n");
 
@@ -474,6 +596,9 @@ int main(void) {
 
     printf("\nAllocator tests:\n");
     RUN_TEST(test_worker_allocator_initialized);
+    RUN_TEST(test_worker_allocator_backs_values);
+    RUN_TEST(test_worker_allocator_remote_free);
+    RUN_TEST(test_worker_allocator_free_keeps_live_chunks);
 
     return TEST_RESULT();
 }
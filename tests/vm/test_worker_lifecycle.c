@@ -260,7 +260,7 @@ void test_worker_join_not_started(void) {
 }
 
 /*
- * Test: worker_enqueue adds block to deque
+ * Test: worker_enqueue adds block to a stopped worker's queue
  */
 void test_worker_enqueue(void) {
     Scheduler *scheduler = create_test_scheduler();
@@ -274,6 +274,9 @@ void test_worker_enqueue(void) {
     Block *block = block_new(1, "test", NULL);
     worker_enqueue(worker, block);
 
+    /* Not the owning thread, so it waits in the inbox until drained */
+    ASSERT(deque_empty(&worker->runq));
+    ASSERT_EQ(1, worker_drain_inbox(worker));
     ASSERT(!deque_empty(&worker->runq));
     ASSERT_EQ(1, deque_size(&worker->runq));
 
@@ -300,6 +303,7 @@ void test_worker_enqueue_multiple(void) {
         worker_enqueue(worker, blocks[i]);
     }
 
+    ASSERT_EQ(5, worker_drain_inbox(worker));
     ASSERT_EQ(5, deque_size(&worker->runq));
 
     /* Cleanup */
@@ -311,6 +315,60 @@ void test_worker_enqueue_multiple(void) {
     scheduler_free(scheduler);
 }
 
+/*
+ * Test: worker_enqueue from a foreign thread goes through the inbox
+ */
+void test_worker_enqueue_running_uses_inbox(void) {
+    Scheduler *scheduler = create_test_scheduler();
+    ASSERT(scheduler != NULL);
+
+    Worker *worker = worker_new(0, scheduler);
+    ASSERT(worker != NULL);
+
+    /* Pretend the worker thread owns the deque */
+    atomic_store(&worker->state, WORKER_RUNNING);
+
+    Block *blocks[3];
+    for (int i = 0; i < 3; i++) {
+        blocks[i] = block_new((Pid)(i + 1), "test", NULL);
+        worker_enqueue(worker, blocks[i]);
+    }
+
+    ASSERT(deque_empty(&worker->runq));
+    ASSERT(atomic_load(&worker->inbox) != NULL);
+
+    /* Draining preserves enqueue order */
+    ASSERT_EQ(3, worker_drain_inbox(worker));
+    ASSERT(atomic_load(&worker->inbox) == NULL);
+    ASSERT_EQ(3, deque_size(&worker->runq));
+    for (int i = 0; i < 3; i++) {
+        ASSERT_EQ(blocks[i], deque_steal(&worker->runq));
+        block_free(blocks[i]);
+    }
+
+    atomic_store(&worker->state, WORKER_IDLE);
+    worker_free(worker);
+    scheduler_free(scheduler);
+}
+
+/*
+ * Test: worker_drain_inbox on an empty inbox
+ */
+void test_worker_drain_inbox_empty(void) {
+    Scheduler *scheduler = create_test_scheduler();
+    ASSERT(scheduler != NULL);
+
+    Worker *worker = worker_new(0, scheduler);
+    ASSERT(worker != NULL);
+
+    ASSERT_EQ(0, worker_drain_inbox(worker));
+    ASSERT_EQ(0, worker_drain_inbox(NULL));
+    ASSERT(deque_empty(&worker->runq));
+
+    worker_free(worker);
+    scheduler_free(scheduler);
+}
+
 /*
  * Test: worker_enqueue handles NULL worker
  */
@@ -529,6 +587,8 @@ int main(void) {
     printf("\nworker_enqueue tests:\n");
     RUN_TEST(test_worker_enqueue);
     RUN_TEST(test_worker_enqueue_multiple);
+    RUN_TEST(test_worker_enqueue_running_uses_inbox);
+    RUN_TEST(test_worker_drain_inbox_empty);
     RUN_TEST(test_worker_enqueue_null_worker);
     RUN_TEST(test_worker_enqueue_null_block);
 
@@ -25,6 +25,13 @@ static Scheduler *create_test_scheduler(void) {
     return scheduler_new(&config);
 }
 
+/* Helper: Queue a block on a stopped worker's deque, seeding it the way
+ * scheduler_run does before any worker thread exists */
+static void seed(Worker *worker, Block *block) {
+    worker_enqueue(worker, block);
+    worker_drain_inbox(worker);
+}
+
 /*
  * Test: worker_steal returns NULL with NULL worker
  */
@@ -58,7 +65,7 @@ void test_steal_single_worker(void) {
     ASSERT(worker != NULL);
 
     Block *block = block_new(1, "test", NULL);
-    worker_enqueue(worker, block);
+    seed(worker, block);
 
     /* Can't steal from self */
     Block *stolen = worker_steal(worker);
@@ -94,7 +101,7 @@ void test_steal_from_other_worker(void) {
 
     /* Add work to w1 */
     Block *block = block_new(1, "test", NULL);
-    worker_enqueue(w1, block);
+    seed(w1, block);
 
     /* w0 should be able to steal from w1 */
     Block *stolen = worker_steal(w0);
@@ -112,6 +119,51 @@ void test_steal_from_other_worker(void) {
     scheduler_free(scheduler);
 }
 
+/*
+ * Test: worker_steal takes a busy worker's undrained inbox
+ */
+void test_steal_from_inbox(void) {
+    Scheduler *scheduler = create_test_scheduler();
+    ASSERT(scheduler != NULL);
+
+    Worker *w0 = worker_new(0, scheduler);
+    Worker *w1 = worker_new(1, scheduler);
+    ASSERT(w0 != NULL);
+    ASSERT(w1 != NULL);
+
+    scheduler->workers = malloc(2 * sizeof(Worker *));
+    ASSERT(scheduler->workers != NULL);
+    scheduler->workers[0] = w0;
+    scheduler->workers[1] = w1;
+    scheduler->worker_count = 2;
+
+    /* w1 is "running"; foreign enqueues land in its inbox */
+    atomic_store(&w1->state, WORKER_RUNNING);
+    Block *b1 = block_new(1, "test", NULL);
+    Block *b2 = block_new(2, "test", NULL);
+    worker_enqueue(w1, b1);
+    worker_enqueue(w1, b2);
+    ASSERT(deque_empty(&w1->runq));
+
+    /* w0 takes the whole batch: runs one, keeps the rest */
+    Block *stolen = worker_steal(w0);
+    ASSERT(stolen != NULL);
+    ASSERT(atomic_load(&w1->inbox) == NULL);
+    ASSERT_EQ(1, deque_size(&w0->runq));
+    Block *rest = deque_pop(&w0->runq);
+    ASSERT((stolen == b1 && rest == b2) || (stolen == b2 && rest == b1));
+
+    atomic_store(&w1->state, WORKER_IDLE);
+    block_free(b1);
+    block_free(b2);
+    free(scheduler->workers);
+    scheduler->workers = NULL;
+    scheduler->worker_count = 0;
+    worker_free(w0);
+    worker_free(w1);
+    scheduler_free(scheduler);
+}
+
 /*
  * Test: worker_steal returns NULL when all deques empty
  */
@@ -160,7 +212,7 @@ void test_steal_skips_self(void) {
 
     /* Add work only to w0 */
     Block *block = block_new(1, "test", NULL);
-    worker_enqueue(w0, block);
+    seed(w0, block);
 
     /* w0 tries to steal - should not steal from self */
     Block *stolen = worker_steal(w0);
@@ -233,7 +285,7 @@ void test_steal_multiple_from_same(void) {
     Block *blocks[5];
     for (int i = 0; i < 5; i++) {
         blocks[i] = block_new((Pid)(i + 1), "test", NULL);
-        worker_enqueue(w1, blocks[i]);
+        seed(w1, blocks[i]);
     }
 
     /* Steal all from w1 */
@@ -279,7 +331,7 @@ void test_steal_from_multiple_victims(void) {
     Block *blocks[3];
     for (int i = 0; i < 3; i++) {
         blocks[i] = block_new((Pid)(i + 1), "test", NULL);
-        worker_enqueue(workers[i + 1], blocks[i]);
+        seed(workers[i + 1], blocks[i]);
     }
 
     /* Worker 0 steals - should get all 3 eventually */
@@ -325,7 +377,7 @@ void test_steal_null_victim_in_array(void) {
 
     /* Add work to w1 */
     Block *block = block_new(1, "test", NULL);
-    worker_enqueue(w1, block);
+    seed(w1, block);
 
     /* w0 should skip NULL victim and find w1 */
     Block *stolen = NULL;
@@ -368,7 +420,7 @@ void test_steal_random_victim_selection(void) {
     for (int w = 1; w < NUM_WORKERS; w++) {
         for (int i = 0; i < 10; i++) {
             blocks[w - 1][i] = block_new((Pid)(w * 100 + i), "test", NULL);
-            worker_enqueue(workers[w], blocks[w - 1][i]);
+            seed(workers[w], blocks[w - 1][i]);
         }
     }
 
@@ -430,7 +482,7 @@ void test_steal_large_scale(void) {
 
     for (int i = 0; i < COUNT; i++) {
         blocks[i] = block_new((Pid)(i + 1), "test", NULL);
-        worker_enqueue(w1, blocks[i]);
+        seed(w1, blocks[i]);
     }
 
     /* Steal all */
@@ -479,11 +531,11 @@ void test_steal_interleaved_with_push(void) {
     Block *b3 = block_new(3, "test", NULL);
 
     /* Push, steal, push, steal */
-    worker_enqueue(w1, b1);
+    seed(w1, b1);
     ASSERT_EQ(b1, worker_steal(w0));
 
-    worker_enqueue(w1, b2);
-    worker_enqueue(w1, b3);
+    seed(w1, b2);
+    seed(w1, b3);
     ASSERT_EQ(b2, worker_steal(w0));
     ASSERT_EQ(b3, worker_steal(w0));
 
@@ -518,7 +570,7 @@ void test_steal_vs_pop_sequential(void) {
     Block *blocks[10];
     for (int i = 0; i < 10; i++) {
         blocks[i] = block_new((Pid)(i + 1), "test", NULL);
-        worker_enqueue(w1, blocks[i]);
+        seed(w1, blocks[i]);
     }
 
     /* Alternate between pop (from w1) and steal (from w0) */
@@ -559,6 +611,7 @@ int main(void) {
 
     printf("\nBasic stealing tests:\n");
     RUN_TEST(test_steal_from_other_worker);
+    RUN_TEST(test_steal_from_inbox);
     RUN_TEST(test_steal_all_empty);
     RUN_TEST(test_steal_skips_self);
 